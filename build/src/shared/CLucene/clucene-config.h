@@ -32,7 +32,9 @@
 #define _CL_HAVE_SYS_TIMEB_H  1 
 /* #undef _CL_HAVE_SYS_TIME_H */
 #define _CL_HAVE_TCHAR_H 1
-/* #undef _CL_HAVE_SYS_MMAN_H */
+#if !defined(_WIN32) && !defined(_WIN64)
+	#define _CL_HAVE_SYS_MMAN_H 1
+#endif
 #define _CL_HAVE_WINERROR_H 1
 #define _CL_HAVE_STDINT_H 1
 
@@ -8,6 +8,10 @@
 ------------------------------------------------------------------------------*/
 #include "stdafx.h"
 #include "TestCLString.h"
+#include "TestIndexInput.h"
+#include "TestVInt.h"
+#include "TestDocumentsWriter.h"
+#include "TestPhraseQuery.h"
 
 #ifdef COMPILER_MSVC
 #ifdef _DEBUG
@@ -46,6 +50,10 @@ int main( int argc, char** argv ){
 
 	Benchmarker bench;
 	TestCLString clstring;
+	TestIndexInput indexinput;
+	TestVInt vint;
+	TestDocumentsWriter documentswriter;
+	TestPhraseQuery phrasequery;
 	bool ret_result = false;
 
 	cl_tempDir = NULL;
@@ -94,6 +102,10 @@ int main( int argc, char** argv ){
 
 
 	bench.Add(&clstring);
+	bench.Add(&indexinput);
+	bench.Add(&vint);
+	bench.Add(&documentswriter);
+	bench.Add(&phrasequery);
 	ret_result = bench.run();
 
 
@@ -0,0 +1,99 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "stdafx.h"
+#include "TestDocumentsWriter.h"
+
+using namespace lucene::util;
+using namespace lucene::analysis;
+using namespace lucene::document;
+using namespace lucene::index;
+using namespace lucene::store;
+
+#define BENCHMARK_DOCUMENTSWRITER_DOCS 40000
+#define BENCHMARK_DOCUMENTSWRITER_VOCAB 20000
+
+struct AddDocumentsArgs{
+	IndexWriter* writer;
+	int32_t seed;
+	int32_t numDocs;
+	bool failed;
+};
+
+/** Adds numDocs documents of random words, each thread with its own random sequence */
+static void __cdecl addDocumentsThread(void* arg){
+	AddDocumentsArgs* args = (AddDocumentsArgs*)arg;
+	uint32_t r = (uint32_t)args->seed;
+	std::wstring text;
+	try{
+		for ( int32_t i=0;i<args->numDocs;i++ ){
+			text.clear();
+			r = r * 1103515245 + 12345;
+			int32_t words = 50 + (int32_t)((r >> 16) % 150);
+			for ( int32_t j=0;j<words;j++ ){
+				r = r * 1103515245 + 12345;
+				text += L"w";
+				text += Misc::toString((int32_t)((r >> 8) % BENCHMARK_DOCUMENTSWRITER_VOCAB));
+				text += L' ';
+			}
+			Document doc;
+			doc.add(*_CLNEW Field(L"id", Misc::toString(args->seed * args->numDocs + i).c_str(), Field::STORE_YES | Field::INDEX_UNTOKENIZED));
+			doc.add(*_CLNEW Field(L"contents", text.c_str(), Field::STORE_NO | Field::INDEX_TOKENIZED));
+			args->writer->addDocument(&doc);
+		}
+	}catch(CLuceneError&){
+		args->failed = true;
+	}
+}
+
+static int benchmarkAddDocuments(Timer* timerCase, int32_t numThreads){
+	RAMDirectory dir;
+	WhitespaceAnalyzer an;
+	IndexWriter writer(&dir, &an, true);
+	writer.setRAMBufferSizeMB(32);
+
+	AddDocumentsArgs args[8];
+	_LUCENE_THREADID_TYPE threads[8];
+
+	timerCase->start();
+	for ( int32_t i=0;i<numThreads;i++ ){
+		args[i].writer = &writer;
+		args[i].seed = i + 1;
+		args[i].numDocs = BENCHMARK_DOCUMENTSWRITER_DOCS / numThreads;
+		args[i].failed = false;
+		threads[i] = _LUCENE_THREAD_CREATE(&addDocumentsThread, &args[i]);
+	}
+	for ( int32_t i=0;i<numThreads;i++ )
+		_LUCENE_THREAD_JOIN(threads[i]);
+	writer.flush();
+	timerCase->stop();
+
+	bool failed = false;
+	for ( int32_t i=0;i<numThreads;i++ )
+		failed = failed || args[i].failed;
+	const int32_t numDocs = writer.docCount();
+	writer.close();
+	dir.close();
+	return !failed && numDocs == (BENCHMARK_DOCUMENTSWRITER_DOCS / numThreads) * numThreads ? 0 : 1;
+}
+
+int BenchmarkAddDocuments1Thread(Timer* timerCase){
+	return benchmarkAddDocuments(timerCase, 1);
+}
+
+int BenchmarkAddDocuments2Threads(Timer* timerCase){
+	return benchmarkAddDocuments(timerCase, 2);
+}
+
+int BenchmarkAddDocuments4Threads(Timer* timerCase){
+	return benchmarkAddDocuments(timerCase, 4);
+}
+
+int BenchmarkAddDocuments8Threads(Timer* timerCase){
+	return benchmarkAddDocuments(timerCase, 8);
+}
@@ -0,0 +1,33 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#pragma once
+
+int BenchmarkAddDocuments1Thread(Timer* timerCase);
+int BenchmarkAddDocuments2Threads(Timer* timerCase);
+int BenchmarkAddDocuments4Threads(Timer* timerCase);
+int BenchmarkAddDocuments8Threads(Timer* timerCase);
+
+/**
+* Adds the same number of documents to an IndexWriter from 1 to 8 threads,
+* to show how addDocument throughput scales with the number of producers.
+*/
+class TestDocumentsWriter:public Unit
+{
+protected:
+	void runTests(){
+		this->runTest("BenchmarkAddDocuments1Thread",BenchmarkAddDocuments1Thread,3);
+		this->runTest("BenchmarkAddDocuments2Threads",BenchmarkAddDocuments2Threads,3);
+		this->runTest("BenchmarkAddDocuments4Threads",BenchmarkAddDocuments4Threads,3);
+		this->runTest("BenchmarkAddDocuments8Threads",BenchmarkAddDocuments8Threads,3);
+	}
+public:
+	const char* getName(){
+		return "TestDocumentsWriter";
+	}
+};
@@ -0,0 +1,187 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "stdafx.h"
+#include "TestIndexInput.h"
+
+using namespace lucene::util;
+using namespace lucene::analysis;
+using namespace lucene::document;
+using namespace lucene::index;
+using namespace lucene::store;
+
+#define BENCHMARK_INDEXINPUT_DOCS 20000
+#define BENCHMARK_INDEXINPUT_VOCAB 500
+#define BENCHMARK_PARALLELREADS_FILE_INTS (16 * 1024 * 1024)
+#define BENCHMARK_PARALLELREADS_READS 400000
+
+static void getIndexInputDir(wchar_t* path, size_t len){
+	wchar_t* wtmp = Misc::_charToWide(cl_tempDir);
+	_snwprintf(path, len, L"%s/benchmark.indexinput", wtmp);
+	_CLDELETE_CARRAY(wtmp);
+}
+
+/** Builds the index once: many docs over a small vocabulary, so postings are long */
+static void createIndexInputIndex(const wchar_t* path){
+	if ( IndexReader::indexExists(path) )
+		return;
+
+	WhitespaceAnalyzer an;
+	IndexWriter writer(path, &an, true);
+	writer.setMaxBufferedDocs(1000);
+
+	srand(1251971);
+	std::wstring text;
+	for ( int32_t i=0;i<BENCHMARK_INDEXINPUT_DOCS;i++ ){
+		text.clear();
+		int32_t words = 20 + (rand() % 80);
+		for ( int32_t j=0;j<words;j++ ){
+			text += L"w";
+			text += Misc::toString((int32_t)(rand() % BENCHMARK_INDEXINPUT_VOCAB));
+			text += L' ';
+		}
+		Document doc;
+		doc.add(*_CLNEW Field(L"contents", text.c_str(), Field::STORE_NO | Field::INDEX_TOKENIZED));
+		writer.addDocument(&doc);
+	}
+	writer.optimize();
+	writer.close();
+}
+
+static int benchmarkTermDocs(Timer* timerCase, bool useMMap){
+	wchar_t path[CL_MAX_PATH];
+	getIndexInputDir(path, CL_MAX_PATH);
+	createIndexInputIndex(path);
+
+	FSDirectory* dir = FSDirectory::getDirectory(path);
+	dir->setUseMMap(useMMap);
+	IndexReader* reader = IndexReader::open(dir);
+
+	int32_t docs[32];
+	int32_t freqs[32];
+	int64_t total = 0;
+
+	timerCase->start();
+	TermEnum* te = reader->terms();
+	TermDocs* td = reader->termDocs();
+	while ( te->next() ){
+		td->seek(te);
+		int32_t n;
+		while ( (n = td->read(docs, freqs, 32)) > 0 )
+			total += n;
+	}
+	timerCase->stop();
+
+	td->close();
+	_CLDELETE(td);
+	te->close();
+	_CLDELETE(te);
+	reader->close();
+	_CLDELETE(reader);
+	dir->close();
+	_CLDECDELETE(dir);
+	return total > 0 ? 0 : 1;
+}
+
+int BenchmarkTermDocsBuffered(Timer* timerCase){
+	return benchmarkTermDocs(timerCase, false);
+}
+
+int BenchmarkTermDocsMMap(Timer* timerCase){
+	return benchmarkTermDocs(timerCase, true);
+}
+
+/** Writes a 64MB file of consecutive ints once */
+static void createParallelReadsFile(FSDirectory* dir){
+	if ( dir->fileExists(L"parallelreads.dat") && dir->fileLength(L"parallelreads.dat") == (int64_t)BENCHMARK_PARALLELREADS_FILE_INTS * 4 )
+		return;
+	IndexOutput* out = dir->createOutput(L"parallelreads.dat");
+	for ( int32_t i=0;i<BENCHMARK_PARALLELREADS_FILE_INTS;i++ )
+		out->writeInt(i);
+	out->close();
+	_CLDELETE(out);
+}
+
+struct ParallelReadsArgs{
+	IndexInput* in;
+	int32_t seed;
+	int32_t numReads;
+	bool failed;
+};
+
+/** Seeks to random positions of its own clone and reads a few ints, like a postings lookup */
+static void __cdecl parallelReadsThread(void* arg){
+	ParallelReadsArgs* args = (ParallelReadsArgs*)arg;
+	uint32_t r = (uint32_t)args->seed;
+	try{
+		for ( int32_t i=0;i<args->numReads;i++ ){
+			r = r * 1103515245 + 12345;
+			const int32_t n = (int32_t)((r >> 4) % (BENCHMARK_PARALLELREADS_FILE_INTS - 16));
+			args->in->seek((int64_t)n * 4);
+			for ( int32_t j=0;j<16;j++ ){
+				if ( args->in->readInt() != n + j )
+					args->failed = true;
+			}
+		}
+	}catch(CLuceneError&){
+		args->failed = true;
+	}
+}
+
+static int benchmarkParallelReads(Timer* timerCase, int32_t numThreads){
+	wchar_t path[CL_MAX_PATH];
+	getIndexInputDir(path, CL_MAX_PATH);
+	FSDirectory* dir = FSDirectory::getDirectory(path);
+	dir->setUseMMap(false);
+	createParallelReadsFile(dir);
+
+	IndexInput* in = ((Directory*)dir)->openInput(L"parallelreads.dat");
+	ParallelReadsArgs args[32];
+	_LUCENE_THREADID_TYPE threads[32];
+	for ( int32_t i=0;i<numThreads;i++ ){
+		args[i].in = in->clone();
+		args[i].seed = i + 1;
+		args[i].numReads = BENCHMARK_PARALLELREADS_READS / numThreads;
+		args[i].failed = false;
+	}
+
+	timerCase->start();
+	for ( int32_t i=0;i<numThreads;i++ )
+		threads[i] = _LUCENE_THREAD_CREATE(&parallelReadsThread, &args[i]);
+	for ( int32_t i=0;i<numThreads;i++ )
+		_LUCENE_THREAD_JOIN(threads[i]);
+	timerCase->stop();
+
+	bool failed = false;
+	for ( int32_t i=0;i<numThreads;i++ ){
+		failed = failed || args[i].failed;
+		args[i].in->close();
+		_CLDELETE(args[i].in);
+	}
+	in->close();
+	_CLDELETE(in);
+	dir->close();
+	_CLDECDELETE(dir);
+	return failed ? 1 : 0;
+}
+
+int BenchmarkParallelReads1Thread(Timer* timerCase){
+	return benchmarkParallelReads(timerCase, 1);
+}
+
+int BenchmarkParallelReads4Threads(Timer* timerCase){
+	return benchmarkParallelReads(timerCase, 4);
+}
+
+int BenchmarkParallelReads16Threads(Timer* timerCase){
+	return benchmarkParallelReads(timerCase, 16);
+}
+
+int BenchmarkParallelReads32Threads(Timer* timerCase){
+	return benchmarkParallelReads(timerCase, 32);
+}
@@ -0,0 +1,39 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#pragma once
+
+int BenchmarkTermDocsBuffered(Timer* timerCase);
+int BenchmarkTermDocsMMap(Timer* timerCase);
+int BenchmarkParallelReads1Thread(Timer* timerCase);
+int BenchmarkParallelReads4Threads(Timer* timerCase);
+int BenchmarkParallelReads16Threads(Timer* timerCase);
+int BenchmarkParallelReads32Threads(Timer* timerCase);
+
+/**
+* Compares reading all postings of an index through SegmentTermDocs::read
+* with the buffered FSIndexInput and with the memory mapped MMapIndexInput,
+* and measures random read throughput of FSIndexInput clones of one file
+* from 1 to 32 threads.
+*/
+class TestIndexInput:public Unit
+{
+protected:
+	void runTests(){
+		this->runTest("BenchmarkTermDocsBuffered",BenchmarkTermDocsBuffered,10);
+		this->runTest("BenchmarkTermDocsMMap",BenchmarkTermDocsMMap,10);
+		this->runTest("BenchmarkParallelReads1Thread",BenchmarkParallelReads1Thread,3);
+		this->runTest("BenchmarkParallelReads4Threads",BenchmarkParallelReads4Threads,3);
+		this->runTest("BenchmarkParallelReads16Threads",BenchmarkParallelReads16Threads,3);
+		this->runTest("BenchmarkParallelReads32Threads",BenchmarkParallelReads32Threads,3);
+	}
+public:
+	const char* getName(){
+		return "TestIndexInput";
+	}
+};
@@ -0,0 +1,166 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "stdafx.h"
+#include "TestPhraseQuery.h"
+#include "CLucene/search/_PhraseScorer.h"
+
+using namespace lucene::util;
+using namespace lucene::analysis;
+using namespace lucene::document;
+using namespace lucene::index;
+using namespace lucene::store;
+using namespace lucene::search;
+
+#define BENCHMARK_PHRASE_DOCS 20000
+#define BENCHMARK_PHRASE_MAXWORDS 100
+#define BENCHMARK_PHRASE_ROUNDS 5
+
+static const wchar_t* phraseWords[] = { L"a", L"b", L"c", L"d", L"e" };
+
+/** The phrases of the exact phrase query test, -1 terminated */
+static const int32_t phrases[][5] = { {0, 1, -1}, {1, 0, 1, -1}, {2, 2, -1}, {0, 1, 2, 3, -1}, {4, 0, 4, -1}, {3, 4, -1} };
+
+static RAMDirectory* phraseDir = NULL;
+
+/** Indexes random text of the words a, b and c, with d and e rare */
+static void createPhraseIndex(){
+	if ( phraseDir != NULL )
+		return;
+
+	phraseDir = _CLNEW RAMDirectory();
+	WhitespaceAnalyzer an;
+	IndexWriter writer(phraseDir, &an, true);
+	writer.setRAMBufferSizeMB(32);
+	srand(4711);
+	std::wstring text;
+	for ( int32_t i=0;i<BENCHMARK_PHRASE_DOCS;i++ ){
+		text.clear();
+		const int32_t length = 1 + rand() % BENCHMARK_PHRASE_MAXWORDS;
+		for ( int32_t j=0;j<length;j++ ){
+			const int32_t w = rand() % 10 < 8 ? rand() % 3 : 3 + rand() % 2;
+			text += phraseWords[w];
+			text += L' ';
+		}
+		Document doc;
+		doc.add(*_CLNEW Field(L"content", text.c_str(), Field::STORE_NO | Field::INDEX_TOKENIZED));
+		writer.addDocument(&doc);
+	}
+	writer.optimize();
+	writer.close();
+}
+
+/**
+* The exact phrase scorer the ExactPhraseScorer replaced: the PhraseQueue
+* sorts the PhrasePositions of every document that has all the terms, which
+* are then advanced one nextPosition() at a time.
+*/
+class QueueExactPhraseScorer: public PhraseScorer{
+public:
+	QueueExactPhraseScorer(Weight* weight, TermPositions** tps, int32_t* offsets,
+		Similarity* similarity, uint8_t* norms):
+		PhraseScorer(weight, tps, offsets, similarity, norms){
+	}
+protected:
+	float_t phraseFreq(){
+		pq->clear();
+		for ( PhrasePositions* pp = first; pp != NULL; pp = pp->_next ){
+			pp->firstPosition();
+			pq->put(pp);
+		}
+		pqToList();
+
+		int32_t freq = 0;
+		do {
+			while ( first->position < last->position ){
+				do{
+					if ( !first->nextPosition() )
+						return (float_t)freq;
+				} while ( first->position < last->position );
+				firstToLast();
+			}
+			freq++;
+		} while ( last->nextPosition() );
+		return (float_t)freq;
+	}
+};
+
+/** Scores each phrase over the whole index, with the queue scorer or with the scorer of the query */
+static int benchmarkPhrases(Timer* timerCase, bool queue){
+	createPhraseIndex();
+	IndexSearcher searcher(phraseDir);
+	IndexReader* reader = searcher.getReader();
+	const int32_t numPhrases = sizeof(phrases) / sizeof(phrases[0]);
+	PhraseQuery** queries = _CL_NEWARRAY(PhraseQuery*, numPhrases);
+	for ( int32_t p=0;p<numPhrases;p++ ){
+		queries[p] = _CLNEW PhraseQuery();
+		for ( int32_t k=0;phrases[p][k] >= 0;k++ ){
+			Term* t = _CLNEW Term(L"content", phraseWords[phrases[p][k]]);
+			queries[p]->add(t);
+			_CLDECDELETE(t);
+		}
+	}
+
+	int64_t hits = 0;
+	float_t scores = 0;
+	timerCase->start();
+	for ( int32_t r=0;r<BENCHMARK_PHRASE_ROUNDS;r++ ){
+		for ( int32_t p=0;p<numPhrases;p++ ){
+			Weight* weight = queries[p]->weight(&searcher);
+			Scorer* scorer;
+			if ( queue ){
+				Term** terms = queries[p]->getTerms();
+				int32_t numTerms = 0;
+				while ( terms[numTerms] != NULL )
+					numTerms++;
+				TermPositions** tps = _CL_NEWARRAY(TermPositions*, numTerms + 1);
+				for ( int32_t k=0;k<numTerms;k++ )
+					tps[k] = reader->termPositions(terms[k]);
+				tps[numTerms] = NULL;
+				_CLDELETE_ARRAY(terms);
+
+				ValueArray<int32_t> positions;
+				queries[p]->getPositions(positions);
+				scorer = _CLNEW QueueExactPhraseScorer(weight, tps, positions.values,
+					queries[p]->getSimilarity(&searcher), reader->norms(L"content"));
+				positions.deleteArray();
+				_CLDELETE_ARRAY(tps);
+			}else
+				scorer = weight->scorer(reader);
+
+			while ( scorer->next() ){
+				hits++;
+				scores += scorer->score();
+			}
+			_CLDELETE(scorer);
+			_CLDELETE(weight);
+		}
+	}
+	timerCase->stop();
+
+	for ( int32_t p=0;p<numPhrases;p++ )
+		_CLDELETE(queries[p]);
+	_CLDELETE_ARRAY(queries);
+	searcher.close();
+	return hits > 0 && scores > 0 ? 0 : 1;
+}
+
+int BenchmarkQueueExactPhrase(Timer* timerCase){
+	return benchmarkPhrases(timerCase, true);
+}
+
+int BenchmarkExactPhrase(Timer* timerCase){
+	return benchmarkPhrases(timerCase, false);
+}
+
+void FreePhraseIndex(){
+	if ( phraseDir == NULL )
+		return;
+	phraseDir->close();
+	_CLDECDELETE(phraseDir);
+}
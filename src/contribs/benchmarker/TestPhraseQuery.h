@@ -0,0 +1,32 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#pragma once
+
+int BenchmarkQueueExactPhrase(Timer* timerCase);
+int BenchmarkExactPhrase(Timer* timerCase);
+void FreePhraseIndex();
+
+/**
+* Scores the phrases of the exact phrase query test over a bigger index
+* of the same kind of text, with the ExactPhraseScorer and with the exact
+* scorer it replaced, which went through the PhraseScorer queue.
+*/
+class TestPhraseQuery:public Unit
+{
+protected:
+	void runTests(){
+		this->runTest("BenchmarkQueueExactPhrase",BenchmarkQueueExactPhrase,10);
+		this->runTest("BenchmarkExactPhrase",BenchmarkExactPhrase,10);
+		FreePhraseIndex();
+	}
+public:
+	const char* getName(){
+		return "TestPhraseQuery";
+	}
+};
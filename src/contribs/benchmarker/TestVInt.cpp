@@ -0,0 +1,91 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "stdafx.h"
+#include "TestVInt.h"
+#include "CLucene/util/_VIntDecoder.h"
+
+using namespace lucene::util;
+using namespace lucene::store;
+
+#define BENCHMARK_VINT_COUNT (1<<22)
+#define BENCHMARK_VINT_BLOCK 128
+
+/** The encoded values, mostly small like doc deltas and freqs */
+static std::vector<uint8_t> vintBytes;
+
+static void createVInts(){
+	if ( !vintBytes.empty() )
+		return;
+
+	srand(1251971);
+	for ( int32_t i=0;i<BENCHMARK_VINT_COUNT;i++ ){
+		int32_t r = rand() % 10;
+		uint32_t v = r < 7 ? rand() % 128 : ( r < 9 ? rand() % 16384 : (rand() % 32768) * 64 );
+		while ( (v & ~0x7F) != 0 ){
+			vintBytes.push_back((uint8_t)((v & 0x7f) | 0x80));
+			v >>= 7;
+		}
+		vintBytes.push_back((uint8_t)v);
+	}
+}
+
+int BenchmarkReadVInt(Timer* timerCase){
+	createVInts();
+	RAMDirectory ram;
+	Directory* dir = &ram;
+	IndexOutput* out = dir->createOutput(L"vints");
+	out->writeBytes(&vintBytes[0], (int32_t)vintBytes.size());
+	out->close();
+	_CLDELETE(out);
+
+	IndexInput* in = dir->openInput(L"vints");
+	int64_t sum = 0;
+	timerCase->start();
+	for ( int32_t i=0;i<BENCHMARK_VINT_COUNT;i++ )
+		sum += in->readVInt();
+	timerCase->stop();
+	in->close();
+	_CLDELETE(in);
+	return sum > 0 ? 0 : 1;
+}
+
+static int benchmarkVIntDecode(Timer* timerCase, bool simd){
+	createVInts();
+	int32_t values[BENCHMARK_VINT_BLOCK];
+	int32_t ends[BENCHMARK_VINT_BLOCK];
+	const uint8_t* bytes = &vintBytes[0];
+	int32_t length = (int32_t)vintBytes.size();
+	int32_t decoded = 0;
+	int64_t sum = 0;
+
+	timerCase->start();
+	while ( decoded < BENCHMARK_VINT_COUNT ){
+		int32_t n = simd ? VIntDecoder::decode(bytes, length, values, ends, BENCHMARK_VINT_BLOCK)
+			: VIntDecoder::decodeScalar(bytes, length, values, ends, BENCHMARK_VINT_BLOCK);
+		if ( n == 0 )
+			break;
+		for ( int32_t i=0;i<n;i++ )
+			sum += values[i];
+		bytes += ends[n-1];
+		length -= ends[n-1];
+		decoded += n;
+	}
+	timerCase->stop();
+	return decoded == BENCHMARK_VINT_COUNT && sum > 0 ? 0 : 1;
+}
+
+int BenchmarkVIntDecodeScalar(Timer* timerCase){
+	return benchmarkVIntDecode(timerCase, false);
+}
+
+int BenchmarkVIntDecode(Timer* timerCase){
+	if ( !VIntDecoder::hasSimd() )
+		printf(" (no SIMD in this build)");
+	return benchmarkVIntDecode(timerCase, true);
+}
@@ -0,0 +1,31 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#pragma once
+
+int BenchmarkReadVInt(Timer* timerCase);
+int BenchmarkVIntDecodeScalar(Timer* timerCase);
+int BenchmarkVIntDecode(Timer* timerCase);
+
+/**
+* Compares decoding a postings-like stream of VInts one IndexInput::readVInt()
+* at a time with the bulk VIntDecoder, with and without its SIMD path.
+*/
+class TestVInt:public Unit
+{
+protected:
+	void runTests(){
+		this->runTest("BenchmarkReadVInt",BenchmarkReadVInt,10);
+		this->runTest("BenchmarkVIntDecodeScalar",BenchmarkVIntDecodeScalar,10);
+		this->runTest("BenchmarkVIntDecode",BenchmarkVIntDecode,10);
+	}
+public:
+	const char* getName(){
+		return "TestVInt";
+	}
+};
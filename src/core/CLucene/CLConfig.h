@@ -43,8 +43,9 @@
 //   Your application
 ////////////////////////////////////////////////////////////////////
 //
-//define this to enable mmap support in the fsdirectory IndexInput
-//EXPERIMENTAL
+//mmap support in the fsdirectory IndexInput is compiled in whenever the
+//platform has mmap or MapViewOfFile, and can be switched on per directory
+//with FSDirectory::setUseMMap. Define this to switch it on by default.
 //#define LUCENE_FS_MMAP
 //
 //define to true to actually use it (not just enable it)
@@ -54,6 +55,28 @@
 	#define LUCENE_USE_MMAP false
 #endif
 //
+//mmap'd files are mapped in chunks of 2^LUCENE_MMAP_CHUNK_POWER bytes, so
+//that files over 2GB can be read where a single mapping can't be that big.
+//Must be a multiple of the page size (and on windows of the 64k allocation
+//granularity). Chunks are mapped when they are first read. Where address
+//space is scarce, no more than LUCENE_MMAP_MAX_IDLE_CHUNKS chunks of a file
+//stay mapped while no input is positioned in them.
+#if defined(_WIN64) || defined(__LP64__) || defined(_LP64)
+	#ifndef LUCENE_MMAP_CHUNK_POWER
+		#define LUCENE_MMAP_CHUNK_POWER 34
+	#endif
+	#ifndef LUCENE_MMAP_MAX_IDLE_CHUNKS
+		#define LUCENE_MMAP_MAX_IDLE_CHUNKS 0x7fffffff
+	#endif
+#else
+	#ifndef LUCENE_MMAP_CHUNK_POWER
+		#define LUCENE_MMAP_CHUNK_POWER 28
+	#endif
+	#ifndef LUCENE_MMAP_MAX_IDLE_CHUNKS
+		#define LUCENE_MMAP_MAX_IDLE_CHUNKS 2
+	#endif
+#endif
+//
 //LOCK_DIR implementation:
 //define this to set an exact directory for the lock dir (not recommended)
 //all other methods of getting the temporary directory will be ignored
@@ -163,6 +186,37 @@
 //Size of TermScore cache. Required.
 #define LUCENE_SCORE_CACHE_SIZE 32
 //
+//Number of independently locked shards the FieldCache spreads its
+//entries over, so that concurrent sorted searches don't all wait on
+//one lock. Required.
+#define LUCENE_FIELDCACHE_SHARDS 16
+//
+//Number of recently looked up terms each segment keeps the TermInfo
+//of, so that repeated lookups don't have to seek the term dictionary.
+//0 disables the cache. Required.
+#define LUCENE_TERMINFOS_CACHE_SIZE 1024
+//
+//Number of threads that can add documents to an IndexWriter at the same
+//time, each with its own postings and a list of free RAM blocks it reuses
+//without locking. They still add to one segment, and lock to get new
+//postings and blocks from the shared pools. Further threads share these
+//states and wait for each other. Required.
+#define LUCENE_MAX_INDEXING_THREADS 8
+//
+//Number of threads which read ahead for all PrefetchIndexInputs. Required.
+#define LUCENE_PREFETCH_THREADS 1
+//
+//Size and number of the chunks a PrefetchIndexInput reads ahead of its
+//caller, see IndexInput::ACCESS_SEQUENTIAL. Required.
+#define LUCENE_PREFETCH_CHUNK_SIZE 65536
+#define LUCENE_PREFETCH_CHUNKS 4
+//
+//Uncompressed size at which a block of compressed stored fields is written,
+//and the number of decompressed blocks each FieldsReader keeps, see
+//IndexWriter::setStoredFieldsCompression. Required.
+#define LUCENE_STORED_FIELDS_BLOCK_SIZE 16384
+#define LUCENE_STORED_FIELDS_BLOCK_CACHE 4
+//
 //analysis options
 //maximum length that the CharTokenizer uses. Required.
 //By adjusting this value, you can greatly improve the performance of searching
@@ -16,6 +16,7 @@
 #include "CLucene/debug/error.cpp"
 #include "CLucene/analysis/Analyzers.cpp"
 #include "CLucene/analysis/AnalysisHeader.cpp"
+#include "CLucene/analysis/NumericTokenStream.cpp"
 #include "CLucene/analysis/standard/StandardAnalyzer.cpp"
 #include "CLucene/analysis/standard/StandardFilter.cpp"
 #include "CLucene/analysis/standard/StandardTokenizer.cpp"
@@ -23,10 +24,13 @@
 #include "CLucene/document/DateTools.cpp"
 #include "CLucene/document/Document.cpp"
 #include "CLucene/document/FieldSelector.cpp"
+#include "CLucene/document/StoredFieldVisitor.cpp"
 #include "CLucene/document/NumberTools.cpp"
+#include "CLucene/document/NumericField.cpp"
 #include "CLucene/document/Field.cpp"
 #include "CLucene/index/CompoundFile.cpp"
 #include "CLucene/index/DirectoryIndexReader.cpp"
+#include "CLucene/index/DocValues.cpp"
 #include "CLucene/index/DocumentsWriter.cpp"
 #include "CLucene/index/DocumentsWriterThreadState.cpp"
 #include "CLucene/index/FieldInfos.cpp"
@@ -50,12 +54,16 @@
 #include "CLucene/index/SegmentMergeQueue.cpp"
 #include "CLucene/index/SegmentMerger.cpp"
 #include "CLucene/index/SegmentReader.cpp"
+#include "CLucene/index/SegmentReaderPool.cpp"
 #include "CLucene/index/SegmentTermDocs.cpp"
 #include "CLucene/index/SegmentTermEnum.cpp"
 #include "CLucene/index/SegmentTermPositions.cpp"
 #include "CLucene/index/SegmentTermVector.cpp"
 #include "CLucene/index/SkipListReader.cpp"
 #include "CLucene/index/SkipListWriter.cpp"
+#include "CLucene/index/PostingsCodec.cpp"
+#include "CLucene/index/BlockTermDocs.cpp"
+#include "CLucene/index/BlockTermPositions.cpp"
 #include "CLucene/index/Term.cpp"
 #include "CLucene/index/Terms.cpp"
 #include "CLucene/index/TermInfo.cpp"
@@ -85,6 +93,7 @@
 #include "CLucene/search/FieldDocSortedHitQueue.cpp"
 #include "CLucene/search/FieldSortedHitQueue.cpp"
 #include "CLucene/search/FilteredTermEnum.cpp"
+#include "CLucene/search/AutomatonTermEnum.cpp"
 #include "CLucene/search/FuzzyQuery.cpp"
 #include "CLucene/search/Hits.cpp"
 #include "CLucene/search/HitQueue.cpp"
@@ -93,21 +102,28 @@
 #include "CLucene/search/MultiPhraseQuery.cpp"
 #include "CLucene/search/MultiSearcher.cpp"
 #include "CLucene/search/MultiTermQuery.cpp"
+#include "CLucene/search/ParallelMultiSearcher.cpp"
 #include "CLucene/search/PhrasePositions.cpp"
 #include "CLucene/search/PhraseQuery.cpp"
 #include "CLucene/search/PhraseScorer.cpp"
 #include "CLucene/search/PrefixQuery.cpp"
 #include "CLucene/search/QueryFilter.cpp"
+#include "CLucene/search/QueryCache.cpp"
 #include "CLucene/search/RangeQuery.cpp"
+#include "CLucene/search/RegexpQuery.cpp"
+#include "CLucene/search/NumericRangeFilter.cpp"
+#include "CLucene/search/NumericRangeQuery.cpp"
 #include "CLucene/search/RangeFilter.cpp"
 #include "CLucene/search/SearchHeader.cpp"
 #include "CLucene/search/Similarity.cpp"
 #include "CLucene/search/SloppyPhraseScorer.cpp"
 #include "CLucene/search/Scorer.cpp"
 #include "CLucene/search/ScorerDocQueue.cpp"
+#include "CLucene/search/SearchThreadPool.cpp"
 #include "CLucene/search/Sort.cpp"
 #include "CLucene/search/TermQuery.cpp"
 #include "CLucene/search/TermScorer.cpp"
+#include "CLucene/search/WANDScorer.cpp"
 #include "CLucene/search/WildcardQuery.cpp"
 #include "CLucene/search/WildcardTermEnum.cpp"
 #include "CLucene/search/spans/NearSpansOrdered.cpp"
@@ -125,15 +141,22 @@
 #include "CLucene/store/Lock.cpp"
 #include "CLucene/store/LockFactory.cpp"
 #include "CLucene/store/MMapInput.cpp"
+#include "CLucene/store/PrefetchIndexInput.cpp"
 #include "CLucene/store/IndexOutput.cpp"
 #include "CLucene/store/Directory.cpp"
 #include "CLucene/store/RAMDirectory.cpp"
 #include "CLucene/util/BitSet.cpp"
+#include "CLucene/util/PackedInts.cpp"
+#include "CLucene/util/NumericUtils.cpp"
 #include "CLucene/util/Equators.cpp"
 #include "CLucene/util/FastCharStream.cpp"
 #include "CLucene/util/MD5Digester.cpp"
 #include "CLucene/util/Reader.cpp"
 #include "CLucene/util/StringIntern.cpp"
 #include "CLucene/util/ThreadLocal.cpp"
+#include "CLucene/util/VIntDecoder.cpp"
+#include "CLucene/util/ForUtil.cpp"
+#include "CLucene/util/Automaton.cpp"
+#include "CLucene/util/LZ4.cpp"
 
 #include "CLucene/CLSharedMonolithic.cpp"
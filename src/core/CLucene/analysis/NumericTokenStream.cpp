@@ -0,0 +1,82 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "CLucene/_ApiHeader.h"
+#include "NumericTokenStream.h"
+
+CL_NS_USE(util)
+CL_NS_DEF(analysis)
+
+const wchar_t* NumericTokenStream::TOKEN_TYPE_FULL_PREC = L"fullPrecNumeric";
+const wchar_t* NumericTokenStream::TOKEN_TYPE_LOWER_PREC = L"lowerPrecNumeric";
+
+NumericTokenStream::NumericTokenStream(const int32_t _precisionStep):
+	precisionStep(_precisionStep), valSize(0), value(0), shift(0)
+{
+	if ( precisionStep < 1 )
+		_CLTHROWA(CL_ERR_IllegalArgument, "precisionStep must be at least 1");
+}
+
+NumericTokenStream::~NumericTokenStream(){
+}
+
+NumericTokenStream* NumericTokenStream::setLongValue(const int64_t _value){
+	value = _value;
+	valSize = 64;
+	shift = 0;
+	return this;
+}
+
+NumericTokenStream* NumericTokenStream::setIntValue(const int32_t _value){
+	value = _value;
+	valSize = 32;
+	shift = 0;
+	return this;
+}
+
+NumericTokenStream* NumericTokenStream::setDoubleValue(const double _value){
+	return setLongValue(NumericUtils::doubleToSortableLong(_value));
+}
+
+NumericTokenStream* NumericTokenStream::setFloatValue(const float _value){
+	return setIntValue(NumericUtils::floatToSortableInt(_value));
+}
+
+int32_t NumericTokenStream::getPrecisionStep() const{
+	return precisionStep;
+}
+
+Token* NumericTokenStream::next(Token* token){
+	if ( valSize == 0 )
+		_CLTHROWA(CL_ERR_IllegalState, "a value must be set before the stream is used");
+	if ( shift >= valSize )
+		return NULL;
+
+	wchar_t buffer[NumericUtils::BUF_SIZE_LONG + 1];
+	const int32_t len = valSize == 64 ?
+		NumericUtils::longToPrefixCoded(value, shift, buffer) :
+		NumericUtils::intToPrefixCoded((int32_t)value, shift, buffer);
+
+	token->clear();
+	token->setText(buffer, len);
+	token->setStartOffset(0);
+	token->setEndOffset(0);
+	token->setType(shift == 0 ? TOKEN_TYPE_FULL_PREC : TOKEN_TYPE_LOWER_PREC);
+	token->setPositionIncrement(shift == 0 ? 1 : 0);
+	shift += precisionStep;
+	return token;
+}
+
+void NumericTokenStream::reset(){
+	shift = 0;
+}
+
+void NumericTokenStream::close(){
+}
+
+CL_NS_END
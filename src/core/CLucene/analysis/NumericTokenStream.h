@@ -0,0 +1,63 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#ifndef _lucene_analysis_NumericTokenStream_
+#define _lucene_analysis_NumericTokenStream_
+
+#include "CLucene/analysis/AnalysisHeader.h"
+#include "CLucene/util/NumericUtils.h"
+
+CL_NS_DEF(analysis)
+
+/**
+* The tokens of a number at each precision which util::NumericUtils
+* describes, for search::NumericRangeQuery to find it by. The first token
+* is the full precision; the lower precisions follow at the same position.
+* <p>
+* document::NumericField indexes a number with this stream. The stream may
+* be reused for another number after one of the set*Value() methods.
+*/
+class CLUCENE_EXPORT NumericTokenStream: public TokenStream {
+private:
+	const int32_t precisionStep;
+	int32_t valSize;
+	int64_t value;
+	int32_t shift;
+
+public:
+	/** The type of the token of the full precision */
+	static const wchar_t* TOKEN_TYPE_FULL_PREC;
+	/** The type of the tokens of the lower precisions */
+	static const wchar_t* TOKEN_TYPE_LOWER_PREC;
+
+	/**
+	* Creates a stream without a value.
+	* @throws CLuceneError CL_ERR_IllegalArgument if precisionStep is below 1
+	*/
+	NumericTokenStream(const int32_t precisionStep = CL_NS(util)::NumericUtils::PRECISION_STEP_DEFAULT);
+	virtual ~NumericTokenStream();
+
+	/** Sets the value of the stream to a 64 bit integer */
+	NumericTokenStream* setLongValue(const int64_t value);
+	/** Sets the value of the stream to a 32 bit integer */
+	NumericTokenStream* setIntValue(const int32_t value);
+	/** Sets the value of the stream to a double */
+	NumericTokenStream* setDoubleValue(const double value);
+	/** Sets the value of the stream to a float */
+	NumericTokenStream* setFloatValue(const float value);
+
+	int32_t getPrecisionStep() const;
+
+	/** @throws CLuceneError CL_ERR_IllegalState if no value was set */
+	Token* next(Token* token);
+	void reset();
+	void close();
+};
+
+CL_NS_END
+#endif
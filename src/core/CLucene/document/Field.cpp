@@ -136,6 +136,9 @@ void Field::setOmitNorms(const bool omitNorms)
         config &= ~INDEX_NONORMS;
 }
 
+bool Field::isNumericDocValues() const { return (config & DOCVALUES_NUMERIC) != 0; }
+bool Field::isSortedDocValues() const { return (config & DOCVALUES_SORTED) != 0; }
+
 bool Field::isLazy() const { return lazy; }
 
 void Field::setValue(wchar_t* value, const bool duplicateValue)
@@ -216,7 +219,11 @@ void Field::setConfig(const uint32_t x)
     else
         newConfig |= INDEX_NO;
 
-    if (newConfig & INDEX_NO && newConfig & STORE_NO)
+    if ((x & DOCVALUES_NUMERIC) && (x & DOCVALUES_SORTED))
+        _CLTHROWA(CL_ERR_IllegalArgument, "a field cannot have both numeric and sorted doc values");
+    newConfig |= x & (DOCVALUES_NUMERIC | DOCVALUES_SORTED);
+
+    if (newConfig & INDEX_NO && newConfig & STORE_NO && (newConfig & (DOCVALUES_NUMERIC | DOCVALUES_SORTED)) == 0)
         _CLTHROWA(CL_ERR_IllegalArgument, "it doesn't make sense to have a field that is neither indexed nor stored");
 
     //set termvector settings
@@ -306,6 +313,14 @@ std::wstring Field::toString()
     {
         result.append(L",omitNorms");
     }
+    if (isNumericDocValues())
+    {
+        result.append(L",numericDocValues");
+    }
+    if (isSortedDocValues())
+    {
+        result.append(L",sortedDocValues");
+    }
     if (isLazy())
     {
         result.append(L",lazy");
@@ -115,6 +115,22 @@ public:
 		TERMVECTOR_WITH_POSITIONS_OFFSETS = TERMVECTOR_WITH_OFFSETS | TERMVECTOR_WITH_POSITIONS
 	};
 
+	enum DocValues{
+		/** Also write the value, which must be a decimal integer, as a
+		* per-document numeric value, see IndexReader::getNumericDocValues().
+		* Sorting on the field then reads the values straight from the index
+		* instead of un-inverting its terms. A field may have doc values
+		* without being indexed or stored.
+		*/
+		DOCVALUES_NUMERIC = 4096,
+
+		/** Also write the value as a per-document string value, see
+		* IndexReader::getSortedDocValues(). Sorting on the field then reads
+		* the values straight from the index instead of un-inverting its terms.
+		*/
+		DOCVALUES_SORTED = 8192
+	};
+
 	bool lazy;
 
 	enum ValueType {
@@ -246,6 +262,12 @@ public:
 	/** True if norms are omitted for this indexed field */
 	bool getOmitNorms() const;
 
+	/** True if the value is also written as a numeric doc value */
+	bool isNumericDocValues() const;
+
+	/** True if the value is also written as a sorted doc value */
+	bool isSortedDocValues() const;
+
 	/** Expert:
 	*
 	* If set, omit normalization factors associated with this indexed field.
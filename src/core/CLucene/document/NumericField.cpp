@@ -0,0 +1,89 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "CLucene/_ApiHeader.h"
+#include "NumericField.h"
+#include "CLucene/analysis/NumericTokenStream.h"
+
+CL_NS_USE(analysis)
+CL_NS_USE(util)
+CL_NS_DEF(document)
+
+// an indexed field is always tokenized by its own stream, and has no norms
+static int numericConfig(const int config){
+	if ( (config & Field::INDEX_NO) == 0 &&
+		(config & (Field::INDEX_TOKENIZED | Field::INDEX_UNTOKENIZED | Field::INDEX_NONORMS)) != 0 )
+		return (config & ~(Field::INDEX_UNTOKENIZED | Field::INDEX_NONORMS)) | Field::INDEX_TOKENIZED;
+	return config;
+}
+
+NumericField::NumericField(const wchar_t* Name, const int32_t precisionStep, const int _config):
+	Field(Name, numericConfig(_config)),
+	numericTokenStream(NULL)
+{
+	numericTokenStream = _CLNEW NumericTokenStream(precisionStep);
+	if ( isIndexed() )
+		setOmitNorms(true);
+}
+
+NumericField::~NumericField(){
+	_CLDELETE(numericTokenStream);
+}
+
+NumericField* NumericField::setLongValue(const int64_t value){
+	wchar_t buf[24];
+	_i64tow(value, buf, 10);
+	setValue(buf);
+	numericTokenStream->setLongValue(value);
+	return this;
+}
+
+NumericField* NumericField::setIntValue(const int32_t value){
+	wchar_t buf[24];
+	_i64tow(value, buf, 10);
+	setValue(buf);
+	numericTokenStream->setIntValue(value);
+	return this;
+}
+
+NumericField* NumericField::setDoubleValue(const double value){
+	// enough digits to read the same double back
+	wchar_t buf[32];
+	_snwprintf(buf, 32, L"%.17g", value);
+	buf[31] = 0;
+	setValue(buf);
+	numericTokenStream->setDoubleValue(value);
+	return this;
+}
+
+NumericField* NumericField::setFloatValue(const float value){
+	wchar_t buf[32];
+	_snwprintf(buf, 32, L"%.9g", (double)value);
+	buf[31] = 0;
+	setValue(buf);
+	numericTokenStream->setFloatValue(value);
+	return this;
+}
+
+int32_t NumericField::getPrecisionStep() const{
+	return numericTokenStream->getPrecisionStep();
+}
+
+TokenStream* NumericField::tokenStreamValue(){
+	return isIndexed() ? numericTokenStream : NULL;
+}
+
+const std::wstring NumericField::getObjectName() const{
+	return getClassName();
+}
+
+const std::wstring NumericField::getClassName(){
+	return L"NumericField";
+}
+
+CL_NS_END
@@ -0,0 +1,73 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#ifndef _lucene_document_NumericField_
+#define _lucene_document_NumericField_
+
+#include "Field.h"
+#include "CLucene/util/NumericUtils.h"
+
+CL_CLASS_DEF(analysis,NumericTokenStream)
+
+CL_NS_DEF(document)
+
+/**
+* A field holding an int32_t, int64_t, float or double, indexed so that
+* search::NumericRangeQuery and search::NumericRangeFilter find a range of
+* values by a few terms, rather than by every value in the range as
+* search::RangeQuery does.
+* <p>
+* The value is indexed at several precisions (see util::NumericUtils): the
+* lower precisionStep is, the more terms each value adds to the index and
+* the fewer terms a range query reads. A range must be searched for with
+* the precisionStep and the type the field was indexed with.
+* <pre>
+* NumericField* field = _CLNEW NumericField(_T("price"));
+* field->setDoubleValue(9.99);
+* doc->add(*field);
+* </pre>
+* If the field is stored, or has doc values, its value is the number in
+* decimal. An indexed field has no norms.
+*/
+class CLUCENE_EXPORT NumericField: public Field {
+private:
+	CL_NS(analysis)::NumericTokenStream* numericTokenStream;
+
+public:
+	/**
+	* Creates a field without a value; one of the set*Value() methods must
+	* be called before the document is added. If _config indexes the field,
+	* it is indexed tokenized and without norms.
+	* @throws CLuceneError CL_ERR_IllegalArgument if precisionStep is below 1
+	*/
+	NumericField(const wchar_t* name,
+		const int32_t precisionStep = CL_NS(util)::NumericUtils::PRECISION_STEP_DEFAULT,
+		const int _config = STORE_NO | INDEX_TOKENIZED);
+	virtual ~NumericField();
+
+	/** Sets the value of the field to a 64 bit integer */
+	NumericField* setLongValue(const int64_t value);
+	/** Sets the value of the field to a 32 bit integer */
+	NumericField* setIntValue(const int32_t value);
+	/** Sets the value of the field to a double */
+	NumericField* setDoubleValue(const double value);
+	/** Sets the value of the field to a float */
+	NumericField* setFloatValue(const float value);
+
+	int32_t getPrecisionStep() const;
+
+	/** Returns the stream of the terms of the value, or NULL if the field
+	* is not indexed */
+	CL_NS(analysis)::TokenStream* tokenStreamValue();
+
+	virtual const std::wstring getObjectName() const;
+	static const std::wstring getClassName();
+};
+
+CL_NS_END
+#endif
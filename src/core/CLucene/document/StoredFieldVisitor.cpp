@@ -0,0 +1,24 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "CLucene/_ApiHeader.h"
+
+#include "StoredFieldVisitor.h"
+
+CL_NS_DEF(document)
+
+StoredFieldVisitor::~StoredFieldVisitor(){
+}
+
+void StoredFieldVisitor::stringField(const wchar_t* /*fieldName*/, const wchar_t* /*value*/, const int32_t /*length*/){
+}
+
+void StoredFieldVisitor::binaryField(const wchar_t* /*fieldName*/, const uint8_t* /*value*/, const int32_t /*length*/){
+}
+
+CL_NS_END
@@ -0,0 +1,55 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#ifndef _lucene_document_StoredFieldVisitor_
+#define _lucene_document_StoredFieldVisitor_
+
+CL_NS_DEF(document)
+
+/**
+ * Expert: receives the stored fields of a document as they are read, see
+ * IndexReader::document(int32_t, StoredFieldVisitor&).
+ * <p/>
+ * Unlike loading a {@link Document}, no Field objects or values are
+ * allocated: the values are handed out of buffers owned by the reader,
+ * which are only valid until the visitor method returns. This makes it
+ * cheap to pick a few small fields out of many documents, e.g. to render
+ * a page of results. Use a {@link FieldSelector} to get a Document instead.
+ * <p/>
+ * Field names are interned.
+ */
+class CLUCENE_EXPORT StoredFieldVisitor :LUCENE_BASE {
+public:
+	enum Status {
+		/** Read the value of the field and pass it to stringField() or binaryField() */
+		YES = 0,
+		/** Skip the field */
+		NO = 1,
+		/** Skip the field and all that follow it */
+		STOP = 2
+	};
+
+	virtual ~StoredFieldVisitor();
+
+	/** Called for every stored field of the document, in the order the
+	* fields were added, before the value is read.
+	*/
+	virtual Status needsField(const wchar_t* fieldName) = 0;
+
+	/** A string field (including compressed ones). value holds length
+	* characters and is null-terminated. The default does nothing.
+	*/
+	virtual void stringField(const wchar_t* fieldName, const wchar_t* value, const int32_t length);
+
+	/** A binary field (including compressed ones). The default does nothing.
+	*/
+	virtual void binaryField(const wchar_t* fieldName, const uint8_t* value, const int32_t length);
+};
+
+CL_NS_END
+#endif
@@ -0,0 +1,166 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "CLucene/_ApiHeader.h"
+#include "_SegmentHeader.h"
+
+#include "CLucene/store/IndexInput.h"
+#include "CLucene/util/_ForUtil.h"
+#include "Term.h"
+#include <assert.h>
+
+CL_NS_USE(util)
+CL_NS_DEF(index)
+
+  BlockTermDocs::BlockTermDocs(const SegmentReader* _parent) : SegmentTermDocs(_parent),
+		blockSkipListReader(NULL), docBufferUpto(0), docBufferSize(0)
+  {
+  }
+
+  BlockTermDocs::~BlockTermDocs() {
+      close();
+  }
+
+  void BlockTermDocs::seek(const TermInfo* ti,Term* term) {
+	  SegmentTermDocs::seek(ti, term);
+	  docBufferUpto = docBufferSize = 0;
+  }
+
+  void BlockTermDocs::close() {
+	  SegmentTermDocs::close();
+	  _CLDELETE( blockSkipListReader );
+  }
+
+  void BlockTermDocs::refill() {
+	  // blocks start at multiples of BLOCK_LENGTH documents of the term, only
+	  // the last one is shorter and written as vints
+	  const int32_t left = df - count;
+	  if (left >= ForUtil::BLOCK_LENGTH) {
+		  ForUtil::readBlock(freqStream, docBuffer);
+		  ForUtil::readBlock(freqStream, freqBuffer);
+		  docBufferSize = ForUtil::BLOCK_LENGTH;
+	  } else {
+		  for (int32_t i = 0; i < left; i++) {
+			  const uint32_t docCode = freqStream->readVInt();
+			  docBuffer[i] = docCode >> 1;
+			  freqBuffer[i] = (docCode & 1) != 0 ? 1 : freqStream->readVInt();
+		  }
+		  docBufferSize = left;
+	  }
+
+	  int32_t doc = _doc;
+	  for (int32_t i = 0; i < docBufferSize; i++)
+		  docBuffer[i] = doc += docBuffer[i];
+	  docBufferUpto = 0;
+  }
+
+  bool BlockTermDocs::next() {
+    while (true) {
+      if (count == df)
+        return false;
+      if (docBufferUpto == docBufferSize)
+        refill();
+
+      _doc = docBuffer[docBufferUpto];
+      _freq = freqBuffer[docBufferUpto];
+      docBufferUpto++;
+      count++;
+
+      if ( (deletedDocs == NULL) || (_doc >= 0 && deletedDocs->get(_doc) == false ) )
+        break;
+      skippingDoc();
+    }
+    return true;
+  }
+
+  int32_t BlockTermDocs::read(int32_t* docs, int32_t* freqs, int32_t length) {
+	  int32_t i = 0;
+	  while (i < length && count < df) {
+		  if (docBufferUpto == docBufferSize)
+			  refill();
+
+		  const int32_t n = cl_min(length - i, docBufferSize - docBufferUpto);
+		  if (deletedDocs == NULL) {
+			  memcpy(docs + i, docBuffer + docBufferUpto, n * sizeof(int32_t));
+			  memcpy(freqs + i, freqBuffer + docBufferUpto, n * sizeof(int32_t));
+			  i += n;
+		  } else {
+			  for (int32_t j = docBufferUpto; j < docBufferUpto + n; j++) {
+				  if (!deletedDocs->get(docBuffer[j])) {
+					  docs[i] = docBuffer[j];
+					  freqs[i] = freqBuffer[j];
+					  i++;
+				  }
+			  }
+		  }
+		  docBufferUpto += n;
+		  count += n;
+		  _doc = docBuffer[docBufferUpto - 1];
+		  _freq = freqBuffer[docBufferUpto - 1];
+	  }
+	  return i;
+  }
+
+  void BlockTermDocs::initSkipListReader(){
+    if (blockSkipListReader == NULL)
+      blockSkipListReader = _CLNEW BlockSkipListReader(freqStream->clone(), maxSkipLevels); // lazily clone
+
+    if (!haveSkipped) {                          // lazily initialize skip stream
+      blockSkipListReader->init(skipPointer, freqBasePointer, proxBasePointer, df);
+      haveSkipped = true;
+    }
+  }
+
+  int32_t BlockTermDocs::maxFreqInBlock(const int32_t target, int32_t& blockEnd){
+    blockEnd = LUCENE_INT32_MAX_SHOULDBE;
+    if (termMaxFreq < 0 || df <= ForUtil::BLOCK_LENGTH)
+      return termMaxFreq;
+
+    // moves the skip list reader only, skipTo() picks up from there
+    initSkipListReader();
+    if (target <= blockSkipListReader->getDoc()) {
+      // before the block the reader is at: bound everything up to it
+      blockEnd = blockSkipListReader->getDoc();
+      return termMaxFreq;
+    }
+    blockSkipListReader->skipTo(target);
+    const int32_t next = blockSkipListReader->getNextSkipDoc();
+    if (next == LUCENE_INT32_MAX_SHOULDBE)
+      return termMaxFreq; // after the last skip entry
+    blockEnd = next;
+    return blockSkipListReader->getNextMaxFreq();
+  }
+
+  bool BlockTermDocs::skipTo(const int32_t target){
+    assert(count <= df );
+
+    if (df > ForUtil::BLOCK_LENGTH) {                // there are skip entries
+      initSkipListReader();
+
+      // the number of documents before the block of the skip entry
+      const int32_t newCount = blockSkipListReader->skipTo(target) + 1;
+      // maxFreqInBlock() may have taken the reader past target already
+      if (newCount > count && blockSkipListReader->getDoc() < target) {
+        freqStream->seek(blockSkipListReader->getFreqPointer());
+        skipProxBlock(blockSkipListReader->getProxPointer(), blockSkipListReader->getPosUpto());
+
+        _doc = blockSkipListReader->getDoc();
+        count = newCount;
+        docBufferUpto = docBufferSize = 0;
+      }
+    }
+
+    // done skipping, now just scan
+    do {
+      if (!next())
+        return false;
+    } while (target > _doc);
+    return true;
+  }
+
+CL_NS_END
@@ -0,0 +1,232 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "CLucene/_ApiHeader.h"
+#include "_SegmentHeader.h"
+
+#include "Terms.h"
+#include "CLucene/store/IndexInput.h"
+#include "CLucene/util/_ForUtil.h"
+
+CL_NS_USE(util)
+CL_NS_DEF(index)
+
+BlockTermPositions::BlockTermPositions(const SegmentReader* _parent):
+	BlockTermDocs(_parent), proxStream(NULL)// the proxStream will be cloned lazily when nextPosition() is called for the first time
+	,proxCount(0), position(0), payloadBytes(64), posBufferUpto(0), posBufferSize(0), payloadByteUpto(0)
+	,payloadLength(0), payloadOffset(0), needToLoadPayload(false), lazySkipPointer(-1), lazySkipProxCount(0)
+{
+}
+
+BlockTermPositions::~BlockTermPositions() {
+    close();
+}
+
+TermDocs* BlockTermPositions::__asTermDocs(){
+    return (TermDocs*) this;
+}
+TermPositions* BlockTermPositions::__asTermPositions(){
+    return (TermPositions*) this;
+}
+
+void BlockTermPositions::seek(const TermInfo* ti, Term* term) {
+    BlockTermDocs::seek(ti, term);
+    if (ti != NULL)
+    	lazySkipPointer = ti->proxPointer;
+
+    lazySkipProxCount = 0;
+    proxCount = 0;
+    posBufferUpto = posBufferSize = 0;
+    payloadLength = 0;
+    needToLoadPayload = false;
+}
+
+void BlockTermPositions::close() {
+    BlockTermDocs::close();
+    //Check if proxStream still exists
+    if(proxStream){
+        proxStream->close();
+        _CLDELETE( proxStream );
+    }
+}
+
+void BlockTermPositions::refillPositions() {
+	const int32_t header = proxStream->readByte();
+	if (header == 0) {
+		ForUtil::readBlock(proxStream, posDeltas);
+		if (currentFieldStoresPayloads)
+			ForUtil::readBlock(proxStream, payloadLengths);
+		posBufferSize = ForUtil::BLOCK_LENGTH;
+	} else {
+		// the last positions of the term
+		int32_t length = -1;
+		for (int32_t i = 0; i < header; i++) {
+			const uint32_t code = proxStream->readVInt();
+			if (currentFieldStoresPayloads) {
+				if ((code & 1) != 0)
+					length = proxStream->readVInt();
+				payloadLengths[i] = length;
+				posDeltas[i] = code >> 1;
+			} else {
+				posDeltas[i] = code;
+			}
+		}
+		posBufferSize = header;
+	}
+	if (currentFieldStoresPayloads) {
+		const int32_t numBytes = proxStream->readVInt();
+		if (payloadBytes.length < (size_t)numBytes)
+			payloadBytes.resize(numBytes);
+		proxStream->readBytes(payloadBytes.values, numBytes);
+	}
+	posBufferUpto = 0;
+	payloadByteUpto = 0;
+}
+
+void BlockTermPositions::skipPositionBlock() {
+	if (proxStream->readByte() != 0)
+		_CLTHROWA(CL_ERR_CorruptIndex, "Incomplete block of positions before the last one of a term");
+	ForUtil::skipBlock(proxStream);
+	if (currentFieldStoresPayloads) {
+		ForUtil::skipBlock(proxStream);
+		const int32_t numBytes = proxStream->readVInt();
+		proxStream->seek(proxStream->getFilePointer() + numBytes);
+	}
+}
+
+void BlockTermPositions::skipBufferedPositions(const int32_t n) {
+	if (currentFieldStoresPayloads) {
+		for (int32_t i = posBufferUpto; i < posBufferUpto + n; i++)
+			payloadByteUpto += payloadLengths[i];
+	}
+	posBufferUpto += n;
+}
+
+void BlockTermPositions::lazySkip() {
+    if (proxStream == NULL) {
+      // clone lazily
+      proxStream = parent->proxStream->clone();
+    }
+
+    // the payload of the previous position is in the buffer already
+    needToLoadPayload = false;
+
+    if (lazySkipPointer != -1) {
+      proxStream->seek(lazySkipPointer);
+      lazySkipPointer = -1;
+      posBufferUpto = posBufferSize = 0;
+    }
+
+    if (lazySkipProxCount != 0) {
+      int32_t n = lazySkipProxCount;
+      lazySkipProxCount = 0;
+      const int32_t buffered = posBufferSize - posBufferUpto;
+      if (n <= buffered) {
+        skipBufferedPositions(n);
+        return;
+      }
+      n -= buffered;
+      posBufferUpto = posBufferSize;
+
+      // at least one position follows the skipped ones, so the blocks
+      // skipped whole are packed ones
+      while (n >= ForUtil::BLOCK_LENGTH) {
+        skipPositionBlock();
+        n -= ForUtil::BLOCK_LENGTH;
+      }
+      if (n > 0) {
+        refillPositions();
+        skipBufferedPositions(n);
+      }
+    }
+}
+
+int32_t BlockTermPositions::nextPosition() {
+    // perform lazy skips if neccessary
+	lazySkip();
+	if (posBufferUpto == posBufferSize)
+		refillPositions();
+    proxCount--;
+
+	if (currentFieldStoresPayloads) {
+		payloadLength = payloadLengths[posBufferUpto];
+		payloadOffset = payloadByteUpto;
+		payloadByteUpto += payloadLength;
+		needToLoadPayload = true;
+	}
+    return position += posDeltas[posBufferUpto++];
+}
+
+void BlockTermPositions::nextPositions(int32_t* positions, const int32_t length) {
+	lazySkip();
+	proxCount -= length;
+
+	int32_t i = 0;
+	while (i < length) {
+		if (posBufferUpto == posBufferSize)
+			refillPositions();
+		const int32_t n = cl_min(length - i, posBufferSize - posBufferUpto);
+		for ( const int32_t end = i + n; i < end; i++ )
+			positions[i] = position += posDeltas[posBufferUpto++];
+		if (currentFieldStoresPayloads) {
+			// the payloads are not loaded
+			for (int32_t j = posBufferUpto - n; j < posBufferUpto; j++)
+				payloadByteUpto += payloadLengths[j];
+		}
+	}
+}
+
+void BlockTermPositions::skippingDoc() {
+	lazySkipProxCount += _freq;
+}
+
+bool BlockTermPositions::next() {
+	// we remember to skip the remaining positions of the current
+    // document lazily
+    lazySkipProxCount += proxCount;
+
+    if (BlockTermDocs::next()) {				  // run super
+        proxCount = _freq;				  // note frequency
+        position = 0;				  // reset position
+        return true;
+    }
+    return false;
+}
+
+int32_t BlockTermPositions::read(int32_t* /*docs*/, int32_t* /*freqs*/, int32_t /*length*/) {
+    _CLTHROWA(CL_ERR_UnsupportedOperation,"TermPositions does not support processing multiple documents in one call. Use TermDocs instead.");
+}
+
+void BlockTermPositions::skipProxBlock(const int64_t proxPointer, const int32_t posUpto){
+    // we save the pointer, we might have to skip there lazily
+    lazySkipPointer = proxPointer;
+    lazySkipProxCount = posUpto;
+    proxCount = 0;
+    needToLoadPayload = false;
+}
+
+int32_t BlockTermPositions::getPayloadLength() const { return payloadLength; }
+
+uint8_t* BlockTermPositions::getPayload(uint8_t* data) {
+	if (!needToLoadPayload) {
+		_CLTHROWA(CL_ERR_IO, "Payload cannot be loaded more than once for the same term position.");
+	}
+
+	uint8_t* retArray;
+	if (data == NULL) {
+		retArray = _CL_NEWARRAY(uint8_t, payloadLength);
+	} else {
+		retArray = data;
+	}
+	memcpy(retArray, payloadBytes.values + payloadOffset, payloadLength);
+	needToLoadPayload = false;
+	return retArray;
+}
+bool BlockTermPositions::isPayloadAvailable() const { return needToLoadPayload && (payloadLength > 0); }
+
+CL_NS_END
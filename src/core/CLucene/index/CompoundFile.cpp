@@ -14,6 +14,7 @@
 #include "CLucene/util/Misc.h"
 #include "CLucene/store/IndexInput.h"
 #include "CLucene/store/IndexOutput.h"
+#include "CLucene/store/FSDirectory.h"
 
 CL_NS_USE(store)
 CL_NS_USE(util)
@@ -72,6 +73,7 @@ public:
     /** Closes the stream to futher operations. */
     void close();
     CL_NS(store)::IndexInput* clone() const;
+    void setAccessPattern(AccessPattern pattern);
 
     int64_t length() const { return _length; }
 
@@ -131,6 +133,14 @@ void CSIndexInput::close()
 {
 }
 
+void CSIndexInput::setAccessPattern(AccessPattern pattern)
+{
+    //reading ahead only pays off if the compound file is read from disk
+    if (pattern == ACCESS_SEQUENTIAL && base->getDirectoryType() != FSDirectory::getClassName())
+        pattern = ACCESS_NORMAL;
+    BufferedIndexInput::setAccessPattern(pattern);
+}
+
 
 
 CompoundFileReader::CompoundFileReader(Directory* dir, const wchar_t * name, int32_t _readBufferSize) :
@@ -469,6 +479,7 @@ void CompoundFileWriter::copyFile(WriterFileEntry* source, IndexOutput* os, uint
         int64_t startPtr = os->getFilePointer();
 
         is = _internal->directory->openInput(source->file);
+        is->setAccessPattern(IndexInput::ACCESS_SEQUENTIAL);
         int64_t length = is->length();
         int64_t remainder = length;
         int32_t chunk = bufferLength;
@@ -24,6 +24,16 @@ CL_NS_DEF(index)
 
 
   void DirectoryIndexReader::doClose() {
+    // the readers of the writer's own pool never had a writer and so never
+    // take READERS_LOCK, which the writer may hold while closing them
+    if (_LUCENE_ATOMIC_PTR_GET(&writer) != NULL) {
+      SCOPED_LOCK_MUTEX(IndexWriter::READERS_LOCK)
+      if (writer != NULL) {
+        // let the writer release the files of this reader
+        writer->readerClosed(this);
+        writer = NULL;
+      }
+    }
     if(closeDirectory && _directory){
         _directory->close();
     }
@@ -83,6 +93,8 @@ CL_NS_DEF(index)
   }
 
   void DirectoryIndexReader::acquireWriteLock() {
+    if (writer != NULL)
+      _CLTHROWA(CL_ERR_UnsupportedOperation, "a reader opened by IndexWriter::getReader() cannot delete, undelete or set norms: use the IndexWriter instead");
     if (segmentInfos != NULL) {
       ensureOpen();
       if (stale)
@@ -114,6 +126,8 @@ CL_NS_DEF(index)
     this->stale = false;
     this->writeLock = NULL;
     this->rollbackSegmentInfos = NULL;
+    this->writer = NULL;
+    this->writerChangeCount = 0;
     this->_directory = _CL_POINTER(__directory);
     this->segmentInfos = segmentInfos;
     this->closeDirectory = closeDirectory;
@@ -149,13 +163,7 @@ CL_NS_DEF(index)
       SegmentInfos* infos = _CLNEW SegmentInfos;
       infos->read(directory, segmentFileName);
 
-      DirectoryIndexReader* reader;
-
-      if (infos->size() == 1) {          // index is optimized
-        reader = SegmentReader::get(infos, infos->info(0), closeDirectory);
-      } else {
-        reader = _CLNEW MultiSegmentReader(directory, infos, closeDirectory);
-      }
+      DirectoryIndexReader* reader = DirectoryIndexReader::open(directory, infos, closeDirectory);
       reader->setDeletionPolicy(deletionPolicy);
       return reader;
     }
@@ -174,6 +182,14 @@ CL_NS_DEF(index)
     return runner.run();
   }
 
+  DirectoryIndexReader* DirectoryIndexReader::open(Directory* __directory, SegmentInfos* infos, bool closeDirectory) {
+    if (infos->size() == 1) {          // index is optimized
+      return SegmentReader::get(infos, infos->info(0), closeDirectory);
+    } else {
+      return _CLNEW MultiSegmentReader(__directory, infos, closeDirectory);
+    }
+  }
+
 
   class DirectoryIndexReader::FindSegmentsFile_Reopen: public SegmentInfos::FindSegmentsFile<DirectoryIndexReader*>{
     bool closeDirectory;
@@ -212,6 +228,12 @@ CL_NS_DEF(index)
       // the index hasn't changed - nothing to do here
       return this;
     }
+    if (_LUCENE_ATOMIC_PTR_GET(&writer) != NULL) {
+      SCOPED_LOCK_MUTEX(IndexWriter::READERS_LOCK)
+      // a reader of the writer is reopened on its current segments
+      if (writer != NULL)
+        return writer->getReader();
+    }
     FindSegmentsFile_Reopen runner(closeDirectory, deletionPolicy, _directory, this);
     IndexReader* ret = runner.run();
 
@@ -258,6 +280,11 @@ CL_NS_DEF(index)
    */
   bool DirectoryIndexReader::isCurrent(){
     ensureOpen();
+    if (_LUCENE_ATOMIC_PTR_GET(&writer) != NULL) {
+      SCOPED_LOCK_MUTEX(IndexWriter::READERS_LOCK)
+      if (writer != NULL)
+        return writer->isReaderCurrent(this);
+    }
     return SegmentInfos::readCurrentVersion(_directory) == segmentInfos->getVersion();
   }
 
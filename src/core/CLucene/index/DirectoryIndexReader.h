@@ -15,6 +15,7 @@ CL_CLASS_DEF(store,LuceneLock)
 
 CL_NS_DEF(index)
 class IndexDeletionPolicy;
+class IndexWriter;
 
 /**
  * IndexReader implementation that has access to a Directory.
@@ -35,10 +36,18 @@ private:
   bool rollbackHasChanges;
   SegmentInfos* rollbackSegmentInfos;
 
+  /** The writer this reader was opened from by IndexWriter::getReader(),
+   * or NULL. It holds the files of segmentInfos until this reader is closed. */
+  IndexWriter* writer;
+
+  /** The count of changes of the writer when this reader was opened */
+  int64_t writerChangeCount;
+
   class FindSegmentsFile_Open;
   class FindSegmentsFile_Reopen;
   friend class FindSegmentsFile_Open;
   friend class FindSegmentsFile_Reopen;
+  friend class IndexWriter;
 
 protected:
   CL_NS(store)::Directory* _directory;
@@ -87,6 +96,9 @@ public:
   CLUCENE_LOCAL_DECL DirectoryIndexReader(CL_NS(store)::Directory* directory, SegmentInfos* segmentInfos, bool closeDirectory);
   CLUCENE_LOCAL_DECL static DirectoryIndexReader* open(CL_NS(store)::Directory* directory, bool closeDirectory, IndexDeletionPolicy* deletionPolicy);
 
+  /** Opens a reader on the given segments, which it takes ownership of */
+  CLUCENE_LOCAL_DECL static DirectoryIndexReader* open(CL_NS(store)::Directory* directory, SegmentInfos* infos, bool closeDirectory);
+
   IndexReader* reopen();
 
   void setDeletionPolicy(IndexDeletionPolicy* deletionPolicy);
@@ -110,6 +122,8 @@ public:
    * description of the <a href="IndexWriter.html#autoCommit"><code>autoCommit</code></a>
    * flag which controls when the {@link IndexWriter}
    * actually commits changes to the index.
+   * <p>A reader opened by {@link IndexWriter#getReader()} is current while
+   * its writer has neither flushed nor buffered any changes since.
    *
    * @throws CorruptIndexException if the index is corrupt
    * @throws IOException if there is a low-level IO error
@@ -0,0 +1,575 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "CLucene/_ApiHeader.h"
+#include "_DocValues.h"
+#include "_FieldInfos.h"
+#include "_IndexFileNames.h"
+#include "IndexReader.h"
+#include "CLucene/document/Document.h"
+#include "CLucene/document/Field.h"
+#include "CLucene/store/Directory.h"
+#include "CLucene/store/IndexInput.h"
+#include "CLucene/store/IndexOutput.h"
+#include "CLucene/util/PackedInts.h"
+#include <algorithm>
+
+CL_NS_USE(store)
+CL_NS_USE(util)
+CL_NS_USE(document)
+CL_NS_DEF(index)
+
+NumericDocValues::~NumericDocValues(){
+}
+SortedDocValues::~SortedDocValues(){
+}
+
+/** packs values of bits bits into little-endian 64 bit words, as PackedInts keeps them */
+static void writePacked(IndexOutput* output, const uint64_t* values, const int32_t count, const int32_t bits){
+	uint64_t word = 0;
+	int32_t used = 0;
+	uint8_t bytes[8];
+	for ( int32_t i = 0; i < count; i++ ){
+		const uint64_t v = values[i];
+		word |= v << used;
+		if ( used + bits >= 64 ){
+			for ( int32_t b = 0; b < 8; b++ )
+				bytes[b] = (uint8_t)(word >> (b * 8));
+			output->writeBytes(bytes, 8);
+			const int32_t spill = used + bits - 64;
+			word = spill > 0 ? v >> (bits - spill) : 0;
+			used = spill;
+		}else
+			used += bits;
+	}
+	if ( used > 0 ){
+		for ( int32_t b = 0; b < 8; b++ )
+			bytes[b] = (uint8_t)(word >> (b * 8));
+		output->writeBytes(bytes, 8);
+	}
+}
+
+static int32_t packedWords(const int32_t count, const int32_t bits){
+	return (int32_t)(((int64_t)count * bits + 63) >> 6);
+}
+
+static int32_t bitsFor(const uint64_t maxValue){
+	int32_t bits = 1;
+	while ( bits < 64 && (maxValue >> bits) != 0 )
+		bits++;
+	return bits;
+}
+
+
+class DocValuesWriter::FieldValues :LUCENE_BASE{
+public:
+	int32_t number;
+	uint8_t type;
+	std::vector<int64_t> numbers;          //numeric: the value of each doc
+	std::vector<int32_t> ids;              //sorted: 1 + the id of each doc's value, 0 for none
+	std::map<std::wstring, int32_t> terms; //sorted: value -> id, in insertion order
+
+	FieldValues(const int32_t number, const uint8_t type): number(number), type(type){
+	}
+};
+
+DocValuesWriter::DocValuesWriter(){
+}
+
+DocValuesWriter::~DocValuesWriter(){
+	reset();
+}
+
+DocValuesWriter::FieldValues* DocValuesWriter::getField(const FieldInfo* fi, const uint8_t type){
+	if ( fi->docValuesType != type )
+		_CLTHROWA(CL_ERR_IllegalArgument, "field does not have this type of doc values");
+	if ( (size_t)fi->number >= fields.size() )
+		fields.resize(fi->number + 1, NULL);
+	FieldValues* values = fields[fi->number];
+	if ( values == NULL ){
+		values = _CLNEW FieldValues(fi->number, type);
+		fields[fi->number] = values;
+	}
+	return values;
+}
+
+void DocValuesWriter::addNumeric(const FieldInfo* fi, const int32_t doc, const int64_t value){
+	FieldValues* values = getField(fi, FieldInfos::DOC_VALUES_NUMERIC);
+	if ( (size_t)doc >= values->numbers.size() )
+		values->numbers.resize(doc + 1, 0);
+	values->numbers[doc] = value;
+}
+
+void DocValuesWriter::addSorted(const FieldInfo* fi, const int32_t doc, const wchar_t* value){
+	FieldValues* values = getField(fi, FieldInfos::DOC_VALUES_SORTED);
+	std::map<std::wstring, int32_t>::iterator itr = values->terms.find(value);
+	int32_t id;
+	if ( itr == values->terms.end() ){
+		id = (int32_t)values->terms.size();
+		values->terms.insert(std::pair<const std::wstring, int32_t>(value, id));
+	}else
+		id = itr->second;
+	if ( (size_t)doc >= values->ids.size() )
+		values->ids.resize(doc + 1, 0);
+	values->ids[doc] = id + 1;
+}
+
+void DocValuesWriter::addDocument(FieldInfos* fieldInfos, const Document* doc, const int32_t docID){
+	const Document::FieldsType& docFields = *doc->getFields();
+	Document::FieldsType::const_iterator itr;
+
+	//check all values first, so that a bad one leaves nothing behind for docID
+	std::vector<int64_t> numbers;
+	for ( itr = docFields.begin(); itr != docFields.end(); itr++ ){
+		Field* field = *itr;
+		if ( !field->isNumericDocValues() && !field->isSortedDocValues() )
+			continue;
+		const wchar_t* value = field->stringValue();
+		if ( value == NULL )
+			_CLTHROWA(CL_ERR_IllegalArgument, "doc values fields must have a string value");
+		if ( field->isNumericDocValues() ){
+			wchar_t* end = NULL;
+			const int64_t number = _wcstoi64(value, &end, 10);
+			if ( *value == 0 || end == NULL || *end != 0 )
+				_CLTHROWA(CL_ERR_NumberFormat, "numeric doc values must be decimal integers");
+			numbers.push_back(number);
+		}
+	}
+
+	size_t n = 0;
+	for ( itr = docFields.begin(); itr != docFields.end(); itr++ ){
+		Field* field = *itr;
+		if ( field->isNumericDocValues() )
+			addNumeric(fieldInfos->fieldInfo(field->name()), docID, numbers[n++]);
+		else if ( field->isSortedDocValues() )
+			addSorted(fieldInfos->fieldInfo(field->name()), docID, field->stringValue());
+	}
+}
+
+bool DocValuesWriter::hasValues() const{
+	for ( size_t i = 0; i < fields.size(); i++ )
+		if ( fields[i] != NULL )
+			return true;
+	return false;
+}
+
+void DocValuesWriter::write(Directory* directory, const std::wstring& segment, const int32_t numDocs){
+	std::wstring fileName = segment + L"." + IndexFileNames::DOC_VALUES_EXTENSION;
+	IndexOutput* output = directory->createOutput(fileName.c_str());
+	std::vector<int64_t> pointers;
+	try{
+		output->writeInt(FORMAT_CURRENT);
+
+		std::vector<uint64_t> packed(numDocs);
+		for ( size_t i = 0; i < fields.size(); i++ ){
+			FieldValues* values = fields[i];
+			if ( values == NULL )
+				continue;
+			pointers.push_back(output->getFilePointer());
+
+			if ( values->type == FieldInfos::DOC_VALUES_NUMERIC ){
+				values->numbers.resize(numDocs, 0);
+				int64_t minValue = 0, maxValue = 0;
+				for ( int32_t d = 0; d < numDocs; d++ ){
+					const int64_t v = values->numbers[d];
+					if ( d == 0 || v < minValue ) minValue = v;
+					if ( d == 0 || v > maxValue ) maxValue = v;
+				}
+				output->writeLong(minValue);
+				if ( minValue == maxValue ){
+					output->writeByte(0);
+				}else{
+					const int32_t bits = bitsFor((uint64_t)maxValue - (uint64_t)minValue);
+					output->writeByte((uint8_t)bits);
+					for ( int32_t d = 0; d < numDocs; d++ )
+						packed[d] = (uint64_t)values->numbers[d] - (uint64_t)minValue;
+					writePacked(output, &packed[0], numDocs, bits);
+				}
+			}else{
+				//the values come out of the map in natural order, so the rank of each is its ordinal
+				const int32_t valueCount = (int32_t)values->terms.size();
+				std::vector<int32_t> ords(valueCount);
+				int64_t totalChars = 0;
+				int32_t ord = 1;
+				std::map<std::wstring, int32_t>::const_iterator itr;
+				for ( itr = values->terms.begin(); itr != values->terms.end(); itr++ ){
+					ords[itr->second] = ord++;
+					totalChars += itr->first.length();
+				}
+				output->writeVInt(valueCount);
+				output->writeVInt((int32_t)totalChars);
+				for ( itr = values->terms.begin(); itr != values->terms.end(); itr++ ){
+					output->writeVInt((int32_t)itr->first.length());
+					output->writeChars(itr->first.c_str(), (int32_t)itr->first.length());
+				}
+
+				const int32_t bits = bitsFor((uint64_t)valueCount);
+				output->writeByte((uint8_t)bits);
+				values->ids.resize(numDocs, 0);
+				for ( int32_t d = 0; d < numDocs; d++ ){
+					const int32_t id = values->ids[d];
+					packed[d] = id == 0 ? 0 : ords[id - 1];
+				}
+				writePacked(output, numDocs == 0 ? NULL : &packed[0], numDocs, bits);
+			}
+		}
+
+		const int64_t directoryPointer = output->getFilePointer();
+		output->writeVInt((int32_t)pointers.size());
+		size_t p = 0;
+		for ( size_t i = 0; i < fields.size(); i++ ){
+			if ( fields[i] == NULL )
+				continue;
+			output->writeVInt(fields[i]->number);
+			output->writeByte(fields[i]->type);
+			output->writeVLong(pointers[p++]);
+		}
+		output->writeLong(directoryPointer);
+	}_CLFINALLY(
+		output->close();
+		_CLDELETE(output);
+	);
+	reset();
+}
+
+void DocValuesWriter::reset(){
+	for ( size_t i = 0; i < fields.size(); i++ )
+		_CLDELETE(fields[i]);
+	fields.clear();
+}
+
+
+/** a packed array, either mapped from the input or read into memory */
+class PackedValues :LUCENE_BASE{
+	const uint8_t* data;
+	uint8_t* owned;
+	IndexInput* mapped;
+	int32_t bits;
+	uint64_t mask;
+
+	inline uint64_t word(const int32_t index) const{
+		//the file is little-endian, so is every platform this builds on
+		uint64_t w;
+		memcpy(&w, data + ((size_t)index << 3), sizeof(w));
+		return w;
+	}
+public:
+	PackedValues(IndexInput* input, const int32_t count, const int32_t bits):
+		data(NULL), owned(NULL), mapped(NULL), bits(bits)
+	{
+		mask = bits == 64 ? ~(uint64_t)0 : (((uint64_t)1 << bits) - 1);
+		const int32_t numBytes = packedWords(count, bits) << 3;
+		IndexInput* in = input->clone();
+		try{
+			int32_t available = 0;
+			const uint8_t* bytes = in->bufferedBytes(available);
+			if ( bytes != NULL && available >= numBytes ){
+				//the clone keeps the bytes valid, as long as it is not read from
+				data = bytes;
+				mapped = in;
+				in = NULL;
+			}else{
+				owned = _CL_NEWARRAY(uint8_t, numBytes + 1);
+				in->readBytes(owned, numBytes);
+				data = owned;
+			}
+		}_CLFINALLY(
+			if ( in != NULL ){
+				in->close();
+				_CLDELETE(in);
+			}
+		);
+	}
+	~PackedValues(){
+		if ( mapped != NULL ){
+			mapped->close();
+			_CLDELETE(mapped);
+		}
+		_CLDELETE_ARRAY(owned);
+	}
+
+	inline uint64_t get(const int32_t index) const{
+		const int64_t bit = (int64_t)index * bits;
+		const int32_t block = (int32_t)(bit >> 6);
+		const int32_t shift = (int32_t)(bit & 63);
+		uint64_t value = word(block) >> shift;
+		if ( shift + bits > 64 )
+			value |= word(block + 1) << (64 - shift);
+		return value & mask;
+	}
+};
+
+class NumericValues: public NumericDocValues{
+	int64_t minValue;
+	int32_t maxDoc;
+	PackedValues* packed; //NULL if all docs have minValue
+public:
+	NumericValues(IndexInput* input, const int32_t maxDoc): maxDoc(maxDoc), packed(NULL){
+		minValue = input->readLong();
+		const int32_t bits = input->readByte();
+		if ( bits != 0 )
+			packed = _CLNEW PackedValues(input, maxDoc, bits);
+	}
+	~NumericValues(){
+		_CLDELETE(packed);
+	}
+	int64_t get(const int32_t doc) const{
+		CND_PRECONDITION(doc >= 0 && doc < maxDoc, "doc out of range");
+		return packed == NULL ? minValue : (int64_t)((uint64_t)minValue + packed->get(doc));
+	}
+};
+
+class SortedValues: public SortedDocValues{
+	int32_t valueCount;
+	int32_t maxDoc;
+	wchar_t* chars;   //the values, each null-terminated
+	int32_t* offsets; //where each value starts in chars
+	PackedValues* ords;
+public:
+	SortedValues(IndexInput* input, const int32_t maxDoc): maxDoc(maxDoc){
+		valueCount = input->readVInt();
+		const int32_t totalChars = input->readVInt();
+		chars = _CL_NEWARRAY(wchar_t, totalChars + valueCount + 1);
+		offsets = _CL_NEWARRAY(int32_t, valueCount + 1);
+		int32_t pos = 0;
+		for ( int32_t i = 0; i < valueCount; i++ ){
+			const int32_t len = input->readVInt();
+			offsets[i] = pos;
+			input->readChars(chars, pos, len);
+			pos += len;
+			chars[pos++] = 0;
+		}
+		const int32_t bits = input->readByte();
+		ords = _CLNEW PackedValues(input, maxDoc, bits);
+	}
+	~SortedValues(){
+		_CLDELETE(ords);
+		_CLDELETE_ARRAY(chars);
+		_CLDELETE_ARRAY(offsets);
+	}
+	int32_t getOrd(const int32_t doc) const{
+		CND_PRECONDITION(doc >= 0 && doc < maxDoc, "doc out of range");
+		return (int32_t)ords->get(doc);
+	}
+	int32_t getValueCount() const{
+		return valueCount;
+	}
+	const wchar_t* lookup(const int32_t ord) const{
+		CND_PRECONDITION(ord >= 0 && ord <= valueCount, "ord out of range");
+		return ord == 0 ? NULL : chars + offsets[ord - 1];
+	}
+};
+
+class DocValuesReader::Entry :LUCENE_BASE{
+public:
+	uint8_t type;
+	int64_t pointer;
+	NumericDocValues* numeric;
+	SortedDocValues* sorted;
+
+	Entry(const uint8_t type, const int64_t pointer): type(type), pointer(pointer), numeric(NULL), sorted(NULL){
+	}
+	~Entry(){
+		_CLDELETE(numeric);
+		_CLDELETE(sorted);
+	}
+};
+
+DocValuesReader::DocValuesReader(Directory* dir, const wchar_t* segment, const int32_t maxDoc, const int32_t readBufferSize):
+	input(NULL), maxDoc(maxDoc)
+{
+	std::wstring fileName = std::wstring(segment) + L"." + IndexFileNames::DOC_VALUES_EXTENSION;
+	input = dir->openInput(fileName.c_str(), readBufferSize);
+	try{
+		input->setAccessPattern(IndexInput::ACCESS_RANDOM);
+		const int32_t format = input->readInt();
+		if ( format < DocValuesWriter::FORMAT_CURRENT )
+			_CLTHROWA(CL_ERR_CorruptIndex, "Unknown doc values format");
+		input->seek(input->length() - 8);
+		input->seek(input->readLong());
+		const int32_t count = input->readVInt();
+		for ( int32_t i = 0; i < count; i++ ){
+			const int32_t number = input->readVInt();
+			const uint8_t type = input->readByte();
+			const int64_t pointer = input->readVLong();
+			if ( (size_t)number >= entries.size() )
+				entries.resize(number + 1, NULL);
+			entries[number] = _CLNEW Entry(type, pointer);
+		}
+	}catch(CLuceneError&){
+		for ( size_t i = 0; i < entries.size(); i++ )
+			_CLDELETE(entries[i]);
+		input->close();
+		_CLDELETE(input);
+		throw;
+	}
+}
+
+DocValuesReader::~DocValuesReader(){
+	for ( size_t i = 0; i < entries.size(); i++ )
+		_CLDELETE(entries[i]);
+	input->close();
+	_CLDELETE(input);
+}
+
+DocValuesReader::Entry* DocValuesReader::getEntry(const FieldInfo* fi, const uint8_t type){
+	if ( fi == NULL || (size_t)fi->number >= entries.size() )
+		return NULL;
+	Entry* entry = entries[fi->number];
+	if ( entry == NULL || entry->type != type )
+		return NULL;
+	if ( entry->numeric == NULL && entry->sorted == NULL ){
+		input->seek(entry->pointer);
+		if ( type == FieldInfos::DOC_VALUES_NUMERIC )
+			entry->numeric = _CLNEW NumericValues(input, maxDoc);
+		else
+			entry->sorted = _CLNEW SortedValues(input, maxDoc);
+	}
+	return entry;
+}
+
+NumericDocValues* DocValuesReader::getNumeric(const FieldInfo* fi){
+	SCOPED_LOCK_MUTEX(THIS_LOCK);
+	Entry* entry = getEntry(fi, FieldInfos::DOC_VALUES_NUMERIC);
+	return entry == NULL ? NULL : entry->numeric;
+}
+
+SortedDocValues* DocValuesReader::getSorted(const FieldInfo* fi){
+	SCOPED_LOCK_MUTEX(THIS_LOCK);
+	Entry* entry = getEntry(fi, FieldInfos::DOC_VALUES_SORTED);
+	return entry == NULL ? NULL : entry->sorted;
+}
+
+
+/** finds the sub reader holding doc */
+static inline int32_t subIndex(const int32_t* starts, const int32_t subCount, const int32_t doc){
+	return (int32_t)(std::upper_bound(starts, starts + subCount, doc) - starts) - 1;
+}
+
+class MultiDocValues::Numeric: public NumericDocValues{
+	std::vector<NumericDocValues*> subs; //NULL for subs without values
+	const int32_t* starts;
+public:
+	Numeric(const std::vector<NumericDocValues*>& subs, const int32_t* starts): subs(subs), starts(starts){
+	}
+	int64_t get(const int32_t doc) const{
+		const int32_t i = subIndex(starts, (int32_t)subs.size(), doc);
+		return subs[i] == NULL ? 0 : subs[i]->get(doc - starts[i]);
+	}
+};
+
+static bool wcsLess(const wchar_t* a, const wchar_t* b){
+	return wcscmp(a, b) < 0;
+}
+
+class MultiDocValues::Sorted: public SortedDocValues{
+	std::vector<SortedDocValues*> subs;  //NULL for subs without values
+	std::vector<PackedInts*> globalOrds; //ordinal of each sub ordinal across all subs
+	std::vector<const wchar_t*> values;  //the distinct values, owned by the subs
+	const int32_t* starts;
+public:
+	Sorted(const std::vector<SortedDocValues*>& subs, const int32_t* starts): subs(subs), starts(starts){
+		//only the values are merged, the documents keep the ordinals of their sub
+		for ( size_t i = 0; i < subs.size(); i++ ){
+			if ( subs[i] == NULL )
+				continue;
+			for ( int32_t ord = 1; ord <= subs[i]->getValueCount(); ord++ )
+				values.push_back(subs[i]->lookup(ord));
+		}
+		std::sort(values.begin(), values.end(), wcsLess);
+		size_t unique = 0;
+		for ( size_t i = 0; i < values.size(); i++ )
+			if ( unique == 0 || wcscmp(values[unique - 1], values[i]) != 0 )
+				values[unique++] = values[i];
+		values.resize(unique);
+
+		const int32_t bits = PackedInts::bitsRequired((int64_t)values.size());
+		for ( size_t i = 0; i < subs.size(); i++ ){
+			if ( subs[i] == NULL ){
+				globalOrds.push_back(NULL);
+				continue;
+			}
+			const int32_t count = subs[i]->getValueCount();
+			PackedInts* map = _CLNEW PackedInts(count + 1, bits);
+			//both are in natural order, so one pass finds all of them
+			size_t global = 0;
+			for ( int32_t ord = 1; ord <= count; ord++ ){
+				const wchar_t* value = subs[i]->lookup(ord);
+				while ( wcscmp(values[global], value) != 0 )
+					global++;
+				map->set(ord, (int64_t)global + 1);
+			}
+			globalOrds.push_back(map);
+		}
+	}
+	~Sorted(){
+		for ( size_t i = 0; i < globalOrds.size(); i++ )
+			_CLDELETE(globalOrds[i]);
+	}
+	int32_t getOrd(const int32_t doc) const{
+		const int32_t i = subIndex(starts, (int32_t)subs.size(), doc);
+		if ( subs[i] == NULL )
+			return 0;
+		return (int32_t)globalOrds[i]->get(subs[i]->getOrd(doc - starts[i]));
+	}
+	int32_t getValueCount() const{
+		return (int32_t)values.size();
+	}
+	const wchar_t* lookup(const int32_t ord) const{
+		CND_PRECONDITION(ord >= 0 && ord <= (int32_t)values.size(), "ord out of range");
+		return ord == 0 ? NULL : values[ord - 1];
+	}
+};
+
+MultiDocValues::MultiDocValues(){
+}
+
+MultiDocValues::~MultiDocValues(){
+	std::map<std::wstring, NumericDocValues*>::iterator n;
+	for ( n = numeric.begin(); n != numeric.end(); n++ )
+		_CLDELETE(n->second);
+	std::map<std::wstring, SortedDocValues*>::iterator s;
+	for ( s = sorted.begin(); s != sorted.end(); s++ )
+		_CLDELETE(s->second);
+}
+
+NumericDocValues* MultiDocValues::getNumeric(const wchar_t* field, ArrayBase<IndexReader*>* subReaders, const int32_t* starts){
+	std::map<std::wstring, NumericDocValues*>::iterator itr = numeric.find(field);
+	if ( itr != numeric.end() )
+		return itr->second;
+
+	std::vector<NumericDocValues*> subs;
+	bool any = false;
+	for ( size_t i = 0; i < subReaders->length; i++ ){
+		NumericDocValues* values = (*subReaders)[i]->getNumericDocValues(field);
+		any = any || values != NULL;
+		subs.push_back(values);
+	}
+	NumericDocValues* ret = any ? _CLNEW Numeric(subs, starts) : NULL;
+	numeric[field] = ret;
+	return ret;
+}
+
+SortedDocValues* MultiDocValues::getSorted(const wchar_t* field, ArrayBase<IndexReader*>* subReaders, const int32_t* starts){
+	std::map<std::wstring, SortedDocValues*>::iterator itr = sorted.find(field);
+	if ( itr != sorted.end() )
+		return itr->second;
+
+	std::vector<SortedDocValues*> subs;
+	bool any = false;
+	for ( size_t i = 0; i < subReaders->length; i++ ){
+		SortedDocValues* values = (*subReaders)[i]->getSortedDocValues(field);
+		any = any || values != NULL;
+		subs.push_back(values);
+	}
+	SortedDocValues* ret = any ? _CLNEW Sorted(subs, starts) : NULL;
+	sorted[field] = ret;
+	return ret;
+}
+
+CL_NS_END
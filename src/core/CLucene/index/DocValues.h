@@ -0,0 +1,54 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#ifndef _lucene_index_DocValues_
+#define _lucene_index_DocValues_
+
+CL_NS_DEF(index)
+
+/**
+ * Per-document numeric values of a field, see Field::DOCVALUES_NUMERIC
+ * and IndexReader::getNumericDocValues().
+ * <p/>
+ * The values are written column-stride, one packed array per field and
+ * segment, so they can be read straight from the index instead of being
+ * un-inverted from the terms like the FieldCache does.
+ */
+class CLUCENE_EXPORT NumericDocValues :LUCENE_BASE {
+public:
+	virtual ~NumericDocValues();
+
+	/** Returns the value of the document, 0 if it has none. */
+	virtual int64_t get(const int32_t doc) const = 0;
+};
+
+/**
+ * Per-document string values of a field, see Field::DOCVALUES_SORTED
+ * and IndexReader::getSortedDocValues().
+ * <p/>
+ * Each document has the ordinal of its value. Ordinal 0 stands for documents
+ * without a value, the distinct values follow in natural order from ordinal
+ * 1, so comparing ordinals compares the values, as in FieldCache::StringIndex.
+ */
+class CLUCENE_EXPORT SortedDocValues :LUCENE_BASE {
+public:
+	virtual ~SortedDocValues();
+
+	/** Returns the ordinal of the value of the document, 0 if it has none. */
+	virtual int32_t getOrd(const int32_t doc) const = 0;
+
+	/** Returns the number of distinct values, ordinals run from 1 to this. */
+	virtual int32_t getValueCount() const = 0;
+
+	/** Returns the value with the given ordinal, NULL for ordinal 0.
+	 * The value belongs to the reader and is valid while it is open. */
+	virtual const wchar_t* lookup(const int32_t ord) const = 0;
+};
+
+CL_NS_END
+#endif
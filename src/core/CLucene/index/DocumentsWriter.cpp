@@ -29,12 +29,13 @@
 #include "_TermInfo.h"
 #include "_TermVector.h"
 #include "_TermInfosWriter.h"
-#include "_SkipListWriter.h"
+#include "_PostingsCodec.h"
 #include "CLucene/analysis/AnalysisHeader.h"
 #include "CLucene/search/Similarity.h"
 #include "_TermInfosWriter.h"
 #include "_FieldsWriter.h"
 #include "_DocumentsWriter.h"
+#include "_DocValues.h"
 #include <assert.h>
 #include <algorithm>
 #include <iostream>
@@ -47,7 +48,7 @@ CL_NS_USE(search)
 CL_NS_DEF(index)
 
 
-const int32_t DocumentsWriter::MAX_THREAD_STATE = 5;
+const int32_t DocumentsWriter::MAX_THREAD_STATE = LUCENE_MAX_INDEXING_THREADS;
 const uint8_t DocumentsWriter::defaultNorm = Similarity::encodeNorm(1.0f);
 const int32_t DocumentsWriter::nextLevelArray[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 9};
 const int32_t DocumentsWriter::levelSizeArray[10] = {5, 14, 20, 30, 40, 40, 80, 80, 120, 200};
@@ -93,19 +94,18 @@ DocumentsWriter::DocumentsWriter(CL_NS(store)::Directory* directory, IndexWriter
   this->writer = writer;
   this->hasNorms = this->bufferIsFull = false;
   fieldInfos = _CLNEW FieldInfos();
+  docValuesWriter = _CLNEW DocValuesWriter();
 
 	maxBufferedDeleteTerms = IndexWriter::DEFAULT_MAX_BUFFERED_DELETE_TERMS;
 	ramBufferSize = (int64_t) (IndexWriter::DEFAULT_RAM_BUFFER_SIZE_MB*1024*1024);
 	maxBufferedDocs = IndexWriter::DEFAULT_MAX_BUFFERED_DOCS;
 
 	numBufferedDeleteTerms = 0;
-  copyByteBuffer = _CL_NEWARRAY(uint8_t, 4096);
-  *copyByteBuffer = 0;
 
   this->closed = this->flushPending = false;
   _files = NULL;
   _abortedFiles = NULL;
-  skipListWriter = NULL;
+  postingsWriter = NULL;
   infoStream = NULL;
   fieldsWriter = NULL;
   tvx = tvf = tvd = NULL;
@@ -114,10 +114,10 @@ DocumentsWriter::DocumentsWriter(CL_NS(store)::Directory* directory, IndexWriter
 }
 DocumentsWriter::~DocumentsWriter(){
   _CLLDELETE(bufferedDeleteTerms);
-  _CLLDELETE(skipListWriter);
-  _CLDELETE_LARRAY(copyByteBuffer);
+  _CLLDELETE(postingsWriter);
   _CLLDELETE(_files);
   _CLLDELETE(fieldInfos);
+  _CLLDELETE(docValuesWriter);
 
   for(size_t i=0;i<threadStates.length;i++) {
     _CLLDELETE(threadStates.values[i]);
@@ -206,10 +206,11 @@ std::wstring DocumentsWriter::closeDocStore() {
 
     if (fieldsWriter != NULL) {
       assert (!docStoreSegment.empty());
+      const int32_t fdxHeaderLength = fieldsWriter->indexHeaderLength();
       fieldsWriter->close();
       _CLDELETE(fieldsWriter);
 
-      assert(numDocsInStore*8 == directory->fileLength( (docStoreSegment + L"." + IndexFileNames::FIELDS_INDEX_EXTENSION).c_str() ) );// "after flush: fdx size mismatch: " + numDocsInStore + " docs vs " + directory->fileLength(docStoreSegment + "." + IndexFileNames::FIELDS_INDEX_EXTENSION) + " length in bytes of " + docStoreSegment + "." + IndexFileNames::FIELDS_INDEX_EXTENSION;
+      assert(fdxHeaderLength + numDocsInStore*8 == directory->fileLength( (docStoreSegment + L"." + IndexFileNames::FIELDS_INDEX_EXTENSION).c_str() ) );// "after flush: fdx size mismatch: " + numDocsInStore + " docs vs " + directory->fileLength(docStoreSegment + "." + IndexFileNames::FIELDS_INDEX_EXTENSION) + " length in bytes of " + docStoreSegment + "." + IndexFileNames::FIELDS_INDEX_EXTENSION;
     }
 
     std::wstring s = docStoreSegment;
@@ -364,6 +365,9 @@ void DocumentsWriter::abort(AbortException* ae) {
         }
       }
 
+      // Discard pending doc values:
+      docValuesWriter->reset();
+
       // Reset all postings data
       resetPostingsData();
 
@@ -395,11 +399,18 @@ void DocumentsWriter::resetPostingsData() {
   balanceRAM();
   bufferIsFull = false;
   flushPending = false;
+
+  // Each thread keeps up to its share of the RAM buffer in
+  // free blocks, the rest goes back to the shared pool where
+  // balanceRAM can free it
+  const int64_t maxBytesPerThread = ramBufferSize == IndexWriter::DISABLE_AUTO_FLUSH
+    ? -1 : ramBufferSize / cl_max(1, (int32_t)threadStates.length);
   for(size_t i=0;i<threadStates.length;i++) {
     threadStates[i]->numThreads = 0;
     threadStates[i]->resetPostings();
+    threadStates[i]->trimBlocks(maxBytesPerThread);
   }
-  numBytesUsed = 0;
+  _LUCENE_ATOMIC_INT_SET(numBytesUsed, 0);
 }
 
 // Returns true if an abort is in progress
@@ -553,9 +564,6 @@ void DocumentsWriter::writeSegment(std::vector<std::wstring>& flushedFiles) {
   TermInfosWriter* termsOut = _CLNEW TermInfosWriter(directory, segmentName.c_str(), fieldInfos,
                                                  writer->getTermIndexInterval());
 
-  IndexOutput* freqOut = directory->createOutput( (segmentName + L".frq").c_str() );
-  IndexOutput* proxOut = directory->createOutput( (segmentName + L".prx").c_str() );
-
   // Gather all FieldData's that have postings, across all
   // ThreadStates
   std::vector<ThreadState::FieldData*> allFields;
@@ -575,9 +583,10 @@ void DocumentsWriter::writeSegment(std::vector<std::wstring>& flushedFiles) {
   std::sort(allFields.begin(),allFields.end(),ThreadState::FieldData::sort);
   const int32_t numAllFields = allFields.size();
 
-  skipListWriter = _CLNEW DefaultSkipListWriter(termsOut->skipInterval,
+  postingsWriter = PostingsCodec::forFormat(writer->getPostingsFormat())->newWriter(directory, segmentName,
+                                             termsOut->skipInterval,
                                              termsOut->maxSkipLevels,
-                                             numDocsInRAM, freqOut, proxOut);
+                                             numDocsInRAM);
 
   int32_t start = 0;
   while(start < numAllFields) {
@@ -594,7 +603,7 @@ void DocumentsWriter::writeSegment(std::vector<std::wstring>& flushedFiles) {
 
     // If this field has postings then add them to the
     // segment
-    appendPostings(&fields, termsOut, freqOut, proxOut);
+    appendPostings(&fields, termsOut);
 
     for(size_t i=0;i<fields.length;i++)
       fields[i]->resetPostingArrays();
@@ -602,13 +611,10 @@ void DocumentsWriter::writeSegment(std::vector<std::wstring>& flushedFiles) {
     start = end;
   }
 
-  freqOut->close();
-  _CLDELETE(freqOut);
-  proxOut->close();
-  _CLDELETE(proxOut);
+  postingsWriter->close();
+  _CLDELETE(postingsWriter);
   termsOut->close();
   _CLDELETE(termsOut);
-  _CLDELETE(skipListWriter);
 
   // Record all files we have flushed
   flushedFiles.push_back(segmentFileName(IndexFileNames::FIELD_INFOS_EXTENSION));
@@ -622,13 +628,18 @@ void DocumentsWriter::writeSegment(std::vector<std::wstring>& flushedFiles) {
     flushedFiles.push_back(segmentFileName(IndexFileNames::NORMS_EXTENSION));
   }
 
+  if (docValuesWriter->hasValues()) {
+    docValuesWriter->write(directory, segmentName, numDocsInRAM);
+    flushedFiles.push_back(segmentFileName(IndexFileNames::DOC_VALUES_EXTENSION));
+  }
+
   if (infoStream != NULL) {
     const int64_t newSegmentSize = segmentSize(segmentName);
 
-    (*infoStream) << std::wstring(L"  oldRAMSize=") << Misc::toString(numBytesUsed) <<
+    (*infoStream) << std::wstring(L"  oldRAMSize=") << Misc::toString(getRAMUsed()) <<
 				std::wstring(L" newFlushedSize=") << Misc::toString(newSegmentSize) <<
         std::wstring(L" docs/MB=") << Misc::toString((float_t)(numDocsInRAM/(newSegmentSize/1024.0/1024.0))) <<
-        std::wstring(L" new/old=") << Misc::toString((float_t)(100.0*newSegmentSize/numBytesUsed)) << std::wstring(L"%\n");
+        std::wstring(L" new/old=") << Misc::toString((float_t)(100.0*newSegmentSize/getRAMUsed())) << std::wstring(L"%\n");
   }
 
   resetPostingsData();
@@ -679,9 +690,7 @@ int32_t pos2=0;
 
 
 void DocumentsWriter::appendPostings(ArrayBase<ThreadState::FieldData*>* fields,
-                    TermInfosWriter* termsOut,
-                    IndexOutput* freqOut,
-                    IndexOutput* proxOut) {
+                    TermInfosWriter* termsOut) {
 
   const int32_t fieldNumber = (*fields)[0]->fieldInfo->number;
   int32_t numFields = fields->length;
@@ -702,7 +711,6 @@ void DocumentsWriter::appendPostings(ArrayBase<ThreadState::FieldData*>* fields,
   }
   memcpy(mergeStates.values,mergeStatesData.values,sizeof(FieldMergeState*) * numFields);
 
-  const int32_t skipInterval = termsOut->skipInterval;
   currentFieldStorePayloads = (*fields)[0]->fieldInfo->storePayloads;
 
   ValueArray<FieldMergeState*> termStates(numFields);
@@ -726,8 +734,6 @@ void DocumentsWriter::appendPostings(ArrayBase<ThreadState::FieldData*>* fields,
     }
 
     int32_t df = 0;
-    int32_t lastPayloadLength = -1;
-
     int32_t lastDoc = 0;
 
     const wchar_t* start = termStates[0]->text + termStates[0]->textOffset;
@@ -735,20 +741,14 @@ void DocumentsWriter::appendPostings(ArrayBase<ThreadState::FieldData*>* fields,
     while(*pos != CLUCENE_END_OF_WORD)
       pos++;
 
-    int64_t freqPointer = freqOut->getFilePointer();
-    int64_t proxPointer = proxOut->getFilePointer();
-
-    skipListWriter->resetSkip();
+    postingsWriter->startTerm(currentFieldStorePayloads);
 
     // Now termStates has numToMerge FieldMergeStates
     // which all share the same term.  Now we must
     // interleave the docID streams.
     while(numToMerge > 0) {
 
-      if ((++df % skipInterval) == 0) {
-        skipListWriter->setSkipData(lastDoc, currentFieldStorePayloads, lastPayloadLength);
-        skipListWriter->bufferSkip(df);
-      }
+      df++;
 
       FieldMergeState* minState = termStates[0];
       for(int32_t i=1;i<numToMerge;i++)
@@ -761,42 +761,28 @@ void DocumentsWriter::appendPostings(ArrayBase<ThreadState::FieldData*>* fields,
       assert (doc < numDocsInRAM);
       assert ( doc > lastDoc || df == 1 );
 
-      const int32_t newDocCode = (doc-lastDoc)<<1;
       lastDoc = doc;
+      postingsWriter->startDoc(doc, termDocFreq);
 
       ByteSliceReader& prox = minState->prox;
 
       // Carefully copy over the prox + payload info,
-      // changing the format to match Lucene's segment
-      // format.
+      // decoding the position deltas and payloads the
+      // thread states buffered.
+      int32_t position = 0;
       for(int32_t j=0;j<termDocFreq;j++) {
         const int32_t code = prox.readVInt();
-        if (currentFieldStorePayloads) {
-          int32_t payloadLength;
-          if ((code & 1) != 0) {
-            // This position has a payload
-            payloadLength = prox.readVInt();
-          } else
-            payloadLength = 0;
-          if (payloadLength != lastPayloadLength) {
-            proxOut->writeVInt(code|1);
-            proxOut->writeVInt(payloadLength);
-            lastPayloadLength = payloadLength;
-          } else
-            proxOut->writeVInt(code & (~1));
-          if (payloadLength > 0)
-            copyBytes(&prox, proxOut, payloadLength);
-        } else {
-          assert ( 0 == (code & 1) );
-          proxOut->writeVInt(code>>1);
+        position += code>>1;
+        int32_t payloadLength = 0;
+        if ((code & 1) != 0) {
+          // This position has a payload
+          assert ( currentFieldStorePayloads );
+          payloadLength = prox.readVInt();
+          if (payloadBuffer.length < (size_t)payloadLength)
+            payloadBuffer.resize(payloadLength);
+          prox.readBytes(payloadBuffer.values, payloadLength);
         }
-      }
-
-      if (1 == termDocFreq) {
-        freqOut->writeVInt(newDocCode|1);
-      } else {
-        freqOut->writeVInt(newDocCode);
-        freqOut->writeVInt(termDocFreq);
+        postingsWriter->addPosition(position, payloadBuffer.values, payloadLength);
       }
 
       if (!minState->nextDoc()) {
@@ -829,10 +815,8 @@ void DocumentsWriter::appendPostings(ArrayBase<ThreadState::FieldData*>* fields,
 
     // Done merging this term
 
-    int64_t skipPointer = skipListWriter->writeSkip(freqOut);
-
     // Write term
-    termInfo.set(df, freqPointer, proxPointer, (int32_t) (skipPointer - freqPointer));
+    postingsWriter->finishTerm(&termInfo);
     termsOut->add(fieldNumber, start, pos-start, &termInfo);
   }
 }
@@ -1005,7 +989,7 @@ void DocumentsWriter::clearBufferedDeletes() {
   }
   bufferedDeleteDocIDs.clear();
   numBufferedDeleteTerms = 0;
-  if (numBytesUsed > 0)
+  if (getRAMUsed() > 0)
     resetPostingsData();
 }
 
@@ -1059,12 +1043,8 @@ void DocumentsWriter::addDeleteTerm(Term* term, int32_t docCount) {
   if (num == NULL) {
     bufferedDeleteTerms->put(_CL_POINTER(term), new Num(docCount));
     // This is coarse approximation of actual bytes used:
-    numBytesUsed += ( wcslen(term->field()) + term->textLength()) * BYTES_PER_CHAR
-        + 4 + 5 * OBJECT_HEADER_BYTES + 5 * OBJECT_POINTER_BYTES;
-    if (ramBufferSize != IndexWriter::DISABLE_AUTO_FLUSH
-        && numBytesUsed > ramBufferSize) {
-      bufferIsFull = true;
-    }
+    addBytesUsed(( wcslen(term->field()) + term->textLength()) * BYTES_PER_CHAR
+        + 4 + 5 * OBJECT_HEADER_BYTES + 5 * OBJECT_POINTER_BYTES);
   } else {
     num->setNum(docCount);
   }
@@ -1074,7 +1054,7 @@ void DocumentsWriter::addDeleteTerm(Term* term, int32_t docCount) {
 void DocumentsWriter::addDeleteDocID(int32_t docId) {
 	SCOPED_LOCK_MUTEX(THIS_LOCK)
   bufferedDeleteDocIDs.push_back(docId);
-  numBytesUsed += OBJECT_HEADER_BYTES + BYTES_PER_INT + OBJECT_POINTER_BYTES;
+  _LUCENE_ATOMIC_ADD64(&numBytesUsed, OBJECT_HEADER_BYTES + BYTES_PER_INT + OBJECT_POINTER_BYTES);
 }
 
 void DocumentsWriter::finishDocument(ThreadState* state) {
@@ -1134,7 +1114,15 @@ void DocumentsWriter::finishDocument(ThreadState* state) {
 }
 
 int64_t DocumentsWriter::getRAMUsed() {
-  return numBytesUsed;
+  return _LUCENE_ATOMIC_GET64(&numBytesUsed);
+}
+
+void DocumentsWriter::addBytesUsed(int64_t bytes) {
+  const int64_t used = _LUCENE_ATOMIC_ADD64(&numBytesUsed, bytes);
+  if (ramBufferSize != IndexWriter::DISABLE_AUTO_FLUSH && used > ramBufferSize) {
+    SCOPED_LOCK_MUTEX(THIS_LOCK)
+    bufferIsFull = true;
+  }
 }
 
 void DocumentsWriter::fillBytes(IndexOutput* out, uint8_t b, int32_t numBytes) {
@@ -1142,23 +1130,6 @@ void DocumentsWriter::fillBytes(IndexOutput* out, uint8_t b, int32_t numBytes) {
     out->writeByte(b);
 }
 
-void DocumentsWriter::copyBytes(IndexInput* srcIn, IndexOutput* destIn, int64_t numBytes) {
-  // TODO: we could do this more efficiently (save a copy)
-  // because it's always from a ByteSliceReader ->
-  // IndexOutput
-  while(numBytes > 0) {
-    int32_t chunk;
-    if (numBytes > 4096)
-      chunk = 4096;
-    else
-      chunk = (int32_t) numBytes;
-    srcIn->readBytes(copyByteBuffer, chunk);
-    destIn->writeBytes(copyByteBuffer, chunk);
-    numBytes -= chunk;
-  }
-}
-
-
 int64_t DocumentsWriter::segmentSize(const std::wstring& segmentName) {
   assert (infoStream != NULL);
 
@@ -1176,7 +1147,7 @@ int64_t DocumentsWriter::segmentSize(const std::wstring& segmentName) {
 
 void DocumentsWriter::getPostings(ValueArray<Posting*>& postings) {
 	SCOPED_LOCK_MUTEX(THIS_LOCK)
-  numBytesUsed += postings.length * POSTING_NUM_BYTE;
+  _LUCENE_ATOMIC_ADD64(&numBytesUsed, postings.length * POSTING_NUM_BYTE);
   int32_t numToCopy;
   if (this->postingsFreeCountDW < postings.length)
     numToCopy = this->postingsFreeCountDW;
@@ -1226,11 +1197,11 @@ uint8_t* DocumentsWriter::getByteBlock(bool trackAllocations) {
     b = _CL_NEWARRAY(uint8_t, BYTE_BLOCK_SIZE);
     memset(b,0,sizeof(uint8_t) * BYTE_BLOCK_SIZE);
   } else {
-    b = *freeByteBlocks.begin();
-    freeByteBlocks.remove(freeByteBlocks.begin(),true);
+    b = freeByteBlocks.back();
+    freeByteBlocks.pop_back();
   }
   if (trackAllocations)
-    numBytesUsed += BYTE_BLOCK_SIZE;
+    _LUCENE_ATOMIC_ADD64(&numBytesUsed, BYTE_BLOCK_SIZE);
   return b;
 }
 
@@ -1253,10 +1224,10 @@ wchar_t* DocumentsWriter::gewchar_tBlock() {
     c = _CL_NEWARRAY(wchar_t, CHAR_BLOCK_SIZE);
     memset(c,0,sizeof(wchar_t) * CHAR_BLOCK_SIZE);
   } else{
-    c = *freeCharBlocks.begin();
-    freeCharBlocks.remove(freeCharBlocks.begin(),true);
+    c = freeCharBlocks.back();
+    freeCharBlocks.pop_back();
   }
-  numBytesUsed += CHAR_BLOCK_SIZE * CHAR_NUM_BYTE;
+  _LUCENE_ATOMIC_ADD64(&numBytesUsed, CHAR_BLOCK_SIZE * CHAR_NUM_BYTE);
   return c;
 }
 
@@ -1269,6 +1240,28 @@ void DocumentsWriter::recycleBlocks(ArrayBase<wchar_t*>& blocks, int32_t start,
   }
 }
 
+int64_t DocumentsWriter::threadBlocksFree() {
+	SCOPED_LOCK_MUTEX(THIS_LOCK)
+  int64_t bytes = 0;
+  for(size_t i=0;i<threadStates.length;i++) {
+    if (threadStates[i]->isIdle)
+      bytes += threadStates[i]->freeBlockBytes();
+  }
+  return bytes;
+}
+
+int64_t DocumentsWriter::reclaimIdleBlocks() {
+	SCOPED_LOCK_MUTEX(THIS_LOCK)
+  // A ThreadState only becomes busy under THIS_LOCK, so the
+  // free blocks of an idle one are safe to take
+  const int64_t bytes = threadBlocksFree();
+  for(size_t i=0;i<threadStates.length;i++) {
+    if (threadStates[i]->isIdle)
+      threadStates[i]->trimBlocks(0);
+  }
+  return bytes;
+}
+
 std::wstring DocumentsWriter::toMB(int64_t v) {
   wchar_t buf[40];
   swprintf_s(buf,40, L"%0.2f", v/1024.0/1024.0);
@@ -1291,13 +1284,14 @@ void DocumentsWriter::balanceRAM() {
 
   if (numBytesAlloc > freeTrigger) {
     if (infoStream != NULL)
-      (*infoStream) << std::wstring(L"  RAM: now balance allocations: usedMB=") << toMB(numBytesUsed) +
+      (*infoStream) << std::wstring(L"  RAM: now balance allocations: usedMB=") << toMB(getRAMUsed()) +
                          std::wstring(L" vs trigger=") << toMB(flushTrigger) <<
                          std::wstring(L" allocMB=") << toMB(numBytesAlloc) <<
                          std::wstring(L" vs trigger=") << toMB(freeTrigger) <<
                          std::wstring(L" postingsFree=") << toMB(this->postingsFreeCountDW*POSTING_NUM_BYTE) <<
                          std::wstring(L" byteBlockFree=") << toMB(freeByteBlocks.size()*BYTE_BLOCK_SIZE) <<
-                         std::wstring(L" charBlockFree=") << toMB(freeCharBlocks.size()*CHAR_BLOCK_SIZE*CHAR_NUM_BYTE) << std::wstring(L"\n");
+                         std::wstring(L" charBlockFree=") << toMB(freeCharBlocks.size()*CHAR_BLOCK_SIZE*CHAR_NUM_BYTE) <<
+                         std::wstring(L" threadBlockFree=") << toMB(threadBlocksFree()) << std::wstring(L"\n");
 
     // When we've crossed 100% of our target Postings
     // RAM usage, try to free up until we're back down
@@ -1313,7 +1307,8 @@ void DocumentsWriter::balanceRAM() {
     // (freeLevel)
 
     while(numBytesAlloc > freeLevel) {
-      if (0 == freeByteBlocks.size() && 0 == freeCharBlocks.size() && 0 == this->postingsFreeCountDW) {
+      if (0 == freeByteBlocks.size() && 0 == freeCharBlocks.size() && 0 == this->postingsFreeCountDW
+          && 0 == reclaimIdleBlocks()) {
         // Nothing else to free -- must flush now.
         bufferIsFull = true;
         if (infoStream != NULL)
@@ -1350,7 +1345,7 @@ void DocumentsWriter::balanceRAM() {
 
     if (infoStream != NULL){
       (*infoStream) << L"    after free: freedMB=" + Misc::toString((float_t)((startBytesAlloc-numBytesAlloc)/1024.0/1024.0)) +
-        L" usedMB=" + Misc::toString((float_t)(numBytesUsed/1024.0/1024.0)) +
+        L" usedMB=" + Misc::toString((float_t)(getRAMUsed()/1024.0/1024.0)) +
         L" allocMB=" + Misc::toString((float_t)(numBytesAlloc/1024.0/1024.0)) << std::wstring(L"\n");
     }
 
@@ -1360,9 +1355,9 @@ void DocumentsWriter::balanceRAM() {
     // using, go ahead and flush.  This prevents
     // over-allocating and then freeing, with every
     // flush.
-    if (numBytesUsed > flushTrigger) {
+    if (getRAMUsed() > flushTrigger) {
 	    if (infoStream != NULL){
-        (*infoStream) << std::wstring(L"  RAM: now flush @ usedMB=") << Misc::toString((float_t)(numBytesUsed/1024.0/1024.0)) <<
+        (*infoStream) << std::wstring(L"  RAM: now flush @ usedMB=") << Misc::toString((float_t)(getRAMUsed()/1024.0/1024.0)) <<
             std::wstring(L" allocMB=") << Misc::toString((float_t)(numBytesAlloc/1024.0/1024.0)) <<
             std::wstring(L" triggerMB=") << Misc::toString((float_t)(flushTrigger/1024.0/1024.0)) << std::wstring(L"\n");
 	    }
@@ -1579,8 +1574,9 @@ int64_t DocumentsWriter::ByteSliceReader::length() const{_CLTHROWA(CL_ERR_Runtim
 void DocumentsWriter::ByteSliceReader::seek(const int64_t /*pos*/) {_CLTHROWA(CL_ERR_Runtime,"not implemented");}
 void DocumentsWriter::ByteSliceReader::close() {_CLTHROWA(CL_ERR_Runtime,"not implemented");}
 
-DocumentsWriter::ByteBlockPool::ByteBlockPool( bool _trackAllocations, DocumentsWriter* _parent):
-  BlockPool<uint8_t>(_parent, BYTE_BLOCK_SIZE, _trackAllocations)
+DocumentsWriter::ByteBlockPool::ByteBlockPool( bool _trackAllocations, DocumentsWriter* _parent, ThreadState* _threadState):
+  BlockPool<uint8_t>(_parent, BYTE_BLOCK_SIZE, _trackAllocations),
+  threadState(_threadState)
 {
 }
 DocumentsWriter::ByteBlockPool::~ByteBlockPool(){
@@ -1589,7 +1585,7 @@ DocumentsWriter::ByteBlockPool::~ByteBlockPool(){
   _CLDELETE_ARRAY(buffer);
 }
 uint8_t* DocumentsWriter::ByteBlockPool::getNewBlock(bool _trackAllocations){
-  return parent->getByteBlock(_trackAllocations);
+  return threadState->getByteBlock(_trackAllocations);
 }
 int32_t DocumentsWriter::ByteBlockPool::newSlice(const int32_t size) {
   if (tUpto > BYTE_BLOCK_SIZE-size)
@@ -1644,7 +1640,7 @@ void DocumentsWriter::ByteBlockPool::reset() {
 
     if (bufferUpto > 0)
       // Recycle all but the first buffer
-      parent->recycleBlocks(buffers, 1, 1+bufferUpto);
+      threadState->recycleBlocks(buffers, 1, 1+bufferUpto);
 
     // Re-use the first buffer
     bufferUpto = 0;
@@ -1653,17 +1649,18 @@ void DocumentsWriter::ByteBlockPool::reset() {
     buffer = buffers[0];
   }
 }
-DocumentsWriter::CharBlockPool::CharBlockPool(DocumentsWriter* _parent):
-    BlockPool<wchar_t>(_parent, CHAR_BLOCK_SIZE, false)
+DocumentsWriter::CharBlockPool::CharBlockPool(DocumentsWriter* _parent, ThreadState* _threadState):
+    BlockPool<wchar_t>(_parent, CHAR_BLOCK_SIZE, false),
+    threadState(_threadState)
 {
 }
 DocumentsWriter::CharBlockPool::~CharBlockPool(){
 }
 wchar_t* DocumentsWriter::CharBlockPool::getNewBlock(bool){
-    return parent->gewchar_tBlock();
+    return threadState->getCharBlock();
 }
 void DocumentsWriter::CharBlockPool::reset() {
-  parent->recycleBlocks(buffers, 0, 1+bufferUpto);
+  threadState->recycleBlocks(buffers, 0, 1+bufferUpto);
   bufferUpto = -1;
   tUpto = blockSize;
   tOffset = -blockSize;
@@ -33,6 +33,7 @@
 #include "_TermInfosWriter.h"
 #include "_FieldsWriter.h"
 #include "_DocumentsWriter.h"
+#include "_DocValues.h"
 #include <assert.h>
 #include <iostream>
 
@@ -51,9 +52,11 @@ DocumentsWriter::ThreadState::ThreadState(DocumentsWriter* __parent):
   fieldDataArray(ValueArray<FieldData*>(8)),
   fieldDataHash(ValueArray<FieldData*>(16)),
   postingsVectors(ObjectArray<PostingVector>(1)),
-  postingsPool( _CLNEW ByteBlockPool(true, __parent) ),
-  vectorsPool( _CLNEW ByteBlockPool(false, __parent) ),
-  charPool( _CLNEW CharBlockPool(__parent) ),
+  postingsPool( _CLNEW ByteBlockPool(true, __parent, this) ),
+  vectorsPool( _CLNEW ByteBlockPool(false, __parent, this) ),
+  charPool( _CLNEW CharBlockPool(__parent, this) ),
+  freeByteBlocksTS(FreeByteBlocksType(true)),
+  freeCharBlocksTS(FreeCharBlocksType(true)),
   allFieldDataArray(ValueArray<FieldData*>(10)),
   _parent(__parent)
 {
@@ -114,6 +117,65 @@ void DocumentsWriter::ThreadState::resetPostings() {
   }
 }
 
+uint8_t* DocumentsWriter::ThreadState::getByteBlock(bool trackAllocations) {
+  if (freeByteBlocksTS.size() == 0)
+    return _parent->getByteBlock(trackAllocations);
+
+  uint8_t* b = freeByteBlocksTS.back();
+  freeByteBlocksTS.pop_back();
+  if (trackAllocations)
+    _parent->addBytesUsed(BYTE_BLOCK_SIZE);
+  return b;
+}
+
+wchar_t* DocumentsWriter::ThreadState::getCharBlock() {
+  if (freeCharBlocksTS.size() == 0)
+    return _parent->gewchar_tBlock();
+
+  wchar_t* c = freeCharBlocksTS.back();
+  freeCharBlocksTS.pop_back();
+  _parent->addBytesUsed(CHAR_BLOCK_SIZE * CHAR_NUM_BYTE);
+  return c;
+}
+
+void DocumentsWriter::ThreadState::recycleBlocks(ArrayBase<uint8_t*>& blocks, int32_t start, int32_t end) {
+  for(int32_t i=start;i<end;i++){
+    freeByteBlocksTS.push_back(blocks[i]);
+    blocks.values[i] = NULL;
+  }
+}
+
+void DocumentsWriter::ThreadState::recycleBlocks(ArrayBase<wchar_t*>& blocks, int32_t start, int32_t numBlocks) {
+  for(int32_t i=start;i<numBlocks;i++){
+    freeCharBlocksTS.push_back(blocks[i]);
+    blocks.values[i] = NULL;
+  }
+}
+
+int64_t DocumentsWriter::ThreadState::freeBlockBytes() const {
+  return (int64_t)freeByteBlocksTS.size() * BYTE_BLOCK_SIZE
+    + (int64_t)freeCharBlocksTS.size() * CHAR_BLOCK_SIZE * CHAR_NUM_BYTE;
+}
+
+void DocumentsWriter::ThreadState::trimBlocks(int64_t maxBytes) {
+  if (maxBytes < 0)
+    return;
+
+  // Give back char blocks first, and keep byte blocks, which
+  // postings need far more of
+  int64_t bytes = freeBlockBytes();
+  while (bytes > maxBytes && freeCharBlocksTS.size() > 0) {
+    _parent->freeCharBlocks.push_back(freeCharBlocksTS.back());
+    freeCharBlocksTS.pop_back();
+    bytes -= CHAR_BLOCK_SIZE * CHAR_NUM_BYTE;
+  }
+  while (bytes > maxBytes && freeByteBlocksTS.size() > 0) {
+    _parent->freeByteBlocks.push_back(freeByteBlocksTS.back());
+    freeByteBlocksTS.pop_back();
+    bytes -= BYTE_BLOCK_SIZE;
+  }
+}
+
 void DocumentsWriter::ThreadState::writeDocument() {
 
   // If we hit an exception while appending to the
@@ -166,9 +228,12 @@ void DocumentsWriter::ThreadState::writeDocument() {
     throw AbortException(t, _parent);
   }
 
-  if (_parent->bufferIsFull && !_parent->flushPending) {
-    _parent->flushPending = true;
-    doFlushAfter = true;
+  {
+    SCOPED_LOCK_MUTEX(_parent->THIS_LOCK)
+    if (_parent->bufferIsFull && !_parent->flushPending) {
+      _parent->flushPending = true;
+      doFlushAfter = true;
+    }
   }
 }
 
@@ -205,6 +270,8 @@ void DocumentsWriter::ThreadState::init(Document* doc, int32_t docID) {
     FieldInfo* fi = _parent->fieldInfos->add(field->name(), field->isIndexed(), field->isTermVectorStored(),
                                   field->isStorePositionWithTermVector(), field->isStoreOffsetWithTermVector(),
                                   field->getOmitNorms(), false);
+    fi->setDocValuesType(field->isNumericDocValues() ? FieldInfos::DOC_VALUES_NUMERIC :
+                         field->isSortedDocValues() ? FieldInfos::DOC_VALUES_SORTED : 0);
     if (fi->isIndexed && !fi->omitNorms) {
       // Maybe grow our buffered norms
       if (_parent->norms.length <= fi->number) {
@@ -293,6 +360,10 @@ void DocumentsWriter::ThreadState::init(Document* doc, int32_t docID) {
     fp->docFields.values[fp->fieldCount++] = field;
   }
 
+  // Doc values are buffered right away (we hold the
+  // DocumentsWriter's lock here), they are not inverted:
+  _parent->docValuesWriter->addDocument(_parent->fieldInfos, doc, docID);
+
   // Maybe init the local & global fieldsWriter
   if (localFieldsWriter == NULL) {
     if (_parent->fieldsWriter == NULL) {
@@ -304,7 +375,8 @@ void DocumentsWriter::ThreadState::init(Document* doc, int32_t docID) {
       // because those files will be in an unknown
       // state:
       try {
-        _parent->fieldsWriter = _CLNEW FieldsWriter(_parent->directory, _parent->docStoreSegment.c_str(), _parent->fieldInfos);
+        _parent->fieldsWriter = _CLNEW FieldsWriter(_parent->directory, _parent->docStoreSegment.c_str(), _parent->fieldInfos,
+                                                    _parent->writer->getStoredFieldsCompression());
       } catch (CLuceneError& t) {
         throw AbortException(t,_parent);
       }
@@ -562,7 +634,7 @@ void DocumentsWriter::ThreadState::processDocument(Analyzer* analyzer)
     (*_parent->infoStream) << "WARNING: document contains at least one immense term (longer than the max length " << MAX_TERM_LENGTH << "), all of which were skipped.  Please correct the analyzer to not produce such terms.  The prefix of the first immense term is: '" << maxTermPrefix << "...'\n";
 
   if (_parent->ramBufferSize != IndexWriter::DISABLE_AUTO_FLUSH
-      && _parent->numBytesUsed > 0.95 * _parent->ramBufferSize)
+      && _parent->getRAMUsed() > 0.95 * _parent->ramBufferSize)
     _parent->balanceRAM();
 }
 
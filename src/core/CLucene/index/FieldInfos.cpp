@@ -38,7 +38,8 @@ FieldInfo::FieldInfo(	const wchar_t* _fieldName,
 	storeTermVector(_storeTermVector),
 	storeOffsetWithTermVector(_storeOffsetWithTermVector),
 	storePositionWithTermVector(_storePositionWithTermVector),
-	omitNorms(_omitNorms), storePayloads(_storePayloads)
+	omitNorms(_omitNorms), storePayloads(_storePayloads),
+	docValuesType(0)
 {
 }
 
@@ -47,8 +48,18 @@ FieldInfo::~FieldInfo(){
 }
 
 FieldInfo* FieldInfo::clone() {
-	return _CLNEW FieldInfo(name, isIndexed, number, storeTermVector, storePositionWithTermVector,
+	FieldInfo* ret = _CLNEW FieldInfo(name, isIndexed, number, storeTermVector, storePositionWithTermVector,
 		storeOffsetWithTermVector, omitNorms, storePayloads);
+	ret->docValuesType = docValuesType;
+	return ret;
+}
+
+void FieldInfo::setDocValuesType(const uint8_t type) {
+	if ( type == 0 || type == docValuesType )
+		return;
+	if ( docValuesType != 0 )
+		_CLTHROWA(CL_ERR_IllegalArgument, "a field cannot have both numeric and sorted doc values");
+	docValuesType = type;
 }
 
 FieldInfos::FieldInfos():
@@ -89,8 +100,10 @@ void FieldInfos::add(const Document* doc) {
 	Field* field;
   for ( Document::FieldsType::const_iterator itr = fields.begin() ; itr != fields.end() ; itr++ ){
 			field = *itr;
-			add(field->name(), field->isIndexed(), field->isTermVectorStored(), field->isStorePositionWithTermVector(),
+			FieldInfo* fi = add(field->name(), field->isIndexed(), field->isTermVectorStored(), field->isStorePositionWithTermVector(),
               field->isStoreOffsetWithTermVector(), field->getOmitNorms());
+			fi->setDocValuesType(field->isNumericDocValues() ? DOC_VALUES_NUMERIC :
+				field->isSortedDocValues() ? DOC_VALUES_SORTED : 0);
 	}
 }
 
@@ -189,6 +202,14 @@ bool FieldInfos::hasVectors() const{
 	return false;
 }
 
+bool FieldInfos::hasDocValues() const{
+	for (size_t i = 0; i < size(); i++) {
+	   if (fieldInfo(i)->docValuesType != 0)
+	      return true;
+	}
+	return false;
+}
+
 void FieldInfos::write(Directory* d, const wchar_t * name) const{
 	IndexOutput* output = d->createOutput(name);
 	try {
@@ -200,6 +221,9 @@ void FieldInfos::write(Directory* d, const wchar_t * name) const{
 }
 
 void FieldInfos::write(IndexOutput* output) const{
+	const bool docValues = hasDocValues();
+	if ( docValues )
+		output->writeVInt(FORMAT_DOC_VALUES);
 	output->writeVInt(static_cast<int32_t>(size()));
 	FieldInfo* fi;
 	uint8_t bits;
@@ -215,11 +239,19 @@ void FieldInfos::write(IndexOutput* output) const{
 
 	    output->writeString(fi->name,wcslen(fi->name));
 	    output->writeByte(bits);
+		if ( docValues )
+			output->writeByte(fi->docValuesType);
 	}
 }
 
 void FieldInfos::read(IndexInput* input) {
 	int32_t size = input->readVInt();//read in the size
+	const int32_t format = size < 0 ? size : 0;
+	if ( format != 0 ){
+		if ( format != FORMAT_DOC_VALUES )
+			_CLTHROWA(CL_ERR_CorruptIndex, "Unknown field infos format");
+		size = input->readVInt();
+	}
     uint8_t bits;
 	bool isIndexed,storeTermVector,storePositionsWithTermVector,storeOffsetWithTermVector,omitNorms,storePayloads;
 	for (int32_t i = 0; i < size; ++i){
@@ -232,7 +264,9 @@ void FieldInfos::read(IndexInput* input) {
    		omitNorms = (bits & OMIT_NORMS) != 0;
 		storePayloads = (bits & STORE_PAYLOADS) != 0;
    
-   		addInternal(name, isIndexed, storeTermVector, storePositionsWithTermVector, storeOffsetWithTermVector, omitNorms, storePayloads);
+   		FieldInfo* fi = addInternal(name, isIndexed, storeTermVector, storePositionsWithTermVector, storeOffsetWithTermVector, omitNorms, storePayloads);
+		if ( format == FORMAT_DOC_VALUES )
+			fi->docValuesType = input->readByte();
    		_CLDELETE_CARRAY(name);
 	}
 }
@@ -12,9 +12,11 @@
 #include "CLucene/util/Misc.h"
 #include "CLucene/util/_StringIntern.h"
 #include "CLucene/util/CLStreams.h"
+#include "CLucene/util/_LZ4.h"
 #include "CLucene/store/Directory.h"
 #include "CLucene/store/IndexInput.h"
 #include "CLucene/document/Document.h"
+#include "CLucene/document/StoredFieldVisitor.h"
 #include "CLucene/document/FieldSelector.h"
 #include "_FieldInfos.h"
 #include "_FieldsWriter.h"
@@ -27,9 +29,99 @@ CL_NS_USE(document)
 CL_NS_USE(util)
 CL_NS_DEF(index)
 
+/** Reads the document at hand out of a decompressed block. */
+class FieldsReader::BlockInput: public IndexInput {
+private:
+	const uint8_t* data;
+	int32_t pos;
+	int32_t _length;
+
+	BlockInput(const BlockInput& other):
+		IndexInput(other),
+		data(other.data),
+		pos(other.pos),
+		_length(other._length)
+	{
+	}
+public:
+	BlockInput():
+		data(NULL),
+		pos(0),
+		_length(0)
+	{
+	}
+	virtual ~BlockInput(){
+	}
+
+	void reset(const uint8_t* _data, const int32_t len){
+		data = _data;
+		_length = len;
+		pos = 0;
+	}
+
+	uint8_t readByte(){
+		if ( pos >= _length )
+			_CLTHROWA(CL_ERR_IO, "read past end of stored fields block");
+		return data[pos++];
+	}
+	void readBytes(uint8_t* b, const int32_t len){
+		if ( len > _length - pos )
+			_CLTHROWA(CL_ERR_IO, "read past end of stored fields block");
+		memcpy(b, data + pos, len);
+		pos += len;
+	}
+	int64_t getFilePointer() const{
+		return pos;
+	}
+	void seek(const int64_t _pos){
+		if ( _pos < 0 || _pos > _length )
+			_CLTHROWA(CL_ERR_IO, "seek past end of stored fields block");
+		pos = (int32_t)_pos;
+	}
+	int64_t length() const{
+		return _length;
+	}
+	void close(){
+		reset(NULL, 0);
+	}
+	const uint8_t* bufferedBytes(int32_t& length){
+		length = _length - pos;
+		return length > 0 ? data + pos : NULL;
+	}
+	void consumeBufferedBytes(const int32_t len){
+		CND_PRECONDITION(len >= 0 && pos + len <= _length, "consuming more than was buffered");
+		pos += len;
+	}
+	IndexInput* clone() const{
+		return _CLNEW BlockInput(*this);
+	}
+
+	const std::wstring getDirectoryType() const{ return L"BLOCK"; }
+	const std::wstring getObjectName() const{ return getClassName(); }
+	static const std::wstring getClassName(){ return L"FieldsReader::BlockInput"; }
+};
+
+struct FieldsReader::Block {
+	int64_t pointer;  // of the block in the .fdt, -1 if this entry is empty
+	int32_t firstDoc;
+	int32_t numDocs;
+	ValueArray<int32_t> offsets; // where each document starts in data, and where the last ends
+	ValueArray<uint8_t> data;    // may be longer than the block
+	int64_t lastUse;
+
+	Block():
+		pointer(-1),
+		firstDoc(0),
+		numDocs(0),
+		lastUse(0)
+	{
+	}
+};
+
 FieldsReader::FieldsReader(Directory* d, const wchar_t * segment, FieldInfos* fn, int32_t _readBufferSize, int32_t _docStoreOffset, int32_t size):
 	fieldInfos(fn), cloneableFieldsStream(NULL), fieldsStream(NULL), indexStream(NULL),
-        numTotalDocs(0),_size(0), closed(false),docStoreOffset(0)
+        numTotalDocs(0),_size(0), closed(false),docStoreOffset(0),
+	compressedBlocks(false), indexHeaderLength(0), blocksStream(NULL), blockCache(NULL), blockCacheUse(0)
 {
 //Func - Constructor
 //Pre  - d contains a valid reference to a Directory
@@ -47,6 +139,17 @@ FieldsReader::FieldsReader(Directory* d, const wchar_t * segment, FieldInfos* fn
 
 		indexStream = d->openInput( Misc::segmentname(segment,L".fdx").c_str(), _readBufferSize );
 
+		if (indexStream->length() >= 4 && indexStream->readInt() == FieldsWriter::FORMAT_BLOCKS) {
+			compressedBlocks = true;
+			indexHeaderLength = 4;
+			blocksStream = fieldsStream;
+			fieldsStream = _CLNEW BlockInput();
+			blockCache = _CL_NEWARRAY(Block*, LUCENE_STORED_FIELDS_BLOCK_CACHE);
+			for (int32_t i = 0; i < LUCENE_STORED_FIELDS_BLOCK_CACHE; i++)
+				blockCache[i] = _CLNEW Block();
+		}
+		const int32_t indexDocs = (int32_t) ((indexStream->length() - indexHeaderLength) >> 3);
+
 		if (_docStoreOffset != -1) {
 			// We read only a slice out of this shared fields file
 			this->docStoreOffset = _docStoreOffset;
@@ -54,16 +157,14 @@ FieldsReader::FieldsReader(Directory* d, const wchar_t * segment, FieldInfos* fn
 
 			// Verify the file is long enough to hold all of our
 			// docs
-			CND_CONDITION(((int32_t) (indexStream->length() / 8)) >= size + this->docStoreOffset,
+			CND_CONDITION(indexDocs >= size + this->docStoreOffset,
 				L"the file is not long enough to hold all of our docs");
 		} else {
 			this->docStoreOffset = 0;
-			this->_size = (int32_t) (indexStream->length() >> 3);
+			this->_size = indexDocs;
 		}
 
-		//_size = (int32_t)indexStream->length()/8;
-
-		numTotalDocs = (int32_t) (indexStream->length() >> 3);
+		numTotalDocs = indexDocs;
 		success = true;
 	} _CLFINALLY ({
 		// With lock-less commits, it's entirely possible (and
@@ -91,6 +192,17 @@ void FieldsReader::ensureOpen() {
 	}
 }
 
+void FieldsReader::setAccessPattern(IndexInput::AccessPattern pattern) {
+	if (cloneableFieldsStream != NULL)
+		cloneableFieldsStream->setAccessPattern(pattern);
+	if (fieldsStream != NULL)
+		fieldsStream->setAccessPattern(pattern);
+	if (blocksStream != NULL)
+		blocksStream->setAccessPattern(pattern);
+	if (indexStream != NULL)
+		indexStream->setAccessPattern(pattern);
+}
+
 void FieldsReader::close() {
 	if (!closed) {
 		if (fieldsStream){
@@ -105,6 +217,15 @@ void FieldsReader::close() {
 			indexStream->close();
 			_CLDELETE(indexStream);
 		}
+		if (blocksStream){
+			blocksStream->close();
+			_CLDELETE(blocksStream);
+		}
+		if (blockCache){
+			for (int32_t i = 0; i < LUCENE_STORED_FIELDS_BLOCK_CACHE; i++)
+				_CLDELETE(blockCache[i]);
+			_CLDELETE_ARRAY(blockCache);
+		}
 		/*
 		CL_NS(store)::IndexInput* localFieldsStream = fieldsStreamTL.get();
 		if (localFieldsStream != NULL) {
@@ -119,12 +240,26 @@ int32_t FieldsReader::size() const{
 	return _size;
 }
 
-bool FieldsReader::doc(int32_t n, Document& doc, const CL_NS(document)::FieldSelector* fieldSelector) {
-  if ( (n + docStoreOffset) * 8L > indexStream->length() )
+bool FieldsReader::seekDocument(int32_t n) {
+  if ( indexHeaderLength + (n + docStoreOffset) * 8L > indexStream->length() )
       return false;
-	indexStream->seek((n + docStoreOffset) * 8L);
+	indexStream->seek(indexHeaderLength + (n + docStoreOffset) * 8L);
 	int64_t position = indexStream->readLong();
-	fieldsStream->seek(position);
+	if (compressedBlocks) {
+		const Block* block = loadBlock(position);
+		const int32_t i = n + docStoreOffset - block->firstDoc;
+		if (i < 0 || i >= block->numDocs)
+			_CLTHROWA(CL_ERR_CorruptIndex, "stored fields block does not hold the document");
+		static_cast<BlockInput*>(fieldsStream)->reset(block->data.values, block->offsets.values[i + 1]);
+		fieldsStream->seek(block->offsets.values[i]);
+	} else
+		fieldsStream->seek(position);
+	return true;
+}
+
+bool FieldsReader::doc(int32_t n, Document& doc, const CL_NS(document)::FieldSelector* fieldSelector) {
+	if (!seekDocument(n))
+		return false;
 
 	int32_t numFields = fieldsStream->readVInt();
 	for (int32_t i = 0; i < numFields; i++) {
@@ -155,7 +290,11 @@ bool FieldsReader::doc(int32_t n, Document& doc, const CL_NS(document)::FieldSel
 			break;//Get out of this loop
 		}
 		else if (acceptField == FieldSelector::LAZY_LOAD) {
-			addFieldLazy(doc, fi, binary, compressed, tokenize);
+			// a lazy field would point into a block that is gone by the time it is loaded
+			if (compressedBlocks)
+				addField(doc, fi, binary, compressed, tokenize);
+			else
+				addFieldLazy(doc, fi, binary, compressed, tokenize);
 		}
 		else if (acceptField == FieldSelector::SIZE){
 			skipField(binary, compressed, addFieldSize(doc, fi, binary, compressed));
@@ -170,7 +309,128 @@ bool FieldsReader::doc(int32_t n, Document& doc, const CL_NS(document)::FieldSel
 	return true;
 }
 
+bool FieldsReader::visitDocument(int32_t n, StoredFieldVisitor& visitor) {
+	if (!seekDocument(n))
+		return false;
+
+	const int32_t numFields = fieldsStream->readVInt();
+	for (int32_t i = 0; i < numFields; i++) {
+		const int32_t fieldNumber = fieldsStream->readVInt();
+		FieldInfo* fi = fieldInfos->fieldInfo(fieldNumber);
+		if ( fi == NULL ) _CLTHROWA(CL_ERR_IO, "Field stream is invalid");
+
+		const uint8_t bits = fieldsStream->readByte();
+		const bool compressed = (bits & FieldsWriter::FIELD_IS_COMPRESSED) != 0;
+		const bool binary = (bits & FieldsWriter::FIELD_IS_BINARY) != 0;
+
+		const StoredFieldVisitor::Status status = visitor.needsField(fi->name);
+		if (status == StoredFieldVisitor::STOP)
+			break;
+		if (status == StoredFieldVisitor::NO) {
+			skipField(binary, compressed);
+			continue;
+		}
+
+		const int32_t toRead = fieldsStream->readVInt();
+		if (compressed) {
+			if ((int32_t)visitBytes.length < toRead)
+				visitBytes.resize(toRead);
+			fieldsStream->readBytes(visitBytes.values, toRead);
+			// inflate works on whole arrays, so this is the one case that allocates
+			ValueArray<uint8_t> b(visitBytes.values, toRead);
+			ValueArray<uint8_t> data;
+			try {
+				uncompress(b, data);
+			} _CLFINALLY( b.takeArray() );
+			const int32_t length = (int32_t)data.length - 1; // uncompress null-terminates
+			if (binary) {
+				visitor.binaryField(fi->name, data.values, length);
+			} else {
+				if ((int32_t)visitChars.length < length + 1)
+					visitChars.resize(length + 1);
+				const int32_t l = (int32_t)lucene_utf8towcs(visitChars.values, (const char*)data.values, length);
+				visitChars.values[l] = 0;
+				visitor.stringField(fi->name, visitChars.values, l);
+			}
+		} else if (binary) {
+			// hand out the bytes straight from the input buffer if they are all there
+			int32_t buffered = 0;
+			const uint8_t* bytes = fieldsStream->bufferedBytes(buffered);
+			if (bytes != NULL && buffered >= toRead) {
+				visitor.binaryField(fi->name, bytes, toRead);
+				fieldsStream->consumeBufferedBytes(toRead);
+			} else {
+				if ((int32_t)visitBytes.length < toRead)
+					visitBytes.resize(toRead);
+				fieldsStream->readBytes(visitBytes.values, toRead);
+				visitor.binaryField(fi->name, visitBytes.values, toRead);
+			}
+		} else {
+			if ((int32_t)visitChars.length < toRead + 1)
+				visitChars.resize(toRead + 1);
+			fieldsStream->readChars(visitChars.values, 0, toRead);
+			visitChars.values[toRead] = 0;
+			visitor.stringField(fi->name, visitChars.values, toRead);
+		}
+	}
+	return true;
+}
+
+const FieldsReader::Block* FieldsReader::loadBlock(const int64_t pointer) {
+	Block* victim = NULL;
+	for (int32_t i = 0; i < LUCENE_STORED_FIELDS_BLOCK_CACHE; i++) {
+		Block* block = blockCache[i];
+		if (block->pointer == pointer) {
+			block->lastUse = ++blockCacheUse;
+			return block;
+		}
+		if (victim == NULL || block->lastUse < victim->lastUse)
+			victim = block;
+	}
+
+	victim->pointer = -1; // until it is read completely
+	blocksStream->seek(pointer);
+	const uint8_t codec = blocksStream->readByte();
+	victim->firstDoc = blocksStream->readVInt();
+	victim->numDocs = blocksStream->readVInt();
+	if ((int32_t)victim->offsets.length < victim->numDocs + 1)
+		victim->offsets.resize(victim->numDocs + 1);
+	victim->offsets.values[0] = 0;
+	for (int32_t i = 0; i < victim->numDocs; i++)
+		victim->offsets.values[i + 1] = victim->offsets.values[i] + blocksStream->readVInt();
+
+	const int32_t length = blocksStream->readVInt();
+	if (length != victim->offsets.values[victim->numDocs])
+		_CLTHROWA(CL_ERR_CorruptIndex, "stored fields block has the wrong length");
+	if ((int32_t)victim->data.length < length)
+		victim->data.resize(length);
+
+	if (codec == FieldsWriter::BLOCK_STORED) {
+		blocksStream->readBytes(victim->data.values, length);
+	} else {
+		ValueArray<uint8_t> compressed(blocksStream->readVInt());
+		blocksStream->readBytes(compressed.values, (int32_t)compressed.length);
+		if (codec == FieldsWriter::BLOCK_LZ4) {
+			LZ4::decompress(compressed.values, (int32_t)compressed.length, victim->data.values, length);
+		} else if (codec == FieldsWriter::BLOCK_DEFLATE) {
+			uncompress(compressed, victim->data);
+			if ((int32_t)victim->data.length != length + 1)
+				_CLTHROWA(CL_ERR_CorruptIndex, "stored fields block has the wrong length");
+		} else
+			_CLTHROWA(CL_ERR_CorruptIndex, "unknown stored fields block compression");
+	}
+
+	victim->pointer = pointer;
+	victim->lastUse = ++blockCacheUse;
+	return victim;
+}
+
+bool FieldsReader::canReadRawDocs() const {
+	return !compressedBlocks;
+}
+
 CL_NS(store)::IndexInput* FieldsReader::rawDocs(int32_t* lengths, const int32_t startDocID, const int32_t numDocs) {
+	CND_PRECONDITION(!compressedBlocks, "compressed stored fields can't be copied raw");
 	indexStream->seek((docStoreOffset+startDocID) * 8L);
 	int64_t startOffset = indexStream->readLong();
 	int64_t lastOffset = startOffset;
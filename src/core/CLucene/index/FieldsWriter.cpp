@@ -12,6 +12,7 @@
 //#include "CLucene/util/VoidMap.h"
 #include "CLucene/util/CLStreams.h"
 #include "CLucene/util/Misc.h"
+#include "CLucene/util/_LZ4.h"
 #include "CLucene/store/Directory.h"
 #include "CLucene/store/_RAMDirectory.h"
 #include "CLucene/store/IndexOutput.h"
@@ -26,8 +27,16 @@ CL_NS_USE(util)
 CL_NS_USE(document)
 CL_NS_DEF(index)
 
-FieldsWriter::FieldsWriter(Directory* d, const wchar_t * segment, FieldInfos* fn):
-	fieldInfos(fn)
+FieldsWriter::FieldsWriter(Directory* d, const wchar_t * segment, FieldInfos* fn, int32_t _compression):
+	fieldInfos(fn),
+	fieldsStream(NULL),
+	indexStream(NULL),
+	compression(_compression),
+	blockBuffer(NULL),
+	blocksStream(NULL),
+	blockDocs(0),
+	numDocs(0),
+	docStart(0)
 {
 //Func - Constructor
 //Pre  - d contains a valid reference to a directory
@@ -45,10 +54,24 @@ FieldsWriter::FieldsWriter(Directory* d, const wchar_t * segment, FieldInfos* fn
 	CND_CONDITION(indexStream != NULL,L"indexStream is NULL");
 
 	doClose = true;
+
+	if ( compression != BLOCK_STORED ){
+		indexStream->writeInt(FORMAT_BLOCKS);
+		blocksStream = fieldsStream;
+		blockBuffer = _CLNEW RAMOutputStream();
+		fieldsStream = blockBuffer;
+		blockLengths.resize(64);
+	}
 }
 
 FieldsWriter::FieldsWriter(CL_NS(store)::IndexOutput* fdx, CL_NS(store)::IndexOutput* fdt, FieldInfos* fn):
-	fieldInfos(fn)
+	fieldInfos(fn),
+	compression(BLOCK_STORED),
+	blockBuffer(NULL),
+	blocksStream(NULL),
+	blockDocs(0),
+	numDocs(0),
+	docStart(0)
 {
 	fieldsStream = fdt;
 	CND_CONDITION(fieldsStream != NULL,L"fieldsStream is NULL");
@@ -73,6 +96,17 @@ void FieldsWriter::close() {
 	if (! doClose )
 		return;
 
+	if (blocksStream){
+		try{
+			flushBlock();
+		}_CLFINALLY(
+			//fieldsStream only buffered the pending block
+			_CLDELETE(blockBuffer);
+			fieldsStream = blocksStream;
+			blocksStream = NULL;
+		)
+	}
+
 	//Check if fieldsStream is valid
 	if (fieldsStream){
 		//Close fieldsStream
@@ -98,7 +132,7 @@ void FieldsWriter::addDocument(Document* doc) {
 	CND_PRECONDITION(indexStream != NULL,L"indexStream is NULL");
 	CND_PRECONDITION(fieldsStream != NULL,L"fieldsStream is NULL");
 
-	indexStream->writeLong(fieldsStream->getFilePointer());
+	startDocument();
 
 	int32_t storedCount = 0;
   {
@@ -119,6 +153,71 @@ void FieldsWriter::addDocument(Document* doc) {
 		  }
 	  }
   }
+	finishDocument();
+}
+
+void FieldsWriter::startDocument() {
+	if (blocksStream == NULL)
+		indexStream->writeLong(fieldsStream->getFilePointer());
+	else
+		docStart = fieldsStream->getFilePointer();
+}
+
+void FieldsWriter::finishDocument() {
+	if (blocksStream == NULL)
+		return;
+	if (blockDocs == (int32_t)blockLengths.length)
+		blockLengths.resize(blockLengths.length * 2);
+	blockLengths.values[blockDocs++] = (int32_t)(fieldsStream->getFilePointer() - docStart);
+	if (fieldsStream->getFilePointer() >= LUCENE_STORED_FIELDS_BLOCK_SIZE)
+		flushBlock();
+}
+
+void FieldsWriter::flushBlock() {
+	if (blockDocs == 0)
+		return;
+
+	const int32_t length = (int32_t)blockBuffer->getFilePointer();
+	ValueArray<uint8_t> data(length);
+	blockBuffer->writeTo(data.values);
+
+	uint8_t codec = (uint8_t)compression;
+	ValueArray<uint8_t> compressed;
+	int32_t compressedLength = 0;
+	if (codec == BLOCK_LZ4) {
+		compressed.resize(LZ4::compressBound(length));
+		compressedLength = LZ4::compress(data.values, length, compressed.values);
+	} else {
+		compress(data, compressed);
+		compressedLength = (int32_t)compressed.length;
+	}
+	if (compressedLength >= length)
+		codec = BLOCK_STORED; //does not compress, e.g. binary fields that already are
+
+	// block: codec, first doc, doc count, doc lengths, data length, [compressed length], data
+	const int64_t pointer = blocksStream->getFilePointer();
+	blocksStream->writeByte(codec);
+	blocksStream->writeVInt(numDocs);
+	blocksStream->writeVInt(blockDocs);
+	for (int32_t i = 0; i < blockDocs; i++)
+		blocksStream->writeVInt(blockLengths.values[i]);
+	blocksStream->writeVInt(length);
+	if (codec == BLOCK_STORED) {
+		blocksStream->writeBytes(data.values, length);
+	} else {
+		blocksStream->writeVInt(compressedLength);
+		blocksStream->writeBytes(compressed.values, compressedLength);
+	}
+
+	for (int32_t i = 0; i < blockDocs; i++)
+		indexStream->writeLong(pointer);
+	numDocs += blockDocs;
+	blockDocs = 0;
+	blockBuffer->reset();
+}
+
+int32_t FieldsWriter::indexHeaderLength() const {
+	return compression == BLOCK_STORED ? 0 : 4;
 }
 
 void FieldsWriter::writeField(FieldInfo* fi, CL_NS(document)::Field* field)
@@ -231,17 +330,31 @@ void FieldsWriter::writeField(FieldInfo* fi, CL_NS(document)::Field* field)
 }
 
 void FieldsWriter::flushDocument(int32_t numStoredFields, CL_NS(store)::RAMOutputStream* buffer) {
-	indexStream->writeLong(fieldsStream->getFilePointer());
+	startDocument();
 	fieldsStream->writeVInt(numStoredFields);
 	buffer->writeTo(fieldsStream);
+	finishDocument();
 }
 
 void FieldsWriter::flush() {
+  if (blocksStream != NULL) {
+    flushBlock();
+    blocksStream->flush();
+  }
   indexStream->flush();
   fieldsStream->flush();
 }
 
 void FieldsWriter::addRawDocuments(CL_NS(store)::IndexInput* stream, const int32_t* lengths, const int32_t numDocs) {
+	if (blocksStream != NULL) {
+		// the raw documents go into blocks like any other
+		for(int32_t i=0;i<numDocs;i++) {
+			startDocument();
+			fieldsStream->copyBytes(stream, lengths[i]);
+			finishDocument();
+		}
+		return;
+	}
 	int64_t position = fieldsStream->getFilePointer();
 	const int64_t start = position;
 	for(int32_t i=0;i<numDocs;i++) {
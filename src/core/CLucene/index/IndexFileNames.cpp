@@ -19,6 +19,7 @@ CL_NS_DEF(index)
 	const wchar_t* IndexFileNames::SEGMENTS_GEN = L"segments.gen";
 	const wchar_t* IndexFileNames::DELETABLE = L"deletable";
 	const wchar_t* IndexFileNames::NORMS_EXTENSION = L"nrm";
+	const wchar_t* IndexFileNames::DOC_VALUES_EXTENSION = L"dv";
 	const wchar_t* IndexFileNames::FREQ_EXTENSION = L"frq";
 	const wchar_t* IndexFileNames::PROX_EXTENSION = L"prx";
 	const wchar_t* IndexFileNames::TERMS_EXTENSION = L"tis";
@@ -52,14 +53,15 @@ CL_NS_DEF(index)
 			IndexFileNames::VECTORS_FIELDS_EXTENSION,
 			IndexFileNames::GEN_EXTENSION,
 			IndexFileNames::NORMS_EXTENSION,
-			IndexFileNames::COMPOUND_FILE_STORE_EXTENSION
+			IndexFileNames::COMPOUND_FILE_STORE_EXTENSION,
+			IndexFileNames::DOC_VALUES_EXTENSION
 		};
   
 	CL_NS(util)::ConstValueArray<const wchar_t*> IndexFileNames::_INDEX_EXTENSIONS;
   CL_NS(util)::ConstValueArray<const wchar_t*>& IndexFileNames::INDEX_EXTENSIONS(){
     if ( _INDEX_EXTENSIONS.length == 0 ){
       _INDEX_EXTENSIONS.values = IndexFileNames_INDEX_EXTENSIONS_s;
-      _INDEX_EXTENSIONS.length = 15;
+      _INDEX_EXTENSIONS.length = 16;
     }
     return _INDEX_EXTENSIONS;
   }
@@ -75,13 +77,14 @@ CL_NS_DEF(index)
 		IndexFileNames::VECTORS_INDEX_EXTENSION,
 		IndexFileNames::VECTORS_DOCUMENTS_EXTENSION,
 		IndexFileNames::VECTORS_FIELDS_EXTENSION,
-		IndexFileNames::NORMS_EXTENSION
+		IndexFileNames::NORMS_EXTENSION,
+		IndexFileNames::DOC_VALUES_EXTENSION
 	};
 	CL_NS(util)::ConstValueArray<const wchar_t*> IndexFileNames::_INDEX_EXTENSIONS_IN_COMPOUND_FILE;
   CL_NS(util)::ConstValueArray<const wchar_t*>& IndexFileNames::INDEX_EXTENSIONS_IN_COMPOUND_FILE(){
     if ( _INDEX_EXTENSIONS_IN_COMPOUND_FILE.length == 0 ){
       _INDEX_EXTENSIONS_IN_COMPOUND_FILE.values = IndexFileNames_INDEX_EXTENSIONS_IN_COMPOUND_FILE_s;
-      _INDEX_EXTENSIONS_IN_COMPOUND_FILE.length = 11;
+      _INDEX_EXTENSIONS_IN_COMPOUND_FILE.length = 12;
     }
     return _INDEX_EXTENSIONS_IN_COMPOUND_FILE;
   }
@@ -108,13 +111,14 @@ CL_NS_DEF(index)
 		IndexFileNames::PROX_EXTENSION,
 		IndexFileNames::TERMS_EXTENSION,
 		IndexFileNames::TERMS_INDEX_EXTENSION,
-		IndexFileNames::NORMS_EXTENSION
+		IndexFileNames::NORMS_EXTENSION,
+		IndexFileNames::DOC_VALUES_EXTENSION
 	};
 	CL_NS(util)::ConstValueArray<const wchar_t*> IndexFileNames::_NON_STORE_INDEX_EXTENSIONS;
   CL_NS(util)::ConstValueArray<const wchar_t*>& IndexFileNames::NON_STORE_INDEX_EXTENSIONS(){
     if ( _NON_STORE_INDEX_EXTENSIONS.length == 0 ){
       _NON_STORE_INDEX_EXTENSIONS.values = IndexFileNames_NON_STORE_INDEX_EXTENSIONS_s;
-      _NON_STORE_INDEX_EXTENSIONS.length = 6;
+      _NON_STORE_INDEX_EXTENSIONS.length = 7;
     }
     return _NON_STORE_INDEX_EXTENSIONS;
   }
@@ -63,7 +63,14 @@ CL_NS_DEF(index)
       CloseCallbackCompare> CloseCallbackMap;
     CloseCallbackMap closeCallbacks;
 
-    Internal(Directory* directory, IndexReader* _this)
+    // the largest norm of each field asked for, see maxNorm()
+    typedef CL_NS(util)::CLHashMap<wchar_t*, int32_t,
+      CL_NS(util)::Compare::WChar, CL_NS(util)::Equals::WChar,
+      CL_NS(util)::Deletor::tcArray, CL_NS(util)::Deletor::DummyInt32> MaxNormsType;
+    MaxNormsType maxNorms;
+
+    Internal(Directory* directory, IndexReader* _this):
+      maxNorms(true, false)
     {
       if ( directory != NULL )
         this->directory = _CL_POINTER(directory);
@@ -213,6 +220,26 @@ CL_NS_DEF(index)
     this->acquireWriteLock();
     this->hasChanges = true;
     this->doSetNorm(doc, field, value);
+    _internal->maxNorms.remove(const_cast<wchar_t*>(field));
+  }
+
+  uint8_t IndexReader::maxNorm(const wchar_t* field){
+    SCOPED_LOCK_MUTEX(THIS_LOCK)
+    Internal::MaxNormsType::iterator itr = _internal->maxNorms.find(const_cast<wchar_t*>(field));
+    if ( itr != _internal->maxNorms.end() )
+      return (uint8_t)itr->second;
+
+    uint8_t max = 0;
+    const uint8_t* bytes = norms(field);
+    if ( bytes != NULL ){
+      const int32_t n = maxDoc();
+      for ( int32_t i = 0; i < n; i++ ){
+        if ( bytes[i] > max )
+          max = bytes[i];
+      }
+    }
+    _internal->maxNorms.put(_wcsdup(field), max);
+    return max;
   }
 
 
@@ -444,6 +471,20 @@ CL_NS_DEF(index)
 	  return ret;
   }
 
+NumericDocValues* IndexReader::getNumericDocValues(const wchar_t* /*field*/){
+  ensureOpen();
+  return NULL;
+}
+
+SortedDocValues* IndexReader::getSortedDocValues(const wchar_t* /*field*/){
+  ensureOpen();
+  return NULL;
+}
+
+const CL_NS(util)::ArrayBase<IndexReader*>* IndexReader::getSubReaders() const{
+  return NULL;
+}
+
 bool IndexReader::hasNorms(const wchar_t* field) {
 	// backward compatible implementation.
 	// SegmentReader has an efficient implementation.
@@ -18,6 +18,7 @@ CL_CLASS_DEF(store,Directory)
 CL_CLASS_DEF(store,LuceneLock)
 CL_CLASS_DEF(document,Document)
 CL_CLASS_DEF(document,FieldSelector)
+CL_CLASS_DEF(document,StoredFieldVisitor)
 
 CL_NS_DEF(index)
 class SegmentInfos;
@@ -28,6 +29,8 @@ class TermDocs;
 class TermPositions;
 class IndexDeletionPolicy;
 class TermVectorMapper;
+class NumericDocValues;
+class SortedDocValues;
 
 /** IndexReader is an abstract class, providing an interface for accessing an
  index.  Search of an index is done entirely through this abstract interface,
@@ -262,6 +265,27 @@ public:
 	*/
 	virtual void norms(const wchar_t* field, uint8_t* bytes) = 0;
 
+	/** Returns the largest of the byte-encoded norms of the named field, which
+	* search code uses to bound the scores of a field's documents. The norms are
+	* scanned once per field, until {@link #setNorm} changes one of them.
+	*/
+	uint8_t maxNorm(const wchar_t* field);
+
+	/** Returns the numeric doc values of the field, or NULL if the field has
+	* none in this reader (see Field::DOCVALUES_NUMERIC). The values are read
+	* the first time they are asked for, straight from the index.
+	*
+	* @memory The values belong to the reader and are valid while it is open.
+	*/
+	virtual NumericDocValues* getNumericDocValues(const wchar_t* field);
+
+	/** Returns the sorted doc values of the field, or NULL if the field has
+	* none in this reader (see Field::DOCVALUES_SORTED).
+	*
+	* @memory The values belong to the reader and are valid while it is open.
+	*/
+	virtual SortedDocValues* getSortedDocValues(const wchar_t* field);
+
   /** Expert: Resets the normalization factor for the named field of the named
   * document.
   *
@@ -362,16 +386,19 @@ public:
    *
    * <b>NOTE:</b> you must call this before the term
    * index is loaded.  If the index is already loaded,
-   * an IllegalStateException is thrown.
+   * an IllegalStateException is thrown. Readers which share their term
+   * index with other open readers, such as the readers of
+   * IndexWriter::getReader() and reopened readers, cannot change it either.
    * @throws IllegalStateException if the term index has already been loaded into memory
+   * or is shared with other readers
    */
-  void setTermInfosIndexDivisor(int32_t indexDivisor);
+  virtual void setTermInfosIndexDivisor(int32_t indexDivisor);
 
   /** <p>For IndexReader implementations that use
    *  TermInfosReader to read terms, this returns the
    *  current indexDivisor.
    *  @see #setTermInfosIndexDivisor */
-  int32_t getTermInfosIndexDivisor();
+  virtual int32_t getTermInfosIndexDivisor();
 
   /**
    * Check whether this IndexReader is still using the
@@ -478,6 +505,13 @@ public:
 	*/
 	virtual int32_t maxDoc() const = 0;
 
+	/** Expert: Returns the readers this one is made of, in the order of
+	* their documents, or NULL if it is not made of other readers. The
+	* documents of each start at the sum of the {@link #maxDoc()} of the
+	* readers before it. The default returns NULL.
+	*/
+	virtual const CL_NS(util)::ArrayBase<IndexReader*>* getSubReaders() const;
+
   /**
    * Get the {@link org.apache.lucene.document.Document} at the <code>n</code><sup>th</sup> position. The {@link org.apache.lucene.document.FieldSelector}
    * may be used to determine what {@link org.apache.lucene.document.Field}s to load and how they should be loaded.
@@ -514,6 +548,16 @@ public:
 
 	_CL_DEPRECATED( document(i, Document&) ) bool document(int32_t n, CL_NS(document)::Document*);
 
+  /** Expert: passes the stored fields of the <code>n</code><sup>th</sup>
+  * document to visitor as they are read, without building a Document or
+  * allocating the values. The visitor decides which fields are read and
+  * can stop early.
+  * @see CL_NS(document)::StoredFieldVisitor
+  * @throws CorruptIndexException if the index is corrupt
+  * @throws IOException if there is a low-level IO error
+  */
+  virtual bool document(int32_t n, CL_NS(document)::StoredFieldVisitor& visitor) =0;
+
 	_CL_DEPRECATED( document(i, document) ) CL_NS(document)::Document* document(const int32_t n);
 
 	/** Returns true if document <i>n</i> has been deleted */
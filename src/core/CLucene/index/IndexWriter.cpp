@@ -24,6 +24,9 @@
 #include "_SegmentInfos.h"
 #include "_SegmentMerger.h"
 #include "_SegmentHeader.h"
+#include "DirectoryIndexReader.h"
+#include "_MultiSegmentReader.h"
+#include "_SegmentReaderPool.h"
 #include "CLucene/search/Similarity.h"
 #include "CLucene/index/MergePolicy.h"
 #include "MergePolicy.h"
@@ -54,6 +57,7 @@ const int32_t IndexWriter::DEFAULT_MAX_MERGE_DOCS = LogDocMergePolicy::DEFAULT_M
 const int32_t IndexWriter::DEFAULT_MERGE_FACTOR = LogMergePolicy::DEFAULT_MERGE_FACTOR;
 
 DEFINE_MUTEX(IndexWriter::MESSAGE_ID_LOCK)
+DEFINE_MUTEX(IndexWriter::READERS_LOCK)
 int32_t IndexWriter::MESSAGE_ID = 0;
 const int32_t IndexWriter::MAX_TERM_LENGTH = DocumentsWriter::MAX_TERM_LENGTH;
 
@@ -61,9 +65,20 @@ class IndexWriter::Internal
 {
 public:
     IndexWriter * _this;
+
+    // the readers opened by getReader() and not closed yet
+    std::vector<DirectoryIndexReader*> readers;
+
+    // counts the changes of segmentInfos, see isReaderCurrent()
+    int64_t changeCount;
+
+    // the segment readers of merges, deletions and getReader()
+    SegmentReaderPool readerPool;
+
     Internal(IndexWriter* _this)
     {
         this->_this = _this;
+        this->changeCount = 0;
     }
     // Apply buffered delete terms to the segment just flushed from ram
     // apply appropriately so that a delete term is only applied to
@@ -73,10 +88,16 @@ public:
 
     // Apply buffered delete terms to this reader.
     void applyDeletes(const DocumentsWriter::TermNumMapType& deleteTerms, IndexReader* reader);
+
+    // Opens a reader of infos, a clone of segmentInfos, out of
+    // clones of the pooled segment readers
+    DirectoryIndexReader* openReader(SegmentInfos* infos);
 };
 
 void IndexWriter::deinit(bool releaseWriteLock) throw()
 {
+    detachReaders();
+    _internal->readerPool.clear();
     if (writeLock != NULL && releaseWriteLock)
     {
         writeLock->release(); // release write lock
@@ -175,6 +196,30 @@ int32_t IndexWriter::getTermIndexInterval()
     return termIndexInterval;
 }
 
+void IndexWriter::setStoredFieldsCompression(StoredFieldsCompression compression)
+{
+    ensureOpen();
+    this->storedFieldsCompression = compression;
+}
+
+IndexWriter::StoredFieldsCompression IndexWriter::getStoredFieldsCompression()
+{
+    ensureOpen();
+    return (StoredFieldsCompression)storedFieldsCompression;
+}
+
+void IndexWriter::setPostingsFormat(PostingsFormat format)
+{
+    ensureOpen();
+    this->postingsFormat = format;
+}
+
+IndexWriter::PostingsFormat IndexWriter::getPostingsFormat()
+{
+    ensureOpen();
+    return (PostingsFormat)postingsFormat;
+}
+
 IndexWriter::IndexWriter(const wchar_t * path, Analyzer* a, bool create) :bOwnsDirectory(true)
 {
     init(FSDirectory::getDirectory(path, create), a, create, true, (IndexDeletionPolicy*) NULL, true);
@@ -212,7 +257,9 @@ void IndexWriter::init(Directory* d, Analyzer* a, const bool create, const bool
 {
     this->_internal = new Internal(this);
     this->termIndexInterval = IndexWriter::DEFAULT_TERM_INDEX_INTERVAL;
-    this->mergeScheduler = _CLNEW SerialMergeScheduler(); //TODO: implement and use ConcurrentMergeScheduler
+    this->storedFieldsCompression = STORED_FIELDS_UNCOMPRESSED;
+    this->postingsFormat = POSTINGS_BLOCK;
+    this->mergeScheduler = _CLNEW SerialMergeScheduler();
     this->mergingSegments = _CLNEW MergingSegmentsType;
     this->pendingMerges = _CLNEW PendingMergesType;
     this->runningMerges = _CLNEW RunningMergesType;
@@ -586,6 +633,19 @@ void IndexWriter::close(bool waitForMerges)
         waitForClose();
 }
 
+void IndexWriter::waitForMerges()
+{
+    ensureOpen();
+    {
+        SCOPED_LOCK_MUTEX(THIS_LOCK)
+            while (pendingMerges->size() > 0 || runningMerges->size() > 0)
+            {
+                CONDITION_WAIT(THIS_LOCK, THIS_WAIT_CONDITION)
+            }
+    }
+    mergeScheduler->sync();
+}
+
 void IndexWriter::waitForClose()
 {
     SCOPED_LOCK_MUTEX(THIS_LOCK)
@@ -617,8 +677,28 @@ void IndexWriter::closeInternal(bool waitForMerges)
 
         finishMerges(waitForMerges);
 
+        // a background merge which failed is reported once the
+        // writer is closed, so the write lock is not left behind
+        bool mergeFailed = false;
+        CLuceneError mergeError;
+        if (waitForMerges)
+        {
+            try
+            {
+                mergeScheduler->sync();
+            }
+            catch (CLuceneError& err)
+            {
+                mergeError.set(err.number(), err.twhat());
+                mergeFailed = true;
+            }
+        }
+
         mergeScheduler->close();
 
+        // outside of THIS_LOCK, see READERS_LOCK
+        detachReaders();
+
         {
             SCOPED_LOCK_MUTEX(this->THIS_LOCK)
                 if (commitPending)
@@ -651,6 +731,7 @@ void IndexWriter::closeInternal(bool waitForMerges)
                 message(L"at close: " + segString());
 
             _CLDELETE(docWriter);
+            _internal->readerPool.clear();
             deleter->close();
         }
 
@@ -663,6 +744,8 @@ void IndexWriter::closeInternal(bool waitForMerges)
             _CLDELETE(writeLock);
         }
         closed = true;
+        if (mergeFailed)
+            throw mergeError;
     }
     catch (std::bad_alloc&)
     {
@@ -685,7 +768,8 @@ bool IndexWriter::flushDocStores()
 {
     SCOPED_LOCK_MUTEX(THIS_LOCK)
 
-        const std::vector<std::wstring>& files = docWriter->files();
+        // a copy, as closeDocStore() clears the files of docWriter
+        const std::vector<std::wstring> files = docWriter->files();
 
     bool useCompoundDocStore = false;
 
@@ -733,7 +817,10 @@ bool IndexWriter::flushDocStores()
                     SegmentInfo* si = segmentInfos->info(i);
                     if (si->getDocStoreOffset() != -1 &&
                         si->getDocStoreSegment().compare(docStoreSegment) == 0)
+                    {
                         si->setDocStoreIsCompoundFile(true);
+                        _internal->readerPool.drop(si);
+                    }
                 }
                 checkpoint();
                 success = true;
@@ -1020,7 +1107,7 @@ void IndexWriter::optimize(int32_t maxNumSegments, bool doWait)
                         const int32_t size = mergeExceptions->size();
                         for (int32_t i = 0; i < size; i++)
                         {
-                            MergePolicy::OneMerge* _merge = (*mergeExceptions)[0];
+                            MergePolicy::OneMerge* _merge = (*mergeExceptions)[i];
                             if (_merge->optimize)
                             {
                                 CLuceneError tmp(_merge->getException());
@@ -1047,8 +1134,6 @@ bool IndexWriter::optimizeMergesPending()
     {
         if ((*it)->optimize)
             return true;
-
-        it++;
     }
 
     for (RunningMergesType::iterator it = runningMerges->begin();
@@ -1056,8 +1141,6 @@ bool IndexWriter::optimizeMergesPending()
     {
         if ((*it)->optimize)
             return true;
-
-        it++;
     }
 
     return false;
@@ -1180,6 +1263,8 @@ void IndexWriter::rollbackTransaction()
     segmentInfos->clear();
     segmentInfos->insert(localRollbackSegmentInfos, true);
     _CLDELETE(localRollbackSegmentInfos);
+    _internal->changeCount++;
+    _internal->readerPool.clear();
 
     // Ask deleter to locate unreferenced files we had
     // created & remove them:
@@ -1268,6 +1353,7 @@ void IndexWriter::abort()
                 // once").
                 segmentInfos->clear();
             segmentInfos->insert(rollbackSegmentInfos, false);
+            _internal->readerPool.clear();
 
             docWriter->abort(NULL);
 
@@ -1301,8 +1387,6 @@ void IndexWriter::finishMerges(bool waitForMerges)
                     message(L"now abort pending merge " + _merge->segString(directory));
                 _merge->abort();
                 mergeFinish(_merge);
-
-                it++;
             }
             pendingMerges->clear();
 
@@ -1313,8 +1397,6 @@ void IndexWriter::finishMerges(bool waitForMerges)
                 if (infoStream != NULL)
                     message(L"now abort running merge " + _merge->segString(directory));
                 _merge->abort();
-
-                it++;
             }
 
             // These merges periodically check whether they have
@@ -1348,6 +1430,7 @@ void IndexWriter::finishMerges(bool waitForMerges)
 void IndexWriter::checkpoint()
 {
     SCOPED_LOCK_MUTEX(THIS_LOCK)
+        _internal->changeCount++;
         if (autoCommit)
         {
             segmentInfos->write(directory);
@@ -1564,6 +1647,128 @@ void IndexWriter::flush(bool triggerMerge, bool _flushDocStores)
         maybeMerge();
 }
 
+IndexReader* IndexWriter::getReader()
+{
+    ensureOpen();
+
+    // Flush the buffered documents and deletes, and close
+    // the doc stores so the reader can open them, but do
+    // not write a segments file:
+    flush(false, true);
+
+    DirectoryIndexReader* reader;
+    {
+        SCOPED_LOCK_MUTEX(THIS_LOCK)
+        // the readers may already have been detached
+        if (closing || closed)
+            _CLTHROWA(CL_ERR_AlreadyClosed, "this IndexWriter is closed");
+        SegmentInfos* infos = segmentInfos->clone();
+
+        // Keep the files of the reader until it is closed,
+        // even if its segments are merged away:
+        deleter->incRef(infos, false);
+
+        // Keep the segment readers for the next reader
+        _internal->readerPool.setPooling(true);
+
+        bool success = false;
+        try
+        {
+            reader = _internal->openReader(infos);
+            success = true;
+        } _CLFINALLY(
+            if (!success)
+            {
+                deleter->decRef(infos);
+                _CLDELETE(infos);
+            }
+        )
+
+        reader->writer = this;
+        reader->writerChangeCount = _internal->changeCount;
+        _internal->readers.push_back(reader);
+    }
+
+    // The flush may have made merges necessary:
+    maybeMerge();
+    return reader;
+}
+
+DirectoryIndexReader* IndexWriter::Internal::openReader(SegmentInfos* infos)
+{
+    ArrayBase<IndexReader*>* subReaders = _CLNEW ObjectArray<IndexReader>(infos->size());
+    DirectoryIndexReader* reader = NULL;
+    try
+    {
+        for (int32_t i = 0; i < infos->size(); i++)
+        {
+            SegmentReader* pooled = readerPool.get(_this->segmentInfos->info(i), true, BufferedIndexInput::BUFFER_SIZE);
+            try
+            {
+                // every reader has its own deletions and stored fields reader
+                subReaders->values[i] = pooled->reopenSegment(infos->info(i), true);
+            } _CLFINALLY(
+                readerPool.release(pooled);
+            )
+        }
+
+        if (infos->size() == 1)
+        {
+            reader = (SegmentReader*) subReaders->values[0];
+            subReaders->values[0] = NULL;
+            reader->segmentInfos = infos;
+        }
+        else
+        {
+            reader = _CLNEW MultiSegmentReader(_this->directory, infos, false, subReaders);
+            subReaders = NULL;
+        }
+    } _CLFINALLY(
+        if (subReaders != NULL)
+        {
+            for (size_t i = 0; i < subReaders->length; i++)
+            {
+                if (subReaders->values[i] != NULL)
+                    subReaders->values[i]->close();
+            }
+            _CLDELETE(subReaders);
+        }
+    )
+    return reader;
+}
+
+bool IndexWriter::isReaderCurrent(DirectoryIndexReader* reader)
+{
+    SCOPED_LOCK_MUTEX(THIS_LOCK)
+    return reader->writerChangeCount == _internal->changeCount &&
+        docWriter->getNumDocsInRAM() == 0 && !docWriter->hasDeletes();
+}
+
+void IndexWriter::readerClosed(DirectoryIndexReader* reader)
+{
+    SCOPED_LOCK_MUTEX(THIS_LOCK)
+    std::vector<DirectoryIndexReader*>::iterator itr =
+        std::find(_internal->readers.begin(), _internal->readers.end(), reader);
+    if (itr != _internal->readers.end())
+    {
+        _internal->readers.erase(itr);
+        deleter->decRef(reader->segmentInfos);
+    }
+}
+
+void IndexWriter::detachReaders()
+{
+    SCOPED_LOCK_MUTEX(READERS_LOCK)
+    {
+        SCOPED_LOCK_MUTEX(THIS_LOCK)
+        // The files of the readers that are still open are
+        // left to the deleter of the next writer
+        for (size_t i = 0; i < _internal->readers.size(); i++)
+            _LUCENE_ATOMIC_PTR_SET(&_internal->readers[i]->writer, NULL);
+        _internal->readers.clear();
+    }
+}
+
 bool IndexWriter::doFlush(bool _flushDocStores)
 {
     SCOPED_LOCK_MUTEX(THIS_LOCK)
@@ -1678,6 +1883,7 @@ bool IndexWriter::doFlush(bool _flushDocStores)
                         directory, false, true,
                         docStoreOffset, docStoreSegment.c_str(),
                         docStoreIsCompoundFile);
+                    newSegment->setPostingsFormat(postingsFormat);
                     segmentInfos->insert(newSegment);
                 }
 
@@ -1995,6 +2201,7 @@ bool IndexWriter::commitMerge(MergePolicy::OneMerge* _merge)
         int32_t segmentssize = _merge->segments->size();
         for (int32_t i = 0; i < segmentssize; i++)
         {
+            _internal->readerPool.drop(segmentInfos->info(start));
             segmentInfos->remove(start);
         }
         segmentInfos->add(_merge->info, start);
@@ -2316,6 +2523,7 @@ void IndexWriter::_mergeInit(MergePolicy::OneMerge* _merge)
         docStoreOffset,
         docStoreSegment.c_str(),
         docStoreIsCompoundFile);
+    _merge->info->setPostingsFormat(postingsFormat);
     // Also enroll the merged segment into mergingSegments;
     // this prevents it from getting selected for a merge
     // after our merge is done but while we are building the
@@ -2362,8 +2570,15 @@ int32_t IndexWriter::mergeMiddle(MergePolicy::OneMerge* _merge)
 
     SegmentMerger merger(this, mergedName.c_str(), _merge);
 
-    // This is try/finally to make sure merger's readers are
-    // closed:
+    // The merge reads the pooled readers, which applyDeletes() leaves
+    // alone while they are checked out, unless deletes were flushed
+    // between the start of the merge and now: then it reads clones that
+    // have the deletes of the start of the merge.
+    std::vector<SegmentReader*> readers;
+    std::vector<bool> pooled;
+
+    // This is try/finally to make sure the readers are
+    // returned or closed:
 
     bool success = false;
 
@@ -2373,8 +2588,37 @@ int32_t IndexWriter::mergeMiddle(MergePolicy::OneMerge* _merge)
 
         for (int32_t i = 0; i < numSegments; i++)
         {
-            SegmentInfo* si = sourceSegmentsClone->info(i);
-            IndexReader* reader = SegmentReader::get(si, MERGE_READ_BUFFER_SIZE, _merge->mergeDocStores); // no need to set deleter (yet)
+            SegmentInfo* previousInfo = sourceSegmentsClone->info(i);
+            SegmentReader* reader;
+            bool isPooled = true;
+            if (previousInfo->dir != directory)
+            {
+                // the pool only has the segments of this index,
+                // addIndexesNoOptimize() also merges foreign ones
+                reader = SegmentReader::get(previousInfo, MERGE_READ_BUFFER_SIZE, _merge->mergeDocStores);
+                isPooled = false;
+            }
+            else
+            {
+                SCOPED_LOCK_MUTEX(THIS_LOCK)
+                SegmentInfo* currentInfo = sourceSegments->info(i);
+                reader = _internal->readerPool.get(currentInfo, _merge->mergeDocStores, MERGE_READ_BUFFER_SIZE);
+                if (currentInfo->hasDeletions() != previousInfo->hasDeletions() ||
+                    (currentInfo->hasDeletions() && currentInfo->getDelFileName().compare(previousInfo->getDelFileName()) != 0))
+                {
+                    SegmentReader* current = reader;
+                    try
+                    {
+                        reader = current->reopenSegment(previousInfo, true);
+                    } _CLFINALLY(
+                        _internal->readerPool.release(current);
+                    )
+                    isPooled = false;
+                }
+            }
+            readers.push_back(reader);
+            pooled.push_back(isPooled);
+            reader->setAccessPattern(IndexInput::ACCESS_SEQUENTIAL); // every file is read front to back once
             merger.add(reader);
             totDocCount += reader->numDocs();
         }
@@ -2392,9 +2636,21 @@ int32_t IndexWriter::mergeMiddle(MergePolicy::OneMerge* _merge)
         success = true;
 
     } _CLFINALLY(
-        // close readers before we attempt to delete
-        // now-obsolete segments
-        merger.closeReaders();
+        // return or close the readers before we attempt to
+        // delete now-obsolete segments
+        for (size_t i = 0; i < readers.size(); i++)
+        {
+            if (pooled[i])
+            {
+                readers[i]->setAccessPattern(IndexInput::ACCESS_NORMAL);
+                _internal->readerPool.release(readers[i]);
+            }
+            else
+            {
+                readers[i]->close();
+                _CLDELETE(readers[i]);
+            }
+        }
     if (!success)
     {
         if (infoStream != NULL)
@@ -2484,6 +2740,7 @@ int32_t IndexWriter::mergeMiddle(MergePolicy::OneMerge* _merge)
                             try
                             {
                                 _merge->info->setUseCompoundFile(true);
+                                _internal->readerPool.drop(_merge->info);
                                 checkpoint();
                                 success = true;
                             } _CLFINALLY(
@@ -2513,19 +2770,11 @@ int32_t IndexWriter::mergeMiddle(MergePolicy::OneMerge* _merge)
 void IndexWriter::addMergeException(MergePolicy::OneMerge* _merge)
 {
     SCOPED_LOCK_MUTEX(THIS_LOCK)
-        if (mergeGen == _merge->mergeGen)
-        {
-            MergeExceptionsType::iterator itr = mergeExceptions->begin();
-            while (itr != mergeExceptions->end())
-            {
-                MergePolicy::OneMerge* x = *itr;
-                if (x == _merge)
-                {
-                    return;
-                }
-            }
-        }
-    mergeExceptions->push_back(_merge);
+        // Merges registered before the last resetMergeExceptions
+        // belong to an earlier optimize, don't report them again
+        if (mergeGen == _merge->mergeGen &&
+            std::find(mergeExceptions->begin(), mergeExceptions->end(), _merge) == mergeExceptions->end())
+            mergeExceptions->push_back(_merge);
 }
 
 void IndexWriter::deletePartialSegmentsFile()
@@ -2555,13 +2804,13 @@ void IndexWriter::applyDeletes(bool flushedNewSegment)
 
     if (flushedNewSegment)
     {
-        IndexReader* reader = NULL;
+        SegmentReader* reader = NULL;
         try
         {
             // Open readers w/o opening the stored fields /
             // vectors because these files may still be held
             // open for writing by docWriter
-            reader = SegmentReader::get(segmentInfos->info(segmentInfos->size() - 1), false);
+            reader = _internal->readerPool.get(segmentInfos->info(segmentInfos->size() - 1), false, BufferedIndexInput::BUFFER_SIZE);
 
             // Apply delete terms to the segment just flushed from ram
             // apply appropriately so that a delete term is only applied to
@@ -2574,8 +2823,7 @@ void IndexWriter::applyDeletes(bool flushedNewSegment)
                 {
                     reader->doCommit();
                 } _CLFINALLY(
-                    reader->doClose();
-                _CLLDELETE(reader);
+                    _internal->readerPool.release(reader);
                 )
             }
         )
@@ -2589,10 +2837,14 @@ void IndexWriter::applyDeletes(bool flushedNewSegment)
 
     for (int32_t i = 0; i < infosEnd; i++)
     {
-        IndexReader* reader = NULL;
+        SegmentReader* reader = NULL;
         try
         {
-            reader = SegmentReader::get(segmentInfos->info(i), false);
+            // a merge reads the pooled reader of the segment as it was
+            // when the merge started, so the deletes go to a new one
+            if (_internal->readerPool.isCheckedOut(segmentInfos->info(i)))
+                _internal->readerPool.drop(segmentInfos->info(i));
+            reader = _internal->readerPool.get(segmentInfos->info(i), false, BufferedIndexInput::BUFFER_SIZE);
 
             // Apply delete terms to disk segments
             // except the one just flushed from ram.
@@ -2604,7 +2856,7 @@ void IndexWriter::applyDeletes(bool flushedNewSegment)
                 {
                     reader->doCommit();
                 } _CLFINALLY(
-                    reader->doClose();
+                    _internal->readerPool.release(reader);
                 )
             }
         )
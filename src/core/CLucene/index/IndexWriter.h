@@ -27,6 +27,7 @@ class SegmentInfos;
 class MergePolicy;
 class IndexReader;
 class SegmentReader;
+class DirectoryIndexReader;
 class MergeScheduler;
 class DocumentsWriter;
 class IndexFileDeleter;
@@ -248,6 +249,8 @@ class CLUCENE_EXPORT IndexWriter:LUCENE_BASE {
   int32_t minMergeDocs;
   int32_t maxMergeDocs;
   int32_t termIndexInterval;
+  int32_t storedFieldsCompression;
+  int32_t postingsFormat;
 
   int64_t writeLockTimeout;
   int64_t commitLockTimeout;
@@ -444,6 +447,54 @@ public:
    */
   int32_t getTermIndexInterval();
 
+  /** How stored fields are written, see setStoredFieldsCompression() */
+  enum StoredFieldsCompression{
+    STORED_FIELDS_UNCOMPRESSED = 0, ///< one document after the other, the default
+    STORED_FIELDS_FAST = 1,         ///< blocks of documents compressed with LZ4, cheap to decompress
+    STORED_FIELDS_HIGH = 2          ///< blocks of documents compressed with deflate, smaller but slower
+  };
+  /** Expert: Set how stored fields of new segments are written. The compressed
+   * formats write the stored fields of several documents (up to
+   * LUCENE_STORED_FIELDS_BLOCK_SIZE bytes) as one compressed block, so that the
+   * documents share one dictionary. This works much better than per field
+   * compression (Field::STORE_COMPRESS) on many short stored fields. Loading a
+   * document then decompresses its whole block, readers keep the last few
+   * blocks to make loading neighbouring documents cheap.
+   *
+   * Segments written in any format can be read and merged together, merged
+   * segments are written in the format set here. Lazy loading of fields is
+   * not supported for compressed blocks, those fields are loaded right away.
+   */
+  void setStoredFieldsCompression(StoredFieldsCompression compression);
+  /** Expert: Return how stored fields are written.
+   *
+   * @see #setStoredFieldsCompression
+   */
+  StoredFieldsCompression getStoredFieldsCompression();
+
+  /** How postings are written, see setPostingsFormat() */
+  enum PostingsFormat{
+    POSTINGS_VINT = 0,  ///< doc deltas, freqs and positions one vint after the other
+    POSTINGS_BLOCK = 1  ///< blocks of 128 bit-packed doc deltas, freqs and positions, the default
+  };
+  /** Expert: Set how the postings (.frq and .prx files) of new segments are
+   * written. The block format packs the doc deltas and freqs of 128
+   * documents, and 128 positions, with the bits most of them need, which
+   * readers decode a block at a time, and skips from block to block. The
+   * vint format is the one of indexes written before postings formats
+   * existed.
+   *
+   * Each segment records its format, segments written in any format can be
+   * read and merged together, merged segments are written in the format set
+   * here.
+   */
+  void setPostingsFormat(PostingsFormat format);
+  /** Expert: Return how postings are written.
+   *
+   * @see #setPostingsFormat
+   */
+  PostingsFormat getPostingsFormat();
+
   /**Determines the largest number of documents ever merged by addDocument().
    *  Small values (e.g., less than 10,000) are best for interactive indexing,
    *  as this limits the length of pauses while indexing to a few seconds.
@@ -799,11 +850,21 @@ public:
    *
    * after which, you must be certain not to use the writer
    * instance anymore.</p>
+   * <p>When waiting for merges, an exception hit by a merge
+   * running in the background (see ConcurrentMergeScheduler)
+   * is rethrown once the writer is closed.</p>
    * @throws CorruptIndexException if the index is corrupt
    * @throws IOException if there is a low-level IO error
    */
   void close(bool waitForMerges=true);
 
+  /**
+   * Waits for all pending and running merges to finish, and
+   * rethrows the first exception hit by a merge running in the
+   * background since the last call, if any.
+   */
+  void waitForMerges();
+
   /**
    * Requests an "optimize" operation on an index, priming the index
    * for the fastest available search. Traditionally this has meant
@@ -910,6 +971,28 @@ public:
    */
   void flush();
 
+  /**
+   * Returns a read-only reader of the documents added and deleted with this
+   * writer so far, without committing them (near real-time search). The
+   * buffered documents and deletes are flushed to new segments, but no
+   * segments file is written.
+   * <p>Reopening the returned reader with {@link IndexReader#reopen()} opens
+   * only the segments flushed or merged since, and it is current (see
+   * {@link IndexReader#isCurrent()}) until this writer changes the index
+   * again. The files of the reader are kept until it is closed, even if
+   * its segments were merged away meanwhile. The reader cannot delete
+   * documents or set norms: do this with the writer. Once this writer is
+   * closed the reader behaves like one opened on the directory, and it
+   * must be closed and deleted by the caller either way.
+   * <p>From the first call on, this writer keeps the readers of the segments
+   * it uses for merges and deletions open. The readers returned here are
+   * clones of them, which share their files, term indexes and unchanged
+   * norms.
+   * @throws CorruptIndexException if the index is corrupt
+   * @throws IOException if there is a low-level IO error
+   */
+  IndexReader* getReader();
+
   /**
    * Adds a document to this index.  If the document contains more than
    * {@link #setMaxFieldLength(int)} terms for a given field, the remainder are
@@ -1107,6 +1190,22 @@ private:
   friend class LockWith2;
   friend class LockWithCFS;
   friend class DocumentsWriter;
+  friend class DirectoryIndexReader;
+
+  /** True if nothing changed since the reader of getReader() was (re)opened */
+  bool isReaderCurrent(DirectoryIndexReader* reader);
+
+  /** Releases the files of a reader of getReader() that is being closed */
+  void readerClosed(DirectoryIndexReader* reader);
+
+  /** Disconnects the readers of getReader() when this writer goes away */
+  void detachReaders();
+
+  /** Guards the writer of the readers of getReader(): a reader only
+  * calls into its writer while holding it, and detachReaders() takes it
+  * before the writer's own lock, so a reader never reaches a writer that
+  * is gone */
+  STATIC_DEFINE_MUTEX(READERS_LOCK)
 
   /** Merges all RAM-resident segments. */
   void flushRamSegments();
@@ -183,6 +183,7 @@ LogMergePolicy::LogMergePolicy()
     this->_useCompoundDocStore = true;
     this->writer = NULL;
     this->minMergeSize = this->maxMergeSize = 0;
+    this->maxMergeSizeForOptimize = LUCENE_INT64_MAX_SHOULDBE;
 }
 
 void LogMergePolicy::setMergeFactor(int32_t mergeFactor)
@@ -260,7 +261,21 @@ MergePolicy::MergeSpecification* LogMergePolicy::findMergesForOptimize(SegmentIn
             }
         }
 
-        if (last > 0)
+        bool anyTooLarge = false;
+        for (int32_t i = 0; i < last; i++)
+        {
+            if ((uint64_t) size(infos->info(i)) > maxMergeSizeForOptimize)
+            {
+                anyTooLarge = true;
+                break;
+            }
+        }
+
+        if (last > 0 && anyTooLarge)
+        {
+            spec = findMergesForOptimizeSizeLimit(infos, writer, last);
+        }
+        else if (last > 0)
         {
             spec = _CLNEW MergeSpecification();
 
@@ -336,6 +351,52 @@ MergePolicy::MergeSpecification* LogMergePolicy::findMergesForOptimize(SegmentIn
     return spec;
 }
 
+MergePolicy::MergeSpecification* LogMergePolicy::findMergesForOptimizeSizeLimit(SegmentInfos* infos, IndexWriter* writer, int32_t last)
+{
+    MergeSpecification* spec = _CLNEW MergeSpecification();
+
+    // Walk backwards from the newest segment, merging
+    // mergeFactor segments at a time and stopping each run at
+    // a segment that is too large to be merged:
+    int32_t start = last - 1;
+    while (start >= 0)
+    {
+        SegmentInfo* info = infos->info(start);
+        if ((uint64_t) size(info) > maxMergeSizeForOptimize)
+        {
+            // Merge the segments to the right of this one,
+            // unless that is a single optimized segment:
+            if (last - start - 1 > 1 || (start != last - 1 && !isOptimized(writer, infos->info(start + 1))))
+            {
+                SegmentInfos* range = _CLNEW SegmentInfos;
+                infos->range(start + 1, last, *range);
+                spec->add(_CLNEW OneMerge(range, _useCompoundFile));
+            }
+            last = start;
+        }
+        else if (last - start == mergeFactor)
+        {
+            SegmentInfos* range = _CLNEW SegmentInfos;
+            infos->range(start, last, *range);
+            spec->add(_CLNEW OneMerge(range, _useCompoundFile));
+            last = start;
+        }
+        --start;
+    }
+
+    // Whatever is left at the start of the index:
+    if (last > 0 && (last > 1 || !isOptimized(writer, infos->info(0))))
+    {
+        SegmentInfos* range = _CLNEW SegmentInfos;
+        infos->range(0, last, *range);
+        spec->add(_CLNEW OneMerge(range, _useCompoundFile));
+    }
+
+    if (spec->merges->size() == 0)
+        _CLDELETE(spec);
+    return spec;
+}
+
 MergePolicy::MergeSpecification* LogMergePolicy::findMerges(SegmentInfos* infos, IndexWriter* writer)
 {
 
@@ -425,19 +486,38 @@ MergePolicy::MergeSpecification* LogMergePolicy::findMerges(SegmentInfos* infos,
                 anyTooLarge |= (size(info) >= maxMergeSize || info->docCount >= maxMergeDocs);
             }
 
+            // Don't let the merged segment grow past
+            // maxMergeSize: leave the trailing segments for the
+            // next merge on this level instead.
+            int32_t mergeEnd = end;
             if (!anyTooLarge)
+            {
+                uint64_t mergeSize = 0;
+                mergeEnd = start;
+                while (mergeEnd < end && mergeSize + size(infos->info(mergeEnd)) <= maxMergeSize)
+                    mergeSize += size(infos->info(mergeEnd++));
+            }
+
+            if (anyTooLarge)
+            {
+                MESSAGE(std::wstring(L"    ") + Misc::toString(start) + L" to " + Misc::toString(end) + L": contains segment over maxMergeSize or maxMergeDocs; skipping");
+                start = end;
+            }
+            else if (mergeEnd - start < 2)
+            {
+                MESSAGE(std::wstring(L"    ") + Misc::toString(start) + L" to " + Misc::toString(end) + L": merged segment would be over maxMergeSize; skipping");
+                start = end;
+            }
+            else
             {
                 if (spec == NULL)
                     spec = _CLNEW MergeSpecification();
-                MESSAGE(std::wstring(L"    ") + Misc::toString(start) + L" to " + Misc::toString(end) + L": add this merge");
+                MESSAGE(std::wstring(L"    ") + Misc::toString(start) + L" to " + Misc::toString(mergeEnd) + L": add this merge");
                 SegmentInfos* range = _CLNEW SegmentInfos;
-                infos->range(start, end, *range);
+                infos->range(start, mergeEnd, *range);
                 spec->add(_CLNEW OneMerge(range, _useCompoundFile));
+                start = mergeEnd;
             }
-            else
-                MESSAGE(std::wstring(L"    ") + Misc::toString(start) + L" to " + Misc::toString(end) + L": contains segment over maxMergeSize or maxMergeDocs; skipping");
-
-            start = end;
             end = start + mergeFactor;
         }
 
@@ -585,6 +665,16 @@ float_t LogByteSizeMergePolicy::getMinMergeMB()
     return ((float_t) minMergeSize) / 1024 / 1024;
 }
 
+void LogByteSizeMergePolicy::setMaxMergeMBForOptimize(float_t mb)
+{
+    maxMergeSizeForOptimize = (uint64_t) (mb * 1024 * 1024);
+}
+
+float_t LogByteSizeMergePolicy::getMaxMergeMBForOptimize()
+{
+    return ((float_t) maxMergeSizeForOptimize) / 1024 / 1024;
+}
+
 const std::wstring LogByteSizeMergePolicy::getClassName()
 {
     return L"LogByteSizeMergePolicy";
@@ -223,11 +223,18 @@ class CLUCENE_EXPORT LogMergePolicy : public MergePolicy
      *  writer, and matches the current compound file setting */
     bool isOptimized(IndexWriter* writer, SegmentInfo* info);
 
+    /** Returns the merges to optimize the segments before last
+     *  when some of them are over maxMergeSizeForOptimize.
+     *  Those segments are left alone, and the runs of segments
+     *  between them are merged, mergeFactor at a time. */
+    MergeSpecification* findMergesForOptimizeSizeLimit(SegmentInfos* infos, IndexWriter* writer, int32_t last);
+
 
 protected:
     virtual int64_t size(SegmentInfo* info) = 0;
     int64_t minMergeSize;
     uint64_t maxMergeSize;
+    uint64_t maxMergeSizeForOptimize;
 
 public:
     LogMergePolicy();
@@ -298,7 +305,11 @@ public:
      *  compound file format if the current useCompoundFile
      *  setting is true.  This method returns multiple merges
      *  (mergeFactor at a time) so the {@link MergeScheduler}
-     *  in use may make use of concurrency. */
+     *  in use may make use of concurrency.  Segments larger
+     *  than the optimize size limit (see {@link
+     *  LogByteSizeMergePolicy#setMaxMergeMBForOptimize}) are
+     *  left as they are, so the index may be left with more
+     *  than maxSegmentCount segments. */
     MergeSpecification* findMergesForOptimize(SegmentInfos* segmentInfos,
         IndexWriter* writer,
         int32_t maxSegmentCount,
@@ -310,7 +321,10 @@ public:
      *  #setMergeFactor} segments at a given level.  When
      *  multiple levels have too many segments, this method
      *  will return multiple merges, allowing the {@link
-     *  MergeScheduler} to use concurrency. */
+     *  MergeScheduler} to use concurrency.  A merge is cut
+     *  short so that the merged segment is not over the max
+     *  merge size; the segments left out are considered for
+     *  the next merge on the same level. */
     MergeSpecification* findMerges(SegmentInfos* infos, IndexWriter* writer);
 
     /** <p>Determines the largest segment (measured by
@@ -409,7 +423,10 @@ public:
      *
      *  <p>Note that {@link #setMaxMergeDocs} is also
      *  used to check whether a segment is too large for
-     *  merging (it's either or).</p>*/
+     *  merging (it's either or).</p>
+     *
+     *  <p>No merge selected by {@link #findMerges} produces a
+     *  segment larger than this.</p>*/
     void setMaxMergeMB(float_t mb);
 
     /** Returns the largest segment (meaured by total byte
@@ -434,6 +451,22 @@ public:
      *  @see #setMinMergeMB **/
     float_t getMinMergeMB();
 
+    /** <p>Determines the largest segment (measured by total
+     *  byte size of the segment's files, in MB) that
+     *  IndexWriter::optimize will merge. Larger segments are
+     *  left untouched, which bounds the I/O and the temporary
+     *  disk space an optimize needs once the index holds some
+     *  very large segments.</p>
+     *
+     *  <p>By default there is no limit.</p>*/
+    void setMaxMergeMBForOptimize(float_t mb);
+
+    /** Returns the largest segment (measured by total byte
+     *  size of the segment's files, in MB) that optimize will
+     *  merge.
+     *  @see #setMaxMergeMBForOptimize */
+    float_t getMaxMergeMBForOptimize();
+
     static const std::wstring getClassName();
     virtual const std::wstring getObjectName() const;
 };
@@ -9,7 +9,12 @@
 #include "CLucene/_ApiHeader.h"
 #include "MergeScheduler.h"
 #include "IndexWriter.h"
+#include "_SegmentInfos.h"
+#include "CLucene/util/Misc.h"
+#include <map>
+#include <vector>
 
+CL_NS_USE(util)
 
 CL_NS_DEF(index)
 
@@ -33,4 +38,248 @@ void SerialMergeScheduler::merge(IndexWriter* writer){
 
 void SerialMergeScheduler::close() {}
 
+void MergeScheduler::sync() {}
+
+
+class ConcurrentMergeScheduler::Internal{
+public:
+  // merges waiting for a thread, keyed by their size in bytes. Equal
+  // keys keep their insertion order, so merges of the same size are
+  // started first come, first served.
+  typedef std::multimap<int64_t, MergePolicy::OneMerge*> QueueType;
+  QueueType queue;
+
+  int32_t maxThreadCount;
+  int32_t maxPendingMerges;
+  int32_t threadCount;
+
+  // the threads which are running, by the slot they were started in,
+  // and those which have exited but were not joined yet
+  typedef std::map<int32_t, _LUCENE_THREADID_TYPE> ThreadsType;
+  ThreadsType threads;
+  std::vector<_LUCENE_THREADID_TYPE> exitedThreads;
+  int32_t nextSlot;
+
+  bool hasError;
+  CLuceneError error;
+
+  Internal():
+    maxThreadCount(3),
+    maxPendingMerges(3),
+    threadCount(0),
+    nextSlot(0),
+    hasError(false)
+  {
+  }
+
+  // the exited threads have given up the lock for good, so they can be
+  // joined while holding it
+  void joinExitedThreads(){
+    for ( size_t i = 0; i < exitedThreads.size(); i++ )
+      _LUCENE_THREAD_JOIN(exitedThreads[i]);
+    exitedThreads.clear();
+  }
+};
+
+struct MergeThreadArgs{
+  ConcurrentMergeScheduler* scheduler;
+  IndexWriter* writer;
+  MergePolicy::OneMerge* merge;
+  int32_t slot;
+};
+
+static bool anyUnhandledMergeExceptions = false;
+
+ConcurrentMergeScheduler::ConcurrentMergeScheduler():
+  _internal(_CLNEW Internal)
+{
+}
+
+ConcurrentMergeScheduler::~ConcurrentMergeScheduler(){
+  close();
+  _CLDELETE(_internal);
+}
+
+const std::wstring ConcurrentMergeScheduler::getObjectName() const{
+  return getClassName();
+}
+const std::wstring ConcurrentMergeScheduler::getClassName(){
+  return L"ConcurrentMergeScheduler";
+}
+
+void ConcurrentMergeScheduler::setMaxThreadCount(int32_t count){
+  if (count < 1)
+    _CLTHROWA(CL_ERR_IllegalArgument, "count should be at least 1");
+  SCOPED_LOCK_MUTEX(THIS_LOCK)
+  _internal->maxThreadCount = count;
+}
+int32_t ConcurrentMergeScheduler::getMaxThreadCount() const{
+  return _internal->maxThreadCount;
+}
+
+void ConcurrentMergeScheduler::setMaxPendingMerges(int32_t count){
+  if (count < 0)
+    _CLTHROWA(CL_ERR_IllegalArgument, "count should be at least 0");
+  SCOPED_LOCK_MUTEX(THIS_LOCK)
+  _internal->maxPendingMerges = count;
+  CONDITION_NOTIFYALL(THIS_WAIT_CONDITION)
+}
+int32_t ConcurrentMergeScheduler::getMaxPendingMerges() const{
+  return _internal->maxPendingMerges;
+}
+
+int32_t ConcurrentMergeScheduler::mergeThreadCount(){
+  SCOPED_LOCK_MUTEX(THIS_LOCK)
+  return _internal->threadCount;
+}
+
+void ConcurrentMergeScheduler::merge(IndexWriter* writer){
+  while(true) {
+    // getNextMerge takes the writer's lock, so don't hold ours
+    MergePolicy::OneMerge* merge = writer->getNextMerge();
+    if (merge == NULL)
+      break;
+
+    int64_t size = 0;
+    const int32_t numSegments = merge->segments->size();
+    for (int32_t i = 0; i < numSegments; i++)
+      size += merge->segments->info(i)->sizeInBytes();
+
+    SCOPED_LOCK_MUTEX(THIS_LOCK)
+    _internal->joinExitedThreads();
+    if (_internal->threadCount < _internal->maxThreadCount) {
+      MergeThreadArgs* args = _CLNEW MergeThreadArgs;
+      args->scheduler = this;
+      args->writer = writer;
+      args->merge = merge;
+      const int32_t slot = args->slot = _internal->nextSlot++;
+      _internal->threadCount++;
+      if ( writer->getInfoStream() != NULL )
+        writer->message(L"CMS: launch new thread, size=" + Misc::toString(size) +
+          L" merge=" + merge->segString(writer->getDirectory()));
+      // the thread can't exit before we let go of the lock, so its slot
+      // is filled in before it is moved to exitedThreads. It owns args
+      // from here on, so don't read them again.
+      _internal->threads[slot] = _LUCENE_THREAD_CREATE(&mergeThread, args);
+    }else{
+      _internal->queue.insert(Internal::QueueType::value_type(size, merge));
+
+      // Stall the caller until a thread frees up, so that
+      // merges can't fall ever further behind:
+      while ( (int32_t)_internal->queue.size() > _internal->maxPendingMerges ){
+        if ( writer->getInfoStream() != NULL )
+          writer->message(L"CMS: too many merges queued (" + Misc::toString((int32_t)_internal->queue.size()) + L"); stalling");
+        CONDITION_WAIT(THIS_LOCK, THIS_WAIT_CONDITION)
+      }
+    }
+  }
+}
+
+MergePolicy::OneMerge* ConcurrentMergeScheduler::nextQueuedMerge(IndexWriter* writer, int32_t slot){
+  {
+    SCOPED_LOCK_MUTEX(THIS_LOCK)
+    if ( !_internal->queue.empty() ){
+      Internal::QueueType::iterator itr = _internal->queue.begin();
+      MergePolicy::OneMerge* merge = itr->second;
+      _internal->queue.erase(itr);
+      CONDITION_NOTIFYALL(THIS_WAIT_CONDITION)
+      return merge;
+    }
+  }
+
+  MergePolicy::OneMerge* merge = writer->getNextMerge();
+  if ( merge != NULL )
+    return merge;
+
+  // The thread only exits once both queues are empty. Check ours
+  // again under the lock, since merge() only starts a new thread
+  // when fewer than maxThreadCount are alive.
+  SCOPED_LOCK_MUTEX(THIS_LOCK)
+  if ( !_internal->queue.empty() ){
+    Internal::QueueType::iterator itr = _internal->queue.begin();
+    merge = itr->second;
+    _internal->queue.erase(itr);
+  }else{
+    _internal->threadCount--;
+    Internal::ThreadsType::iterator itr = _internal->threads.find(slot);
+    _internal->exitedThreads.push_back(itr->second);
+    _internal->threads.erase(itr);
+  }
+  CONDITION_NOTIFYALL(THIS_WAIT_CONDITION)
+  return merge;
+}
+
+void ConcurrentMergeScheduler::runMerges(IndexWriter* writer, MergePolicy::OneMerge* merge, int32_t slot){
+  while ( merge != NULL ){
+    try{
+      writer->merge(merge);
+    }catch(CLuceneError& err){
+      // the writer has already recorded the exception with the
+      // merge. Aborted merges are expected when the writer is
+      // closed without waiting for them.
+      if ( err.number() != CL_ERR_MergeAborted ){
+        if ( writer->getInfoStream() != NULL )
+          writer->message(std::wstring(L"CMS: merge thread hit exception: ") + err.twhat());
+        handleMergeException(err);
+      }
+    }catch(...){
+      // don't let anything escape the thread, or the thread
+      // count is never decremented
+      handleMergeException(CLuceneError(CL_ERR_Runtime, "unknown exception in merge thread", false));
+    }
+    merge = nextQueuedMerge(writer, slot);
+  }
+}
+
+void ConcurrentMergeScheduler::mergeThread(void* arg){
+  MergeThreadArgs* args = (MergeThreadArgs*)arg;
+  ConcurrentMergeScheduler* scheduler = args->scheduler;
+  IndexWriter* writer = args->writer;
+  MergePolicy::OneMerge* merge = args->merge;
+  const int32_t slot = args->slot;
+  _CLDELETE(args);
+
+  scheduler->runMerges(writer, merge, slot);
+}
+
+void ConcurrentMergeScheduler::handleMergeException(const CLuceneError& error){
+  SCOPED_LOCK_MUTEX(THIS_LOCK)
+  anyUnhandledMergeExceptions = true;
+  if ( !_internal->hasError ){
+    CLuceneError tmp(error);
+    _internal->error.set(tmp.number(), tmp.twhat());
+    _internal->hasError = true;
+  }
+}
+
+void ConcurrentMergeScheduler::sync(){
+  SCOPED_LOCK_MUTEX(THIS_LOCK)
+  while ( _internal->threadCount > 0 ){
+    CONDITION_WAIT(THIS_LOCK, THIS_WAIT_CONDITION)
+  }
+  _internal->joinExitedThreads();
+  if ( _internal->hasError ){
+    _internal->hasError = false;
+    CLuceneError err(_internal->error.number(),
+      (std::wstring(L"background merge hit exception: ") + _internal->error.twhat()).c_str(), false);
+    throw err;
+  }
+}
+
+void ConcurrentMergeScheduler::close(){
+  SCOPED_LOCK_MUTEX(THIS_LOCK)
+  while ( _internal->threadCount > 0 ){
+    CONDITION_WAIT(THIS_LOCK, THIS_WAIT_CONDITION)
+  }
+  _internal->joinExitedThreads();
+  _internal->hasError = false;
+}
+
+bool ConcurrentMergeScheduler::anyUnhandledExceptions(){
+  return anyUnhandledMergeExceptions;
+}
+void ConcurrentMergeScheduler::clearUnhandledExceptions(){
+  anyUnhandledMergeExceptions = false;
+}
+
 CL_NS_END
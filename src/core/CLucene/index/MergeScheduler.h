@@ -11,6 +11,7 @@
 
 #include "CLucene/util/Equators.h"
 #include "CLucene/LuceneThreads.h"
+#include "MergePolicy.h"
 CL_NS_DEF(index)
 
 class IndexWriter;
@@ -18,7 +19,9 @@ class IndexWriter;
 /** Expert: {@link IndexWriter} uses an instance
  *  implementing this interface to execute the merges
  *  selected by a {@link MergePolicy}.  The default
- *  MergeScheduler is {@link ConcurrentMergeScheduler}.
+ *  MergeScheduler is {@link SerialMergeScheduler}; use
+ *  {@link ConcurrentMergeScheduler} to run merges in the
+ *  background.
  * <p><b>NOTE:</b> This API is new and still experimental
  * (subject to change suddenly in the next release)</p>
 */
@@ -29,6 +32,12 @@ public:
 
   /** Close this MergeScheduler. */
   virtual void close() = 0;
+
+  /** Waits until the merges this scheduler started in the background are
+   *  done, and rethrows the first exception one of them hit. IndexWriter
+   *  calls this when it waits for merges. The default does nothing, for
+   *  schedulers which run merges in the thread asking for them. */
+  virtual void sync();
 };
 
 /** A {@link MergeScheduler} that simply does each merge
@@ -47,6 +56,91 @@ public:
   static const std::wstring getClassName();
 };
 
+/** A {@link MergeScheduler} that runs each merge using a
+ *  separate thread, up until a maximum number of threads
+ *  ({@link #setMaxThreadCount}) at which point merges are
+ *  queued. Queued merges are started smallest first, so a
+ *  large cascading merge does not hold up the small merges
+ *  that keep the segment count down. Once more than
+ *  {@link #setMaxPendingMerges} merges are queued, the
+ *  thread asking for merges (typically one calling
+ *  IndexWriter::addDocument) is stalled until a merge
+ *  thread picks one up.
+ *
+ *  <p>Exceptions hit by a merge thread are recorded with the
+ *  {@link IndexWriter}, so that IndexWriter::optimize can forward
+ *  them, and are passed to {@link #handleMergeException}, so
+ *  that IndexWriter::close and IndexWriter::waitForMerges
+ *  rethrow them. Aborted merges (as happen when the writer is
+ *  closed without waiting for merges) are ignored.</p>
+ */
+class CLUCENE_EXPORT ConcurrentMergeScheduler: public MergeScheduler {
+private:
+  class Internal;
+  Internal* _internal;
+
+  static void mergeThread(void* arg);
+  MergePolicy::OneMerge* nextQueuedMerge(IndexWriter* writer, int32_t slot);
+  void runMerges(IndexWriter* writer, MergePolicy::OneMerge* merge, int32_t slot);
+public:
+  DEFINE_MUTEX(THIS_LOCK)
+  DEFINE_CONDITION(THIS_WAIT_CONDITION)
+
+  ConcurrentMergeScheduler();
+  virtual ~ConcurrentMergeScheduler();
+
+  /** Sets the max # simultaneous threads that may be
+   *  running.  If a merge is necessary yet we already have
+   *  this many threads running, the merge is queued. */
+  void setMaxThreadCount(int32_t count);
+
+  /** Get the max # simultaneous threads that may be
+   *  running. @see #setMaxThreadCount. */
+  int32_t getMaxThreadCount() const;
+
+  /** Sets the max # of merges that may wait for a free
+   *  thread before {@link #merge} stalls the calling thread.
+   *  0 means the caller stalls as soon as all threads are
+   *  busy. */
+  void setMaxPendingMerges(int32_t count);
+
+  /** @see #setMaxPendingMerges */
+  int32_t getMaxPendingMerges() const;
+
+  /** Returns the number of merge threads that are alive. */
+  int32_t mergeThreadCount();
+
+  /** Starts threads for the merges provided by {@link
+   *  IndexWriter#getNextMerge()} and returns once they are
+   *  all running or queued. */
+  void merge(IndexWriter* writer);
+
+  /** Waits until all running and queued merges are done.
+   *  Rethrows the first exception hit by a merge thread since
+   *  the last call, if any. */
+  void sync();
+
+  /** Waits for all merge threads to exit. Exceptions hit by
+   *  the merge threads are not rethrown. Called by the
+   *  destructor, so no thread outlives the scheduler. */
+  void close();
+
+  /** Returns true if any merge thread has hit an exception
+   *  (other than an aborted merge) since the last call to
+   *  {@link #clearUnhandledExceptions}. Used by tests. */
+  static bool anyUnhandledExceptions();
+  static void clearUnhandledExceptions();
+
+  const std::wstring getObjectName() const;
+  static const std::wstring getClassName();
+
+protected:
+  /** Called by a merge thread when its merge hit an
+   *  exception. The default implementation records the
+   *  exception so that the next {@link #sync} rethrows it. */
+  virtual void handleMergeException(const CLuceneError& error);
+};
+
 
 CL_NS_END
 #endif
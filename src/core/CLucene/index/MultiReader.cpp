@@ -18,6 +18,7 @@
 #include "_SegmentHeader.h"
 #include "_SegmentMergeInfo.h"
 #include "_SegmentMergeQueue.h"
+#include "_DocValues.h"
 
 CL_NS_USE(store)
 CL_NS_USE(document)
@@ -30,6 +31,7 @@ class MultiReader::Internal : LUCENE_BASE
 {
 public:
     MultiSegmentReader::NormsCacheType normsCache;
+    MultiDocValues* docValues;
 
     bool* closeOnClose; //remember which subreaders to close on close
     bool _hasDeletions;
@@ -45,9 +47,11 @@ public:
         ones = NULL;
         _hasDeletions = false;
         closeOnClose = NULL;
+        docValues = NULL;
     }
     ~Internal()
     {
+        _CLDELETE(docValues);
         _CLDELETE_ARRAY(ones);
         _CLDELETE_ARRAY(closeOnClose);
     }
@@ -230,6 +234,13 @@ bool MultiReader::document(int32_t n, CL_NS(document)::Document& doc, const Fiel
     return (*subReaders)[i]->document(n - starts[i], doc, fieldSelector);	  // dispatch to segment reader
 }
 
+bool MultiReader::document(int32_t n, StoredFieldVisitor& visitor)
+{
+    ensureOpen();
+    int32_t i = readerIndex(n);			  // find segment num
+    return (*subReaders)[i]->document(n - starts[i], visitor);	  // dispatch to segment reader
+}
+
 bool MultiReader::isDeleted(const int32_t n)
 {
     // Don't call ensureOpen() here (it could affect performance)
@@ -276,6 +287,24 @@ uint8_t* MultiReader::norms(const wchar_t* field)
     return bytes;
 }
 
+NumericDocValues* MultiReader::getNumericDocValues(const wchar_t* field)
+{
+    SCOPED_LOCK_MUTEX(THIS_LOCK)
+        ensureOpen();
+    if (_internal->docValues == NULL)
+        _internal->docValues = _CLNEW MultiDocValues();
+    return _internal->docValues->getNumeric(field, subReaders, starts);
+}
+
+SortedDocValues* MultiReader::getSortedDocValues(const wchar_t* field)
+{
+    SCOPED_LOCK_MUTEX(THIS_LOCK)
+        ensureOpen();
+    if (_internal->docValues == NULL)
+        _internal->docValues = _CLNEW MultiDocValues();
+    return _internal->docValues->getSorted(field, subReaders, starts);
+}
+
 void MultiReader::norms(const wchar_t* field, uint8_t* result)
 {
     SCOPED_LOCK_MUTEX(THIS_LOCK)
@@ -375,7 +404,8 @@ void MultiReader::doCommit()
 void MultiReader::doClose()
 {
     SCOPED_LOCK_MUTEX(THIS_LOCK)
-        for (size_t i = 0; i < subReaders->length; i++)
+        _CLDELETE(_internal->docValues); // refers to the values of the subReaders
+    for (size_t i = 0; i < subReaders->length; i++)
         {
             if ((*subReaders)[i] == NULL) continue; //reopen may take some memory...
             if (_internal->closeOnClose[i])
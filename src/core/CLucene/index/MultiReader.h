@@ -92,10 +92,13 @@ public:
 	int32_t numDocs();
 	int32_t maxDoc() const;
   bool document(int32_t n, CL_NS(document)::Document& doc, const CL_NS(document)::FieldSelector* fieldSelector);
+  bool document(int32_t n, CL_NS(document)::StoredFieldVisitor& visitor);
 	bool isDeleted(const int32_t n);
 	bool hasDeletions() const;
 	uint8_t* norms(const wchar_t* field);
 	void norms(const wchar_t* field, uint8_t* result);
+	NumericDocValues* getNumericDocValues(const wchar_t* field);
+	SortedDocValues* getSortedDocValues(const wchar_t* field);
 	TermEnum* terms();
 	TermEnum* terms(const Term* term);
 
@@ -19,6 +19,7 @@
 #include "_SegmentMergeQueue.h"
 #include "MultiReader.h"
 #include "_MultiSegmentReader.h"
+#include "_DocValues.h"
 
 CL_NS_USE(document)
 CL_NS_USE(store)
@@ -49,7 +50,8 @@ void MultiSegmentReader::initialize(CL_NS(util)::ArrayBase<IndexReader*>* _subRe
 
 MultiSegmentReader::MultiSegmentReader(CL_NS(store)::Directory* directory, SegmentInfos* sis, bool closeDirectory) :
     DirectoryIndexReader(directory, sis, closeDirectory),
-    normsCache(NormsCacheType(true, true))
+    normsCache(NormsCacheType(true, true)),
+    docValues(NULL)
 {
     // To reduce the chance of hitting FileNotFound
     // (and having to retry), we open segments in
@@ -86,6 +88,15 @@ MultiSegmentReader::MultiSegmentReader(CL_NS(store)::Directory* directory, Segme
     initialize(readers);
 }
 
+MultiSegmentReader::MultiSegmentReader(CL_NS(store)::Directory* directory, SegmentInfos* sis, bool closeDirectory,
+    CL_NS(util)::ArrayBase<IndexReader*>* subReaders) :
+    DirectoryIndexReader(directory, sis, closeDirectory),
+    normsCache(NormsCacheType(true, true)),
+    docValues(NULL)
+{
+    initialize(subReaders);
+}
+
 /** This contructor is only used for {@link #reopen()} */
 MultiSegmentReader::MultiSegmentReader(
     CL_NS(store)::Directory* directory,
@@ -95,7 +106,8 @@ MultiSegmentReader::MultiSegmentReader(
     int32_t* oldStarts,
     NormsCacheType* oldNormsCache) :
     DirectoryIndexReader(directory, infos, closeDirectory),
-    normsCache(NormsCacheType(true, true))
+    normsCache(NormsCacheType(true, true)),
+    docValues(NULL)
 {
     // we put the old SegmentReaders in a map, that allows us
     // to lookup a reader using its segment name
@@ -111,6 +123,10 @@ MultiSegmentReader::MultiSegmentReader(
 
     ArrayBase<IndexReader*>* newReaders = _CLNEW ObjectArray<IndexReader>(infos->size());
 
+    // the old readers which were reused as they are: their slots in
+    // oldReaders are cleared, as they belong to this reader now
+    std::vector<bool> reused(oldReaders != NULL ? oldReaders->length : 0, false);
+
     for (int32_t i = infos->size() - 1; i >= 0; i--)
     {
         // find SegmentReader for this segment
@@ -142,7 +158,8 @@ MultiSegmentReader::MultiSegmentReader(
             if (newReader == (*newReaders)[i])
             {
                 // this reader is being re-used, so we take ownership of it...
-                oldReaders->values[i] = NULL;
+                reused[oldReaderIndex->second] = true;
+                oldReaders->values[oldReaderIndex->second] = NULL;
             }
 
             newReaders->values[i] = newReader;
@@ -182,6 +199,7 @@ MultiSegmentReader::MultiSegmentReader(
             wchar_t* field = it->first;
             if (!hasNorms(field))
             {
+                it++;
                 continue;
             }
             uint8_t* oldBytes = it->second;
@@ -194,7 +212,7 @@ MultiSegmentReader::MultiSegmentReader(
 
                 // this SegmentReader was not re-opened, we can copy all of its norms
                 if (oldReaderIndex != segmentReaders.end() &&
-                    ((*oldReaders)[oldReaderIndex->second] == (*subReaders)[i]
+                    (reused[oldReaderIndex->second]
                         || ((SegmentReader*) (*oldReaders)[oldReaderIndex->second])->_norms.get(field) == ((SegmentReader*) (*subReaders)[i])->_norms.get(field)))
                 {
                     // we don't have to synchronize here: either this constructor is called from a SegmentReader,
@@ -226,6 +244,7 @@ MultiSegmentReader::~MultiSegmentReader()
 
     _CLDELETE_ARRAY(ones);
     _CLDELETE_ARRAY(starts);
+    _CLDELETE(docValues);
 
     //Iterate through the subReaders and destroy each reader
     _CLDELETE(subReaders);
@@ -315,6 +334,13 @@ bool MultiSegmentReader::document(int32_t n, CL_NS(document)::Document& doc, con
     return (*subReaders)[i]->document(n - starts[i], doc, fieldSelector);	  // dispatch to segment reader
 }
 
+bool MultiSegmentReader::document(int32_t n, StoredFieldVisitor& visitor)
+{
+    ensureOpen();
+    int32_t i = readerIndex(n);			  // find segment num
+    return (*subReaders)[i]->document(n - starts[i], visitor);	  // dispatch to segment reader
+}
+
 bool MultiSegmentReader::isDeleted(const int32_t n)
 {
     // Don't call ensureOpen() here (it could affect performance)
@@ -356,6 +382,24 @@ uint8_t* MultiSegmentReader::norms(const wchar_t* field)
     return bytes;
 }
 
+NumericDocValues* MultiSegmentReader::getNumericDocValues(const wchar_t* field)
+{
+    SCOPED_LOCK_MUTEX(THIS_LOCK)
+        ensureOpen();
+    if (docValues == NULL)
+        docValues = _CLNEW MultiDocValues();
+    return docValues->getNumeric(field, subReaders, starts);
+}
+
+SortedDocValues* MultiSegmentReader::getSortedDocValues(const wchar_t* field)
+{
+    SCOPED_LOCK_MUTEX(THIS_LOCK)
+        ensureOpen();
+    if (docValues == NULL)
+        docValues = _CLNEW MultiDocValues();
+    return docValues->getSorted(field, subReaders, starts);
+}
+
 void MultiSegmentReader::norms(const wchar_t* field, uint8_t* result)
 {
     SCOPED_LOCK_MUTEX(THIS_LOCK)
@@ -503,7 +547,8 @@ void MultiSegmentReader::commitChanges()
 void MultiSegmentReader::doClose()
 {
     SCOPED_LOCK_MUTEX(THIS_LOCK)
-        for (size_t i = 0; i < subReaders->length; i++)
+        _CLDELETE(docValues); // refers to the values of the subReaders
+    for (size_t i = 0; i < subReaders->length; i++)
         {
             if ((*subReaders)[i] != NULL)
             {
@@ -666,6 +711,7 @@ void MultiTermDocs::seek(Term* tterm)
     base = 0;
     pointer = 0;
     current = NULL;
+    subMaxFreqs.clear();
 }
 
 bool MultiTermDocs::next()
@@ -744,6 +790,71 @@ bool MultiTermDocs::skipTo(const int32_t target)
     }
 }
 
+int32_t MultiTermDocs::maxFreq()
+{
+    if (term == NULL || subReaders == NULL)
+        return 0;
+    if (subMaxFreqs.empty())
+    {
+        for (size_t i = 0; i < subReaders->length; i++)
+        {
+            // sub readers behind the current one are positioned on the term already,
+            // the others are seeked again once they are reached
+            TermDocs* td = i < pointer ? (*readerTermDocs)[i] : termDocs((int32_t) i);
+            subMaxFreqs.push_back(td == NULL ? 0 : td->maxFreq());
+        }
+    }
+    int32_t ret = 0;
+    for (size_t i = 0; i < subMaxFreqs.size(); i++)
+    {
+        if (subMaxFreqs[i] < 0)
+            return -1;
+        ret = cl_max(ret, subMaxFreqs[i]);
+    }
+    return ret;
+}
+
+int32_t MultiTermDocs::docFreq()
+{
+    if (term == NULL || subReaders == NULL)
+        return 0;
+    int32_t ret = 0;
+    for (size_t i = 0; i < subReaders->length; i++)
+    {
+        // as in maxFreq(), the seek of a sub reader that was not reached
+        // yet is repeated from the TermInfo cache once it is reached
+        TermDocs* td = i < pointer ? (*readerTermDocs)[i] : termDocs((int32_t) i);
+        if (td == NULL)
+            continue;
+        const int32_t df = td->docFreq();
+        if (df < 0)
+            return -1;
+        ret += df;
+    }
+    return ret;
+}
+
+int32_t MultiTermDocs::maxFreqInBlock(const int32_t target, int32_t& blockEnd)
+{
+    const int32_t ret = maxFreq();
+    blockEnd = LUCENE_INT32_MAX_SHOULDBE;
+    if (subReaders == NULL)
+        return ret;
+
+    size_t i = 0;
+    while (i + 1 < subReaders->length && starts[i + 1] <= target)
+        i++;
+    const int32_t end = starts[i + 1] - 1;
+    if (current != NULL && i + 1 == pointer)
+    {
+        const int32_t f = current->maxFreqInBlock(target - base, blockEnd);
+        blockEnd = blockEnd == LUCENE_INT32_MAX_SHOULDBE ? end : cl_min(blockEnd + base, end);
+        return f;
+    }
+    blockEnd = end;
+    return i < subMaxFreqs.size() ? subMaxFreqs[i] : ret;
+}
+
 void MultiTermDocs::close()
 {
     //Func - Closes all MultiTermDocs managed by this instance
@@ -937,6 +1048,28 @@ bool MultiTermEnum::next()
 }
 
 
+bool MultiTermEnum::skipTo(Term* target)
+{
+    //the enumerations in the queue are already past the current term, so
+    //only those behind target have to skip
+    SegmentMergeInfo* top = queue->top();
+    while (top != NULL && target->compareTo(top->term) > 0)
+    {
+        queue->pop();
+        if (top->skipTo(target))
+        {
+            queue->put(top);
+        }
+        else
+        {
+            top->close();
+            _CLDELETE(top);
+        }
+        top = queue->top();
+    }
+    return next();
+}
+
 Term* MultiTermEnum::term(bool pointer)
 {
     if (pointer)
@@ -1031,6 +1164,12 @@ int32_t MultiTermPositions::nextPosition()
         return curAsTP->nextPosition();
 }
 
+void MultiTermPositions::nextPositions(int32_t* positions, const int32_t length)
+{
+    CND_PRECONDITION(current != NULL, L"current is NULL");
+    current->__asTermPositions()->nextPositions(positions, length);
+}
+
 int32_t MultiTermPositions::getPayloadLength() const
 {
     TermPositions* curAsTP = current->__asTermPositions();
@@ -0,0 +1,294 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "CLucene/_ApiHeader.h"
+#include "_PostingsCodec.h"
+
+#include "CLucene/store/Directory.h"
+#include "CLucene/store/IndexOutput.h"
+#include "IndexWriter.h"
+#include "_TermInfo.h"
+#include "_SkipListWriter.h"
+#include "_SegmentHeader.h"
+
+CL_NS_USE(store)
+CL_NS_USE(util)
+CL_NS_DEF(index)
+
+PostingsWriter::~PostingsWriter(){
+}
+
+
+VIntPostingsWriter::VIntPostingsWriter(Directory* directory, const std::wstring& segment,
+	const int32_t _skipInterval, const int32_t maxSkipLevels, const int32_t docCount):
+	freqOut(NULL), proxOut(NULL), skipListWriter(NULL), skipInterval(_skipInterval),
+	storePayloads(false), freqStart(0), proxStart(0), df(0), lastDoc(0), lastPosition(0),
+	lastPayloadLength(-1)
+{
+	try {
+		freqOut = directory->createOutput( (segment + L".frq").c_str() );
+		proxOut = directory->createOutput( (segment + L".prx").c_str() );
+		skipListWriter = _CLNEW DefaultSkipListWriter(skipInterval, maxSkipLevels, docCount, freqOut, proxOut);
+	} catch(CLuceneError& err) {
+		close();
+		throw err;
+	}
+}
+VIntPostingsWriter::~VIntPostingsWriter(){
+	close();
+}
+
+void VIntPostingsWriter::startTerm(const bool _storePayloads){
+	storePayloads = _storePayloads;
+	freqStart = freqOut->getFilePointer();
+	proxStart = proxOut->getFilePointer();
+	df = 0;
+	lastDoc = 0;
+	lastPayloadLength = -1;   // ensures that we write the first length
+	skipListWriter->resetSkip();
+}
+
+void VIntPostingsWriter::startDoc(const int32_t doc, const int32_t freq){
+	if ((++df % skipInterval) == 0) {
+		skipListWriter->setSkipData(lastDoc, storePayloads, lastPayloadLength);
+		skipListWriter->bufferSkip(df);
+	}
+	skipListWriter->addFreq(freq);
+
+	// use low bit to flag freq=1
+	const int32_t docCode = (doc - lastDoc) << 1;
+	lastDoc = doc;
+	if (freq == 1) {
+		freqOut->writeVInt(docCode | 1);
+	} else {
+		freqOut->writeVInt(docCode);
+		freqOut->writeVInt(freq);
+	}
+	lastPosition = 0;
+}
+
+void VIntPostingsWriter::addPosition(const int32_t position, const uint8_t* payload, const int32_t payloadLength){
+	const int32_t delta = position - lastPosition;
+	lastPosition = position;
+	if (storePayloads) {
+		if (payloadLength == lastPayloadLength) {
+			proxOut->writeVInt(delta * 2);
+		} else {
+			proxOut->writeVInt(delta * 2 + 1);
+			proxOut->writeVInt(payloadLength);
+			lastPayloadLength = payloadLength;
+		}
+		if (payloadLength > 0)
+			proxOut->writeBytes(payload, payloadLength);
+	} else {
+		proxOut->writeVInt(delta);
+	}
+}
+
+void VIntPostingsWriter::finishTerm(TermInfo* termInfo){
+	const int64_t skipPointer = skipListWriter->writeSkip(freqOut);
+	termInfo->set(df, freqStart, proxStart, (int32_t) (skipPointer - freqStart), skipListWriter->getMaxFreq());
+}
+
+void VIntPostingsWriter::close(){
+	if (freqOut != NULL) {
+		freqOut->close();
+		_CLDELETE(freqOut);
+	}
+	if (proxOut != NULL) {
+		proxOut->close();
+		_CLDELETE(proxOut);
+	}
+	_CLDELETE(skipListWriter);
+}
+
+
+BlockPostingsWriter::BlockPostingsWriter(Directory* directory, const std::wstring& segment,
+	const int32_t maxSkipLevels, const int32_t docCount):
+	freqOut(NULL), proxOut(NULL), skipListWriter(NULL),
+	storePayloads(false), freqStart(0), proxStart(0), df(0), lastDoc(0), blockMaxFreq(0),
+	termMaxFreq(0), docUpto(0), lastPosition(0), posUpto(0), payloadBytes(64), payloadUpto(0)
+{
+	try {
+		freqOut = directory->createOutput( (segment + L".frq").c_str() );
+		proxOut = directory->createOutput( (segment + L".prx").c_str() );
+		skipListWriter = _CLNEW BlockSkipListWriter(maxSkipLevels, docCount);
+	} catch(CLuceneError& err) {
+		close();
+		throw err;
+	}
+}
+BlockPostingsWriter::~BlockPostingsWriter(){
+	close();
+}
+
+void BlockPostingsWriter::startTerm(const bool _storePayloads){
+	storePayloads = _storePayloads;
+	freqStart = freqOut->getFilePointer();
+	proxStart = proxOut->getFilePointer();
+	df = 0;
+	lastDoc = 0;
+	blockMaxFreq = termMaxFreq = 0;
+	docUpto = posUpto = payloadUpto = 0;
+	skipListWriter->resetSkip(freqStart, proxStart);
+}
+
+void BlockPostingsWriter::startDoc(const int32_t doc, const int32_t freq){
+	if (df > 0 && docUpto == 0) {
+		// the first document of a block, the previous one is written
+		skipListWriter->setSkipData(lastDoc, freqOut->getFilePointer(), proxOut->getFilePointer(), posUpto, blockMaxFreq);
+		skipListWriter->bufferSkip(df);
+		blockMaxFreq = 0;
+	}
+
+	docDeltas[docUpto] = doc - lastDoc;
+	freqs[docUpto] = freq;
+	docUpto++;
+	df++;
+	lastDoc = doc;
+	if (freq > blockMaxFreq)
+		blockMaxFreq = freq;
+	if (freq > termMaxFreq)
+		termMaxFreq = freq;
+
+	if (docUpto == ForUtil::BLOCK_LENGTH) {
+		ForUtil::writeBlock(docDeltas, freqOut);
+		ForUtil::writeBlock(freqs, freqOut);
+		docUpto = 0;
+	}
+	lastPosition = 0;
+}
+
+void BlockPostingsWriter::addPosition(const int32_t position, const uint8_t* payload, const int32_t payloadLength){
+	posDeltas[posUpto] = position - lastPosition;
+	lastPosition = position;
+	if (storePayloads) {
+		payloadLengths[posUpto] = payloadLength;
+		if (payloadLength > 0) {
+			if (payloadBytes.length < (size_t)(payloadUpto + payloadLength))
+				payloadBytes.resize(cl_max((size_t)(payloadUpto + payloadLength), payloadBytes.length * 2));
+			memcpy(payloadBytes.values + payloadUpto, payload, payloadLength);
+			payloadUpto += payloadLength;
+		}
+	}
+	posUpto++;
+
+	if (posUpto == ForUtil::BLOCK_LENGTH)
+		writePositions();
+}
+
+void BlockPostingsWriter::writePositions(){
+	if (posUpto == ForUtil::BLOCK_LENGTH) {
+		proxOut->writeByte(0);
+		ForUtil::writeBlock(posDeltas, proxOut);
+		if (storePayloads)
+			ForUtil::writeBlock(payloadLengths, proxOut);
+	} else {
+		proxOut->writeByte((uint8_t) posUpto);
+		int32_t lastPayloadLength = -1;
+		for (int32_t i = 0; i < posUpto; i++) {
+			if (!storePayloads) {
+				proxOut->writeVInt(posDeltas[i]);
+			} else if (payloadLengths[i] == lastPayloadLength) {
+				proxOut->writeVInt(posDeltas[i] * 2);
+			} else {
+				proxOut->writeVInt(posDeltas[i] * 2 + 1);
+				proxOut->writeVInt(payloadLengths[i]);
+				lastPayloadLength = payloadLengths[i];
+			}
+		}
+	}
+	if (storePayloads) {
+		proxOut->writeVInt(payloadUpto);
+		proxOut->writeBytes(payloadBytes.values, payloadUpto);
+	}
+	posUpto = payloadUpto = 0;
+}
+
+void BlockPostingsWriter::finishTerm(TermInfo* termInfo){
+	// the last, incomplete block of documents
+	for (int32_t i = 0; i < docUpto; i++) {
+		const int32_t docCode = docDeltas[i] << 1;
+		if (freqs[i] == 1) {
+			freqOut->writeVInt(docCode | 1);
+		} else {
+			freqOut->writeVInt(docCode);
+			freqOut->writeVInt(freqs[i]);
+		}
+	}
+	if (posUpto > 0)
+		writePositions();
+
+	const int64_t skipPointer = skipListWriter->writeSkip(freqOut);
+	termInfo->set(df, freqStart, proxStart, (int32_t) (skipPointer - freqStart), termMaxFreq);
+}
+
+void BlockPostingsWriter::close(){
+	if (freqOut != NULL) {
+		freqOut->close();
+		_CLDELETE(freqOut);
+	}
+	if (proxOut != NULL) {
+		proxOut->close();
+		_CLDELETE(proxOut);
+	}
+	_CLDELETE(skipListWriter);
+}
+
+
+PostingsCodec::~PostingsCodec(){
+}
+
+class VIntPostingsCodec: public PostingsCodec {
+public:
+	int32_t getFormat() const{
+		return IndexWriter::POSTINGS_VINT;
+	}
+	PostingsWriter* newWriter(Directory* directory, const std::wstring& segment,
+		const int32_t skipInterval, const int32_t maxSkipLevels, const int32_t docCount){
+		return _CLNEW VIntPostingsWriter(directory, segment, skipInterval, maxSkipLevels, docCount);
+	}
+	TermDocs* newTermDocs(const SegmentReader* reader){
+		return _CLNEW SegmentTermDocs(reader);
+	}
+	TermPositions* newTermPositions(const SegmentReader* reader){
+		return _CLNEW SegmentTermPositions(reader);
+	}
+};
+
+class BlockPostingsCodec: public PostingsCodec {
+public:
+	int32_t getFormat() const{
+		return IndexWriter::POSTINGS_BLOCK;
+	}
+	PostingsWriter* newWriter(Directory* directory, const std::wstring& segment,
+		const int32_t /*skipInterval*/, const int32_t maxSkipLevels, const int32_t docCount){
+		return _CLNEW BlockPostingsWriter(directory, segment, maxSkipLevels, docCount);
+	}
+	TermDocs* newTermDocs(const SegmentReader* reader){
+		return _CLNEW BlockTermDocs(reader);
+	}
+	TermPositions* newTermPositions(const SegmentReader* reader){
+		return _CLNEW BlockTermPositions(reader);
+	}
+};
+
+PostingsCodec* PostingsCodec::forFormat(const int32_t format){
+	static VIntPostingsCodec vintCodec;
+	static BlockPostingsCodec blockCodec;
+	switch (format) {
+	case IndexWriter::POSTINGS_VINT:
+		return &vintCodec;
+	case IndexWriter::POSTINGS_BLOCK:
+		return &blockCodec;
+	default:
+		_CLTHROWA(CL_ERR_CorruptIndex, "Unknown postings format");
+	}
+}
+
+CL_NS_END
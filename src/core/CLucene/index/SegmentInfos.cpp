@@ -35,7 +35,8 @@ SegmentInfo::SegmentInfo(const wchar_t * _name, const int32_t _docCount, CL_NS(s
     _sizeInBytes(-1),
     docStoreOffset(_docStoreOffset),
     docStoreSegment(_docStoreSegment == NULL ? L"" : _docStoreSegment),
-    docStoreIsCompoundFile(_docStoreIsCompoundFile)
+    docStoreIsCompoundFile(_docStoreIsCompoundFile),
+    postingsFormat(0)
 {
     CND_PRECONDITION(docStoreOffset == -1 || !docStoreSegment.empty(), L"failed testing for (docStoreOffset == -1 || docStoreSegment != NULL)");
 
@@ -132,6 +133,14 @@ SegmentInfo::SegmentInfo(CL_NS(store)::Directory* _dir, int32_t format, CL_NS(st
         }
         isCompoundFile = input->readByte();
         preLockless = (isCompoundFile == CHECK_DIR);
+        if (format <= SegmentInfos::FORMAT_POSTINGS_CODEC)
+        {
+            postingsFormat = input->readByte();
+        }
+        else
+        {
+            postingsFormat = 0; // the vint format of the segments before
+        }
     }
     else
     {
@@ -142,6 +151,7 @@ SegmentInfo::SegmentInfo(CL_NS(store)::Directory* _dir, int32_t format, CL_NS(st
         hasSingleNormFile = false;
         docStoreOffset = -1;
         docStoreIsCompoundFile = false;
+        postingsFormat = 0;
     }
 }
 
@@ -174,6 +184,7 @@ void SegmentInfo::reset(const SegmentInfo* src)
     }
     isCompoundFile = src->isCompoundFile;
     hasSingleNormFile = src->hasSingleNormFile;
+    postingsFormat = src->postingsFormat;
 }
 
 SegmentInfo::~SegmentInfo()
@@ -433,6 +444,7 @@ SegmentInfo* SegmentInfo::clone()
     si->docStoreOffset = docStoreOffset;
     si->docStoreSegment = docStoreSegment;
     si->docStoreIsCompoundFile = docStoreIsCompoundFile;
+    si->postingsFormat = postingsFormat;
 
     return si;
 }
@@ -628,6 +640,13 @@ void SegmentInfo::setDocStoreOffset(const int32_t offset)
     clearFiles();
 }
 
+int32_t SegmentInfo::getPostingsFormat() const { return postingsFormat; }
+
+void SegmentInfo::setPostingsFormat(const int32_t format)
+{
+    postingsFormat = format;
+}
+
 void SegmentInfo::write(CL_NS(store)::IndexOutput* output)
 {
     output->writeString(name);
@@ -654,6 +673,7 @@ void SegmentInfo::write(CL_NS(store)::IndexOutput* output)
         }
     }
     output->writeByte(isCompoundFile);
+    output->writeByte(static_cast<uint8_t>(postingsFormat));
 }
 
 void SegmentInfo::clearFiles()
@@ -87,6 +87,17 @@ bool SegmentMergeInfo::next() {
 	}
 }
 
+bool SegmentMergeInfo::skipTo(Term* target) {
+	_CLDECDELETE(term);
+	if (termEnum->skipTo(target)) {
+		term = termEnum->term();
+		return true;
+	} else {
+		term = NULL;
+		return false;
+	}
+}
+
 void SegmentMergeInfo::close() {
 //Func - Closes the the resources
 //Pre  - true
@@ -18,8 +18,9 @@
 #include <assert.h>
 #include "CLucene/index/_IndexFileNames.h"
 #include "_CompoundFile.h"
-#include "_SkipListWriter.h"
+#include "_PostingsCodec.h"
 #include "CLucene/document/FieldSelector.h"
+#include "_DocValues.h"
 
 CL_NS_USE(util)
 CL_NS_USE(document)
@@ -31,14 +32,11 @@ const int SegmentMerger::NORMS_HEADER_length = 4;
 int32_t SegmentMerger::MAX_RAW_MERGE_DOCS = 4192;
 
 void SegmentMerger::init(){
-  skipListWriter   = NULL;
-  freqOutput       = NULL;
-  proxOutput       = NULL;
+  postingsWriter   = NULL;
   termInfosWriter  = NULL;
   queue            = NULL;
   fieldInfos       = NULL;
   checkAbort       = NULL;
-  skipInterval     = 0;
 }
 
 SegmentMerger::SegmentMerger(IndexWriter* writer, const wchar_t * name, MergePolicy::OneMerge* merge){
@@ -55,8 +53,9 @@ SegmentMerger::SegmentMerger(IndexWriter* writer, const wchar_t * name, MergePol
   if (merge != NULL)
     this->checkAbort = _CLNEW CheckAbort(merge, directory);
   this->termIndexInterval= writer->getTermIndexInterval();
+  this->storedFieldsCompression = writer->getStoredFieldsCompression();
+  this->postingsFormat = merge != NULL ? merge->info->getPostingsFormat() : writer->getPostingsFormat();
   this->mergedDocs = 0;
-  this->maxSkipLevels = 0;
 }
 
 SegmentMerger::~SegmentMerger(){
@@ -69,15 +68,10 @@ SegmentMerger::~SegmentMerger(){
 
 	//Delete field Infos
 	_CLDELETE(fieldInfos);
-	//Close and destroy the IndexOutput to the Frequency File
-	if (freqOutput != NULL){
-		freqOutput->close();
-		_CLDELETE(freqOutput);
-	}
-	//Close and destroy the IndexOutput to the Prox File
-	if (proxOutput != NULL){
-		proxOutput->close();
-		_CLDELETE(proxOutput);
+	//Close and destroy the Frequency and Prox Files
+	if (postingsWriter != NULL){
+		postingsWriter->close();
+		_CLDELETE(postingsWriter);
 	}
 	//Close and destroy the termInfosWriter
 	if (termInfosWriter != NULL){
@@ -91,7 +85,6 @@ SegmentMerger::~SegmentMerger(){
 	}
 
   _CLDELETE(checkAbort);
-  _CLDELETE(skipListWriter);
 
 }
 
@@ -132,6 +125,7 @@ int32_t SegmentMerger::merge(bool mergeDocStores) {
 
 	mergeTerms();
 	mergeNorms();
+	mergeDocValues();
 
 	if (mergeDocStores && fieldInfos->hasVectors())
 		mergeVectors();
@@ -139,13 +133,6 @@ int32_t SegmentMerger::merge(bool mergeDocStores) {
 	return mergedDocs;
 }
 
-void SegmentMerger::closeReaders(){
-  for (uint32_t i = 0; i < readers.size(); i++) {  // close readers
-      IndexReader* reader = readers[i];
-      reader->close();
-  }
-}
-
 void SegmentMerger::createCompoundFile(const wchar_t * filename, std::vector<std::wstring>* files){
   CompoundFileWriter* cfsWriter = _CLNEW CompoundFileWriter(directory, filename, checkAbort);
 
@@ -174,6 +161,10 @@ void SegmentMerger::createCompoundFile(const wchar_t * filename, std::vector<std
 		}
 	}
 
+  // Doc values file
+  if ( fieldInfos->hasDocValues() && directory->fileExists( (segment + L"." + IndexFileNames::DOC_VALUES_EXTENSION).c_str() ) )
+    files->push_back ( segment + L"." + IndexFileNames::DOC_VALUES_EXTENSION );
+
   // Vector files
   if ( mergeDocStores && fieldInfos->hasVectors()) {
     for (int32_t i = 0; i < IndexFileNames::VECTOR_EXTENSIONS().length; i++) {
@@ -230,7 +221,6 @@ int32_t SegmentMerger::mergeFields() {
     // with the fieldInfos of the last segment in this
     // case, to keep that numbering.
     assert(readers[readers.size()-1]->instanceOf(SegmentReader::getClassName()));
-    assert(false);//check last...and remove if correct...
     SegmentReader* sr = (SegmentReader*)readers[readers.size()-1];
     fieldInfos = sr->fieldInfos()->clone();
   } else {
@@ -255,7 +245,7 @@ int32_t SegmentMerger::mergeFields() {
         FieldInfo* fi = segmentReader->getFieldInfos()->fieldInfo(j);
         fieldInfos->add(fi->name, fi->isIndexed, fi->storeTermVector,
           fi->storePositionWithTermVector, fi->storeOffsetWithTermVector,
-          !reader->hasNorms(fi->name), fi->storePayloads);
+          !reader->hasNorms(fi->name), fi->storePayloads)->setDocValuesType(fi->docValuesType);
       }
     } else {
 	    StringArrayWithDeletor tmp;
@@ -285,6 +275,18 @@ int32_t SegmentMerger::mergeFields() {
 		    fieldInfos->add((const wchar_t**)arr, false);
 		    _CLDELETE_ARRAY(arr); //no need to delete the contents, since tmp is responsible for it
 	    }
+
+	    // other readers only tell about doc values when asked for them
+	    tmp.clear(); reader->getFieldNames(IndexReader::ALL, tmp);
+	    for ( StringArrayWithDeletor::const_iterator itr = tmp.begin(); itr != tmp.end(); ++itr ){
+	      uint8_t type = 0;
+	      if ( reader->getNumericDocValues(*itr) != NULL )
+	        type = FieldInfos::DOC_VALUES_NUMERIC;
+	      else if ( reader->getSortedDocValues(*itr) != NULL )
+	        type = FieldInfos::DOC_VALUES_SORTED;
+	      if ( type != 0 )
+	        fieldInfos->add(*itr, false)->setDocValuesType(type);
+	    }
     }
   }
 
@@ -322,7 +324,7 @@ int32_t SegmentMerger::mergeFields() {
     ValueArray<int32_t> rawDocLengths(MAX_RAW_MERGE_DOCS);
 
     // merge field values
-    FieldsWriter fieldsWriter(directory, segment.c_str(), fieldInfos);
+    FieldsWriter fieldsWriter(directory, segment.c_str(), fieldInfos, storedFieldsCompression);
 
     try {
       for (size_t i = 0; i < readers.size(); i++) {
@@ -333,12 +335,15 @@ int32_t SegmentMerger::mergeFields() {
           matchingFieldsReader = matchingSegmentReader->getFieldsReader();
         else
           matchingFieldsReader = NULL;
+        if (matchingFieldsReader != NULL && !matchingFieldsReader->canReadRawDocs())
+          matchingFieldsReader = NULL; // compressed blocks are read document by document
+
         const int32_t maxDoc = reader->maxDoc();
         Document doc;
         FieldSelectorMerge fieldSelectorMerge;
         for (int32_t j = 0; j < maxDoc;) {
           if (!reader->isDeleted(j)) { // skip deleted docs
-            if (matchingSegmentReader != NULL) {
+            if (matchingFieldsReader != NULL) {
               // We can optimize this case (doing a bulk
               // byte copy) since the field numbers are
               // identical
@@ -371,7 +376,7 @@ int32_t SegmentMerger::mergeFields() {
       fieldsWriter.close();
     )
 
-    CND_PRECONDITION (docCount*8 == directory->fileLength( (segment + L"." + IndexFileNames::FIELDS_INDEX_EXTENSION).c_str() ),
+    CND_PRECONDITION (fieldsWriter.indexHeaderLength() + docCount*8 == directory->fileLength( (segment + L"." + IndexFileNames::FIELDS_INDEX_EXTENSION).c_str() ),
     (std::wstring(L"after mergeFields: fdx size mismatch: ") + Misc::toString(docCount) + L" docs vs " + Misc::toString(directory->fileLength( (segment + L"." + IndexFileNames::FIELDS_INDEX_EXTENSION).c_str() )) + L" length in bytes of " + segment + L"." + IndexFileNames::FIELDS_INDEX_EXTENSION).c_str() );
 
   } else{
@@ -428,12 +433,6 @@ void SegmentMerger::mergeTerms() {
 	CND_PRECONDITION(fieldInfos != NULL, L"fieldInfos is NULL");
 
     try{
-      //Open an IndexOutput to the new Frequency File
-      freqOutput = directory->createOutput( Misc::segmentname(segment.c_str(),L".frq").c_str() );
-
-      //Open an IndexOutput to the new Prox File
-      proxOutput = directory->createOutput( Misc::segmentname(segment.c_str(),L".prx").c_str() );
-
       //Instantiate  a new termInfosWriter which will write in directory
       //for the segment name segment using the new merged fieldInfos
       termInfosWriter = _CLNEW TermInfosWriter(directory, segment.c_str(), fieldInfos, termIndexInterval);
@@ -441,21 +440,17 @@ void SegmentMerger::mergeTerms() {
       //Condition check to see if termInfosWriter points to a valid instance
       CND_CONDITION(termInfosWriter != NULL,L"Memory allocation for termInfosWriter failed")	;
 
-      skipInterval = termInfosWriter->skipInterval;
-      maxSkipLevels = termInfosWriter->maxSkipLevels;
-      skipListWriter = _CLNEW DefaultSkipListWriter(skipInterval, maxSkipLevels, mergedDocs, freqOutput, proxOutput);
+      //Open the new Frequency and Prox Files
+      postingsWriter = PostingsCodec::forFormat(postingsFormat)->newWriter(directory, segment,
+        termInfosWriter->skipInterval, termInfosWriter->maxSkipLevels, mergedDocs);
       queue = _CLNEW SegmentMergeQueue(readers.size());
 
       //And merge the Term Infos
       mergeTermInfos();
     }_CLFINALLY(
-      if ( freqOutput != NULL ){
-        freqOutput->close();
-        _CLDELETE(freqOutput);
-      }
-      if ( proxOutput != NULL ){
-        proxOutput->close();
-        _CLDELETE(proxOutput);
+      if ( postingsWriter != NULL ){
+        postingsWriter->close();
+        _CLDELETE(postingsWriter);
       }
       if ( termInfosWriter != NULL ){
         termInfosWriter->close();
@@ -579,28 +574,21 @@ int32_t SegmentMerger::mergeTermInfo( SegmentMergeInfo** smis, int32_t n){
 //Func - Merge the TermInfo of a term found in one or more segments.
 //Pre  - smis != NULL and it contains segments that are positioned at the same term.
 //       n is equal to the number of SegmentMergeInfo instances in smis
-//       freqOutput != NULL
-//       proxOutput != NULL
+//       postingsWriter != NULL
 //Post - The TermInfo of a term has been merged
 
 	CND_PRECONDITION(smis != NULL, L"smis is NULL");
-	CND_PRECONDITION(freqOutput != NULL, L"freqOutput is NULL");
-	CND_PRECONDITION(proxOutput != NULL, L"proxOutput is NULL");
-
-  //Get the file pointer of the IndexOutput to the Frequency File
-  int64_t freqPointer = freqOutput->getFilePointer();
-  //Get the file pointer of the IndexOutput to the Prox File
-  int64_t proxPointer = proxOutput->getFilePointer();
+	CND_PRECONDITION(postingsWriter != NULL, L"postingsWriter is NULL");
 
   //Process postings from multiple segments all positioned on the same term.
   int32_t df = appendPostings(smis, n);
 
-  int64_t skipPointer = skipListWriter->writeSkip(freqOutput);
+  //Finish the term, which sets df and the pointers to the freq and prox files of termInfo
+  postingsWriter->finishTerm(&termInfo);
 
   //df contains the number of documents across all segments where this term was found
   if (df > 0) {
     //add an entry to the dictionary with pointers to prox and freq files
-    termInfo.set(df, freqPointer, proxPointer, (int32_t)(skipPointer - freqPointer));
     //Precondition check for to be sure that the reference to
     //smis[0]->term will be valid
     CND_PRECONDITION(smis[0]->term != NULL, L"smis[0]->term is NULL");
@@ -613,24 +601,20 @@ int32_t SegmentMerger::mergeTermInfo( SegmentMergeInfo** smis, int32_t n){
 
 int32_t SegmentMerger::appendPostings(SegmentMergeInfo** smis, int32_t n){
 //Func - Process postings from multiple segments all positioned on the
-//       same term. Writes out merged entries into freqOutput and
-//       the proxOutput streams.
+//       same term. Writes out merged entries with the postingsWriter.
 //Pre  - smis != NULL and it contains segments that are positioned at the same term.
 //       n is equal to the number of SegmentMergeInfo instances in smis
-//       freqOutput != NULL
-//       proxOutput != NULL
+//       postingsWriter != NULL
 //Post - Returns number of documents across all segments where this term was found
 
   CND_PRECONDITION(smis != NULL, L"smis is NULL");
-  CND_PRECONDITION(freqOutput != NULL, L"freqOutput is NULL");
-  CND_PRECONDITION(proxOutput != NULL, L"proxOutput is NULL");
+  CND_PRECONDITION(postingsWriter != NULL, L"postingsWriter is NULL");
 
   int32_t lastDoc = 0;
   int32_t df = 0;       //Document Counter
 
-  skipListWriter->resetSkip();
   bool storePayloads = fieldInfos->fieldInfo(smis[0]->term->field())->storePayloads;
-  int32_t lastPayloadLength = -1;   // ensures that we write the first length
+  postingsWriter->startTerm(storePayloads);
 
   SegmentMergeInfo* smi = NULL;
 
@@ -665,58 +649,27 @@ int32_t SegmentMerger::appendPostings(SegmentMergeInfo** smis, int32_t n){
 
       //Increase the total frequency over all segments
       df++;
-
-      if ((df % skipInterval) == 0) {
-        skipListWriter->setSkipData(lastDoc, storePayloads, lastPayloadLength);
-        skipListWriter->bufferSkip(df);
-      }
-
-      //Calculate a new docCode
-      //use low bit to flag freq=1
-      int32_t docCode = (doc - lastDoc) << 1;
       lastDoc = doc;
 
       //Get the frequency of the Term
       int32_t freq = postings->freq();
-      if (freq == 1){
-        //write doc & freq=1
-        freqOutput->writeVInt(docCode | 1);
-      }else{
-        //write doc
-        freqOutput->writeVInt(docCode);
-        //write frequency in doc
-        freqOutput->writeVInt(freq);
-      }
+      postingsWriter->startDoc(doc, freq);
 
-      /** See {@link DocumentWriter#writePostings(Posting[], String)} for
-      *  documentation about the encoding of positions and payloads
-      */
-      int32_t lastPosition = 0;
-      // write position deltas
+      // write positions
       for (int32_t j = 0; j < freq; j++) {
         //Get the next position
         int32_t position = postings->nextPosition();
-        int32_t delta = position - lastPosition;
+        int32_t payloadLength = 0;
         if (storePayloads) {
-          size_t payloadLength = postings->getPayloadLength();
-          if (payloadLength == lastPayloadLength) {
-            proxOutput->writeVInt(delta * 2);
-          } else {
-            proxOutput->writeVInt(delta * 2 + 1);
-            proxOutput->writeVInt(payloadLength);
-            lastPayloadLength = payloadLength;
-          }
+          payloadLength = postings->getPayloadLength();
           if (payloadLength > 0) {
-          	if ( payloadBuffer.length < payloadLength ){
+          	if ( payloadBuffer.length < (size_t)payloadLength ){
               payloadBuffer.resize(payloadLength);
             }
             postings->getPayload(payloadBuffer.values);
-            proxOutput->writeBytes(payloadBuffer.values, payloadLength);
           }
-        } else {
-          proxOutput->writeVInt(delta);
         }
-        lastPosition = position;
+        postingsWriter->addPosition(position, payloadBuffer.values, payloadLength);
       }
     }
   }
@@ -725,6 +678,50 @@ int32_t SegmentMerger::appendPostings(SegmentMergeInfo** smis, int32_t n){
   return df;
 }
 
+void SegmentMerger::mergeDocValues() {
+  if (!fieldInfos->hasDocValues())
+    return;
+
+  DocValuesWriter writer;
+  for (size_t i = 0; i < fieldInfos->size(); i++) {
+    FieldInfo* fi = fieldInfos->fieldInfo(i);
+    if (fi->docValuesType == 0)
+      continue;
+
+    int32_t docBase = 0;
+    for (uint32_t j = 0; j < readers.size(); j++) {
+      IndexReader* reader = readers[j];
+      const int32_t maxDoc = reader->maxDoc();
+      const bool hasDeletions = reader->hasDeletions();
+      if (fi->docValuesType == FieldInfos::DOC_VALUES_NUMERIC) {
+        NumericDocValues* values = reader->getNumericDocValues(fi->name);
+        for (int32_t k = 0; k < maxDoc; k++) {
+          if (hasDeletions && reader->isDeleted(k))
+            continue;
+          if (values != NULL)
+            writer.addNumeric(fi, docBase, values->get(k));
+          docBase++;
+        }
+      } else {
+        SortedDocValues* values = reader->getSortedDocValues(fi->name);
+        for (int32_t k = 0; k < maxDoc; k++) {
+          if (hasDeletions && reader->isDeleted(k))
+            continue;
+          const int32_t ord = values == NULL ? 0 : values->getOrd(k);
+          if (ord != 0)
+            writer.addSorted(fi, docBase, values->lookup(ord));
+          docBase++;
+        }
+      }
+      if (checkAbort != NULL)
+        checkAbort->work(maxDoc);
+    }
+  }
+
+  if (writer.hasValues())
+    writer.write(directory, segment, mergedDocs);
+}
+
 void SegmentMerger::mergeNorms() {
 //Func - Merges the norms for all fields
 //Pre  - fieldInfos != NULL
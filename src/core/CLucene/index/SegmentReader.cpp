@@ -19,6 +19,8 @@
 #include "CLucene/store/FSDirectory.h"
 #include "CLucene/util/PriorityQueue.h"
 #include "_SegmentMerger.h"
+#include "_DocValues.h"
+#include "_PostingsCodec.h"
 #include <assert.h>
 
 CL_NS_USE(util)
@@ -27,10 +29,9 @@ CL_NS_USE(document)
 CL_NS_USE(search)
 CL_NS_DEF(index)
 
-SegmentReader::Norm::Norm(IndexInput* instrm, bool _useSingleNormStream, int32_t n, int64_t ns, SegmentReader* r, const wchar_t * seg) :
+SegmentReader::Norm::Norm(IndexInput* instrm, bool _useSingleNormStream, int32_t n, int64_t ns, const wchar_t * seg) :
     number(n),
     normSeek(ns),
-    _this(r),
     segment(seg),
     useSingleNormStream(_useSingleNormStream),
     in(instrm),
@@ -55,7 +56,8 @@ SegmentReader::Norm::~Norm()
 
         //Close and destroy the inputstream in-> The inputstream will be closed
         // by its destructor. Note that the IndexInput 'in' actually is a pointer!!!!!
-    if (in != _this->singleNormStream)
+        // The single norm stream belongs to the reader.
+    if (!useSingleNormStream)
         _CLDELETE(in);
 
     //Delete the bytes array
@@ -102,10 +104,10 @@ void SegmentReader::Norm::reWrite(SegmentInfo* si)
 {
     // NOTE: norms are re-written in regular directory, not cfs
     si->advanceNormGen(this->number);
-    IndexOutput* out = _this->directory()->createOutput(si->getNormFileName(this->number).c_str());
+    IndexOutput* out = si->dir->createOutput(si->getNormFileName(this->number).c_str());
     try
     {
-        out->writeBytes(bytes, _this->maxDoc());
+        out->writeBytes(bytes, si->docCount);
     }_CLFINALLY(
         out->close();
     _CLDELETE(out)
@@ -113,6 +115,162 @@ void SegmentReader::Norm::reWrite(SegmentInfo* si)
     this->dirty = false;
 }
 
+/** The files of a segment which do not change with its deletions and norms */
+class SegmentReader::Core : LUCENE_REFBASE
+{
+public:
+    DEFINE_MUTEX(THIS_LOCK)
+
+    std::wstring segment;
+    Directory* dir;
+    int32_t readBufferSize;
+
+    CompoundFileReader* cfsReader;
+    CompoundFileReader* storeCFSReader;
+    FieldInfos* fieldInfos;
+    TermInfosReader* tis;
+    IndexInput* freqStream;
+    IndexInput* proxStream;
+    TermVectorsReader* termVectorsReaderOrig;
+    DocValuesReader* docValues;
+    PostingsCodec* postingsCodec;
+    bool docStoresOpen;
+
+    Core(SegmentInfo* si, int32_t readBufferSize);
+    ~Core();
+
+    /** The directory of the files of the segment, which is the compound file if there is one */
+    Directory* cfsDir();
+
+    /** The directory of the stored fields and term vectors of si */
+    Directory* storeDir(SegmentInfo* si);
+
+    /** Opens the compound doc store and the term vectors, once */
+    void openDocStores(SegmentInfo* si);
+
+private:
+    void close();
+};
+
+SegmentReader::Core::Core(SegmentInfo* si, int32_t _readBufferSize) :
+    segment(si->name),
+    dir(si->dir),
+    readBufferSize(_readBufferSize),
+    cfsReader(NULL),
+    storeCFSReader(NULL),
+    fieldInfos(NULL),
+    tis(NULL),
+    freqStream(NULL),
+    proxStream(NULL),
+    termVectorsReaderOrig(NULL),
+    docValues(NULL),
+    postingsCodec(PostingsCodec::forFormat(si->getPostingsFormat())),
+    docStoresOpen(false)
+{
+    bool success = false;
+    try
+    {
+        // Use compound file directory for some files, if it exists
+        if (si->getUseCompoundFile())
+            cfsReader = _CLNEW CompoundFileReader(dir, (segment + L"." + IndexFileNames::COMPOUND_FILE_EXTENSION).c_str(), readBufferSize);
+        Directory* d = cfsDir();
+
+        // No compound file exists - use the multi-file format
+        fieldInfos = _CLNEW FieldInfos(d, (segment + L".fnm").c_str());
+        tis = _CLNEW TermInfosReader(d, segment.c_str(), fieldInfos, readBufferSize);
+
+        // make sure that all index files have been read or are kept open
+        // so that if an index update removes them we'll still have them
+        freqStream = d->openInput((segment + L".frq").c_str(), readBufferSize);
+        proxStream = d->openInput((segment + L".prx").c_str(), readBufferSize);
+
+        if (fieldInfos->hasDocValues() && d->fileExists((segment + L"." + IndexFileNames::DOC_VALUES_EXTENSION).c_str()))
+            docValues = _CLNEW DocValuesReader(d, segment.c_str(), si->docCount, readBufferSize);
+        success = true;
+    } _CLFINALLY(
+        if (!success)
+            close();
+    )
+}
+
+SegmentReader::Core::~Core()
+{
+    close();
+}
+
+void SegmentReader::Core::close()
+{
+    if (tis != NULL)
+    {
+        tis->close();
+        _CLDELETE(tis);
+    }
+    if (freqStream != NULL)
+    {
+        freqStream->close();
+        _CLDELETE(freqStream);
+    }
+    if (proxStream != NULL)
+    {
+        proxStream->close();
+        _CLDELETE(proxStream);
+    }
+    if (termVectorsReaderOrig != NULL)
+    {
+        termVectorsReaderOrig->close();
+        _CLDELETE(termVectorsReaderOrig);
+    }
+    _CLDELETE(docValues);
+    _CLDELETE(fieldInfos);
+    if (cfsReader != NULL)
+    {
+        cfsReader->close();
+        _CLDECDELETE(cfsReader);
+    }
+    if (storeCFSReader != NULL)
+    {
+        storeCFSReader->close();
+        _CLDECDELETE(storeCFSReader);
+    }
+}
+
+Directory* SegmentReader::Core::cfsDir()
+{
+    if (cfsReader != NULL)
+        return cfsReader;
+    return dir;
+}
+
+Directory* SegmentReader::Core::storeDir(SegmentInfo* si)
+{
+    if (si->getDocStoreOffset() == -1)
+        return cfsDir();
+    if (storeCFSReader != NULL)
+        return storeCFSReader;
+    return dir;
+}
+
+void SegmentReader::Core::openDocStores(SegmentInfo* si)
+{
+    SCOPED_LOCK_MUTEX(THIS_LOCK)
+    if (docStoresOpen)
+        return;
+
+    if (storeCFSReader == NULL && si->getDocStoreOffset() != -1 && si->getDocStoreIsCompoundFile())
+        storeCFSReader = _CLNEW CompoundFileReader(dir, (si->getDocStoreSegment() + L"." + IndexFileNames::COMPOUND_FILE_STORE_EXTENSION).c_str(), readBufferSize);
+
+    if (fieldInfos->hasVectors())
+    { // open term vector files only as needed
+        std::wstring vectorsSegment;
+        if (si->getDocStoreOffset() != -1)
+            vectorsSegment = si->getDocStoreSegment();
+        else
+            vectorsSegment = segment;
+        termVectorsReaderOrig = _CLNEW TermVectorsReader(storeDir(si), vectorsSegment.c_str(), fieldInfos, readBufferSize, si->getDocStoreOffset(), si->docCount);
+    }
+    docStoresOpen = true;
+}
+
 void SegmentReader::initialize(SegmentInfo* si, int32_t readBufferSize, bool doOpenStores, bool doingReopen)
 {
     //Pre  - si-> is a valid reference to SegmentInfo instance
@@ -136,6 +294,7 @@ void SegmentReader::initialize(SegmentInfo* si, int32_t readBufferSize, bool doO
 
     // make sure that all index files have been read or are kept open
     // so that if an index update removes them we'll still have them
+    this->core = NULL;
     this->freqStream = NULL;
     this->proxStream = NULL;
     this->singleNormStream = NULL;
@@ -143,6 +302,7 @@ void SegmentReader::initialize(SegmentInfo* si, int32_t readBufferSize, bool doO
     this->_fieldInfos = NULL;
     this->tis = NULL;
     this->fieldsReader = NULL;
+    this->docValues = NULL;
     this->cfsReader = NULL;
     this->storeCFSReader = NULL;
 
@@ -156,85 +316,14 @@ void SegmentReader::initialize(SegmentInfo* si, int32_t readBufferSize, bool doO
 
     try
     {
-        // Use compound file directory for some files, if it exists
-        Directory* cfsDir = directory();
-        if (si->getUseCompoundFile())
-        {
-            cfsReader = _CLNEW CompoundFileReader(directory(), (segment + L"." + IndexFileNames::COMPOUND_FILE_EXTENSION).c_str(), readBufferSize);
-            cfsDir = cfsReader;
-        }
-
-        Directory* storeDir;
+        core = _CLNEW Core(si, readBufferSize);
+        initializeFromCore();
 
         if (doOpenStores)
-        {
-            if (si->getDocStoreOffset() != -1)
-            {
-                if (si->getDocStoreIsCompoundFile())
-                {
-                    storeCFSReader = _CLNEW CompoundFileReader(directory(), (si->getDocStoreSegment() + L"." + IndexFileNames::COMPOUND_FILE_STORE_EXTENSION).c_str(), readBufferSize);
-                    storeDir = storeCFSReader;
-                }
-                else
-                {
-                    storeDir = directory();
-                }
-            }
-            else
-            {
-                storeDir = cfsDir;
-            }
-        }
-        else
-            storeDir = NULL;
-
-        // No compound file exists - use the multi-file format
-        _fieldInfos = _CLNEW FieldInfos(cfsDir, (segment + L".fnm").c_str());
-
-        std::wstring fieldsSegment;
-
-        if (si->getDocStoreOffset() != -1)
-            fieldsSegment = si->getDocStoreSegment();
-        else
-            fieldsSegment = segment;
-
-        if (doOpenStores)
-        {
-            fieldsReader = _CLNEW FieldsReader(storeDir, fieldsSegment.c_str(), _fieldInfos, readBufferSize,
-                si->getDocStoreOffset(), si->docCount);
-
-            // Verify two sources of "maxDoc" agree:
-            if (si->getDocStoreOffset() == -1 && fieldsReader->size() != si->docCount)
-            {
-                std::wstring err = L"doc counts differ for segment ";
-                err += si->name;
-                err += L": fieldsReader shows ";
-                err += fieldsReader->size();
-                err += L" but segmentInfo shows ";
-                err += si->docCount;
-                _CLTHROWT(CL_ERR_CorruptIndex, err.c_str());
-            }
-        }
-
-        tis = _CLNEW TermInfosReader(cfsDir, segment.c_str(), _fieldInfos, readBufferSize);
+            openDocStores();
 
         loadDeletedDocs();
-
-        // make sure that all index files have been read or are kept open
-        // so that if an index update removes them we'll still have them
-        freqStream = cfsDir->openInput((segment + L".frq").c_str(), readBufferSize);
-        proxStream = cfsDir->openInput((segment + L".prx").c_str(), readBufferSize);
-        openNorms(cfsDir, readBufferSize);
-
-        if (doOpenStores && _fieldInfos->hasVectors())
-        { // open term vector files only as needed
-            std::wstring vectorsSegment;
-            if (si->getDocStoreOffset() != -1)
-                vectorsSegment = si->getDocStoreSegment();
-            else
-                vectorsSegment = segment;
-            termVectorsReaderOrig = _CLNEW TermVectorsReader(storeDir, vectorsSegment.c_str(), _fieldInfos, readBufferSize, si->getDocStoreOffset(), si->docCount);
-        }
+        openNorms(core->cfsDir(), readBufferSize);
         success = true;
     } _CLFINALLY(
 
@@ -250,6 +339,50 @@ void SegmentReader::initialize(SegmentInfo* si, int32_t readBufferSize, bool doO
     )
 }
 
+void SegmentReader::initializeFromCore()
+{
+    cfsReader = core->cfsReader;
+    storeCFSReader = core->storeCFSReader;
+    _fieldInfos = core->fieldInfos;
+    tis = core->tis;
+    freqStream = core->freqStream;
+    proxStream = core->proxStream;
+    termVectorsReaderOrig = core->termVectorsReaderOrig;
+    docValues = core->docValues;
+}
+
+void SegmentReader::openDocStores()
+{
+    SCOPED_LOCK_MUTEX(THIS_LOCK)
+    if (fieldsReader != NULL)
+        return;
+
+    core->openDocStores(si);
+    initializeFromCore();
+
+    std::wstring fieldsSegment;
+    if (si->getDocStoreOffset() != -1)
+        fieldsSegment = si->getDocStoreSegment();
+    else
+        fieldsSegment = segment;
+
+    // every reader has its own FieldsReader, because it is not thread-safe
+    fieldsReader = _CLNEW FieldsReader(core->storeDir(si), fieldsSegment.c_str(), _fieldInfos, readBufferSize,
+        si->getDocStoreOffset(), si->docCount);
+
+    // Verify two sources of "maxDoc" agree:
+    if (si->getDocStoreOffset() == -1 && fieldsReader->size() != si->docCount)
+    {
+        std::wstring err = L"doc counts differ for segment ";
+        err += si->name;
+        err += L": fieldsReader shows ";
+        err += fieldsReader->size();
+        err += L" but segmentInfo shows ";
+        err += si->docCount;
+        _CLTHROWT(CL_ERR_CorruptIndex, err.c_str());
+    }
+}
+
 SegmentReader* SegmentReader::get(SegmentInfo* si, bool doOpenStores)
 {
     return get(si->dir, si, NULL, false, false, BufferedIndexInput::BUFFER_SIZE, doOpenStores);
@@ -293,16 +426,7 @@ SegmentReader::~SegmentReader()
 
     doClose(); //this means that index reader doesn't need to be closed manually
 
-    _CLDELETE(_fieldInfos);
-    _CLDELETE(fieldsReader);
-    _CLDELETE(tis);
-    _CLDELETE(freqStream);
-    _CLDELETE(proxStream);
-    _CLDELETE(deletedDocs);
     _CLDELETE_ARRAY(ones);
-    _CLDELETE(termVectorsReaderOrig)
-        _CLDECDELETE(cfsReader);
-    //termVectorsLocal->unregister(this);
 }
 
 void SegmentReader::commitChanges()
@@ -365,42 +489,14 @@ void SegmentReader::doClose()
         _CLDELETE(fieldsReader);
     }
 
-    if (tis != NULL)
-    {
-        tis->close();
-        _CLDELETE(tis);
-    }
-
-    //Close the frequency stream
-    if (freqStream != NULL)
-    {
-        freqStream->close();
-        _CLDELETE(freqStream);
-    }
-    //Close the prox stream
-    if (proxStream != NULL)
-    {
-        proxStream->close();
-        _CLDELETE(proxStream);
-    }
-
-    if (termVectorsReaderOrig != NULL)
-    {
-        termVectorsReaderOrig->close();
-        _CLDELETE(termVectorsReaderOrig);
-    }
-
-    if (cfsReader != NULL)
-    {
-        cfsReader->close();
-        _CLDECDELETE(cfsReader);
-    }
-
-    if (storeCFSReader != NULL)
-    {
-        storeCFSReader->close();
-        _CLDELETE(storeCFSReader);
-    }
+    // the files shared with other readers of the segment are closed with its core
+    cfsReader = storeCFSReader = NULL;
+    _fieldInfos = NULL;
+    tis = NULL;
+    freqStream = proxStream = NULL;
+    termVectorsReaderOrig = NULL;
+    docValues = NULL;
+    _CLDECDELETE(core);
 
     this->decRefNorms();
     _norms.clear();
@@ -533,6 +629,22 @@ bool SegmentReader::document(int32_t n, Document& doc, const FieldSelector* fiel
     return fieldsReader->doc(n, doc, fieldSelector);
 }
 
+bool SegmentReader::document(int32_t n, StoredFieldVisitor& visitor)
+{
+    SCOPED_LOCK_MUTEX(THIS_LOCK)
+
+    ensureOpen();
+
+    CND_PRECONDITION(n >= 0, L"n is a negative number");
+
+    if (isDeleted(n))
+    {
+        _CLTHROWA(CL_ERR_InvalidState, "attempt to access a deleted document");
+    }
+
+    return fieldsReader->visitDocument(n, visitor);
+}
+
 
 bool SegmentReader::isDeleted(const int32_t n)
 {
@@ -557,7 +669,7 @@ TermDocs* SegmentReader::termDocs()
     //Post - An unpositioned TermDocs enumerator has been returned
 
     ensureOpen();
-    return _CLNEW SegmentTermDocs(this);
+    return core->postingsCodec->newTermDocs(this);
 }
 
 TermPositions* SegmentReader::termPositions()
@@ -567,7 +679,7 @@ TermPositions* SegmentReader::termPositions()
     //Post - An unpositioned TermPositions enumerator has been returned
 
     ensureOpen();
-    return _CLNEW SegmentTermPositions(this);
+    return core->postingsCodec->newTermPositions(this);
 }
 
 int32_t SegmentReader::docFreq(const Term* t)
@@ -629,8 +741,28 @@ int32_t SegmentReader::maxDoc() const
 }
 
 
+void SegmentReader::setAccessPattern(IndexInput::AccessPattern pattern)
+{
+    // the postings streams belong to the core, leave them alone while other readers share it
+    if (core != NULL && _LUCENE_ATOMIC_INT_GET(core->__cl_refcount) > 1)
+    {
+        if (fieldsReader != NULL)
+            fieldsReader->setAccessPattern(pattern);
+        return;
+    }
+    if (freqStream != NULL)
+        freqStream->setAccessPattern(pattern);
+    if (proxStream != NULL)
+        proxStream->setAccessPattern(pattern);
+    if (fieldsReader != NULL)
+        fieldsReader->setAccessPattern(pattern);
+}
+
 void SegmentReader::setTermInfosIndexDivisor(int32_t indexDivisor)
 {
+    // the term index belongs to the core, which the clones of this reader share
+    if (_LUCENE_ATOMIC_INT_GET(core->__cl_refcount) > 1)
+        _CLTHROWA(CL_ERR_IllegalState, "the term index of this reader is shared with other readers");
     tis->setIndexDivisor(indexDivisor);
 }
 
@@ -691,6 +823,22 @@ bool SegmentReader::hasNorms(const wchar_t* field)
     return _norms.find(field) != _norms.end();
 }
 
+NumericDocValues* SegmentReader::getNumericDocValues(const wchar_t* field)
+{
+    ensureOpen();
+    if (docValues == NULL)
+        return NULL;
+    return docValues->getNumeric(_fieldInfos->fieldInfo(field));
+}
+
+SortedDocValues* SegmentReader::getSortedDocValues(const wchar_t* field)
+{
+    ensureOpen();
+    if (docValues == NULL)
+        return NULL;
+    return docValues->getSorted(_fieldInfos->fieldInfo(field));
+}
+
 
 void SegmentReader::norms(const wchar_t* field, uint8_t* bytes)
 {
@@ -808,9 +956,29 @@ DirectoryIndexReader* SegmentReader::doReopen(SegmentInfos* infos)
     }
     else
     {
+        // The new reader takes over the segment readers it reuses, but the
+        // caller still closes this one, so give it a clone of this reader
         ValueArray<IndexReader*> readers(1);
-        readers.values[0] = this;
-        return _CLNEW MultiSegmentReader(_directory, infos, closeDirectory, &readers, NULL, NULL);
+        for (int32_t i = 0; i < infos->size() && readers.values[0] == NULL; i++)
+        {
+            SegmentInfo* si = infos->info(i);
+            if (segment.compare(si->name) == 0 && si->getUseCompoundFile() == this->si->getUseCompoundFile())
+                readers.values[0] = reopenSegment(si, true);
+        }
+        if (readers.values[0] == NULL)
+            readers.values[0] = this;
+
+        try
+        {
+            newReader = _CLNEW MultiSegmentReader(_directory, infos, closeDirectory, &readers, NULL, NULL);
+        } _CLFINALLY(
+            // the clone was not reused
+            if (readers.values[0] != NULL && readers.values[0] != this)
+            {
+                readers.values[0]->close();
+                _CLDELETE(readers.values[0]);
+            }
+        )
     }
 
     return newReader;
@@ -839,6 +1007,18 @@ void SegmentReader::doSetNorm(int32_t doc, const wchar_t* field, uint8_t value)
     Norm* norm = _norms.get(field);
     if (norm == NULL)                             // not an indexed field
         return;
+
+    if (norm->refCount > 1)
+    {
+        // the norm is shared with another reader of the segment, change a copy
+        uint8_t* bits = norms(field);
+        Norm* copy = _CLNEW Norm(NULL, false, norm->number, 0, segment.c_str());
+        copy->bytes = _CL_NEWARRAY(uint8_t, maxDoc());
+        memcpy(copy->bytes, bits, maxDoc());
+        norm->decRef();
+        _norms.put(_fieldInfos->fieldInfo(field)->name, copy);
+        norm = copy;
+    }
     norm->dirty = true;                            // mark it dirty
     normsDirty = true;
 
@@ -913,7 +1093,7 @@ void SegmentReader::openNorms(Directory* cfsDir, int32_t readBufferSize)
                 normInput = d->openInput(fileName.c_str());
             }
 
-            _norms[fi->name] = _CLNEW Norm(normInput, singleNormFile, fi->number, normSeek, this, segment.c_str());
+            _norms[fi->name] = _CLNEW Norm(normInput, singleNormFile, fi->number, normSeek, segment.c_str());
             nextNormSeek += _maxDoc; // increment also if some norms are separate
         }
     }
@@ -1025,7 +1205,7 @@ void SegmentReader::loadDeletedDocs()
     }
 }
 
-SegmentReader* SegmentReader::reopenSegment(SegmentInfo* si)
+SegmentReader* SegmentReader::reopenSegment(SegmentInfo* si, bool doClone)
 {
     SCOPED_LOCK_MUTEX(THIS_LOCK)
         bool deletionsUpToDate = (this->si->hasDeletions() == si->hasDeletions())
@@ -1046,7 +1226,7 @@ SegmentReader* SegmentReader::reopenSegment(SegmentInfo* si)
         }
     }
 
-    if (normsUpToDate && deletionsUpToDate)
+    if (normsUpToDate && deletionsUpToDate && !doClone)
     {
         this->si = si; //force the result to use the new segment info (the old one is going to go away!)
         return this;
@@ -1061,44 +1241,12 @@ SegmentReader* SegmentReader::reopenSegment(SegmentInfo* si)
         clone = _CLNEW SegmentReader();
         clone->init(_directory, NULL, false);
         clone->initialize(si, readBufferSize, false, true);
-        clone->cfsReader = cfsReader;
-        clone->storeCFSReader = storeCFSReader;
-        clone->_fieldInfos = _fieldInfos;
-        clone->tis = tis;
-        clone->freqStream = freqStream;
-        clone->proxStream = proxStream;
-        clone->termVectorsReaderOrig = termVectorsReaderOrig;
-
-        // we have to open a new FieldsReader, because it is not thread-safe
-        // and can thus not be shared among multiple SegmentReaders
-        // TODO: Change this in case FieldsReader becomes thread-safe in the future
-        std::wstring fieldsSegment;
-
-        Directory* storeDir = directory();
-
-        if (si->getDocStoreOffset() != -1)
-        {
-            fieldsSegment = si->getDocStoreSegment();
-            if (storeCFSReader != NULL)
-            {
-                storeDir = storeCFSReader;
-            }
-        }
-        else
-        {
-            fieldsSegment = segment;
-            if (cfsReader != NULL)
-            {
-                storeDir = cfsReader;
-            }
-        }
+        clone->core = _CL_POINTER(core);
+        clone->initializeFromCore();
 
+        // the clone gets its own FieldsReader, because it is not thread-safe
         if (fieldsReader != NULL)
-        {
-            clone->fieldsReader = _CLNEW FieldsReader(storeDir, fieldsSegment.c_str(), _fieldInfos, readBufferSize,
-                si->getDocStoreOffset(), si->docCount);
-        }
-
+            clone->openDocStores();
 
         if (!deletionsUpToDate)
         {
@@ -1106,9 +1254,10 @@ SegmentReader* SegmentReader::reopenSegment(SegmentInfo* si)
             clone->deletedDocs = NULL;
             clone->loadDeletedDocs();
         }
-        else
+        else if (this->deletedDocs != NULL)
         {
-            clone->deletedDocs = this->deletedDocs;
+            // deletions of either reader must not show through the other one
+            clone->deletedDocs = this->deletedDocs->clone();
         }
 
         if (!normsUpToDate)
@@ -1122,7 +1271,6 @@ SegmentReader* SegmentReader::reopenSegment(SegmentInfo* si)
                     const wchar_t* curField = _fieldInfos->fieldInfo(i)->name;
                     Norm* norm = this->_norms.get(curField);
                     norm->incRef();
-                    norm->_this = clone; //give the norm to the clone
                     clone->_norms.put(curField, norm);
                 }
             }
@@ -1137,7 +1285,6 @@ SegmentReader* SegmentReader::reopenSegment(SegmentInfo* si)
                 const wchar_t* field = it->first;
                 Norm* norm = _norms[field];
                 norm->incRef();
-                norm->_this = clone; //give the norm to the clone
                 clone->_norms.put(field, norm);
                 it++;
             }
@@ -1171,27 +1318,16 @@ SegmentReader* SegmentReader::reopenSegment(SegmentInfo* si)
     } _CLFINALLY(
         if (!success)
         {
-            // An exception occured during reopen, we have to decRef the norms
-            // that we incRef'ed already and close singleNormsStream and FieldsReader
-            clone->decRefNorms();
+            // An exception occured during reopen, closing the clone decRefs the
+            // norms and the core it shares and closes its own streams
+            if (clone != NULL)
+            {
+                clone->close();
+                _CLDELETE(clone);
+            }
         }
     )
 
-        //disown this memory
-        this->freqStream = NULL;
-    this->_fieldInfos = NULL;
-    this->tis = NULL;
-    this->deletedDocs = NULL;
-    this->ones = NULL;
-    this->termVectorsReaderOrig = NULL;
-    this->cfsReader = NULL;
-    this->freqStream = NULL;
-    this->proxStream = NULL;
-    this->termVectorsReaderOrig = NULL;
-    this->cfsReader = NULL;
-    this->storeCFSReader = NULL;
-    this->singleNormStream = NULL;
-
     return clone;
 }
 
@@ -1276,6 +1412,7 @@ bool SegmentReader::normsClosed()
         {
             return false;
         }
+        it++;
     }
     return true;
 }
@@ -0,0 +1,154 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "CLucene/_ApiHeader.h"
+#include "_SegmentReaderPool.h"
+#include "_SegmentInfos.h"
+#include "_SegmentHeader.h"
+
+CL_NS_DEF(index)
+
+SegmentReaderPool::SegmentReaderPool():
+    pooling(false)
+{
+}
+
+SegmentReaderPool::~SegmentReaderPool()
+{
+    clear();
+}
+
+void SegmentReaderPool::closeReader(SegmentReader* reader)
+{
+    try
+    {
+        reader->close();
+    } _CLFINALLY(
+        _CLDELETE(reader);
+    )
+}
+
+void SegmentReaderPool::retire(ReadersType::iterator itr)
+{
+    Entry& entry = itr->second;
+    SegmentInfo* info = entry.info;
+    if (entry.refCount == 0)
+        closeReader(entry.reader);
+    else
+        retired[entry.reader] = entry.refCount;
+    readers.erase(itr);
+    _CLDELETE(info);
+}
+
+SegmentReader* SegmentReaderPool::get(SegmentInfo* info, bool doOpenStores, int32_t readBufferSize)
+{
+    SCOPED_LOCK_MUTEX(THIS_LOCK)
+
+    ReadersType::iterator itr = readers.find(info->name);
+    if (itr != readers.end() &&
+        itr->second.reader->getSegmentInfo()->getUseCompoundFile() != info->getUseCompoundFile())
+    {
+        // the segment was moved into a compound file
+        retire(itr);
+        itr = readers.end();
+    }
+
+    if (itr == readers.end())
+    {
+        Entry entry;
+        entry.reader = SegmentReader::get(info, readBufferSize, doOpenStores);
+        entry.info = NULL;
+        entry.refCount = 1;
+        readers[info->name] = entry;
+        return entry.reader;
+    }
+
+    Entry& entry = itr->second;
+
+    // returns the reader itself, now using info, unless the
+    // deletions or norms of info are newer
+    SegmentReader* reader = entry.reader->reopenSegment(info);
+    if (reader != entry.reader)
+    {
+        if (entry.refCount == 0)
+            closeReader(entry.reader);
+        else
+            retired[entry.reader] = entry.refCount;
+        entry.reader = reader;
+        entry.refCount = 0;
+    }
+    _CLDELETE(entry.info);
+
+    if (doOpenStores)
+        reader->openDocStores();
+    entry.refCount++;
+    return reader;
+}
+
+void SegmentReaderPool::release(SegmentReader* reader)
+{
+    SCOPED_LOCK_MUTEX(THIS_LOCK)
+
+    std::map<SegmentReader*, int32_t>::iterator r = retired.find(reader);
+    if (r != retired.end())
+    {
+        if (--r->second == 0)
+        {
+            retired.erase(r);
+            closeReader(reader);
+        }
+        return;
+    }
+
+    ReadersType::iterator itr = readers.find(reader->getSegmentName());
+    CND_PRECONDITION(itr != readers.end() && itr->second.reader == reader, L"reader was not checked out of this pool");
+    Entry& entry = itr->second;
+    if (--entry.refCount > 0)
+        return;
+
+    if (!pooling)
+    {
+        readers.erase(itr);
+        closeReader(reader);
+        return;
+    }
+
+    // the writer may delete the info the reader was checked out with
+    entry.info = reader->getSegmentInfo()->clone();
+    reader->setSegmentInfo(entry.info);
+}
+
+void SegmentReaderPool::drop(const SegmentInfo* info)
+{
+    SCOPED_LOCK_MUTEX(THIS_LOCK)
+    ReadersType::iterator itr = readers.find(info->name);
+    if (itr != readers.end())
+        retire(itr);
+}
+
+bool SegmentReaderPool::isCheckedOut(const SegmentInfo* info)
+{
+    SCOPED_LOCK_MUTEX(THIS_LOCK)
+    ReadersType::iterator itr = readers.find(info->name);
+    return itr != readers.end() && itr->second.refCount > 0;
+}
+
+void SegmentReaderPool::clear()
+{
+    SCOPED_LOCK_MUTEX(THIS_LOCK)
+    while (!readers.empty())
+        retire(readers.begin());
+}
+
+void SegmentReaderPool::setPooling(const bool pooling)
+{
+    SCOPED_LOCK_MUTEX(THIS_LOCK)
+    this->pooling = pooling;
+}
+
+CL_NS_END
@@ -10,15 +10,17 @@
 #include "_SegmentHeader.h"
 
 #include "CLucene/store/IndexInput.h"
+#include "CLucene/util/_VIntDecoder.h"
 #include "Term.h"
 #include <assert.h>
 
+CL_NS_USE(util)
 CL_NS_DEF(index)
 
   SegmentTermDocs::SegmentTermDocs(const SegmentReader* _parent) : parent(_parent),freqStream(_parent->freqStream->clone()),
 		count(0),df(0),deletedDocs(_parent->deletedDocs),_doc(0),_freq(0),skipInterval(_parent->tis->getSkipInterval()),
 		maxSkipLevels(_parent->tis->getMaxSkipLevels()),skipListReader(NULL),freqBasePointer(0),proxBasePointer(0),
-		skipPointer(0),haveSkipped(false)
+		skipPointer(0),haveSkipped(false),storesMaxFreqs(_parent->tis->hasMaxFreqs()),termMaxFreq(0)
 	{
       CND_CONDITION(_parent != NULL,L"Parent is NULL");
    }
@@ -61,8 +63,10 @@ CL_NS_DEF(index)
 	  currentFieldStoresPayloads = (fi != NULL) ? fi->storePayloads : false;
 	  if (ti == NULL) {
 		  df = 0;
+		  termMaxFreq = 0;
 	  } else {					// punt case
 		  df = ti->docFreq;
+		  termMaxFreq = storesMaxFreqs ? ti->maxFreq : -1;
 		  _doc = 0;
 		  freqBasePointer = ti->freqPointer;
 		  proxBasePointer = ti->proxPointer;
@@ -106,41 +110,113 @@ CL_NS_DEF(index)
 
   int32_t SegmentTermDocs::read(int32_t* docs, int32_t* freqs, int32_t length) {
 	  int32_t i = 0;
-	  //todo: one optimization would be to get the pointer buffer for ram or mmap dirs 
-	  //and iterate over them instead of using readByte() intensive functions.
+	  int32_t values[DECODE_BLOCK_SIZE];
+	  int32_t ends[DECODE_BLOCK_SIZE];
+
 	  while (i<length && count < df) {
-		  // manually inlined call to next() for speed
-		  uint32_t docCode = freqStream->readVInt();
-		  _doc += docCode >> 1;
-		  if ((docCode & 1) != 0)			  // if low bit is set
-			  _freq = 1;				  // _freq is one
-		  else
-			  _freq = freqStream->readVInt();		  // else read _freq
-		  count++;
-
-		  if (deletedDocs == NULL || (_doc >= 0 && !deletedDocs->get(_doc))) {
-			  docs[i] = _doc;
-			  freqs[i] = _freq;
-			  i++;
+		  // decode as many vints as the stream has in memory in one go. Each
+		  // document takes at most two of them (doc delta and freq).
+		  int32_t decoded = 0;
+		  int32_t available;
+		  const uint8_t* bytes = freqStream->bufferedBytes(available);
+		  if (bytes != NULL) {
+			  int32_t wanted = cl_min(length - i, df - count);
+			  wanted = wanted > DECODE_BLOCK_SIZE / 2 ? DECODE_BLOCK_SIZE : wanted * 2;
+			  decoded = VIntDecoder::decode(bytes, available, values, ends, wanted);
+		  }
+
+		  int32_t used = 0;
+		  while (used < decoded && i < length && count < df) {
+			  uint32_t docCode = values[used];
+			  if ((docCode & 1) != 0) {		  // if low bit is set
+				  _freq = 1;				  // _freq is one
+				  used++;
+			  } else {
+				  if (used + 1 >= decoded)
+					  break;				  // the freq was not decoded
+				  _freq = values[used + 1];
+				  used += 2;
+			  }
+			  _doc += docCode >> 1;
+			  count++;
+
+			  if (deletedDocs == NULL || (_doc >= 0 && !deletedDocs->get(_doc))) {
+				  docs[i] = _doc;
+				  freqs[i] = _freq;
+				  i++;
+			  }
+		  }
+
+		  if (used > 0) {
+			  freqStream->consumeBufferedBytes(ends[used - 1]);
+		  } else {
+			  // nothing buffered, or the next document straddles the end of the
+			  // buffer: read it the slow way, which moves on to the next buffer.
+			  uint32_t docCode = freqStream->readVInt();
+			  _doc += docCode >> 1;
+			  if ((docCode & 1) != 0)			  // if low bit is set
+				  _freq = 1;				  // _freq is one
+			  else
+				  _freq = freqStream->readVInt();		  // else read _freq
+			  count++;
+
+			  if (deletedDocs == NULL || (_doc >= 0 && !deletedDocs->get(_doc))) {
+				  docs[i] = _doc;
+				  freqs[i] = _freq;
+				  i++;
+			  }
 		  }
 	  }
 	  return i;
   }
 
+  void SegmentTermDocs::initSkipListReader(){
+    if (skipListReader == NULL)
+      skipListReader = _CLNEW DefaultSkipListReader(freqStream->clone(), maxSkipLevels, skipInterval, storesMaxFreqs); // lazily clone
+
+    if (!haveSkipped) {                          // lazily initialize skip stream
+      skipListReader->init(skipPointer, freqBasePointer, proxBasePointer, df, currentFieldStoresPayloads);
+      haveSkipped = true;
+    }
+  }
+
+  int32_t SegmentTermDocs::maxFreq(){
+    return termMaxFreq;
+  }
+
+  int32_t SegmentTermDocs::docFreq(){
+    return df;
+  }
+
+  int32_t SegmentTermDocs::maxFreqInBlock(const int32_t target, int32_t& blockEnd){
+    blockEnd = LUCENE_INT32_MAX_SHOULDBE;
+    if (termMaxFreq < 0 || df < skipInterval)
+      return termMaxFreq;
+
+    // moves the skip list reader only, skipTo() picks up from there
+    initSkipListReader();
+    if (target <= skipListReader->getDoc()) {
+      // before the block the reader is at: bound everything up to it
+      blockEnd = skipListReader->getDoc();
+      return termMaxFreq;
+    }
+    skipListReader->skipTo(target);
+    const int32_t next = skipListReader->getNextSkipDoc();
+    if (next == LUCENE_INT32_MAX_SHOULDBE)
+      return termMaxFreq; // after the last skip entry
+    blockEnd = next;
+    return skipListReader->getNextMaxFreq();
+  }
+
   bool SegmentTermDocs::skipTo(const int32_t target){
     assert(count <= df );
     
     if (df >= skipInterval) {                      // optimized case
-      if (skipListReader == NULL)
-		  skipListReader = _CLNEW DefaultSkipListReader(freqStream->clone(), maxSkipLevels, skipInterval); // lazily clone
-
-	  if (!haveSkipped) {                          // lazily initialize skip stream
-		  skipListReader->init(skipPointer, freqBasePointer, proxBasePointer, df, currentFieldStoresPayloads);
-		  haveSkipped = true;
-	  }
+      initSkipListReader();
 
       int32_t newCount = skipListReader->skipTo(target); 
-      if (newCount > count) {
+      // maxFreqInBlock() may have taken the reader past target already
+      if (newCount > count && skipListReader->getDoc() < target) {
         freqStream->seek(skipListReader->getFreqPointer());
         skipProx(skipListReader->getProxPointer(), skipListReader->getPayloadLength());
 
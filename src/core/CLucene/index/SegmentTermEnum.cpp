@@ -38,6 +38,9 @@ CL_NS_DEF(index)
 		prev         = NULL;
 		formatM1SkipInterval = 0;
 		maxSkipLevels = 1;
+		termInfos    = NULL;
+		indexOffset  = -1;
+		indexTerm    = NULL;
 		
 		//Set isClone to false as the instance is not clone of another instance
 		isClone      = false;
@@ -77,7 +80,7 @@ CL_NS_DEF(index)
          }else{
             indexInterval = input->readInt();
             skipInterval = input->readInt();
-            if ( format == -3 ) {
+            if ( format <= -3 ) {
 		// this new format introduces multi-level skipping
             	maxSkipLevels = input->readInt();
             }
@@ -115,6 +118,9 @@ CL_NS_DEF(index)
       skipInterval = clone.skipInterval;
       formatM1SkipInterval = clone.formatM1SkipInterval;
       maxSkipLevels = clone.maxSkipLevels;
+      termInfos = clone.termInfos;
+      indexOffset = -1;
+      indexTerm = NULL;
       
 		//Set isClone to true as this instance is a clone of another instance
 		isClone      = true;
@@ -136,6 +142,7 @@ CL_NS_DEF(index)
 		_CLDECDELETE(prev );
 		//Finalize term
 		_CLDECDELETE( _term );
+		_CLDECDELETE( indexTerm );
 		
 
 		//Delete the buffer if necessary
@@ -200,6 +207,8 @@ CL_NS_DEF(index)
       }else{
          if (termInfo->docFreq >= skipInterval) 
             termInfo->skipOffset = input->readVInt();
+         if (format <= -4)
+            termInfo->maxFreq = input->readVInt();
       }
 
 		//Check if the enumeration is an index
@@ -217,14 +226,23 @@ CL_NS_DEF(index)
 			return _term;
 	}
 
-	void SegmentTermEnum::scanTo(const Term *term){
+	int32_t SegmentTermEnum::scanTo(const Term *term){
 	//Func - Scan for Term without allocating new Terms
 	//Pre  - term != NULL
 	//Post - The iterator term has been moved to the position where Term is expected to be
-	//       in the enumeration
+	//       in the enumeration. The number of terms moved over has been returned
+		int32_t count = 0;
 		while ( term->compareTo(this->_term) > 0 && next()) 
 		{
+			count++;
 		}
+		return count;
+	}
+
+	bool SegmentTermEnum::skipTo(Term* target){
+		if ( termInfos == NULL )
+			return TermEnum::skipTo(target);
+		return termInfos->skipTo(this, target);
 	}
 
 	void SegmentTermEnum::close() {
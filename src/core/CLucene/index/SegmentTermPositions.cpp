@@ -10,6 +10,8 @@
 #include "_SegmentHeader.h"
 
 #include "Terms.h"
+#include "CLucene/store/IndexInput.h"
+#include "CLucene/util/_VIntDecoder.h"
 
 CL_NS_USE(util)
 CL_NS_DEF(index)
@@ -59,6 +61,38 @@ int32_t SegmentTermPositions::nextPosition() {
     return position += readDeltaPosition();
 }
 
+void SegmentTermPositions::nextPositions(int32_t* positions, const int32_t length) {
+	lazySkip();
+	proxCount -= length;
+
+	int32_t i = 0;
+	if (currentFieldStoresPayloads) {
+		for ( ; i < length; i++ ) {
+			skipPayload();
+			positions[i] = position += readDeltaPosition();
+		}
+		return;
+	}
+
+	int32_t ends[DECODE_BLOCK_SIZE];
+	while (i < length) {
+		int32_t decoded = 0;
+		int32_t available;
+		const uint8_t* bytes = proxStream->bufferedBytes(available);
+		if (bytes != NULL)
+			decoded = VIntDecoder::decode(bytes, available, positions + i, ends, cl_min(length - i, (int32_t)DECODE_BLOCK_SIZE));
+
+		if (decoded > 0) {
+			proxStream->consumeBufferedBytes(ends[decoded - 1]);
+			for ( const int32_t end = i + decoded; i < end; i++ )
+				positions[i] = position += positions[i];
+		} else {
+			// nothing buffered, or the next position straddles the end of the buffer
+			positions[i++] = position += proxStream->readVInt();
+		}
+	}
+}
+
 int32_t SegmentTermPositions::readDeltaPosition() {
 	int32_t delta = proxStream->readVInt();
 	if (currentFieldStoresPayloads) {
@@ -8,6 +8,7 @@
 ------------------------------------------------------------------------------*/
 #include "CLucene/_ApiHeader.h"
 #include "_SkipListReader.h"
+#include "CLucene/util/_ForUtil.h"
 
 CL_NS_USE(store)
 CL_NS_DEF(index)
@@ -58,6 +59,11 @@ int32_t MultiLevelSkipListReader::getDoc() const
     return lastDoc;
 }
 
+int32_t MultiLevelSkipListReader::getNextSkipDoc() const
+{
+    return skipDoc[0];
+}
+
 int32_t MultiLevelSkipListReader::skipTo(const int32_t target)
 {
     if (!haveSkipped)
@@ -280,8 +286,9 @@ IndexInput* MultiLevelSkipListReader::SkipBuffer::clone() const
 
 
 
-DefaultSkipListReader::DefaultSkipListReader(CL_NS(store)::IndexInput* _skipStream, const int32_t maxSkipLevels, const int32_t _skipInterval)
-    : MultiLevelSkipListReader(_skipStream, maxSkipLevels, _skipInterval)
+DefaultSkipListReader::DefaultSkipListReader(CL_NS(store)::IndexInput* _skipStream, const int32_t maxSkipLevels, const int32_t _skipInterval, const bool _storesMaxFreqs)
+    : MultiLevelSkipListReader(_skipStream, maxSkipLevels, _skipInterval),
+    storesMaxFreqs(_storesMaxFreqs), nextMaxFreq(-1)
 {
     freqPointer = _CL_NEWARRAY(int64_t, maxSkipLevels);
     proxPointer = _CL_NEWARRAY(int64_t, maxSkipLevels);
@@ -308,6 +315,7 @@ void DefaultSkipListReader::init(const int64_t _skipPointer, const int64_t freqB
     this->currentFieldStoresPayloads = storesPayloads;
     lastFreqPointer = freqBasePointer;
     lastProxPointer = proxBasePointer;
+    nextMaxFreq = -1;
 
     for (int32_t j = 0; j < maxNumberOfSkipLevels; j++)
     {
@@ -330,6 +338,11 @@ int32_t DefaultSkipListReader::getPayloadLength() const
     return lastPayloadLength;
 }
 
+int32_t DefaultSkipListReader::getNextMaxFreq() const
+{
+    return nextMaxFreq;
+}
+
 void DefaultSkipListReader::seekChild(const int32_t level)
 {
     MultiLevelSkipListReader::seekChild(level);
@@ -369,7 +382,99 @@ int32_t DefaultSkipListReader::readSkipData(const int32_t level, CL_NS(store)::I
     }
     freqPointer[level] += _skipStream->readVInt();
     proxPointer[level] += _skipStream->readVInt();
+    if (storesMaxFreqs && level == 0)
+    {
+        nextMaxFreq = _skipStream->readVInt();
+    }
+
+    return delta;
+}
+
+
+
+BlockSkipListReader::BlockSkipListReader(CL_NS(store)::IndexInput* _skipStream, const int32_t maxSkipLevels)
+    : MultiLevelSkipListReader(_skipStream, maxSkipLevels, CL_NS(util)::ForUtil::BLOCK_LENGTH),
+    nextMaxFreq(-1)
+{
+    freqPointer = _CL_NEWARRAY(int64_t, maxSkipLevels);
+    proxPointer = _CL_NEWARRAY(int64_t, maxSkipLevels);
+    posUpto = _CL_NEWARRAY(int32_t, maxSkipLevels);
+    memset(freqPointer, 0, sizeof(int64_t) * maxSkipLevels);
+    memset(proxPointer, 0, sizeof(int64_t) * maxSkipLevels);
+    memset(posUpto, 0, sizeof(int32_t) * maxSkipLevels);
+    this->lastFreqPointer = 0;
+    this->lastProxPointer = 0;
+    this->lastPosUpto = 0;
+}
+
+BlockSkipListReader::~BlockSkipListReader()
+{
+    _CLDELETE_LARRAY(freqPointer);
+    _CLDELETE_LARRAY(proxPointer);
+    _CLDELETE_LARRAY(posUpto);
+}
+
+void BlockSkipListReader::init(const int64_t _skipPointer, const int64_t freqBasePointer, const int64_t proxBasePointer, const int32_t df)
+{
+    // the entry of a block is written when the first document after it is
+    // added, so there is none for a block the term ends with
+    MultiLevelSkipListReader::init(_skipPointer, df - 1);
+    lastFreqPointer = freqBasePointer;
+    lastProxPointer = proxBasePointer;
+    lastPosUpto = 0;
+    nextMaxFreq = -1;
+
+    for (int32_t j = 0; j < maxNumberOfSkipLevels; j++)
+    {
+        freqPointer[j] = freqBasePointer;
+        proxPointer[j] = proxBasePointer;
+        posUpto[j] = 0;
+    }
+}
+
+int64_t BlockSkipListReader::getFreqPointer() const
+{
+    return lastFreqPointer;
+}
+int64_t BlockSkipListReader::getProxPointer() const
+{
+    return lastProxPointer;
+}
+int32_t BlockSkipListReader::getPosUpto() const
+{
+    return lastPosUpto;
+}
+int32_t BlockSkipListReader::getNextMaxFreq() const
+{
+    return nextMaxFreq;
+}
+
+void BlockSkipListReader::seekChild(const int32_t level)
+{
+    MultiLevelSkipListReader::seekChild(level);
+    freqPointer[level] = lastFreqPointer;
+    proxPointer[level] = lastProxPointer;
+    posUpto[level] = lastPosUpto;
+}
+
+void BlockSkipListReader::setLastSkipData(const int32_t level)
+{
+    MultiLevelSkipListReader::setLastSkipData(level);
+    lastFreqPointer = freqPointer[level];
+    lastProxPointer = proxPointer[level];
+    lastPosUpto = posUpto[level];
+}
 
+int32_t BlockSkipListReader::readSkipData(const int32_t level, CL_NS(store)::IndexInput* _skipStream)
+{
+    const int32_t delta = _skipStream->readVInt();
+    freqPointer[level] += _skipStream->readVLong();
+    proxPointer[level] += _skipStream->readVLong();
+    posUpto[level] = _skipStream->readVInt();
+    if (level == 0)
+    {
+        nextMaxFreq = _skipStream->readVInt();
+    }
     return delta;
 }
 
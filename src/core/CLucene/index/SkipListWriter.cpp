@@ -9,6 +9,7 @@
 #include "CLucene/_ApiHeader.h"
 #include "_SkipListWriter.h"
 #include "CLucene/util/_Arrays.h"
+#include "CLucene/util/_ForUtil.h"
 
 CL_NS_USE(store)
 CL_NS_USE(util)
@@ -100,8 +101,20 @@ void DefaultSkipListWriter::setSkipData(int32_t doc, bool storePayloads, int32_t
   this->curProxPointer = proxOutput->getFilePointer();
 }
 
+void DefaultSkipListWriter::addFreq(int32_t freq) {
+  if (freq > curMaxFreq)
+    curMaxFreq = freq;
+  if (freq > termMaxFreq)
+    termMaxFreq = freq;
+}
+
+int32_t DefaultSkipListWriter::getMaxFreq() const {
+  return termMaxFreq;
+}
+
 void DefaultSkipListWriter::resetSkip() {
   MultiLevelSkipListWriter::resetSkip();
+  curMaxFreq = termMaxFreq = 0;
   memset(lastSkipDoc, 0, numberOfSkipLevels * sizeof(int32_t) );
   Arrays<int32_t>::fill(lastSkipPayloadLength, numberOfSkipLevels, -1);  // we don't have to write the first length in the skip list
   Arrays<int64_t>::fill(lastSkipFreqPointer,   numberOfSkipLevels, freqOutput->getFilePointer());
@@ -129,6 +142,8 @@ void DefaultSkipListWriter::writeSkipData(int32_t level, IndexOutput* skipBuffer
   //         if DocSkip is even, then it is assumed that the
   //         current payload length equals the length at the previous
   //         skip point
+  // On level 0 a MaxFreq VInt follows, the largest frequency of the documents
+  // after the previous skip point up to and including DocSkip.
   if (curStorePayloads) {
     int32_t delta = curDoc - lastSkipDoc[level];
     if (curPayloadLength == lastSkipPayloadLength[level]) {
@@ -148,6 +163,10 @@ void DefaultSkipListWriter::writeSkipData(int32_t level, IndexOutput* skipBuffer
   }
   skipBuffer->writeVInt((int32_t) (curFreqPointer - lastSkipFreqPointer[level]));
   skipBuffer->writeVInt((int32_t) (curProxPointer - lastSkipProxPointer[level]));
+  if (level == 0) {
+    skipBuffer->writeVInt(curMaxFreq);
+    curMaxFreq = 0;
+  }
 
   lastSkipDoc[level] = curDoc;
   //System.out.println("write doc at level " + level + ": " + curDoc);
@@ -163,6 +182,7 @@ DefaultSkipListWriter::DefaultSkipListWriter(int32_t skipInterval, int32_t numbe
   this->proxOutput = proxOutput;
   this->curDoc = this->curPayloadLength = 0;
   this->curFreqPointer =this->curProxPointer = 0;
+  this->curMaxFreq = this->termMaxFreq = 0;
   
   lastSkipDoc = _CL_NEWARRAY(int32_t,numberOfSkipLevels);
   lastSkipPayloadLength =  _CL_NEWARRAY(int32_t,numberOfSkipLevels);
@@ -175,4 +195,55 @@ DefaultSkipListWriter::~DefaultSkipListWriter(){
   _CLDELETE_ARRAY(lastSkipFreqPointer);
   _CLDELETE_ARRAY(lastSkipProxPointer);
 }
+
+
+
+void BlockSkipListWriter::setSkipData(int32_t doc, int64_t freqPointer, int64_t proxPointer, int32_t posUpto, int32_t maxFreq) {
+  this->curDoc = doc;
+  this->curFreqPointer = freqPointer;
+  this->curProxPointer = proxPointer;
+  this->curPosUpto = posUpto;
+  this->curMaxFreq = maxFreq;
+}
+
+void BlockSkipListWriter::resetSkip(int64_t freqPointer, int64_t proxPointer) {
+  MultiLevelSkipListWriter::resetSkip();
+  memset(lastSkipDoc, 0, numberOfSkipLevels * sizeof(int32_t) );
+  Arrays<int64_t>::fill(lastSkipFreqPointer, numberOfSkipLevels, freqPointer);
+  Arrays<int64_t>::fill(lastSkipProxPointer, numberOfSkipLevels, proxPointer);
+}
+
+void BlockSkipListWriter::writeSkipData(int32_t level, IndexOutput* skipBuffer){
+  //   SkipDatum       --> DocSkip, FreqSkip, ProxSkip, PosUpto, MaxFreq?
+  //   DocSkip,PosUpto,MaxFreq --> VInt
+  //   FreqSkip,ProxSkip       --> VLong
+  // DocSkip, FreqSkip and ProxSkip are differences from the previous entry
+  // of the level. MaxFreq is only written on level 0.
+  skipBuffer->writeVInt(curDoc - lastSkipDoc[level]);
+  skipBuffer->writeVLong(curFreqPointer - lastSkipFreqPointer[level]);
+  skipBuffer->writeVLong(curProxPointer - lastSkipProxPointer[level]);
+  skipBuffer->writeVInt(curPosUpto);
+  if (level == 0)
+    skipBuffer->writeVInt(curMaxFreq);
+
+  lastSkipDoc[level] = curDoc;
+  lastSkipFreqPointer[level] = curFreqPointer;
+  lastSkipProxPointer[level] = curProxPointer;
+}
+
+BlockSkipListWriter::BlockSkipListWriter(int32_t numberOfSkipLevels, int32_t docCount):
+  MultiLevelSkipListWriter(ForUtil::BLOCK_LENGTH, numberOfSkipLevels, docCount)
+{
+  this->curDoc = this->curPosUpto = this->curMaxFreq = 0;
+  this->curFreqPointer = this->curProxPointer = 0;
+
+  lastSkipDoc = _CL_NEWARRAY(int32_t,numberOfSkipLevels);
+  lastSkipFreqPointer =  _CL_NEWARRAY(int64_t,numberOfSkipLevels);
+  lastSkipProxPointer =  _CL_NEWARRAY(int64_t,numberOfSkipLevels);
+}
+BlockSkipListWriter::~BlockSkipListWriter(){
+  _CLDELETE_ARRAY(lastSkipDoc);
+  _CLDELETE_ARRAY(lastSkipFreqPointer);
+  _CLDELETE_ARRAY(lastSkipProxPointer);
+}
 CL_NS_END
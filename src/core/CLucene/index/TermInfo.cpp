@@ -21,6 +21,7 @@ TermInfo::TermInfo(){
 	freqPointer = 0;
 	proxPointer = 0;
   skipOffset = 0;
+  maxFreq = 0;
 }
 
 TermInfo::~TermInfo(){
@@ -42,6 +43,7 @@ TermInfo::TermInfo(const int32_t df, const int64_t fp, const int64_t pp){
     proxPointer = pp;
 	  docFreq     = df;
     skipOffset = 0;
+    maxFreq = 0;
 }
 
 TermInfo::TermInfo(const TermInfo* ti) {
@@ -61,9 +63,10 @@ TermInfo::TermInfo(const TermInfo* ti) {
 	freqPointer = ti->freqPointer;
 	proxPointer = ti->proxPointer;
   skipOffset  = ti->skipOffset;
+  maxFreq     = ti->maxFreq;
 }
 
-void TermInfo::set(const int32_t df, const int64_t fp, const int64_t pp, int32_t so) {
+void TermInfo::set(const int32_t df, const int64_t fp, const int64_t pp, int32_t so, const int32_t mf) {
 //Func - Sets a new document frequency, a new freqPointer and a new proxPointer
 //Pre  - df >= 0, fp >= 0 pp >= 0
 //Post - The new document frequency, a new freqPointer and a new proxPointer
@@ -77,6 +80,7 @@ void TermInfo::set(const int32_t df, const int64_t fp, const int64_t pp, int32_t
 	freqPointer = fp;
 	proxPointer = pp;
     skipOffset  = so;
+    maxFreq     = mf;
 }
 
 void TermInfo::set(const TermInfo* ti) {
@@ -96,5 +100,6 @@ void TermInfo::set(const TermInfo* ti) {
 	freqPointer = ti->freqPointer;
 	proxPointer = ti->proxPointer;
     skipOffset =  ti->skipOffset;
+    maxFreq    =  ti->maxFreq;
 }
 CL_NS_END
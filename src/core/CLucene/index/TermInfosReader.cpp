@@ -11,6 +11,8 @@
 #include "Term.h"
 #include "Terms.h"
 #include "CLucene/util/Misc.h"
+#include "CLucene/util/PackedInts.h"
+#include "CLucene/util/_StringIntern.h"
 #include "CLucene/store/Directory.h"
 #include "CLucene/store/IndexInput.h"
 
@@ -27,8 +29,371 @@ CL_NS_USE(util)
 CL_NS_DEF(index)
 
 
+  TermInfosIndex::TermInfosIndex(SegmentTermEnum* indexEnum, const int32_t indexDivisor):
+      length(0), fields(NULL), fieldsLength(0), termFields(NULL), texts(NULL), blockStarts(NULL),
+      infos(NULL), pointers(NULL)
+  {
+      const int32_t maxLength = indexEnum->size == 0 ? 0 : 1 + (int32_t)((indexEnum->size - 1) / indexDivisor);
+
+      std::vector<const wchar_t*> fieldList;
+      int32_t* termFieldList = _CL_NEWARRAY(int32_t, maxLength + 1);
+      int64_t* pointerList = _CL_NEWARRAY(int64_t, maxLength + 1);
+      std::vector<int64_t> blockList;
+      std::string textBlock;
+      std::wstring prev;
+      infos = _CL_NEWARRAY(TermInfo, maxLength + 1);
+
+      uint8_t buf[6];
+      while ( length < maxLength && indexEnum->next() ){
+          const Term* term = indexEnum->term(false);
+          if ( fieldList.empty() || fieldList.back() != term->field() )
+              fieldList.push_back(term->field());
+          termFieldList[length] = (int32_t)fieldList.size() - 1;
+          indexEnum->getTermInfo(&infos[length]);
+          pointerList[length] = indexEnum->indexPointer;
+
+          //every BLOCK_SIZE-th text is stored whole, the others share a prefix with the one before
+          const wchar_t* text = term->text();
+          const int32_t textLength = (int32_t)term->textLength();
+          int32_t prefix = 0;
+          if ( length % BLOCK_SIZE == 0 ){
+              blockList.push_back((int64_t)textBlock.length());
+          }else{
+              const int32_t max = cl_min(textLength, (int32_t)prev.length());
+              while ( prefix < max && text[prefix] == prev[prefix] )
+                  prefix++;
+          }
+          int32_t vint = prefix;
+          while ( (vint & ~0x7F) != 0 ){ textBlock += (char)((vint & 0x7f) | 0x80); vint = (int32_t)((uint32_t)vint >> 7); }
+          textBlock += (char)vint;
+          vint = textLength - prefix;
+          while ( (vint & ~0x7F) != 0 ){ textBlock += (char)((vint & 0x7f) | 0x80); vint = (int32_t)((uint32_t)vint >> 7); }
+          textBlock += (char)vint;
+          for ( int32_t i = prefix; i < textLength; i++ )
+              textBlock.append((const char*)buf, lucene_wctoutf8((char*)buf, text[i]));
+          prev.assign(text, textLength);
+
+          length++;
+          for (int32_t j = 1; j < indexDivisor; j++)
+              if (!indexEnum->next())
+                  break;
+      }
+      blockList.push_back((int64_t)textBlock.length());
+
+      fieldsLength = (int32_t)fieldList.size();
+      fields = _CL_NEWARRAY(const wchar_t*, fieldsLength + 1);
+      for ( int32_t i = 0; i < fieldsLength; i++ )
+          fields[i] = fieldList[i];
+
+      termFields = _CLNEW PackedInts(length, PackedInts::bitsRequired(fieldsLength));
+      int64_t maxPointer = 0;
+      for ( int32_t i = 0; i < length; i++ ){
+          termFields->set(i, termFieldList[i]);
+          if ( pointerList[i] > maxPointer )
+              maxPointer = pointerList[i];
+      }
+      pointers = _CLNEW PackedInts(length, PackedInts::bitsRequired(maxPointer));
+      for ( int32_t i = 0; i < length; i++ )
+          pointers->set(i, pointerList[i]);
+      _CLDELETE_ARRAY(termFieldList);
+      _CLDELETE_ARRAY(pointerList);
+
+      blockStarts = _CLNEW PackedInts((int32_t)blockList.size(), PackedInts::bitsRequired((int64_t)textBlock.length()));
+      for ( size_t i = 0; i < blockList.size(); i++ )
+          blockStarts->set((int32_t)i, blockList[i]);
+      texts = _CL_NEWARRAY(uint8_t, textBlock.length() + 1);
+      memcpy(texts, textBlock.c_str(), textBlock.length() + 1);
+  }
+
+  TermInfosIndex::~TermInfosIndex(){
+      _CLDELETE_ARRAY(fields);
+      _CLDELETE(termFields);
+      _CLDELETE_ARRAY(texts);
+      _CLDELETE(blockStarts);
+      _CLDELETE_ARRAY(infos);
+      _CLDELETE(pointers);
+  }
+
+  int32_t TermInfosIndex::size() const{
+      return length;
+  }
+
+  const uint8_t* TermInfosIndex::readText(const uint8_t* pos, std::wstring& text){
+      uint8_t b = *pos++;
+      int32_t prefix = b & 0x7F;
+      for (int32_t shift = 7; (b & 0x80) != 0; shift += 7) {
+          b = *pos++;
+          prefix |= (b & 0x7F) << shift;
+      }
+      b = *pos++;
+      int32_t suffix = b & 0x7F;
+      for (int32_t shift = 7; (b & 0x80) != 0; shift += 7) {
+          b = *pos++;
+          suffix |= (b & 0x7F) << shift;
+      }
+
+      text.resize(prefix);
+      for ( int32_t i = 0; i < suffix; i++ ){
+          wchar_t c;
+          size_t r = lucene_utf8towc(c, (const char*)pos);
+          if ( r == 0 )
+              _CLTHROWA(CL_ERR_Runtime, "invalid UTF-8 in the term index");
+          pos += r;
+          text += c;
+      }
+      return pos;
+  }
+
+  void TermInfosIndex::readText(const int32_t offset, std::wstring& text) const{
+      CND_PRECONDITION(offset >= 0 && offset < length, L"offset out of range");
+      const int32_t block = offset / BLOCK_SIZE;
+      const uint8_t* pos = texts + blockStarts->get(block);
+      for ( int32_t i = block * BLOCK_SIZE; i <= offset; i++ )
+          pos = readText(pos, text);
+  }
+
+  int32_t TermInfosIndex::compare(const Term* term, const int32_t offset, const std::wstring& text) const{
+      const wchar_t* field = fields[termFields->get(offset)];
+      if ( term->field() != field ){ // fields are interned
+          int32_t ret = wcscmp(term->field(), field);
+          if ( ret != 0 )
+              return ret;
+      }
+      return wcscmp(term->text(), text.c_str());
+  }
+
+  int32_t TermInfosIndex::getIndexOffset(const Term* term) const{
+      //find the last block that starts at or before term
+      int32_t lo = 0;
+      int32_t hi = blockStarts->size() - 2;
+      std::wstring text;
+      while (hi >= lo) {
+          const int32_t mid = (lo + hi) >> 1;
+          readText(texts + blockStarts->get(mid), text);
+          const int32_t delta = compare(term, mid * BLOCK_SIZE, text);
+          if (delta < 0)
+              hi = mid - 1;
+          else if (delta > 0)
+              lo = mid + 1;
+          else
+              return mid * BLOCK_SIZE;
+      }
+      if ( hi < 0 )
+          return -1;
+
+      //then scan the block for the last term at or before term
+      const int32_t start = hi * BLOCK_SIZE;
+      const int32_t end = cl_min(start + BLOCK_SIZE, length);
+      const uint8_t* pos = texts + blockStarts->get(hi);
+      int32_t ret = start;
+      for ( int32_t i = start; i < end; i++ ){
+          pos = readText(pos, text);
+          const int32_t delta = compare(term, i, text);
+          if ( delta < 0 )
+              break;
+          ret = i;
+          if ( delta == 0 )
+              break;
+      }
+      return ret;
+  }
+
+  void TermInfosIndex::getTerm(const int32_t offset, Term* dest) const{
+      std::wstring text;
+      readText(offset, text);
+      dest->set(fields[termFields->get(offset)], text.c_str(), false);
+  }
+
+  TermInfo* TermInfosIndex::getTermInfo(const int32_t offset) const{
+      CND_PRECONDITION(offset >= 0 && offset < length, L"offset out of range");
+      return &infos[offset];
+  }
+
+  int64_t TermInfosIndex::getPointer(const int32_t offset) const{
+      return pointers->get(offset);
+  }
+
+  size_t TermInfosIndex::ramBytesUsed() const{
+      return sizeof(TermInfosIndex)
+          + sizeof(const wchar_t*) * (fieldsLength + 1)
+          + termFields->ramBytesUsed()
+          + (size_t)blockStarts->get(blockStarts->size() - 1) + 1
+          + blockStarts->ramBytesUsed()
+          + sizeof(TermInfo) * (length + 1)
+          + pointers->ramBytesUsed();
+  }
+
+
+  /** A cached term. Keys that are looked up borrow the text of the Term, keys in the cache own a copy */
+  class TermInfosCache::Key{
+  public:
+      const wchar_t* field;
+      const wchar_t* text;
+      size_t hash;
+      bool owned;
+
+      Key(const Term* term):
+          field(term->field()), text(term->text()), owned(false)
+      {
+          hash = Misc::whashCode(field) * 31 + Misc::whashCode(text, term->textLength());
+      }
+      Key(const Key& other):
+          field(CLStringIntern::intern(other.field)), hash(other.hash), owned(true)
+      {
+          const size_t len = wcslen(other.text);
+          wchar_t* copy = _CL_NEWARRAY(wchar_t, len + 1);
+          memcpy(copy, other.text, sizeof(wchar_t) * (len + 1));
+          text = copy;
+      }
+      ~Key(){
+          if ( owned ){
+              CLStringIntern::unintern(field);
+              _CLDELETE_CARRAY(text);
+          }
+      }
+
+      class Compare:LUCENE_BASE, public CL_NS(util)::Compare::_base //<Key*>
+      {
+      public:
+          bool operator()( const Key* k1, const Key* k2 ) const{
+              if ( k1->hash != k2->hash )
+                  return k1->hash < k2->hash;
+              int32_t ret = k1->field == k2->field ? 0 : wcscmp(k1->field, k2->field);
+              return (ret == 0 ? wcscmp(k1->text, k2->text) : ret) < 0;
+          }
+          size_t operator()( const Key* k ) const{
+              return k->hash;
+          }
+      };
+      class Equals:public CL_NS_STD(binary_function)<const Key*,const Key*,bool>
+      {
+      public:
+          bool operator()( const Key* k1, const Key* k2 ) const{
+              return k1->hash == k2->hash
+                  && (k1->field == k2->field || wcscmp(k1->field, k2->field) == 0)
+                  && wcscmp(k1->text, k2->text) == 0;
+          }
+      };
+  };
+
+  class TermInfosCache::Stripe{
+  public:
+      typedef CL_NS(util)::CLHashMap<Key*, TermInfo*, Key::Compare, Key::Equals,
+          CL_NS(util)::Deletor::Object<Key>, CL_NS(util)::Deletor::Object<TermInfo> > Generation;
+
+      DEFINE_MUTEX(THIS_LOCK)
+      Generation* current;
+      Generation* previous;
+      int64_t hits;
+      int64_t misses;
+
+      Stripe():
+          current(_CLNEW Generation(true, true)),
+          previous(_CLNEW Generation(true, true)),
+          hits(0),
+          misses(0)
+      {
+      }
+      ~Stripe(){
+          _CLDELETE(current);
+          _CLDELETE(previous);
+      }
+
+      /** Drops the older generation, if the current one is full */
+      void makeRoom(const int32_t generationSize){
+          if ( (int32_t)current->size() < generationSize )
+              return;
+          Generation* tmp = previous;
+          previous = current;
+          current = tmp;
+          current->clear();
+      }
+  };
+
+  TermInfosCache::TermInfosCache(const int32_t size){
+      generationSize = cl_max(1, size / (2 * STRIPES));
+      stripes = _CL_NEWARRAY(Stripe*, STRIPES);
+      for ( int32_t i = 0; i < STRIPES; i++ )
+          stripes[i] = _CLNEW Stripe;
+  }
+
+  TermInfosCache::~TermInfosCache(){
+      for ( int32_t i = 0; i < STRIPES; i++ )
+          _CLDELETE(stripes[i]);
+      _CLDELETE_ARRAY(stripes);
+  }
+
+  TermInfosCache::Stripe* TermInfosCache::stripeFor(const Key& key) const{
+      return stripes[(key.hash ^ (key.hash >> 16)) % STRIPES];
+  }
+
+  TermInfo* TermInfosCache::get(const Term* term){
+      Key key(term);
+      Stripe* stripe = stripeFor(key);
+      SCOPED_LOCK_MUTEX(stripe->THIS_LOCK)
+      Stripe::Generation::iterator itr = stripe->current->find(&key);
+      if ( itr != stripe->current->end() ){
+          stripe->hits++;
+          return _CLNEW TermInfo(itr->second);
+      }
+
+      itr = stripe->previous->find(&key);
+      if ( itr == stripe->previous->end() ){
+          stripe->misses++;
+          return NULL;
+      }
+
+      //still in use: move it into the current generation
+      stripe->hits++;
+      Key* cached = itr->first;
+      TermInfo* ti = itr->second;
+      stripe->previous->removeitr(itr, true, true);
+      stripe->makeRoom(generationSize);
+      stripe->current->put(cached, ti);
+      return _CLNEW TermInfo(ti);
+  }
+
+  void TermInfosCache::put(const Term* term, const TermInfo* ti){
+      Key key(term);
+      Stripe* stripe = stripeFor(key);
+      SCOPED_LOCK_MUTEX(stripe->THIS_LOCK)
+      if ( stripe->current->exists(&key) )
+          return;
+      stripe->previous->remove(&key);
+      stripe->makeRoom(generationSize);
+      stripe->current->put(_CLNEW Key(key), _CLNEW TermInfo(ti));
+  }
+
+  int32_t TermInfosCache::size() const{
+      int32_t ret = 0;
+      for ( int32_t i = 0; i < STRIPES; i++ ){
+          SCOPED_LOCK_MUTEX(stripes[i]->THIS_LOCK)
+          ret += (int32_t)(stripes[i]->current->size() + stripes[i]->previous->size());
+      }
+      return ret;
+  }
+
+  int64_t TermInfosCache::getHits() const{
+      int64_t ret = 0;
+      for ( int32_t i = 0; i < STRIPES; i++ ){
+          SCOPED_LOCK_MUTEX(stripes[i]->THIS_LOCK)
+          ret += stripes[i]->hits;
+      }
+      return ret;
+  }
+
+  int64_t TermInfosCache::getMisses() const{
+      int64_t ret = 0;
+      for ( int32_t i = 0; i < STRIPES; i++ ){
+          SCOPED_LOCK_MUTEX(stripes[i]->THIS_LOCK)
+          ret += stripes[i]->misses;
+      }
+      return ret;
+  }
+
+
   TermInfosReader::TermInfosReader(Directory* dir, const wchar_t * seg, FieldInfos* fis, const int32_t readBufferSize):
-      directory (dir),fieldInfos (fis), indexTerms(NULL), indexInfos(NULL), indexPointers(NULL), indexDivisor(1)
+      directory (dir),fieldInfos (fis), index(NULL), cache(NULL), indexDivisor(1)
   {
   //Func - Constructor.
   //       Reads the TermInfos file (.tis) and eventually the Term Info Index file (.tii)
@@ -48,7 +413,9 @@ CL_NS_DEF(index)
 	  std::wstring tiiFile = Misc::segmentname(segment,L".tii");
 	  bool success = false;
     origEnum = indexEnum = NULL;
-    _size = indexTermsLength = totalIndexInterval = 0;
+    _size = totalIndexInterval = 0;
+    if ( LUCENE_TERMINFOS_CACHE_SIZE > 0 )
+      cache = _CLNEW TermInfosCache(LUCENE_TERMINFOS_CACHE_SIZE);
 
 	  try {
 		  //Create an SegmentTermEnum for storing all the terms read of the segment
@@ -93,11 +460,15 @@ CL_NS_DEF(index)
     return origEnum->maxSkipLevels;
   }
 
+  bool TermInfosReader::hasMaxFreqs() const {
+    return origEnum->format <= -4;
+  }
+
   void TermInfosReader::setIndexDivisor(const int32_t _indexDivisor) {
-	  if (indexDivisor < 1)
+	  if (_indexDivisor < 1)
 		  _CLTHROWA(CL_ERR_IllegalArgument, "indexDivisor must be > 0");
 
-	  if (indexTerms != NULL)
+	  if (index != NULL)
 		  _CLTHROWA(CL_ERR_IllegalArgument, "index terms are already loaded");
 
 	  this->indexDivisor = _indexDivisor;
@@ -107,22 +478,11 @@ CL_NS_DEF(index)
   int32_t TermInfosReader::getIndexDivisor() const { return indexDivisor; }
   void TermInfosReader::close() {
 
-	  //Check if indexTerms and indexInfos exist
-     if (indexTerms && indexInfos){
-          //Iterate through arrays indexTerms and indexPointer to
-	      //destroy their elements
-#ifdef _DEBUG
-         for ( int32_t i=0; i<indexTermsLength;++i ){
-            indexTerms[i].__cl_refcount--;
-         }
-#endif
-         //Delete the arrays
-         delete [] indexTerms;
-         _CLDELETE_ARRAY(indexInfos);
-     }
-
-      //Delete the arrays
-      _CLDELETE_ARRAY(indexPointers);
+      //Delete the term index and the term cache
+      TermInfosIndex* tmp = index;
+      index = NULL;
+      _CLDELETE(tmp);
+      _CLDELETE(cache);
 
       if (origEnum != NULL){
         origEnum->close();
@@ -172,6 +532,7 @@ CL_NS_DEF(index)
       if (_size == 0)
           return NULL;
 
+	  ensureIndexIsRead();
 	  SegmentTermEnum* enumerator = getEnum();
 
 	  if (
@@ -201,6 +562,10 @@ CL_NS_DEF(index)
   }
 
   TermInfo* TermInfosReader::get(const Term* term){
+    return get(term, true);
+  }
+
+  TermInfo* TermInfosReader::get(const Term* term, const bool useCache){
   //Func - Returns a TermInfo for a term
   //Pre  - term holds a valid reference to term
   //Post - if term can be found its TermInfo has been returned otherwise NULL
@@ -211,6 +576,12 @@ CL_NS_DEF(index)
 
     ensureIndexIsRead();
 
+    if ( useCache && cache != NULL ){
+      TermInfo* ti = cache->get(term);
+      if ( ti != NULL )
+        return ti;
+    }
+
     // optimize sequential access: first try scanning cached enum w/o seeking
     SegmentTermEnum* enumerator = getEnum();
 
@@ -231,21 +602,46 @@ CL_NS_DEF(index)
 
 		// but before end of block
 		if (
-			//the length of indexTerms (the number of terms in enumerator) equals
+			//the length of the index (the number of terms in enumerator) equals
 			//_enum_offset OR
-			indexTermsLength == _enumOffset	 ||
-			//term is positioned in front of term found at _enumOffset in indexTerms
-			term->compareTo(&indexTerms[_enumOffset]) < 0){
+			index->size() == _enumOffset	 ||
+			//term is positioned in front of term found at _enumOffset in the index
+			compareIndexTerm(enumerator, term, _enumOffset) < 0){
 
 			//no need to seek, retrieve the TermInfo for term
-			return scanEnum(term);
+			int32_t numScans = enumerator->scanTo(term);
+			if (enumerator->term(false) == NULL || !term->equals(enumerator->term(false)))
+				return NULL;
+			TermInfo* ti = enumerator->getTermInfo();
+			// only cache terms that had to be scanned for, so that looking
+			// up many terms in order (as range and wildcard queries do)
+			// does not wipe out the cache
+			if ( useCache && cache != NULL && numScans > 1 )
+				cache->put(term, ti);
+			return ti;
         }
     }
 
     //Reposition current term in the enumeration
     seekEnum(getIndexOffset(term));
 	//Return the TermInfo for term
-    return scanEnum(term);
+    TermInfo* ti = scanEnum(term);
+    if ( ti != NULL && useCache && cache != NULL )
+      cache->put(term, ti);
+    return ti;
+  }
+
+  int64_t TermInfosReader::getCacheHits() const{
+    return cache == NULL ? 0 : cache->getHits();
+  }
+
+  int64_t TermInfosReader::getCacheMisses() const{
+    return cache == NULL ? 0 : cache->getMisses();
+  }
+
+  size_t TermInfosReader::getIndexRamBytesUsed() const{
+    const TermInfosIndex* tmp = (const TermInfosIndex*)_LUCENE_ATOMIC_PTR_GET(&index);
+    return tmp == NULL ? 0 : tmp->ramBytesUsed();
   }
 
 
@@ -285,7 +681,8 @@ CL_NS_DEF(index)
 	  SegmentTermEnum* enumerator = NULL;
 	  if ( term != NULL ){
 		//Seek enumerator to term; delete the new TermInfo that's returned.
-		TermInfo* ti = get(term);
+		//The cache is bypassed, because it would not move the enumerator.
+		TermInfo* ti = get(term, false);
 		_CLLDELETE(ti);
 		enumerator = getEnum();
 	  }else
@@ -296,51 +693,57 @@ CL_NS_DEF(index)
 
       //Check if cln points to a valid instance
       CND_CONDITION(cln != NULL,L"cln is NULL");
+      cln->termInfos = this;
 
       return cln;
   }
 
 
+  bool TermInfosReader::skipTo(SegmentTermEnum* enumerator, const Term* target) {
+	  ensureIndexIsRead();
+
+	  //seek only if target is at or beyond the next indexed term, scanning
+	  //the rest of the current block is cheaper otherwise
+	  const int32_t enumOffset = (int32_t)(enumerator->position/totalIndexInterval)+1;
+	  if ( enumerator->term(false) != NULL && enumOffset < index->size() &&
+	       compareIndexTerm(enumerator, target, enumOffset) >= 0 ){
+		  const int32_t indexOffset = getIndexOffset(target);
+		  Term term;
+		  index->getTerm(indexOffset, &term);
+		  enumerator->seek(index->getPointer(indexOffset), (indexOffset * totalIndexInterval) - 1,
+			  &term, index->getTermInfo(indexOffset));
+		  if ( target->compareTo(enumerator->term(false)) <= 0 )
+			  return true;
+	  }
+
+	  do {
+		  if ( !enumerator->next() )
+			  return false;
+	  } while ( target->compareTo(enumerator->term(false)) > 0 );
+	  return true;
+  }
+
   void TermInfosReader::ensureIndexIsRead() {
   //Func - Reads the term info index file or .tti file.
   //       This file contains every IndexInterval-th entry from the .tis file,
   //       along with its location in the "tis" file. This is designed to be read entirely
   //       into memory and used to provide random access to the "tis" file.
-  //Pre  - indexTerms    = NULL
-  //       indexInfos    = NULL
-  //       indexPointers = NULL
+  //Pre  - index = NULL
   //Post - The term info index file has been read into memory
 
+    //the index is never replaced once it is read, so only the first
+    //lookups need to take the lock. The index is published with a release
+    //and checked with an acquire, so a thread that sees it sees all of it
+    if ( _LUCENE_ATOMIC_PTR_GET(&index) != NULL )
+      return;
+
     SCOPED_LOCK_MUTEX(THIS_LOCK)
 
-	  if ( indexTerms != NULL )
+	  if ( index != NULL )
 		  return;
 
       try {
-          indexTermsLength = (size_t)indexEnum->size;
-
-		      //Instantiate an block of Term's,so that each one doesn't have to be new'd
-          indexTerms    = new Term[indexTermsLength];
-          CND_CONDITION(indexTerms != NULL,L"No memory could be allocated for indexTerms");//Check if is indexTerms is a valid array
-
-		  //Instantiate an big block of TermInfo's, so that each one doesn't have to be new'd
-          indexInfos    = _CL_NEWARRAY(TermInfo,indexTermsLength);
-          CND_CONDITION(indexInfos != NULL,L"No memory could be allocated for indexInfos"); //Check if is indexInfos is a valid array
-
-          //Instantiate an array indexPointers that contains pointers to the term info index file
-          indexPointers = _CL_NEWARRAY(int64_t,indexTermsLength);
-          CND_CONDITION(indexPointers != NULL,L"No memory could be allocated for indexPointers");//Check if is indexPointers is a valid array
-
-		  //Iterate through the terms of indexEnum
-          for (int32_t i = 0; indexEnum->next(); ++i){
-              indexTerms[i].set(indexEnum->term(false),indexEnum->term(false)->text());
-              indexEnum->getTermInfo(&indexInfos[i]);
-              indexPointers[i] = indexEnum->indexPointer;
-
-			        for (int32_t j = 1; j < indexDivisor; j++)
-				        if (!indexEnum->next())
-					        break;
-          }
+          _LUCENE_ATOMIC_PTR_SET(&index, _CLNEW TermInfosIndex(indexEnum, indexDivisor));
     }_CLFINALLY(
           indexEnum->close();
 		  //Close and delete the IndexInput is. The close is done by the destructor.
@@ -353,61 +756,43 @@ CL_NS_DEF(index)
   int32_t TermInfosReader::getIndexOffset(const Term* term){
   //Func - Returns the offset of the greatest index entry which is less than or equal to term.
   //Pre  - term holds a reference to a valid term
-  //       indexTerms != NULL
+  //       index != NULL
   //Post - The new offset has been returned
 
-      //Check if is indexTerms is a valid array
-      CND_PRECONDITION(indexTerms != NULL,L"indexTerms is NULL");
-
-      int32_t lo = 0;
-      int32_t hi = indexTermsLength - 1;
-	  int32_t mid;
-	  int32_t delta;
-
-      while (hi >= lo) {
-          //Start in the middle betwee hi and lo
-          mid = (lo + hi) >> 1;
-
-          //Check if is indexTerms[mid] is a valid instance of Term
-          CND_PRECONDITION(&indexTerms[mid] != NULL,L"indexTerms[mid] is NULL");
-          CND_PRECONDITION(mid < indexTermsLength,L"mid >= indexTermsLength");
+      CND_PRECONDITION(index != NULL,L"index is NULL");
+      return index->getIndexOffset(term);
+  }
 
-		  //Determine if term is before mid or after mid
-          delta = term->compareTo(&indexTerms[mid]);
-          if (delta < 0){
-              //Calculate the new hi
-              hi = mid - 1;
-          }else if (delta > 0){
-                  //Calculate the new lo
-                  lo = mid + 1;
-			  }else{
-                  //term has been found so return its position
-                  return mid;
-          }
-     }
-     // the new starting offset
-     return hi;
+  int32_t TermInfosReader::compareIndexTerm(SegmentTermEnum* enumerator, const Term* term, const int32_t offset){
+      //lookups in order compare with the same index term until they pass
+      //it, decode it once rather than its block up to it every time
+      if ( enumerator->indexOffset != offset ){
+          if ( enumerator->indexTerm == NULL )
+              enumerator->indexTerm = _CLNEW Term;
+          index->getTerm(offset, enumerator->indexTerm);
+          enumerator->indexOffset = offset;
+      }
+      return term->compareTo(enumerator->indexTerm);
   }
 
   void TermInfosReader::seekEnum(const int32_t indexOffset) {
   //Func - Reposition the current Term and TermInfo to indexOffset
   //Pre  - indexOffset >= 0
-  //       indexTerms    != NULL
-  //       indexInfos    != NULL
-  //       indexPointers != NULL
+  //       index != NULL
   //Post - The current Term and Terminfo have been repositioned to indexOffset
 
       CND_PRECONDITION(indexOffset >= 0, L"indexOffset contains a negative number");
-      CND_PRECONDITION(indexTerms != NULL,    L"indexTerms is NULL");
-      CND_PRECONDITION(indexInfos != NULL,    L"indexInfos is NULL");
-      CND_PRECONDITION(indexPointers != NULL, L"indexPointers is NULL");
+      CND_PRECONDITION(index != NULL, L"index is NULL");
+
+	  Term term;
+	  index->getTerm(indexOffset, &term);
 
 	  SegmentTermEnum* enumerator =  getEnum();
 	  enumerator->seek(
-          indexPointers[indexOffset],
+          index->getPointer(indexOffset),
 		  (indexOffset * totalIndexInterval) - 1,
-          &indexTerms[indexOffset],
-		  &indexInfos[indexOffset]
+          &term,
+		  index->getTermInfo(indexOffset)
 	      );
   }
 
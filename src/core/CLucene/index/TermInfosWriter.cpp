@@ -180,6 +180,7 @@ CL_NS_DEF(index)
 		if (ti->docFreq >= skipInterval) {
 			output->writeVInt(ti->skipOffset);
 		}
+		output->writeVInt(ti->maxFreq);
 
 		if (isIndex){
 			output->writeVLong(other->output->getFilePointer() - lastIndexPointer);
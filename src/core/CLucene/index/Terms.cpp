@@ -15,6 +15,19 @@ CL_NS_DEF(index)
 TermDocs::~TermDocs(){
 }
 
+int32_t TermDocs::maxFreq(){
+	return -1;
+}
+
+int32_t TermDocs::maxFreqInBlock(const int32_t /*target*/, int32_t& blockEnd){
+	blockEnd = LUCENE_INT32_MAX_SHOULDBE;
+	return maxFreq();
+}
+
+int32_t TermDocs::docFreq(){
+	return -1;
+}
+
 TermEnum::~TermEnum(){
 }
 
@@ -29,4 +42,9 @@ bool TermEnum::skipTo(Term* target){
 TermPositions::~TermPositions(){
 }
 
+void TermPositions::nextPositions(int32_t* positions, const int32_t length){
+	for ( int32_t i=0;i<length;i++ )
+		positions[i] = nextPosition();
+}
+
 CL_NS_END
@@ -73,6 +73,25 @@ public:
 	// Some implementations are considerably more efficient than that.
 	virtual bool skipTo(const int32_t target)=0;
 
+	// Expert: Returns the largest frequency of the term in a document, or -1
+	// if it is not known, e.g. for segments written before it was recorded.
+	// Together with maxFreqInBlock() this bounds the scores of documents that
+	// were not read yet, see TermScorer. The default returns -1.
+	virtual int32_t maxFreq();
+
+	// Expert: Returns the largest frequency of the term in the block of
+	// documents that holds <i>target</i>, and sets <i>blockEnd</i> to the last
+	// document of the block, without moving the enumeration. Returns -1 if it
+	// is not known. <i>target</i> should not be less than in earlier calls,
+	// nor than the target of earlier calls of skipTo(). The default returns
+	// maxFreq() for a block that runs to the end.
+	virtual int32_t maxFreqInBlock(const int32_t target, int32_t& blockEnd);
+
+	// Expert: Returns the number of documents of the term, counting deleted
+	// ones like IndexReader::docFreq(), without looking the term up again.
+	// The default returns -1, for unknown.
+	virtual int32_t docFreq();
+
 	// Frees associated resources.
 	virtual void close() = 0;
 
@@ -145,6 +164,13 @@ public:
     */
 	virtual int32_t nextPosition() = 0;
 
+	/** Reads the next length positions of the current document into
+	* positions, the same as calling {@link #nextPosition()} length times.
+	* It is an error to read more than {@link #freq()} positions of a
+	* document.
+	*/
+	virtual void nextPositions(int32_t* positions, const int32_t length);
+
 	virtual ~TermPositions();
 
     /** 
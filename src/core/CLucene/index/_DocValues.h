@@ -0,0 +1,118 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#pragma once
+
+#include "CLucene/clucene-config.h"
+#include "CLucene/util/Array.h"
+#include "CLucene/LuceneThreads.h"
+#include "DocValues.h"
+#include <map>
+
+CL_CLASS_DEF(document,Document)
+CL_CLASS_DEF(store,Directory)
+CL_CLASS_DEF(store,IndexInput)
+CL_CLASS_DEF(store,IndexOutput)
+CL_CLASS_DEF(index,FieldInfo)
+CL_CLASS_DEF(index,FieldInfos)
+CL_CLASS_DEF(index,IndexReader)
+
+CL_NS_DEF(index)
+
+/**
+* Buffers the doc values of a segment and writes them to its .dv file.
+*
+* The file starts with FORMAT_CURRENT, followed by one section per field,
+* a directory of the sections (VInt count, then for each a VInt field
+* number, the type byte and a VLong pointer) and a Long pointer to the
+* directory. A numeric section is the smallest value as a Long, a bits per
+* value byte and each document's value minus the smallest, packed as in
+* PackedInts (nothing if all values are equal). A sorted section is the
+* VInt count of distinct values, the VInt total of their characters, the
+* values in natural order as VInt length and chars, a bits per value byte
+* and each document's ordinal, packed the same way. Packed values are
+* little-endian 64 bit words, so they can be used right out of a mapped file.
+*/
+class DocValuesWriter :LUCENE_BASE{
+	class FieldValues;
+	std::vector<FieldValues*> fields; // by field number, NULL for fields without values
+
+	FieldValues* getField(const FieldInfo* fi, const uint8_t type);
+public:
+	LUCENE_STATIC_CONSTANT(int32_t, FORMAT_CURRENT = -1);
+
+	DocValuesWriter();
+	~DocValuesWriter();
+
+	// Sets the numeric value of doc, the last one counts if it has several
+	void addNumeric(const FieldInfo* fi, const int32_t doc, const int64_t value);
+
+	// Sets the string value of doc, the last one counts if it has several
+	void addSorted(const FieldInfo* fi, const int32_t doc, const wchar_t* value);
+
+	// Adds the values of doc in the fields of doc, which the caller has
+	// added to fieldInfos. Throws CL_ERR_NumberFormat for a numeric field
+	// that is not a decimal integer.
+	void addDocument(FieldInfos* fieldInfos, const CL_NS(document)::Document* doc, const int32_t docID);
+
+	// True if any values were added since the last reset
+	bool hasValues() const;
+
+	// Writes the values of numDocs documents to the .dv file of segment and resets
+	void write(CL_NS(store)::Directory* directory, const std::wstring& segment, const int32_t numDocs);
+
+	// Drops all values
+	void reset();
+};
+
+/**
+* Reads the .dv file of a segment. The values of a field are loaded the
+* first time they are asked for and kept until the reader is deleted. The
+* packed values are used straight from the input when it can hand them out
+* in one piece (see IndexInput::bufferedBytes()), which is the case for
+* mapped files, otherwise they are read into memory.
+*/
+class DocValuesReader :LUCENE_BASE{
+	class Entry;
+	CL_NS(store)::IndexInput* input;
+	int32_t maxDoc;
+	std::vector<Entry*> entries; // by field number, NULL for fields without values
+	DEFINE_MUTEX(THIS_LOCK)
+
+	Entry* getEntry(const FieldInfo* fi, const uint8_t type);
+public:
+	DocValuesReader(CL_NS(store)::Directory* dir, const wchar_t* segment, const int32_t maxDoc, const int32_t readBufferSize);
+	~DocValuesReader();
+
+	// NULL if the field has no numeric values in this segment
+	NumericDocValues* getNumeric(const FieldInfo* fi);
+
+	// NULL if the field has no sorted values in this segment
+	SortedDocValues* getSorted(const FieldInfo* fi);
+};
+
+/**
+* The doc values of readers made of sub readers, seen through their doc
+* numbers. Sorted values get ordinals across all sub readers, mapped from
+* the ordinals of each, so that only the distinct values are merged and
+* not the documents. Callers synchronize.
+*/
+class MultiDocValues :LUCENE_BASE{
+	class Numeric;
+	class Sorted;
+	std::map<std::wstring, NumericDocValues*> numeric;
+	std::map<std::wstring, SortedDocValues*> sorted;
+public:
+	MultiDocValues();
+	~MultiDocValues();
+
+	NumericDocValues* getNumeric(const wchar_t* field, CL_NS(util)::ArrayBase<IndexReader*>* subReaders, const int32_t* starts);
+	SortedDocValues* getSorted(const wchar_t* field, CL_NS(util)::ArrayBase<IndexReader*>* subReaders, const int32_t* starts);
+};
+
+CL_NS_END
@@ -26,7 +26,8 @@ CL_CLASS_DEF(util, StringReader)
 CL_NS_DEF(index)
 
 class DocumentsWriter;
-class DefaultSkipListWriter;
+class PostingsWriter;
+class DocValuesWriter;
 class FieldInfos;
 class FieldsWriter;
 class FieldInfos;
@@ -334,6 +335,14 @@ private:
      * pools to match the current docs. */
     void balanceRAM();
 
+    /** Bytes in the free blocks of idle ThreadStates */
+    int64_t threadBlocksFree();
+
+    /** Moves the free blocks of idle ThreadStates to the
+     *  shared pool, so that balanceRAM can free them.
+     *  Returns the number of bytes moved. */
+    int64_t reclaimIdleBlocks();
+
     std::vector<std::wstring>* _files;                      // Cached list of files we've created
     std::vector<std::wstring>* _abortedFiles;               // List of files that were written before last abort()
 
@@ -341,7 +350,7 @@ private:
 
     bool hasNorms;                       // Whether any norms were seen since last flush
 
-    DefaultSkipListWriter* skipListWriter;
+    PostingsWriter* postingsWriter;
 
     bool currentFieldStorePayloads;
 
@@ -513,6 +522,14 @@ private:
         ByteBlockPool* vectorsPool;
         CharBlockPool* charPool;
 
+        // Blocks this thread's pools gave back.  They are reused
+        // by this thread without taking the DocumentsWriter lock,
+        // and trimmed to the thread's share of the RAM buffer
+        // after each flush (see trimBlocks).  balanceRAM takes
+        // them back while the thread is idle
+        FreeByteBlocksType freeByteBlocksTS;
+        FreeCharBlocksType freeCharBlocksTS;
+
         // Current posting we are working on
         Posting* p;
         PostingVector* vector;
@@ -596,6 +613,27 @@ private:
           *  shared pool */
         void resetPostings();
 
+        /** Get a uint8_t[] block, from this thread's free blocks
+          *  if it has any, else from the shared pool */
+        uint8_t* getByteBlock(bool trackAllocations);
+
+        /** Get a char[] block, from this thread's free blocks if
+          *  it has any, else from the shared pool */
+        wchar_t* getCharBlock();
+
+        /** Keep blocks for reuse by this thread */
+        void recycleBlocks(CL_NS(util)::ArrayBase<uint8_t*>& blocks, int32_t start, int32_t end);
+        void recycleBlocks(CL_NS(util)::ArrayBase<wchar_t*>& blocks, int32_t start, int32_t numBlocks);
+
+        /** Give free blocks beyond maxBytes back to the shared
+          *  pool, so that balanceRAM can free them.  Only called
+          *  under the DocumentsWriter lock while this ThreadState
+          *  is idle. A negative maxBytes keeps all blocks. */
+        void trimBlocks(int64_t maxBytes);
+
+        /** Bytes held in this thread's free blocks */
+        int64_t freeBlockBytes() const;
+
         /** Move all per-document state that was accumulated in
           *  the ThreadState into the "real" stores. */
         void writeDocument();
@@ -713,8 +751,9 @@ private:
 
     class CharBlockPool : public BlockPool<wchar_t>
     {
+        ThreadState* threadState;
     public:
-        CharBlockPool(DocumentsWriter* _parent);
+        CharBlockPool(DocumentsWriter* _parent, ThreadState* _threadState);
         virtual ~CharBlockPool();
         wchar_t* getNewBlock(bool trackAllocations);
         void reset();
@@ -722,8 +761,9 @@ private:
     };
     class ByteBlockPool : public BlockPool<uint8_t>
     {
+        ThreadState* threadState;
     public:
-        ByteBlockPool(bool _trackAllocations, DocumentsWriter* _parent);
+        ByteBlockPool(bool _trackAllocations, DocumentsWriter* _parent, ThreadState* _threadState);
         virtual ~ByteBlockPool();
         uint8_t* getNewBlock(bool trackAllocations);
         int32_t newSlice(const int32_t size);
@@ -736,7 +776,8 @@ private:
 
 
     // Max # ThreadState instances; if there are more threads
-    // than this they share ThreadStates
+    // than this they share ThreadStates.  See
+    // LUCENE_MAX_INDEXING_THREADS
     static const int32_t MAX_THREAD_STATE;
     CL_NS(util)::ValueArray<ThreadState*> threadStates;
     CL_NS(util)::CLHashMap<_LUCENE_THREADID_TYPE, ThreadState*,
@@ -748,10 +789,12 @@ private:
     int32_t pauseThreads;                       // Non-zero when we need all threads to
                                                     // pause (eg to flush)
     bool flushPending;                   // True when a thread has decided to flush
-    bool bufferIsFull;                   // True when it's time to write segment
+    bool bufferIsFull;                   // True when it's time to write segment;
+                                         // read and written under THIS_LOCK
     int32_t abortCount;                         // Non-zero while abort is pending or running
 
     CL_NS(util)::ObjectArray<BufferedNorms> norms;   // Holds norms until we flush
+    DocValuesWriter* docValuesWriter;                 // Holds doc values until we flush
 
     /** Does the synchronized work to finish/flush the
      * inverted document. */
@@ -872,9 +915,7 @@ public:
      * instances) found in this field and serialize them
      * into a single RAM segment. */
     void appendPostings(CL_NS(util)::ArrayBase<ThreadState::FieldData*>* fields,
-        TermInfosWriter* termsOut,
-        CL_NS(store)::IndexOutput* freqOut,
-        CL_NS(store)::IndexOutput* proxOut);
+        TermInfosWriter* termsOut);
 
     void close();
 
@@ -914,18 +955,25 @@ public:
 
     int64_t getRAMUsed();
 
+    // Changed only while holding THIS_LOCK
     int64_t numBytesAlloc;
-    int64_t numBytesUsed;
+    // Changed with _LUCENE_ATOMIC_ADD64 and read with
+    // getRAMUsed, because threads add the blocks they reuse
+    // from their own free lists without taking THIS_LOCK
+    volatile int64_t numBytesUsed;
+
+    /** Adds to numBytesUsed without locking.  Takes THIS_LOCK
+     *  only to mark the buffer full once the RAM buffer is used
+     *  up, like balanceRAM does when it allocates. */
+    void addBytesUsed(int64_t bytes);
 
     /* Used only when writing norms to fill in default norm
      * value into the holes in docID stream for those docs
      * that didn't have this field. */
     static void fillBytes(CL_NS(store)::IndexOutput* out, uint8_t b, int32_t numBytes);
 
-    uint8_t* copyByteBuffer;
-
-    /** Copy numBytes from srcIn to destIn */
-    void copyBytes(CL_NS(store)::IndexInput* srcIn, CL_NS(store)::IndexOutput* destIn, int64_t numBytes);
+    /** Holds the payload appendPostings() copies over */
+    CL_NS(util)::ValueArray<uint8_t> payloadBuffer;
 
 
     // Size of each slice.  These arrays should be at most 16
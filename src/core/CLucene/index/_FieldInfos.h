@@ -9,6 +9,7 @@
 #ifndef _lucene_index_FieldInfos_
 #define _lucene_index_FieldInfos_
 
+#include "CLucene/clucene-config.h"
 #include "CLucene/store/Directory.h"
 
 CL_CLASS_DEF(document,Document)
@@ -36,6 +37,10 @@ class FieldInfo :LUCENE_BASE{
 
 	bool storePayloads; // whether this field stores payloads together with term positions
 
+	// 0, or FieldInfos::DOC_VALUES_NUMERIC or DOC_VALUES_SORTED if the field
+	// has per-document values in the segment's doc values file
+	uint8_t docValuesType;
+
 	//Func - Constructor
 	//       Initialises FieldInfo.
 	//       na holds the name of the field
@@ -66,6 +71,12 @@ class FieldInfo :LUCENE_BASE{
 	* @memory - caller is responsible for deleting the returned object
 	*/
 	FieldInfo* clone();
+
+	/** Sets how the per-document values of this field are stored, once set
+	* it cannot change. 0 leaves it as it is.
+	* @throws CL_ERR_IllegalArgument if the field already has the other type
+	*/
+	void setDocValuesType(const uint8_t type);
 };
 
 /** Access to the Field Info file that describes document fields and whether or
@@ -91,6 +102,19 @@ public:
 		STORE_PAYLOADS = 0x20
 	};
 
+	/** Types of per-document values. They are written in a byte of their
+	 *  own, because Lucene gives the free bits above to other flags
+	 *  (0x40 is OMIT_TF in Lucene 2.4) */
+	enum{
+		DOC_VALUES_NUMERIC = 1,
+		DOC_VALUES_SORTED = 2
+	};
+
+	/** .fnm files that start with this have the doc values type of each
+	 *  field after its bits. Lucene has used -1 to -3, and files without
+	 *  doc values are written without a format, as before */
+	LUCENE_STATIC_CONSTANT(int32_t, FORMAT_DOC_VALUES = -16);
+
 	FieldInfos();
 	~FieldInfos();
 
@@ -186,6 +210,7 @@ public:
 
 	size_t size()const;
   	bool hasVectors() const;
+	bool hasDocValues() const;
 
 
 	void write(CL_NS(store)::Directory* d, const wchar_t * name) const;
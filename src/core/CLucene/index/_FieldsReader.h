@@ -14,6 +14,7 @@ CL_CLASS_DEF(store,Directory)
 CL_CLASS_DEF(document,Document)
 #include "CLucene/document/Field.h"
 CL_CLASS_DEF(document,FieldSelector)
+CL_CLASS_DEF(document,StoredFieldVisitor)
 CL_CLASS_DEF(index, FieldInfo)
 CL_CLASS_DEF(index, FieldInfos)
 CL_CLASS_DEF(store,IndexInput)
@@ -45,6 +46,27 @@ CL_NS_DEF(index)
 		// file.  This will be 0 if we have our own private file.
 		int32_t docStoreOffset;
 
+		// Set if the .fdx starts with FieldsWriter::FORMAT_BLOCKS. The .fdt
+		// then holds compressed blocks of documents, read by blocksStream,
+		// and fieldsStream reads the current document out of its block.
+		bool compressedBlocks;
+		int32_t indexHeaderLength;
+		CL_NS(store)::IndexInput* blocksStream;
+
+		class BlockInput;
+		struct Block;
+		// The last LUCENE_STORED_FIELDS_BLOCK_CACHE blocks used
+		Block** blockCache;
+		int64_t blockCacheUse;
+		const Block* loadBlock(const int64_t pointer);
+
+		// Positions fieldsStream at the n'th document, false if there is none
+		bool seekDocument(int32_t n);
+
+		// Reused by visitDocument() for the values it hands out
+		CL_NS(util)::ValueArray<wchar_t> visitChars;
+		CL_NS(util)::ValueArray<uint8_t> visitBytes;
+
 		DEFINE_MUTEX(THIS_LOCK)
 		CL_NS(util)::ThreadLocal<CL_NS(store)::IndexInput*, CL_NS(util)::Deletor::Object<CL_NS(store)::IndexInput> > fieldsStreamTL;
     static void uncompress(const CL_NS(util)::ValueArray<uint8_t>& input, CL_NS(util)::ValueArray<uint8_t>& output);
@@ -59,6 +81,9 @@ CL_NS_DEF(index)
 		*/
 		void ensureOpen();
 
+		/** Passes an access hint on to the .fdt and .fdx files */
+		void setAccessPattern(CL_NS(store)::IndexInput::AccessPattern pattern);
+
 		/**
 		* Closes the underlying {@link org.apache.lucene.store.IndexInput} streams, including any ones associated with a
 		* lazy implementation of a Field.  This means that the Fields values will not be accessible.
@@ -72,6 +97,10 @@ CL_NS_DEF(index)
 		/** Loads the fields from n'th document into doc. returns true on success. */
 		bool doc(int32_t n, CL_NS(document)::Document& doc, const CL_NS(document)::FieldSelector* fieldSelector = NULL);
 
+		/** Passes the fields of the n'th document to visitor, see StoredFieldVisitor.
+		* The values point into buffers of this reader. returns true on success. */
+		bool visitDocument(int32_t n, CL_NS(document)::StoredFieldVisitor& visitor);
+
 	protected:
 		/** Returns the length in bytes of each raw document in a
 		*  contiguous range of length numDocs starting with
@@ -79,6 +108,9 @@ CL_NS_DEF(index)
 		*  already seeked to the starting point for startDocID.*/
 		CL_NS(store)::IndexInput* rawDocs(int32_t* lengths, const int32_t startDocID, const int32_t numDocs);
 
+		/** False for compressed blocks, rawDocs() can't be used then. */
+		bool canReadRawDocs() const;
+
 	private:
 		/**
 		* Skip the field.  We still have to read some of the information about the field, but can skip past the actual content.
@@ -30,6 +30,22 @@ private:
 
 	bool doClose;
 
+	// See IndexWriter::setStoredFieldsCompression. When writing compressed
+	// blocks, fieldsStream buffers the documents of the pending block and
+	// blocksStream is the .fdt file.
+	int32_t compression;
+	CL_NS(store)::RAMOutputStream* blockBuffer;
+	CL_NS(store)::IndexOutput* blocksStream;
+	CL_NS(util)::ValueArray<int32_t> blockLengths;
+	int32_t blockDocs;
+	int32_t numDocs;
+	int64_t docStart;
+
+	void startDocument();
+	void finishDocument();
+	// Compresses the pending documents into the .fdt and points their .fdx entries at the block
+	void flushBlock();
+
   static void compress(const CL_NS(util)::ValueArray<uint8_t>& input, CL_NS(util)::ValueArray<uint8_t>& output);
 
 public:
@@ -37,7 +53,17 @@ public:
 	LUCENE_STATIC_CONSTANT(uint8_t, FIELD_IS_BINARY = 0x2);
 	LUCENE_STATIC_CONSTANT(uint8_t, FIELD_IS_COMPRESSED = 0x4);
 
-	FieldsWriter(CL_NS(store)::Directory* d, const wchar_t * segment, FieldInfos* fn);
+	// A .fdx of compressed blocks starts with this, the first pointer of an
+	// uncompressed one is always 0
+	LUCENE_STATIC_CONSTANT(int32_t, FORMAT_BLOCKS = -1);
+
+	// How a block in the .fdt is compressed. LZ4 and DEFLATE match
+	// IndexWriter::STORED_FIELDS_FAST and STORED_FIELDS_HIGH
+	LUCENE_STATIC_CONSTANT(uint8_t, BLOCK_STORED = 0);
+	LUCENE_STATIC_CONSTANT(uint8_t, BLOCK_LZ4 = 1);
+	LUCENE_STATIC_CONSTANT(uint8_t, BLOCK_DEFLATE = 2);
+
+	FieldsWriter(CL_NS(store)::Directory* d, const wchar_t * segment, FieldInfos* fn, int32_t compression = 0);
 	FieldsWriter(CL_NS(store)::IndexOutput* fdx, CL_NS(store)::IndexOutput* fdt, FieldInfos* fn);
 	~FieldsWriter();
 
@@ -47,8 +73,12 @@ public:
 	// in the correct fields format.
 	void flushDocument(int32_t numStoredFields, CL_NS(store)::RAMOutputStream* buffer);
 
+	// Also writes out a pending compressed block, even if it is not full yet
 	void flush();
 
+	// The number of bytes in front of the .fdx entries, 4 for compressed blocks
+	int32_t indexHeaderLength() const;
+
 	void writeField(FieldInfo* fi, CL_NS(document)::Field* field);
 
 	void close();
@@ -19,6 +19,7 @@ public:
 	static const wchar_t* SEGMENTS_GEN;
 	static const wchar_t* DELETABLE;
 	static const wchar_t* NORMS_EXTENSION;
+	static const wchar_t* DOC_VALUES_EXTENSION;
 	static const wchar_t* FREQ_EXTENSION;
 	static const wchar_t* PROX_EXTENSION;
 	static const wchar_t* TERMS_EXTENSION;
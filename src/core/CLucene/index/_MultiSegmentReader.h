@@ -18,6 +18,7 @@ CL_CLASS_DEF(document,Document)
 
 CL_NS_DEF(index)
 class SegmentMergeQueue;
+class MultiDocValues;
 
 class MultiSegmentReader:public DirectoryIndexReader{
   static int32_t readerIndex(const int32_t n, int32_t* starts, int32_t numSubReaders);
@@ -38,6 +39,7 @@ private:
   bool _hasDeletions;
   uint8_t* ones;
   NormsCacheType normsCache;
+  MultiDocValues* docValues;
   int32_t _maxDoc;
   int32_t _numDocs;
 
@@ -62,6 +64,11 @@ public:
   /** Construct reading the named set of readers. */
   MultiSegmentReader(CL_NS(store)::Directory* directory, SegmentInfos* sis, bool closeDirectory);
 
+  /** Construct reading the given readers of the segments of sis, which
+  * this reader takes over. Used by IndexWriter::getReader(). */
+  CLUCENE_LOCAL_DECL MultiSegmentReader(CL_NS(store)::Directory* directory, SegmentInfos* sis, bool closeDirectory,
+      CL_NS(util)::ArrayBase<IndexReader*>* subReaders);
+
   /** This contructor is only used for {@link #reopen()} */
   CLUCENE_LOCAL_DECL MultiSegmentReader(
       CL_NS(store)::Directory* directory,
@@ -91,6 +98,7 @@ public:
 	int32_t maxDoc() const;
 
   bool document(int32_t n, CL_NS(document)::Document& doc, const CL_NS(document)::FieldSelector* fieldSelector);
+  bool document(int32_t n, CL_NS(document)::StoredFieldVisitor& visitor);
 
 	bool isDeleted(const int32_t n);
 	bool hasDeletions() const;
@@ -99,6 +107,10 @@ public:
 	uint8_t* norms(const wchar_t* field);
 	void norms(const wchar_t* field, uint8_t* result);
 
+	// synchronized
+	NumericDocValues* getNumericDocValues(const wchar_t* field);
+	SortedDocValues* getSortedDocValues(const wchar_t* field);
+
 	TermEnum* terms();
 	TermEnum* terms(const Term* term);
 
@@ -136,6 +148,7 @@ protected:
   size_t pointer;
 
   TermDocs* current;              // == segTermDocs[pointer]
+  std::vector<int32_t> subMaxFreqs; // maxFreq() of each sub reader, filled on first use after a seek
   TermDocs* termDocs(const int32_t i); //< internal use only
   virtual TermDocs* termDocs(IndexReader* reader);
   void init(CL_NS(util)::ArrayBase<IndexReader*>* subReaders, const int32_t* starts);
@@ -157,6 +170,14 @@ public:
    /* A Possible future optimization could skip entire segments */
   bool skipTo(const int32_t target);
 
+  int32_t maxFreq();
+
+  /** Uses the blocks of the current sub reader, later ones are bounded as a whole. */
+  int32_t maxFreqInBlock(const int32_t target, int32_t& blockEnd);
+
+  /** Sums the docFreq() of the sub readers */
+  int32_t docFreq();
+
   void close();
 
   virtual TermPositions* __asTermPositions();
@@ -181,6 +202,10 @@ public:
   //Move the current term to the next in the set of enumerations
   bool next();
 
+  //Skips the enumerations which are behind target to it, then moves the
+  //current term to the next in the set of enumerations
+  bool skipTo(Term* target);
+
   //Returns a pointer to the current term of the set of enumerations
   Term* term(bool pointer=true);
 
@@ -206,6 +231,7 @@ public:
   MultiTermPositions(CL_NS(util)::ArrayBase<IndexReader*>* subReaders, const int32_t* s);
   virtual ~MultiTermPositions() {};
   int32_t nextPosition();
+  void nextPositions(int32_t* positions, const int32_t length);
 
   /**
   * Not implemented.
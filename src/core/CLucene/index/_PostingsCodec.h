@@ -0,0 +1,171 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#ifndef _lucene_index_PostingsCodec_
+#define _lucene_index_PostingsCodec_
+
+#include "CLucene/util/Array.h"
+#include "CLucene/util/_ForUtil.h"
+
+CL_CLASS_DEF(store,Directory)
+CL_CLASS_DEF(store,IndexOutput)
+
+CL_NS_DEF(index)
+class TermInfo;
+class TermDocs;
+class TermPositions;
+class SegmentReader;
+class DefaultSkipListWriter;
+class BlockSkipListWriter;
+
+/**
+* Writes the postings (.frq and .prx files) of a new segment, term after
+* term in the order of the term dictionary. For each term startTerm() is
+* called, then startDoc() for each document in the order of the document
+* numbers, each followed by addPosition() for every one of its positions,
+* and finally finishTerm().
+*/
+class PostingsWriter: LUCENE_BASE {
+public:
+	virtual ~PostingsWriter();
+
+	/** Starts the postings of a term of a field which stores payloads or not */
+	virtual void startTerm(const bool storePayloads) = 0;
+
+	/** Adds a document which has freq positions of the term */
+	virtual void startDoc(const int32_t doc, const int32_t freq) = 0;
+
+	/** Adds the next position of the current document. payload is only read
+	* if the field stores payloads */
+	virtual void addPosition(const int32_t position, const uint8_t* payload, const int32_t payloadLength) = 0;
+
+	/** Ends the postings of the term and sets the document frequency and
+	* the file pointers of termInfo */
+	virtual void finishTerm(TermInfo* termInfo) = 0;
+
+	/** Closes the files */
+	virtual void close() = 0;
+};
+
+/**
+* The postings format of segments written before postings codecs existed:
+* doc deltas and freqs as VInts, with a skip entry every skipInterval
+* documents, and position deltas as VInts. See
+* <a href="http://lucene.apache.org/java/docs/fileformats.html">file formats</a>.
+*/
+class VIntPostingsWriter: public PostingsWriter {
+	CL_NS(store)::IndexOutput* freqOut;
+	CL_NS(store)::IndexOutput* proxOut;
+	DefaultSkipListWriter* skipListWriter;
+	int32_t skipInterval;
+
+	bool storePayloads;
+	int64_t freqStart;
+	int64_t proxStart;
+	int32_t df;
+	int32_t lastDoc;
+	int32_t lastPosition;
+	int32_t lastPayloadLength;
+public:
+	VIntPostingsWriter(CL_NS(store)::Directory* directory, const std::wstring& segment,
+		const int32_t skipInterval, const int32_t maxSkipLevels, const int32_t docCount);
+	~VIntPostingsWriter();
+
+	void startTerm(const bool storePayloads);
+	void startDoc(const int32_t doc, const int32_t freq);
+	void addPosition(const int32_t position, const uint8_t* payload, const int32_t payloadLength);
+	void finishTerm(TermInfo* termInfo);
+	void close();
+};
+
+/**
+* The block postings format. Doc deltas and freqs are written in blocks of
+* ForUtil::BLOCK_LENGTH documents, the doc deltas of a block bit-packed with
+* the bits most of them need, then the freqs likewise. The documents of the
+* last, incomplete block are written as VInts like VIntPostingsWriter does.
+* There is a skip entry for every block after the first one, pointing to
+* the block and to the first position of its first document.
+* <p>
+* Position deltas (within each document) are written in blocks of
+* ForUtil::BLOCK_LENGTH too. A block starts with a byte: 0 if the block is
+* packed, or the number of positions of the last, incomplete block which
+* are written as VInts. Fields with payloads have the payload length of
+* each position after the position deltas, packed or as VInts (only where
+* it changes, see VIntPostingsWriter), then the number of payload bytes of
+* the block and the bytes.
+* <p>
+* The packed blocks are decoded in one go by BlockTermDocs and
+* BlockTermPositions, which is much cheaper than one VInt after the other,
+* and skipping goes straight to the block of the target.
+*/
+class BlockPostingsWriter: public PostingsWriter {
+	CL_NS(store)::IndexOutput* freqOut;
+	CL_NS(store)::IndexOutput* proxOut;
+	BlockSkipListWriter* skipListWriter;
+
+	bool storePayloads;
+	int64_t freqStart;
+	int64_t proxStart;
+	int32_t df;
+	int32_t lastDoc;
+	int32_t blockMaxFreq;
+	int32_t termMaxFreq;
+
+	int32_t docDeltas[CL_NS(util)::ForUtil::BLOCK_LENGTH];
+	int32_t freqs[CL_NS(util)::ForUtil::BLOCK_LENGTH];
+	int32_t docUpto;
+
+	int32_t lastPosition;
+	int32_t posDeltas[CL_NS(util)::ForUtil::BLOCK_LENGTH];
+	int32_t payloadLengths[CL_NS(util)::ForUtil::BLOCK_LENGTH];
+	int32_t posUpto;
+	CL_NS(util)::ValueArray<uint8_t> payloadBytes;
+	int32_t payloadUpto;
+
+	/** Writes the buffered positions as one block */
+	void writePositions();
+public:
+	BlockPostingsWriter(CL_NS(store)::Directory* directory, const std::wstring& segment,
+		const int32_t maxSkipLevels, const int32_t docCount);
+	~BlockPostingsWriter();
+
+	void startTerm(const bool storePayloads);
+	void startDoc(const int32_t doc, const int32_t freq);
+	void addPosition(const int32_t position, const uint8_t* payload, const int32_t payloadLength);
+	void finishTerm(TermInfo* termInfo);
+	void close();
+};
+
+/**
+* A format of the postings of a segment, which SegmentInfo records (see
+* IndexWriter::PostingsFormat). Creates the writer of new segments and the
+* TermDocs and TermPositions of readers of segments in that format.
+*/
+class PostingsCodec: LUCENE_BASE {
+public:
+	virtual ~PostingsCodec();
+
+	/** Returns the codec of an IndexWriter::PostingsFormat, throws
+	* CL_ERR_CorruptIndex for an unknown format */
+	static PostingsCodec* forFormat(const int32_t format);
+
+	/** Returns the IndexWriter::PostingsFormat of this codec */
+	virtual int32_t getFormat() const = 0;
+
+	/** Creates the .frq and .prx files of segment, a segment of docCount
+	* documents. skipInterval and maxSkipLevels are those of its term
+	* dictionary, a codec may skip in its own intervals */
+	virtual PostingsWriter* newWriter(CL_NS(store)::Directory* directory, const std::wstring& segment,
+		const int32_t skipInterval, const int32_t maxSkipLevels, const int32_t docCount) = 0;
+
+	virtual TermDocs* newTermDocs(const SegmentReader* reader) = 0;
+	virtual TermPositions* newTermPositions(const SegmentReader* reader) = 0;
+};
+
+CL_NS_END
+#endif
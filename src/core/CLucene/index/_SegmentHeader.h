@@ -27,8 +27,10 @@
 #include "DirectoryIndexReader.h"
 #include "_SkipListReader.h"
 #include "CLucene/util/_ThreadLocal.h"
+#include "CLucene/util/_ForUtil.h"
 
 CL_NS_DEF(index)
+class DocValuesReader;
 class SegmentReader;
 
 class SegmentTermDocs:public virtual TermDocs {
@@ -41,10 +43,8 @@ protected:
   int32_t _doc;
   int32_t _freq;
 
-private:
   int32_t skipInterval;
   int32_t maxSkipLevels;
-  DefaultSkipListReader* skipListReader;
 
   int64_t freqBasePointer;
   int64_t proxBasePointer;
@@ -52,7 +52,19 @@ private:
   int64_t skipPointer;
   bool haveSkipped;
 
+  bool storesMaxFreqs;
+  int32_t termMaxFreq;
+
+private:
+  DefaultSkipListReader* skipListReader;
+
+  /** Creates the skip list reader on first use, and positions it at the start of the term */
+  void initSkipListReader();
+
 protected:
+  /** number of vints read() decodes from the freqStream buffer at once */
+  LUCENE_STATIC_CONSTANT(int32_t, DECODE_BLOCK_SIZE = 128);
+
   bool currentFieldStoresPayloads;
 
 public:
@@ -76,6 +88,14 @@ public:
   /** Optimized implementation. */
   virtual bool skipTo(const int32_t target);
 
+  virtual int32_t maxFreq();
+
+  /** Uses the largest frequency stored with each skip entry. */
+  virtual int32_t maxFreqInBlock(const int32_t target, int32_t& blockEnd);
+
+  /** The docFreq of the TermInfo of the last seek */
+  virtual int32_t docFreq();
+
   virtual TermPositions* __asTermPositions();
 
 protected:
@@ -113,6 +133,10 @@ public:
   void close();
 
   int32_t nextPosition();
+
+  /** Decodes the positions from the proxStream buffer in blocks where the
+  * field has no payloads */
+  void nextPositions(int32_t* positions, const int32_t length);
 private:
   int32_t readDeltaPosition();
 
@@ -163,6 +187,121 @@ private:
 };
 
 
+/**
+* The TermDocs of segments in the block postings format, see
+* BlockPostingsWriter. Decodes a whole block of doc deltas and freqs at a
+* time, and skips from block to block.
+*/
+class BlockTermDocs: public SegmentTermDocs {
+private:
+  BlockSkipListReader* blockSkipListReader;
+
+  int32_t docBuffer[CL_NS(util)::ForUtil::BLOCK_LENGTH];
+  int32_t freqBuffer[CL_NS(util)::ForUtil::BLOCK_LENGTH];
+  int32_t docBufferUpto;
+  int32_t docBufferSize;
+
+  /** Decodes the next block of documents, all of the current one were read */
+  void refill();
+
+  /** Creates the skip list reader on first use, and positions it at the start of the term */
+  void initSkipListReader();
+
+public:
+  ///\param Parent must be a segment reader
+  BlockTermDocs(const SegmentReader* Parent);
+  virtual ~BlockTermDocs();
+
+  virtual void seek(const TermInfo* ti,Term* term);
+  virtual void close();
+
+  virtual bool next();
+  virtual int32_t read(int32_t* docs, int32_t* freqs, int32_t length);
+  virtual bool skipTo(const int32_t target);
+
+  virtual int32_t maxFreqInBlock(const int32_t target, int32_t& blockEnd);
+
+protected:
+  /** Called by skipTo() with the position block the positions of the
+  * next document start in, and the number of positions before them in
+  * that block */
+  virtual void skipProxBlock(const int64_t /*proxPointer*/, const int32_t /*posUpto*/){}
+};
+
+
+class BlockTermPositions: public BlockTermDocs, public TermPositions {
+private:
+  CL_NS(store)::IndexInput* proxStream;
+  int32_t proxCount;
+  int32_t position;
+
+  int32_t posDeltas[CL_NS(util)::ForUtil::BLOCK_LENGTH];
+  int32_t payloadLengths[CL_NS(util)::ForUtil::BLOCK_LENGTH];
+  CL_NS(util)::ValueArray<uint8_t> payloadBytes;
+  int32_t posBufferUpto;
+  int32_t posBufferSize;
+  int32_t payloadByteUpto; // offset in payloadBytes of the payload at posBufferUpto
+
+  int32_t payloadLength;
+  int32_t payloadOffset;
+  bool needToLoadPayload;
+
+  // the positions to skip before those of the current document, and the
+  // position block to go to first unless lazySkipPointer is -1
+  int64_t lazySkipPointer;
+  int32_t lazySkipProxCount;
+
+public:
+  ///\param Parent must be a segment reader
+  BlockTermPositions(const SegmentReader* Parent);
+  virtual ~BlockTermPositions();
+
+private:
+  void seek(const TermInfo* ti, Term* term);
+
+  /** Decodes the next block of positions */
+  void refillPositions();
+
+  /** Moves past the next block of positions without decoding it, the
+  * block must be a packed one */
+  void skipPositionBlock();
+
+  /** Moves past n of the decoded positions */
+  void skipBufferedPositions(const int32_t n);
+
+  /** Moves to the first position of the current document */
+  void lazySkip();
+
+protected:
+  void skippingDoc();
+  void skipProxBlock(const int64_t proxPointer, const int32_t posUpto);
+
+public:
+  void close();
+
+  bool next();
+  int32_t read(int32_t* docs, int32_t* freqs, int32_t length);
+
+  int32_t nextPosition();
+  void nextPositions(int32_t* positions, const int32_t length);
+
+  int32_t getPayloadLength() const;
+  uint8_t* getPayload(uint8_t* data);
+  bool isPayloadAvailable() const;
+
+private:
+  virtual TermDocs* __asTermDocs();
+  virtual TermPositions* __asTermPositions();
+
+  //resolve BlockTermDocs/TermPositions ambiguity
+  void seek(Term* term){ SegmentTermDocs::seek(term); }
+  void seek(TermEnum* termEnum){ SegmentTermDocs::seek(termEnum); }
+  int32_t doc() const{ return BlockTermDocs::doc(); }
+  int32_t freq() const{ return BlockTermDocs::freq(); }
+  bool skipTo(const int32_t target){ return BlockTermDocs::skipTo(target); }
+};
+
+
 
 
 /**
@@ -176,7 +315,6 @@ class SegmentReader: public DirectoryIndexReader {
   class Norm :LUCENE_BASE{
     int32_t number;
     int64_t normSeek;
-    SegmentReader* _this;
     const wchar_t * segment; ///< pointer to segment name
     volatile int32_t refCount;
     bool useSingleNormStream;
@@ -195,7 +333,7 @@ class SegmentReader: public DirectoryIndexReader {
     uint8_t* bytes;
     bool dirty;
     //Constructor
-    Norm(CL_NS(store)::IndexInput* instrm, bool useSingleNormStream, int32_t number, int64_t normSeek, SegmentReader* reader, const wchar_t * segment);
+    Norm(CL_NS(store)::IndexInput* instrm, bool useSingleNormStream, int32_t number, int64_t normSeek, const wchar_t * segment);
     //Destructor
     ~Norm();
 
@@ -209,6 +347,13 @@ class SegmentReader: public DirectoryIndexReader {
   };
   friend class SegmentReader::Norm;
 
+  class Core;
+
+  /** The files of the segment, shared with the other readers of the segment.
+   * tis, freqStream, proxStream, _fieldInfos, cfsReader, storeCFSReader,
+   * termVectorsReaderOrig and docValues belong to it. */
+  Core* core;
+
   //Holds the name of the segment that is being read
   std::wstring segment;
   SegmentInfo* si;
@@ -244,6 +389,8 @@ class SegmentReader: public DirectoryIndexReader {
   ///Reads the Field Info file
   FieldsReader* fieldsReader;
   TermVectorsReader* termVectorsReaderOrig;
+  ///Reads the .dv file, NULL if the segment has no doc values
+  DocValuesReader* docValues;
   CL_NS(util)::ThreadLocal<TermVectorsReader*,
   CL_NS(util)::Deletor::Object<TermVectorsReader> >termVectorsLocal;
 
@@ -320,6 +467,9 @@ public:
   bool hasDeletions() const;
   bool hasNorms(const wchar_t* field);
 
+  NumericDocValues* getNumericDocValues(const wchar_t* field);
+  SortedDocValues* getSortedDocValues(const wchar_t* field);
+
   ///Returns all file names managed by this SegmentReader
   void files(std::vector<std::wstring>& retarray);
   ///Returns an enumeration of all the Terms and TermInfos in the set.
@@ -329,6 +479,7 @@ public:
 
   ///Gets the document identified by n
   bool document(int32_t n, CL_NS(document)::Document& doc, const CL_NS(document)::FieldSelector* fieldSelector);
+  bool document(int32_t n, CL_NS(document)::StoredFieldVisitor& visitor);
 
   ///Checks if the n-th document has been marked deleted
   bool isDeleted(const int32_t n);
@@ -416,7 +567,21 @@ private:
   static uint8_t* createFakeNorms(int32_t size);
 
   void loadDeletedDocs();
-  SegmentReader* reopenSegment(SegmentInfo* si);
+  /** Returns this reader if si has the same deletions and norms, unless
+   * doClone is set, else a new reader of si. The new reader shares the
+   * files and the unchanged norms of this one, and it has its own copy of
+   * the deletions. */
+  SegmentReader* reopenSegment(SegmentInfo* si, bool doClone = false);
+
+  /** Copies the pointers to the files of the core to this reader */
+  void initializeFromCore();
+
+  /** Opens the stored fields and term vectors, if not done yet */
+  void openDocStores();
+
+  /** Passes an access hint on to the stored fields and, unless other readers
+   * share them, the postings files (used by merges) */
+  void setAccessPattern(CL_NS(store)::IndexInput::AccessPattern pattern);
 
   /** Returns the field infos of this segment */
   FieldInfos* fieldInfos();
@@ -438,8 +603,11 @@ private:
   //a more tight idea of the package
   friend class IndexReader;
   friend class IndexWriter;
+  friend class SegmentReaderPool;
   friend class SegmentTermDocs;
   friend class SegmentTermPositions;
+  friend class BlockTermDocs;
+  friend class BlockTermPositions;
   friend class MultiReader;
   friend class MultiSegmentReader;
   friend class SegmentMerger;
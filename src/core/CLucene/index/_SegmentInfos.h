@@ -75,6 +75,8 @@ private:
 
     bool docStoreIsCompoundFile;			  // whether doc store files are stored in compound file (*.cfx)
 
+    int32_t postingsFormat;                   // IndexWriter::PostingsFormat of the .frq and .prx files
+
     /* Called whenever any change is made that affects which
     * files this segment has. */
     void clearFiles();
@@ -183,6 +185,12 @@ public:
 
     void setDocStoreOffset(const int32_t offset);
 
+    /** Returns the IndexWriter::PostingsFormat the postings of this segment
+    * are written in */
+    int32_t getPostingsFormat() const;
+
+    void setPostingsFormat(const int32_t format);
+
     /** We consider another SegmentInfo instance equal if it
     *  has the same dir and same name. */
     bool equals(const SegmentInfo* obj);
@@ -260,9 +268,13 @@ public:
     * vectors and stored fields file. */
     LUCENE_STATIC_CONSTANT(int32_t, FORMAT_SHARED_DOC_STORE = -4);
 
+    /** This format adds the postings format (see
+    * IndexWriter::PostingsFormat) into each segment info. */
+    LUCENE_STATIC_CONSTANT(int32_t, FORMAT_POSTINGS_CODEC = -5);
+
 private:
     /* This must always point to the most recent file format. */
-    LUCENE_STATIC_CONSTANT(int32_t, CURRENT_FORMAT = FORMAT_SHARED_DOC_STORE);
+    LUCENE_STATIC_CONSTANT(int32_t, CURRENT_FORMAT = FORMAT_POSTINGS_CODEC);
 
 public:
     int32_t counter;  // used to name new segments
@@ -37,6 +37,10 @@ public:
     //points to this new current term
 	bool next();
 
+	//Moves the current term of the enumeration termEnum to the first one
+	//greater or equal to target, see TermEnum::skipTo
+	bool skipTo(Term* target);
+
 	//Closes the the resources
 	void close();
 
@@ -20,7 +20,7 @@ CL_CLASS_DEF(store,Directory)
 #include "MergePolicy.h"
 
 CL_NS_DEF(index)
-class DefaultSkipListWriter;
+class PostingsWriter;
 /**
 * The SegmentMerger class combines two or more Segments, represented by an IndexReader ({@link #add},
 * into a single Segment.  After adding the appropriate readers, call the merge method to combine the 
@@ -39,8 +39,8 @@ class SegmentMerger:LUCENE_BASE {
 	CL_NS(store)::Directory* directory;     
 	//name of the new segment
   std::wstring segment;
-	//Set of IndexReaders
-	CL_NS(util)::CLVector<IndexReader*,CL_NS(util)::Deletor::Object<IndexReader> > readers;
+	//Set of IndexReaders, which belong to the caller
+	std::vector<IndexReader*> readers;
 	//Field Infos for t	he FieldInfo instances of all fields
 	FieldInfos* fieldInfos;
 
@@ -58,18 +58,15 @@ class SegmentMerger:LUCENE_BASE {
 
 	//The queue that holds SegmentMergeInfo instances
 	SegmentMergeQueue* queue;
-	//IndexOutput to the new Frequency File
-	CL_NS(store)::IndexOutput* freqOutput;
-  //IndexOutput to the new Prox File
-	CL_NS(store)::IndexOutput* proxOutput;
+	//Writes the new Frequency and Prox Files
+	PostingsWriter* postingsWriter;
 	//Writes Terminfos that have been merged
 	TermInfosWriter* termInfosWriter;
 	TermInfo termInfo; //(new) minimize consing
 
   int32_t termIndexInterval;
-	int32_t skipInterval;
-  int32_t maxSkipLevels;
-  DefaultSkipListWriter* skipListWriter;
+  int32_t storedFieldsCompression;
+  int32_t postingsFormat;
 
 public:
   static const uint8_t NORMS_HEADER[]; 
@@ -91,7 +88,8 @@ public:
 	~SegmentMerger();
 	
 	/**
-	* Add an IndexReader to the collection of readers that are to be merged
+	* Add an IndexReader to the collection of readers that are to be merged.
+	* The caller closes the reader once the merge is done.
 	* @param reader
 	*/
 	void add(IndexReader* reader);
@@ -113,12 +111,6 @@ public:
    * @throws IOException if there is a low-level IO error
    */
 	int32_t merge(bool mergeDocStores);
-	/**
-	* close all IndexReaders that have been added.
-	* Should not be called before merge().
-	* @throws IOException
-	*/
-	void closeReaders();
 
   
   class CheckAbort {
@@ -179,8 +171,7 @@ private:
 	int32_t mergeTermInfo( SegmentMergeInfo** smis, int32_t n);
 	    
 	/** Process postings from multiple segments all positioned on the
-	*  same term. Writes out merged entries into freqOutput and
-	*  the proxOutput streams.
+	*  same term. Writes out merged entries with the postingsWriter.
 	*
 	* @param smis array of segments
 	* @param n number of cells in the array actually occupied
@@ -193,6 +184,9 @@ private:
 	//Merges the norms for all fields 
 	void mergeNorms();
 
+	//Merges the doc values of all fields that have them, skipping deleted docs
+	void mergeDocValues();
+
 	void createCompoundFile(const wchar_t * filename, std::vector<std::wstring>* files=NULL);
 	friend class IndexWriter; //allow IndexWriter to use createCompoundFile
 };
@@ -0,0 +1,87 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#ifndef _lucene_index_SegmentReaderPool_
+#define _lucene_index_SegmentReaderPool_
+
+#include <map>
+
+CL_NS_DEF(index)
+class SegmentInfo;
+class SegmentReader;
+
+/**
+* The SegmentReaders of an IndexWriter, one per segment name, which its
+* deletions and merges check out and return, and which the readers of
+* IndexWriter::getReader() are cloned from. Clones share the term index,
+* the FieldInfos, the postings streams and the unchanged norms of the
+* pooled reader (see SegmentReader::reopenSegment()).
+* <p>
+* Until pooling is switched on, a reader is closed as soon as it is no
+* longer checked out, so a writer without near real-time readers holds no
+* more files open than before.
+* <p>
+* While a reader is checked out its SegmentInfo is the one it was checked
+* out with, so that committing its deletions advances that info. Otherwise
+* it refers to a copy which belongs to the pool: the writer may delete its
+* infos at any time.
+*/
+class SegmentReaderPool: LUCENE_BASE {
+	class Entry {
+	public:
+		SegmentReader* reader;
+		SegmentInfo* info; // the copy of the info of the reader while nobody has it
+		int32_t refCount;
+	};
+	typedef std::map<std::wstring, Entry> ReadersType;
+
+	DEFINE_MUTEX(THIS_LOCK)
+
+	ReadersType readers;
+	/** Readers which were dropped while checked out, with their count */
+	std::map<SegmentReader*, int32_t> retired;
+	bool pooling;
+
+	void closeReader(SegmentReader* reader);
+
+	/** Removes the entry, the reader is closed now or when it is returned */
+	void retire(ReadersType::iterator itr);
+public:
+	SegmentReaderPool();
+
+	/** Closes all readers, see clear() */
+	~SegmentReaderPool();
+
+	/**
+	* Checks out the reader of the segment of info, which is opened or
+	* brought up to the deletions and norms of info if needed. Every call
+	* must be matched by a call to release().
+	* @param doOpenStores also open the stored fields and term vectors
+	*/
+	SegmentReader* get(SegmentInfo* info, bool doOpenStores, int32_t readBufferSize);
+
+	/** Returns a reader which was checked out with get() */
+	void release(SegmentReader* reader);
+
+	/** Forgets the reader of the segment of info, after the segment was
+	* merged away or its files changed */
+	void drop(const SegmentInfo* info);
+
+	/** True if the reader of the segment of info is checked out */
+	bool isCheckedOut(const SegmentInfo* info);
+
+	/** Forgets all readers, for instance when the writer rolls back. The
+	* readers which are checked out are closed when they are returned. */
+	void clear();
+
+	/** Keep the readers which are not checked out open for later use */
+	void setPooling(const bool pooling);
+};
+
+CL_NS_END
+#endif
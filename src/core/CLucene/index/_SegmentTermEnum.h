@@ -15,6 +15,7 @@
 //#include "TermInfo.h"
 
 CL_NS_DEF(index)
+class TermInfosReader;
 
 /**
  * SegmentTermEnum is an enumeration of all Terms and TermInfos
@@ -43,8 +44,12 @@ private:
 	int32_t indexInterval;
 	int32_t skipInterval;
 	int32_t maxSkipLevels;
+	TermInfosReader* termInfos;	///The reader whose term index skipTo() seeks with, if any
+	int32_t indexOffset;    ///Offset of indexTerm in the term index, or -1
+	Term* indexTerm;        ///The term of the term index the reader last compared with, so that lookups in order decode it once
 
 	friend class TermInfosReader;
+	friend class TermInfosIndex;
 	friend class SegmentTermDocs;
 protected:
 
@@ -72,9 +77,17 @@ public:
 	Term* term(bool pointer=true);
 
     /**
-	 * Scan for Term term without allocating new Terms
+	 * Scan for Term term without allocating new Terms.
+	 * Returns the number of terms that were moved over.
 	 */
-	void scanTo(const Term *term);
+	int32_t scanTo(const Term *term);
+
+	/**
+	 * Skips to the first term beyond the current one which is greater or
+	 * equal to target. Seeks with the term index if target lies beyond the
+	 * next indexed term, rather than reading all terms up to it.
+	 */
+	bool skipTo(Term* target);
 
 	/**
 	 * Closes the enumeration to further activity, freeing resources.
@@ -66,6 +66,10 @@ public:
 	*  has skipped.  */
 	int32_t getDoc() const;
 
+	/** Returns the id of the doc of the skip entry that follows {@link #getDoc()}
+	*  on the lowest level, LUCENE_INT32_MAX_SHOULDBE if there is none. */
+	int32_t getNextSkipDoc() const;
+
 	/** Skips entries to the first beyond the current whose document number is
 	*  greater than or equal to <i>target</i>. Returns the current doc count.
 	*/
@@ -144,6 +148,8 @@ protected:
 class DefaultSkipListReader: public MultiLevelSkipListReader {
 private:
 	bool currentFieldStoresPayloads;
+	bool storesMaxFreqs;
+	int32_t nextMaxFreq;
 	int64_t* freqPointer;
 	int64_t* proxPointer;
 	int32_t* payloadLength;
@@ -153,7 +159,11 @@ private:
 	int32_t lastPayloadLength;
 
 public:
-	DefaultSkipListReader(CL_NS(store)::IndexInput* _skipStream, const int32_t maxSkipLevels, const int32_t _skipInterval);
+	/**
+	* @param _storesMaxFreqs true if the skip entries of the lowest level hold
+	* the largest frequency of their documents (TermInfosWriter::FORMAT -4 on)
+	*/
+	DefaultSkipListReader(CL_NS(store)::IndexInput* _skipStream, const int32_t maxSkipLevels, const int32_t _skipInterval, const bool _storesMaxFreqs);
 	virtual ~DefaultSkipListReader();
 
 	void init(const int64_t _skipPointer, const int64_t freqBasePointer, const int64_t proxBasePointer, const int32_t df, const bool storesPayloads);
@@ -171,6 +181,59 @@ public:
 	* has skipped.  */
 	int32_t getPayloadLength() const;
 
+	/** Returns the largest frequency of the documents after {@link #getDoc()}
+	* up to and including {@link #getNextSkipDoc()}, -1 if the skip entries
+	* do not hold it.  */
+	int32_t getNextMaxFreq() const;
+
+protected:
+	void seekChild(const int32_t level);
+
+	void setLastSkipData(const int32_t level);
+
+	int32_t readSkipData(const int32_t level, CL_NS(store)::IndexInput* _skipStream);
+};
+
+/**
+ * Implements the skip list reader for the block postings format, see
+ * BlockSkipListWriter.
+ */
+class BlockSkipListReader: public MultiLevelSkipListReader {
+private:
+	int32_t nextMaxFreq;
+	int64_t* freqPointer;
+	int64_t* proxPointer;
+	int32_t* posUpto;
+
+	int64_t lastFreqPointer;
+	int64_t lastProxPointer;
+	int32_t lastPosUpto;
+
+public:
+	BlockSkipListReader(CL_NS(store)::IndexInput* _skipStream, const int32_t maxSkipLevels);
+	virtual ~BlockSkipListReader();
+
+	/** Positions the reader at the start of the skip list of a term with df
+	* documents. {@link MultiLevelSkipListReader#skipTo(int)} then returns
+	* the number of documents skipped minus one. */
+	void init(const int64_t _skipPointer, const int64_t freqBasePointer, const int64_t proxBasePointer, const int32_t df);
+
+	/** Returns the pointer of the block of documents after the doc to which
+	* the last call of {@link MultiLevelSkipListReader#skipTo(int)} has skipped. */
+	int64_t getFreqPointer() const;
+
+	/** Returns the pointer of the block of positions the positions of the
+	* next document start in. */
+	int64_t getProxPointer() const;
+
+	/** Returns the number of positions in the block at {@link #getProxPointer()}
+	* before those of the next document. */
+	int32_t getPosUpto() const;
+
+	/** Returns the largest frequency of the documents after {@link #getDoc()}
+	* up to and including {@link #getNextSkipDoc()}. */
+	int32_t getNextMaxFreq() const;
+
 protected:
 	void seekChild(const int32_t level);
 
@@ -83,8 +83,8 @@ protected:
    */
   virtual void writeSkipData(int32_t level, CL_NS(store)::IndexOutput* skipBuffer) = 0;
 
-  friend class SegmentMerger;
-  friend class DocumentsWriter;
+  friend class VIntPostingsWriter;
+  friend class BlockPostingsWriter;
 };
 
 /**
@@ -107,12 +107,24 @@ private:
   int32_t curPayloadLength;
   int64_t curFreqPointer;
   int64_t curProxPointer;
+  int32_t curMaxFreq;   // largest freq since the last skip entry on level 0
+  int32_t termMaxFreq;  // largest freq since resetSkip()
   
   /**
    * Sets the values for the current skip data. 
    */
   void setSkipData(int32_t doc, bool storePayloads, int32_t payloadLength);
 
+  /**
+   * Records the frequency of the document that is written next.
+   */
+  void addFreq(int32_t freq);
+
+  /**
+   * Returns the largest frequency recorded since the last resetSkip().
+   */
+  int32_t getMaxFreq() const;
+
 protected:
   void resetSkip();
   
@@ -123,8 +135,46 @@ public:
     CL_NS(store)::IndexOutput* freqOutput, CL_NS(store)::IndexOutput* proxOutput);
   ~DefaultSkipListWriter();
   
-  friend class SegmentMerger;
-  friend class DocumentsWriter;
+  friend class VIntPostingsWriter;
+};
+
+/**
+ * Implements the skip list writer for the block postings format, see
+ * BlockPostingsWriter. There is a skip entry for each block of documents,
+ * so the skip interval is the block size.
+ */
+class BlockSkipListWriter: public MultiLevelSkipListWriter {
+private:
+  int32_t* lastSkipDoc;
+  int64_t* lastSkipFreqPointer;
+  int64_t* lastSkipProxPointer;
+
+  int32_t curDoc;
+  int64_t curFreqPointer;
+  int64_t curProxPointer;
+  int32_t curPosUpto;
+  int32_t curMaxFreq;
+
+  /**
+   * Sets the values for the current skip data: the last document of the
+   * previous block, the start of the next block, the start of the block of
+   * positions its first position is in, the index of that position in the
+   * block and the largest frequency of the documents of the previous block.
+   */
+  void setSkipData(int32_t doc, int64_t freqPointer, int64_t proxPointer, int32_t posUpto, int32_t maxFreq);
+
+  /**
+   * Starts the skip list of a term whose postings start at the given pointers.
+   */
+  void resetSkip(int64_t freqPointer, int64_t proxPointer);
+
+protected:
+  void writeSkipData(int32_t level, CL_NS(store)::IndexOutput* skipBuffer);
+public:
+  BlockSkipListWriter(int32_t numberOfSkipLevels, int32_t docCount);
+  ~BlockSkipListWriter();
+
+  friend class BlockPostingsWriter;
 };
 
 
@@ -30,6 +30,11 @@ public:
 
   int32_t skipOffset;
 
+	//The largest frequency of the term in a document. Left at 0 if the
+	//segment was written before it was recorded, which TermDocs::maxFreq()
+	//reports as -1
+	int32_t maxFreq;
+
     //Constructor
 	TermInfo();
 
@@ -44,7 +49,7 @@ public:
 	~TermInfo();
 
 	//Sets a new document frequency, a new freqPointer and a new proxPointer
-	void set(const int32_t docFreq, const int64_t freqPointer, const int64_t proxPointer, int32_t skipOffset);
+	void set(const int32_t docFreq, const int64_t freqPointer, const int64_t proxPointer, int32_t skipOffset, const int32_t maxFreq);
 
 	//Sets a new document frequency, a new freqPointer and a new proxPointer
     //by copying these values from another instance of TermInfo
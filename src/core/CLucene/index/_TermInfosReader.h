@@ -14,12 +14,109 @@
 #include "_SegmentTermEnum.h"
 CL_CLASS_DEF(store,Directory)
 //CL_CLASS_DEF(store,IndexInput)
+CL_CLASS_DEF(util,PackedInts)
 #include "CLucene/util/_ThreadLocal.h"
 //#include "FieldInfos.h"
 //#include "TermInfo.h"
 //#include "TermInfosWriter.h"
 
 CL_NS_DEF(index)
+
+/** The part of the term dictionary that is kept in memory: every
+* indexInterval-th term of the .tis file, with its TermInfo and its position
+* in the file. The texts of the terms are stored in one block of UTF-8, each
+* one as the length of the prefix it shares with the one before and the rest
+* of it. Every BLOCK_SIZE-th term is stored whole, so that decoding can start
+* there.
+*/
+class TermInfosIndex :LUCENE_BASE{
+public:
+	LUCENE_STATIC_CONSTANT(int32_t, BLOCK_SIZE = 16);
+private:
+	int32_t length;
+
+	/** The fields of the terms, in term order. Owned by the FieldInfos */
+	const wchar_t** fields;
+	int32_t fieldsLength;
+	/** For each term, its index in fields */
+	CL_NS(util)::PackedInts* termFields;
+
+	uint8_t* texts;
+	/** For each block of terms, where its first term starts in texts */
+	CL_NS(util)::PackedInts* blockStarts;
+
+	TermInfo* infos;
+	CL_NS(util)::PackedInts* pointers;
+
+	/** Decodes the text of the term at pos, given the text of the one before. Returns the position after it */
+	static const uint8_t* readText(const uint8_t* pos, std::wstring& text);
+	/** Decodes the text of the term at offset */
+	void readText(const int32_t offset, std::wstring& text) const;
+	/** Compares term to the term at offset, whose text is given */
+	int32_t compare(const Term* term, const int32_t offset, const std::wstring& text) const;
+public:
+	/** Reads the terms of indexEnum, keeping one in every indexDivisor */
+	TermInfosIndex(SegmentTermEnum* indexEnum, const int32_t indexDivisor);
+	~TermInfosIndex();
+
+	/** Returns the number of terms */
+	int32_t size() const;
+
+	/** Returns the offset of the greatest term which is less than or equal to term, or -1 */
+	int32_t getIndexOffset(const Term* term) const;
+
+	/** Sets dest to the term at offset */
+	void getTerm(const int32_t offset, Term* dest) const;
+
+	/** Returns the TermInfo of the term at offset */
+	TermInfo* getTermInfo(const int32_t offset) const;
+
+	/** Returns the position of the term at offset in the .tis file */
+	int64_t getPointer(const int32_t offset) const;
+
+	/** Estimates the memory held, in bytes */
+	size_t ramBytesUsed() const;
+};
+
+/** A bounded cache of the TermInfo of recently looked up terms, shared by all
+* threads that read a segment. It is split into stripes with a lock each, so
+* that threads looking up different terms rarely wait for each other. Each
+* stripe keeps two generations of entries: when the newer one is full, the
+* older one is dropped and a new one is started. Entries found in the older
+* generation move to the newer one, so terms that keep being looked up stay
+* cached without the cache tracking the order of use.
+*/
+class TermInfosCache :LUCENE_BASE{
+public:
+	LUCENE_STATIC_CONSTANT(int32_t, STRIPES = 8);
+private:
+	class Key;
+	class Stripe;
+	Stripe** stripes;
+	int32_t generationSize;
+
+	Stripe* stripeFor(const Key& key) const;
+public:
+	/** Creates a cache that holds at most size terms */
+	TermInfosCache(const int32_t size);
+	~TermInfosCache();
+
+	/** Returns a copy of the cached TermInfo of term, or NULL if it is not cached */
+	TermInfo* get(const Term* term);
+
+	/** Caches a copy of ti as the TermInfo of term */
+	void put(const Term* term, const TermInfo* ti);
+
+	/** Returns the number of cached terms */
+	int32_t size() const;
+
+	/** Returns the number of calls to get() that found the term */
+	int64_t getHits() const;
+
+	/** Returns the number of calls to get() that did not find the term */
+	int64_t getMisses() const;
+};
+
 /** This stores a monotonically increasing set of <Term, TermInfo> pairs in a
 * Directory.  Pairs are accessed either by Term or by ordinal position the
 * set.
@@ -40,10 +137,10 @@ CL_NS_DEF(index)
 		SegmentTermEnum* indexEnum;
 		int64_t _size;
 
-		Term* indexTerms; //note: this is a list of objects, not arrays!
-    int32_t indexTermsLength;
-		TermInfo* indexInfos;
-		int64_t* indexPointers;
+		/** read lazily, then never replaced until close. Published with
+		* _LUCENE_ATOMIC_PTR_SET, see ensureIndexIsRead */
+		TermInfosIndex* index;
+		TermInfosCache* cache;
 
 		int32_t indexDivisor;
 		int32_t totalIndexInterval;
@@ -62,6 +159,10 @@ CL_NS_DEF(index)
 		int32_t getSkipInterval() const;
 		int32_t getMaxSkipLevels() const;
 
+		/** True if the terms and the skip data of their postings record the
+		* largest frequencies, see TermInfo::maxFreq */
+		bool hasMaxFreqs() const;
+
 		/**
 		* <p>Sets the indexDivisor, which subsamples the number
 		* of indexed terms loaded into memory.  This has a
@@ -100,16 +201,40 @@ CL_NS_DEF(index)
 		* and TermInfos in the set is returned.
 		*/
 		SegmentTermEnum* terms(const Term* term=NULL);
+
+		/**
+		* Moves termEnum, an enumeration returned by terms(), to the first term
+		* beyond its current one which is greater or equal to target. Seeks
+		* with the term index if target lies beyond the next indexed term.
+		*/
+		bool skipTo(SegmentTermEnum* termEnum, const Term* target);
 		
 		/** Returns the TermInfo for a Term in the set, or null. */
 		TermInfo* get(const Term* term);
+
+		/** Returns how many lookups of get(const Term*) were answered by the term cache */
+		int64_t getCacheHits() const;
+
+		/** Returns how many lookups of get(const Term*) had to go to the term dictionary */
+		int64_t getCacheMisses() const;
+
+		/** Estimates the memory held by the in memory term index, in bytes */
+		size_t getIndexRamBytesUsed() const;
 	private:
+		/** Returns the TermInfo for a Term in the set, or null. If useCache is
+		* false, the cache is bypassed so that the enumerator is positioned at term. */
+		TermInfo* get(const Term* term, const bool useCache);
+
 		/** Reads the term info index file or .tti file. */
 		void ensureIndexIsRead();
 
 		/** Returns the offset of the greatest index entry which is less than or equal to term.*/
 		int32_t getIndexOffset(const Term* term);
 
+		/** Compares term to the term at offset of the index, which enumerator
+		* keeps decoded for the next call */
+		int32_t compareIndexTerm(SegmentTermEnum* enumerator, const Term* term, const int32_t offset);
+
 		/** Reposition the current Term and TermInfo to indexOffset */
 		void seekEnum(const int32_t indexOffset);  
 
@@ -49,8 +49,11 @@ class TermInfo;
     */
     int32_t maxSkipLevels;
 
-		/** The file format version, a negative number. */
-		LUCENE_STATIC_CONSTANT(int32_t,FORMAT=-3);
+		/** The file format version, a negative number. Format -4 adds the
+		* largest frequency of each term, and of each block of postings to
+		* the skip data, see TermDocs::maxFreq().
+		*/
+		LUCENE_STATIC_CONSTANT(int32_t,FORMAT=-4);
 
     //Expert: The fraction of {@link TermDocs} entries stored in skip tables,
     //used to accellerate {@link TermDocs#skipTo(int)}.  Larger values result in
@@ -0,0 +1,185 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "CLucene/_ApiHeader.h"
+#include "AutomatonTermEnum.h"
+#include "CLucene/index/Term.h"
+#include "CLucene/index/IndexReader.h"
+#include "CLucene/util/_Automaton.h"
+
+CL_NS_USE(index)
+CL_NS_USE(util)
+CL_NS_DEF(search)
+
+AutomatonTermEnum::AutomatonTermEnum():
+	automaton(NULL), fieldTerm(NULL), seekTerm(NULL), seekNext(false), _endEnum(false), curGen(0)
+{
+}
+
+AutomatonTermEnum::~AutomatonTermEnum(){
+	close();
+}
+
+const std::wstring AutomatonTermEnum::getObjectName() const { return getClassName(); }
+const std::wstring AutomatonTermEnum::getClassName() { return L"AutomatonTermEnum"; }
+
+void AutomatonTermEnum::setAutomaton(IndexReader* reader, Term* term, Automaton* _automaton){
+	CND_PRECONDITION(automaton == NULL, L"automaton already set");
+	automaton = _automaton;
+	fieldTerm = _CL_POINTER(term);
+	visited.resize(automaton->getNumStates());
+
+	// start at the smallest string the automaton may accept
+	seekText.clear();
+	if ( !automaton->isAccept(0) && !nextString() )
+		_endEnum = true;
+	seekTerm = _CLNEW Term(fieldTerm, seekText.c_str());
+	setEnum(reader->terms(seekTerm));
+}
+
+bool AutomatonTermEnum::acceptTerm(Term* /*term*/){
+	return true;
+}
+
+bool AutomatonTermEnum::termCompare(Term* term){
+	if ( term == NULL || _endEnum )
+		return false;
+
+	//fields are interned
+	if ( term->field() != fieldTerm->field() ){
+		_endEnum = true;
+		return false;
+	}
+
+	// seek only if a character of the term is rejected: if the whole term
+	// is walked, as after a leading wildcard, the strings which may match
+	// next extend it and the next term is cheaper to get than a seek
+	const wchar_t* text = term->text();
+	const size_t len = term->textLength();
+	int32_t state = 0;
+	for ( size_t i = 0; i < len; i++ ){
+		state = automaton->step(state, text[i]);
+		if ( state < 0 ){
+			seekNext = true;
+			return false;
+		}
+	}
+	seekNext = false;
+	return automaton->isAccept(state) && acceptTerm(term);
+}
+
+bool AutomatonTermEnum::endEnum(){
+	return _endEnum;
+}
+
+Term* AutomatonTermEnum::nextSeekTerm(Term* current){
+	// after an accepted term, the next term is as likely to match as the
+	// target a seek would find
+	if ( !seekNext || current == NULL || current->field() != fieldTerm->field() )
+		return NULL;
+	seekText.assign(current->text(), current->textLength());
+	if ( !nextString() ){
+		_endEnum = true;
+		return NULL;
+	}
+	seekTerm->set(fieldTerm, seekText.c_str());
+	return seekTerm;
+}
+
+bool AutomatonTermEnum::nextString(){
+	int32_t state;
+	size_t pos = 0;
+	while ( true ){
+		if ( savedStates.length < seekText.length() + 1 )
+			savedStates.resize(seekText.length() + 1);
+		savedStates.values[0] = 0;
+		curGen++;
+
+		// walk the automaton until a character is rejected
+		for ( state = savedStates.values[pos]; pos < seekText.length(); pos++ ){
+			visited.values[state] = curGen;
+			const int32_t nextState = automaton->step(state, seekText[pos]);
+			if ( nextState == -1 )
+				break;
+			savedStates.values[pos + 1] = nextState;
+			state = nextState;
+		}
+
+		// append the smallest characters that will match to the part the
+		// automaton walked
+		if ( nextString(state, pos) )
+			return true;
+
+		// no string starts with that part, so increment a character before it
+		const int32_t back = backtrack((int32_t)pos);
+		if ( back < 0 )
+			return false;
+		pos = back;
+		const int32_t newState = automaton->step(savedStates.values[pos], seekText[pos]);
+		if ( newState >= 0 && automaton->isAccept(newState) )
+			return true;
+	}
+}
+
+bool AutomatonTermEnum::nextString(int32_t state, const size_t position){
+	// the next string must be greater than the current character, if there is one
+	int32_t c = Automaton::MIN_CHAR;
+	if ( position < seekText.length() ){
+		c = seekText[position];
+		if ( c == Automaton::MAX_CHAR )
+			return false;
+		c++;
+	}
+	seekText.resize(position);
+	visited.values[state] = curGen;
+
+	const int32_t numTransitions = automaton->getNumTransitions(state);
+	for ( int32_t i = 0; i < numTransitions; i++ ){
+		const Automaton::Transition& t = automaton->getTransition(state, i);
+		if ( t.max < c )
+			continue;
+		seekText.push_back((wchar_t)cl_max(c, (int32_t)t.min));
+		state = t.dest;
+
+		// follow the smallest transitions until a string is accepted, or a
+		// state repeats: then seekText is a prefix of the strings to come
+		while ( visited.values[state] != curGen && !automaton->isAccept(state) ){
+			visited.values[state] = curGen;
+			const Automaton::Transition& first = automaton->getTransition(state, 0);
+			seekText.push_back(first.min);
+			state = first.dest;
+		}
+		return true;
+	}
+	return false;
+}
+
+int32_t AutomatonTermEnum::backtrack(int32_t position){
+	while ( position-- > 0 ){
+		const int32_t c = seekText[position];
+		if ( c != Automaton::MAX_CHAR ){
+			seekText[position] = (wchar_t)(c + 1);
+			seekText.resize(position + 1);
+			return position;
+		}
+	}
+	return -1;
+}
+
+float_t AutomatonTermEnum::difference(){
+	return 1.0f;
+}
+
+void AutomatonTermEnum::close(){
+	FilteredTermEnum::close();
+	_CLDELETE(automaton);
+	_CLDECDELETE(seekTerm);
+	_CLDECDELETE(fieldTerm);
+}
+
+CL_NS_END
@@ -0,0 +1,80 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#ifndef _lucene_search_AutomatonTermEnum_
+#define _lucene_search_AutomatonTermEnum_
+
+CL_CLASS_DEF(index,Term)
+CL_CLASS_DEF(index,IndexReader)
+CL_CLASS_DEF(util,Automaton)
+#include "FilteredTermEnum.h"
+#include "CLucene/util/Array.h"
+
+CL_NS_DEF(search)
+
+/**
+* Subclass of FilteredTermEnum for enumerating the terms of a field which
+* an automaton accepts.
+* <p>
+* Rather than testing every term of the field, the enumeration seeks: when
+* a term is rejected, the automaton is walked along it up to the rejected
+* character, and the smallest string greater than the term which the
+* automaton could still accept becomes the target of TermEnum::skipTo. So
+* the ranges of terms which cannot match are skipped with the term index.
+*/
+class CLUCENE_EXPORT AutomatonTermEnum: public FilteredTermEnum {
+private:
+	CL_NS(util)::Automaton* automaton;
+	CL_NS(index)::Term* fieldTerm;
+	CL_NS(index)::Term* seekTerm;
+	std::wstring seekText;
+	bool seekNext;
+	bool _endEnum;
+
+	CL_NS(util)::ValueArray<int32_t> savedStates;
+	CL_NS(util)::ValueArray<int32_t> visited;
+	int32_t curGen;
+
+	/** Moves seekText to the next string which the automaton may accept,
+	* false if there is none */
+	bool nextString();
+	bool nextString(int32_t state, size_t position);
+	int32_t backtrack(int32_t position);
+
+protected:
+	AutomatonTermEnum();
+
+	/**
+	* Starts the enumeration of the terms of the field of fieldTerm which
+	* automaton accepts. Takes ownership of automaton; must be called once
+	* by the constructor of the subclass.
+	*/
+	void setAutomaton(CL_NS(index)::IndexReader* reader, CL_NS(index)::Term* fieldTerm, CL_NS(util)::Automaton* automaton);
+
+	/** Whether a term which the automaton accepts is enumerated. The
+	* default returns true */
+	virtual bool acceptTerm(CL_NS(index)::Term* term);
+
+	bool termCompare(CL_NS(index)::Term* term);
+	bool endEnum();
+	CL_NS(index)::Term* nextSeekTerm(CL_NS(index)::Term* current);
+
+public:
+	virtual ~AutomatonTermEnum();
+
+	/** Returns 1 */
+	float_t difference();
+
+	void close();
+
+	const std::wstring getObjectName() const;
+	static const std::wstring getClassName();
+};
+
+CL_NS_END
+#endif
@@ -19,6 +19,7 @@
 #include "_BooleanScorer.h"
 #include "_ConjunctionScorer.h"
 #include "_DisjunctionSumScorer.h"
+#include "_WANDScorer.h"
 
 CL_NS_USE(util)
 CL_NS_DEF(search)
@@ -47,6 +48,8 @@ public:
 
     void init()
     {
+        if (coordFactors != NULL)
+            return; // BooleanScorer2::score() may have asked for them already
         coordFactors = _CL_NEWARRAY(float_t, maxCoord + 1);
         Similarity* sim = parentScorer->getSimilarity();
         for (int32_t i = 0; i <= maxCoord; i++)
@@ -485,6 +488,36 @@ virtual ~BSDisjunctionSumScorer()
 virtual std::wstring toString() { return L"BSDisjunctionSumScorer"; }
 };
 
+class BooleanScorer2::BSWANDScorer : public CL_NS(search)::WANDScorer {
+private:
+    CL_NS(search)::BooleanScorer2::Coordinator* coordinator;
+    int32_t lastScoredDoc;
+public:
+    BSWANDScorer(
+        CL_NS(search)::BooleanScorer2::Coordinator* _coordinator,
+        ScorersType* subScorers) :
+            WANDScorer(subScorers, _coordinator->coordFactors),
+            coordinator(_coordinator),
+            lastScoredDoc(-1)
+    {
+    }
+
+    float_t score()
+    {
+        if (this->doc() >= lastScoredDoc)
+        {
+            lastScoredDoc = this->doc();
+            coordinator->nrMatchers += nrMatchers();
+        }
+        return WANDScorer::score();
+    }
+
+    virtual ~BSWANDScorer()
+    {
+    }
+    virtual std::wstring toString() { return L"BSWANDScorer"; }
+};
+
 class BooleanScorer2::Internal
 {
 public:
@@ -500,6 +533,9 @@ public:
     size_t minNrShouldMatch;
     bool allowDocsOutOfOrder;
 
+    // set when the caller is going to pass minimum competitive scores
+    bool skipNonCompetitive;
+
 
     void initCountingSumScorer()
     {
@@ -507,6 +543,26 @@ public:
         countingSumScorer = makeCountingSumScorer();
     }
 
+    /** A pure disjunction of subscorers that bound their scores, under coordination
+    * factors that are not negative, can skip documents that are not competitive. */
+    bool useWANDScorer(size_t nrOptRequired)
+    {
+        if (!skipNonCompetitive || nrOptRequired > 1 || optionalScorers.size() < 2 || prohibitedScorers.size() > 0)
+            return false;
+        coordinator->init();
+        for (int32_t i = 0; i <= coordinator->maxCoord; i++)
+        {
+            if (coordinator->coordFactors[i] < 0)
+                return false;
+        }
+        for (ScorersType::iterator it = optionalScorers.begin(); it != optionalScorers.end(); it++)
+        {
+            if ((*it)->maxScore() < 0)
+                return false;
+        }
+        return true;
+    }
+
     Scorer* countingDisjunctionSumScorer(ScorersType* scorers, int32_t minNrShouldMatch)
     {
         return _CLNEW BSDisjunctionSumScorer(coordinator, scorers, minNrShouldMatch);
@@ -548,6 +604,10 @@ public:
                 optionalScorers.setDoDelete(true);
                 return _CLNEW NonMatchingScorer();
             }
+            else if (useWANDScorer(nrOptRequired))
+            {
+                return _CLNEW BSWANDScorer(coordinator, &optionalScorers);
+            }
             else
             {
                 Scorer* requiredCountingSumScorer =
@@ -626,7 +686,8 @@ public:
         prohibitedScorers(false),
         countingSumScorer(NULL),
         minNrShouldMatch(_minNrShouldMatch),
-        allowDocsOutOfOrder(_allowDocsOutOfOrder)
+        allowDocsOutOfOrder(_allowDocsOutOfOrder),
+        skipNonCompetitive(false)
     {
         if (_minNrShouldMatch < 0)
         {
@@ -692,7 +753,10 @@ void BooleanScorer2::add(Scorer* scorer, bool required, bool prohibited)
 
 void BooleanScorer2::score(HitCollector* hc)
 {
-    if (_internal->allowDocsOutOfOrder && _internal->requiredScorers.size() == 0 && _internal->prohibitedScorers.size() < 32)
+    // The out of order BooleanScorer cannot skip documents, so it is only
+    // left out when makeCountingSumScorer would use a WANDScorer
+    if (_internal->allowDocsOutOfOrder && _internal->requiredScorers.size() == 0 && _internal->prohibitedScorers.size() < 32
+        && !_internal->useWANDScorer(_internal->minNrShouldMatch < 1 ? 1 : _internal->minNrShouldMatch))
     {
 
         BooleanScorer* bs = _CLNEW BooleanScorer(getSimilarity(), _internal->minNrShouldMatch);
@@ -753,6 +817,17 @@ bool BooleanScorer2::skipTo(int32_t target)
     return _internal->countingSumScorer->skipTo(target);
 }
 
+void BooleanScorer2::setMinCompetitiveScore(const float_t minScore)
+{
+    if (_internal->countingSumScorer == NULL)
+    {
+        _internal->skipNonCompetitive = true;
+        _internal->initCountingSumScorer();
+    }
+    // a WANDScorer takes the coordination factors into account, others ignore it
+    _internal->countingSumScorer->setMinCompetitiveScore(minScore);
+}
+
 std::wstring BooleanScorer2::toString()
 {
     return L"BooleanScorer2";
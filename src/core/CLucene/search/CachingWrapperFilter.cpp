@@ -65,7 +65,12 @@ BitSet* AbstractCachingFilter::bits(IndexReader* reader){
 	if ( cached != NULL )
 		return cached->bits;
 	BitSet* bs = doBits(reader);
-	BitSetHolder* bsh = _CLNEW BitSetHolder(bs, doShouldDeleteBitSet(bs));
+	const bool deleteBs = doShouldDeleteBitSet(bs);
+	//a cached filter that matches few documents is kept as a list of them.
+	//only compact bit sets we own, others may be in use elsewhere
+	if ( bs != NULL && deleteBs )
+		bs->compact();
+	BitSetHolder* bsh = _CLNEW BitSetHolder(bs, deleteBs);
 	_internal->cache.put(reader,bsh);
 	return bs;
 }
@@ -104,6 +109,20 @@ BitSet* CachingWrapperFilter::doBits(IndexReader* reader){
 bool CachingWrapperFilter::doShouldDeleteBitSet( CL_NS(util)::BitSet* bits ){
 	return filter->shouldDeleteBitSet(bits);
 }
+bool CachingWrapperFilter::equals(Filter* other) const{
+	if ( this == other ) return true;
+	if ( strcmp(other->getObjectName(), getObjectName()) != 0 ) return false;
+	return filter->equals(static_cast<CachingWrapperFilter*>(other)->filter);
+}
+size_t CachingWrapperFilter::hashCode() const{
+	return filter->hashCode() ^ 0x1117bf25;
+}
+const char* CachingWrapperFilter::getClassName(){
+	return "CachingWrapperFilter";
+}
+const char* CachingWrapperFilter::getObjectName() const{
+	return getClassName();
+}
 CachingWrapperFilter::~CachingWrapperFilter(){
 	if ( deleteFilter ){
 		_CLDELETE(filter);
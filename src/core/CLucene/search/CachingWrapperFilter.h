@@ -62,6 +62,13 @@ public:
 
     Filter *clone() const;
     std::wstring toString();
+
+    /** Returns true if other wraps a filter equal to the one this wraps */
+    bool equals(Filter* other) const;
+    size_t hashCode() const;
+
+    const char* getObjectName() const;
+    static const char* getClassName();
 };
 
 CL_NS_END
@@ -120,8 +120,7 @@ BitSet* ChainedFilter::bits( IndexReader* reader, int logic )
 		else if ( tmp == NULL ){
 			int32_t len = reader->maxDoc();
 			bts = _CLNEW BitSet( len ); //bitset returned null, which means match _all_
-			for (int32_t i=0;i<len;i++ )
-				bts->set(i);
+			bts->set(0, len, true);
 		}else{
 			bts = tmp->clone(); //else it is probably cached, so we need to copy it before using it.
 		}
@@ -154,8 +153,7 @@ BitSet* ChainedFilter::bits( IndexReader* reader, int* _logicArray )
 		else if ( tmp == NULL ){
 			int32_t len = reader->maxDoc();
 			bts = _CLNEW BitSet( len ); //bitset returned null, which means match _all_
-			for (int32_t i=0;i<len;i++ )
-				bts->set(i); //todo: this could mean that we can skip certain types of filters
+			bts->set(0, len, true); //todo: this could mean that we can skip certain types of filters
 		}
 		else
 		{
@@ -184,27 +182,33 @@ BitSet* ChainedFilter::doChain( BitSet* resultset, IndexReader* reader, int logi
 {
 	BitSet* filterbits = filter->bits( reader );
 	int32_t maxDoc = reader->maxDoc();
-	int32_t i=0;
 	if ( logic >= ChainedFilter::USER ){
 		doUserChain(resultset,filterbits,logic);
 	}else{
+		//a NULL filterbits matches all documents
 		switch( logic )
 		{
 		case OR:
-			for( i=0; i < maxDoc; i++ )
-				resultset->set( i, (resultset->get(i) || (filterbits==NULL || filterbits->get(i) ))?1:0 );
+			if ( filterbits == NULL )
+				resultset->set( 0, maxDoc, true );
+			else
+				resultset->or_( *filterbits );
 			break;
 		case AND:
-			for( i=0; i < maxDoc; i++ )
-				resultset->set( i, (resultset->get(i) && (filterbits==NULL || filterbits->get(i) ))?1:0 );
+			if ( filterbits != NULL )
+				resultset->and_( *filterbits );
 			break;
 		case ANDNOT:
-			for( i=0; i < maxDoc; i++ )
-				resultset->set( i, (resultset->get(i) && (filterbits==NULL || filterbits->get(i)))?0:1 );
+			//set the bits that are not set in both
+			if ( filterbits != NULL )
+				resultset->and_( *filterbits );
+			resultset->flip( 0, maxDoc );
 			break;
 		case XOR:
-			for( i=0; i < maxDoc; i++ )
-				resultset->set( i, resultset->get(i) ^ ((filterbits==NULL || filterbits->get(i) )?1:0) );
+			if ( filterbits == NULL )
+				resultset->flip( 0, maxDoc );
+			else
+				resultset->xor_( *filterbits );
 			break;
 		default:
 			doChain( resultset, reader, DEFAULT, filter );
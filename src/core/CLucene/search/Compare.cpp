@@ -9,9 +9,26 @@
 #include "CLucene/_ApiHeader.h"
 #include "Compare.h"
 #include "SearchHeader.h"
+#include "CLucene/index/DocValues.h"
 
 CL_NS_DEF(search)
 
+/** A string sort value that owns its text, which is decoded from the
+* field cache, so that it stays valid when the cache entry goes away.
+*/
+class StringSortValue: public CL_NS(util)::Compare::WChar{
+	wchar_t* value;
+public:
+	StringSortValue(wchar_t* _value):
+		CL_NS(util)::Compare::WChar(_value),
+		value(_value)
+	{
+	}
+	~StringSortValue(){
+		_CLDELETE_CARRAY(value);
+	}
+};
+
 ScoreDocComparators::ScoreDocComparators(){}
 ScoreDocComparators::~ScoreDocComparators(){
 }
@@ -53,18 +70,22 @@ ScoreDocComparators::String::String(FieldCache::StringIndex* index, int32_t len)
 {
 	this->length = len;
 	this->index = index;
+	this->order = index->order;
 }
 
 int32_t ScoreDocComparators::String::compare (struct ScoreDoc* i, struct ScoreDoc* j) {
 	CND_PRECONDITION(i->doc<length, L"i->doc>=length")
 	CND_PRECONDITION(j->doc<length, L"j->doc>=length")
-	if (index->order[i->doc] < index->order[j->doc]) return -1;
-	if (index->order[i->doc] > index->order[j->doc]) return 1;
+	//ordinals are in term order, so the terms themselves need not be looked at
+	const int64_t fi = order->get(i->doc);
+	const int64_t fj = order->get(j->doc);
+	if (fi < fj) return -1;
+	if (fi > fj) return 1;
 	return 0;
 }
 
 CL_NS(util)::Comparable* ScoreDocComparators::String::sortValue (struct ScoreDoc* i) {
-	return _CLNEW CL_NS(util)::Compare::WChar(index->lookup[index->order[i->doc]]);
+	return _CLNEW StringSortValue(index->getTerm(index->getOrd(i->doc)));
 }
 
 int32_t ScoreDocComparators::String::sortType() {
@@ -119,4 +140,48 @@ int32_t ScoreDocComparators::Float::sortType() {
 	return SortField::FLOAT;
 }
 
+ScoreDocComparators::Numeric::Numeric(CL_NS(index)::NumericDocValues* values):
+	values(values)
+{
+}
+
+int32_t ScoreDocComparators::Numeric::compare (struct ScoreDoc* i, struct ScoreDoc* j) {
+	const int64_t vi = values->get(i->doc);
+	const int64_t vj = values->get(j->doc);
+	if (vi < vj) return -1;
+	if (vi > vj) return 1;
+	return 0;
+}
+
+CL_NS(util)::Comparable* ScoreDocComparators::Numeric::sortValue (struct ScoreDoc* i) {
+	return _CLNEW CL_NS(util)::Compare::Int64(values->get(i->doc));
+}
+
+int32_t ScoreDocComparators::Numeric::sortType() {
+	return SortField::LONG;
+}
+
+ScoreDocComparators::Sorted::Sorted(CL_NS(index)::SortedDocValues* values):
+	values(values)
+{
+}
+
+int32_t ScoreDocComparators::Sorted::compare (struct ScoreDoc* i, struct ScoreDoc* j) {
+	//ordinals are in value order, as for String
+	const int32_t oi = values->getOrd(i->doc);
+	const int32_t oj = values->getOrd(j->doc);
+	if (oi < oj) return -1;
+	if (oi > oj) return 1;
+	return 0;
+}
+
+CL_NS(util)::Comparable* ScoreDocComparators::Sorted::sortValue (struct ScoreDoc* i) {
+	const wchar_t* value = values->lookup(values->getOrd(i->doc));
+	return _CLNEW StringSortValue(value == NULL ? NULL : _wcsdup(value));
+}
+
+int32_t ScoreDocComparators::Sorted::sortType() {
+	return SortField::STRING;
+}
+
 CL_NS_END
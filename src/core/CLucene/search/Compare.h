@@ -14,6 +14,9 @@
 #include "Sort.h"
 #include "FieldCache.h"
 
+CL_CLASS_DEF(index,NumericDocValues)
+CL_CLASS_DEF(index,SortedDocValues)
+
 CL_NS_DEF(search)
 
 
@@ -41,6 +44,7 @@ public:
 
 	class CLUCENE_EXPORT String: public ScoreDocComparator {
 		FieldCache::StringIndex* index;
+		const CL_NS(util)::PackedInts* order;
 		int32_t length;
 	public:
 		String(FieldCache::StringIndex* index, int32_t len);
@@ -69,6 +73,26 @@ public:
 		CL_NS(util)::Comparable* sortValue (struct ScoreDoc* i);
 		int32_t sortType();
 	};
+
+	/** Sorts by the numeric doc values of a field, which belong to the reader */
+	class CLUCENE_EXPORT Numeric:public ScoreDocComparator {
+		CL_NS(index)::NumericDocValues* values;
+	public:
+		Numeric(CL_NS(index)::NumericDocValues* values);
+		int32_t compare (struct ScoreDoc* i, struct ScoreDoc* j);
+		CL_NS(util)::Comparable* sortValue (struct ScoreDoc* i);
+		int32_t sortType();
+	};
+
+	/** Sorts by the ordinals of the sorted doc values of a field, which belong to the reader */
+	class CLUCENE_EXPORT Sorted:public ScoreDocComparator {
+		CL_NS(index)::SortedDocValues* values;
+	public:
+		Sorted(CL_NS(index)::SortedDocValues* values);
+		int32_t compare (struct ScoreDoc* i, struct ScoreDoc* j);
+		CL_NS(util)::Comparable* sortValue (struct ScoreDoc* i);
+		int32_t sortType();
+	};
 };
 
 
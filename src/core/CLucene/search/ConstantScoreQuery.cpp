@@ -12,6 +12,8 @@
 #include "SearchHeader.h"
 #include "Scorer.h"
 #include "RangeFilter.h"
+#include "Searchable.h"
+#include "QueryCache.h"
 #include "Similarity.h"
 #include "CLucene/index/IndexReader.h"
 #include "CLucene/util/BitSet.h"
@@ -25,18 +27,27 @@ CL_NS_DEF(search)
 
 class ConstantScorer : public Scorer
 {
-    BitSet* bits;
+    Filter* filter;
+    QueryCache* cache;
+    const BitSet* bits;
     const float_t theScore;
     int32_t _doc;
 
 public:
-    ConstantScorer(Similarity* similarity, IndexReader* reader, Weight* w, Filter* filter) : Scorer(similarity),
-        bits(filter->bits(reader)), theScore(w->getValue()), _doc(-1)
+    /** Takes the bits of filter from cache, under key, if cache is not NULL */
+    ConstantScorer(Similarity* similarity, IndexReader* reader, Weight* w, Filter* _filter,
+        QueryCache* _cache, Query* key) : Scorer(similarity),
+        filter(_filter), cache(_cache),
+        bits(_cache != NULL ? _cache->bits(key, _filter, reader) : _filter->bits(reader)),
+        theScore(w->getValue()), _doc(-1)
     {
     }
     virtual ~ConstantScorer()
     {
-        _CLLDELETE(bits);
+        if (cache != NULL)
+            cache->release(bits);
+        else if (filter->shouldDeleteBitSet(bits))
+            _CLLDELETE(bits);
     }
 
     bool next()
@@ -81,15 +92,28 @@ private:
     float_t queryNorm;
     float_t queryWeight;
     const ConstantScoreQuery* parentQuery;
+    QueryCache* cache;
+    // the filter without the boost, which the cache is looked up with
+    Query* cacheKey;
 
 public:
     ConstantWeight(ConstantScoreQuery* enclosingInstance, Searcher* searcher) :
         similarity(enclosingInstance->getSimilarity(searcher)),
         queryNorm(0), queryWeight(0),
-        parentQuery(enclosingInstance)
+        parentQuery(enclosingInstance),
+        cache(searcher->getQueryCache()),
+        cacheKey(NULL)
     {
+        if (cache != NULL)
+        {
+            cacheKey = _CLNEW ConstantScoreQuery(parentQuery->filter->clone());
+            cache->onUse(cacheKey);
+        }
+    }
+    virtual ~ConstantWeight()
+    {
+        _CLLDELETE(cacheKey);
     }
-    virtual ~ConstantWeight() {}
 
     Query* getQuery()
     {
@@ -115,7 +139,7 @@ public:
 
     Scorer* scorer(IndexReader* reader)
     {
-        return _CLNEW ConstantScorer(similarity, reader, this, parentQuery->filter);
+        return _CLNEW ConstantScorer(similarity, reader, this, parentQuery->filter, cache, cacheKey);
     }
 
     Explanation* explain(IndexReader* reader, int32_t doc)
@@ -201,25 +225,21 @@ std::wstring ConstantScoreQuery::toString(const wchar_t* /*field*/) const
     return buf;
 }
 
-// TODO: Filter is missing an equals() function, hence this equals() is incomplete
 bool ConstantScoreQuery::equals(Query* o) const
 {
     if (this == o) return true;
     if (!(o->instanceOf(L"ConstantScoreQuery"))) return false;
     ConstantScoreQuery* other = (ConstantScoreQuery*) o;
     return this->getBoost() == other->getBoost()
-        /*&& filter->equals(other->filter)*/;
+        && filter->equals(other->filter);
 }
 
-// TODO: Filter is missing hashCode()
 size_t ConstantScoreQuery::hashCode() const
 {
-    // Simple add is OK since no existing filter hashcode has a float component.
-    //return filter->hashCode() + FloatToIntBits(getBoost());
-    return 0;
+    return filter->hashCode() ^ Similarity::floatToByte(getBoost());
 }
 
-ConstantScoreQuery::ConstantScoreQuery(const ConstantScoreQuery& copy) : filter(copy.getFilter()->clone())
+ConstantScoreQuery::ConstantScoreQuery(const ConstantScoreQuery& copy) : Query(copy), filter(copy.getFilter()->clone())
 {
 }
 
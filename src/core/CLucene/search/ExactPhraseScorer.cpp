@@ -2,92 +2,204 @@
 * Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
 
 * Updated by https://github.com/farfella/.
-* 
-* Distributable under the terms of either the Apache License (Version 2.0) or 
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
 * the GNU Lesser General Public License, as specified in the COPYING file.
 ------------------------------------------------------------------------------*/
 #include "CLucene/_ApiHeader.h"
 #include "CLucene/index/Terms.h"
 #include "SearchHeader.h"
-#include "SearchHeader.h"
 #include "Scorer.h"
+#include "Explanation.h"
+#include "Similarity.h"
 #include "_ExactPhraseScorer.h"
 
 CL_NS_USE(index)
 CL_NS_DEF(search)
 
-	ExactPhraseScorer::ExactPhraseScorer(Weight* weight, TermPositions** tps, 
-		int32_t* offsets, Similarity* similarity, uint8_t* norms):
-		PhraseScorer(weight, tps, offsets, similarity, norms){
-	//Func - Constructor
-	//Pre  - tps != NULL
-	//       tpsLength >= 0
-	//       n != NULL
-	//Post - Instance has been created
+/** The positions of one term of the phrase */
+class ExactPhraseScorer::Postings {
+public:
+	TermPositions* tp;
+	int32_t offset;
+	int32_t docFreq;
+	int32_t doc;
+
+	// the positions of the term in doc less offset, once they were read
+	int32_t* positions;
+	int32_t size;
+	int32_t capacity;
+	int32_t upto; // the first position not before the current one of the intersection
 
-		CND_PRECONDITION(tps != NULL,L"tps is NULL");
-		CND_PRECONDITION(tps[0] != NULL,L"tps is NULL");
-		//CND_PRECONDITION(n != NULL,"n is NULL") =this is checked already in PhraseScorer
+	/** Moves to the first document from target, which is after doc */
+	bool advance(const int32_t target) {
+		if ( target == doc + 1 ? tp->next() : tp->skipTo(target) ) {
+			doc = tp->doc();
+			return true;
+		}
+		doc = LUCENE_INT32_MAX_SHOULDBE;
+		return false;
+	}
 
+	void readPositions() {
+		size = tp->freq();
+		if ( size > capacity ) {
+			_CLDELETE_ARRAY(positions);
+			capacity = cl_max(size, capacity * 2);
+			positions = _CL_NEWARRAY(int32_t, capacity);
+		}
+		tp->nextPositions(positions, size);
+		for ( int32_t i = 0; i < size; i++ )
+			positions[i] -= offset;
+		upto = 0;
 	}
+};
+
+ExactPhraseScorer::ExactPhraseScorer(Weight* _weight, TermPositions** tps,
+	int32_t* offsets, Similarity* similarity, uint8_t* _norms, const int32_t* docFreqs):
+	Scorer(similarity), weight(_weight), norms(_norms), value(_weight->getValue()),
+	nrPostings(0), currentDoc(-1), freq(0.0f)
+{
+	CND_PRECONDITION(tps != NULL,L"tps is NULL");
+	CND_PRECONDITION(tps[0] != NULL,L"tps is NULL");
+
+	while ( tps[nrPostings] != NULL )
+		nrPostings++;
+
+	postings = _CL_NEWARRAY(Postings, nrPostings);
+	for ( int32_t i = 0; i < nrPostings; i++ ) {
+		Postings p;
+		p.tp = tps[i];
+		p.offset = offsets[i];
+		p.docFreq = docFreqs == NULL ? 0 : docFreqs[i];
+		p.doc = -1;
+		p.positions = NULL;
+		p.size = p.capacity = p.upto = 0;
 
-	ExactPhraseScorer::~ExactPhraseScorer(){}
-
-	float_t ExactPhraseScorer::phraseFreq(){
-	//Func - Returns the freqency of the phrase
-	//Pre  - first != NULL
-	//       last  != NULL
-	//       pq    != NULL
-	//       size of the PhraseQueue pq is 0
-	//Post - The frequency of the phrase has been returned
-
-		CND_PRECONDITION(first != NULL,L"first is NULL");
-		CND_PRECONDITION(last  != NULL,L"last is NULL");
-		CND_PRECONDITION(pq    != NULL,L"pq is NULL");
-		CND_PRECONDITION(pq->size()==0,L"pq is not empty");
-
-		// sort list with pq
-		pq->clear();
-
-		//Add the nodes of the list of PhrasePositions and store them
-		//into the PhraseQueue pq so it can used to build
-		//a list of sorted nodes
-		for (PhrasePositions* pp = first; pp != NULL; pp = pp->_next) {
-			//Read the first TermPosition of the current PhrasePositions pp
-			pp->firstPosition();
-			//Store the current PhrasePositions pp into the PhraseQueue pq
-			pq->put(pp);
+		// keep the rarest term first, and the terms with as many documents in phrase order
+		int32_t j = i - 1;
+		while ( j >= 0 && postings[j].docFreq > p.docFreq ) {
+			postings[j + 1] = postings[j];
+			j--;
 		}
-		//pqToList requires that first and last be NULL when it's called.  
-		//This is done at the beginning of pqToList()
-		//In this case, the nodes of the linked list are referenced by pq (see
-		//above loop), so we can clear our pointers to the head and tail of the
-		//linked list without fear of leaking the nodes.
-		
-		//rebuild list from pq
-		pqToList();
-
-		// for counting how many times the exact phrase is found in current document,
-		// just count how many times all PhrasePosition's have exactly the same position.   
-		int32_t freq = 0;
-		do {		//find position with all terms
-			while (first->position < last->position){	//scan forward in first
-				do{
-					if (!first->nextPosition()){
-						return (float_t)freq;
-					}
-				} while (first->position < last->position);
-				//Make the current first node the last node in the list
-				firstToLast();
+		postings[j + 1] = p;
+	}
+}
+
+ExactPhraseScorer::~ExactPhraseScorer() {
+	for ( int32_t i = 0; i < nrPostings; i++ ) {
+		postings[i].tp->close();
+		_CLVDELETE(postings[i].tp);
+		_CLDELETE_ARRAY(postings[i].positions);
+	}
+	_CLDELETE_ARRAY(postings);
+}
+
+bool ExactPhraseScorer::advance(int32_t target) {
+	for (;;) {
+		// the rarest term leads, the others skip to its documents
+		Postings& lead = postings[0];
+		if ( lead.doc < target && !lead.advance(target) )
+			break;
+		const int32_t doc = lead.doc;
+
+		int32_t i = 1;
+		for ( ; i < nrPostings; i++ ) {
+			Postings& p = postings[i];
+			if ( p.doc < doc && !p.advance(doc) ) {
+				currentDoc = LUCENE_INT32_MAX_SHOULDBE;
+				return false;
 			}
-			//all equal: a match has been found
-			freq++;
-		} while (last->nextPosition());
+			if ( p.doc > doc )
+				break;
+		}
+
+		if ( i < nrPostings ) {
+			target = postings[i].doc;
+			continue;
+		}
 
-		return (float_t)freq;
+		currentDoc = doc;
+		const int32_t f = phraseFreq();
+		if ( f > 0 ) {
+			freq = (float_t) f;
+			return true;
+		}
+		target = doc + 1;
+	}
+	currentDoc = LUCENE_INT32_MAX_SHOULDBE;
+	return false;
+}
+
+int32_t ExactPhraseScorer::phraseFreq() {
+	// the term with the fewest positions in this document drives the intersection
+	Postings* driver = NULL;
+	for ( int32_t i = 0; i < nrPostings; i++ ) {
+		postings[i].readPositions();
+		if ( driver == NULL || postings[i].size < driver->size )
+			driver = &postings[i];
 	}
 
-	std::wstring ExactPhraseScorer::toString() {
-		return L"ExactPhraseScorer";
+	int32_t f = 0;
+	for ( int32_t d = 0; d < driver->size; d++ ) {
+		const int32_t position = driver->positions[d];
+		bool match = true;
+		for ( int32_t i = 0; i < nrPostings && match; i++ ) {
+			Postings& p = postings[i];
+			if ( &p == driver )
+				continue;
+			while ( p.upto < p.size && p.positions[p.upto] < position )
+				p.upto++;
+			if ( p.upto == p.size )
+				return f;
+			match = p.positions[p.upto] == position;
+		}
+		if ( match )
+			f++;
 	}
+	return f;
+}
+
+bool ExactPhraseScorer::next() {
+	if ( currentDoc == LUCENE_INT32_MAX_SHOULDBE )
+		return false;
+	return advance(currentDoc + 1);
+}
+
+bool ExactPhraseScorer::skipTo(int32_t target) {
+	if ( currentDoc == LUCENE_INT32_MAX_SHOULDBE )
+		return false;
+	return advance(cl_max(target, currentDoc + 1));
+}
+
+int32_t ExactPhraseScorer::doc() const {
+	return currentDoc;
+}
+
+float_t ExactPhraseScorer::score() {
+	float_t raw = getSimilarity()->tf(freq) * value; // raw score
+	return raw * Similarity::decodeNorm(norms[currentDoc]); // normalize
+}
+
+Explanation* ExactPhraseScorer::explain(int32_t _doc) {
+	Explanation* tfExplanation = _CLNEW Explanation();
+
+	while ( next() && doc() < _doc ) {
+	}
+
+	float_t phraseFreq = (doc() == _doc) ? freq : 0.0f;
+	tfExplanation->setValue(getSimilarity()->tf(phraseFreq));
+
+	std::wstring buf;
+	buf.append(L"tf(phraseFreq=");
+	buf.append(std::to_wstring(phraseFreq));
+	buf.append(L")");
+	tfExplanation->setDescription(buf.c_str());
+
+	return tfExplanation;
+}
+
+std::wstring ExactPhraseScorer::toString() {
+	return L"ExactPhraseScorer";
+}
 CL_NS_END
@@ -64,4 +64,25 @@ FieldCacheAuto::~FieldCacheAuto(){
 	}
 }
 
+size_t FieldCacheAuto::ramBytesUsed() const{
+	size_t ret = sizeof(FieldCacheAuto);
+	if ( contentType == FieldCacheAuto::INT_ARRAY ){
+		ret += sizeof(int32_t) * contentLen;
+	}else if ( contentType == FieldCacheAuto::FLOAT_ARRAY ){
+		ret += sizeof(float_t) * contentLen;
+	}else if ( contentType == FieldCacheAuto::STRING_INDEX ){
+		ret += stringIndex->ramBytesUsed();
+	}else if ( contentType == FieldCacheAuto::STRING_ARRAY ){
+		ret += sizeof(wchar_t*) * (contentLen + 1);
+		for ( int32_t i=0;i<contentLen;i++ ){
+			if ( stringArray[i] != NULL )
+				ret += sizeof(wchar_t) * (wcslen(stringArray[i]) + 1);
+		}
+	}else if ( contentType == FieldCacheAuto::COMPARABLE_ARRAY ){
+		//the size of the comparables themselves is not known
+		ret += sizeof(CL_NS(util)::Comparable*) * contentLen;
+	}
+	return ret;
+}
+
 CL_NS_END
@@ -10,9 +10,12 @@
 #define _lucene_search_FieldCache_
 
 //#include "Sort.h"
+#include "CLucene/util/PackedInts.h"
+#include "CLucene/LuceneThreads.h"
 
 CL_CLASS_DEF(index,IndexReader)
 CL_CLASS_DEF(search,SortComparator)
+CL_CLASS_DEF(search,SortComparatorSource)
 CL_CLASS_DEF(search,ScoreDocComparator)
 CL_CLASS_DEF(util,Comparable)
 
@@ -24,28 +27,83 @@ class FieldCacheAuto;
 /**
  * Expert: Maintains caches of term values.
  *
+ * Entries stay in the cache until their reader is closed, unless a memory
+ * budget is set with setMaxRamBytes(), in which case the least recently used
+ * entries that no search is holding on to are evicted to stay within it.
+ * The budget only applies to entries obtained through getPinned(): the
+ * other getters return entries without a reference for the caller, so those
+ * are kept until their reader is closed, as they always were.
  */
 class CLUCENE_EXPORT FieldCache :LUCENE_BASE {
 public:
    virtual ~FieldCache(){
    }
 
-	/** Expert: Stores term text values and document ordering data. */
+	/** Expert: Stores term text values and document ordering data.
+	 * Ordinal 0 stands for documents without a term, the terms follow in
+	 * natural order from ordinal 1. Comparing ordinals compares the terms.
+	 *
+	 * The ordinals used to be an int32_t array <code>order</code>, and the
+	 * terms an array of strings <code>lookup</code>. Use getOrd() for
+	 * <code>order[doc]</code> and lookupTerm() for <code>lookup[ord]</code>;
+	 * getOrder() and getLookup() still hand out the old arrays, at the
+	 * memory cost they always had.
+	 */
 	class CLUCENE_EXPORT StringIndex:LUCENE_BASE {
+		//the old arrays, decoded when first asked for
+		DEFINE_MUTEX(THIS_LOCK)
+		int32_t* orderArray;
+		wchar_t** lookupArray;
+		void decodeLookup();
 	public:
-		/** All the term values, in natural order. */
-		wchar_t** lookup;
+		/** For each document, the ordinal of its term, packed into as
+		 * few bits as the number of terms needs. */
+		CL_NS(util)::PackedInts* order;
 
-		/** For each document, an index into the lookup array. */
-		int32_t* order;
+		/** All the term values, in natural order, as one block of UTF-8 text. */
+		char* terms;
 
-        int count;
+		/** For each ordinal, where its term starts in terms. The term ends
+		 * where the next one starts, so there is one more offset than ordinals. */
+		CL_NS(util)::PackedInts* termOffsets;
+
+		/** The number of ordinals, including 0 */
+		int count;
 
 		/** Creates one of these objects 
             @memory Consumes all memory given.
         */
-		StringIndex (int32_t* values, wchar_t** lookup, int count);
+		StringIndex (CL_NS(util)::PackedInts* order, char* terms, CL_NS(util)::PackedInts* termOffsets, int count);
         ~StringIndex();
+
+		/** Returns the ordinal of the term of a document. */
+		inline int32_t getOrd(const int32_t doc) const{
+			return (int32_t)order->get(doc);
+		}
+
+		/** Returns the UTF-8 text of the term with the given ordinal, which
+		 * is not terminated, and its length in bytes. NULL for ordinal 0. */
+		const char* getTermUTF8(const int32_t ord, int32_t& length) const;
+
+		/** Returns a copy of the term with the given ordinal, NULL for
+		 * ordinal 0. Delete it with _CLDELETE_CARRAY. */
+		wchar_t* getTerm(const int32_t ord) const;
+
+		/** Returns the term with the given ordinal, NULL for ordinal 0. It
+		 * stays valid as long as this index. The first call decodes all terms,
+		 * so prefer getTerm() or getTermUTF8() for a few lookups. */
+		const wchar_t* lookupTerm(const int32_t ord);
+
+		/** @deprecated The ordinals are packed now, see getOrd(). This decodes
+		 * them into an array of one int32_t per document, kept with the index. */
+		_CL_DEPRECATED(getOrd) const int32_t* getOrder();
+
+		/** @deprecated The terms are stored as UTF-8 now, see lookupTerm(). This
+		 * returns all terms in natural order, NULL at ordinal 0. */
+		_CL_DEPRECATED(lookupTerm) const wchar_t* const* getLookup();
+
+		/** Estimates the memory held, in bytes. */
+		size_t ramBytesUsed() const;
 	};
 
 
@@ -127,7 +185,50 @@ public:
    * @throws IOException  If any error occurs.
    */
    virtual FieldCacheAuto* getCustom (CL_NS(index)::IndexReader* reader, const wchar_t* field, SortComparator* comparator) = 0;
-    
+
+  /** Expert: same as the get methods above, chosen by <code>type</code>
+   * (a SortField type, or STRING_INDEX), but the returned entry carries a
+   * reference for the caller, so it cannot be evicted while it is in use.
+   * Release it with _CLDECDELETE when done.
+   * @param comparator Used for SortField::CUSTOM, NULL otherwise.
+   */
+   virtual FieldCacheAuto* getPinned (CL_NS(index)::IndexReader* reader, const wchar_t* field, int32_t type,
+       SortComparator* comparator = NULL) = 0;
+
+  /** Expert: describes one entry of the cache, see getCacheEntries(). */
+  class CLUCENE_EXPORT CacheEntry {
+  public:
+    CL_NS(index)::IndexReader* reader;  ///< reader the values were read from
+    std::wstring field;                 ///< field the values were read from
+    int32_t type;                       ///< a SortField type, or STRING_INDEX
+    SortComparatorSource* custom;       ///< comparator of SortField::CUSTOM entries
+    size_t ramBytesUsed;                ///< estimated memory held by the values
+    bool pinned;                        ///< true while a search holds the entry
+  };
+
+  /** Expert: lists the entries of the cache, with the memory each holds. */
+  virtual void getCacheEntries(std::vector<CacheEntry>& entries) = 0;
+
+  /** Expert: estimated memory held by all entries. */
+  virtual int64_t getRamBytesUsed() = 0;
+
+  /** Expert: sets the memory budget of the cache. Once it is exceeded, least
+   * recently used entries are evicted until the cache fits again. Entries in
+   * use by a search are never evicted, so the budget may be exceeded while
+   * they are, and neither are entries that were ever returned by one of the
+   * getters other than getPinned(). 0 (the default) means no limit.
+   */
+  virtual void setMaxRamBytes(int64_t maxRamBytes) = 0;
+
+  /** Expert: the memory budget, see setMaxRamBytes(). */
+  virtual int64_t getMaxRamBytes() = 0;
+
+  /** Expert: drops all entries of <code>reader</code> (done anyway when it closes). */
+  virtual void purge(CL_NS(index)::IndexReader* reader) = 0;
+
+  /** Expert: drops all entries. */
+  virtual void purgeAllCaches() = 0;
+
 	/** Cleanup static data */
 	static CLUCENE_LOCAL void _shutdown();
 };
@@ -141,8 +242,11 @@ public:
 	This class is also used when returning getInt, getFloat, etc
 	because we have no way of returning the size of the array and
 	this class can be used to determine the array size
+
+	Entries are reference counted: the cache holds one reference, and
+	FieldCache::getPinned() hands out more.
 */	
-class CLUCENE_EXPORT FieldCacheAuto:LUCENE_BASE{
+class CLUCENE_EXPORT FieldCacheAuto:LUCENE_REFBASE{
 public:
 	enum{
 		INT_ARRAY=1,
@@ -156,6 +260,10 @@ public:
 
 	FieldCacheAuto(int32_t len, int32_t type);
 	~FieldCacheAuto();
+
+	/** Estimates the memory held by the contents, in bytes. */
+	size_t ramBytesUsed() const;
+
 	///if contents should be deleted too, depending on type
 	bool ownContents;
 	int32_t contentLen; //number of items in the list
@@ -19,30 +19,69 @@ CL_NS_USE(util)
 CL_NS_USE(index)
 CL_NS_DEF(search)
 
+///an entry of the field cache, together with what the cache knows about it
+class fieldcacheSlot: LUCENE_BASE{
+public:
+	FieldCacheAuto* value;
+	size_t ramBytesUsed;  ///< 0 for SortField::AUTO entries, which share the value of a typed entry
+	int32_t lastUse;      ///< cache clock when the entry was last looked up
+	bool retained;        ///< handed out unpinned, so it stays until its reader closes
+	IndexReader* reader;  ///< the reader and key the entry is stored under
+	FieldCacheImpl::FileEntry* entry;
+	fieldcacheSlot* shared; ///< the AUTO entry sharing the value of a typed one, and the other way round
+
+	//the shard's list of entries which may be evicted, least recently used first.
+	//Only typed entries are on it, their AUTO entry goes with them
+	fieldcacheSlot* older;
+	fieldcacheSlot* newer;
+	bool linked;
+
+	fieldcacheSlot(FieldCacheAuto* _value, size_t _ramBytesUsed, IndexReader* _reader, FieldCacheImpl::FileEntry* _entry):
+		value(_value),
+		ramBytesUsed(_ramBytesUsed),
+		lastUse(0),
+		retained(false),
+		reader(_reader),
+		entry(_entry),
+		shared(NULL),
+		older(NULL),
+		newer(NULL),
+		linked(false)
+	{
+	}
+	~fieldcacheSlot(){
+		_CLDECDELETE(value);
+	}
+
+	/** True if anyone but the cache holds a reference to the value. The
+	cache holds one for this entry, and one for the entry sharing it. */
+	bool pinned() const{
+		return value->__cl_getref() > (shared != NULL ? 2 : 1);
+	}
+};
+
 ///the type that is stored in the field cache. can't use a typedef because
 ///the decorated name would become too long
 class fieldcacheCacheReaderType: public CL_NS(util)::CLHashMap<FieldCacheImpl::FileEntry*,
-	FieldCacheAuto*,
+	fieldcacheSlot*,
 	FieldCacheImpl::FileEntry::Compare,
 	FieldCacheImpl::FileEntry::Equals,
 	CL_NS(util)::Deletor::Object<FieldCacheImpl::FileEntry>,
-	CL_NS(util)::Deletor::Object<FieldCacheAuto> >{
+	CL_NS(util)::Deletor::Object<fieldcacheSlot> >{
 public:
     fieldcacheCacheReaderType(){
-		setDeleteKey(false);
-		setDeleteValue(false);
+		setDeleteKey(true);
+		setDeleteValue(true);
 	}
 	~fieldcacheCacheReaderType(){
-		iterator itr = begin();
-		while ( itr != end() ){
-			FieldCacheImpl::FileEntry* f = itr->first;
-			if ( f->getType() != SortField::AUTO )
-				_CLDELETE( itr->second );
-			_CLDELETE( f );
-			++itr;
-		}
 		clear();
 	}
+	int64_t ramBytesUsed() const{
+		int64_t ret = 0;
+		for ( const_iterator itr = begin(); itr != end(); ++itr )
+			ret += itr->second->ramBytesUsed;
+		return ret;
+	}
 };
 
 //note: typename gets too long if using cacheReaderType as a typename
@@ -64,27 +103,180 @@ public:
 	}
 };
 
-FieldCache::StringIndex::StringIndex (int32_t* values, wchar_t** lookup, int count) {
+///one lock stripe of the field cache
+class fieldcacheShard: LUCENE_BASE{
+public:
+	DEFINE_MUTEX(THIS_LOCK)
+	fieldcacheCacheType cache;
+	fieldcacheSlot* oldest; ///< the entries which may be evicted, least recently used first
+	fieldcacheSlot* newest;
+
+	fieldcacheShard():
+		cache(false,true),
+		oldest(NULL),
+		newest(NULL)
+	{
+	}
+	~fieldcacheShard(){
+		cache.clear();
+	}
+
+	void unlink(fieldcacheSlot* slot){
+		if ( !slot->linked )
+			return;
+		if ( slot->older != NULL )
+			slot->older->newer = slot->newer;
+		else
+			oldest = slot->newer;
+		if ( slot->newer != NULL )
+			slot->newer->older = slot->older;
+		else
+			newest = slot->older;
+		slot->older = slot->newer = NULL;
+		slot->linked = false;
+	}
+
+	/** Marks slot as used at tick, retaining it if asked to. An AUTO entry
+	marks the typed entry it shares the value with. */
+	void use(fieldcacheSlot* slot, int32_t tick, bool retain){
+		slot->lastUse = tick;
+		if ( slot->entry->getType() == SortField::AUTO )
+			slot = slot->shared;
+		if ( slot == NULL )
+			return;
+		slot->lastUse = tick;
+		if ( retain )
+			slot->retained = true;
+		unlink(slot);
+		if ( !slot->retained ){
+			slot->older = newest;
+			if ( newest != NULL )
+				newest->newer = slot;
+			else
+				oldest = slot;
+			newest = slot;
+			slot->linked = true;
+		}
+	}
+
+	/** The least recently used entry nobody holds, or NULL. Entries in use
+	are rare, so this is hardly ever more than a step. */
+	fieldcacheSlot* evictable() const{
+		fieldcacheSlot* slot = oldest;
+		while ( slot != NULL && slot->pinned() )
+			slot = slot->newer;
+		return slot;
+	}
+
+	/** Takes the entries of readerCache off the list, before they are dropped */
+	void unlinkAll(fieldcacheCacheReaderType* readerCache){
+		for ( fieldcacheCacheReaderType::iterator e = readerCache->begin(); e != readerCache->end(); ++e )
+			unlink(e->second);
+	}
+};
+
+FieldCache::StringIndex::StringIndex (PackedInts* order, char* terms, PackedInts* termOffsets, int count) {
     this->count = count;
-	this->order = values;
-	this->lookup = lookup;
+	this->order = order;
+	this->terms = terms;
+	this->termOffsets = termOffsets;
+	this->orderArray = NULL;
+	this->lookupArray = NULL;
 }
 
 FieldCache::StringIndex::~StringIndex(){
-    _CLDELETE_ARRAY(order);
+    _CLDELETE(order);
+    _CLDELETE_ARRAY(terms);
+    _CLDELETE(termOffsets);
+    _CLDELETE_ARRAY(orderArray);
+    if ( lookupArray != NULL ){
+        for ( int32_t i = 0; i < count; i++ )
+            _CLDELETE_CARRAY(lookupArray[i]);
+        _CLDELETE_ARRAY(lookupArray);
+    }
+}
+
+const char* FieldCache::StringIndex::getTermUTF8(const int32_t ord, int32_t& length) const{
+    CND_PRECONDITION(ord >= 0 && ord < count, L"ord out of range");
+    if ( ord == 0 ){
+        length = 0;
+        return NULL;
+    }
+    const int64_t start = termOffsets->get(ord);
+    length = (int32_t)(termOffsets->get(ord + 1) - start);
+    return terms + start;
+}
+
+wchar_t* FieldCache::StringIndex::getTerm(const int32_t ord) const{
+    int32_t length;
+    const char* utf8 = getTermUTF8(ord, length);
+    if ( utf8 == NULL )
+        return NULL;
+
+    //every character takes at least one byte
+    wchar_t* ret = _CL_NEWARRAY(wchar_t, length + 1);
+    int32_t len = 0;
+    for ( int32_t i = 0; i < length; len++ ){
+        size_t r = lucene_utf8towc(ret[len], utf8 + i);
+        if ( r == 0 )
+            _CLTHROWA(CL_ERR_Runtime, "invalid UTF-8 in the field cache");
+        i += (int32_t)r;
+    }
+    ret[len] = 0;
+    return ret;
+}
+
+void FieldCache::StringIndex::decodeLookup(){
+    SCOPED_LOCK_MUTEX(THIS_LOCK)
+    if ( lookupArray != NULL )
+        return;
+    wchar_t** ret = _CL_NEWARRAY(wchar_t*, count);
+    for ( int32_t i = 0; i < count; i++ )
+        ret[i] = getTerm(i);
+    lookupArray = ret;
+}
 
-    for ( int i=0;i<count;i++ )
-        _CLDELETE_CARRAY(lookup[i]);
-    _CLDELETE_ARRAY(lookup);
+const wchar_t* FieldCache::StringIndex::lookupTerm(const int32_t ord){
+    CND_PRECONDITION(ord >= 0 && ord < count, L"ord out of range");
+    decodeLookup();
+    return lookupArray[ord];
 }
 
-FieldCacheImpl::FieldCacheImpl()
+const wchar_t* const* FieldCache::StringIndex::getLookup(){
+    decodeLookup();
+    return lookupArray;
+}
+
+const int32_t* FieldCache::StringIndex::getOrder(){
+    SCOPED_LOCK_MUTEX(THIS_LOCK)
+    if ( orderArray == NULL ){
+        const int32_t docs = (int32_t)order->size();
+        int32_t* ret = _CL_NEWARRAY(int32_t, docs);
+        for ( int32_t i = 0; i < docs; i++ )
+            ret[i] = (int32_t)order->get(i);
+        orderArray = ret;
+    }
+    return orderArray;
+}
+
+size_t FieldCache::StringIndex::ramBytesUsed() const{
+    return sizeof(StringIndex) + order->ramBytesUsed() + termOffsets->ramBytesUsed()
+        + (size_t)termOffsets->get(count) + 1;
+}
+
+FieldCacheImpl::FieldCacheImpl():
+    ramBytesUsed(0),
+    maxRamBytes(0)
 {
-    cache = _CLNEW fieldcacheCacheType(false,true);
+    _LUCENE_ATOMIC_INT_SET(clock,0);
+    shards = _CL_NEWARRAY(fieldcacheShard*,LUCENE_FIELDCACHE_SHARDS);
+    for ( int32_t i=0;i<LUCENE_FIELDCACHE_SHARDS;i++ )
+        shards[i] = _CLNEW fieldcacheShard;
 }
 FieldCacheImpl::~FieldCacheImpl(){
-    cache->clear();
-    _CLDELETE(cache);
+    for ( int32_t i=0;i<LUCENE_FIELDCACHE_SHARDS;i++ )
+        _CLDELETE(shards[i]);
+    _CLDELETE_ARRAY(shards);
 }
 
 FieldCacheImpl::FileEntry::FileEntry (const wchar_t* field, int32_t type) {
@@ -162,82 +354,289 @@ FieldCacheImpl::FileEntry::FileEntry (const wchar_t* field, int32_t type) {
 
 
 
-  /** See if an object is in the cache. */
-  FieldCacheAuto* FieldCacheImpl::lookup (IndexReader* reader, const wchar_t* field, int32_t type) {
-    FieldCacheAuto* ret = NULL;
-    FileEntry* entry = _CLNEW FileEntry (field, type);
-    {
-    	SCOPED_LOCK_MUTEX(THIS_LOCK)
-      	fieldcacheCacheReaderType* readerCache = cache->get(reader);
-      	if (readerCache != NULL)
-          ret = readerCache->get (entry);
-      	_CLDELETE(entry);
-	}
-    return ret;
+  fieldcacheShard* FieldCacheImpl::shardFor (IndexReader* reader, const wchar_t* field){
+    //field is interned, so its address identifies it as well as its text
+    size_t h = ((size_t)reader >> 4) ^ ((size_t)field >> 3);
+    h ^= h >> 7;
+    return shards[h % LUCENE_FIELDCACHE_SHARDS];
   }
 
-
-  /** See if a custom object is in the cache. */
-  FieldCacheAuto* FieldCacheImpl::lookup (IndexReader* reader, const wchar_t* field, SortComparatorSource* comparer) {
+  /** See if an object is in the cache. */
+  FieldCacheAuto* FieldCacheImpl::lookup (IndexReader* reader, FileEntry* entry, bool retain) {
     FieldCacheAuto* ret = NULL;
-    FileEntry* entry = _CLNEW FileEntry (field, comparer);
+    fieldcacheShard* shard = shardFor(reader, entry->getField());
     {
-    	SCOPED_LOCK_MUTEX(THIS_LOCK)
-      	fieldcacheCacheReaderType* readerCache = cache->get(reader);
-      	if (readerCache != NULL)
-        	ret = readerCache->get (entry);
-      	_CLDELETE(entry);
-}
+      SCOPED_LOCK_MUTEX(shard->THIS_LOCK)
+      fieldcacheCacheReaderType* readerCache = shard->cache.get(reader);
+      if (readerCache != NULL){
+        fieldcacheSlot* slot = readerCache->get (entry);
+        if ( slot != NULL ){
+          shard->use(slot, _LUCENE_ATOMIC_INC(&clock), retain);
+          ret = _CL_POINTER(slot->value);
+        }
+      }
+    }
     return ret;
   }
 
 	void FieldCacheImpl::closeCallback(CL_NS(index)::IndexReader* reader, void* fieldCacheImpl){
 		FieldCacheImpl* fci = (FieldCacheImpl*)fieldCacheImpl;
-    	SCOPED_LOCK_MUTEX(fci->THIS_LOCK)
-		fci->cache->remove(reader);
+		fci->purge(reader);
 	}
 
   /** Put an object into the cache. */
-  void FieldCacheImpl::store (IndexReader* reader, const wchar_t* field, int32_t type, FieldCacheAuto* value) {
-    FileEntry* entry = _CLNEW FileEntry (field, type);
+  FieldCacheAuto* FieldCacheImpl::store (IndexReader* reader, FileEntry* entry, FieldCacheAuto* value, bool retain) {
+    //AUTO entries share the value of the typed entry, which accounts for it
+    size_t bytes = entry->getType() == SortField::AUTO ? 0 : value->ramBytesUsed();
+    bool added = false;
+    fieldcacheShard* shard = shardFor(reader, entry->getField());
     {
-    	SCOPED_LOCK_MUTEX(THIS_LOCK)
-	  fieldcacheCacheReaderType* readerCache = cache->get(reader);
-	  if (readerCache == NULL) {
-	    readerCache = _CLNEW fieldcacheCacheReaderType;
-	    cache->put(reader,readerCache);
-	    reader->addCloseCallback(closeCallback, this);
-	  }
-	  readerCache->put (entry, value);
-	 //this is supposed to return the previous value, but it needs to be deleted!!!
+      SCOPED_LOCK_MUTEX(shard->THIS_LOCK)
+      fieldcacheCacheReaderType* readerCache = shard->cache.get(reader);
+      if (readerCache == NULL) {
+        readerCache = _CLNEW fieldcacheCacheReaderType;
+        shard->cache.put(reader,readerCache);
+        reader->addCloseCallback(closeCallback, this);
+      }
+      fieldcacheSlot* slot = readerCache->get(entry);
+      if ( slot != NULL ){
+        //another thread got here first, use its value
+        _CLDELETE(entry);
+        _CLDECDELETE(value);
+      }else{
+        slot = _CLNEW fieldcacheSlot(value, bytes, reader, entry);
+        if ( entry->getType() == SortField::AUTO ){
+          //readAuto() got the value from the typed entry, which the caller still holds
+          for ( fieldcacheCacheReaderType::iterator e = readerCache->begin(); e != readerCache->end(); ++e ){
+            if ( e->second->value == value ){
+              slot->shared = e->second;
+              e->second->shared = slot;
+              break;
+            }
+          }
+        }
+        readerCache->put(entry, slot);
+        added = true;
+      }
+      shard->use(slot, _LUCENE_ATOMIC_INC(&clock), retain);
+      value = _CL_POINTER(slot->value);
+    }
+    if ( added )
+      account(bytes);
+    return value;
+  }
+
+  void FieldCacheImpl::account (int64_t bytes){
+    SCOPED_LOCK_MUTEX(ACCOUNTING_LOCK)
+    ramBytesUsed += bytes;
+  }
+
+  void FieldCacheImpl::evict(){
+    SCOPED_LOCK_MUTEX(EVICTION_LOCK)
+    while ( true ){
+      {
+        SCOPED_LOCK_MUTEX(ACCOUNTING_LOCK)
+        if ( maxRamBytes <= 0 || ramBytesUsed <= maxRamBytes )
+          return;
+      }
+
+      //the least recently used entry nobody holds, of all shards. Each
+      //shard keeps its entries in order of use, so only their heads are compared
+      const int32_t now = (int32_t)_LUCENE_ATOMIC_INT_GET(clock);
+      fieldcacheShard* oldestShard = NULL;
+      uint32_t oldestAge = 0;
+      for ( int32_t i=0;i<LUCENE_FIELDCACHE_SHARDS;i++ ){
+        fieldcacheShard* shard = shards[i];
+        SCOPED_LOCK_MUTEX(shard->THIS_LOCK)
+        fieldcacheSlot* slot = shard->evictable();
+        if ( slot == NULL )
+          continue;
+        //compare ages rather than ticks, so that the clock may wrap around
+        uint32_t age = (uint32_t)(now - slot->lastUse);
+        if ( oldestShard == NULL || age > oldestAge ){
+          oldestShard = shard;
+          oldestAge = age;
+        }
+      }
+      if ( oldestShard == NULL )
+        return; //everything left is in use
+
+      int64_t freed = evictFromShard(oldestShard);
+      if ( freed > 0 )
+        account(-freed);
+    }
+  }
+
+  int64_t FieldCacheImpl::evictFromShard (fieldcacheShard* shard){
+    SCOPED_LOCK_MUTEX(shard->THIS_LOCK)
+    //the shard may have changed since it was looked at, so ask again
+    fieldcacheSlot* victim = shard->evictable();
+    if ( victim == NULL )
+      return 0;
+    shard->unlink(victim);
+    int64_t freed = victim->ramBytesUsed;
+
+    fieldcacheCacheType::iterator r = shard->cache.find(victim->reader);
+    fieldcacheCacheReaderType* readerCache = r->second;
+    //the AUTO entry sharing the value goes too
+    if ( victim->shared != NULL )
+      readerCache->remove(victim->shared->entry);
+    readerCache->remove(victim->entry);
+    if ( readerCache->size() == 0 )
+      shard->cache.removeitr(r);
+    return freed;
+  }
+
+  void FieldCacheImpl::purge(IndexReader* reader){
+    for ( int32_t i=0;i<LUCENE_FIELDCACHE_SHARDS;i++ ){
+      fieldcacheShard* shard = shards[i];
+      int64_t freed = 0;
+      {
+        SCOPED_LOCK_MUTEX(shard->THIS_LOCK)
+        fieldcacheCacheType::iterator itr = shard->cache.find(reader);
+        if ( itr != shard->cache.end() ){
+          freed = itr->second->ramBytesUsed();
+          shard->unlinkAll(itr->second);
+          shard->cache.removeitr(itr);
+        }
+      }
+      if ( freed > 0 )
+        account(-freed);
+    }
+  }
+
+  void FieldCacheImpl::purgeAllCaches(){
+    for ( int32_t i=0;i<LUCENE_FIELDCACHE_SHARDS;i++ ){
+      fieldcacheShard* shard = shards[i];
+      int64_t freed = 0;
+      {
+        SCOPED_LOCK_MUTEX(shard->THIS_LOCK)
+        for ( fieldcacheCacheType::iterator itr = shard->cache.begin(); itr != shard->cache.end(); ++itr )
+          freed += itr->second->ramBytesUsed();
+        shard->cache.clear();
+        shard->oldest = shard->newest = NULL;
+      }
+      if ( freed > 0 )
+        account(-freed);
     }
   }
 
-  /** Put a custom object into the cache. */
-  void FieldCacheImpl::store (IndexReader* reader, const wchar_t* field, SortComparatorSource* comparer, FieldCacheAuto* value) {
-    FileEntry* entry = _CLNEW FileEntry (field, comparer);
+  void FieldCacheImpl::getCacheEntries(std::vector<CacheEntry>& entries){
+    for ( int32_t i=0;i<LUCENE_FIELDCACHE_SHARDS;i++ ){
+      fieldcacheShard* shard = shards[i];
+      SCOPED_LOCK_MUTEX(shard->THIS_LOCK)
+      for ( fieldcacheCacheType::iterator r = shard->cache.begin(); r != shard->cache.end(); ++r ){
+        fieldcacheCacheReaderType* readerCache = r->second;
+        for ( fieldcacheCacheReaderType::iterator e = readerCache->begin(); e != readerCache->end(); ++e ){
+          CacheEntry entry;
+          entry.reader = r->first;
+          entry.field = e->first->getField();
+          entry.type = e->first->getType();
+          entry.custom = e->first->getCustom();
+          entry.ramBytesUsed = e->second->ramBytesUsed;
+          entry.pinned = e->second->pinned();
+          entries.push_back(entry);
+        }
+      }
+    }
+  }
+
+  int64_t FieldCacheImpl::getRamBytesUsed(){
+    SCOPED_LOCK_MUTEX(ACCOUNTING_LOCK)
+    return ramBytesUsed;
+  }
+
+  void FieldCacheImpl::setMaxRamBytes(int64_t maxRamBytes){
     {
-      SCOPED_LOCK_MUTEX(THIS_LOCK)
-      fieldcacheCacheReaderType* readerCache = cache->get(reader);
-      if (readerCache == NULL) {
-        readerCache = _CLNEW fieldcacheCacheReaderType;
-        cache->put(reader, readerCache);
-		reader->addCloseCallback(FieldCacheImpl::closeCallback, this);
+      SCOPED_LOCK_MUTEX(ACCOUNTING_LOCK)
+      this->maxRamBytes = maxRamBytes;
+    }
+    evict();
+  }
+
+  int64_t FieldCacheImpl::getMaxRamBytes(){
+    SCOPED_LOCK_MUTEX(ACCOUNTING_LOCK)
+    return maxRamBytes;
+  }
+
+  FieldCacheAuto* FieldCacheImpl::getPinned (IndexReader* reader, const wchar_t* field, int32_t type, SortComparator* comparator){
+    return get(reader, field, type, comparator, false);
+  }
+
+  FieldCacheAuto* FieldCacheImpl::getRetained (IndexReader* reader, const wchar_t* field, int32_t type, SortComparator* comparator){
+    FieldCacheAuto* ret = get(reader, field, type, comparator, true);
+    _CL_LDECREF(ret); //the cache keeps it until the reader is closed
+    return ret;
+  }
+
+  FieldCacheAuto* FieldCacheImpl::get (IndexReader* reader, const wchar_t* fieldname, int32_t type, SortComparator* comparator, bool retain){
+    const wchar_t* field = CLStringIntern::intern(fieldname);
+    FileEntry* entry = (type == SortField::CUSTOM)
+      ? _CLNEW FileEntry (field, comparator)
+      : _CLNEW FileEntry (field, type);
+    FieldCacheAuto* ret = NULL;
+    try{
+      ret = lookup(reader, entry, retain);
+      if ( ret == NULL ){
+        FieldCacheAuto* value;
+        if ( type == SortField::INT )
+          value = readInts(reader, field);
+        else if ( type == SortField::FLOAT )
+          value = readFloats(reader, field);
+        else if ( type == SortField::STRING )
+          value = readStrings(reader, field);
+        else if ( type == STRING_INDEX )
+          value = readStringIndex(reader, field);
+        else if ( type == SortField::AUTO )
+          value = readAuto(reader, field);
+        else if ( type == SortField::CUSTOM )
+          value = readCustom(reader, field, comparator);
+        else
+          _CLTHROWA(CL_ERR_IllegalArgument, "unknown field cache type");
+
+        ret = store(reader, entry, value, retain);
+        entry = NULL; //owned by the cache now
+        evict();
       }
-      readerCache->put(entry, value);
-	  //this is supposed to return the previous value, but it needs to be deleted!!!
-	}
+    }_CLFINALLY(
+      _CLDELETE(entry);
+      CLStringIntern::unintern(field);
+    )
+    return ret;
+  }
+
+  // inherit javadocs
+  FieldCacheAuto* FieldCacheImpl::getInts (IndexReader* reader, const wchar_t* field) {
+    return getRetained(reader, field, SortField::INT);
+  }
+
+  // inherit javadocs
+  FieldCacheAuto* FieldCacheImpl::getFloats (IndexReader* reader, const wchar_t* field) {
+    return getRetained(reader, field, SortField::FLOAT);
   }
 
+  // inherit javadocs
+  FieldCacheAuto* FieldCacheImpl::getStrings (IndexReader* reader, const wchar_t* field) {
+    return getRetained(reader, field, SortField::STRING);
+  }
 
+  // inherit javadocs
+  FieldCacheAuto* FieldCacheImpl::getStringIndex (IndexReader* reader, const wchar_t* field) {
+    return getRetained(reader, field, STRING_INDEX);
+  }
 
+  // inherit javadocs
+  FieldCacheAuto* FieldCacheImpl::getAuto (IndexReader* reader, const wchar_t* field) {
+    return getRetained(reader, field, SortField::AUTO);
+  }
 
+  // inherit javadocs
+  FieldCacheAuto* FieldCacheImpl::getCustom (IndexReader* reader, const wchar_t* field, SortComparator* comparator) {
+    return getRetained(reader, field, SortField::CUSTOM, comparator);
+  }
 
- // inherit javadocs
- FieldCacheAuto* FieldCacheImpl::getInts (IndexReader* reader, const wchar_t* field) {
-    field = CLStringIntern::intern(field);
-    FieldCacheAuto* ret = lookup (reader, field, SortField::INT);
-    if (ret == NULL) {
+ /** Reads the terms of field as integers */
+ FieldCacheAuto* FieldCacheImpl::readInts (IndexReader* reader, const wchar_t* field) {
       int32_t retLen = reader->maxDoc();
       int32_t* retArray = _CL_NEWARRAY(int32_t,retLen);
 	    memset(retArray,0,sizeof(int32_t)*retLen);
@@ -273,19 +672,12 @@ FieldCacheImpl::FileEntry::FileEntry (const wchar_t* field, int32_t type) {
       FieldCacheAuto* fa = _CLNEW FieldCacheAuto(retLen,FieldCacheAuto::INT_ARRAY);
       fa->intArray = retArray;
 
-      store (reader, field, SortField::INT, fa);
-	    CLStringIntern::unintern(field);
       return fa;
-    }
-	  CLStringIntern::unintern(field);
-    return ret;
   }
 
-  // inherit javadocs
-  FieldCacheAuto* FieldCacheImpl::getFloats (IndexReader* reader, const wchar_t* field){
-	field = CLStringIntern::intern(field);
-    FieldCacheAuto* ret = lookup (reader, field, SortField::FLOAT);
-    if (ret == NULL) {
+
+  /** Reads the terms of field as floats */
+  FieldCacheAuto* FieldCacheImpl::readFloats (IndexReader* reader, const wchar_t* field){
 	  int32_t retLen = reader->maxDoc();
       float_t* retArray = _CL_NEWARRAY(float_t,retLen);
 	  memset(retArray,0,sizeof(float_t)*retLen);
@@ -322,21 +714,14 @@ FieldCacheImpl::FileEntry::FileEntry (const wchar_t* field, int32_t type) {
 	  FieldCacheAuto* fa = _CLNEW FieldCacheAuto(retLen,FieldCacheAuto::FLOAT_ARRAY);
 	  fa->floatArray = retArray;
 
-      store (reader, field, SortField::FLOAT, fa);
-	  CLStringIntern::unintern(field);
       return fa;
-    }
-	CLStringIntern::unintern(field);
-    return ret;
   }
 
 
-  // inherit javadocs
-  FieldCacheAuto* FieldCacheImpl::getStrings (IndexReader* reader, const wchar_t* field){
+
+  /** Reads the term of each document in field */
+  FieldCacheAuto* FieldCacheImpl::readStrings (IndexReader* reader, const wchar_t* field){
    //todo: this is not really used, i think?
-	field = CLStringIntern::intern(field);
-    FieldCacheAuto* ret = lookup (reader, field, SortField::STRING);
-    if (ret == NULL) {
 	  int32_t retLen = reader->maxDoc();
       wchar_t** retArray = _CL_NEWARRAY(wchar_t*,retLen+1);
       memset(retArray,0,sizeof(wchar_t*)*(retLen+1));
@@ -372,26 +757,26 @@ FieldCacheImpl::FileEntry::FileEntry (const wchar_t* field, int32_t type) {
 	    FieldCacheAuto* fa = _CLNEW FieldCacheAuto(retLen,FieldCacheAuto::STRING_ARRAY);
 	    fa->stringArray = retArray;
 	    fa->ownContents=true;
-      store (reader, field, SortField::STRING, fa);
-	    CLStringIntern::unintern(field);
       return fa;
-    }
-	  CLStringIntern::unintern(field);
-    return ret;
   }
 
-  // inherit javadocs
-  FieldCacheAuto* FieldCacheImpl::getStringIndex (IndexReader* reader, const wchar_t* field){
-	  field = CLStringIntern::intern(field);
-    FieldCacheAuto* ret = lookup (reader, field, STRING_INDEX);
-    int32_t t = 0;  // current term number
-    if (ret == NULL) {
-	    int32_t retLen = reader->maxDoc();
-      int32_t* retArray = _CL_NEWARRAY(int32_t,retLen);
-	    memset(retArray,0,sizeof(int32_t)*retLen);
 
-      wchar_t** mterms = _CL_NEWARRAY(wchar_t*,retLen+2);
-      mterms[0]=NULL;
+  /** Reads the terms of field and the index of each document's term */
+  FieldCacheAuto* FieldCacheImpl::readStringIndex (IndexReader* reader, const wchar_t* field){
+      int32_t retLen = reader->maxDoc();
+      //ordinals are collected at full width, and packed once the number of terms is known
+      int32_t* ords = _CL_NEWARRAY(int32_t,retLen);
+      memset(ords,0,sizeof(int32_t)*retLen);
+
+      // an entry for documents that have no terms in this field
+      // should a document with no terms be at top or bottom?
+      // this puts them at the top - if it is changed, FieldDocSortedHitQueue
+      // needs to change as well.
+      std::string terms;
+      std::vector<int64_t> offsets;
+      offsets.push_back(0);
+      int32_t t = 1;  // current term number
+
       if ( retLen > 0 ) {
         TermDocs* termDocs = reader->termDocs();
 
@@ -399,81 +784,70 @@ FieldCacheImpl::FileEntry::FileEntry (const wchar_t* field, int32_t type) {
         TermEnum* termEnum = reader->terms (term);
 		    _CLDECDELETE(term);
 
-
-		    CND_PRECONDITION(t+1 <= retLen, L"t out of bounds");
-
-        // an entry for documents that have no terms in this field
-        // should a document with no terms be at top or bottom?
-        // this puts them at the top - if it is changed, FieldDocSortedHitQueue
-        // needs to change as well.
-        mterms[t++] = NULL;
-
         try {
-          if (termEnum->term(false) == NULL) {
-            _CLTHROWA(CL_ERR_Runtime,L"no terms in field"); //todo: make rich message " + field);
-          }
-          do {
-            Term* term = termEnum->term(false);
-            if (term->field() != field)
-			        break;
+          try {
+            if (termEnum->term(false) == NULL) {
+              _CLTHROWA(CL_ERR_Runtime,L"no terms in field"); //todo: make rich message " + field);
+            }
+            char utf8[6];
+            do {
+              Term* term = termEnum->term(false);
+              if (term->field() != field)
+                break;
+
+              // store term text
+              // we expect that there is at most one term per document
+              if (t >= retLen+1)
+                _CLTHROWA(CL_ERR_Runtime,"there are more terms than documents in field"); //todo: rich error \"" + field + "\"");
+              offsets.push_back(terms.length());
+              for ( const wchar_t* c = term->text(); *c != 0; c++ )
+                terms.append(utf8, lucene_wctoutf8(utf8, *c));
+
+              termDocs->seek (termEnum);
+              while (termDocs->next()) {
+                ords[termDocs->doc()] = t;
+              }
+
+              t++;
+            } while (termEnum->next());
+          } _CLFINALLY(
+            termDocs->close();
+            _CLDELETE(termDocs);
+            termEnum->close();
+            _CLDELETE(termEnum);
+          );
+        } catch (CLuceneError&) {
+          _CLDELETE_ARRAY(ords);
+          throw;
+        }
+      }
+      // where the last term ends
+      offsets.push_back(terms.length());
 
-            // store term text
-            // we expect that there is at most one term per document
-            if (t >= retLen+1)
-			        _CLTHROWA(CL_ERR_Runtime,"there are more terms than documents in field"); //todo: rich error \"" + field + "\"");
-            mterms[t] = _wcsdup(term->text());
+      PackedInts* order = _CLNEW PackedInts(retLen, PackedInts::bitsRequired(t - 1));
+      for ( int32_t i=0;i<retLen;i++ )
+        order->set(i, ords[i]);
+      _CLDELETE_ARRAY(ords);
 
-            termDocs->seek (termEnum);
-            while (termDocs->next()) {
-              retArray[termDocs->doc()] = t;
-            }
+      PackedInts* termOffsets = _CLNEW PackedInts((int32_t)offsets.size(), PackedInts::bitsRequired((int64_t)terms.length()));
+      for ( size_t i=0;i<offsets.size();i++ )
+        termOffsets->set((int32_t)i, offsets[i]);
 
-            t++;
-          } while (termEnum->next());
-		      CND_PRECONDITION(t<retLen+2,L"t out of bounds");
-		      mterms[t] = NULL;
-        } _CLFINALLY(
-          termDocs->close();
-          _CLDELETE(termDocs);
-          termEnum->close();
-          _CLDELETE(termEnum);
-        );
+      char* termBlock = _CL_NEWARRAY(char, terms.length() + 1);
+      memcpy(termBlock, terms.c_str(), terms.length() + 1);
 
-        if (t == 0) {
-          // if there are no terms, make the term array
-          // have a single NULL entry
-          _CLDELETE_ARRAY(mterms);
-          mterms = _CL_NEWARRAY(wchar_t*,1); //todo: delete old mterms?
-          mterms[0]=NULL;
-          } else if (t < retLen) { //todo: check, was mterms.length
-          // if there are less terms than documents,
-          // trim off the dead array space
-          //const wchar_t** terms = _CL_NEWARRAY(wchar_t,t);
-          //System.arraycopy (mterms, 0, terms, 0, t);
-          //mterms = terms;
-
-          //we simply shorten the length of the array...
-        
-        }
-      }
-      FieldCache::StringIndex* value = _CLNEW FieldCache::StringIndex (retArray, mterms,t);
+      FieldCache::StringIndex* value = _CLNEW FieldCache::StringIndex (order, termBlock, termOffsets, t);
   	  
 	    FieldCacheAuto* fa = _CLNEW FieldCacheAuto(retLen,FieldCacheAuto::STRING_INDEX);
 	    fa->stringIndex = value;
 	    fa->ownContents=true;
-      store (reader, field, STRING_INDEX, fa);
-      CLStringIntern::unintern(field);
       return fa;
-    }
-    CLStringIntern::unintern(field);
-    return ret;
   }
 
-  // inherit javadocs
-  FieldCacheAuto* FieldCacheImpl::getAuto (IndexReader* reader, const wchar_t* field) {
-	  field = CLStringIntern::intern(field);
-    FieldCacheAuto* ret = lookup (reader, field, SortField::AUTO);
-    if (ret == NULL) {
+
+  /** Reads field as integers, floats or a StringIndex, depending on what its first term looks like */
+  FieldCacheAuto* FieldCacheImpl::readAuto (IndexReader* reader, const wchar_t* field) {
+      FieldCacheAuto* ret = NULL;
 	    Term* term = _CLNEW Term (field, LUCENE_BLANK_STRING, false);
       TermEnum* enumerator = reader->terms (term);
 	    _CLDECDELETE(term);
@@ -495,7 +869,7 @@ FieldCacheImpl::FileEntry::FileEntry (const wchar_t* field, int32_t type) {
 			      }
 		      }
 		      if ( isint )
-			      ret = getInts (reader, field);
+			      ret = getPinned (reader, field, SortField::INT);
 		      else{
 			      bool isfloat=true;
 
@@ -509,32 +883,25 @@ FieldCacheImpl::FileEntry::FileEntry (const wchar_t* field, int32_t type) {
 				      }
 			      }
 			      if ( isfloat )
-				      ret = getFloats (reader, field);
+				      ret = getPinned (reader, field, SortField::FLOAT);
 			      else{
-				      ret = getStringIndex (reader, field);
+				      ret = getPinned (reader, field, STRING_INDEX);
 			      }
 		      }
-
-          if (ret != NULL) {
-			      store (reader, field, SortField::AUTO, ret);
-          }
         } else {
           _CLTHROWA (CL_ERR_Runtime,"field does not appear to be indexed"); //todo: make rich error: \"" + field + "\"
         }
       } _CLFINALLY( enumerator->close(); _CLDELETE(enumerator) );
 
-    }
-	  CLStringIntern::unintern(field);
-    return ret;
+      //the AUTO entry shares the value of the typed one
+      return ret;
   }
 
 
-  // inherit javadocs
-  FieldCacheAuto* FieldCacheImpl::getCustom (IndexReader* reader, const wchar_t* field, SortComparator* comparator){
-	  field = CLStringIntern::intern(field);
 
-    FieldCacheAuto* ret = lookup (reader, field, comparator);
-    if (ret == NULL) {
+  /** Reads the terms of field through comparator */
+  FieldCacheAuto* FieldCacheImpl::readCustom (IndexReader* reader, const wchar_t* field, SortComparator* comparator){
+
 	    int32_t retLen = reader->maxDoc();
       Comparable** retArray = _CL_NEWARRAY(Comparable*,retLen);
 	    memset(retArray,0,sizeof(Comparable*)*retLen);
@@ -567,13 +934,9 @@ FieldCacheImpl::FileEntry::FileEntry (const wchar_t* field, int32_t type) {
       FieldCacheAuto* fa = _CLNEW FieldCacheAuto(retLen,FieldCacheAuto::COMPARABLE_ARRAY);
       fa->comparableArray = retArray;
       fa->ownContents=true;
-      store (reader, field, SortField::CUSTOM, fa);
-      CLStringIntern::unintern(field);
       return fa;
-    }
-	  CLStringIntern::unintern(field);
-    return ret;
   }
 
 
+
 CL_NS_END
@@ -50,6 +50,7 @@ bool FieldDocSortedHitQueue::lessThan (FieldDoc* docA, FieldDoc* docB) {
 	int32_t c = 0;
 	float_t f1,f2,r1,r2;
 	int32_t i1,i2;
+	int64_t l1,l2;
 	const wchar_t *s1, *s2;
 
 	for (int32_t i=0; i<n && c==0; ++i) {
@@ -69,6 +70,12 @@ bool FieldDocSortedHitQueue::lessThan (FieldDoc* docA, FieldDoc* docB) {
 					if (i1 > i2) c = -1;
 					if (i1 < i2) c = 1;
 					break;
+				case SortField::LONG:
+					l1 = reinterpret_cast<Compare::Int64*>(docA->fields[i])->getValue();
+					l2 = reinterpret_cast<Compare::Int64*>(docB->fields[i])->getValue();
+					if (l1 > l2) c = -1;
+					if (l1 < l2) c = 1;
+					break;
 				case SortField::STRING:
 					s1 = reinterpret_cast<Compare::WChar*>(docA->fields[i])->getValue();
 					s2 = reinterpret_cast<Compare::WChar*>(docB->fields[i])->getValue();
@@ -114,6 +121,12 @@ bool FieldDocSortedHitQueue::lessThan (FieldDoc* docA, FieldDoc* docB) {
 					if (i1 < i2) c = -1;
 					if (i1 > i2) c = 1;
 					break;
+				case SortField::LONG:
+					l1 = reinterpret_cast<Compare::Int64*>(docA->fields[i])->getValue();
+					l2 = reinterpret_cast<Compare::Int64*>(docB->fields[i])->getValue();
+					if (l1 < l2) c = -1;
+					if (l1 > l2) c = 1;
+					break;
 				case SortField::STRING:
 					s1 = reinterpret_cast<Compare::WChar*>(docA->fields[i])->getValue();
 					s2 = reinterpret_cast<Compare::WChar*>(docB->fields[i])->getValue();
@@ -12,6 +12,7 @@
 #include "_FieldCacheImpl.h"
 #include "Compare.h"
 #include "CLucene/index/IndexReader.h"
+#include "CLucene/index/DocValues.h"
 
 CL_NS_USE(util)
 CL_NS_USE(index)
@@ -55,6 +56,23 @@ public:
     }
 };
 
+/** A comparator over a pinned FieldCache entry, which it releases when
+* it is deleted, so that the entry is not evicted while a search uses it.
+*/
+template<typename Comparator, typename Values>
+class FieldCacheComparator: public Comparator{
+	FieldCacheAuto* entry;
+public:
+	FieldCacheComparator(FieldCacheAuto* _entry, Values values):
+		Comparator(values, _entry->contentLen),
+		entry(_entry)
+	{
+	}
+	~FieldCacheComparator(){
+		_CLDECDELETE(entry);
+	}
+};
+
 hitqueueCacheType* FieldSortedHitQueue::Comparators = _CLNEW hitqueueCacheType(false,true);
 DEFINE_MUTEX(FieldSortedHitQueue::Comparators_LOCK)
 
@@ -71,15 +89,24 @@ FieldSortedHitQueue::FieldSortedHitQueue (IndexReader* reader, SortField** _fiel
 		fieldsLen++;
 
 	comparators = _CL_NEWARRAY(ScoreDocComparator*,fieldsLen+1);
+	comparatorsOwned = _CL_NEWARRAY(bool,fieldsLen+1);
 	SortField** tmp = _CL_NEWARRAY(SortField*,fieldsLen+1);
 	for (int32_t i=0; i<fieldsLen; ++i) {
 		const wchar_t* fieldname = _fields[i]->getField();
+		const int32_t type = _fields[i]->getType();
 		//todo: fields[i].getLocale(), not implemented
-		comparators[i] = getCachedComparator (reader, fieldname, _fields[i]->getType(), _fields[i]->getFactory());
+		//comparators over the field cache are made for each queue, so the
+		//cache entries they pin are released once the search is done
+		comparatorsOwned[i] = type != SortField::DOC && type != SortField::DOCSCORE && type != SortField::CUSTOM;
+		if ( comparatorsOwned[i] )
+			comparators[i] = newComparator (reader, fieldname, type);
+		else
+			comparators[i] = getCachedComparator (reader, fieldname, type, _fields[i]->getFactory());
 		tmp[i] = _CLNEW SortField (fieldname, comparators[i]->sortType(), _fields[i]->getReverse());
 	}
 	comparatorsLen = fieldsLen;
 	comparators[fieldsLen]=NULL;
+	comparatorsOwned[fieldsLen]=false;
 	tmp[fieldsLen] = NULL;
 	this->fields = tmp;
 
@@ -107,53 +134,87 @@ bool FieldSortedHitQueue::lessThan (FieldDoc* docA, FieldDoc* docB) {
 
 //static
 ScoreDocComparator* FieldSortedHitQueue::comparatorString (IndexReader* reader, const wchar_t* field) {
-	//const wchar_t* field = CLStringIntern::intern(fieldname);
-	FieldCacheAuto* fa = FieldCache::DEFAULT()->getStringIndex (reader, field);
-	//CLStringIntern::unintern(field);
-
+	FieldCacheAuto* fa = FieldCache::DEFAULT()->getPinned (reader, field, FieldCache::STRING_INDEX);
 	CND_PRECONDITION(fa->contentType==FieldCacheAuto::STRING_INDEX,L"Content type is incorrect");
-	fa->ownContents = false;
-    return _CLNEW ScoreDocComparators::String(fa->stringIndex, fa->contentLen);
+	return _CLNEW FieldCacheComparator<ScoreDocComparators::String, FieldCache::StringIndex*>(fa, fa->stringIndex);
 }
 
 //static 
 ScoreDocComparator* FieldSortedHitQueue::comparatorInt (IndexReader* reader, const wchar_t* field){
-    //const wchar_t* field = CLStringIntern::intern(fieldname);
-    FieldCacheAuto* fa =  FieldCache::DEFAULT()->getInts (reader, field);
-	//CLStringIntern::unintern(field);
-
+	FieldCacheAuto* fa = FieldCache::DEFAULT()->getPinned (reader, field, SortField::INT);
 	CND_PRECONDITION(fa->contentType==FieldCacheAuto::INT_ARRAY,L"Content type is incorrect");
-    return _CLNEW ScoreDocComparators::Int32(fa->intArray, fa->contentLen);
+	return _CLNEW FieldCacheComparator<ScoreDocComparators::Int32, int32_t*>(fa, fa->intArray);
   }
 
 //static
  ScoreDocComparator* FieldSortedHitQueue::comparatorFloat (IndexReader* reader, const wchar_t* field) {
-	//const wchar_t* field = CLStringIntern::intern(fieldname);
-    FieldCacheAuto* fa = FieldCache::DEFAULT()->getFloats (reader, field);
-	//CLStringIntern::unintern(field);
-
+	FieldCacheAuto* fa = FieldCache::DEFAULT()->getPinned (reader, field, SortField::FLOAT);
 	CND_PRECONDITION(fa->contentType==FieldCacheAuto::FLOAT_ARRAY,L"Content type is incorrect");
-	return _CLNEW ScoreDocComparators::Float (fa->floatArray, fa->contentLen);
+	return _CLNEW FieldCacheComparator<ScoreDocComparators::Float, float_t*>(fa, fa->floatArray);
   }
 //static
   ScoreDocComparator* FieldSortedHitQueue::comparatorAuto (IndexReader* reader, const wchar_t* field){
-	//const wchar_t* field = CLStringIntern::intern(fieldname);
-    FieldCacheAuto* fa =  FieldCache::DEFAULT()->getAuto (reader, field);
-	//CLStringIntern::unintern(field);
+    FieldCacheAuto* fa = FieldCache::DEFAULT()->getPinned (reader, field, SortField::AUTO);
+    const int32_t contentType = fa->contentType;
+    _CLDECDELETE(fa);
 
-    if (fa->contentType == FieldCacheAuto::STRING_INDEX ) {
+    if (contentType == FieldCacheAuto::STRING_INDEX ) {
       return comparatorString (reader, field);
-    } else if (fa->contentType == FieldCacheAuto::INT_ARRAY) {
+    } else if (contentType == FieldCacheAuto::INT_ARRAY) {
       return comparatorInt (reader, field);
-    } else if (fa->contentType == FieldCacheAuto::FLOAT_ARRAY) {
+    } else if (contentType == FieldCacheAuto::FLOAT_ARRAY) {
       return comparatorFloat (reader, field);
-    } else if (fa->contentType == FieldCacheAuto::STRING_ARRAY) {
+    } else if (contentType == FieldCacheAuto::STRING_ARRAY) {
       return comparatorString (reader, field);
     } else {
       _CLTHROWA(CL_ERR_Runtime, "unknown data type in field"); //todo: rich error information: '"+field+"'");
     }
   }
 
+  /** A comparator over the doc values of the field, if it has the kind the
+  * sort type can use, else NULL. Doc values are read from the index and
+  * belong to the reader, so nothing is put into the field cache.
+  */
+  static ScoreDocComparator* comparatorDocValues (IndexReader* reader, const wchar_t* fieldname, int32_t type){
+    if (type == SortField::AUTO || type == SortField::INT || type == SortField::LONG) {
+      NumericDocValues* values = reader->getNumericDocValues(fieldname);
+      if (values != NULL)
+        return _CLNEW ScoreDocComparators::Numeric(values);
+    }
+    if (type == SortField::AUTO || type == SortField::STRING) {
+      SortedDocValues* values = reader->getSortedDocValues(fieldname);
+      if (values != NULL)
+        return _CLNEW ScoreDocComparators::Sorted(values);
+    }
+    return NULL;
+  }
+
+  //static
+  ScoreDocComparator* FieldSortedHitQueue::newComparator (IndexReader* reader, const wchar_t* fieldname, int32_t type){
+    ScoreDocComparator* docValues = comparatorDocValues (reader, fieldname, type);
+    if (docValues != NULL)
+      return docValues;
+
+    switch (type) {
+      case SortField::AUTO:
+        return comparatorAuto (reader, fieldname);
+      case SortField::INT:
+        return comparatorInt (reader, fieldname);
+      case SortField::LONG:
+        _CLTHROWA(CL_ERR_Runtime,"LONG sorts need numeric doc values");
+      case SortField::FLOAT:
+        return comparatorFloat (reader, fieldname);
+      case SortField::STRING:
+        //if (locale != NULL) 
+        //  return comparatorStringLocale (reader, fieldname, locale);
+        return comparatorString (reader, fieldname);
+      default:
+        _CLTHROWA(CL_ERR_Runtime,"unknown field type");
+        //todo: extend error
+        //throw _CLNEW RuntimeException ("unknown field type: "+type);
+    }
+  }
+
 
   //todo: Locale locale, not implemented yet
   ScoreDocComparator* FieldSortedHitQueue::getCachedComparator (IndexReader* reader, const wchar_t* fieldname, int32_t type, SortComparatorSource* factory){ 
@@ -163,30 +224,10 @@ ScoreDocComparator* FieldSortedHitQueue::comparatorInt (IndexReader* reader, con
 		return ScoreDocComparator::RELEVANCE();
     ScoreDocComparator* comparator = lookup (reader, fieldname, type, factory);
     if (comparator == NULL) {
-      switch (type) {
-		case SortField::AUTO:
-          comparator = comparatorAuto (reader, fieldname);
-          break;
-		case SortField::INT:
-          comparator = comparatorInt (reader, fieldname);
-          break;
-		case SortField::FLOAT:
-          comparator = comparatorFloat (reader, fieldname);
-          break;
-		case SortField::STRING:
-          //if (locale != NULL) 
-		//	  comparator = comparatorStringLocale (reader, fieldname, locale);
-          //else 
-			  comparator = comparatorString (reader, fieldname);
-          break;
-		case SortField::CUSTOM:
-          comparator = factory->newComparator (reader, fieldname);
-          break;
-        default:
-          _CLTHROWA(CL_ERR_Runtime,"unknown field type");
-		  //todo: extend error
-			//throw _CLNEW RuntimeException ("unknown field type: "+type);
-      }
+      if (type == SortField::CUSTOM)
+        comparator = factory->newComparator (reader, fieldname);
+      else
+        comparator = newComparator (reader, fieldname, type);
       store (reader, fieldname, type, factory, comparator);
     }
 	return comparator;
@@ -250,6 +291,11 @@ ScoreDocComparator* FieldSortedHitQueue::comparatorInt (IndexReader* reader, con
   }
 
 FieldSortedHitQueue::~FieldSortedHitQueue(){
+	for ( int32_t i=0;i<comparatorsLen;i++ ){
+		if ( comparatorsOwned[i] )
+			_CLDELETE(comparators[i]);
+	}
+	_CLDELETE_ARRAY(comparatorsOwned);
 	_CLDELETE_ARRAY(comparators);
     if ( fields != NULL ){
        for ( int i=0;fields[i]!=NULL;i++ )
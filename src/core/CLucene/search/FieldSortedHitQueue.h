@@ -60,6 +60,14 @@ private:
   //todo: Locale locale, not implemented yet
   static ScoreDocComparator* getCachedComparator (CL_NS(index)::IndexReader* reader, 
   	const wchar_t* fieldname, int32_t type, SortComparatorSource* factory);
+
+  /** Returns a new comparator for one of the built-in types. Fields with
+  * doc values of a kind the type can use are sorted by those (LONG needs
+  * them), others over the field cache, keeping the cache entry it uses
+  * pinned until the comparator is deleted.
+  */
+  static ScoreDocComparator* newComparator (CL_NS(index)::IndexReader* reader,
+  	const wchar_t* fieldname, int32_t type);
   	
   	
   /**
@@ -135,6 +143,9 @@ protected:
   /** Stores a comparator corresponding to each field being sorted by */
   ScoreDocComparator** comparators;
   int32_t comparatorsLen;
+
+  /** Whether each comparator was made for this queue, and must be deleted with it */
+  bool* comparatorsOwned;
   
   /** Stores the sort criteria being used. */
   SortField** fields;
@@ -191,6 +202,17 @@ public:
 	SortField** getFields() {
 	return fields;
 	}
+
+	/** Returns the largest score seen so far, which fillFields() normalizes by if above 1. */
+	float_t getMaxScore() const{
+		return maxscore;
+	}
+
+	/** Raises the largest score seen to <code>score</code>, for merging the
+	* hits of other queues that saw scores this one did not. */
+	void updateMaxScore(const float_t score){
+		if (score > maxscore) maxscore = score;
+	}
 };
 
 
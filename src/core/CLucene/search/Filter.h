@@ -41,6 +41,19 @@ public:
 
     //Creates a user-readable version of this query and returns it as as string
     virtual std::wstring toString() = 0;
+
+    /**
+    * Returns true if other lets the same documents through as this filter.
+    * ConstantScoreQuery, and so the QueryCache of an IndexSearcher, compare
+    * filters with this. The default only finds a filter equal to itself.
+    */
+    virtual bool equals(Filter* other) const { return this == other; }
+
+    /** Returns a hash code which is the same for filters that are equal */
+    virtual size_t hashCode() const { return (size_t)this; }
+
+    /** Returns the name of the class of this filter, which equals() compares */
+    virtual const char* getObjectName() const { return "Filter"; }
 };
 CL_NS_END
 #endif
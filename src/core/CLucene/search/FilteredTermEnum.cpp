@@ -53,7 +53,10 @@ FilteredTermEnum::FilteredTermEnum():currentTerm(NULL),actualEnum(NULL){
         while (currentTerm == NULL) {
             if (endEnum()) 
 				return false;
-            if (actualEnum->next()) {
+            Term* seekTerm = nextSeekTerm(actualEnum->term(false));
+            if (endEnum())
+				return false;
+            if (seekTerm != NULL ? actualEnum->skipTo(seekTerm) : actualEnum->next()) {
                 //Order term not to return reference ownership here. */
                 Term* term = actualEnum->term(false);
 				//Compare the retrieved term
@@ -73,6 +76,10 @@ FilteredTermEnum::FilteredTermEnum():currentTerm(NULL),actualEnum(NULL){
         return false;
     }
 
+    Term* FilteredTermEnum::nextSeekTerm(Term* /*current*/) {
+        return NULL;
+    }
+
     Term* FilteredTermEnum::term(bool pointer) {
     	if ( pointer )
         return _CL_POINTER(currentTerm);
@@ -49,6 +49,15 @@ protected:
 	/** Indicates the end of the enumeration has been reached */
 	virtual bool endEnum() = 0;
 
+	/**
+	* Returns the term to skip to (see TermEnum::skipTo) rather than moving
+	* on to the term after current, or NULL to move on. Lets an enumeration
+	* jump over terms which cannot match. endEnum() is checked after this
+	* is called. The returned term stays owned by the enumeration. The
+	* default returns NULL.
+	*/
+	virtual CL_NS(index)::Term* nextSeekTerm(CL_NS(index)::Term* current);
+
 	void setEnum(CL_NS(index)::TermEnum* actualEnum) ;
 
 private:
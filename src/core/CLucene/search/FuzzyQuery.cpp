@@ -17,6 +17,7 @@
 
 #include "CLucene/util/StringBuffer.h"
 #include "CLucene/util/PriorityQueue.h"
+#include "CLucene/util/_Automaton.h"
 
 CL_NS_USE(index)
 CL_NS_USE(util)
@@ -29,8 +30,8 @@ CL_NS_DEF(search)
 #define min3(a, b, c) __t = (a < b) ? a : b; __t = (__t < c) ? __t : c;
 
 
-    FuzzyTermEnum::FuzzyTermEnum(IndexReader* reader, Term* term, float_t minSimilarity, size_t _prefixLength) :
-    FilteredTermEnum(), d(NULL), dLen(0), _similarity(0), _endEnum(false), searchTerm(_CL_POINTER(term)),
+    FuzzyTermEnum::FuzzyTermEnum(IndexReader* reader, Term* term, float_t minSimilarity, size_t _prefixLength, bool _transpositions) :
+    AutomatonTermEnum(), d(NULL), dLen(0), _similarity(0), transpositions(_transpositions), searchTerm(_CL_POINTER(term)),
     text(NULL), textLen(0), prefix(NULL)/* ISH: was STRDUP_TtoT(LUCENE_BLANK_STRING)*/, prefixLength(0),
     minimumSimilarity(minSimilarity)
 {
@@ -59,9 +60,22 @@ CL_NS_DEF(search)
 
     initializeMaxDistances();
 
-    Term* trm = _CLNEW Term(searchTerm->field(), prefix); // _CLNEW Term(term, prefix); -- not intern'd?
-    setEnum(reader->terms(trm));
-    _CLLDECDELETE(trm);
+    //No term is similar enough if it is further than this from the text
+    Automaton* automaton = LevenshteinAutomata::build(prefix, prefixLength, text, textLen,
+        calculateMaxDistance(textLen), transpositions, MAX_AUTOMATON_STATES);
+    if (automaton == NULL)
+    {
+        //the terms which start with the prefix
+        automaton = _CLNEW Automaton();
+        for (size_t i = 0; i <= prefixLength; i++)
+            automaton->createState();
+        for (size_t i = 0; i < prefixLength; i++)
+            automaton->addTransition(i, prefix[i], prefix[i], i + 1);
+        automaton->addTransition(prefixLength, Automaton::MIN_CHAR, Automaton::MAX_CHAR, prefixLength);
+        automaton->setAccept(prefixLength, true);
+        automaton->finish();
+    }
+    setAutomaton(reader, searchTerm, automaton);
 
 
     /* LEGACY:
@@ -91,15 +105,10 @@ FuzzyTermEnum::~FuzzyTermEnum()
 const std::wstring FuzzyTermEnum::getObjectName() const { return getClassName(); }
 const std::wstring FuzzyTermEnum::getClassName() { return L"FuzzyTermEnum"; }
 
-bool FuzzyTermEnum::endEnum()
-{
-    return _endEnum;
-}
-
 void FuzzyTermEnum::close()
 {
 
-    FilteredTermEnum::close();
+    AutomatonTermEnum::close();
 
     //Finalize the searchTerm
     _CLDECDELETE(searchTerm);
@@ -112,35 +121,18 @@ void FuzzyTermEnum::close()
     _CLDELETE_CARRAY(prefix);
 }
 
-bool FuzzyTermEnum::termCompare(Term* term)
+bool FuzzyTermEnum::acceptTerm(Term* term)
 {
     //Func - Compares term with the searchTerm using the Levenshtein distance.
-    //Pre  - term is NULL or term points to a Term
-    //Post - if pre(term) is NULL then false is returned otherwise
-    //       if the distance of the current term in the enumeration is bigger than the FUZZY_THRESHOLD
+    //Pre  - term points to a Term of the field of searchTerm, which starts with
+    //       the prefix, as the automaton accepted it
+    //Post - if the distance of the current term in the enumeration is bigger than the FUZZY_THRESHOLD
     //       then true is returned
 
-    if (term == NULL)
-    {
-        return false;  //Note that endEnum is not set to true!
-    }
-
-    const wchar_t* termText = term->text();
-    const size_t termTextLen = term->textLength();
-
-    //Check if the field name of searchTerm of term match
-    //(we can use == because fields are interned)
-    if (searchTerm->field() == term->field() &&
-        (prefixLength == 0 || wcsncmp(termText, prefix, prefixLength) == 0))
-    {
-
-        const wchar_t* target = termText + prefixLength;
-        const size_t targetLen = termTextLen - prefixLength;
-        _similarity = similarity(target, targetLen);
-        return (_similarity > minimumSimilarity);
-    }
-    _endEnum = true;
-    return false;
+    const wchar_t* target = term->text() + prefixLength;
+    const size_t targetLen = term->textLength() - prefixLength;
+    _similarity = similarity(target, targetLen);
+    return (_similarity > minimumSimilarity);
 }
 
 float_t FuzzyTermEnum::difference()
@@ -226,6 +218,10 @@ float_t FuzzyTermEnum::similarity(const wchar_t* target, const size_t m)
                 min3(d[i - 1 + (j*dWidth)] + 1, d[i + ((j - 1)*dWidth)] + 1, d[i - 1 + ((j - 1)*dWidth)]);
                 d[i + (j*dWidth)] = __t;
             }
+            if (transpositions && i > 1 && j > 1 && s_i == target[j - 2] && text[i - 2] == target[j - 1])
+            {
+                d[i + (j*dWidth)] = cl_min(d[i + (j*dWidth)], d[i - 2 + ((j - 2)*dWidth)] + 1);
+            }
             bestPossibleEditDistance = cl_min(bestPossibleEditDistance, d[i + (j*dWidth)]);
         }
 
@@ -305,10 +301,11 @@ protected:
 };
 
 
-FuzzyQuery::FuzzyQuery(Term* term, float_t _minimumSimilarity, size_t _prefixLength) :
+FuzzyQuery::FuzzyQuery(Term* term, float_t _minimumSimilarity, size_t _prefixLength, bool _transpositions) :
     MultiTermQuery(term),
     minimumSimilarity(_minimumSimilarity),
-    prefixLength(_prefixLength)
+    prefixLength(_prefixLength),
+    transpositions(_transpositions)
 {
     if (minimumSimilarity < 0)
         minimumSimilarity = defaultMinSimilarity;
@@ -338,6 +335,11 @@ size_t FuzzyQuery::getPrefixLength() const
     return prefixLength;
 }
 
+bool FuzzyQuery::getTranspositions() const
+{
+    return transpositions;
+}
+
 std::wstring FuzzyQuery::toString(const wchar_t* field) const
 {
     std::wstring buffer; // TODO: Have a better estimation for the initial buffer length
@@ -376,6 +378,7 @@ FuzzyQuery::FuzzyQuery(const FuzzyQuery& clone) :
 {
     this->minimumSimilarity = clone.getMinSimilarity();
     this->prefixLength = clone.getPrefixLength();
+    this->transpositions = clone.getTranspositions();
 
     //if(prefixLength < 0)
     //	_CLTHROWA(CL_ERR_IllegalArgument,"prefixLength < 0");
@@ -397,6 +400,7 @@ size_t FuzzyQuery::hashCode() const
     size_t val = Similarity::floatToByte(getBoost()) ^ getTerm()->hashCode();
     val ^= Similarity::floatToByte(this->getMinSimilarity());
     val ^= this->getPrefixLength();
+    val ^= transpositions ? 1231 : 1237;
     return val;
 }
 bool FuzzyQuery::equals(Query* other) const
@@ -409,13 +413,14 @@ bool FuzzyQuery::equals(Query* other) const
     return (this->getBoost() == fq->getBoost())
         && this->minimumSimilarity == fq->getMinSimilarity()
         && this->prefixLength == fq->getPrefixLength()
+        && this->transpositions == fq->getTranspositions()
         && getTerm()->equals(fq->getTerm());
 }
 
 FilteredTermEnum* FuzzyQuery::getEnum(IndexReader* reader)
 {
     Term* term = getTerm(false);
-    FuzzyTermEnum* ret = _CLNEW FuzzyTermEnum(reader, term, minimumSimilarity, prefixLength);
+    FuzzyTermEnum* ret = _CLNEW FuzzyTermEnum(reader, term, minimumSimilarity, prefixLength, transpositions);
     return ret;
 }
 
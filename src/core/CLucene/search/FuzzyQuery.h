@@ -9,20 +9,23 @@
 #ifndef _lucene_search_FuzzyQuery_
 #define _lucene_search_FuzzyQuery_
 
+#include "CLucene/clucene-config.h"
 #include "MultiTermQuery.h"
-#include "FilteredTermEnum.h"
+#include "AutomatonTermEnum.h"
 
 CL_CLASS_DEF(index,Term)
 
 CL_NS_DEF(search)
 
 /** Implements the fuzzy search query. The similiarity measurement
-* is based on the Levenshtein (edit distance) algorithm.
+* is based on the Levenshtein (edit distance) algorithm, optionally
+* counting the transposition of two adjacent characters as one edit.
 */
 class CLUCENE_EXPORT FuzzyQuery : public MultiTermQuery {
 private:
 	float_t minimumSimilarity;
 	size_t prefixLength;
+	bool transpositions;
 protected:
 	FuzzyQuery(const FuzzyQuery& clone);
 public:
@@ -42,10 +45,12 @@ public:
 	*  as the query term is considered similar to the query term if the edit distance
 	*  between both terms is less than <code>length(term)*0.5</code>
 	* @param prefixLength length of common (non-fuzzy) prefix
+	* @param transpositions whether swapping two adjacent characters counts
+	*  as one edit rather than two
 	* @throws IllegalArgumentException if minimumSimilarity is &gt; 1 or &lt; 0
 	* or if prefixLength &lt; 0 or &gt; <code>term.text().length()</code>.
 	*/
-	FuzzyQuery(CL_NS(index)::Term* term, float_t minimumSimilarity=-1, size_t prefixLength=0);
+	FuzzyQuery(CL_NS(index)::Term* term, float_t minimumSimilarity=-1, size_t prefixLength=0, bool transpositions=false);
 	virtual ~FuzzyQuery();
 
 	/**
@@ -61,6 +66,10 @@ public:
 	*/
 	size_t getPrefixLength() const;
 
+	/** Returns whether the transposition of two adjacent characters counts
+	* as one edit */
+	bool getTranspositions() const;
+
 	Query* rewrite(CL_NS(index)::IndexReader* reader);
 
 	std::wstring toString(const wchar_t* field) const;
@@ -82,9 +91,18 @@ protected:
 *
 * <p>Term enumerations are always ordered by Term.compareTo().  Each term in
 * the enumeration is greater than all that precede it.
+*
+* <p>The terms are found with a Levenshtein automaton of the largest edit
+* distance that any term could be similar enough with, so that the ranges
+* of terms further away are skipped rather than compared. The terms the
+* automaton accepts are then scored by similarity() as before. If that
+* automaton would be too large, all the terms with the prefix are compared.
 */
-class CLUCENE_EXPORT FuzzyTermEnum: public FilteredTermEnum {
+class CLUCENE_EXPORT FuzzyTermEnum: public AutomatonTermEnum {
 private:
+	/** The largest automaton built, in states */
+	LUCENE_STATIC_CONSTANT(int32_t, MAX_AUTOMATON_STATES = 10000);
+
 	/* Allows us save time required to create a new array
 	* everytime similarity is called.
 	*/
@@ -93,7 +111,7 @@ private:
 
 	//float_t distance;
 	float_t _similarity;
-	bool _endEnum;
+	bool transpositions;
 
 	CL_NS(index)::Term* searchTerm; 
 	//String field;
@@ -142,7 +160,8 @@ private:
 	* <p>Levenshtein distance (also known as edit distance) is a measure of similiarity
 	* between two strings where the distance is measured as the number of character
 	* deletions, insertions or substitutions required to transform one string to
-	* the other string.
+	* the other string. With transpositions, swapping two adjacent characters is
+	* one edit too (the optimal string alignment distance).
 	* @param target the target word or phrase
 	* @return the similarity,  0.0 or less indicates that it matches less than the required
 	* threshold and 1.0 indicates that the text and target are identical
@@ -164,13 +183,10 @@ private:
 
 protected:
 	/**
-	* The termCompare method in FuzzyTermEnum uses Levenshtein distance to 
+	* The acceptTerm method in FuzzyTermEnum uses Levenshtein distance to 
 	* calculate the distance between the given term and the comparing term. 
 	*/
-	bool termCompare(CL_NS(index)::Term* term) ;
-
-	/** Returns the fact if the current term in the enumeration has reached the end */
-	bool endEnum();
+	bool acceptTerm(CL_NS(index)::Term* term);
 public:
 
 	/**
@@ -185,9 +201,10 @@ public:
 	* @param term Pattern term.
 	* @param minSimilarity Minimum required similarity for terms from the reader. Default value is 0.5f.
 	* @param prefixLength Length of required common prefix. Default value is 0.
+	* @param transpositions Whether swapping two adjacent characters is one edit. Default value is false.
 	* @throws IOException
 	*/
-	FuzzyTermEnum(CL_NS(index)::IndexReader* reader, CL_NS(index)::Term* term, float_t minSimilarity=FuzzyQuery::defaultMinSimilarity, size_t prefixLength=0);
+	FuzzyTermEnum(CL_NS(index)::IndexReader* reader, CL_NS(index)::Term* term, float_t minSimilarity=FuzzyQuery::defaultMinSimilarity, size_t prefixLength=0, bool transpositions=false);
 	virtual ~FuzzyTermEnum();
 
 	/** Close the enumeration */
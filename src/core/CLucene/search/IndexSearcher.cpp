@@ -22,6 +22,9 @@
 #include "CLucene/util/BitSet.h"
 #include "FieldSortedHitQueue.h"
 #include "Explanation.h"
+#include "ConstantScoreQuery.h"
+#include "QueryCache.h"
+#include "_SearchThreadPool.h"
 
 CL_NS_USE(index)
 CL_NS_USE(util)
@@ -36,25 +39,39 @@ CL_NS_DEF(search)
 		HitQueue* hq;
 		size_t nDocs;
 		int32_t* totalHits;
+		Scorer* scorer;
+		int32_t docBase;
+		int32_t bitsBase;
 	public:
-		SimpleTopDocsCollector(const CL_NS(util)::BitSet* bs, HitQueue* hitQueue, int32_t* totalhits, size_t ndocs, const float_t ms=-1.0f):
+		// base is added to the docs, when scoring a segment of the reader of bs,
+		// unless segmentBits says that bs only holds the docs of the segment
+		SimpleTopDocsCollector(const CL_NS(util)::BitSet* bs, HitQueue* hitQueue, int32_t* totalhits, size_t ndocs, const float_t ms=-1.0f, const int32_t base=0, const bool segmentBits=false):
     		minScore(ms),
     		bits(bs),
     		hq(hitQueue),
     		nDocs(ndocs),
-    		totalHits(totalhits)
+    		totalHits(totalhits),
+    		scorer(NULL),
+    		docBase(base),
+    		bitsBase(segmentBits ? 0 : base)
     	{
+    	}
+		// passes the score to beat to s once the queue is full
+		void setScorer(Scorer* s){
+    		scorer = s;
     	}
 		~SimpleTopDocsCollector(){}
 		void collect(const int32_t doc, const float_t score){
     		if (score > 0.0f &&			  // ignore zeroed buckets
-    			(bits==NULL || bits->get(doc))) {	  // skip docs not in bits
+    			(bits==NULL || bits->get(doc + bitsBase))) {	  // skip docs not in bits
     			++totalHits[0];
     			if (hq->size() < nDocs || (minScore==-1.0f || score >= minScore)) {
-    				ScoreDoc sd = {doc, score};
+    				ScoreDoc sd = {doc + docBase, score};
     				hq->insert(sd);	  // update hit queue
     				if ( minScore != -1.0f )
     					minScore = hq->top().score; // maintain minScore
+    				if ( scorer != NULL && hq->size() >= nDocs )
+    					scorer->setMinCompetitiveScore(hq->top().score);
     			}
     		}
     	}
@@ -66,21 +83,25 @@ CL_NS_DEF(search)
 		FieldSortedHitQueue* hq;
 		size_t nDocs;
 		int32_t* totalHits;
+		int32_t docBase;
+		int32_t bitsBase;
 	public:
-		SortedTopDocsCollector(const CL_NS(util)::BitSet* bs, FieldSortedHitQueue* hitQueue, int32_t* totalhits, size_t _nDocs):
+		SortedTopDocsCollector(const CL_NS(util)::BitSet* bs, FieldSortedHitQueue* hitQueue, int32_t* totalhits, size_t _nDocs, const int32_t base=0, const bool segmentBits=false):
     		bits(bs),
     		hq(hitQueue),
     		nDocs(_nDocs),
-    		totalHits(totalhits)
+    		totalHits(totalhits),
+    		docBase(base),
+    		bitsBase(segmentBits ? 0 : base)
     	{
     	}
 		~SortedTopDocsCollector(){
 		}
 		void collect(const int32_t doc, const float_t score){
     		if (score > 0.0f &&			  // ignore zeroed buckets
-    			(bits==NULL || bits->get(doc))) {	  // skip docs not in bits
+    			(bits==NULL || bits->get(doc + bitsBase))) {	  // skip docs not in bits
     			++totalHits[0];
-    			FieldDoc* fd = _CLNEW FieldDoc(doc, score); //todo: see jlucene way... with fields def???
+    			FieldDoc* fd = _CLNEW FieldDoc(doc + docBase, score); //todo: see jlucene way... with fields def???
     			if ( !hq->insert(fd) )	  // update hit queue
     				_CLDELETE(fd);
     		}
@@ -89,24 +110,185 @@ CL_NS_DEF(search)
 
 	class SimpleFilteredCollector: public HitCollector{
 	private:
-		CL_NS(util)::BitSet* bits;
+		const CL_NS(util)::BitSet* bits;
 		HitCollector* results;
+		int32_t docBase;
 	public:
-		SimpleFilteredCollector(CL_NS(util)::BitSet* bs, HitCollector* collector):
+		// base is added to the docs, when scoring a segment with bits of its own
+		SimpleFilteredCollector(const CL_NS(util)::BitSet* bs, HitCollector* collector, const int32_t base=0):
             bits(bs),
-            results(collector)
+            results(collector),
+            docBase(base)
         {
         }
 		~SimpleFilteredCollector(){
 		}
 	protected:
 		void collect(const int32_t doc, const float_t score){
-            if (bits->get(doc)) {		  // skip docs not in bits
-                results->collect(doc, score);
+            if (bits == NULL || bits->get(doc)) {		  // skip docs not in bits
+                results->collect(doc + docBase, score);
             }
         }
 	};
 
+	/** The Filter of a search. With a QueryCache, its documents are taken
+	* from the cache for each reader scored, see IndexSearcher::setQueryCache() */
+	class SearchFilter{
+		Filter* filter;
+		QueryCache* cache;
+		Query* cacheKey;
+	public:
+		SearchFilter(Filter* _filter, QueryCache* _cache):
+			filter(_filter),
+			cache(_filter != NULL ? _cache : NULL),
+			cacheKey(NULL)
+		{
+			if ( cache != NULL ){
+				cacheKey = _CLNEW ConstantScoreQuery(filter->clone());
+				cache->onUse(cacheKey);
+			}
+		}
+		~SearchFilter(){
+			_CLDELETE(cacheKey);
+		}
+		bool isCached() const{
+			return cache != NULL;
+		}
+		/** Returns the documents of the filter in reader, NULL without a filter */
+		const BitSet* bits(IndexReader* reader){
+			if ( filter == NULL )
+				return NULL;
+			if ( cache != NULL )
+				return cache->bits(cacheKey, filter, reader);
+			return filter->bits(reader);
+		}
+		void release(const BitSet* bits){
+			if ( bits == NULL )
+				return;
+			if ( cache != NULL )
+				cache->release(bits);
+			else if ( filter->shouldDeleteBitSet(bits) )
+				_CLDELETE(bits);
+		}
+	};
+
+	/** Returns the segments of reader to score one by one, or NULL to score
+	* the whole reader. They are scored one by one to search in parallel,
+	* and with a query cache, which is keyed by segment */
+	static const ArrayBase<IndexReader*>* searchedSegments(IndexReader* reader, const bool parallel, const bool cached){
+		if ( !parallel && !cached )
+			return NULL;
+		const ArrayBase<IndexReader*>* subReaders = reader->getSubReaders();
+		if ( subReaders == NULL || subReaders->length == 0 || (subReaders->length < 2 && !cached) )
+			return NULL;
+		return subReaders;
+	}
+
+	/** Scores one segment into its own queue, see IndexSearcher::setSearchThreads() */
+	class SegmentSearchTask: public SearchThreadPool::Task{
+	protected:
+		Weight* weight;
+		IndexReader* reader;
+		int32_t base;
+		const BitSet* bits;
+		SearchFilter* segmentFilter;
+		int32_t nDocs;
+
+		/** bits are those of the segment if segmentBits, else of the whole reader */
+		virtual void score(Scorer* scorer, const BitSet* bits, const bool segmentBits) = 0;
+	public:
+		int32_t totalHits;
+
+		// the filter is applied with the bits of the whole reader, or
+		// with those segmentFilter returns for the segment
+		SegmentSearchTask(Weight* _weight, IndexReader* _reader, const int32_t _base, const BitSet* _bits, SearchFilter* _segmentFilter, const int32_t _nDocs):
+			weight(_weight),
+			reader(_reader),
+			base(_base),
+			bits(_bits),
+			segmentFilter(_segmentFilter),
+			nDocs(_nDocs),
+			totalHits(0)
+		{
+		}
+		void run(){
+			Scorer* scorer = weight->scorer(reader);
+			if ( scorer == NULL )
+				return;
+			const BitSet* segmentBits = NULL;
+			try{
+				if ( segmentFilter != NULL ){
+					segmentBits = segmentFilter->bits(reader);
+					score(scorer, segmentBits, true);
+				}else
+					score(scorer, bits, false);
+			}_CLFINALLY(
+				if ( segmentFilter != NULL )
+					segmentFilter->release(segmentBits);
+				_CLDELETE(scorer);
+			)
+		}
+	};
+
+	class SegmentTopDocsTask: public SegmentSearchTask{
+		bool skipNonCompetitive;
+	protected:
+		void score(Scorer* scorer, const BitSet* bits, const bool segmentBits){
+			SimpleTopDocsCollector hitCol(bits,&hq,&totalHits,nDocs,0.0f,base,segmentBits);
+			if ( skipNonCompetitive ){
+				scorer->setMinCompetitiveScore(0.0f);
+				hitCol.setScorer(scorer);
+			}
+			scorer->score( &hitCol );
+		}
+	public:
+		HitQueue hq;
+
+		SegmentTopDocsTask(Weight* weight, IndexReader* reader, const int32_t base, const BitSet* bits, SearchFilter* segmentFilter, const int32_t nDocs, const bool _skipNonCompetitive):
+			SegmentSearchTask(weight, reader, base, bits, segmentFilter, nDocs),
+			skipNonCompetitive(_skipNonCompetitive),
+			hq(nDocs)
+		{
+		}
+	};
+
+	class SegmentTopFieldDocsTask: public SegmentSearchTask{
+	protected:
+		void score(Scorer* scorer, const BitSet* bits, const bool segmentBits){
+			SortedTopDocsCollector hitCol(bits,hq,&totalHits,nDocs,base,segmentBits);
+			scorer->score( &hitCol );
+		}
+	public:
+		FieldSortedHitQueue* hq;
+
+		SegmentTopFieldDocsTask(Weight* weight, IndexReader* reader, const int32_t base, const BitSet* bits, SearchFilter* segmentFilter, const int32_t nDocs, FieldSortedHitQueue* _hq):
+			SegmentSearchTask(weight, reader, base, bits, segmentFilter, nDocs),
+			hq(_hq)
+		{
+		}
+		~SegmentTopFieldDocsTask(){
+			_CLDELETE(hq);
+		}
+	};
+
+	/** Runs tasks on pool, or one after the other if it is NULL, deleting
+	* all of them if one fails */
+	static void runSegmentTasks(SearchThreadPool* pool, SegmentSearchTask** tasks, const int32_t count){
+		try{
+			if ( pool != NULL )
+				pool->run((SearchThreadPool::Task**)tasks, count);
+			else{
+				for ( int32_t i=0;i<count;i++ )
+					tasks[i]->run();
+			}
+		}catch(CLuceneError&){
+			for ( int32_t i=0;i<count;i++ )
+				_CLDELETE(tasks[i]);
+			_CLDELETE_ARRAY(tasks);
+			throw;
+		}
+	}
+
 
   IndexSearcher::IndexSearcher(const wchar_t * path){
   //Func - Constructor
@@ -118,6 +300,10 @@ CL_NS_DEF(search)
 
       reader = IndexReader::open(path);
       readerOwner = true;
+      exactTotalHits = true;
+      searchThreads = 0;
+      threadPool = NULL;
+      queryCache = NULL;
   }
   
   IndexSearcher::IndexSearcher(CL_NS(store)::Directory* directory){
@@ -130,6 +316,10 @@ CL_NS_DEF(search)
 
       reader = IndexReader::open(directory);
       readerOwner = true;
+      exactTotalHits = true;
+      searchThreads = 0;
+      threadPool = NULL;
+      queryCache = NULL;
   }
 
   IndexSearcher::IndexSearcher(IndexReader* r){
@@ -140,6 +330,10 @@ CL_NS_DEF(search)
 
       reader      = r;
       readerOwner = false;
+      exactTotalHits = true;
+      searchThreads = 0;
+      threadPool = NULL;
+      queryCache = NULL;
   }
 
   IndexSearcher::~IndexSearcher(){
@@ -158,6 +352,7 @@ CL_NS_DEF(search)
           reader->close();
           _CLDELETE(reader);
       }
+      _CLDELETE(threadPool);
   }
 
   // inherit javadoc
@@ -199,6 +394,11 @@ CL_NS_DEF(search)
 
       return reader->document(i,*d);
   }
+  bool IndexSearcher::doc(int32_t i, CL_NS(document)::StoredFieldVisitor& visitor) {
+      CND_PRECONDITION(reader != NULL, L"reader is NULL");
+
+      return reader->document(i,visitor);
+  }
 
   // inherit javadoc
   int32_t IndexSearcher::maxDoc() const {
@@ -212,6 +412,33 @@ CL_NS_DEF(search)
       return reader->maxDoc();
   }
 
+  void IndexSearcher::setExactTotalHits(const bool exact){
+      exactTotalHits = exact;
+  }
+
+  bool IndexSearcher::getExactTotalHits() const{
+      return exactTotalHits;
+  }
+
+  void IndexSearcher::setSearchThreads(const int32_t threadCount){
+      _CLDELETE(threadPool);
+      searchThreads = threadCount > 1 ? threadCount : 0;
+      if ( searchThreads > 0 )
+        threadPool = _CLNEW SearchThreadPool(searchThreads);
+  }
+
+  int32_t IndexSearcher::getSearchThreads() const{
+      return searchThreads;
+  }
+
+  void IndexSearcher::setQueryCache(QueryCache* cache){
+      queryCache = cache;
+  }
+
+  QueryCache* IndexSearcher::getQueryCache(){
+      return queryCache;
+  }
+
   //todo: find out why we are passing Query* and not Weight*, as Weight is being extracted anyway from Query*
   TopDocs* IndexSearcher::_search(Query* query, Filter* filter, const int32_t nDocs){
   //Func -
@@ -222,8 +449,11 @@ CL_NS_DEF(search)
       CND_PRECONDITION(query != NULL, L"query is NULL");
 
       Weight* weight = query->weight(this);
-      Scorer* scorer = weight->scorer(reader);
-      if (scorer == NULL) {
+      const ArrayBase<IndexReader*>* subReaders = searchedSegments(reader, threadPool != NULL, queryCache != NULL);
+      Scorer* scorer = NULL;
+      if ( subReaders == NULL )
+        scorer = weight->scorer(reader);
+      if (scorer == NULL && subReaders == NULL) {
         Query* wq = weight->getQuery();
         if (wq != query)
           _CLLDELETE(wq);
@@ -231,7 +461,10 @@ CL_NS_DEF(search)
           return _CLNEW TopDocs(0, NULL, 0);
       }
 
-      BitSet* bits = filter != NULL ? filter->bits(reader) : NULL;
+      // with a query cache, the segments take the bits of their own
+      SearchFilter searchFilter(filter, queryCache);
+      SearchFilter* segmentFilter = subReaders != NULL && searchFilter.isCached() ? &searchFilter : NULL;
+      const BitSet* bits = segmentFilter == NULL ? searchFilter.bits(reader) : NULL;
       HitQueue* hq = _CLNEW HitQueue(nDocs);
 
 		  //Check hq has been allocated properly
@@ -240,9 +473,34 @@ CL_NS_DEF(search)
 		  int32_t* totalHits = _CL_NEWARRAY(int32_t,1);
       totalHits[0] = 0;
 
-      SimpleTopDocsCollector hitCol(bits,hq,totalHits,nDocs,0.0f);
-      scorer->score( &hitCol );
-      _CLDELETE(scorer);
+      if ( subReaders != NULL ){
+        const int32_t len = (int32_t) subReaders->length;
+        SegmentSearchTask** tasks = _CL_NEWARRAY(SegmentSearchTask*, len);
+        for ( int32_t i=0, base=0;i<len;base += (*subReaders)[i]->maxDoc(), i++ )
+          tasks[i] = _CLNEW SegmentTopDocsTask(weight, (*subReaders)[i], base, bits, segmentFilter, nDocs, !exactTotalHits);
+        runSegmentTasks(threadPool, tasks, len);
+
+        // the queues break ties by doc like a single one does
+        for ( int32_t i=0;i<len;i++ ){
+          SegmentTopDocsTask* task = static_cast<SegmentTopDocsTask*>(tasks[i]);
+          totalHits[0] += task->totalHits;
+          while ( task->hq.size() > 0 ){
+            ScoreDoc sd = task->hq.pop();
+            hq->insert(sd);
+          }
+          _CLDELETE(tasks[i]);
+        }
+        _CLDELETE_ARRAY(tasks);
+      }else{
+        SimpleTopDocsCollector hitCol(bits,hq,totalHits,nDocs,0.0f);
+        if ( !exactTotalHits ){
+          // no document scoring 0 is collected
+          scorer->setMinCompetitiveScore(0.0f);
+          hitCol.setScorer(scorer);
+        }
+        scorer->score( &hitCol );
+        _CLDELETE(scorer);
+      }
 
       int32_t scoreDocsLength = hq->size();
 
@@ -254,8 +512,7 @@ CL_NS_DEF(search)
       int32_t totalHitsInt = totalHits[0];
 
       _CLDELETE(hq);
-		  if ( bits != NULL && filter->shouldDeleteBitSet(bits) )
-				_CLDELETE(bits);
+		  searchFilter.release(bits);
 	    _CLDELETE_ARRAY(totalHits);
 		  Query* wq = weight->getQuery();
 		  if ( query != wq ) //query was re-written
@@ -273,19 +530,50 @@ CL_NS_DEF(search)
       CND_PRECONDITION(query != NULL, L"query is NULL");
 
     Weight* weight = query->weight(this);
-    Scorer* scorer = weight->scorer(reader);
-    if (scorer == NULL){
+    const ArrayBase<IndexReader*>* subReaders = searchedSegments(reader, threadPool != NULL, queryCache != NULL);
+    Scorer* scorer = NULL;
+    if ( subReaders == NULL ){
+      scorer = weight->scorer(reader);
+      if (scorer == NULL){
 		return _CLNEW TopFieldDocs(0, NULL, 0, NULL );
-	}
+	  }
+    }
 
-    BitSet* bits = filter != NULL ? filter->bits(reader) : NULL;
+    SearchFilter searchFilter(filter, queryCache);
+    SearchFilter* segmentFilter = subReaders != NULL && searchFilter.isCached() ? &searchFilter : NULL;
+    const BitSet* bits = segmentFilter == NULL ? searchFilter.bits(reader) : NULL;
     FieldSortedHitQueue hq(reader, sort->getSort(), nDocs);
     int32_t* totalHits = _CL_NEWARRAY(int32_t,1);
 	totalHits[0]=0;
     
-	SortedTopDocsCollector hitCol(bits,&hq,totalHits,nDocs);
-	scorer->score(&hitCol);
-    _CLLDELETE(scorer);
+    if ( subReaders != NULL ){
+      // the comparators work on the docs of the whole reader, so the queues
+      // are made here, where they are cached the first time
+      const int32_t len = (int32_t) subReaders->length;
+      SegmentSearchTask** tasks = _CL_NEWARRAY(SegmentSearchTask*, len);
+      for ( int32_t i=0, base=0;i<len;base += (*subReaders)[i]->maxDoc(), i++ )
+        tasks[i] = _CLNEW SegmentTopFieldDocsTask(weight, (*subReaders)[i], base, bits, segmentFilter, nDocs,
+          _CLNEW FieldSortedHitQueue(reader, sort->getSort(), nDocs));
+      runSegmentTasks(threadPool, tasks, len);
+
+      for ( int32_t i=0;i<len;i++ ){
+        SegmentTopFieldDocsTask* task = static_cast<SegmentTopFieldDocsTask*>(tasks[i]);
+        totalHits[0] += task->totalHits;
+        // scores are normalized by the largest one of all hits, not only the top ones
+        hq.updateMaxScore(task->hq->getMaxScore());
+        while ( task->hq->size() > 0 ){
+          FieldDoc* fd = task->hq->pop();
+          if ( !hq.insert(fd) )
+            _CLDELETE(fd);
+        }
+        _CLDELETE(tasks[i]);
+      }
+      _CLDELETE_ARRAY(tasks);
+    }else{
+	  SortedTopDocsCollector hitCol(bits,&hq,totalHits,nDocs);
+	  scorer->score(&hitCol);
+      _CLLDELETE(scorer);
+    }
 
 	int32_t hqLen = hq.size();
     FieldDoc** fieldDocs = _CL_NEWARRAY(FieldDoc*,hqLen);
@@ -301,8 +589,7 @@ CL_NS_DEF(search)
     SortField** hqFields = hq.getFields();
 	hq.setFields(NULL); //move ownership of memory over to TopFieldDocs
     int32_t totalHits0 = totalHits[0];
-	if ( bits != NULL && filter->shouldDeleteBitSet(bits) )
-		_CLLDELETE(bits);
+	searchFilter.release(bits);
     _CLDELETE_LARRAY(totalHits);
     return _CLNEW TopFieldDocs(totalHits0, fieldDocs, hqLen, hqFields );
   }
@@ -320,23 +607,44 @@ CL_NS_DEF(search)
       CND_PRECONDITION(reader != NULL, L"reader is NULL");
       CND_PRECONDITION(query != NULL, L"query is NULL");
 
-      BitSet* bits = NULL;
+      SearchFilter searchFilter(filter, queryCache);
+      const ArrayBase<IndexReader*>* subReaders = searchedSegments(reader, false, queryCache != NULL);
+      const BitSet* bits = NULL;
       SimpleFilteredCollector* fc = NULL; 
 
-      if (filter != NULL){
-          bits = filter->bits(reader);
+      if (filter != NULL && subReaders == NULL){
+          bits = searchFilter.bits(reader);
           fc = _CLNEW SimpleFilteredCollector(bits, results);
        }
 
       Weight* weight = query->weight(this);
-      Scorer* scorer = weight->scorer(reader);
-      if (scorer != NULL) {
-		  if (fc == NULL){
-              scorer->score(results);
-		  }else{
-              scorer->score((HitCollector*)fc);
-		  }
-          _CLDELETE(scorer); 
+      if (subReaders != NULL){
+          // the segments are scored in order, with the cached bits of each
+          for ( size_t i=0, base=0;i<subReaders->length;base += (*subReaders)[i]->maxDoc(), i++ ){
+              IndexReader* segment = (*subReaders)[i];
+              Scorer* scorer = weight->scorer(segment);
+              if (scorer == NULL)
+                  continue;
+              const BitSet* segmentBits = NULL;
+              try{
+                  segmentBits = searchFilter.bits(segment);
+                  SimpleFilteredCollector segmentCollector(segmentBits, results, (int32_t)base);
+                  scorer->score(&segmentCollector);
+              }_CLFINALLY(
+                  searchFilter.release(segmentBits);
+                  _CLDELETE(scorer);
+              )
+          }
+      }else{
+          Scorer* scorer = weight->scorer(reader);
+          if (scorer != NULL) {
+		      if (fc == NULL){
+                  scorer->score(results);
+		      }else{
+                  scorer->score((HitCollector*)fc);
+		      }
+              _CLDELETE(scorer); 
+          }
       }
 
     _CLLDELETE(fc);
@@ -344,8 +652,7 @@ CL_NS_DEF(search)
 	if (wq != query) // query was rewritten
 		_CLLDELETE(wq);
 	_CLLDELETE(weight);
-	if ( bits != NULL && filter->shouldDeleteBitSet(bits) )
-		_CLLDELETE(bits);
+	searchFilter.release(bits);
   }
 
   Query* IndexSearcher::rewrite(Query* original) {
@@ -21,6 +21,8 @@ CL_CLASS_DEF(search,Filter)
 CL_CLASS_DEF(search,Sort)
 CL_CLASS_DEF(search,HitCollector)
 CL_CLASS_DEF(search,Explanation)
+CL_CLASS_DEF(search,SearchThreadPool)
+CL_CLASS_DEF(search,QueryCache)
 CL_CLASS_DEF(index,IndexReader)
 //#include "CLucene/index/IndexReader.h"
 //#include "CLucene/util/BitSet.h"
@@ -36,6 +38,10 @@ CL_NS_DEF(search)
 class CLUCENE_EXPORT IndexSearcher:public Searcher{
 	CL_NS(index)::IndexReader* reader;
 	bool readerOwner;
+	bool exactTotalHits;
+	int32_t searchThreads;
+	SearchThreadPool* threadPool;
+	QueryCache* queryCache;
 
 public:
 	/** Creates a searcher searching the index in the named directory.
@@ -67,10 +73,46 @@ public:
 
 	bool doc(int32_t i, CL_NS(document)::Document& document);
 	bool doc(int32_t i, CL_NS(document)::Document* document);
+	bool doc(int32_t i, CL_NS(document)::StoredFieldVisitor& visitor);
 	_CL_DEPRECATED( doc(i, document) ) CL_NS(document)::Document* doc(int32_t i);
 
 	int32_t maxDoc() const;
 
+	/** Expert: If false, {@link #_search(Query*,Filter*,int32_t)} lets the
+	* scorer skip documents that cannot make it into the top hits, which
+	* disjunctions of terms do (see BooleanScorer2). TopDocs::totalHits then
+	* only counts the documents that were scored, so this is not for Hits,
+	* which relies on it. Defaults to true.
+	*/
+	void setExactTotalHits(const bool exact);
+	bool getExactTotalHits() const;
+
+	/** Expert: Searches the segments of a reader made of several (see
+	* IndexReader#getSubReaders()) on <code>threadCount</code> threads owned
+	* by this searcher, so that a single query uses more than one core. Each
+	* segment is scored by its own Scorer of the same Weight into its own hit
+	* queue and the queues are merged, which gives the same hits and scores
+	* as searching the whole reader. Only the methods returning TopDocs and
+	* TopFieldDocs search in parallel, a HitCollector need not be thread
+	* safe. 0 or 1 search on the calling thread, which is the default. Must
+	* not be called while searches are running.
+	*/
+	void setSearchThreads(const int32_t threadCount);
+	int32_t getSearchThreads() const;
+
+	/** Expert: Takes the documents of the Filter of a search and of the
+	* ConstantScoreQuery clauses of its query from <code>cache</code>, which
+	* keeps those of the filters used most often for each segment (see
+	* QueryCache). The segments of a reader made of several are then always
+	* scored one by one, with the filters evaluated per segment, on the
+	* search threads if there are any. The cache may be shared by several
+	* searchers, is not deleted by this one and must outlive it. NULL, the
+	* default, caches nothing. Must not be called while searches are
+	* running.
+	*/
+	void setQueryCache(QueryCache* cache);
+	QueryCache* getQueryCache();
+
 	TopDocs* _search(Query* query, Filter* filter, const int32_t nDocs);
 	TopFieldDocs* _search(Query* query, Filter* filter, const int32_t nDocs, const Sort* sort);
 
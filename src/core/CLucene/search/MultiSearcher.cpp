@@ -60,6 +60,9 @@ CL_NS_DEF(search)
 	int32_t MultiSearcher::getLength() {
 		return searchablesLen;
 	}
+	Searchable** MultiSearcher::getSearchables() {
+		return searchables;
+	}
 
   // inherit javadoc
   void MultiSearcher::close() {
@@ -82,6 +85,11 @@ CL_NS_DEF(search)
     return searchables[i]->doc(n - starts[i], d);	  // dispatch to searcher
   }
 
+  bool MultiSearcher::doc(int32_t n, CL_NS(document)::StoredFieldVisitor& visitor) {
+    int32_t i = subSearcher(n);			  // find searcher index
+    return searchables[i]->doc(n - starts[i], visitor);	  // dispatch to searcher
+  }
+
   int32_t MultiSearcher::searcherIndex(int32_t n) const{
 	 return subSearcher(n);
   }
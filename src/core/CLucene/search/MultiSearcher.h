@@ -31,6 +31,7 @@ CL_NS_DEF(search)
 	protected:
 		int32_t* getStarts();
 		int32_t getLength();
+		Searchable** getSearchables();
   public:
       /** Creates a searcher which searches <i>Searchables</i>. */
       MultiSearcher(Searchable** searchables);
@@ -44,6 +45,7 @@ CL_NS_DEF(search)
 
       /** For use by {@link HitCollector} implementations. */
 	  bool doc(int32_t n, CL_NS(document)::Document* document);
+	  bool doc(int32_t n, CL_NS(document)::StoredFieldVisitor& visitor);
 
       /** For use by {@link HitCollector} implementations to identify the
        * index of the sub-searcher that a particular hit came from. */
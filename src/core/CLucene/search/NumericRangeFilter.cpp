@@ -0,0 +1,290 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "CLucene/_ApiHeader.h"
+#include "CLucene/index/Term.h"
+#include "CLucene/index/Terms.h"
+#include "CLucene/index/IndexReader.h"
+#include "CLucene/util/BitSet.h"
+#include "CLucene/util/Misc.h"
+#include "CLucene/util/_StringIntern.h"
+#include "NumericRangeFilter.h"
+
+CL_NS_DEF(search)
+CL_NS_USE(index)
+CL_NS_USE(util)
+
+/** Sets the bits of the documents of the terms of each range which
+* NumericUtils splits the range of the filter into */
+class NumericRangeFilter::TermRangeCollector: public NumericUtils::LongRangeBuilder,
+	public NumericUtils::IntRangeBuilder
+{
+	IndexReader* reader;
+	const wchar_t* field;
+	BitSet* bts;
+	TermDocs* termDocs;
+	int32_t docs[32];
+	int32_t freqs[32];
+public:
+	TermRangeCollector(IndexReader* _reader, const wchar_t* _field, BitSet* _bts, TermDocs* _termDocs):
+		reader(_reader), field(_field), bts(_bts), termDocs(_termDocs)
+	{
+	}
+
+	using NumericUtils::LongRangeBuilder::addRange;
+	using NumericUtils::IntRangeBuilder::addRange;
+
+	void addRange(const wchar_t* minPrefixCoded, const wchar_t* maxPrefixCoded){
+		Term* t = _CLNEW Term(field, minPrefixCoded);
+		TermEnum* enumerator = reader->terms(t);
+		_CLDECDELETE(t);
+		try{
+			do{
+				Term* term = enumerator->term(false);
+				//fields are interned
+				if ( term == NULL || term->field() != field || wcscmp(term->text(), maxPrefixCoded) > 0 )
+					break;
+				termDocs->seek(enumerator);
+				int32_t count;
+				while ( (count = termDocs->read(docs, freqs, 32)) > 0 ){
+					for ( int32_t i = 0; i < count; i++ )
+						bts->set(docs[i]);
+				}
+			}while ( enumerator->next() );
+		}_CLFINALLY(
+			enumerator->close();
+			_CLDELETE(enumerator);
+		)
+	}
+};
+
+NumericRangeFilter::NumericRangeFilter( const wchar_t* _field, const int32_t _precisionStep, const ValueType _valueType,
+	const bool _hasMin, const int64_t _min, const bool _hasMax, const int64_t _max,
+	const bool _minInclusive, const bool _maxInclusive ):
+	field(NULL), precisionStep(_precisionStep), valueType(_valueType),
+	hasMin(_hasMin), hasMax(_hasMax), min(_hasMin ? _min : 0), max(_hasMax ? _max : 0),
+	// open ends are inclusive, as in ConstantScoreRangeQuery
+	minInclusive(_minInclusive || !_hasMin), maxInclusive(_maxInclusive || !_hasMax)
+{
+	if ( precisionStep < 1 )
+		_CLTHROWA(CL_ERR_IllegalArgument, "precisionStep must be at least 1");
+	field = CLStringIntern::intern(_field);
+}
+
+NumericRangeFilter::NumericRangeFilter( const NumericRangeFilter& copy ):
+	field( CLStringIntern::intern(copy.field) ),
+	precisionStep( copy.precisionStep ),
+	valueType( copy.valueType ),
+	hasMin( copy.hasMin ),
+	hasMax( copy.hasMax ),
+	min( copy.min ),
+	max( copy.max ),
+	minInclusive( copy.minInclusive ),
+	maxInclusive( copy.maxInclusive )
+{
+}
+
+NumericRangeFilter::~NumericRangeFilter()
+{
+	CLStringIntern::unintern(field);
+}
+
+NumericRangeFilter* NumericRangeFilter::newLongRange( const wchar_t* _field, const int32_t _precisionStep,
+	const int64_t* _min, const int64_t* _max, const bool _minInclusive, const bool _maxInclusive )
+{
+	return _CLNEW NumericRangeFilter(_field, _precisionStep, VALUE_LONG,
+		_min != NULL, _min != NULL ? *_min : 0, _max != NULL, _max != NULL ? *_max : 0,
+		_minInclusive, _maxInclusive);
+}
+
+NumericRangeFilter* NumericRangeFilter::newLongRange( const wchar_t* _field,
+	const int64_t* _min, const int64_t* _max, const bool _minInclusive, const bool _maxInclusive )
+{
+	return newLongRange(_field, NumericUtils::PRECISION_STEP_DEFAULT, _min, _max, _minInclusive, _maxInclusive);
+}
+
+NumericRangeFilter* NumericRangeFilter::newIntRange( const wchar_t* _field, const int32_t _precisionStep,
+	const int32_t* _min, const int32_t* _max, const bool _minInclusive, const bool _maxInclusive )
+{
+	return _CLNEW NumericRangeFilter(_field, _precisionStep, VALUE_INT,
+		_min != NULL, _min != NULL ? *_min : 0, _max != NULL, _max != NULL ? *_max : 0,
+		_minInclusive, _maxInclusive);
+}
+
+NumericRangeFilter* NumericRangeFilter::newIntRange( const wchar_t* _field,
+	const int32_t* _min, const int32_t* _max, const bool _minInclusive, const bool _maxInclusive )
+{
+	return newIntRange(_field, NumericUtils::PRECISION_STEP_DEFAULT, _min, _max, _minInclusive, _maxInclusive);
+}
+
+NumericRangeFilter* NumericRangeFilter::newDoubleRange( const wchar_t* _field, const int32_t _precisionStep,
+	const double* _min, const double* _max, const bool _minInclusive, const bool _maxInclusive )
+{
+	return _CLNEW NumericRangeFilter(_field, _precisionStep, VALUE_DOUBLE,
+		_min != NULL, _min != NULL ? NumericUtils::doubleToSortableLong(*_min) : 0,
+		_max != NULL, _max != NULL ? NumericUtils::doubleToSortableLong(*_max) : 0,
+		_minInclusive, _maxInclusive);
+}
+
+NumericRangeFilter* NumericRangeFilter::newDoubleRange( const wchar_t* _field,
+	const double* _min, const double* _max, const bool _minInclusive, const bool _maxInclusive )
+{
+	return newDoubleRange(_field, NumericUtils::PRECISION_STEP_DEFAULT, _min, _max, _minInclusive, _maxInclusive);
+}
+
+NumericRangeFilter* NumericRangeFilter::newFloatRange( const wchar_t* _field, const int32_t _precisionStep,
+	const float* _min, const float* _max, const bool _minInclusive, const bool _maxInclusive )
+{
+	return _CLNEW NumericRangeFilter(_field, _precisionStep, VALUE_FLOAT,
+		_min != NULL, _min != NULL ? NumericUtils::floatToSortableInt(*_min) : 0,
+		_max != NULL, _max != NULL ? NumericUtils::floatToSortableInt(*_max) : 0,
+		_minInclusive, _maxInclusive);
+}
+
+NumericRangeFilter* NumericRangeFilter::newFloatRange( const wchar_t* _field,
+	const float* _min, const float* _max, const bool _minInclusive, const bool _maxInclusive )
+{
+	return newFloatRange(_field, NumericUtils::PRECISION_STEP_DEFAULT, _min, _max, _minInclusive, _maxInclusive);
+}
+
+const wchar_t* NumericRangeFilter::getField() const { return field; }
+int32_t NumericRangeFilter::getPrecisionStep() const { return precisionStep; }
+NumericRangeFilter::ValueType NumericRangeFilter::getValueType() const { return valueType; }
+bool NumericRangeFilter::includesMin() const { return minInclusive; }
+bool NumericRangeFilter::includesMax() const { return maxInclusive; }
+
+bool NumericRangeFilter::getBounds( int64_t& lower, int64_t& upper ) const
+{
+	const bool is64 = valueType == VALUE_LONG || valueType == VALUE_DOUBLE;
+	const int64_t minValue = is64 ? LUCENE_INT64_MIN_SHOULDBE : -(int64_t)LUCENE_INT32_MAX_SHOULDBE - 1;
+	const int64_t maxValue = is64 ? LUCENE_INT64_MAX_SHOULDBE : (int64_t)LUCENE_INT32_MAX_SHOULDBE;
+
+	// an exclusive bound is the inclusive bound next to it, which for
+	// floating point values is the next value of the sortable bits
+	lower = hasMin ? min : minValue;
+	if ( !minInclusive ){
+		if ( lower == maxValue )
+			return false;
+		lower++;
+	}
+	upper = hasMax ? max : maxValue;
+	if ( !maxInclusive ){
+		if ( upper == minValue )
+			return false;
+		upper--;
+	}
+	return lower <= upper;
+}
+
+BitSet* NumericRangeFilter::bits( IndexReader* reader )
+{
+	BitSet* bts = _CLNEW BitSet( reader->maxDoc() );
+	int64_t lower, upper;
+	if ( !getBounds(lower, upper) )
+		return bts;
+
+	TermDocs* termDocs = reader->termDocs();
+
+  #define CLEANUP \
+    termDocs->close(); \
+    _CLLDELETE( termDocs )
+
+	try{
+		TermRangeCollector collector(reader, field, bts, termDocs);
+		if ( valueType == VALUE_LONG || valueType == VALUE_DOUBLE )
+			NumericUtils::splitLongRange(&collector, precisionStep, lower, upper);
+		else
+			NumericUtils::splitIntRange(&collector, precisionStep, (int32_t)lower, (int32_t)upper);
+	}catch(CLuceneError& err){
+		_CLDELETE(bts);
+		CLEANUP;
+		throw err;
+	}
+	CLEANUP;
+  #undef CLEANUP
+
+	return bts;
+}
+
+void NumericRangeFilter::appendValue( std::wstring& buffer, const int64_t value ) const
+{
+	wchar_t buf[32];
+	switch ( valueType ){
+	case VALUE_DOUBLE:
+		_snwprintf(buf, 32, L"%.17g", NumericUtils::sortableLongToDouble(value));
+		break;
+	case VALUE_FLOAT:
+		_snwprintf(buf, 32, L"%.9g", (double)NumericUtils::sortableIntToFloat((int32_t)value));
+		break;
+	default:
+		_i64tow(value, buf, 10);
+	}
+	buf[31] = 0;
+	buffer.append(buf);
+}
+
+void NumericRangeFilter::appendRange( std::wstring& buffer ) const
+{
+	buffer.push_back(minInclusive ? L'[' : L'{');
+	if ( hasMin )
+		appendValue(buffer, min);
+	else
+		buffer.push_back(L'*');
+	buffer.append(L" TO ");
+	if ( hasMax )
+		appendValue(buffer, max);
+	else
+		buffer.push_back(L'*');
+	buffer.push_back(maxInclusive ? L']' : L'}');
+}
+
+std::wstring NumericRangeFilter::toString()
+{
+	std::wstring buffer(field);
+	buffer.push_back(L':');
+	appendRange(buffer);
+	return buffer;
+}
+
+Filter* NumericRangeFilter::clone() const {
+	return _CLNEW NumericRangeFilter(*this );
+}
+
+bool NumericRangeFilter::equals( Filter* o ) const
+{
+	if ( this == o ) return true;
+	if ( strcmp(o->getObjectName(), getObjectName()) != 0 ) return false;
+	const NumericRangeFilter* other = static_cast<NumericRangeFilter*>(o);
+	return field == other->field // interned comparison
+		&& precisionStep == other->precisionStep
+		&& valueType == other->valueType
+		&& hasMin == other->hasMin && min == other->min
+		&& hasMax == other->hasMax && max == other->max
+		&& minInclusive == other->minInclusive
+		&& maxInclusive == other->maxInclusive;
+}
+
+size_t NumericRangeFilter::hashCode() const
+{
+	uint32_t h = (uint32_t)Misc::thashCode(field) ^ ((uint32_t)precisionStep * 0x9e3779b9U) ^ (uint32_t)valueType;
+	h ^= hasMin ? (uint32_t)(min ^ (min >> 32)) : 0x965a965aU;
+	// mix h, so that equal bounds do not cancel out
+	h ^= (h << 17) | (h >> 15);
+	h ^= hasMax ? (uint32_t)(max ^ (max >> 32)) : 0x5a695a69U;
+	h ^= (minInclusive ? 0x665599aaU : 0) ^ (maxInclusive ? 0x99aa5566U : 0);
+	return h;
+}
+
+const char* NumericRangeFilter::getClassName(){
+	return "NumericRangeFilter";
+}
+const char* NumericRangeFilter::getObjectName() const{
+	return getClassName();
+}
+
+CL_NS_END
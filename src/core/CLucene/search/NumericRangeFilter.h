@@ -0,0 +1,146 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#ifndef _lucene_search_NumericRangeFilter_
+#define _lucene_search_NumericRangeFilter_
+
+#include "Filter.h"
+#include "CLucene/util/NumericUtils.h"
+
+CL_NS_DEF(search)
+
+/**
+* A Filter that restricts search results to a range of the values of a
+* document::NumericField.
+* <p>
+* The range is split into the terms of the precisions the field is indexed
+* at (see util::NumericUtils), so only the documents of a few hundred terms
+* at most are read, however many values the range holds. The filter must
+* be created with the type and the precisionStep which the field was
+* indexed with, or it misses documents.
+* <p>
+* A bound given as NULL leaves that end of the range open.
+*/
+class CLUCENE_EXPORT NumericRangeFilter: public Filter
+{
+public:
+	/** The types of values a filter can be created for */
+	enum ValueType {
+		VALUE_INT,
+		VALUE_LONG,
+		VALUE_FLOAT,
+		VALUE_DOUBLE
+	};
+
+private:
+	const wchar_t* field;
+	int32_t precisionStep;
+	ValueType valueType;
+	bool hasMin;
+	bool hasMax;
+	/** the bounds as util::NumericUtils indexes them: floating point
+	* values as their sortable bits */
+	int64_t min;
+	int64_t max;
+	bool minInclusive;
+	bool maxInclusive;
+
+	class TermRangeCollector;
+	friend class NumericRangeQuery;
+
+	NumericRangeFilter( const wchar_t* field, const int32_t precisionStep, const ValueType valueType,
+		const bool hasMin, const int64_t min, const bool hasMax, const int64_t max,
+		const bool minInclusive, const bool maxInclusive );
+
+	/** Sets lower and upper to the inclusive bounds of the values to find,
+	* false if there are none */
+	bool getBounds( int64_t& lower, int64_t& upper ) const;
+
+	void appendValue( std::wstring& buffer, const int64_t value ) const;
+	void appendRange( std::wstring& buffer ) const;
+
+protected:
+	NumericRangeFilter( const NumericRangeFilter& copy );
+
+public:
+	virtual ~NumericRangeFilter();
+
+	/**
+	* Creates a filter on the int64_t values of a field.
+	* @throws CLuceneError CL_ERR_IllegalArgument if precisionStep is below 1
+	*/
+	static NumericRangeFilter* newLongRange( const wchar_t* field, const int32_t precisionStep,
+		const int64_t* min, const int64_t* max, const bool minInclusive, const bool maxInclusive );
+	/** Creates a filter on the int64_t values of a field indexed with the
+	* default precision step */
+	static NumericRangeFilter* newLongRange( const wchar_t* field,
+		const int64_t* min, const int64_t* max, const bool minInclusive, const bool maxInclusive );
+
+	/**
+	* Creates a filter on the int32_t values of a field.
+	* @throws CLuceneError CL_ERR_IllegalArgument if precisionStep is below 1
+	*/
+	static NumericRangeFilter* newIntRange( const wchar_t* field, const int32_t precisionStep,
+		const int32_t* min, const int32_t* max, const bool minInclusive, const bool maxInclusive );
+	/** Creates a filter on the int32_t values of a field indexed with the
+	* default precision step */
+	static NumericRangeFilter* newIntRange( const wchar_t* field,
+		const int32_t* min, const int32_t* max, const bool minInclusive, const bool maxInclusive );
+
+	/**
+	* Creates a filter on the double values of a field.
+	* @throws CLuceneError CL_ERR_IllegalArgument if precisionStep is below 1
+	*/
+	static NumericRangeFilter* newDoubleRange( const wchar_t* field, const int32_t precisionStep,
+		const double* min, const double* max, const bool minInclusive, const bool maxInclusive );
+	/** Creates a filter on the double values of a field indexed with the
+	* default precision step */
+	static NumericRangeFilter* newDoubleRange( const wchar_t* field,
+		const double* min, const double* max, const bool minInclusive, const bool maxInclusive );
+
+	/**
+	* Creates a filter on the float values of a field.
+	* @throws CLuceneError CL_ERR_IllegalArgument if precisionStep is below 1
+	*/
+	static NumericRangeFilter* newFloatRange( const wchar_t* field, const int32_t precisionStep,
+		const float* min, const float* max, const bool minInclusive, const bool maxInclusive );
+	/** Creates a filter on the float values of a field indexed with the
+	* default precision step */
+	static NumericRangeFilter* newFloatRange( const wchar_t* field,
+		const float* min, const float* max, const bool minInclusive, const bool maxInclusive );
+
+	/** Returns the field name for this filter */
+	const wchar_t* getField() const;
+	int32_t getPrecisionStep() const;
+	ValueType getValueType() const;
+	/** Returns <code>true</code> if the lower endpoint is inclusive */
+	bool includesMin() const;
+	/** Returns <code>true</code> if the upper endpoint is inclusive */
+	bool includesMax() const;
+
+	/**
+	* Returns a BitSet with true for documents which should be
+	* permitted in search results, and false for those that should
+	* not.
+	*/
+	CL_NS(util)::BitSet* bits( CL_NS(index)::IndexReader* reader );
+
+	Filter* clone() const;
+
+	std::wstring toString();
+
+	/** Returns true if other restricts the same field to the same range */
+	bool equals( Filter* other ) const;
+	size_t hashCode() const;
+
+	const char* getObjectName() const;
+	static const char* getClassName();
+};
+
+CL_NS_END
+#endif
@@ -0,0 +1,119 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "CLucene/_ApiHeader.h"
+#include "NumericRangeQuery.h"
+#include "ConstantScoreQuery.h"
+#include "Similarity.h"
+#include "CLucene/util/StringBuffer.h"
+
+CL_NS_USE(index)
+CL_NS_DEF(search)
+
+NumericRangeQuery::NumericRangeQuery( NumericRangeFilter* _filter ):
+	filter(_filter)
+{
+}
+
+NumericRangeQuery::NumericRangeQuery( const NumericRangeQuery& copy ):
+	Query(copy),
+	filter( static_cast<NumericRangeFilter*>(copy.filter->clone()) )
+{
+}
+
+NumericRangeQuery::~NumericRangeQuery()
+{
+	_CLLDELETE(filter);
+}
+
+NumericRangeQuery* NumericRangeQuery::newLongRange( const wchar_t* field, const int32_t precisionStep,
+	const int64_t* min, const int64_t* max, const bool minInclusive, const bool maxInclusive )
+{
+	return _CLNEW NumericRangeQuery(NumericRangeFilter::newLongRange(field, precisionStep, min, max, minInclusive, maxInclusive));
+}
+NumericRangeQuery* NumericRangeQuery::newLongRange( const wchar_t* field,
+	const int64_t* min, const int64_t* max, const bool minInclusive, const bool maxInclusive )
+{
+	return _CLNEW NumericRangeQuery(NumericRangeFilter::newLongRange(field, min, max, minInclusive, maxInclusive));
+}
+NumericRangeQuery* NumericRangeQuery::newIntRange( const wchar_t* field, const int32_t precisionStep,
+	const int32_t* min, const int32_t* max, const bool minInclusive, const bool maxInclusive )
+{
+	return _CLNEW NumericRangeQuery(NumericRangeFilter::newIntRange(field, precisionStep, min, max, minInclusive, maxInclusive));
+}
+NumericRangeQuery* NumericRangeQuery::newIntRange( const wchar_t* field,
+	const int32_t* min, const int32_t* max, const bool minInclusive, const bool maxInclusive )
+{
+	return _CLNEW NumericRangeQuery(NumericRangeFilter::newIntRange(field, min, max, minInclusive, maxInclusive));
+}
+NumericRangeQuery* NumericRangeQuery::newDoubleRange( const wchar_t* field, const int32_t precisionStep,
+	const double* min, const double* max, const bool minInclusive, const bool maxInclusive )
+{
+	return _CLNEW NumericRangeQuery(NumericRangeFilter::newDoubleRange(field, precisionStep, min, max, minInclusive, maxInclusive));
+}
+NumericRangeQuery* NumericRangeQuery::newDoubleRange( const wchar_t* field,
+	const double* min, const double* max, const bool minInclusive, const bool maxInclusive )
+{
+	return _CLNEW NumericRangeQuery(NumericRangeFilter::newDoubleRange(field, min, max, minInclusive, maxInclusive));
+}
+NumericRangeQuery* NumericRangeQuery::newFloatRange( const wchar_t* field, const int32_t precisionStep,
+	const float* min, const float* max, const bool minInclusive, const bool maxInclusive )
+{
+	return _CLNEW NumericRangeQuery(NumericRangeFilter::newFloatRange(field, precisionStep, min, max, minInclusive, maxInclusive));
+}
+NumericRangeQuery* NumericRangeQuery::newFloatRange( const wchar_t* field,
+	const float* min, const float* max, const bool minInclusive, const bool maxInclusive )
+{
+	return _CLNEW NumericRangeQuery(NumericRangeFilter::newFloatRange(field, min, max, minInclusive, maxInclusive));
+}
+
+const wchar_t* NumericRangeQuery::getField() const { return filter->getField(); }
+const NumericRangeFilter* NumericRangeQuery::getFilter() const { return filter; }
+
+Query* NumericRangeQuery::rewrite(IndexReader* /*reader*/)
+{
+	Query* q = _CLNEW ConstantScoreQuery(filter->clone());
+	q->setBoost(getBoost());
+	return q;
+}
+
+std::wstring NumericRangeQuery::toString(const wchar_t* field) const
+{
+	std::wstring buffer;
+	if ( field == NULL || wcscmp(getField(), field) != 0 )
+	{
+		buffer.append(getField());
+		buffer.push_back(L':');
+	}
+	filter->appendRange(buffer);
+	buffer.append(boost_to_wstring(getBoost()));
+	return buffer;
+}
+
+bool NumericRangeQuery::equals(Query* o) const
+{
+	if (this == o) return true;
+	if (!(o->instanceOf(NumericRangeQuery::getClassName()))) return false;
+	NumericRangeQuery* other = (NumericRangeQuery*) o;
+	return filter->equals(other->filter) && this->getBoost() == other->getBoost();
+}
+
+size_t NumericRangeQuery::hashCode() const
+{
+	return filter->hashCode() ^ Similarity::floatToByte(getBoost());
+}
+
+const std::wstring NumericRangeQuery::getObjectName() const { return getClassName(); }
+const std::wstring NumericRangeQuery::getClassName() { return L"NumericRangeQuery"; }
+
+Query* NumericRangeQuery::clone() const
+{
+	return _CLNEW NumericRangeQuery(*this);
+}
+
+CL_NS_END
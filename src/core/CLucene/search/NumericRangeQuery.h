@@ -0,0 +1,78 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#ifndef _lucene_search_NumericRangeQuery_
+#define _lucene_search_NumericRangeQuery_
+
+#include "Query.h"
+#include "NumericRangeFilter.h"
+
+CL_NS_DEF(search)
+
+/**
+* A Query that matches the documents whose document::NumericField holds a
+* value in a range, all with the same score.
+* <p>
+* The query rewrites to a ConstantScoreQuery of a NumericRangeFilter, so
+* however wide the range, it reads a few hundred terms at most and never
+* hits the clause limit of BooleanQuery, as RangeQuery does. The factories
+* take the same arguments as those of NumericRangeFilter.
+*/
+class CLUCENE_EXPORT NumericRangeQuery : public Query
+{
+private:
+	NumericRangeFilter* filter;
+
+	NumericRangeQuery( NumericRangeFilter* filter );
+
+protected:
+	NumericRangeQuery( const NumericRangeQuery& copy );
+
+public:
+	virtual ~NumericRangeQuery();
+
+	static NumericRangeQuery* newLongRange( const wchar_t* field, const int32_t precisionStep,
+		const int64_t* min, const int64_t* max, const bool minInclusive, const bool maxInclusive );
+	static NumericRangeQuery* newLongRange( const wchar_t* field,
+		const int64_t* min, const int64_t* max, const bool minInclusive, const bool maxInclusive );
+	static NumericRangeQuery* newIntRange( const wchar_t* field, const int32_t precisionStep,
+		const int32_t* min, const int32_t* max, const bool minInclusive, const bool maxInclusive );
+	static NumericRangeQuery* newIntRange( const wchar_t* field,
+		const int32_t* min, const int32_t* max, const bool minInclusive, const bool maxInclusive );
+	static NumericRangeQuery* newDoubleRange( const wchar_t* field, const int32_t precisionStep,
+		const double* min, const double* max, const bool minInclusive, const bool maxInclusive );
+	static NumericRangeQuery* newDoubleRange( const wchar_t* field,
+		const double* min, const double* max, const bool minInclusive, const bool maxInclusive );
+	static NumericRangeQuery* newFloatRange( const wchar_t* field, const int32_t precisionStep,
+		const float* min, const float* max, const bool minInclusive, const bool maxInclusive );
+	static NumericRangeQuery* newFloatRange( const wchar_t* field,
+		const float* min, const float* max, const bool minInclusive, const bool maxInclusive );
+
+	/** Returns the field name for this query */
+	const wchar_t* getField() const;
+	/** Returns the filter of the range, which the query keeps */
+	const NumericRangeFilter* getFilter() const;
+
+	Query* rewrite(CL_NS(index)::IndexReader* reader);
+
+	/** Prints a user-readable version of this query. */
+	std::wstring toString(const wchar_t* field) const;
+
+	/** Returns true if <code>o</code> is equal to this. */
+	bool equals(Query* o) const;
+
+	/** Returns a hash code value for this object.*/
+	size_t hashCode() const;
+
+	const std::wstring getObjectName() const;
+	static const std::wstring getClassName();
+	Query* clone() const;
+};
+
+CL_NS_END
+#endif
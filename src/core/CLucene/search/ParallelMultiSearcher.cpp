@@ -0,0 +1,269 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "CLucene/_ApiHeader.h"
+#include "ParallelMultiSearcher.h"
+#include "SearchHeader.h"
+#include "Query.h"
+#include "_HitQueue.h"
+#include "CLucene/index/Term.h"
+#include "_FieldDocSortedHitQueue.h"
+#include "_SearchThreadPool.h"
+
+CL_NS_USE(index)
+CL_NS_USE(util)
+
+CL_NS_DEF(search)
+
+  /** A unit of work for the thread pool: one call on one sub-searcher. */
+  class ParallelMultiSearcher::SearchTask: public SearchThreadPool::Task{
+  public:
+    Searchable* searchable;
+
+    SearchTask(Searchable* _searchable):
+      searchable(_searchable)
+    {
+    }
+  };
+
+  class ParallelMultiSearcher::DocFreqTask: public SearchTask{
+    const Term* term;
+  public:
+    int32_t docFreq;
+
+    DocFreqTask(Searchable* _searchable, const Term* _term):
+      SearchTask(_searchable),
+      term(_term),
+      docFreq(0)
+    {
+    }
+    void run(){
+      docFreq = searchable->docFreq(term);
+    }
+  };
+
+  class ParallelMultiSearcher::TopDocsTask: public SearchTask{
+    Query* query;
+    Filter* filter;
+    int32_t nDocs;
+  public:
+    TopDocs* docs;
+
+    TopDocsTask(Searchable* _searchable, Query* _query, Filter* _filter, int32_t _nDocs):
+      SearchTask(_searchable),
+      query(_query),
+      filter(_filter),
+      nDocs(_nDocs),
+      docs(NULL)
+    {
+    }
+    ~TopDocsTask(){
+      _CLDELETE(docs);
+    }
+    void run(){
+      docs = searchable->_search(query, filter, nDocs);
+    }
+  };
+
+  class ParallelMultiSearcher::TopFieldDocsTask: public SearchTask{
+    Query* query;
+    Filter* filter;
+    int32_t n;
+    const Sort* sort;
+  public:
+    TopFieldDocs* docs;
+
+    TopFieldDocsTask(Searchable* _searchable, Query* _query, Filter* _filter, int32_t _n, const Sort* _sort):
+      SearchTask(_searchable),
+      query(_query),
+      filter(_filter),
+      n(_n),
+      sort(_sort),
+      docs(NULL)
+    {
+    }
+    ~TopFieldDocsTask(){
+      _CLDELETE(docs);
+    }
+    void run(){
+      docs = searchable->_search(query, filter, n, sort);
+    }
+  };
+
+  class ParallelMultiSearcher::Internal{
+  public:
+    SearchThreadPool* pool;
+
+    Searchable** searchables;
+    int32_t searchablesLen;
+    int32_t* starts;
+
+    Internal():
+      pool(NULL)
+    {
+    }
+    ~Internal(){
+      _CLDELETE(pool);
+    }
+  };
+
+
+  ParallelMultiSearcher::ParallelMultiSearcher(Searchable** _searchables, int32_t threadCount):
+    MultiSearcher(_searchables),
+    _internal(_CLNEW Internal)
+  {
+    _internal->searchables = getSearchables();
+    _internal->searchablesLen = getLength();
+    _internal->starts = getStarts();
+
+    if ( threadCount <= 0 )
+      threadCount = _internal->searchablesLen;
+    _internal->pool = _CLNEW SearchThreadPool(threadCount);
+  }
+
+  ParallelMultiSearcher::~ParallelMultiSearcher(){
+    _CLDELETE(_internal);
+  }
+
+  const char* ParallelMultiSearcher::getClassName(){
+    return "ParallelMultiSearcher";
+  }
+  const char* ParallelMultiSearcher::getObjectName() const{
+    return ParallelMultiSearcher::getClassName();
+  }
+
+  void ParallelMultiSearcher::close(){
+    MultiSearcher::close();
+  }
+
+  void ParallelMultiSearcher::runTasks(SearchTask** tasks, int32_t count){
+    try{
+      _internal->pool->run((SearchThreadPool::Task**)tasks, count);
+    }catch(CLuceneError&){
+      for ( int32_t j=0;j<count;j++ )
+        _CLDELETE(tasks[j]);
+      throw;
+    }
+  }
+
+  int32_t ParallelMultiSearcher::docFreq(const Term* term) const {
+    const int32_t len = _internal->searchablesLen;
+    SearchTask** tasks = _CL_NEWARRAY(SearchTask*, len);
+    for ( int32_t i=0;i<len;i++ )
+      tasks[i] = _CLNEW DocFreqTask(_internal->searchables[i], term);
+
+    try{
+      const_cast<ParallelMultiSearcher*>(this)->runTasks(tasks, len);
+    }catch(CLuceneError&){
+      _CLDELETE_ARRAY(tasks);
+      throw;
+    }
+
+    int32_t docFreq = 0;
+    for ( int32_t i=0;i<len;i++ ){
+      docFreq += static_cast<DocFreqTask*>(tasks[i])->docFreq;
+      _CLDELETE(tasks[i]);
+    }
+    _CLDELETE_ARRAY(tasks);
+    return docFreq;
+  }
+
+  TopDocs* ParallelMultiSearcher::_search(Query* query, Filter* filter, const int32_t nDocs) {
+    const int32_t len = _internal->searchablesLen;
+    SearchTask** tasks = _CL_NEWARRAY(SearchTask*, len);
+    for ( int32_t i=0;i<len;i++ )
+      tasks[i] = _CLNEW TopDocsTask(_internal->searchables[i], query, filter, nDocs);
+
+    try{
+      runTasks(tasks, len);
+    }catch(CLuceneError&){
+      _CLDELETE_ARRAY(tasks);
+      throw;
+    }
+
+    // merge the results in sub-searcher order, so that ties are
+    // broken the same way as by MultiSearcher
+    HitQueue* hq = _CLNEW HitQueue(nDocs);
+    int32_t totalHits = 0;
+    for ( int32_t i=0;i<len;i++ ){
+      TopDocs* docs = static_cast<TopDocsTask*>(tasks[i])->docs;
+      totalHits += docs->totalHits;		  // update totalHits
+      ScoreDoc* scoreDocs = docs->scoreDocs;
+      for ( int32_t j = 0; j <docs->scoreDocsLength; ++j) { // merge scoreDocs int_to hq
+        scoreDocs[j].doc += _internal->starts[i];		  // convert doc
+        if ( !hq->insert(scoreDocs[j]))
+          break;				  // no more scores > minScore
+      }
+      _CLDELETE(tasks[i]);
+    }
+    _CLDELETE_ARRAY(tasks);
+
+    int32_t scoreDocsLen = hq->size();
+    ScoreDoc* scoreDocs = new ScoreDoc[scoreDocsLen];
+    for (int32_t i = scoreDocsLen-1; i >= 0; --i)	  // put docs in array
+      scoreDocs[i] = hq->pop();
+
+    _CLDELETE(hq);
+
+    return _CLNEW TopDocs(totalHits, scoreDocs, scoreDocsLen);
+  }
+
+  TopFieldDocs* ParallelMultiSearcher::_search (Query* query, Filter* filter, const int32_t n, const Sort* sort){
+    const int32_t len = _internal->searchablesLen;
+    SearchTask** tasks = _CL_NEWARRAY(SearchTask*, len);
+    for ( int32_t i=0;i<len;i++ )
+      tasks[i] = _CLNEW TopFieldDocsTask(_internal->searchables[i], query, filter, n, sort);
+
+    try{
+      runTasks(tasks, len);
+    }catch(CLuceneError&){
+      _CLDELETE_ARRAY(tasks);
+      throw;
+    }
+
+    FieldDocSortedHitQueue* hq = NULL;
+    int32_t totalHits = 0;
+    int32_t j;
+    for ( int32_t i=0;i<len;i++ ){
+      TopFieldDocs* docs = static_cast<TopFieldDocsTask*>(tasks[i])->docs;
+      if (hq == NULL){
+        hq = _CLNEW FieldDocSortedHitQueue (docs->fields, n);
+        docs->fields = NULL; //hit queue takes fields memory
+      }
+
+      totalHits += docs->totalHits;		  // update totalHits
+      FieldDoc** fieldDocs = docs->fieldDocs;
+      for(j = 0;j<docs->scoreDocsLength;++j){ // merge scoreDocs into hq
+        fieldDocs[j]->scoreDoc.doc += _internal->starts[i];                // convert doc
+        if (!hq->insert (fieldDocs[j]) )
+          break;                                  // no more scores > minScore
+      }
+      for ( int32_t x=0;x<j;++x )
+        fieldDocs[x]=NULL; //move ownership of FieldDoc to the hitqueue
+
+      _CLDELETE(tasks[i]);
+    }
+    _CLDELETE_ARRAY(tasks);
+
+    int32_t hqlen = hq->size();
+    FieldDoc** fieldDocs = _CL_NEWARRAY(FieldDoc*,hqlen);
+    for (j = hqlen - 1; j >= 0; j--)	  // put docs in array
+      fieldDocs[j] = hq->pop();
+
+    SortField** hqFields = hq->getFields();
+    hq->setFields(NULL); //move ownership of memory over to TopFieldDocs
+    _CLDELETE(hq);
+
+    return _CLNEW TopFieldDocs (totalHits, fieldDocs, hqlen, hqFields);
+  }
+
+  void ParallelMultiSearcher::_search(Query* query, Filter* filter, HitCollector* results){
+    MultiSearcher::_search(query, filter, results);
+  }
+
+CL_NS_END
@@ -0,0 +1,75 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+* 
+* Distributable under the terms of either the Apache License (Version 2.0) or 
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#ifndef _lucene_search_parallelmultisearcher
+#define _lucene_search_parallelmultisearcher
+
+
+#include "MultiSearcher.h"
+CL_CLASS_DEF(index,Term)
+
+CL_NS_DEF(search)
+
+ /** Implements parallel search over a set of <code>Searchables</code>.
+	*
+	* <p>Applications usually need only call the inherited {@link #search(Query)}
+	* or {@link #search(Query,Filter)} methods.
+	*
+	* <p>Each sub-searcher is searched on a thread of a pool owned by this
+	* searcher, and the caller waits for all of them before the hits are
+	* merged. The lower-level {@link HitCollector} API is not parallelized,
+	* since a HitCollector does not need to be thread safe.
+	*/
+	class CLUCENE_EXPORT ParallelMultiSearcher: public MultiSearcher {
+  private:
+    class Internal;
+    class SearchTask;
+    class DocFreqTask;
+    class TopDocsTask;
+    class TopFieldDocsTask;
+    Internal* _internal;
+
+    /** Runs the tasks on the thread pool and waits for all of them to finish.
+     * If any of them failed, the first error is rethrown after all the tasks
+     * were deleted. */
+    void runTasks(SearchTask** tasks, int32_t count);
+  public:
+      /** Creates a searcher which searches <i>searchables</i>.
+       * @param threadCount the number of threads searching the
+       * sub-searchers. 0 uses one thread per sub-searcher.
+       */
+      ParallelMultiSearcher(Searchable** searchables, int32_t threadCount = 0);
+
+      ~ParallelMultiSearcher();
+
+      /** Frees resources associated with this <code>Searcher</code>. */
+      void close();
+
+      /** Sums the document frequencies of the sub-searchers, which
+       * are queried in parallel. */
+      int32_t docFreq(const CL_NS(index)::Term* term) const;
+
+      /** Searches each Searchable on the thread pool, waits for each
+       * search to complete and merges the results back together. */
+      TopDocs* _search(Query* query, Filter* filter, const int32_t nDocs);
+
+      /** A search implementation allowing sorting which searches each
+       * Searchable on the thread pool, waits for each search to complete
+       * and merges the results back together. */
+      TopFieldDocs* _search(Query* query, Filter* filter, const int32_t n, const Sort* sort);
+
+      /** Lower-level search API. Searches the sub-searchers one after the other.
+       * @see MultiSearcher#_search(Query*,Filter*,HitCollector*) */
+      void _search(Query* query, Filter* filter, HitCollector* results);
+
+      const char* getObjectName() const;
+      static const char* getClassName();
+    };
+
+CL_NS_END
+#endif
@@ -400,9 +400,20 @@ Scorer* PhraseWeight::scorer(IndexReader* reader)
             parentQuery->getSimilarity(searcher),
             slop, reader->norms(parentQuery->field));
     else
+    {
+        // the rarest term leads the intersection of the documents, the
+        // term positions know the docFreq of the term they were seeked to
+        ValueArray<int32_t> docFreqs(tpsLength);
+        for (int32_t i = 0; i < tpsLength; i++)
+        {
+            docFreqs.values[i] = tps[i]->docFreq();
+            if (docFreqs.values[i] < 0)
+                docFreqs.values[i] = reader->docFreq((*parentQuery->terms)[i]);
+        }
         ret = _CLNEW ExactPhraseScorer(this, tps, positions.values,
             parentQuery->getSimilarity(searcher),
-            reader->norms(parentQuery->field));
+            reader->norms(parentQuery->field), docFreqs.values);
+    }
     positions.deleteArray();
 
     CND_CONDITION(ret != NULL, L"Could not allocate memory for ret");
@@ -0,0 +1,316 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "CLucene/_ApiHeader.h"
+#include "QueryCache.h"
+#include "Query.h"
+#include "Filter.h"
+#include "CLucene/index/IndexReader.h"
+#include "CLucene/util/BitSet.h"
+#include <list>
+#include <map>
+#include <set>
+
+CL_NS_DEF(search)
+CL_NS_USE(index)
+CL_NS_USE(util)
+
+/** The documents of a query in a reader, cached or only in use */
+struct QueryCacheEntry{
+	Query* query; //NULL if the entry was never cached
+	IndexReader* reader;
+	size_t hash;
+	BitSet* bits;
+	size_t ramBytes;
+	int32_t refs; //the uses which did not call release() yet
+	bool cached;
+	std::list<QueryCacheEntry*>::iterator lruPos;
+
+	QueryCacheEntry(IndexReader* _reader, const size_t _hash, BitSet* _bits):
+		query(NULL), reader(_reader), hash(_hash), bits(_bits),
+		ramBytes(sizeof(QueryCacheEntry) + _bits->ramBytesUsed()),
+		refs(0), cached(false)
+	{
+	}
+	~QueryCacheEntry(){
+		_CLDELETE(query);
+		_CLDELETE(bits);
+	}
+};
+
+class QueryCache::Internal: LUCENE_BASE{
+public:
+	typedef std::list<QueryCacheEntry*> LruList;
+	typedef std::multimap<size_t, QueryCacheEntry*> EntryMap;
+	typedef std::map<const BitSet*, QueryCacheEntry*> InUseMap;
+
+	DEFINE_MUTEX(THIS_LOCK)
+	size_t maxRamBytes;
+	int32_t minFrequency;
+	size_t ramBytesUsed;
+	LruList lru; //the cached entries, least recently used first
+	EntryMap entries; //the cached entries by the hash of their key
+	InUseMap inUse; //the entries whose bits are in use, cached or not
+	std::set<IndexReader*> readers; //the readers with cached entries
+
+	size_t history[HISTORY_SIZE]; //hash codes of the last queries used
+	int32_t historyLength;
+	int32_t historyPos;
+
+	int64_t hitCount;
+	int64_t missCount;
+	int64_t evictionCount;
+
+	//all caches, so that a reader which closes is dropped from each of them
+	static Internal* caches;
+	STATIC_DEFINE_MUTEX(CACHES_LOCK)
+	Internal* prevCache;
+	Internal* nextCache;
+
+	Internal(const size_t _maxRamBytes, const int32_t _minFrequency):
+		maxRamBytes(_maxRamBytes), minFrequency(_minFrequency), ramBytesUsed(0),
+		historyLength(0), historyPos(0),
+		hitCount(0), missCount(0), evictionCount(0),
+		prevCache(NULL), nextCache(NULL)
+	{
+	}
+
+	static size_t keyHash(Query* query, IndexReader* reader){
+		return query->hashCode() ^ (((size_t)reader >> 4) * 0x9e3779b9U);
+	}
+
+	QueryCacheEntry* find(Query* query, IndexReader* reader, const size_t hash){
+		std::pair<EntryMap::iterator, EntryMap::iterator> range = entries.equal_range(hash);
+		for ( EntryMap::iterator itr = range.first; itr != range.second; ++itr ){
+			QueryCacheEntry* e = itr->second;
+			if ( e->reader == reader && e->query->equals(query) )
+				return e;
+		}
+		return NULL;
+	}
+
+	int32_t frequency(const size_t hash) const{
+		int32_t ret = 0;
+		for ( int32_t i = 0; i < historyLength; i++ ){
+			if ( history[i] == hash )
+				ret++;
+		}
+		return ret;
+	}
+
+	void pin(QueryCacheEntry* e){
+		if ( e->refs++ == 0 )
+			inUse[e->bits] = e;
+	}
+
+	/** Takes e out of the cache, deleting it unless its bits are in use */
+	void remove(QueryCacheEntry* e){
+		std::pair<EntryMap::iterator, EntryMap::iterator> range = entries.equal_range(e->hash);
+		for ( EntryMap::iterator itr = range.first; itr != range.second; ++itr ){
+			if ( itr->second == e ){
+				entries.erase(itr);
+				break;
+			}
+		}
+		lru.erase(e->lruPos);
+		ramBytesUsed -= e->ramBytes;
+		e->cached = false;
+		if ( e->refs == 0 )
+			_CLDELETE(e);
+	}
+
+	void clear(IndexReader* reader){
+		for ( LruList::iterator itr = lru.begin(); itr != lru.end(); ){
+			QueryCacheEntry* e = *itr++;
+			if ( reader == NULL || e->reader == reader )
+				remove(e);
+		}
+		if ( reader == NULL )
+			readers.clear();
+		else
+			readers.erase(reader);
+	}
+};
+
+QueryCache::Internal* QueryCache::Internal::caches = NULL;
+DEFINE_MUTEX(QueryCache::Internal::CACHES_LOCK)
+
+QueryCache::QueryCache(const size_t maxRamBytes, const int32_t minFrequency):
+	_internal(_CLNEW Internal(maxRamBytes, minFrequency))
+{
+	if ( minFrequency < 1 || minFrequency > HISTORY_SIZE ){
+		_CLDELETE(_internal);
+		_CLTHROWA(CL_ERR_IllegalArgument, "minFrequency must be between 1 and HISTORY_SIZE");
+	}
+
+	SCOPED_LOCK_MUTEX(Internal::CACHES_LOCK)
+	_internal->nextCache = Internal::caches;
+	if ( Internal::caches != NULL )
+		Internal::caches->prevCache = _internal;
+	Internal::caches = _internal;
+}
+
+QueryCache::~QueryCache(){
+	{
+		SCOPED_LOCK_MUTEX(Internal::CACHES_LOCK)
+		if ( _internal->prevCache != NULL )
+			_internal->prevCache->nextCache = _internal->nextCache;
+		else
+			Internal::caches = _internal->nextCache;
+		if ( _internal->nextCache != NULL )
+			_internal->nextCache->prevCache = _internal->prevCache;
+	}
+	_internal->clear(NULL);
+	Internal::InUseMap::iterator itr = _internal->inUse.begin();
+	for ( ; itr != _internal->inUse.end(); ++itr ){
+		QueryCacheEntry* e = itr->second;
+		_CLDELETE(e);
+	}
+	_CLDELETE(_internal);
+}
+
+void QueryCache::closeCallback(IndexReader* reader, void*){
+	SCOPED_LOCK_MUTEX(Internal::CACHES_LOCK)
+	for ( Internal* cache = Internal::caches; cache != NULL; cache = cache->nextCache ){
+		SCOPED_LOCK_MUTEX(cache->THIS_LOCK)
+		cache->clear(reader);
+	}
+}
+
+void QueryCache::onUse(Query* query){
+	const size_t hash = query->hashCode();
+	SCOPED_LOCK_MUTEX(_internal->THIS_LOCK)
+	_internal->history[_internal->historyPos] = hash;
+	_internal->historyPos = (_internal->historyPos + 1) % HISTORY_SIZE;
+	if ( _internal->historyLength < HISTORY_SIZE )
+		_internal->historyLength++;
+}
+
+const BitSet* QueryCache::get(Query* query, IndexReader* reader){
+	const size_t hash = Internal::keyHash(query, reader);
+	SCOPED_LOCK_MUTEX(_internal->THIS_LOCK)
+	QueryCacheEntry* e = _internal->find(query, reader, hash);
+	if ( e == NULL ){
+		_internal->missCount++;
+		return NULL;
+	}
+	_internal->hitCount++;
+	// make it the most recently used
+	_internal->lru.splice(_internal->lru.end(), _internal->lru, e->lruPos);
+	_internal->pin(e);
+	return e->bits;
+}
+
+const BitSet* QueryCache::put(Query* query, IndexReader* reader, BitSet* bits){
+	CND_PRECONDITION(bits != NULL, L"bits is NULL");
+
+	//most filters match few documents or many, a list of the few is smaller
+	bits->compact();
+	QueryCacheEntry* e = _CLNEW QueryCacheEntry(reader, Internal::keyHash(query, reader), bits);
+	//a query which is not equal to its clone, such as one with a filter
+	//that does not implement Filter::equals(), would never be found again
+	Query* key = query->clone();
+	if ( !key->equals(query) )
+		_CLDELETE(key);
+
+	bool watchReader = false;
+	{
+		SCOPED_LOCK_MUTEX(_internal->THIS_LOCK)
+		if ( key != NULL
+			&& e->ramBytes <= _internal->maxRamBytes
+			&& _internal->frequency(query->hashCode()) >= _internal->minFrequency
+			&& _internal->find(query, reader, e->hash) == NULL ){
+
+			e->query = key;
+			key = NULL;
+			e->cached = true;
+			_internal->entries.insert(Internal::EntryMap::value_type(e->hash, e));
+			e->lruPos = _internal->lru.insert(_internal->lru.end(), e);
+			_internal->ramBytesUsed += e->ramBytes;
+			while ( _internal->ramBytesUsed > _internal->maxRamBytes ){
+				_internal->remove(_internal->lru.front());
+				_internal->evictionCount++;
+			}
+			watchReader = _internal->readers.insert(reader).second;
+		}
+		_internal->pin(e);
+	}
+	_CLDELETE(key);
+	if ( watchReader )
+		reader->addCloseCallback(closeCallback, NULL);
+	return bits;
+}
+
+void QueryCache::release(const BitSet* bits){
+	if ( bits == NULL )
+		return;
+	SCOPED_LOCK_MUTEX(_internal->THIS_LOCK)
+	Internal::InUseMap::iterator itr = _internal->inUse.find(bits);
+	if ( itr == _internal->inUse.end() )
+		_CLTHROWA(CL_ERR_IllegalArgument, "bits are not in use by this cache");
+	QueryCacheEntry* e = itr->second;
+	if ( --e->refs == 0 ){
+		_internal->inUse.erase(itr);
+		if ( !e->cached )
+			_CLDELETE(e);
+	}
+}
+
+const BitSet* QueryCache::bits(Query* query, Filter* filter, IndexReader* reader){
+	const BitSet* ret = get(query, reader);
+	if ( ret != NULL )
+		return ret;
+	BitSet* bs = filter->bits(reader);
+	// the cache must own what it keeps
+	if ( !filter->shouldDeleteBitSet(bs) )
+		bs = bs->clone();
+	return put(query, reader, bs);
+}
+
+void QueryCache::clear(IndexReader* reader){
+	SCOPED_LOCK_MUTEX(_internal->THIS_LOCK)
+	_internal->clear(reader);
+}
+
+void QueryCache::clear(){
+	SCOPED_LOCK_MUTEX(_internal->THIS_LOCK)
+	_internal->clear(NULL);
+	_internal->historyLength = 0;
+	_internal->historyPos = 0;
+}
+
+int32_t QueryCache::size() const{
+	SCOPED_LOCK_MUTEX(_internal->THIS_LOCK)
+	return (int32_t)_internal->lru.size();
+}
+
+size_t QueryCache::ramBytesUsed() const{
+	SCOPED_LOCK_MUTEX(_internal->THIS_LOCK)
+	return _internal->ramBytesUsed;
+}
+
+size_t QueryCache::getMaxRamBytes() const{
+	return _internal->maxRamBytes;
+}
+
+int64_t QueryCache::getHitCount() const{
+	SCOPED_LOCK_MUTEX(_internal->THIS_LOCK)
+	return _internal->hitCount;
+}
+
+int64_t QueryCache::getMissCount() const{
+	SCOPED_LOCK_MUTEX(_internal->THIS_LOCK)
+	return _internal->missCount;
+}
+
+int64_t QueryCache::getEvictionCount() const{
+	SCOPED_LOCK_MUTEX(_internal->THIS_LOCK)
+	return _internal->evictionCount;
+}
+
+CL_NS_END
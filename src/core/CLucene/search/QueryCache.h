@@ -0,0 +1,121 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#ifndef _lucene_search_QueryCache_
+#define _lucene_search_QueryCache_
+
+#include "CLucene/clucene-config.h"
+
+CL_CLASS_DEF(index,IndexReader)
+CL_CLASS_DEF(util,BitSet)
+CL_CLASS_DEF(search,Query)
+CL_CLASS_DEF(search,Filter)
+
+CL_NS_DEF(search)
+
+/**
+* Caches the documents which filters match in each segment, for the
+* searchers given it with IndexSearcher#setQueryCache(). The Filter of a
+* search and the filters of ConstantScoreQuery clauses are then evaluated
+* once per segment, and any number of searchers and readers may share one
+* cache, so that the filters reused by many queries, such as those limiting
+* a search to what a user may see, take up a single RAM budget.
+* <p>
+* The documents are kept as compact BitSets (see BitSet#compact()), keyed
+* by a query (Query#equals() and Query#hashCode()), which for a filter is a
+* ConstantScoreQuery wrapping it, and by the reader of the segment they are
+* from. Filters which do not implement Filter#equals() are never found
+* again and so not cached.
+* <p>
+* A query is only cached once it was used minFrequency times among the last
+* HISTORY_SIZE uses, so that filters used once do not push out the ones
+* which are used over and over. When the cache would hold more than
+* maxRamBytes, the entries used least recently are evicted. The entries of
+* a reader are dropped when it is closed; documents deleted through a
+* reader after its entries were cached stay in them, as with
+* CachingWrapperFilter.
+* <p>
+* All methods are thread safe. The cache must not be deleted while
+* searches use it.
+*/
+class CLUCENE_EXPORT QueryCache: LUCENE_BASE {
+	class Internal;
+	Internal* _internal;
+
+	/** drops the entries of the reader from every cache */
+	static void closeCallback(CL_NS(index)::IndexReader* reader, void* param);
+public:
+	/** The RAM budget used when none is given, 32MB */
+	LUCENE_STATIC_CONSTANT(size_t, DEFAULT_MAX_RAM_BYTES = 32*1024*1024);
+	/** The uses among the last HISTORY_SIZE which admit a query when none is given */
+	LUCENE_STATIC_CONSTANT(int32_t, DEFAULT_MIN_FREQUENCY = 2);
+	/** The number of the last uses which admission counts in */
+	LUCENE_STATIC_CONSTANT(int32_t, HISTORY_SIZE = 256);
+
+	/**
+	* @param maxRamBytes the most memory the cached BitSets and their
+	* entries may take
+	* @param minFrequency how often a query must be used among the last
+	* HISTORY_SIZE uses before it is cached. 1 caches every query.
+	*/
+	QueryCache(const size_t maxRamBytes = DEFAULT_MAX_RAM_BYTES,
+		const int32_t minFrequency = DEFAULT_MIN_FREQUENCY);
+	~QueryCache();
+
+	/** Counts one use of query towards its admission. Searches call this
+	* once for each query they look up, before looking it up in the segments */
+	void onUse(Query* query);
+
+	/**
+	* Returns the documents of query in reader, if they are cached, or NULL.
+	* The documents stay valid until they are passed to release().
+	*/
+	const CL_NS(util)::BitSet* get(Query* query, CL_NS(index)::IndexReader* reader);
+
+	/**
+	* Caches bits as the documents of query in reader, if the query was used
+	* often enough and they fit in the RAM budget, and returns them.
+	* @memory takes bits, which must be passed to release() even if they
+	* were not cached
+	*/
+	const CL_NS(util)::BitSet* put(Query* query, CL_NS(index)::IndexReader* reader,
+		CL_NS(util)::BitSet* bits);
+
+	/** Ends the use of documents returned by get(), put() or bits(),
+	* deleting them if they are not cached anymore */
+	void release(const CL_NS(util)::BitSet* bits);
+
+	/**
+	* Returns the documents of filter in reader: the cached ones of query,
+	* or else those of filter->bits(), which are put(). query must be equal
+	* to a ConstantScoreQuery wrapping filter.
+	* @memory the returned bits must be passed to release()
+	*/
+	const CL_NS(util)::BitSet* bits(Query* query, Filter* filter, CL_NS(index)::IndexReader* reader);
+
+	/** Drops the entries of reader */
+	void clear(CL_NS(index)::IndexReader* reader);
+	/** Drops all entries and forgets the uses counted so far */
+	void clear();
+
+	/** Returns the number of cached entries */
+	int32_t size() const;
+	/** Returns the memory the cached entries take, in bytes */
+	size_t ramBytesUsed() const;
+	size_t getMaxRamBytes() const;
+
+	/** Returns how often get() found documents */
+	int64_t getHitCount() const;
+	/** Returns how often get() found nothing */
+	int64_t getMissCount() const;
+	/** Returns how many entries were evicted to stay in the RAM budget */
+	int64_t getEvictionCount() const;
+};
+
+CL_NS_END
+#endif
@@ -68,6 +68,25 @@ std::wstring QueryFilter::toString()
 	return L"QueryFilter("+ qt + L")";
 }
 
+bool QueryFilter::equals( Filter* other ) const
+{
+	if ( this == other ) return true;
+	if ( strcmp(other->getObjectName(), getObjectName()) != 0 ) return false;
+	return query->equals(static_cast<QueryFilter*>(other)->query);
+}
+
+size_t QueryFilter::hashCode() const
+{
+	return query->hashCode() ^ 0x923f7d0e;
+}
+
+const char* QueryFilter::getClassName(){
+	return "QueryFilter";
+}
+const char* QueryFilter::getObjectName() const{
+	return getClassName();
+}
+
 
 /** Returns a BitSet with true for documents which should be permitted in
 search results, and false for those that should not. */
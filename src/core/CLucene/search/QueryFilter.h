@@ -36,6 +36,13 @@ public:
 	Filter *clone() const;
 	
 	std::wstring toString();
+
+	/** Returns true if other filters by a query equal to the one of this */
+	bool equals( Filter* other ) const;
+	size_t hashCode() const;
+
+	const char* getObjectName() const;
+	static const char* getClassName();
 };
 
 CL_NS_END
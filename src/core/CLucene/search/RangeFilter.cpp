@@ -11,6 +11,7 @@
 #include "CLucene/index/Terms.h"
 #include "CLucene/index/IndexReader.h"
 #include "CLucene/util/BitSet.h"
+#include "CLucene/util/Misc.h"
 #include "RangeFilter.h"
 
 CL_NS_DEF(search)
@@ -150,4 +151,36 @@ Filter* RangeFilter::clone() const {
 	return _CLNEW RangeFilter(*this );
 }
 
+bool RangeFilter::equals( Filter* other ) const
+{
+	if ( this == other ) return true;
+	if ( strcmp(other->getObjectName(), getObjectName()) != 0 ) return false;
+	RangeFilter* o = static_cast<RangeFilter*>(other);
+	if ( wcscmp(fieldName, o->fieldName) != 0
+		|| includeLower != o->includeLower
+		|| includeUpper != o->includeUpper )
+		return false;
+	if ( lowerTerm != NULL ? o->lowerTerm == NULL || wcscmp(lowerTerm, o->lowerTerm) != 0 : o->lowerTerm != NULL ) return false;
+	if ( upperTerm != NULL ? o->upperTerm == NULL || wcscmp(upperTerm, o->upperTerm) != 0 : o->upperTerm != NULL ) return false;
+	return true;
+}
+
+size_t RangeFilter::hashCode() const
+{
+	uint32_t h = (uint32_t)Misc::thashCode(fieldName);
+	h ^= lowerTerm != NULL ? (uint32_t)Misc::thashCode(lowerTerm) : 0x965a965aU;
+	// mix h, so that equal bounds do not cancel out
+	h ^= (h << 17) | (h >> 15);
+	h ^= upperTerm != NULL ? (uint32_t)Misc::thashCode(upperTerm) : 0x5a695a69U;
+	h ^= (includeLower ? 0x665599aaU : 0) ^ (includeUpper ? 0x99aa5566U : 0);
+	return h;
+}
+
+const char* RangeFilter::getClassName(){
+	return "RangeFilter";
+}
+const char* RangeFilter::getObjectName() const{
+	return getClassName();
+}
+
 CL_NS_END
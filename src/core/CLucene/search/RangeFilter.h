@@ -69,6 +69,13 @@ public:
 	
 	std::wstring toString();
 
+	/** Returns true if other restricts the same field to the same range */
+	bool equals( Filter* other ) const;
+	size_t hashCode() const;
+
+	const char* getObjectName() const;
+	static const char* getClassName();
+
 protected:
 	RangeFilter( const RangeFilter& copy );
 };
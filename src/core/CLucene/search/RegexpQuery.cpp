@@ -0,0 +1,118 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "CLucene/_ApiHeader.h"
+#include "RegexpQuery.h"
+#include "Similarity.h"
+#include "CLucene/index/Term.h"
+#include "CLucene/index/IndexReader.h"
+#include "CLucene/util/StringBuffer.h"
+#include "CLucene/util/_Automaton.h"
+
+CL_NS_USE(index)
+CL_NS_USE(util)
+CL_NS_DEF(search)
+
+RegexpQuery::RegexpQuery(Term* term) :
+    MultiTermQuery(term),
+    automaton(toAutomaton(term))
+{
+}
+
+RegexpQuery::RegexpQuery(const RegexpQuery& clone) :
+    MultiTermQuery(clone),
+    automaton(_CLNEW Automaton(*clone.automaton))
+{
+}
+
+RegexpQuery::~RegexpQuery()
+{
+    _CLDELETE(automaton);
+}
+
+const std::wstring RegexpQuery::getObjectName() const
+{
+    return getClassName();
+}
+
+const std::wstring RegexpQuery::getClassName()
+{
+    return L"RegexpQuery";
+}
+
+FilteredTermEnum* RegexpQuery::getEnum(IndexReader* reader)
+{
+    return _CLNEW RegexpTermEnum(reader, getTerm(false), automaton);
+}
+
+Query* RegexpQuery::clone() const
+{
+    return _CLNEW RegexpQuery(*this);
+}
+
+std::wstring RegexpQuery::toString(const wchar_t* field) const
+{
+    std::wstring buffer;
+    Term* term = getTerm(false);
+    if (field == NULL || wcscmp(term->field(), field) != 0)
+    {
+        buffer.append(term->field());
+        buffer.push_back(L':');
+    }
+    buffer.push_back(L'/');
+    buffer.append(term->text());
+    buffer.push_back(L'/');
+    buffer.append(boost_to_wstring(getBoost()));
+    return buffer;
+}
+
+size_t RegexpQuery::hashCode() const
+{
+    return Similarity::floatToByte(getBoost()) ^ getTerm(false)->hashCode();
+}
+
+bool RegexpQuery::equals(Query* other) const
+{
+    if (!(other->instanceOf(RegexpQuery::getClassName())))
+        return false;
+
+    RegexpQuery* rq = (RegexpQuery*) other;
+    return (this->getBoost() == rq->getBoost())
+        && getTerm(false)->equals(rq->getTerm(false));
+}
+
+
+Automaton* RegexpQuery::toAutomaton(Term* term)
+{
+    Automaton* automaton = RegExp::toAutomaton(term->text(), term->textLength(), MAX_AUTOMATON_STATES);
+    if (automaton == NULL)
+        _CLTHROWA(CL_ERR_IllegalArgument, "Regular expression is too complex");
+    return automaton;
+}
+
+
+RegexpTermEnum::RegexpTermEnum(IndexReader* reader, Term* term) :
+    AutomatonTermEnum()
+{
+    setAutomaton(reader, term, RegexpQuery::toAutomaton(term));
+}
+
+RegexpTermEnum::RegexpTermEnum(IndexReader* reader, Term* term, const Automaton* automaton) :
+    AutomatonTermEnum()
+{
+    setAutomaton(reader, term, _CLNEW Automaton(*automaton));
+}
+
+RegexpTermEnum::~RegexpTermEnum()
+{
+}
+
+const std::wstring RegexpTermEnum::getObjectName() const { return getClassName(); }
+const std::wstring RegexpTermEnum::getClassName() { return L"RegexpTermEnum"; }
+
+CL_NS_END
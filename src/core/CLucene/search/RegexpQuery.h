@@ -0,0 +1,96 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#ifndef _lucene_search_RegexpQuery_
+#define _lucene_search_RegexpQuery_
+
+#include "CLucene/clucene-config.h"
+#include "MultiTermQuery.h"
+#include "AutomatonTermEnum.h"
+
+CL_CLASS_DEF(index,Term)
+CL_CLASS_DEF(util,Automaton)
+
+CL_NS_DEF(search)
+
+/** Implements the regular expression query: the text of the term is a
+* regular expression, which must match the whole of a term. The syntax is:
+* <pre>
+* a        the character a
+* \c       the character c, even if it is one of the operators
+* .        any character
+* [abc]    one of a, b and c; ranges such as [a-z] are allowed
+* [^abc]   any character except a, b and c
+* (e)      e, grouped
+* e|f      e or f
+* e*       e repeated 0 or more times; e+ 1 or more, e? 0 or 1
+* e{n}     e repeated n times; e{n,} n or more, e{n,m} n to m times
+* </pre>
+* The expression is compiled into an automaton once, and the terms are
+* enumerated the way {@link AutomatonTermEnum} does, so a leading
+* <code>.*</code> does not make the query backtrack.
+*/
+class CLUCENE_EXPORT RegexpQuery: public MultiTermQuery {
+private:
+	/** The largest automaton built, in states */
+	LUCENE_STATIC_CONSTANT(int32_t, MAX_AUTOMATON_STATES = 10000);
+
+	CL_NS(util)::Automaton* automaton;
+
+	/** Returns the automaton of the regular expression in the text of term */
+	static CL_NS(util)::Automaton* toAutomaton(CL_NS(index)::Term* term);
+	friend class RegexpTermEnum;
+protected:
+	FilteredTermEnum* getEnum(CL_NS(index)::IndexReader* reader);
+	RegexpQuery(const RegexpQuery& clone);
+public:
+	/**
+	* Creates a query for the terms of the field of term which the regular
+	* expression in the text of term matches.
+	* @throws CLuceneError CL_ERR_Parse if the expression is not valid, or
+	* CL_ERR_IllegalArgument if its automaton would be too large
+	*/
+	RegexpQuery(CL_NS(index)::Term* term);
+	~RegexpQuery();
+
+	const std::wstring getObjectName() const;
+	static const std::wstring getClassName();
+
+	/** Prints the expression between slashes */
+	std::wstring toString(const wchar_t* field) const;
+
+	size_t hashCode() const;
+	bool equals(Query* other) const;
+	Query* clone() const;
+};
+
+/**
+* Subclass of FilteredTermEnum for enumerating the terms which the
+* automaton of a {@link RegexpQuery} accepts.
+*/
+class CLUCENE_EXPORT RegexpTermEnum: public AutomatonTermEnum {
+public:
+	/**
+	* Enumerates the terms of the field of term which the regular expression
+	* in the text of term matches.
+	* @throws CLuceneError CL_ERR_Parse if the expression is not valid, or
+	* CL_ERR_IllegalArgument if its automaton would be too large
+	*/
+	RegexpTermEnum(CL_NS(index)::IndexReader* reader, CL_NS(index)::Term* term);
+
+	/** Enumerates the terms of the field of term which automaton accepts;
+	* automaton is copied */
+	RegexpTermEnum(CL_NS(index)::IndexReader* reader, CL_NS(index)::Term* term, const CL_NS(util)::Automaton* automaton);
+	~RegexpTermEnum();
+
+	const std::wstring getObjectName() const;
+	static const std::wstring getClassName();
+};
+
+CL_NS_END
+#endif
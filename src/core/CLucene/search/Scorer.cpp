@@ -36,6 +36,18 @@ bool Scorer::score( HitCollector* results, const int32_t maxDoc ) {
 	}
 	return true;
 }
+void Scorer::setMinCompetitiveScore(const float_t /*minScore*/) {
+}
+
+float_t Scorer::maxScore() {
+	return -1.0f;
+}
+
+float_t Scorer::maxScoreInBlock(const int32_t /*target*/, int32_t& blockEnd) {
+	blockEnd = LUCENE_INT32_MAX_SHOULDBE;
+	return maxScore();
+}
+
 bool Scorer::sort(const Scorer* elem1, const Scorer* elem2){
 	return elem1->doc() < elem2->doc();
 }
@@ -120,6 +120,27 @@ public:
 	*/
 	virtual bool skipTo(int32_t target) = 0;
 
+	/** Expert: Tells the scorer that documents scoring less than
+	* <code>minScore</code> will not be collected from now on, so it may skip
+	* them. Called with growing scores by collectors that only keep the top
+	* hits, see IndexSearcher#setExactTotalHits(bool). The default ignores it.
+	*/
+	virtual void setMinCompetitiveScore(const float_t minScore);
+
+	/** Expert: Returns an upper bound of the score of any document, or -1 if
+	* the scorer cannot tell. The default returns -1.
+	*/
+	virtual float_t maxScore();
+
+	/** Expert: Returns an upper bound of the scores of the documents from
+	* <code>target</code> up to and including <code>blockEnd</code>, which it
+	* sets, or -1 if the scorer cannot tell. <code>target</code> must not be
+	* less than in earlier calls, nor than the targets of earlier calls of
+	* {@link #skipTo(int)}. The default returns {@link #maxScore()} for a
+	* block that runs to the last document.
+	*/
+	virtual float_t maxScoreInBlock(const int32_t target, int32_t& blockEnd);
+
 	/** Returns an explanation of the score for a document.
 	* <br>When this method is used, the {@link #next()}, {@link #skipTo(int)} and
 	* {@link #score(HitCollector)} methods should not be used.
@@ -246,6 +246,11 @@ Similarity* Searcher::getSimilarity()
     return this->similarity;
 }
 
+QueryCache* Searcher::getQueryCache()
+{
+    return NULL;
+}
+
 const char* Searcher::getClassName()
 {
     return "Searcher";
@@ -0,0 +1,100 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "CLucene/_ApiHeader.h"
+#include "_SearchThreadPool.h"
+
+CL_NS_DEF(search)
+
+  SearchThreadPool::Task::Task():
+    remaining(NULL),
+    failed(false)
+  {
+  }
+  SearchThreadPool::Task::~Task(){
+  }
+
+  void SearchThreadPool::Task::execute(){
+    try{
+      run();
+    }catch(CLuceneError& err){
+      error.set(err.number(), err.twhat());
+      failed = true;
+    }catch(...){
+      error.set(CL_ERR_Runtime, "unknown exception in search thread");
+      failed = true;
+    }
+  }
+
+  SearchThreadPool::SearchThreadPool(const int32_t threadCount):
+    closing(false)
+  {
+    CND_PRECONDITION(threadCount > 0, L"threadCount must be greater than 0");
+
+    SCOPED_LOCK_MUTEX(THIS_LOCK)
+    for ( int32_t i=0;i<threadCount;i++ )
+      threads.push_back(_LUCENE_THREAD_CREATE(&searchThread, this));
+  }
+
+  SearchThreadPool::~SearchThreadPool(){
+    {
+      SCOPED_LOCK_MUTEX(THIS_LOCK)
+      closing = true;
+      CONDITION_NOTIFYALL(THIS_WAIT_CONDITION)
+    }
+    for ( size_t i=0;i<threads.size();i++ )
+      _LUCENE_THREAD_JOIN(threads[i]);
+  }
+
+  void SearchThreadPool::searchThread(void* arg){
+    SearchThreadPool* pool = (SearchThreadPool*)arg;
+    while ( true ){
+      Task* task;
+      {
+        SCOPED_LOCK_MUTEX(pool->THIS_LOCK)
+        while ( pool->tasks.empty() && !pool->closing ){
+          CONDITION_WAIT(pool->THIS_LOCK, pool->THIS_WAIT_CONDITION)
+        }
+        if ( pool->tasks.empty() )
+          return;
+        task = pool->tasks.front();
+        pool->tasks.pop_front();
+      }
+
+      task->execute();
+
+      {
+        SCOPED_LOCK_MUTEX(pool->THIS_LOCK)
+        (*task->remaining)--;
+        CONDITION_NOTIFYALL(pool->THIS_WAIT_CONDITION)
+      }
+    }
+  }
+
+  void SearchThreadPool::run(Task** _tasks, const int32_t count){
+    int32_t remaining = count;
+    {
+      SCOPED_LOCK_MUTEX(THIS_LOCK)
+      for ( int32_t i=0;i<count;i++ ){
+        _tasks[i]->remaining = &remaining;
+        _tasks[i]->failed = false;
+        tasks.push_back(_tasks[i]);
+      }
+      CONDITION_NOTIFYALL(THIS_WAIT_CONDITION)
+      while ( remaining > 0 ){
+        CONDITION_WAIT(THIS_LOCK, THIS_WAIT_CONDITION)
+      }
+    }
+
+    for ( int32_t i=0;i<count;i++ ){
+      if ( _tasks[i]->failed )
+        throw CLuceneError(_tasks[i]->error);
+    }
+  }
+
+CL_NS_END
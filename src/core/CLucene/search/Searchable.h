@@ -14,6 +14,7 @@
 CL_CLASS_DEF(index,Term)
 //#include "Filter.h"
 CL_CLASS_DEF(document,Document)
+CL_CLASS_DEF(document,StoredFieldVisitor)
 //#include "Sort.h"
 //#include "CLucene/util/VoidList.h"
 //#include "Explanation.h"
@@ -31,6 +32,7 @@ CL_NS_DEF(search)
 	class Similarity;
 	class TopFieldDocs;
 	class Sort;
+	class QueryCache;
 	
 
    /** The interface for search implementations.
@@ -93,6 +95,12 @@ CL_NS_DEF(search)
       virtual bool doc(int32_t i, CL_NS(document)::Document* d) = 0;
       _CL_DEPRECATED( doc(i, document) ) CL_NS(document)::Document* doc(const int32_t i);
 
+      /** Expert: Passes the stored fields of document <code>i</code> to
+      * visitor, without allocating a Document.
+      * @see IndexReader#document(int32_t, StoredFieldVisitor&).
+      */
+      virtual bool doc(int32_t i, CL_NS(document)::StoredFieldVisitor& visitor) = 0;
+
       /** Expert: called to re-write queries into primitive queries. */
       virtual Query* rewrite(Query* query) = 0;
 
@@ -174,6 +182,12 @@ CL_NS_DEF(search)
 		*/
 		Similarity* getSimilarity();
 
+		/** Expert: Returns the cache which the weights of this searcher take
+		* the documents of filters from, or NULL. The default is NULL.
+		* @see IndexSearcher#setQueryCache()
+		*/
+		virtual QueryCache* getQueryCache();
+
 		virtual const char* getObjectName() const;
 		static const char* getClassName();
 
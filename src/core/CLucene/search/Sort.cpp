@@ -353,6 +353,7 @@ public:
     }
     ~ScoreDocComparatorImpl()
     {
+        _CLDECDELETE(fca);
     }
     int32_t compare(struct ScoreDoc* i, struct ScoreDoc* j)
     {
@@ -375,7 +376,16 @@ public:
 
 ScoreDocComparator* SortComparator::newComparator(CL_NS(index)::IndexReader* reader, const wchar_t* fieldname)
 {
-    return _CLNEW ScoreDocComparatorImpl(FieldCache::DEFAULT()->getCustom(reader, fieldname, this));
+    FieldCacheAuto* fca = FieldCache::DEFAULT()->getPinned(reader, fieldname, SortField::CUSTOM, this);
+    try
+    {
+        return _CLNEW ScoreDocComparatorImpl(fca);
+    }
+    catch (CLuceneError&)
+    {
+        _CLDECDELETE(fca);
+        throw;
+    }
 }
 SortComparator::SortComparator()
 {
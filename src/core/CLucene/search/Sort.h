@@ -181,19 +181,22 @@ public:
    LUCENE_STATIC_CONSTANT(int32_t, AUTO=2);
 
   /** Sort using term values as Strings.  Sort values are String and lower
-   * values are at the front. */
+   * values are at the front. Fields with sorted doc values are sorted by
+   * those instead of by their terms. */
    LUCENE_STATIC_CONSTANT(int32_t, STRING=3);
 
   /** Sort using term values as encoded Integers.  Sort values are Integer and
-   * lower values are at the front. */
+   * lower values are at the front. Fields with numeric doc values are sorted
+   * by those instead, with Compare::Int64 sort values (see LONG). */
    LUCENE_STATIC_CONSTANT(int32_t, INT=4);
 
   /** Sort using term values as encoded Floats.  Sort values are Float and
    * lower values are at the front. */
    LUCENE_STATIC_CONSTANT(int32_t, FLOAT=5);
 
-    /** Sort using term values as encoded Longs.  Sort values are Long and
-    * lower values are at the front. */
+    /** Sort using the numeric doc values of the field (see
+    * Field::DOCVALUES_NUMERIC).  Sort values are Compare::Int64 and lower
+    * values are at the front. */
    LUCENE_STATIC_CONSTANT(int32_t, LONG=6);
 
     /** Sort using term values as encoded Doubles.  Sort values are Double and
@@ -163,7 +163,7 @@ Scorer* TermWeight::scorer(IndexReader* reader)
         return NULL;
 
     return _CLNEW TermScorer(this, termDocs, similarity,
-        reader->norms(_term->field()));
+        reader->norms(_term->field()), reader, _term->field());
 }
 
 Explanation* TermWeight::explain(IndexReader* reader, int32_t doc)
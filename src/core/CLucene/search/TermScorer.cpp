@@ -12,6 +12,7 @@
 #include "Explanation.h"
 #include "CLucene/index/Term.h"
 #include "CLucene/index/Terms.h"
+#include "CLucene/index/IndexReader.h"
 #include "TermQuery.h"
 #include "Similarity.h"
 #include "Explanation.h"
@@ -20,7 +21,7 @@ CL_NS_USE(index)
 CL_NS_DEF(search)
 
 TermScorer::TermScorer(Weight* w, CL_NS(index)::TermDocs* td,
-    Similarity* similarity, uint8_t* _norms) :
+    Similarity* similarity, uint8_t* _norms, CL_NS(index)::IndexReader* _reader, const wchar_t* _field) :
     Scorer(similarity),
     termDocs(td),
     norms(_norms),
@@ -28,10 +29,13 @@ TermScorer::TermScorer(Weight* w, CL_NS(index)::TermDocs* td,
     weightValue(w->getValue()),
     _doc(0),
     pointer(0),
-    pointerMax(0)
+    pointerMax(0),
+    reader(_reader),
+    field(_field),
+    maxNorm(-1.0f)
 {
-    memset(docs, 0, 32 * sizeof(int32_t));
-    memset(freqs, 0, 32 * sizeof(int32_t));
+    memset(docs, 0, BUFFER_SIZE * sizeof(int32_t));
+    memset(freqs, 0, BUFFER_SIZE * sizeof(int32_t));
 
     for (int32_t i = 0; i < LUCENE_SCORE_CACHE_SIZE; i++)
         scoreCache[i] = getSimilarity()->tf(i) * weightValue;
@@ -41,27 +45,59 @@ TermScorer::~TermScorer()
 {
     _CLLDELETE(termDocs);
 }
+bool TermScorer::refill()
+{
+    pointerMax = termDocs->read(docs, freqs, BUFFER_SIZE);    // refill buffer
+    if (pointerMax != 0)
+    {
+        pointer = 0;
+        return true;
+    }
+    termDocs->close();			  // close stream
+    _doc = LUCENE_INT32_MAX_SHOULDBE;		  // set to sentinel value
+    return false;
+}
+
 bool TermScorer::next()
 {
     pointer++;
     if (pointer >= pointerMax)
     {
-        pointerMax = termDocs->read(docs, freqs, 32);    // refill buffer
-        if (pointerMax != 0)
-        {
-            pointer = 0;
-        }
-        else
-        {
-            termDocs->close();			  // close stream
-            _doc = LUCENE_INT32_MAX_SHOULDBE;		  // set to sentinel value
+        if (!refill())
             return false;
-        }
     }
     _doc = docs[pointer];
     return true;
 }
 
+void TermScorer::score(HitCollector* hc)
+{
+    if (next())
+        score(hc, LUCENE_INT32_MAX_SHOULDBE);
+}
+
+bool TermScorer::score(HitCollector* hc, const int32_t max)
+{
+    Similarity* similarity = getSimilarity();
+    while (_doc < max)
+    {
+        int32_t f = freqs[pointer];
+        float_t raw =
+            f < LUCENE_SCORE_CACHE_SIZE
+            ? scoreCache[f]
+            : similarity->tf(f) * weightValue;
+        hc->collect(_doc, raw * Similarity::decodeNorm(norms[_doc]));
+
+        if (++pointer >= pointerMax)
+        {
+            if (!refill())
+                return false;
+        }
+        _doc = docs[pointer];
+    }
+    return true;
+}
+
 bool TermScorer::skipTo(int32_t target)
 {
     // first scan in cache
@@ -90,6 +126,37 @@ bool TermScorer::skipTo(int32_t target)
     return result;
 }
 
+float_t TermScorer::maxScoreForFreq(const int32_t freq)
+{
+    if (freq < 0)
+        return -1.0f;
+    if (weightValue <= 0)
+        return 0.0f; // no score is above 0
+    if (maxNorm < 0)
+        maxNorm = Similarity::decodeNorm(reader->maxNorm(field));
+    float_t raw =
+        freq < LUCENE_SCORE_CACHE_SIZE
+        ? scoreCache[freq]
+        : getSimilarity()->tf(freq) * weightValue;
+    return raw * maxNorm;
+}
+
+float_t TermScorer::maxScore()
+{
+    return maxScoreForFreq(termDocs->maxFreq());
+}
+
+float_t TermScorer::maxScoreInBlock(const int32_t target, int32_t& blockEnd)
+{
+    if (_doc == LUCENE_INT32_MAX_SHOULDBE)
+    {
+        // exhausted, termDocs is closed
+        blockEnd = LUCENE_INT32_MAX_SHOULDBE;
+        return 0.0f;
+    }
+    return maxScoreForFreq(termDocs->maxFreqInBlock(target, blockEnd));
+}
+
 Explanation* TermScorer::explain(int32_t doc)
 {
     TermQuery* query = (TermQuery*) weight->getQuery();
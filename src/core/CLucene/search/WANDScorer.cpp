@@ -0,0 +1,245 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+
+#include "CLucene/_ApiHeader.h"
+#include "Scorer.h"
+#include "SearchHeader.h"
+#include "Explanation.h"
+
+#include "_WANDScorer.h"
+
+#include <float.h>
+
+CL_NS_DEF(search)
+
+/** A subscorer with its current doc and the bounds of its scores */
+class WANDScorer::Clause {
+public:
+	Scorer* scorer;
+	int32_t doc;
+	double maxScore;
+
+	// the bound of the last block asked for, which holds the docs from blockTarget to blockEnd
+	int32_t blockTarget;
+	int32_t blockEnd;
+	double blockMaxScore;
+
+	void init(Scorer* s) {
+		scorer = s;
+		doc = -1;
+		const float_t bound = s->maxScore();
+		maxScore = bound < 0 ? FLT_MAX : bound;
+		blockTarget = blockEnd = -1;
+		blockMaxScore = maxScore;
+	}
+
+	/** Returns the bound of the block that holds target, and sets end to its last doc */
+	double maxScoreInBlock(const int32_t target, int32_t& end) {
+		if (target < blockTarget || target > blockEnd) {
+			const float_t bound = scorer->maxScoreInBlock(target, blockEnd);
+			blockTarget = target;
+			blockMaxScore = bound < 0 ? maxScore : cl_min((double) bound, maxScore);
+		}
+		end = blockEnd;
+		return blockMaxScore;
+	}
+};
+
+WANDScorer::WANDScorer(ScorersType* _subScorers, const float_t* coordFactors) :
+	Scorer(NULL),
+	nrClauses((int32_t) _subScorers->size()),
+	minScore(0.0f),
+	started(false),
+	currentDoc(-1),
+	_nrMatchers(0),
+	scoredDoc(-1),
+	currentScore(0.0f)
+{
+	if ( nrClauses <= 1 ) {
+		_CLTHROWA(CL_ERR_IllegalArgument,"There must be at least 2 subScorers");
+	}
+
+	clauses = _CL_NEWARRAY(Clause, nrClauses);
+	byDoc = _CL_NEWARRAY(Clause*, nrClauses);
+	int32_t i = 0;
+	for ( ScorersType::iterator itr = _subScorers->begin(); itr != _subScorers->end(); itr++, i++ ) {
+		subScorers.push_back( *itr );
+		clauses[i].init( *itr );
+		byDoc[i] = &clauses[i];
+	}
+
+	maxCoordFactors = _CL_NEWARRAY(float_t, nrClauses + 1);
+	maxCoordFactors[0] = coordFactors[0];
+	for ( i = 1; i <= nrClauses; i++ )
+		maxCoordFactors[i] = cl_max(maxCoordFactors[i - 1], coordFactors[i]);
+}
+
+WANDScorer::~WANDScorer()
+{
+	_CLDELETE_ARRAY(clauses);
+	_CLDELETE_ARRAY(byDoc);
+	_CLDELETE_ARRAY(maxCoordFactors);
+}
+
+bool WANDScorer::canSkip(const double sum, const int32_t n) const
+{
+	// widened a little for the rounding of the float sums of the subscorers
+	return sum * maxCoordFactors[n] * 1.00001 < minScore;
+}
+
+void WANDScorer::sortByDoc()
+{
+	// the order changes little between calls
+	for ( int32_t i = 1; i < nrClauses; i++ ) {
+		Clause* c = byDoc[i];
+		int32_t j = i - 1;
+		while ( j >= 0 && byDoc[j]->doc > c->doc ) {
+			byDoc[j + 1] = byDoc[j];
+			j--;
+		}
+		byDoc[j + 1] = c;
+	}
+}
+
+bool WANDScorer::advance(int32_t target)
+{
+	if ( !started ) {
+		for ( int32_t i = 0; i < nrClauses; i++ ) {
+			Clause* c = &clauses[i];
+			c->doc = c->scorer->next() ? c->scorer->doc() : LUCENE_INT32_MAX_SHOULDBE;
+		}
+		started = true;
+	}
+
+	for (;;) {
+		sortByDoc();
+
+		// clauses before target can still match from target on, so count them there
+		double sum = 0;
+		int32_t pivot = -1;
+		for ( int32_t i = 0; i < nrClauses && byDoc[i]->doc != LUCENE_INT32_MAX_SHOULDBE; i++ ) {
+			sum += byDoc[i]->maxScore;
+			if ( !canSkip(sum, i + 1) ) {
+				pivot = i;
+				break;
+			}
+		}
+		if ( pivot < 0 ) {
+			currentDoc = LUCENE_INT32_MAX_SHOULDBE;
+			return false;
+		}
+		const int32_t pivotDoc = cl_max(byDoc[pivot]->doc, target);
+		while ( pivot + 1 < nrClauses && byDoc[pivot + 1]->doc <= pivotDoc )
+			pivot++;
+
+		if ( minScore > 0 ) {
+			// up to the first block end and the next clause, only these clauses can match
+			int32_t next = pivot + 1 < nrClauses ? byDoc[pivot + 1]->doc : LUCENE_INT32_MAX_SHOULDBE;
+			double blockSum = 0;
+			for ( int32_t i = 0; i <= pivot; i++ ) {
+				int32_t end;
+				blockSum += byDoc[i]->maxScoreInBlock(pivotDoc, end);
+				if ( end < next - 1 )
+					next = end + 1;
+			}
+			if ( canSkip(blockSum, pivot + 1) ) {
+				if ( next == LUCENE_INT32_MAX_SHOULDBE ) {
+					currentDoc = LUCENE_INT32_MAX_SHOULDBE;
+					return false;
+				}
+				target = next;
+				continue;
+			}
+		}
+
+		// move the clause behind the pivot doc with the largest bound onto it
+		Clause* behind = NULL;
+		for ( int32_t i = 0; i <= pivot; i++ ) {
+			if ( byDoc[i]->doc < pivotDoc && (behind == NULL || byDoc[i]->maxScore > behind->maxScore) )
+				behind = byDoc[i];
+		}
+		if ( behind == NULL ) {
+			currentDoc = pivotDoc;
+			_nrMatchers = pivot + 1;
+			return true;
+		}
+		behind->doc = behind->scorer->skipTo(pivotDoc) ? behind->scorer->doc() : LUCENE_INT32_MAX_SHOULDBE;
+	}
+}
+
+bool WANDScorer::next()
+{
+	if ( currentDoc == LUCENE_INT32_MAX_SHOULDBE )
+		return false;
+	return advance(currentDoc + 1);
+}
+
+bool WANDScorer::skipTo(int32_t target)
+{
+	if ( currentDoc == LUCENE_INT32_MAX_SHOULDBE )
+		return false;
+	if ( target <= currentDoc )
+		return true;
+	return advance(target);
+}
+
+int32_t WANDScorer::doc() const
+{
+	return currentDoc;
+}
+
+float_t WANDScorer::score()
+{
+	if ( scoredDoc != currentDoc ) {
+		currentScore = 0.0f;
+		for ( int32_t i = 0; i < nrClauses; i++ ) {
+			if ( clauses[i].doc == currentDoc )
+				currentScore += clauses[i].scorer->score();
+		}
+		scoredDoc = currentDoc;
+	}
+	return currentScore;
+}
+
+int32_t WANDScorer::nrMatchers() const
+{
+	return _nrMatchers;
+}
+
+void WANDScorer::setMinCompetitiveScore(const float_t _minScore)
+{
+	if ( _minScore > minScore )
+		minScore = _minScore;
+}
+
+std::wstring WANDScorer::toString()
+{
+	return L"WANDScorer";
+}
+
+Explanation* WANDScorer::explain( int32_t doc ){
+	Explanation* res = _CLNEW Explanation();
+	float_t sumScore = 0.0f;
+	int32_t nrMatches = 0;
+	for ( int32_t i = 0; i < nrClauses; i++ ) {
+		Explanation* es = clauses[i].scorer->explain(doc);
+		if (es->getValue() > 0.0f) { // indicates match
+			sumScore += es->getValue();
+			nrMatches++;
+		}
+		res->addDetail(es);
+	}
+
+	std::wstring buf = std::to_wstring(nrMatches) + L" of " + std::to_wstring(nrClauses) + L":";
+	res->setValue(sumScore);
+	res->setDescription(buf.c_str());
+	return res;
+}
+
+CL_NS_END
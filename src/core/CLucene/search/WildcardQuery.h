@@ -19,10 +19,10 @@ CL_NS_DEF(search)
 
 /** Implements the wildcard search query. Supported wildcards are <code>*</code>, which
   * matches any character sequence (including the empty one), and <code>?</code>,
-  * which matches any single character. Note this query can be slow, as it
-  * needs to iterate over all terms. In order to prevent extremely slow WildcardQueries,
-  * a Wildcard term must not start with one of the wildcards <code>*</code> or
-  * <code>?</code>.
+  * which matches any single character. The pattern is compiled into an
+  * automaton, so the ranges of terms which cannot match are skipped; a
+  * pattern starting with a wildcard still needs to look at every term,
+  * but compares each of them in linear time.
   *
   * @see WildcardTermEnum
   */
@@ -10,63 +10,50 @@
 #include "WildcardTermEnum.h"
 #include "CLucene/index/Term.h"
 #include "CLucene/index/IndexReader.h"
+#include "CLucene/util/_Automaton.h"
 
 CL_NS_USE(index)
+CL_NS_USE(util)
 CL_NS_DEF(search)
 
-bool WildcardTermEnum::termCompare(Term* term)
+bool WildcardTermEnum::acceptTerm(Term* term)
 {
-    if (term != NULL && __term->field() == term->field())
-    {
-        const wchar_t* searchText = term->text();
-        const wchar_t* patternText = __term->text();
-        if (wcsncmp(searchText, pre, preLen) == 0)
-        {
-            return wildcardEquals(patternText + preLen, __term->textLength() - preLen, 0, searchText, term->textLength(), preLen);
-        }
-    }
-    _endEnum = true;
-    return false;
+    if (exact)
+        return true;
+
+    //the automaton only checked the part before the first wildcard
+    return wildcardEquals(__term->text() + preLen, __term->textLength() - preLen, 0, term->text(), term->textLength(), preLen);
 }
 
 /** Creates new WildcardTermEnum */
 WildcardTermEnum::WildcardTermEnum(IndexReader* reader, Term* term) :
-    FilteredTermEnum(),
+    AutomatonTermEnum(),
     __term(_CL_POINTER(term)),
-    fieldMatch(false),
-    _endEnum(false)
+    preLen(0),
+    exact(true)
 {
-
-    pre = _wcsdup(term->text());
-
-    const wchar_t* sidx = wcschr(pre, LUCENE_WILDCARDTERMENUM_WILDCARD_STRING);
-    const wchar_t* cidx = wcschr(pre, LUCENE_WILDCARDTERMENUM_WILDCARD_CHAR);
-    const wchar_t* tidx = sidx;
-    if (tidx == NULL)
-        tidx = cidx;
-    else if (cidx && cidx > pre)
-        tidx = cl_min(sidx, cidx);
-    CND_PRECONDITION(tidx != NULL, L"tidx==NULL");
-    int32_t idx = (int32_t) (tidx - pre);
-    preLen = idx;
-    CND_PRECONDITION(preLen < term->textLength(), L"preLen >= term->textLength()");
-    pre[preLen] = 0; //trim end
-
-    Term* t = _CLNEW Term(__term, pre);
-    setEnum(reader->terms(t));
-    _CLDECDELETE(t);
+    Automaton* automaton = toAutomaton(term->text(), term->textLength(), MAX_AUTOMATON_STATES);
+    if (automaton == NULL)
+    {
+        //the terms which start with the part before the first wildcard
+        const wchar_t wildcards[] = { LUCENE_WILDCARDTERMENUM_WILDCARD_STRING, LUCENE_WILDCARDTERMENUM_WILDCARD_CHAR, 0 };
+        preLen = (int32_t) wcscspn(term->text(), wildcards);
+        std::wstring prefix(term->text(), preLen);
+        prefix.push_back(LUCENE_WILDCARDTERMENUM_WILDCARD_STRING);
+        automaton = toAutomaton(prefix.c_str(), prefix.length(), MAX_AUTOMATON_STATES);
+        exact = false;
+    }
+    setAutomaton(reader, __term, automaton);
 }
 
 void WildcardTermEnum::close()
 {
     if (__term != NULL)
     {
-        FilteredTermEnum::close();
+        AutomatonTermEnum::close();
 
         _CLDECDELETE(__term);
         __term = NULL;
-
-        _CLDELETE_CARRAY(pre);
     }
 }
 WildcardTermEnum::~WildcardTermEnum()
@@ -74,15 +61,28 @@ WildcardTermEnum::~WildcardTermEnum()
     close();
 }
 
-float_t WildcardTermEnum::difference()
+Automaton* WildcardTermEnum::toAutomaton(const wchar_t* pattern, size_t patternLen, int32_t maxStates)
 {
-    return 1.0f;
+    AutomatonBuilder builder;
+    int32_t state = builder.createState();
+    for (size_t i = 0; i < patternLen; i++)
+    {
+        if (pattern[i] == LUCENE_WILDCARDTERMENUM_WILDCARD_STRING)
+        {
+            builder.addTransition(state, Automaton::MIN_CHAR, Automaton::MAX_CHAR, state);
+            continue;
+        }
+        const int32_t next = builder.createState();
+        if (pattern[i] == LUCENE_WILDCARDTERMENUM_WILDCARD_CHAR)
+            builder.addTransition(state, Automaton::MIN_CHAR, Automaton::MAX_CHAR, next);
+        else
+            builder.addTransition(state, pattern[i], pattern[i], next);
+        state = next;
+    }
+    builder.setAccept(state);
+    return builder.determinize(maxStates);
 }
 
-bool WildcardTermEnum::endEnum()
-{
-    return _endEnum;
-}
 const std::wstring WildcardTermEnum::getObjectName() const { return getClassName(); }
 const std::wstring WildcardTermEnum::getClassName() { return L"WildcardTermEnum"; }
 
@@ -9,11 +9,13 @@
 #ifndef _lucene_search_WildcardTermEnum_
 #define _lucene_search_WildcardTermEnum_
 
+#include "CLucene/clucene-config.h"
 //#include "CLucene/index/IndexReader.h"
 CL_CLASS_DEF(index,Term)
 CL_CLASS_DEF(index,IndexReader)
+CL_CLASS_DEF(util,Automaton)
 //#include "CLucene/index/Terms.h"
-#include "FilteredTermEnum.h"
+#include "AutomatonTermEnum.h"
 
 CL_NS_DEF(search)
     /**
@@ -22,37 +24,38 @@ CL_NS_DEF(search)
      * <p>
      * Term enumerations are always ordered by term->compareTo().  Each term in
      * the enumeration is greater than all that precede it.
+     * <p>
+     * The pattern is compiled into an automaton, so the terms are matched
+     * without backtracking and the ranges of terms which cannot match are
+     * skipped, wherever the wildcards are. If that automaton would be too
+     * large, the terms starting with the part of the pattern before the
+     * first wildcard are compared with wildcardEquals().
      */
-	class CLUCENE_EXPORT WildcardTermEnum: public FilteredTermEnum {
+	class CLUCENE_EXPORT WildcardTermEnum: public AutomatonTermEnum {
     private:
+        /** The largest automaton built, in states */
+        LUCENE_STATIC_CONSTANT(int32_t, MAX_AUTOMATON_STATES = 10000);
+
         CL_NS(index)::Term* __term;
-        wchar_t* pre;
         int32_t preLen;
-        bool fieldMatch;
-        bool _endEnum;
+        bool exact;
 
-        /********************************************
-        * const wchar_t* equality with support for wildcards
-        ********************************************/
+        /** Returns the automaton of the strings matching the patternLen
+        * characters of pattern, or NULL if it would have more than maxStates
+        * states */
+        static CL_NS(util)::Automaton* toAutomaton(const wchar_t* pattern, size_t patternLen, int32_t maxStates);
 
         protected:
-        bool termCompare(CL_NS(index)::Term* term) ;
+        bool acceptTerm(CL_NS(index)::Term* term);
 
         public:
 
         /**
-		* Creates a new <code>WildcardTermEnum</code>.  Passing in a
-		* {@link Term Term} that does not contain a
-		* <code>LUCENE_WILDCARDTERMENUM_WILDCARD_STRING</code> or
-		* <code>LUCENE_WILDCARDTERMENUM_WILDCARD_CHAR</code> will cause an exception to be thrown.
+		* Creates a new <code>WildcardTermEnum</code>.
 		*/
         WildcardTermEnum(CL_NS(index)::IndexReader* reader, CL_NS(index)::Term* term);
         ~WildcardTermEnum();
 
-        float_t difference() ;
-
-        bool endEnum() ;
-
         /**
          * Determines if a word matches a wildcard pattern.
          */
@@ -27,6 +27,7 @@ CL_NS_DEF(search)
 	    class ReqExclScorer;
 	    class BSConjunctionScorer;
 	    class BSDisjunctionSumScorer;
+	    class BSWANDScorer;
 	protected:
 		bool score( HitCollector* hc, const int32_t max );
 	public:
@@ -40,6 +41,12 @@ CL_NS_DEF(search)
 		bool next();
 		float_t score();
 		bool skipTo( int32_t target );
+
+		/** Pure disjunctions of subscorers that bound their scores (see
+		* Scorer::maxScore()) skip the documents that cannot be competitive,
+		* if this is called before the first document is asked for.
+		*/
+		void setMinCompetitiveScore( const float_t minScore );
 		Explanation* explain( int32_t doc );
 		virtual std::wstring toString();
 	};
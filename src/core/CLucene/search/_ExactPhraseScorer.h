@@ -2,29 +2,69 @@
 * Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
 
 * Updated by https://github.com/farfella/.
-* 
-* Distributable under the terms of either the Apache License (Version 2.0) or 
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
 * the GNU Lesser General Public License, as specified in the COPYING file.
 ------------------------------------------------------------------------------*/
 #ifndef _lucene_search_ExactPhraseScorer_
 #define _lucene_search_ExactPhraseScorer_
 
-#include "_PhraseScorer.h"
+#include "Scorer.h"
+
+CL_CLASS_DEF(index,TermPositions)
 
 CL_NS_DEF(search)
 
-  class ExactPhraseScorer: public PhraseScorer {
-    public:
-    ExactPhraseScorer(Weight* weight, CL_NS(index)::TermPositions** tps, int32_t* offsets, 
-       Similarity* similarity, uint8_t* norms );
-       
+class Explanation;
+
+/** Expert: Scoring functionality for phrase queries without slop.
+* <br>The terms are first intersected on documents, the rarest term
+* leading and the others skipping to its documents. Only for a document
+* which has all the terms their positions are read, in one call to
+* {@link TermPositions#nextPositions(int32_t*,int32_t)} per term, and
+* the phrase frequency is the number of positions shared by all the
+* terms once their offset in the phrase is taken off.
+*/
+class ExactPhraseScorer: public Scorer {
+private:
+	class Postings;
+
+	Weight* weight;
+	uint8_t* norms;
+	float_t value;
+
+	Postings* postings; // rarest term first
+	int32_t nrPostings;
+
+	int32_t currentDoc;
+	float_t freq; // phrase frequency in current doc
+
+	/** Moves to the first document from target in which the phrase occurs */
+	bool advance(int32_t target);
+
+	/** Returns the number of times the phrase occurs in the current document */
+	int32_t phraseFreq();
+
+public:
+	/**
+	* @param tps The positions of the terms, ending with NULL, which
+	* this scorer closes and deletes.
+	* @param offsets The positions of the terms in the phrase.
+	* @param docFreqs The numbers of documents of the terms, by which the
+	* term that leads the intersection is chosen, or NULL to lead with the
+	* first term.
+	*/
+	ExactPhraseScorer(Weight* weight, CL_NS(index)::TermPositions** tps, int32_t* offsets,
+		Similarity* similarity, uint8_t* norms, const int32_t* docFreqs = NULL);
 	virtual ~ExactPhraseScorer();
 
-	virtual std::wstring toString();
+	int32_t doc() const;
+	bool next();
+	bool skipTo(int32_t target);
+	float_t score();
 
-    protected:
-      //Returns the exact freqency of the phrase
-      float_t phraseFreq();
-    };
+	Explanation* explain(int32_t doc);
+	virtual std::wstring toString();
+};
 CL_NS_END
 #endif
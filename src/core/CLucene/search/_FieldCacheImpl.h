@@ -16,16 +16,20 @@ CL_CLASS_DEF(search,SortComparatorSource)
 #include "CLucene/LuceneThreads.h"
 CL_NS_DEF(search)
 
-class fieldcacheCacheType;
+class fieldcacheShard;
 
 /**
  * Expert: The default cache implementation, storing all values in memory.
  *
+ * The entries are spread over LUCENE_FIELDCACHE_SHARDS shards, each with its
+ * own lock, so that sorted searches on different readers or fields don't wait
+ * on each other. The memory held by every entry is estimated when it is
+ * stored, and a least recently used entry is evicted whenever the total goes
+ * over the budget set with setMaxRamBytes(). Each shard keeps its entries in
+ * order of use, so finding that entry only compares the heads of the shards.
  */
 class FieldCacheImpl: public FieldCache {
 public:
-  	DEFINE_MUTEX(THIS_LOCK)
-  
 	/** Expert: Every key in the internal cache is of this type. */
 	class FileEntry:LUCENE_BASE {
 		const wchar_t* field;        // which Field
@@ -41,6 +45,8 @@ public:
 		~FileEntry();
 
 		int32_t getType() const{ return type; }
+		const wchar_t* getField() const{ return field; }
+		SortComparatorSource* getCustom() const{ return custom; }
 	   
 		/** Two of these are equal iff they reference the same field and type. */
 		bool equals (FileEntry* other) const;
@@ -72,22 +78,61 @@ public:
     FieldCacheImpl();
     virtual ~FieldCacheImpl();
 private:
-  /** The internal cache. Maps FileEntry to array of interpreted term values. **/
-  //todo: make indexreader remove itself from here when the reader is shut
-  fieldcacheCacheType* cache;
-  
-  /** See if an object is in the cache. */
-  FieldCacheAuto* lookup (CL_NS(index)::IndexReader* reader, const wchar_t* field, int32_t type) ;
- 
-  /** See if a custom object is in the cache. */
-  FieldCacheAuto* lookup (CL_NS(index)::IndexReader* reader, const wchar_t* field, SortComparatorSource* comparer);
-
-  /** Put an object into the cache. */
-  void store (CL_NS(index)::IndexReader* reader, const wchar_t* field, int32_t type, FieldCacheAuto* value);
-
-  /** Put a custom object into the cache. */
-  void store (CL_NS(index)::IndexReader* reader, const wchar_t* field, SortComparatorSource* comparer, FieldCacheAuto* value);
-  
+  /** The internal cache. Each shard maps IndexReader to FileEntry to
+  array of interpreted term values. **/
+  fieldcacheShard** shards;
+
+  /** Guards ramBytesUsed and maxRamBytes */
+  DEFINE_MUTEX(ACCOUNTING_LOCK)
+  int64_t ramBytesUsed;
+  int64_t maxRamBytes;
+
+  /** Only one thread evicts at a time */
+  DEFINE_MUTEX(EVICTION_LOCK)
+
+  /** Ticks on every cache access, entries remember when they were last used */
+  _LUCENE_ATOMIC_INT clock;
+
+  /** The shard holding the entries of reader and (interned) field. */
+  fieldcacheShard* shardFor (CL_NS(index)::IndexReader* reader, const wchar_t* field);
+
+  /** See if an object is in the cache. The returned entry is pinned for
+  the caller, and if retain is set it is never evicted. */
+  FieldCacheAuto* lookup (CL_NS(index)::IndexReader* reader, FileEntry* entry, bool retain);
+
+  /** Put an object into the cache, taking over the caller's reference
+  to value. If the entry was stored by another thread meanwhile, value is
+  released and the stored one is returned instead. The returned entry is
+  pinned for the caller, and if retain is set it is never evicted. */
+  FieldCacheAuto* store (CL_NS(index)::IndexReader* reader, FileEntry* entry, FieldCacheAuto* value, bool retain);
+
+  /** getPinned(), retaining the entry if asked to */
+  FieldCacheAuto* get (CL_NS(index)::IndexReader* reader, const wchar_t* field, int32_t type,
+      SortComparator* comparator, bool retain);
+
+  /** For the getters which return the entry unpinned: the budget does
+  not apply to it, so it stays valid until its reader is closed. */
+  FieldCacheAuto* getRetained (CL_NS(index)::IndexReader* reader, const wchar_t* field, int32_t type,
+      SortComparator* comparator = NULL);
+
+  /** Adds (or with a negative value removes) memory accounted to the cache. */
+  void account (int64_t bytes);
+
+  /** Evicts least recently used entries until the cache fits its budget. */
+  void evict();
+
+  /** Evicts the least recently used entry of shard nobody holds. Returns
+  the memory freed. */
+  int64_t evictFromShard (fieldcacheShard* shard);
+
+  // read the values of a field, uncached
+  FieldCacheAuto* readInts (CL_NS(index)::IndexReader* reader, const wchar_t* field);
+  FieldCacheAuto* readFloats (CL_NS(index)::IndexReader* reader, const wchar_t* field);
+  FieldCacheAuto* readStrings (CL_NS(index)::IndexReader* reader, const wchar_t* field);
+  FieldCacheAuto* readStringIndex (CL_NS(index)::IndexReader* reader, const wchar_t* field);
+  FieldCacheAuto* readAuto (CL_NS(index)::IndexReader* reader, const wchar_t* field);
+  FieldCacheAuto* readCustom (CL_NS(index)::IndexReader* reader, const wchar_t* field, SortComparator* comparator);
+
 public:
 
   // inherit javadocs
@@ -108,6 +153,28 @@ public:
   // inherit javadocs
   FieldCacheAuto* getCustom (CL_NS(index)::IndexReader* reader, const wchar_t* field, SortComparator* comparator);
 
+  // inherit javadocs
+  FieldCacheAuto* getPinned (CL_NS(index)::IndexReader* reader, const wchar_t* field, int32_t type,
+      SortComparator* comparator = NULL);
+
+  // inherit javadocs
+  void getCacheEntries(std::vector<CacheEntry>& entries);
+
+  // inherit javadocs
+  int64_t getRamBytesUsed();
+
+  // inherit javadocs
+  void setMaxRamBytes(int64_t maxRamBytes);
+
+  // inherit javadocs
+  int64_t getMaxRamBytes();
+
+  // inherit javadocs
+  void purge(CL_NS(index)::IndexReader* reader);
+
+  // inherit javadocs
+  void purgeAllCaches();
+
 
 	/**
 	* Callback for when IndexReader closes. This causes
@@ -0,0 +1,62 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#ifndef _lucene_search_SearchThreadPool_
+#define _lucene_search_SearchThreadPool_
+
+#include "CLucene/LuceneThreads.h"
+#include <deque>
+#include <vector>
+
+CL_NS_DEF(search)
+
+/**
+* A fixed number of threads which run the parts of searches, see
+* ParallelMultiSearcher and IndexSearcher::setSearchThreads(). Several
+* searches may run their tasks on the same pool at once.
+*/
+class SearchThreadPool: LUCENE_BASE {
+public:
+	/** One part of a search. Errors thrown by run() are kept for the caller. */
+	class Task: LUCENE_BASE {
+		int32_t* remaining;
+		bool failed;
+		CLuceneError error;
+		friend class SearchThreadPool;
+
+		void execute();
+	public:
+		Task();
+		virtual ~Task();
+		virtual void run() = 0;
+	};
+
+private:
+	DEFINE_MUTEX(THIS_LOCK)
+	DEFINE_CONDITION(THIS_WAIT_CONDITION)
+
+	std::deque<Task*> tasks;
+	std::vector<_LUCENE_THREADID_TYPE> threads;
+	bool closing;
+
+	static void searchThread(void* arg);
+public:
+	/** Starts threadCount threads, which must be more than 0 */
+	SearchThreadPool(const int32_t threadCount);
+
+	/** Waits for the queued tasks and stops the threads */
+	~SearchThreadPool();
+
+	/** Runs the tasks and waits for all of them to finish. If any of them
+	* failed, the error of the first one is rethrown; the tasks still belong
+	* to the caller. */
+	void run(Task** tasks, const int32_t count);
+};
+
+CL_NS_END
+#endif
@@ -9,6 +9,7 @@
 #ifndef _lucene_search_TermScorer_
 #define _lucene_search_TermScorer_
 
+#include "CLucene/clucene-config.h"
 
 #include "Scorer.h"
 #include "CLucene/index/Terms.h"
@@ -27,12 +28,23 @@ private:
 	const float_t weightValue;
 	int32_t _doc;
 
-	int32_t docs[32];	  // buffered doc numbers
-	int32_t freqs[32];	  // buffered term freqs
+	LUCENE_STATIC_CONSTANT(int32_t, BUFFER_SIZE = 32);
+	int32_t docs[BUFFER_SIZE];	  // buffered doc numbers
+	int32_t freqs[BUFFER_SIZE];	  // buffered term freqs
 	int32_t pointer;
 	int32_t pointerMax;
 
 	float_t scoreCache[LUCENE_SCORE_CACHE_SIZE];
+
+	CL_NS(index)::IndexReader* reader;
+	const wchar_t* field;
+	float_t maxNorm; // largest of the norms, -1 until the first bound is asked for
+
+	/** Refills docs and freqs from termDocs, closes it when exhausted. */
+	bool refill();
+
+	/** The score of a document with the largest norm and the given freq, -1 if freq is */
+	float_t maxScoreForFreq(const int32_t freq);
 public:
 
 	/** Construct a <code>TermScorer</code>.
@@ -40,10 +52,12 @@ public:
 	* @param td An iterator over the documents matching the <code>Term</code>.
 	* @param similarity The </code>Similarity</code> implementation to be used for score computations.
 	* @param norms The field norms of the document fields for the <code>Term</code>.
+	* @param reader The reader of the norms, which caches their maximum.
+	* @param field The field of the <code>Term</code>.
 	*
 	* @memory TermScorer takes TermDocs and deletes it when TermScorer is cleaned up */
 	TermScorer(Weight* weight, CL_NS(index)::TermDocs* td, 
-		Similarity* similarity, uint8_t* _norms);
+		Similarity* similarity, uint8_t* _norms, CL_NS(index)::IndexReader* reader, const wchar_t* field);
 
 	virtual ~TermScorer();
 
@@ -62,6 +76,16 @@ public:
 
 	float_t score();
 
+	/** Scores and collects all matching documents, straight from the
+	* buffered docs and freqs.
+	*/
+	void score(HitCollector* hc);
+
+	/** Collects matching documents below max, straight from the buffered
+	* docs and freqs.
+	*/
+	bool score(HitCollector* hc, const int32_t max);
+
 	/** Skips to the first match beyond the current whose document number is
 	* greater than or equal to a given target. 
 	* <br>The implementation uses {@link TermDocs#skipTo(int)}.
@@ -70,6 +94,18 @@ public:
 	*/
 	bool skipTo(int32_t target);
 
+	/** Bounds the scores with the largest freq of the term (see
+	* {@link TermDocs#maxFreq()}) and the largest of the norms, see
+	* {@link IndexReader#maxNorm()}. Assumes that Similarity::tf() does not
+	* decrease with the freq.
+	*/
+	float_t maxScore();
+
+	/** Like {@link #maxScore()}, with the largest freq in the block of postings
+	* that holds target, see {@link TermDocs#maxFreqInBlock(int32_t,int32_t&)}.
+	*/
+	float_t maxScoreInBlock(const int32_t target, int32_t& blockEnd);
+
 	/** Returns an explanation of the score for a document.
 	* <br>When this method is used, the {@link #next()} method
 	* and the {@link #score(HitCollector)} method should not be used.
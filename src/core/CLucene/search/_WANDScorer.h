@@ -0,0 +1,90 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#ifndef _lucene_search_WANDScorer_
+#define _lucene_search_WANDScorer_
+
+#include "Scorer.h"
+
+CL_NS_DEF(search)
+
+/** A Scorer for OR like queries of subscorers that bound their scores (see
+* {@link Scorer#maxScore()}), which skips the documents that cannot be
+* collected once {@link #setMinCompetitiveScore(float_t)} was called
+* (block-max weak AND).
+* <p>
+* The subscorers are kept in the order of their current doc. The first
+* one at which the sum of the bounds of the subscorers up to it could
+* reach the minimum score is the pivot: no document before its doc can.
+* If the bounds of the blocks of postings around the pivot doc (see
+* {@link Scorer#maxScoreInBlock(int32_t,int32_t&)}) cannot reach it either,
+* the whole of those blocks is skipped, otherwise the subscorers before the
+* pivot are moved onto the pivot doc, one at a time, until it matches.
+* Sums are multiplied by the largest coordination factor for as many
+* subscorers before they are compared. Until a minimum score is set this
+* matches every document a DisjunctionSumScorer matches.
+* <p>
+* {@link #score()} is the sum of the scores of the matching subscorers,
+* {@link #nrMatchers()} their number: the caller applies the coordination.
+*/
+class WANDScorer : public Scorer {
+public:
+	typedef CL_NS(util)::CLVector<Scorer*,CL_NS(util)::Deletor::Object<Scorer> > ScorersType;
+private:
+	class Clause;
+
+	/** The subscorers, in the order they were given. */
+	ScorersType subScorers;
+	int32_t nrClauses;
+	Clause* clauses;
+	Clause** byDoc; // clauses in the order of their doc, exhausted ones last
+	float_t* maxCoordFactors; // largest coordination factor for up to n matchers
+
+	float_t minScore;
+	bool started;
+	int32_t currentDoc;
+	int32_t _nrMatchers;
+	int32_t scoredDoc;
+	float_t currentScore;
+
+	/** Moves to the first document from target that may be competitive */
+	bool advance(int32_t target);
+
+	/** True if documents matching n subscorers with bounds adding up to sum are not competitive */
+	bool canSkip(const double sum, const int32_t n) const;
+
+	void sortByDoc();
+
+public:
+	/**
+	* @param subScorers At least two subscorers, which this one deletes.
+	* @param coordFactors The coordination factors for 0 up to the number of
+	* subscorers matching, none of them negative.
+	*/
+	WANDScorer(ScorersType* subScorers, const float_t* coordFactors);
+	virtual ~WANDScorer();
+
+	bool next();
+	int32_t doc() const;
+
+	/** Returns the sum of the scores of the subscorers matching the current document. */
+	virtual float_t score();
+
+	/** Returns the number of subscorers matching the current document. */
+	int32_t nrMatchers() const;
+
+	bool skipTo(int32_t target);
+
+	void setMinCompetitiveScore(const float_t minScore);
+
+	Explanation* explain(int32_t doc);
+	virtual std::wstring toString();
+};
+
+CL_NS_END
+#endif
@@ -15,7 +15,7 @@
 #ifdef _CL_HAVE_SYS_STAT_H
 #include <sys/stat.h>
 #endif
-#ifdef _CL_HAVE_UNISTD_H
+#if defined(_CL_HAVE_UNISTD_H) || defined(_CL_HAVE_FUNCTION_PREAD)
 #include <unistd.h>
 #endif
 #ifdef _CL_HAVE_DIRECT_H
@@ -32,7 +32,8 @@
 #include "CLucene/util/Misc.h"
 #include "CLucene/util/_MD5Digester.h"
 
-#ifdef LUCENE_FS_MMAP
+#if defined(_CL_HAVE_FUNCTION_MMAP) || defined(_CL_HAVE_FUNCTION_MAPVIEWOFFILE)
+#define LUCENE_HAVE_MMAP_INPUT
 #include "_MMapIndexInput.h"
 #endif
 
@@ -52,29 +53,46 @@ class FSDirectory::FSIndexInput :public BufferedIndexInput
 {
     /**
     * We used a shared handle between all the fsindexinput clones.
-    * This reduces number of file handles we need, and it means
-    * we dont have to use file tell (which is slow) before doing
-    * a read.
-* TODO: get rid of this and dup/fctnl or something like that...
+    * This reduces number of file handles we need. Reads are positional
+    * (pread, or ReadFile with an OVERLAPPED offset on windows), so the
+    * handle has no file position that the clones would have to share,
+    * and clones in different threads read in parallel without locking.
+    * The lock only guards the reference count while closing.
     */
     class SharedHandle : LUCENE_REFBASE
     {
     public:
+#ifdef _CL_HAVE_FUNCTION_PREAD
         int32_t fhandle;
+#else
+        HANDLE fhandle; //opened for overlapped io
+#endif
         int64_t _length;
-        int64_t _fpos;
         DEFINE_MUTEX(*SHARED_LOCK)
         wchar_t  path[CL_MAX_DIR]; //todo: this is only used for cloning, better to get information from the fhandle
         SharedHandle(const wchar_t * path);
         ~SharedHandle();
+
+        /** Reads up to len bytes at pos, returns the number of bytes read, 0 at the end of the file and -1 on error */
+#ifdef _CL_HAVE_FUNCTION_PREAD
+        int32_t read(uint8_t* b, const int32_t len, const int64_t pos);
+#else
+        int32_t read(uint8_t* b, const int32_t len, const int64_t pos, HANDLE event);
+#endif
     };
     SharedHandle* handle;
     int64_t _pos;
+#ifndef _CL_HAVE_FUNCTION_PREAD
+    HANDLE readEvent; //signalled when an overlapped read of this input completes, created on the first read
+#endif
     FSIndexInput(SharedHandle* handle, int32_t __bufferSize) :
         BufferedIndexInput(__bufferSize)
     {
         this->_pos = 0;
         this->handle = handle;
+#ifndef _CL_HAVE_FUNCTION_PREAD
+        this->readEvent = NULL;
+#endif
     };
 protected:
     FSIndexInput(const FSIndexInput& clone);
@@ -128,6 +146,7 @@ bool FSDirectory::FSIndexInput::open(const wchar_t * path, IndexInput*& ret, CLu
         __bufferSize = CL_NS(store)::BufferedIndexOutput::BUFFER_SIZE;
     SharedHandle* handle = _CLNEW SharedHandle(path);
 
+#ifdef _CL_HAVE_FUNCTION_PREAD
     //Open the file
     handle->fhandle = ::_wopen(path, _O_BINARY | O_RDONLY | _O_RANDOM, _S_IREAD);
 
@@ -140,7 +159,6 @@ bool FSDirectory::FSIndexInput::open(const wchar_t * path, IndexInput*& ret, CLu
             error.set(CL_ERR_IO, "fileStat error");
         else
         {
-            handle->_fpos = 0;
             ret = _CLNEW FSIndexInput(handle, __bufferSize);
             return true;
         }
@@ -157,6 +175,39 @@ bool FSDirectory::FSIndexInput::open(const wchar_t * path, IndexInput*& ret, CLu
         else
             error.set(CL_ERR_IO, "Could not open file");
     }
+#else
+    //Open the file. Only an overlapped handle lets the system run reads from
+    //several threads at the same time, reads on a synchronous handle are serialized.
+    handle->fhandle = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED | FILE_FLAG_RANDOM_ACCESS, NULL);
+
+    //Check if a valid handle was retrieved
+    if (handle->fhandle != INVALID_HANDLE_VALUE)
+    {
+        //Store the file length
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(handle->fhandle, &size))
+            error.set(CL_ERR_IO, "fileStat error");
+        else
+        {
+            handle->_length = size.QuadPart;
+            ret = _CLNEW FSIndexInput(handle, __bufferSize);
+            return true;
+        }
+    }
+    else
+    {
+        DWORD err = GetLastError();
+        if (err == ERROR_FILE_NOT_FOUND || err == ERROR_PATH_NOT_FOUND)
+            error.set(CL_ERR_IO, "File does not exist");
+        else if (err == ERROR_ACCESS_DENIED)
+            error.set(CL_ERR_IO, "File Access denied");
+        else if (err == ERROR_TOO_MANY_OPEN_FILES)
+            error.set(CL_ERR_IO, "Too many open files");
+        else
+            error.set(CL_ERR_IO, "Could not open file");
+    }
+#endif
 #ifndef _CL_DISABLE_MULTITHREADING
     delete handle->SHARED_LOCK;
 #endif
@@ -175,14 +226,20 @@ FSDirectory::FSIndexInput::FSIndexInput(const FSIndexInput& other) : BufferedInd
 
     SCOPED_LOCK_MUTEX(*other.handle->SHARED_LOCK)
         handle = _CL_POINTER(other.handle);
-    _pos = other.handle->_fpos; //note where we are currently...
+    _pos = other._pos; //the clone continues reading where the original would
+#ifndef _CL_HAVE_FUNCTION_PREAD
+    readEvent = NULL;
+#endif
 }
 
 FSDirectory::FSIndexInput::SharedHandle::SharedHandle(const wchar_t * path)
 {
+#ifdef _CL_HAVE_FUNCTION_PREAD
     fhandle = 0;
+#else
+    fhandle = INVALID_HANDLE_VALUE;
+#endif
     _length = 0;
-    _fpos = 0;
     wcscpy(this->path, path);
 
 #ifndef _CL_DISABLE_MULTITHREADING
@@ -191,6 +248,7 @@ FSDirectory::FSIndexInput::SharedHandle::SharedHandle(const wchar_t * path)
 }
 FSDirectory::FSIndexInput::SharedHandle::~SharedHandle()
 {
+#ifdef _CL_HAVE_FUNCTION_PREAD
     if (fhandle >= 0)
     {
         if (::_close(fhandle) != 0)
@@ -198,8 +256,51 @@ FSDirectory::FSIndexInput::SharedHandle::~SharedHandle()
         else
             fhandle = -1;
     }
+#else
+    if (fhandle != INVALID_HANDLE_VALUE)
+    {
+        if (!CloseHandle(fhandle))
+            _CLTHROWA(CL_ERR_IO, "File IO Close error");
+        else
+            fhandle = INVALID_HANDLE_VALUE;
+    }
+#endif
 }
 
+#ifdef _CL_HAVE_FUNCTION_PREAD
+int32_t FSDirectory::FSIndexInput::SharedHandle::read(uint8_t* b, const int32_t len, const int64_t pos)
+{
+    ssize_t ret;
+    do {
+        ret = ::pread(fhandle, b, len, (off_t)pos);
+    } while (ret == -1 && errno == EINTR);
+    return (int32_t)ret;
+}
+#else
+int32_t FSDirectory::FSIndexInput::SharedHandle::read(uint8_t* b, const int32_t len, const int64_t pos, HANDLE event)
+{
+    OVERLAPPED overlapped;
+    memset(&overlapped, 0, sizeof(OVERLAPPED));
+    overlapped.Offset = (DWORD)(pos & 0xFFFFFFFF);
+    overlapped.OffsetHigh = (DWORD)(pos >> 32);
+    overlapped.hEvent = event;
+
+    DWORD read = 0;
+    if (!ReadFile(fhandle, b, (DWORD)len, &read, &overlapped))
+    {
+        DWORD err = GetLastError();
+        if (err == ERROR_IO_PENDING)
+        {
+            if (GetOverlappedResult(fhandle, &overlapped, &read, TRUE))
+                return (int32_t)read;
+            err = GetLastError();
+        }
+        return err == ERROR_HANDLE_EOF ? 0 : -1;
+    }
+    return (int32_t)read;
+}
+#endif
+
 FSDirectory::FSIndexInput::~FSIndexInput()
 {
     //Func - Destructor
@@ -217,6 +318,13 @@ IndexInput* FSDirectory::FSIndexInput::clone() const
 void FSDirectory::FSIndexInput::close()
 {
     BufferedIndexInput::close();
+#ifndef _CL_HAVE_FUNCTION_PREAD
+    if (readEvent != NULL)
+    {
+        CloseHandle(readEvent);
+        readEvent = NULL;
+    }
+#endif
 #ifndef _CL_DISABLE_MULTITHREADING
     if (handle != NULL)
     {
@@ -260,32 +368,34 @@ void FSDirectory::FSIndexInput::seekInternal(const int64_t position)
 void FSDirectory::FSIndexInput::readInternal(uint8_t* b, const int32_t len)
 {
     CND_PRECONDITION(handle != NULL, L"shared file handle has closed");
+#ifdef _CL_HAVE_FUNCTION_PREAD
     CND_PRECONDITION(handle->fhandle >= 0, L"file is not open");
-    SCOPED_LOCK_MUTEX(*handle->SHARED_LOCK)
-
-        if (handle->_fpos != _pos)
-        {
-            if (fileSeek(handle->fhandle, _pos, SEEK_SET) != _pos)
-            {
-                _CLTHROWA(CL_ERR_IO, "File IO Seek error");
-            }
-            handle->_fpos = _pos;
-        }
-
-    bufferLength = _read(handle->fhandle, b, len); // 2004.10.31:SF 1037836
-    if (bufferLength == 0)
+#else
+    CND_PRECONDITION(handle->fhandle != INVALID_HANDLE_VALUE, L"file is not open");
+    if (readEvent == NULL)
     {
-        _CLTHROWA(CL_ERR_IO, "read past EOF");
+        readEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+        if (readEvent == NULL)
+            _CLTHROWA(CL_ERR_IO, "could not create read event");
     }
-    if (bufferLength == -1)
-    {
-        //if (EINTR == errno) we could do something else... but we have
-        //to guarantee some return, or throw EOF
+#endif
 
-        _CLTHROWA(CL_ERR_IO, "read error");
+    //no lock: the read does not depend on, or change, any state shared with the clones
+    int32_t done = 0;
+    while (done < len)
+    {
+#ifdef _CL_HAVE_FUNCTION_PREAD
+        const int32_t n = handle->read(b + done, len - done, _pos + done);
+#else
+        const int32_t n = handle->read(b + done, len - done, _pos + done, readEvent);
+#endif
+        if (n == 0)
+            _CLTHROWA(CL_ERR_IO, "read past EOF");
+        if (n == -1)
+            _CLTHROWA(CL_ERR_IO, "read error");
+        done += n;
     }
-    _pos += bufferLength;
-    handle->_fpos = _pos;
+    _pos += done;
 }
 
 FSDirectory::FSIndexOutput::FSIndexOutput(const wchar_t* path, int filemode)
@@ -645,15 +755,16 @@ bool FSDirectory::openInput(const wchar_t * name, IndexInput *& ret, CLuceneErro
     CND_PRECONDITION(directory[0] != 0, L"directory is not open")
         wchar_t fl[CL_MAX_DIR];
     priv_getFN(fl, name);
-#ifdef LUCENE_FS_MMAP
-    //todo: do some tests here... like if the file
-    //is >2gb, then some system cannot mmap the file
-    //also some file systems mmap will fail?? could detect here too
-    if (useMMap && Misc::file_Size(fl) < LUCENE_INT32_MAX_SHOULDBE) //todo: would this be bigger on 64bit systems?. i suppose it would be...test first
-        return MMapIndexInput::open(fl, ret, error, bufferSize);
-    else
+#ifdef LUCENE_HAVE_MMAP_INPUT
+    //large files are mapped in chunks, so any size can be mapped. If mapping
+    //fails (some file systems don't support it) fall back to normal reads.
+    if (useMMap)
+    {
+        if (MMapIndexInput::open(fl, ret, error, bufferSize))
+            return true;
+    }
 #endif
-        return FSIndexInput::open(fl, ret, error, bufferSize);
+    return FSIndexInput::open(fl, ret, error, bufferSize);
 }
 
 void FSDirectory::close()
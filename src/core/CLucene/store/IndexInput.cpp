@@ -9,6 +9,7 @@
 #include "CLucene/_ApiHeader.h"
 #include "IndexInput.h"
 #include "IndexOutput.h"
+#include "PrefetchIndexInput.h"
 #include "CLucene/util/Misc.h"
 
 CL_NS_DEF(store)
@@ -122,6 +123,19 @@ CL_NS_USE(util)
     readBytes(b, len);
   }
 
+  void IndexInput::setAccessPattern(AccessPattern /*pattern*/) {
+    // no-op: only mapped inputs can act on access hints
+  }
+
+  const uint8_t* IndexInput::bufferedBytes(int32_t& length) {
+    length = 0;
+    return NULL;
+  }
+
+  void IndexInput::consumeBufferedBytes(const int32_t /*len*/) {
+    // nothing was handed out by bufferedBytes()
+  }
+
   void IndexInput::readChars( wchar_t* buffer, const int32_t start, const int32_t len) {
     const int32_t end = start + len;
     wchar_t b;
@@ -147,6 +161,9 @@ CL_NS_USE(util)
 
 BufferedIndexInput::BufferedIndexInput(int32_t _bufferSize):
 		buffer(NULL),
+		readAhead(false),
+		seekPending(false),
+		prefetch(NULL),
 		bufferSize(_bufferSize>=0?_bufferSize:CL_NS(store)::BufferedIndexOutput::BUFFER_SIZE),
 		bufferStart(0),
 		bufferLength(0),
@@ -157,6 +174,9 @@ BufferedIndexInput::BufferedIndexInput(int32_t _bufferSize):
   BufferedIndexInput::BufferedIndexInput(const BufferedIndexInput& other):
   	IndexInput(other),
     buffer(NULL),
+    readAhead(false), //a clone does not start a thread of its own
+    seekPending(other.readAhead || other.seekPending),
+    prefetch(NULL),
     bufferSize(other.bufferSize),
     bufferStart(other.bufferStart),
     bufferLength(other.bufferLength),
@@ -166,7 +186,7 @@ BufferedIndexInput::BufferedIndexInput(int32_t _bufferSize):
     ** clone.bufferLength is zero indicate memory corruption/leakage?
     **   if ( clone.buffer != NULL) { */
     if (other.bufferLength != 0 && other.buffer != NULL) {
-      buffer = _CL_NEWARRAY(uint8_t,bufferLength);
+      buffer = _CL_NEWARRAY(uint8_t,bufferSize); //refill() reuses it for up to bufferSize bytes
       memcpy(buffer,other.buffer,bufferLength * sizeof(uint8_t));
     }
   }
@@ -220,7 +240,15 @@ BufferedIndexInput::BufferedIndexInput(int32_t _bufferSize):
         int64_t after = bufferStart+bufferPosition+len;
         if(after > length())
           _CLTHROWA(CL_ERR_IO, "read past EOF");
-        readInternal(b, len);
+        if (readAhead)
+          readAheadInternal(b, len, bufferStart+bufferPosition);
+        else{
+          if (seekPending){
+            seekInternal(bufferStart+bufferPosition);
+            seekPending = false;
+          }
+          readInternal(b, len);
+        }
         bufferStart = after;
         bufferPosition = 0;
         bufferLength = 0;                    // trigger refill() on read
@@ -242,9 +270,14 @@ BufferedIndexInput::BufferedIndexInput(int32_t _bufferSize):
       bufferPosition = 0;
       bufferLength = 0;				  // trigger refill() on read()
       seekInternal(pos);
+      seekPending = false;
     }
   }
   void BufferedIndexInput::close(){
+    if (prefetch != NULL){
+      prefetch->close();
+      _CLDELETE(prefetch);
+    }
     _CLDELETE_ARRAY(buffer);
     bufferLength = 0;
     bufferPosition = 0;
@@ -256,6 +289,23 @@ BufferedIndexInput::BufferedIndexInput(int32_t _bufferSize):
     BufferedIndexInput::close();
   }
 
+  const uint8_t* BufferedIndexInput::bufferedBytes(int32_t& length) {
+    if (bufferPosition >= bufferLength) {
+      if (getFilePointer() >= this->length()) {
+        length = 0;                           // EOF, let the caller throw
+        return NULL;
+      }
+      refill();
+    }
+    length = bufferLength - bufferPosition;
+    return buffer + bufferPosition;
+  }
+
+  void BufferedIndexInput::consumeBufferedBytes(const int32_t len) {
+    CND_PRECONDITION(len >= 0 && bufferPosition + len <= bufferLength, "consuming more than was buffered");
+    bufferPosition += len;
+  }
+
   void BufferedIndexInput::refill() {
     int64_t start = bufferStart + bufferPosition;
     int64_t end = start + bufferSize;
@@ -268,13 +318,55 @@ BufferedIndexInput::BufferedIndexInput(int32_t _bufferSize):
     if (buffer == NULL){
       buffer = _CL_NEWARRAY(uint8_t,bufferSize);		  // allocate buffer lazily
     }
-    readInternal(buffer, bufferLength);
+    if (readAhead)
+      readAheadInternal(buffer, bufferLength, start);
+    else{
+      if (seekPending){
+        seekInternal(start);
+        seekPending = false;
+      }
+      readInternal(buffer, bufferLength);
+    }
 
 
     bufferStart = start;
     bufferPosition = 0;
   }
 
+  void BufferedIndexInput::readAheadInternal(uint8_t* b, const int32_t len, const int64_t pos) {
+    if (prefetch == NULL && length() - pos > LUCENE_PREFETCH_CHUNK_SIZE){
+      // the background thread reads a clone of this input, which does not
+      // read ahead itself. refill() may be half way, so drop the buffer copy
+      BufferedIndexInput* source = static_cast<BufferedIndexInput*>(clone());
+      source->bufferStart = pos;
+      source->bufferLength = 0;
+      source->bufferPosition = 0; //seekPending moves the clone to pos
+      prefetch = _CLNEW PrefetchIndexInput(source);
+    }
+    if (prefetch != NULL){
+      prefetch->seek(pos);
+      prefetch->readBytes(b, len);
+    }else{
+      // not worth a thread, read directly. The subclass position may be
+      // stale from reads that went through prefetch before
+      seekInternal(pos);
+      readInternal(b, len);
+    }
+  }
+
+  void BufferedIndexInput::setAccessPattern(AccessPattern pattern) {
+    const bool sequential = (pattern == ACCESS_SEQUENTIAL);
+    if (readAhead && !sequential){
+      if (prefetch != NULL){
+        prefetch->close();
+        _CLDELETE(prefetch);
+      }
+      // reads through prefetch left the subclass position behind
+      seekPending = true;
+    }
+    readAhead = sequential;
+  }
+
   void BufferedIndexInput::setBufferSize( int32_t newSize ) {
 
 	  if ( newSize != bufferSize ) {
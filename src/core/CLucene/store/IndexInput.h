@@ -128,6 +128,37 @@ namespace lucene {
                  /** The number of bytes in the file. */
                  virtual int64_t length() const = 0;
 
+                 /** How the caller is going to read this input. */
+                 enum AccessPattern {
+                     ACCESS_NORMAL = 0,    ///< no particular pattern
+                     ACCESS_RANDOM = 1,    ///< lookups at scattered offsets (term dictionary, stored field index)
+                     ACCESS_SEQUENTIAL = 2 ///< the file is read front to back once (merges, compound file copies)
+                 };
+
+                 /** Expert: hints how this input will be read. Implementations that
+                 * map the file into memory pass this on to the OS (see MMapIndexInput),
+                 * BufferedIndexInput reads ahead on a background thread for
+                 * ACCESS_SEQUENTIAL (see PrefetchIndexInput), the default
+                 * implementation ignores it. The hint applies to this input
+                 * only, clones start without it.
+                 */
+                 virtual void setAccessPattern(AccessPattern pattern);
+
+                 /** Expert: gives direct access to bytes that are already in memory
+                 * at the current position, so callers can decode several values at
+                 * once instead of going through readByte(). Inputs that keep a buffer
+                 * or a mapping return a pointer into it and set length to the number
+                 * of bytes available there (refilling the buffer first if it is
+                 * empty). The bytes are not consumed, see consumeBufferedBytes().
+                 * The default implementation returns NULL and sets length to 0,
+                 * callers must then fall back to the read methods.
+                 * The pointer is only valid until the next call on this input.
+                 */
+                 virtual const uint8_t* bufferedBytes(int32_t& length);
+
+                 /** Expert: skips len bytes of those returned by bufferedBytes(). */
+                 virtual void consumeBufferedBytes(const int32_t len);
+
                  virtual const std::wstring getDirectoryType() const = 0;
                  virtual const std::wstring getObjectName() const = 0;
         };
@@ -137,11 +168,18 @@ namespace lucene {
         * @see Directory
         * @see IndexOutput
         */
+        class PrefetchIndexInput;
+
         class CLUCENE_EXPORT BufferedIndexInput : public IndexInput
         {
         private:
             uint8_t * buffer; //array of bytes
+            bool readAhead; //set by ACCESS_SEQUENTIAL
+            bool seekPending; //reads went through prefetch, so seekInternal() before the next readInternal()
+            PrefetchIndexInput* prefetch; //reads ahead of this input, created on the first refill
             void refill();
+            /** reads len bytes at pos, through prefetch if the file is long enough to be worth it */
+            void readAheadInternal(uint8_t* b, const int32_t len, const int64_t pos);
         protected:
             int32_t bufferSize;				//size of the buffer
             int64_t bufferStart;			  // position in file of buffer
@@ -176,8 +214,11 @@ namespace lucene {
             void readBytes(uint8_t* b, const int32_t len, bool useBuffer);
             int64_t getFilePointer() const;
             void seek(const int64_t pos);
+            const uint8_t* bufferedBytes(int32_t& length);
+            void consumeBufferedBytes(const int32_t len);
 
             void setBufferSize(int32_t newSize);
+            void setAccessPattern(AccessPattern pattern);
 
             const std::wstring getObjectName();
             static const std::wstring getClassName();
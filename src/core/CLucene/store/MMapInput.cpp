@@ -2,8 +2,8 @@
 * Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
 
 * Updated by https://github.com/farfella/.
-* 
-* Distributable under the terms of either the Apache License (Version 2.0) or 
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
 * the GNU Lesser General Public License, as specified in the COPYING file.
 ------------------------------------------------------------------------------*/
 #include "CLucene/_ApiHeader.h"
@@ -33,46 +33,272 @@
 #endif
 #include <errno.h>
 
-#if defined(_CL_HAVE_FUNCTION_MAPVIEWOFFILE)
-	
+#if !defined(_CL_HAVE_FUNCTION_MAPVIEWOFFILE) && !defined(_CL_HAVE_FUNCTION_MMAP)
+    #error no mmap implementation set
 #endif
 
 
 CL_NS_DEF(store)
 CL_NS_USE(util)
 
-    class MMapIndexInput::Internal: LUCENE_BASE{
+    static const int64_t MMAP_CHUNK_SIZE = ((int64_t)1) << LUCENE_MMAP_CHUNK_POWER;
+    //how far ahead of a sequential input the OS is asked to read
+    static const int64_t MMAP_READAHEAD_SIZE = ((int64_t)1) << 20;
+
+    /**
+    * The mapping of one file, shared by an MMapIndexInput and all of its clones.
+    * Chunks are mapped when an input first moves into them, and the file is
+    * unmapped when the last input referencing it is closed.
+    */
+    class MMapIndexInput::MappedFile: LUCENE_REFBASE{
 	public:
-		uint8_t* data;
-		int64_t pos;
+		DEFINE_MUTEX(THIS_LOCK)
+		uint8_t** chunks;
+		int64_t* chunkLengths;
+		int32_t* chunkUsers;  ///< the inputs positioned in each chunk
+		int32_t numChunks;
+		int64_t _length;
+		IndexInput::AccessPattern pattern; ///< the hint every chunk is mapped with
 #if defined(_CL_HAVE_FUNCTION_MAPVIEWOFFILE)
 		HANDLE mmaphandle;
 		HANDLE fhandle;
-#elif defined(_CL_HAVE_FUNCTION_MMAP)
+#else
 		int fhandle;
+#endif
+
+		MappedFile():
+			chunks(NULL),
+			chunkLengths(NULL),
+			chunkUsers(NULL),
+			numChunks(0),
+			_length(0),
+			pattern(IndexInput::ACCESS_NORMAL)
+		{
+#if defined(_CL_HAVE_FUNCTION_MAPVIEWOFFILE)
+			mmaphandle = NULL;
+			fhandle = INVALID_HANDLE_VALUE;
+#else
+			fhandle = -1;
+#endif
+		}
+		~MappedFile(){
+			for ( int32_t i=0;i<numChunks;i++ )
+				unmapChunk(i);
+			_CLDELETE_ARRAY(chunks);
+			_CLDELETE_ARRAY(chunkLengths);
+			_CLDELETE_ARRAY(chunkUsers);
+
+#if defined(_CL_HAVE_FUNCTION_MAPVIEWOFFILE)
+			if ( mmaphandle != NULL ){
+				if ( ! CloseHandle(mmaphandle) ){
+					CND_PRECONDITION( false, L"CloseHandle(mmaphandle) failed");
+				}
+			}
+			if ( fhandle != INVALID_HANDLE_VALUE ){
+				if ( !CloseHandle(fhandle) ){
+					CND_PRECONDITION( false, L"CloseHandle(fhandle) failed");
+				}
+			}
+#else
+			if ( fhandle >= 0 )
+				::close(fhandle);
+#endif
+		}
+
+		/** Splits the file into chunks of MMAP_CHUNK_SIZE and maps the first one.
+		* Sets error and returns false on failure. */
+		bool map(CLuceneError& error){
+			numChunks = (int32_t)((_length + MMAP_CHUNK_SIZE - 1) >> LUCENE_MMAP_CHUNK_POWER);
+			if ( numChunks == 0 )
+				numChunks = 1; //an empty file has one empty chunk, so seek(0) is valid
+			chunks = _CL_NEWARRAY(uint8_t*, numChunks);
+			chunkLengths = _CL_NEWARRAY(int64_t, numChunks);
+			chunkUsers = _CL_NEWARRAY(int32_t, numChunks);
+			for ( int32_t i=0;i<numChunks;i++ ){
+				chunks[i] = NULL;
+				chunkLengths[i] = cl_max((int64_t)0, cl_min(MMAP_CHUNK_SIZE, _length - (((int64_t)i) << LUCENE_MMAP_CHUNK_POWER)));
+				chunkUsers[i] = 0;
+			}
+			//fail on open rather than on the first read if the file cannot be mapped
+			return mapChunk(0, error);
+		}
+
+		bool mapChunk(int32_t c, CLuceneError& error){
+			if ( chunks[c] != NULL || chunkLengths[c] == 0 )
+				return true;
+			const int64_t offset = ((int64_t)c) << LUCENE_MMAP_CHUNK_POWER;
+#if defined(_CL_HAVE_FUNCTION_MAPVIEWOFFILE)
+			void* address = MapViewOfFile(mmaphandle, FILE_MAP_READ,
+				(_cl_dword_t)(offset >> 32), (_cl_dword_t)(offset & 0xFFFFFFFF), (SIZE_T)chunkLengths[c]);
+			if ( address == NULL ){
+				setError(error, GetLastError());
+				return false;
+			}
 #else
-        #error no mmap implementation set
+			void* address = ::mmap(0, (size_t)chunkLengths[c], PROT_READ, MAP_SHARED, fhandle, (off_t)offset);
+			if ( address == MAP_FAILED ){
+				setError(error, errno);
+				return false;
+			}
+#endif
+			chunks[c] = (uint8_t*)address;
+			advise(chunks[c], chunkLengths[c], pattern);
+			return true;
+		}
+
+		void unmapChunk(int32_t c){
+			if ( chunks[c] == NULL )
+				return;
+#if defined(_CL_HAVE_FUNCTION_MAPVIEWOFFILE)
+			if ( ! UnmapViewOfFile(chunks[c]) ){
+				CND_PRECONDITION( false,L"UnmapViewOfFile(data) failed"); //todo: change to rich error
+			}
+#else
+			::munmap(chunks[c], (size_t)chunkLengths[c]);
+#endif
+			chunks[c] = NULL;
+		}
+
+		/** Returns chunk c, mapping it if needed. It stays mapped until the
+		* input passes it to release(). */
+		const uint8_t* acquire(int32_t c){
+			CLuceneError error;
+			{
+				SCOPED_LOCK_MUTEX(THIS_LOCK)
+				if ( mapChunk(c, error) ){
+					chunkUsers[c]++;
+					return chunks[c];
+				}
+			}
+			throw error;
+		}
+
+		/** Unmaps idle chunks once more than LUCENE_MMAP_MAX_IDLE_CHUNKS are
+		* left, chunk c, the one last used, going last */
+		void release(int32_t c){
+			SCOPED_LOCK_MUTEX(THIS_LOCK)
+			if ( --chunkUsers[c] > 0 )
+				return;
+			int32_t idle = 0;
+			for ( int32_t i=0;i<numChunks;i++ ){
+				if ( chunks[i] != NULL && chunkUsers[i] == 0 )
+					idle++;
+			}
+			for ( int32_t i=0;i<numChunks && idle > LUCENE_MMAP_MAX_IDLE_CHUNKS;i++ ){
+				if ( i != c && chunks[i] != NULL && chunkUsers[i] == 0 ){
+					unmapChunk(i);
+					idle--;
+				}
+			}
+			if ( idle > LUCENE_MMAP_MAX_IDLE_CHUNKS )
+				unmapChunk(c);
+		}
+
+		static void advise(uint8_t* address, int64_t len, IndexInput::AccessPattern pattern){
+#if defined(_CL_HAVE_FUNCTION_MMAP) && defined(POSIX_MADV_NORMAL)
+			int advice = POSIX_MADV_NORMAL;
+			if ( pattern == IndexInput::ACCESS_RANDOM )
+				advice = POSIX_MADV_RANDOM;
+			else if ( pattern == IndexInput::ACCESS_SEQUENTIAL )
+				advice = POSIX_MADV_SEQUENTIAL;
+			::posix_madvise(address, (size_t)len, advice); //only a hint, failure is harmless
 #endif
-		bool isClone;
+		}
+
+		/** Asks the OS to read [offset, offset+len) of a mapped chunk soon.
+		* Unlike advise() this leaves the other inputs of the mapping alone. */
+		static void willNeed(uint8_t* address, int64_t offset, int64_t len){
+#if defined(_CL_HAVE_FUNCTION_MMAP) && defined(POSIX_MADV_WILLNEED)
+			//the address must be page aligned, 64k covers the usual page sizes
+			const int64_t aligned = offset & ~((int64_t)0xFFFF);
+			::posix_madvise(address + aligned, (size_t)(offset + len - aligned), POSIX_MADV_WILLNEED);
+#endif
+		}
+
+		static void setError(CLuceneError& error, int errnum){
+			char* lpMsgBuf=strerror(errnum);
+			size_t len = strlen(lpMsgBuf)+80;
+			char* errstr = _CL_NEWARRAY(char, len);
+			cl_sprintf(errstr, len, "MMapIndexInput::MMapIndexInput failed with error %d: %s", errnum, lpMsgBuf);
+			error.set(CL_ERR_IO, errstr);
+			_CLDELETE_CaARRAY(errstr);
+		}
+    };
+
+    class MMapIndexInput::Internal: LUCENE_BASE{
+	public:
+		MappedFile* file;
+		int32_t chunk;        ///< index of the chunk holding the current position
+		bool acquired;        ///< whether chunk was acquired from file
+		uint8_t* data;        ///< the current chunk
+		int64_t pos;          ///< position in the current chunk
+		int64_t chunkLength;  ///< the readable length of the current chunk, up to the end of the read-ahead window
 		int64_t _length;
-		
+		bool sequential;      ///< read ahead in windows of MMAP_READAHEAD_SIZE
+
 		Internal():
-    		data(NULL),
-    		pos(0),
-    		isClone(false),
-    		_length(0)
-    	{
-    	}
-        ~Internal(){
-        }
+			file(NULL),
+			chunk(0),
+			acquired(false),
+			data(NULL),
+			pos(0),
+			chunkLength(0),
+			_length(0),
+			sequential(false)
+		{
+		}
+		~Internal(){
+		}
+		void setChunk(int32_t c){
+			uint8_t* d = (uint8_t*)file->acquire(c);
+			if ( acquired )
+				file->release(chunk);
+			acquired = true;
+			chunk = c;
+			data = d;
+			chunkLength = file->chunkLengths[c];
+		}
+		void releaseChunk(){
+			if ( acquired )
+				file->release(chunk);
+			acquired = false;
+			data = NULL;
+			chunkLength = 0;
+		}
+		/** Sets chunkLength to the end of the chunk, or of the window ahead
+		* of pos which the OS was asked to read */
+		void window(){
+			chunkLength = file->chunkLengths[chunk];
+			if ( sequential && pos < chunkLength ){
+				chunkLength = cl_min(chunkLength, pos + MMAP_READAHEAD_SIZE);
+				MappedFile::willNeed(data, pos, chunkLength - pos);
+			}
+		}
     };
 
 	MMapIndexInput::MMapIndexInput(Internal* __internal):
 	    _internal(__internal)
 	{
   }
-  
-  bool MMapIndexInput::open(const char* path, IndexInput*& ret, CLuceneError& error, int32_t __bufferSize )    {
+
+  MMapIndexInput::AccessPattern MMapIndexInput::defaultAccessPattern(const wchar_t* path){
+	  const wchar_t* ext = wcsrchr(path, L'.');
+	  if ( ext == NULL )
+		  return ACCESS_NORMAL;
+	  ext++;
+	  //files that are searched (term dictionary) or looked up by document number
+	  if ( wcscmp(ext, L"tis") == 0 || wcscmp(ext, L"fdx") == 0 || wcscmp(ext, L"fdt") == 0 ||
+		  wcscmp(ext, L"tvx") == 0 || wcscmp(ext, L"tvd") == 0 || wcscmp(ext, L"tvf") == 0 )
+		  return ACCESS_RANDOM;
+	  //files that are read once, front to back, when the reader is opened
+	  if ( wcscmp(ext, L"tii") == 0 || wcscmp(ext, L"nrm") == 0 || wcscmp(ext, L"fnm") == 0 ||
+		  wcscmp(ext, L"del") == 0 )
+		  return ACCESS_SEQUENTIAL;
+	  //postings and compound files keep the default readahead
+	  return ACCESS_NORMAL;
+  }
+
+  bool MMapIndexInput::open(const wchar_t* path, IndexInput*& ret, CLuceneError& error, int32_t /*__bufferSize*/ )    {
 
 	//Func - Constructor.
 	//       Opens the file named path
@@ -81,14 +307,15 @@ CL_NS_USE(util)
 
 	  CND_PRECONDITION(path != NULL, L"path is NULL");
 
-    Internal* _internal = _CLNEW Internal;
+    MappedFile* file = _CLNEW MappedFile;
+    file->pattern = defaultAccessPattern(path);
+    bool mapped = false;
 
 #if defined(_CL_HAVE_FUNCTION_MAPVIEWOFFILE)
-	  _internal->mmaphandle = NULL;
-	  _internal->fhandle = CreateFileA(path,GENERIC_READ,FILE_SHARE_READ, 0,OPEN_EXISTING,0,0);
-	  
+	  file->fhandle = CreateFileW(path,GENERIC_READ,FILE_SHARE_READ, 0,OPEN_EXISTING,0,0);
+
 	  //Check if a valid fhandle was retrieved
-	  if (_internal->fhandle < 0){
+	  if (file->fhandle == INVALID_HANDLE_VALUE){
 		_cl_dword_t err = GetLastError();
         if ( err == ERROR_FILE_NOT_FOUND )
         error.set(CL_ERR_IO, "File does not exist");
@@ -98,112 +325,164 @@ CL_NS_USE(util)
         error.set(CL_ERR_IO, "Too many open files");
 		else
           error.set(CL_ERR_IO, "Could not open file");
-	  }
+	  }else{
+		_cl_dword_t high=0;
+		_cl_dword_t low = GetFileSize(file->fhandle, &high);
+		file->_length = (((int64_t)high) << 32) | low;
 
-	  _cl_dword_t dummy=0;
-	  _internal->_length = GetFileSize(_internal->fhandle, &dummy);
-
-	  if ( _internal->_length > 0 ){
-			_internal->mmaphandle = CreateFileMappingA(_internal->fhandle,NULL,PAGE_READONLY,0,0,NULL);
-			if ( _internal->mmaphandle != NULL ){
-				void* address = MapViewOfFile(_internal->mmaphandle,FILE_MAP_READ,0,0,0);
-				if ( address != NULL ){
-					_internal->data = (uint8_t*)address;
-          ret = _CLNEW MMapIndexInput(_internal);
-          return true;
-				}
-			}
-			
-			//failure:
-			int errnum = GetLastError(); 
-			
-			CloseHandle(_internal->mmaphandle);
-	
-			char* lpMsgBuf=strerror(errnum);
-			size_t len = strlen(lpMsgBuf)+80;
-			char* errstr = _CL_NEWARRAY(char, len); 
-			cl_sprintf(errstr, len, "MMapIndexInput::MMapIndexInput failed with error %d: %s", errnum, lpMsgBuf); 
-	
-	    error.set(CL_ERR_IO, errstr);
-			_CLDELETE_CaARRAY(errstr);
+		if ( file->_length > 0 ){
+			file->mmaphandle = CreateFileMappingA(file->fhandle,NULL,PAGE_READONLY,0,0,NULL);
+			if ( file->mmaphandle == NULL )
+				MappedFile::setError(error, GetLastError());
+		}
+		if ( file->_length == 0 || file->mmaphandle != NULL )
+			mapped = file->map(error);
 	  }
 
 #else //_CL_HAVE_FUNCTION_MAPVIEWOFFILE
-     _internal->fhandle = ::_cl_open (path, _O_BINARY | O_RDONLY | _O_RANDOM, _S_IREAD);
-  	 if (_internal->fhandle < 0){
+     file->fhandle = ::open(Misc::toString(path).c_str(), O_RDONLY);
+  	 if (file->fhandle < 0){
 	    error.set(CL_ERR_IO, strerror(errno));
   	 }else{
 		// stat it
 		struct stat sb;
-		if (::fstat (_internal->fhandle, &sb)){
+		if (::fstat (file->fhandle, &sb)){
 	    error.set(CL_ERR_IO, strerror(errno));
 		}else{
 			// get length from stat
-			_internal->_length = sb.st_size;
-			
-			// mmap the file
-			void* address = ::mmap(0, _internal->_length, PROT_READ, MAP_SHARED, _internal->fhandle, 0);
-			if (address == MAP_FAILED){
-				error.set(CL_ERR_IO, strerror(errno));
-			}else{
-				_internal->data = (uint8_t*)address;
-        ret = _CLNEW MMapIndexInput(_internal);
-        return true;
-			}
+			file->_length = sb.st_size;
+			mapped = file->map(error);
 		}
   	 }
 #endif
 
-    _CLDELETE(_internal);
+    if ( mapped ){
+		Internal* _internal = _CLNEW Internal;
+		_internal->file = file;
+		_internal->_length = file->_length;
+		_internal->setChunk(0);
+		ret = _CLNEW MMapIndexInput(_internal);
+		return true;
+    }
+    _CLDECDELETE(file);
     return false;
   }
 
   MMapIndexInput::MMapIndexInput(const MMapIndexInput& clone): IndexInput(clone){
   //Func - Constructor
   //       Uses clone for its initialization
-  //Pre  - clone is a valide instance of FSIndexInput
-  //Post - The instance has been created and initialized by clone
+  //Pre  - clone is a valide instance of MMapIndexInput
+  //Post - The instance has been created and initialized by clone.
+  //       Only the position is copied, the mapping itself is shared,
+  //       and the clone starts without the read-ahead of a sequential input
+        if ( clone._internal->file == NULL )
+          _CLTHROWA(CL_ERR_IO, "MMapIndexInput already closed");
         _internal = _CLNEW Internal;
-        
-#if defined(_CL_HAVE_FUNCTION_MAPVIEWOFFILE)
-	  _internal->mmaphandle = NULL;
-	  _internal->fhandle = NULL;
-#endif
 
-	  _internal->data = clone._internal->data;
+	  _internal->file = _CL_POINTER(clone._internal->file);
+	  _internal->_length = clone._internal->_length;
+	  _internal->setChunk(clone._internal->chunk);
 	  _internal->pos = clone._internal->pos;
+  }
 
-	  //clone the file length
-	  _internal->_length  = clone._internal->_length;
-	  //Keep in mind that this instance is a clone
-	  _internal->isClone = true;
+  void MMapIndexInput::nextChunk(){
+	  if ( _internal->file == NULL )
+		  _CLTHROWA(CL_ERR_IO, "MMapIndexInput already closed");
+	  if ( _internal->pos >= _internal->file->chunkLengths[_internal->chunk] ){
+		  if ( _internal->chunk + 1 >= _internal->file->numChunks )
+			  _CLTHROWA(CL_ERR_IO, "read past EOF");
+		  _internal->setChunk(_internal->chunk + 1);
+		  _internal->pos = 0;
+	  }
+	  //else the end of the read-ahead window was reached
+	  _internal->window();
   }
 
   uint8_t MMapIndexInput::readByte(){
-	  return *(_internal->data+(_internal->pos++));
+	  if ( _internal->pos >= _internal->chunkLength )
+		  nextChunk();
+	  return _internal->data[_internal->pos++];
   }
 
   void MMapIndexInput::readBytes(uint8_t* b, const int32_t len){
-	memcpy(b, _internal->data+_internal->pos, len);
-	_internal->pos+=len;
+	int64_t available = _internal->chunkLength - _internal->pos;
+	if ( len <= available ){
+		memcpy(b, _internal->data+_internal->pos, len);
+		_internal->pos+=len;
+		return;
+	}
+	//the read crosses a chunk boundary
+	int32_t remaining = len;
+	while ( remaining > 0 ){
+		if ( _internal->pos >= _internal->chunkLength )
+			nextChunk();
+		int32_t n = (int32_t)cl_min((int64_t)remaining, _internal->chunkLength - _internal->pos);
+		memcpy(b, _internal->data+_internal->pos, n);
+		_internal->pos += n;
+		b += n;
+		remaining -= n;
+	}
   }
   int32_t MMapIndexInput::readVInt(){
-	  uint8_t b = *(_internal->data+(_internal->pos++));
+	  if ( _internal->chunkLength - _internal->pos < 5 ){
+		  //near the end of a chunk, go through readByte() which can move to the next one
+		  return IndexInput::readVInt();
+	  }
+	  const uint8_t* p = _internal->data+_internal->pos;
+	  uint8_t b = *p++;
 	  int32_t i = b & 0x7F;
 	  for (int shift = 7; (b & 0x80) != 0; shift += 7) {
-	    b = *(_internal->data+(_internal->pos++));
+	    b = *p++;
 	    i |= (b & 0x7F) << shift;
 	  }
+	  _internal->pos = p - _internal->data;
 	  return i;
   }
+  const uint8_t* MMapIndexInput::bufferedBytes(int32_t& length){
+	  if ( _internal->pos >= _internal->chunkLength ){
+		  if ( getFilePointer() >= _internal->_length ){
+			  length = 0;
+			  return NULL;
+		  }
+		  nextChunk();
+	  }
+	  length = (int32_t)(_internal->chunkLength - _internal->pos);
+	  return _internal->data + _internal->pos;
+  }
+  void MMapIndexInput::consumeBufferedBytes(const int32_t len){
+	  CND_PRECONDITION(len >= 0 && _internal->pos + len <= _internal->chunkLength, "consuming more than was mapped");
+	  _internal->pos += len;
+  }
   int64_t MMapIndexInput::getFilePointer() const{
-	return _internal->pos;
+	return (((int64_t)_internal->chunk) << LUCENE_MMAP_CHUNK_POWER) + _internal->pos;
   }
   void MMapIndexInput::seek(const int64_t pos){
-	  this->_internal->pos=pos;
+	  if ( _internal->file == NULL )
+		  _CLTHROWA(CL_ERR_IO, "MMapIndexInput already closed");
+	  if ( pos < 0 || pos > _internal->_length )
+		  _CLTHROWA(CL_ERR_IO, "Seeking out of range");
+	  int32_t c = (int32_t)(pos >> LUCENE_MMAP_CHUNK_POWER);
+	  if ( c >= _internal->file->numChunks ){
+		  //seek to EOF of a file that exactly fills its last chunk
+		  c = _internal->file->numChunks - 1;
+	  }
+	  if ( c != _internal->chunk )
+		  _internal->setChunk(c);
+	  _internal->pos = pos - (((int64_t)c) << LUCENE_MMAP_CHUNK_POWER);
+	  _internal->window();
   }
   int64_t MMapIndexInput::length() const{ return _internal->_length; }
 
+  void MMapIndexInput::setAccessPattern(AccessPattern pattern){
+	  //the mapping is shared with the clones, so it keeps the hint it was
+	  //opened with. A sequential input asks for the window ahead of it instead
+#if defined(_CL_HAVE_FUNCTION_MMAP) && defined(POSIX_MADV_WILLNEED)
+	  _internal->sequential = (pattern == ACCESS_SEQUENTIAL);
+	  if ( _internal->file != NULL )
+		  _internal->window();
+#endif
+  }
+
   MMapIndexInput::~MMapIndexInput(){
   //Func - Destructor
   //Pre  - True
@@ -219,35 +498,11 @@ CL_NS_USE(util)
     return _CLNEW MMapIndexInput(*this);
   }
   void MMapIndexInput::close()  {
-	if ( !_internal->isClone ){
-#if defined(_CL_HAVE_FUNCTION_MAPVIEWOFFILE)
-		if ( _internal->data != NULL ){
-			if ( ! UnmapViewOfFile(_internal->data) ){
-				CND_PRECONDITION( false,L"UnmapViewOfFile(data) failed"); //todo: change to rich error
-			}
-		}
-
-		if ( _internal->mmaphandle != NULL ){
-			if ( ! CloseHandle(_internal->mmaphandle) ){
-				CND_PRECONDITION( false, L"CloseHandle(mmaphandle) failed");
-			}
-		}
-		if ( _internal->fhandle != NULL ){
-			if ( !CloseHandle(_internal->fhandle) ){
-				CND_PRECONDITION( false, L"CloseHandle(fhandle) failed");
-			}
-		}
-		_internal->mmaphandle = NULL;
-		_internal->fhandle = NULL;
-#else
-		if ( _internal->data != NULL )
-	  		::munmap(_internal->data, _internal->_length);
-	  	if ( _internal->fhandle > 0 )
-	  		::close(_internal->fhandle);
-	  	_internal->fhandle = 0;
-#endif
-	}
-	_internal->data = NULL;
+	//the mapping is released when the last clone lets go of it
+	if ( _internal->file != NULL )
+		_internal->releaseChunk();
+	_CLDECDELETE(_internal->file);
+	_internal->chunk = 0;
 	_internal->pos = 0;
   }
 
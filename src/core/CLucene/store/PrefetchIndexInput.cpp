@@ -0,0 +1,403 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "CLucene/_ApiHeader.h"
+#include "PrefetchIndexInput.h"
+#include <list>
+#include <map>
+#include <vector>
+
+CL_NS_DEF(store)
+
+/** The chunks form a ring. The caller holds the chunk current, the chunks
+* first, first+1, ... (filled of them) have been read ahead, and a worker
+* reads into the chunk after those. So a worker never writes to a chunk the
+* caller can see. All of it is guarded by PrefetchWorkers::LOCK.
+*/
+class PrefetchIndexInput::Internal{
+public:
+	IndexInput* in;
+	int64_t length;
+	int32_t chunkSize;
+	int32_t chunks;
+	uint8_t** buffers;
+	int64_t* starts;
+	int32_t* lengths;
+
+	int32_t current;
+	int32_t first;
+	int32_t filled;
+	int64_t readPos;    //where the next chunk is read from
+	int32_t generation; //changes whenever reading ahead restarts, so a chunk that was being read is dropped
+	bool reading;       //a worker is using in, only clone or close it when this is false
+	bool registered;    //the workers read ahead for this input
+	bool failed;
+	CLuceneError error;
+
+	Internal(IndexInput* _in, int32_t _chunkSize, int32_t _chunks):
+		in(_in),
+		length(_in->length()),
+		chunkSize(_chunkSize),
+		chunks(_chunks),
+		current(_chunks - 1),
+		first(0),
+		filled(0),
+		readPos(0),
+		generation(0),
+		reading(false),
+		registered(false),
+		failed(false)
+	{
+		buffers = _CL_NEWARRAY(uint8_t*, chunks);
+		starts = _CL_NEWARRAY(int64_t, chunks);
+		lengths = _CL_NEWARRAY(int32_t, chunks);
+		for ( int32_t i=0;i<chunks;i++ ){
+			buffers[i] = _CL_NEWARRAY(uint8_t, chunkSize);
+			starts[i] = 0;
+			lengths[i] = 0;
+		}
+	}
+	~Internal(){
+		for ( int32_t i=0;i<chunks;i++ )
+			_CLDELETE_ARRAY(buffers[i]);
+		_CLDELETE_ARRAY(buffers);
+		_CLDELETE_ARRAY(starts);
+		_CLDELETE_ARRAY(lengths);
+	}
+
+	bool needsRead() const{
+		return !reading && !failed && filled < chunks - 1 && readPos < length;
+	}
+
+	/** drops what was read ahead and continues at pos. Must hold the lock */
+	void restart(int64_t pos);
+
+	/** hands the oldest chunk read ahead to the caller. Must hold the lock */
+	void take();
+};
+
+/** The threads which read ahead for all PrefetchIndexInputs, at most
+* LUCENE_PREFETCH_THREADS of them, so that the number of threads does not grow
+* with the number of inputs read at once. They take turns between the inputs
+* one chunk at a time, are started when an input first needs them and exit
+* once no input is left. The last input to close joins them.
+*/
+class PrefetchWorkers{
+public:
+	DEFINE_MUTEX(LOCK)
+	DEFINE_CONDITION(WAIT_CONDITION)
+	std::list<PrefetchIndexInput::Internal*> inputs;
+	int32_t running;
+	std::vector<_LUCENE_THREADID_TYPE> exited; //workers which exited but were not joined yet
+	std::map<int32_t, _LUCENE_THREADID_TYPE> threads;
+	int32_t nextSlot;
+
+	PrefetchWorkers(): running(0), nextSlot(0){
+	}
+
+	/** Starts reading ahead for in. Must hold LOCK */
+	void add(PrefetchIndexInput::Internal* in){
+		inputs.push_back(in);
+		in->registered = true;
+		if ( running < LUCENE_PREFETCH_THREADS ){
+			joinExited();
+			running++;
+			//the worker can't exit before the lock is let go of, so its id
+			//is in threads by then
+			const int32_t slot = nextSlot++;
+			threads[slot] = _LUCENE_THREAD_CREATE(&run, (void*)(intptr_t)slot);
+		}
+		CONDITION_NOTIFYALL(WAIT_CONDITION)
+	}
+
+	/** Stops reading ahead for in once the chunk being read for it is done.
+	* Returns the workers to join if in was the last input. Must hold LOCK */
+	void remove(PrefetchIndexInput::Internal* in, std::vector<_LUCENE_THREADID_TYPE>& toJoin){
+		while ( in->reading ){
+			CONDITION_WAIT(LOCK, WAIT_CONDITION)
+		}
+		if ( !in->registered )
+			return;
+		inputs.remove(in);
+		in->registered = false;
+		CONDITION_NOTIFYALL(WAIT_CONDITION)
+		while ( inputs.empty() && running > 0 ){
+			CONDITION_WAIT(LOCK, WAIT_CONDITION)
+		}
+		if ( inputs.empty() ){
+			toJoin.insert(toJoin.end(), exited.begin(), exited.end());
+			exited.clear();
+		}
+	}
+
+	/** the exited workers have let go of the lock for good, so they can be
+	* joined while holding it */
+	void joinExited(){
+		for ( size_t i=0;i<exited.size();i++ )
+			_LUCENE_THREAD_JOIN(exited[i]);
+		exited.clear();
+	}
+
+	static void __cdecl run(void* arg);
+};
+static PrefetchWorkers workers;
+
+void PrefetchIndexInput::Internal::restart(int64_t pos){
+	generation++;
+	first = (current + 1) % chunks;
+	filled = 0;
+	readPos = pos;
+	failed = false;
+	CONDITION_NOTIFYALL(workers.WAIT_CONDITION)
+}
+
+void PrefetchIndexInput::Internal::take(){
+	current = first;
+	first = (first + 1) % chunks;
+	filled--;
+	CONDITION_NOTIFYALL(workers.WAIT_CONDITION)
+}
+
+void PrefetchWorkers::run(void* arg){
+	const int32_t slot = (int32_t)(intptr_t)arg;
+	while ( true ){
+		PrefetchIndexInput::Internal* in = NULL;
+		int32_t chunk;
+		int64_t pos;
+		int32_t len;
+		int32_t gen;
+		{
+			SCOPED_LOCK_MUTEX(workers.LOCK)
+			while ( in == NULL ){
+				std::list<PrefetchIndexInput::Internal*>::iterator itr = workers.inputs.begin();
+				for ( ; itr != workers.inputs.end(); ++itr ){
+					if ( (*itr)->needsRead() ){
+						in = *itr;
+						//take turns, the others go first next time
+						workers.inputs.splice(workers.inputs.end(), workers.inputs, itr);
+						break;
+					}
+				}
+				if ( in != NULL )
+					break;
+				if ( workers.inputs.empty() ){
+					workers.running--;
+					workers.exited.push_back(workers.threads[slot]);
+					workers.threads.erase(slot);
+					CONDITION_NOTIFYALL(workers.WAIT_CONDITION)
+					return;
+				}
+				CONDITION_WAIT(workers.LOCK, workers.WAIT_CONDITION)
+			}
+			chunk = (in->first + in->filled) % in->chunks;
+			pos = in->readPos;
+			len = (int32_t)cl_min((int64_t)in->chunkSize, in->length - pos);
+			gen = in->generation;
+			in->reading = true;
+		}
+
+		//read without the lock, the callers and the other workers keep going
+		CLuceneError err;
+		bool ok = true;
+		try{
+			in->in->seek(pos);
+			in->in->readBytes(in->buffers[chunk], len);
+		}catch(CLuceneError& e){
+			err.set(e.number(), e.twhat());
+			ok = false;
+		}
+
+		SCOPED_LOCK_MUTEX(workers.LOCK)
+		in->reading = false;
+		CONDITION_NOTIFYALL(workers.WAIT_CONDITION)
+		if ( gen != in->generation )
+			continue; //the caller seeked elsewhere meanwhile
+		if ( ok ){
+			in->starts[chunk] = pos;
+			in->lengths[chunk] = len;
+			in->filled++;
+			in->readPos = pos + len;
+		}else{
+			in->error.set(err.number(), err.twhat());
+			in->failed = true;
+		}
+	}
+}
+
+
+PrefetchIndexInput::PrefetchIndexInput(IndexInput* in, int32_t chunkSize, int32_t chunks):
+	_internal(NULL),
+	chunk(NULL),
+	chunkLength(0),
+	chunkPosition(0)
+{
+	if ( in == NULL )
+		_CLTHROWA(CL_ERR_NullPointer, "in is NULL");
+	if ( chunkSize <= 0 || chunks < 2 )
+		_CLTHROWA(CL_ERR_IllegalArgument, "PrefetchIndexInput needs at least 2 chunks of at least 1 byte");
+	_internal = _CLNEW Internal(in, chunkSize, chunks);
+	_length = _internal->length;
+	chunkStart = in->getFilePointer();
+	_internal->readPos = chunkStart;
+}
+
+PrefetchIndexInput::PrefetchIndexInput(const PrefetchIndexInput& other):
+	IndexInput(other),
+	_internal(NULL),
+	_length(other._length),
+	chunk(NULL),
+	chunkStart(other.getFilePointer()),
+	chunkLength(0),
+	chunkPosition(0)
+{
+	if ( other._internal == NULL )
+		_CLTHROWA(CL_ERR_IO, "PrefetchIndexInput already closed");
+	IndexInput* in;
+	{
+		//a worker moves the input of other around
+		SCOPED_LOCK_MUTEX(workers.LOCK)
+		while ( other._internal->reading ){
+			CONDITION_WAIT(workers.LOCK, workers.WAIT_CONDITION)
+		}
+		in = other._internal->in->clone();
+	}
+	_internal = _CLNEW Internal(in, other._internal->chunkSize, other._internal->chunks);
+	_internal->readPos = chunkStart;
+}
+
+PrefetchIndexInput::~PrefetchIndexInput(){
+	close();
+}
+
+IndexInput* PrefetchIndexInput::clone() const{
+	return _CLNEW PrefetchIndexInput(*this);
+}
+
+void PrefetchIndexInput::close(){
+	if ( _internal == NULL )
+		return;
+	std::vector<_LUCENE_THREADID_TYPE> toJoin;
+	{
+		SCOPED_LOCK_MUTEX(workers.LOCK)
+		workers.remove(_internal, toJoin);
+	}
+	for ( size_t i=0;i<toJoin.size();i++ )
+		_LUCENE_THREAD_JOIN(toJoin[i]);
+
+	_internal->in->close();
+	_CLDELETE(_internal->in);
+	_CLDELETE(_internal);
+	chunk = NULL;
+	chunkLength = 0;
+	chunkPosition = 0;
+}
+
+void PrefetchIndexInput::nextChunk(){
+	const int64_t pos = chunkStart + chunkLength;
+	if ( pos >= _length )
+		_CLTHROWA(CL_ERR_IO, "read past EOF");
+	if ( _internal == NULL )
+		_CLTHROWA(CL_ERR_IO, "PrefetchIndexInput already closed");
+
+	SCOPED_LOCK_MUTEX(workers.LOCK)
+	if ( !_internal->registered )
+		workers.add(_internal);
+	if ( _internal->filled > 0 ? _internal->starts[_internal->first] != pos : _internal->readPos != pos )
+		_internal->restart(pos);
+
+	while ( _internal->filled == 0 && !_internal->failed ){
+		CONDITION_WAIT(workers.LOCK, workers.WAIT_CONDITION)
+	}
+	if ( _internal->filled == 0 ){
+		CLuceneError err(_internal->error);
+		throw err;
+	}
+
+	_internal->take();
+	chunk = _internal->buffers[_internal->current];
+	chunkStart = pos;
+	chunkLength = _internal->lengths[_internal->current];
+	chunkPosition = 0;
+}
+
+void PrefetchIndexInput::readBytes(uint8_t* b, const int32_t len){
+	int32_t done = 0;
+	while ( done < len ){
+		if ( chunkPosition >= chunkLength )
+			nextChunk();
+		const int32_t n = cl_min(len - done, chunkLength - chunkPosition);
+		memcpy(b + done, chunk + chunkPosition, n);
+		chunkPosition += n;
+		done += n;
+	}
+}
+
+int64_t PrefetchIndexInput::getFilePointer() const{
+	return chunkStart + chunkPosition;
+}
+
+void PrefetchIndexInput::seek(const int64_t pos){
+	if ( pos < 0 )
+		_CLTHROWA(CL_ERR_IO, "IO Argument Error. Value must be a positive value.");
+	if ( pos >= chunkStart && pos < chunkStart + chunkLength ){
+		chunkPosition = (int32_t)(pos - chunkStart);
+		return;
+	}
+	if ( _internal == NULL )
+		_CLTHROWA(CL_ERR_IO, "PrefetchIndexInput already closed");
+
+	SCOPED_LOCK_MUTEX(workers.LOCK)
+	//skip the chunks read ahead that lie before pos
+	while ( _internal->filled > 0 ){
+		const int64_t start = _internal->starts[_internal->first];
+		if ( pos < start )
+			break;
+		_internal->take();
+		if ( pos < start + _internal->lengths[_internal->current] ){
+			chunk = _internal->buffers[_internal->current];
+			chunkStart = start;
+			chunkLength = _internal->lengths[_internal->current];
+			chunkPosition = (int32_t)(pos - start);
+			return;
+		}
+	}
+	//the next chunk being read starts at pos, wait for it instead of reading it again
+	if ( _internal->filled > 0 || pos != _internal->readPos )
+		_internal->restart(pos);
+	chunk = NULL;
+	chunkStart = pos;
+	chunkLength = 0;
+	chunkPosition = 0;
+}
+
+int64_t PrefetchIndexInput::length() const{
+	return _length;
+}
+
+const uint8_t* PrefetchIndexInput::bufferedBytes(int32_t& length){
+	if ( chunkPosition >= chunkLength ){
+		if ( getFilePointer() >= _length ){
+			length = 0; // EOF, let the caller throw
+			return NULL;
+		}
+		nextChunk();
+	}
+	length = chunkLength - chunkPosition;
+	return chunk + chunkPosition;
+}
+
+void PrefetchIndexInput::consumeBufferedBytes(const int32_t len){
+	CND_PRECONDITION(len >= 0 && chunkPosition + len <= chunkLength, "consuming more than was buffered");
+	chunkPosition += len;
+}
+
+const std::wstring PrefetchIndexInput::getDirectoryType() const{
+	return _internal == NULL ? L"" : _internal->in->getDirectoryType();
+}
+
+CL_NS_END
@@ -0,0 +1,77 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#ifndef _lucene_store_PrefetchIndexInput_
+#define _lucene_store_PrefetchIndexInput_
+
+#include "IndexInput.h"
+
+CL_NS_DEF(store)
+
+/** An IndexInput that reads another input ahead of its caller on a
+* background thread. While the caller consumes one chunk, the following
+* chunks are read, so an input that is read front to back does not wait
+* for the disk on every buffer refill. All inputs share at most
+* LUCENE_PREFETCH_THREADS threads, which take turns reading a chunk for
+* each of them.
+*
+* Seeking within the chunks that have been read is cheap, any other seek
+* starts reading ahead again from the new position. The wrapped input is
+* only used by the background threads and is closed and deleted with this input.
+*
+* BufferedIndexInput uses this itself for inputs that are hinted with
+* IndexInput::ACCESS_SEQUENTIAL, which is how merges and compound file
+* copies read.
+*/
+class CLUCENE_EXPORT PrefetchIndexInput: public IndexInput {
+	class Internal;
+	Internal* _internal;
+	int64_t _length;
+	friend class PrefetchWorkers;
+
+	const uint8_t* chunk;   //the chunk the caller reads from, owned by _internal
+	int64_t chunkStart;     //position of chunk in the file
+	int32_t chunkLength;
+	int32_t chunkPosition;  //next byte to read in chunk
+
+	/** releases the current chunk and waits for the one at chunkStart + chunkLength */
+	void nextChunk();
+	PrefetchIndexInput(const PrefetchIndexInput& clone);
+public:
+	/**
+	* @param in the input to read ahead, this input takes ownership of it
+	* @param chunkSize number of bytes read at once
+	* @param chunks number of chunks, the caller holds one, the others are read ahead. At least 2.
+	*/
+	PrefetchIndexInput(IndexInput* in, int32_t chunkSize = LUCENE_PREFETCH_CHUNK_SIZE, int32_t chunks = LUCENE_PREFETCH_CHUNKS);
+	virtual ~PrefetchIndexInput();
+
+	/** Returns a PrefetchIndexInput over a clone of the wrapped input, at the same position */
+	IndexInput* clone() const;
+
+	inline uint8_t readByte(){
+		if (chunkPosition >= chunkLength)
+			nextChunk();
+		return chunk[chunkPosition++];
+	}
+	void readBytes(uint8_t* b, const int32_t len);
+	int64_t getFilePointer() const;
+	void seek(const int64_t pos);
+	int64_t length() const;
+	void close();
+
+	const uint8_t* bufferedBytes(int32_t& length);
+	void consumeBufferedBytes(const int32_t len);
+
+	const std::wstring getDirectoryType() const;
+	const std::wstring getObjectName() const { return getClassName(); }
+	static const std::wstring getClassName() { return L"PrefetchIndexInput"; }
+};
+
+CL_NS_END
+#endif
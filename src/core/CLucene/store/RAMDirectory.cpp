@@ -176,6 +176,25 @@ void RAMOutputStream::writeTo(IndexOutput* out)
     }
 }
 
+void RAMOutputStream::writeTo(uint8_t* bytes)
+{
+    flush();
+    const int64_t end = file->getLength();
+    int64_t pos = 0;
+    int32_t p = 0;
+    while (pos < end)
+    {
+        int32_t length = BUFFER_SIZE;
+        int64_t nextPos = pos + length;
+        if (nextPos > end)
+        {                        // at the last buffer
+            length = (int32_t) (end - pos);
+        }
+        memcpy(bytes + pos, file->getBuffer(p++), length);
+        pos = nextPos;
+    }
+}
+
 void RAMOutputStream::reset()
 {
     seek((int64_t) 0);
@@ -369,6 +388,28 @@ void RAMInputStream::readBytes(uint8_t* _dest, const int32_t _len)
 
 }
 
+const uint8_t* RAMInputStream::bufferedBytes(int32_t& length)
+{
+    if (bufferPosition >= bufferLength)
+    {
+        if (getFilePointer() >= _length)
+        {
+            length = 0;
+            return NULL;
+        }
+        currentBufferIndex++;
+        switchCurrentBuffer();
+    }
+    length = bufferLength - bufferPosition;
+    return currentBuffer + bufferPosition;
+}
+
+void RAMInputStream::consumeBufferedBytes(const int32_t len)
+{
+    assert(len >= 0 && bufferPosition + len <= bufferLength);
+    bufferPosition += len;
+}
+
 int64_t RAMInputStream::getFilePointer() const
 {
     return currentBufferIndex < 0 ? 0 : bufferStart + bufferPosition;
@@ -2,8 +2,8 @@
 * Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
 
 * Updated by https://github.com/farfella/.
-* 
-* Distributable under the terms of either the Apache License (Version 2.0) or 
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
 * the GNU Lesser General Public License, as specified in the COPYING file.
 ------------------------------------------------------------------------------*/
 #pragma once
@@ -14,30 +14,49 @@ namespace lucene {
 
     namespace store {
 
+        /**
+        * An IndexInput that reads a memory mapped file. Files are mapped in chunks
+        * of at most 2^LUCENE_MMAP_CHUNK_POWER bytes, so files larger than the
+        * address range a single mapping may cover (2GB on most 32 bit systems) can
+        * still be read. Chunks are mapped when an input first reads from them.
+        * Clones share the mapping and only carry their own position and access
+        * pattern, and the mapping is released when the last clone is closed.
+        */
         class MMapIndexInput : public IndexInput
         {
+            class MappedFile;
             class Internal;
             Internal* _internal;
 
             MMapIndexInput(const MMapIndexInput& clone);
             MMapIndexInput(Internal* _internal);
+            void nextChunk();
         public:
-            static bool open(const char* path, IndexInput*& ret, CLuceneError& error, int32_t __bufferSize);
+            static bool open(const wchar_t* path, IndexInput*& ret, CLuceneError& error, int32_t __bufferSize);
+
+            /**
+            * The access pattern a file is mapped with when nothing else is known
+            * about how it will be read, based on the extension of path.
+            */
+            static AccessPattern defaultAccessPattern(const wchar_t* path);
 
             ~MMapIndexInput();
             IndexInput* clone() const;
 
-            inline uint8_t readByte();
+            uint8_t readByte();
             int32_t readVInt();
             void readBytes(uint8_t* b, const int32_t len);
             void close();
             int64_t getFilePointer() const;
             void seek(const int64_t pos);
             int64_t length() const;
+            void setAccessPattern(AccessPattern pattern);
+            const uint8_t* bufferedBytes(int32_t& length);
+            void consumeBufferedBytes(const int32_t len);
 
             const std::wstring getObjectName() const { return MMapIndexInput::getClassName(); }
             static const std::wstring getClassName() { return L"MMapIndexInput"; }
             const std::wstring getDirectoryType() const { return L"MMapDirectory"; }
         };
     }
-}
\ No newline at end of file
+}
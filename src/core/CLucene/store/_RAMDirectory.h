@@ -100,6 +100,8 @@ public:
     void reset();
     /** Copy the current contents of this buffer to the named output. */
     void writeTo(IndexOutput* output);
+    /** Copy the current contents of this buffer to bytes, which must hold length() bytes. */
+    void writeTo(uint8_t* bytes);
 
     void writeByte(const uint8_t b);
     void writeBytes(const uint8_t* b, const int32_t len);
@@ -147,6 +149,8 @@ public:
 
     uint8_t readByte();
     void readBytes(uint8_t* dest, const int32_t len);
+    const uint8_t* bufferedBytes(int32_t& length);
+    void consumeBufferedBytes(const int32_t len);
 
     int64_t getFilePointer() const;
 
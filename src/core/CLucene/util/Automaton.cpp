@@ -0,0 +1,711 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "CLucene/_ApiHeader.h"
+#include "_Automaton.h"
+
+#include <map>
+#include <algorithm>
+
+CL_NS_DEF(util)
+
+Automaton::Automaton():
+	numClasses(0)
+{
+}
+Automaton::~Automaton(){
+}
+
+int32_t Automaton::createState(){
+	accepts.push_back(false);
+	transitions.push_back(std::vector<Transition>());
+	return (int32_t)accepts.size() - 1;
+}
+
+void Automaton::setAccept(const int32_t state, const bool accept){
+	accepts[state] = accept;
+}
+
+void Automaton::addTransition(const int32_t state, const wchar_t min, const wchar_t max, const int32_t dest){
+	CND_PRECONDITION(min >= MIN_CHAR && min <= max, L"invalid transition");
+	std::vector<Transition>& t = transitions[state];
+	CND_PRECONDITION(t.empty() || t.back().max < min, L"transitions added out of order");
+	// merge with the previous range if it is adjacent and goes to the same state
+	if ( !t.empty() && t.back().dest == dest && t.back().max + 1 == min ){
+		t.back().max = max;
+		return;
+	}
+	Transition tr;
+	tr.min = min;
+	tr.max = max;
+	tr.dest = dest;
+	t.push_back(tr);
+}
+
+void Automaton::finish(){
+	classStarts.clear();
+	classStarts.push_back(0);
+	for ( size_t s = 0; s < transitions.size(); s++ ){
+		for ( size_t i = 0; i < transitions[s].size(); i++ ){
+			classStarts.push_back(transitions[s][i].min);
+			classStarts.push_back((int64_t)transitions[s][i].max + 1);
+		}
+	}
+	std::sort(classStarts.begin(), classStarts.end());
+	classStarts.erase(std::unique(classStarts.begin(), classStarts.end()), classStarts.end());
+	numClasses = (int32_t)classStarts.size();
+
+	for ( int32_t c = 0, charClass = 0; c < LATIN1_CHARS; c++ ){
+		if ( charClass + 1 < numClasses && classStarts[charClass + 1] == c )
+			charClass++;
+		latin1Classes[c] = charClass;
+	}
+
+	table.assign(transitions.size() * numClasses, -1);
+	for ( size_t s = 0; s < transitions.size(); s++ ){
+		for ( size_t i = 0; i < transitions[s].size(); i++ ){
+			const Transition& t = transitions[s][i];
+			for ( int32_t charClass = getClass(t.min); charClass < numClasses && classStarts[charClass] <= t.max; charClass++ )
+				table[s * numClasses + charClass] = t.dest;
+		}
+	}
+}
+
+int32_t Automaton::getClass(const wchar_t c) const{
+	// the class of character 0 has no transitions, nor has any character below it
+	const int32_t charClass = (int32_t)(std::upper_bound(classStarts.begin(), classStarts.end(), (int64_t)c) - classStarts.begin()) - 1;
+	return cl_max(charClass, 0);
+}
+
+bool Automaton::run(const wchar_t* s, const size_t len) const{
+	int32_t state = 0;
+	for ( size_t i = 0; i < len; i++ ){
+		state = step(state, s[i]);
+		if ( state < 0 )
+			return false;
+	}
+	return accepts[state];
+}
+
+
+AutomatonBuilder::AutomatonBuilder(){
+}
+AutomatonBuilder::~AutomatonBuilder(){
+}
+
+int32_t AutomatonBuilder::createState(){
+	accepts.push_back(false);
+	transitions.push_back(std::vector<Automaton::Transition>());
+	epsilons.push_back(std::vector<int32_t>());
+	return (int32_t)accepts.size() - 1;
+}
+
+void AutomatonBuilder::setAccept(const int32_t state){
+	accepts[state] = true;
+}
+
+void AutomatonBuilder::addTransition(const int32_t state, const wchar_t min, const wchar_t max, const int32_t dest){
+	CND_PRECONDITION(min >= Automaton::MIN_CHAR && min <= max, L"invalid transition");
+	Automaton::Transition tr;
+	tr.min = min;
+	tr.max = max;
+	tr.dest = dest;
+	transitions[state].push_back(tr);
+}
+
+void AutomatonBuilder::addEpsilon(const int32_t state, const int32_t dest){
+	epsilons[state].push_back(dest);
+}
+
+void AutomatonBuilder::closure(std::vector<int32_t>& states) const{
+	std::vector<bool> seen(accepts.size(), false);
+	std::vector<int32_t> reached;
+	for ( size_t j = 0; j < states.size(); j++ ){
+		if ( !seen[states[j]] ){
+			seen[states[j]] = true;
+			reached.push_back(states[j]);
+		}
+	}
+	for ( size_t j = 0; j < reached.size(); j++ ){
+		const std::vector<int32_t>& e = epsilons[reached[j]];
+		for ( size_t l = 0; l < e.size(); l++ ){
+			if ( !seen[e[l]] ){
+				seen[e[l]] = true;
+				reached.push_back(e[l]);
+			}
+		}
+	}
+	std::sort(reached.begin(), reached.end());
+	states.swap(reached);
+}
+
+Automaton* AutomatonBuilder::determinize(const int32_t maxStates) const{
+	CND_PRECONDITION(!accepts.empty(), L"no initial state");
+
+	// every set of states of this automaton which can be in at once is a
+	// state of the deterministic automaton
+	std::map< std::vector<int32_t>, int32_t > numbers;
+	std::vector< std::vector<int32_t> > sets;
+	std::vector< std::vector<Automaton::Transition> > dfaTransitions;
+	std::vector<bool> dfaAccepts;
+	std::vector<int32_t> states(1, 0), to;
+	std::vector<int64_t> points;
+
+	closure(states);
+	numbers[states] = 0;
+	sets.push_back(states);
+	dfaTransitions.push_back(std::vector<Automaton::Transition>());
+	for ( size_t s = 0; s < sets.size(); s++ ){
+		states = sets[s];
+
+		// the characters at which a transition of a state of the set starts
+		// or ends split the characters into ranges treated the same
+		bool accept = false;
+		points.clear();
+		for ( size_t j = 0; j < states.size(); j++ ){
+			accept = accept || accepts[states[j]];
+			const std::vector<Automaton::Transition>& t = transitions[states[j]];
+			for ( size_t l = 0; l < t.size(); l++ ){
+				points.push_back(t[l].min);
+				points.push_back((int64_t)t[l].max + 1);
+			}
+		}
+		std::sort(points.begin(), points.end());
+		points.erase(std::unique(points.begin(), points.end()), points.end());
+		dfaAccepts.push_back(accept);
+
+		for ( size_t p = 0; p + 1 < points.size(); p++ ){
+			const wchar_t min = (wchar_t)points[p];
+			const wchar_t max = (wchar_t)(points[p + 1] - 1);
+			to.clear();
+			for ( size_t j = 0; j < states.size(); j++ ){
+				const std::vector<Automaton::Transition>& t = transitions[states[j]];
+				for ( size_t l = 0; l < t.size(); l++ ){
+					if ( t[l].min <= min && t[l].max >= max )
+						to.push_back(t[l].dest);
+				}
+			}
+			if ( to.empty() )
+				continue;
+			closure(to);
+
+			int32_t dest;
+			std::map< std::vector<int32_t>, int32_t >::iterator itr = numbers.find(to);
+			if ( itr != numbers.end() ){
+				dest = itr->second;
+			}else{
+				if ( (int32_t)numbers.size() >= maxStates )
+					return NULL;
+				dest = (int32_t)sets.size();
+				numbers[to] = dest;
+				sets.push_back(to);
+				dfaTransitions.push_back(std::vector<Automaton::Transition>());
+			}
+			Automaton::Transition tr;
+			tr.min = min;
+			tr.max = max;
+			tr.dest = dest;
+			dfaTransitions[s].push_back(tr);
+		}
+	}
+
+	// leave out the states from which no accepting state can be reached
+	const size_t numStates = sets.size();
+	std::vector< std::vector<int32_t> > incoming(numStates);
+	for ( size_t s = 0; s < numStates; s++ ){
+		for ( size_t l = 0; l < dfaTransitions[s].size(); l++ )
+			incoming[dfaTransitions[s][l].dest].push_back((int32_t)s);
+	}
+	std::vector<bool> live(numStates, false);
+	std::vector<int32_t> pending;
+	for ( size_t s = 0; s < numStates; s++ ){
+		if ( dfaAccepts[s] ){
+			live[s] = true;
+			pending.push_back((int32_t)s);
+		}
+	}
+	while ( !pending.empty() ){
+		const int32_t s = pending.back();
+		pending.pop_back();
+		for ( size_t l = 0; l < incoming[s].size(); l++ ){
+			if ( !live[incoming[s][l]] ){
+				live[incoming[s][l]] = true;
+				pending.push_back(incoming[s][l]);
+			}
+		}
+	}
+
+	Automaton* a = _CLNEW Automaton();
+	std::vector<int32_t> renumbered(numStates, -1);
+	for ( size_t s = 0; s < numStates; s++ ){
+		if ( s == 0 || live[s] )
+			renumbered[s] = a->createState();
+	}
+	for ( size_t s = 0; s < numStates; s++ ){
+		if ( renumbered[s] < 0 )
+			continue;
+		a->setAccept(renumbered[s], dfaAccepts[s]);
+		for ( size_t l = 0; l < dfaTransitions[s].size(); l++ ){
+			const Automaton::Transition& tr = dfaTransitions[s][l];
+			if ( live[tr.dest] )
+				a->addTransition(renumbered[s], tr.min, tr.max, renumbered[tr.dest]);
+		}
+	}
+	a->finish();
+	return a;
+}
+
+
+/**
+* Parses a regular expression into a tree of nodes, which is then turned
+* into an AutomatonBuilder: a node becomes a piece of automaton with a start
+* and an end state, built again for every repetition of it.
+*/
+class RegExpParser {
+	enum { NODE_CHARS, NODE_CONCAT, NODE_UNION, NODE_REPEAT };
+
+	struct Node {
+		int32_t kind;
+		std::vector< std::pair<wchar_t, wchar_t> > ranges;  //NODE_CHARS
+		std::vector<int32_t> children;
+		int32_t min;  //NODE_REPEAT, max -1 for no limit
+		int32_t max;
+	};
+
+	const wchar_t* pattern;
+	const size_t length;
+	size_t pos;
+	std::vector<Node> nodes;
+
+	int32_t createNode(const int32_t kind){
+		nodes.push_back(Node());
+		nodes.back().kind = kind;
+		nodes.back().min = nodes.back().max = 0;
+		return (int32_t)nodes.size() - 1;
+	}
+	bool more() const{
+		return pos < length;
+	}
+	bool peek(const wchar_t c) const{
+		return pos < length && pattern[pos] == c;
+	}
+	wchar_t next(){
+		if ( pos >= length )
+			_CLTHROWA(CL_ERR_Parse, "Unexpected end of regular expression");
+		return pattern[pos++];
+	}
+
+	int32_t parseUnion(){
+		const int32_t first = parseConcat();
+		if ( !peek(L'|') )
+			return first;
+		const int32_t node = createNode(NODE_UNION);
+		nodes[node].children.push_back(first);
+		while ( peek(L'|') ){
+			pos++;
+			const int32_t child = parseConcat();
+			nodes[node].children.push_back(child);
+		}
+		return node;
+	}
+
+	int32_t parseConcat(){
+		const int32_t node = createNode(NODE_CONCAT);
+		while ( more() && !peek(L'|') && !peek(L')') ){
+			const int32_t child = parseRepeat();
+			nodes[node].children.push_back(child);
+		}
+		return node;
+	}
+
+	int32_t parseRepeat(){
+		int32_t node = parseAtom();
+		while ( more() ){
+			int32_t min, max;
+			if ( peek(L'*') ){
+				min = 0; max = -1;
+			}else if ( peek(L'+') ){
+				min = 1; max = -1;
+			}else if ( peek(L'?') ){
+				min = 0; max = 1;
+			}else if ( peek(L'{') ){
+				pos++;
+				min = max = parseNumber();
+				if ( peek(L',') ){
+					pos++;
+					max = peek(L'}') ? -1 : parseNumber();
+				}
+				if ( !peek(L'}') )
+					_CLTHROWA(CL_ERR_Parse, "Expected '}' in regular expression");
+				if ( max != -1 && max < min )
+					_CLTHROWA(CL_ERR_Parse, "Repetition range out of order in regular expression");
+			}else
+				break;
+			pos++;
+			const int32_t repeat = createNode(NODE_REPEAT);
+			nodes[repeat].children.push_back(node);
+			nodes[repeat].min = min;
+			nodes[repeat].max = max;
+			node = repeat;
+		}
+		return node;
+	}
+
+	int32_t parseNumber(){
+		int32_t n = 0;
+		if ( !more() || pattern[pos] < L'0' || pattern[pos] > L'9' )
+			_CLTHROWA(CL_ERR_Parse, "Expected a number in regular expression");
+		while ( more() && pattern[pos] >= L'0' && pattern[pos] <= L'9' ){
+			n = n * 10 + (pattern[pos++] - L'0');
+			if ( n > MAX_REPEAT )
+				_CLTHROWA(CL_ERR_Parse, "Repetition too large in regular expression");
+		}
+		return n;
+	}
+
+	int32_t parseAtom(){
+		const wchar_t c = next();
+		int32_t node;
+		switch ( c ){
+		case L'(':
+			node = parseUnion();
+			if ( !peek(L')') )
+				_CLTHROWA(CL_ERR_Parse, "Expected ')' in regular expression");
+			pos++;
+			return node;
+		case L'[':
+			return parseClass();
+		case L'.':
+			node = createNode(NODE_CHARS);
+			nodes[node].ranges.push_back(std::make_pair((wchar_t)Automaton::MIN_CHAR, (wchar_t)Automaton::MAX_CHAR));
+			return node;
+		case L'*':
+		case L'+':
+		case L'?':
+		case L'{':
+			_CLTHROWA(CL_ERR_Parse, "Nothing to repeat in regular expression");
+		case L'\\':
+			return createChars(next());
+		default:
+			return createChars(c);
+		}
+	}
+
+	int32_t createChars(const wchar_t c){
+		const int32_t node = createNode(NODE_CHARS);
+		nodes[node].ranges.push_back(std::make_pair(c, c));
+		return node;
+	}
+
+	int32_t parseClass(){
+		const int32_t node = createNode(NODE_CHARS);
+		std::vector< std::pair<wchar_t, wchar_t> > ranges;
+		const bool negate = peek(L'^');
+		if ( negate )
+			pos++;
+		while ( !peek(L']') ){
+			wchar_t min = next();
+			if ( min == L'\\' )
+				min = next();
+			wchar_t max = min;
+			if ( peek(L'-') && pos + 1 < length && pattern[pos + 1] != L']' ){
+				pos++;
+				max = next();
+				if ( max == L'\\' )
+					max = next();
+				if ( max < min )
+					_CLTHROWA(CL_ERR_Parse, "Character range out of order in regular expression");
+			}
+			ranges.push_back(std::make_pair(min, max));
+		}
+		pos++;
+
+		// sorted and merged, so that the complement can be taken
+		std::sort(ranges.begin(), ranges.end());
+		std::vector< std::pair<wchar_t, wchar_t> >& merged = nodes[node].ranges;
+		for ( size_t j = 0; j < ranges.size(); j++ ){
+			if ( !merged.empty() && (int64_t)ranges[j].first <= (int64_t)merged.back().second + 1 )
+				merged.back().second = cl_max(merged.back().second, ranges[j].second);
+			else
+				merged.push_back(ranges[j]);
+		}
+		if ( negate ){
+			std::vector< std::pair<wchar_t, wchar_t> > complement;
+			int64_t from = Automaton::MIN_CHAR;
+			for ( size_t j = 0; j < merged.size(); j++ ){
+				if ( from < merged[j].first )
+					complement.push_back(std::make_pair((wchar_t)from, (wchar_t)(merged[j].first - 1)));
+				from = (int64_t)merged[j].second + 1;
+			}
+			if ( from <= Automaton::MAX_CHAR )
+				complement.push_back(std::make_pair((wchar_t)from, (wchar_t)Automaton::MAX_CHAR));
+			merged.swap(complement);
+		}
+		return node;
+	}
+
+	/** Adds the states of node to builder, returns its start and end state */
+	void build(AutomatonBuilder& builder, const int32_t node, int32_t& start, int32_t& end) const{
+		const Node& n = nodes[node];
+		int32_t childStart, childEnd;
+		switch ( n.kind ){
+		case NODE_CHARS:
+			start = builder.createState();
+			end = builder.createState();
+			for ( size_t j = 0; j < n.ranges.size(); j++ ){
+				// terms cannot hold character 0
+				if ( n.ranges[j].second >= Automaton::MIN_CHAR )
+					builder.addTransition(start, cl_max(n.ranges[j].first, (wchar_t)Automaton::MIN_CHAR), n.ranges[j].second, end);
+			}
+			break;
+		case NODE_CONCAT:
+			start = end = builder.createState();
+			for ( size_t j = 0; j < n.children.size(); j++ ){
+				build(builder, n.children[j], childStart, childEnd);
+				builder.addEpsilon(end, childStart);
+				end = childEnd;
+			}
+			break;
+		case NODE_UNION:
+			start = builder.createState();
+			end = builder.createState();
+			for ( size_t j = 0; j < n.children.size(); j++ ){
+				build(builder, n.children[j], childStart, childEnd);
+				builder.addEpsilon(start, childStart);
+				builder.addEpsilon(childEnd, end);
+			}
+			break;
+		case NODE_REPEAT:
+			start = end = builder.createState();
+			for ( int32_t j = 0; j < n.min; j++ ){
+				build(builder, n.children[0], childStart, childEnd);
+				builder.addEpsilon(end, childStart);
+				end = childEnd;
+			}
+			if ( n.max == -1 ){
+				// a loop through the child
+				const int32_t loop = builder.createState();
+				build(builder, n.children[0], childStart, childEnd);
+				builder.addEpsilon(end, loop);
+				builder.addEpsilon(loop, childStart);
+				builder.addEpsilon(childEnd, loop);
+				end = loop;
+			}else{
+				for ( int32_t j = n.min; j < n.max; j++ ){
+					const int32_t skip = builder.createState();
+					build(builder, n.children[0], childStart, childEnd);
+					builder.addEpsilon(end, childStart);
+					builder.addEpsilon(end, skip);
+					builder.addEpsilon(childEnd, skip);
+					end = skip;
+				}
+			}
+			break;
+		}
+	}
+
+public:
+	/** The largest number of times a part of an expression may be repeated */
+	LUCENE_STATIC_CONSTANT(int32_t, MAX_REPEAT = 1000);
+
+	RegExpParser(const wchar_t* _pattern, const size_t _length):
+		pattern(_pattern), length(_length), pos(0)
+	{
+	}
+
+	/** Parses the expression and adds its automaton to builder, of which
+	* it is the first state */
+	void parse(AutomatonBuilder& builder){
+		const int32_t root = parseUnion();
+		if ( more() )
+			_CLTHROWA(CL_ERR_Parse, "Unmatched ')' in regular expression");
+		const int32_t initial = builder.createState();
+		int32_t start, end;
+		build(builder, root, start, end);
+		builder.addEpsilon(initial, start);
+		builder.setAccept(end);
+	}
+};
+
+Automaton* RegExp::toAutomaton(const wchar_t* pattern, const size_t length, const int32_t maxStates){
+	AutomatonBuilder builder;
+	RegExpParser parser(pattern, length);
+	parser.parse(builder);
+	return builder.determinize(maxStates);
+}
+
+
+/**
+* The states of the nondeterministic automaton of LevenshteinAutomata: the
+* number of characters of the text matched so far and the number of edits
+* spent, and whether the first character of a transposition has been read.
+* A set of them, kept sorted, is a state of the deterministic automaton.
+* Deleting characters of the text is not a state of its own: a state stands
+* for the states reached by deleting the next characters as well.
+*/
+class LevenshteinStates {
+	const wchar_t* text;
+	const int32_t n;
+	const int32_t k;
+	const bool transpositions;
+
+	int32_t id(const int32_t i, const int32_t e, const bool t) const{
+		return ((t ? n + 1 : 0) + i) * (k + 1) + e;
+	}
+	int32_t position(const int32_t s) const{
+		return (s / (k + 1)) % (n + 1);
+	}
+	int32_t edits(const int32_t s) const{
+		return s % (k + 1);
+	}
+	bool isTransposition(const int32_t s) const{
+		return s >= (n + 1) * (k + 1);
+	}
+
+	/** Sorts states and drops the redundant ones */
+	void normalize(std::vector<int32_t>& states) const{
+		std::sort(states.begin(), states.end());
+		states.erase(std::unique(states.begin(), states.end()), states.end());
+
+		// drop the states whose strings another state accepts with fewer edits
+		std::vector<int32_t> kept;
+		for ( size_t j = 0; j < states.size(); j++ ){
+			const int32_t s = states[j];
+			bool subsumed = false;
+			if ( !isTransposition(s) ){
+				for ( size_t l = 0; l < states.size() && !subsumed; l++ ){
+					const int32_t o = states[l];
+					subsumed = !isTransposition(o) && edits(o) < edits(s) &&
+						abs(position(o) - position(s)) <= edits(s) - edits(o);
+				}
+			}
+			if ( !subsumed )
+				kept.push_back(s);
+		}
+		states.swap(kept);
+	}
+
+public:
+	LevenshteinStates(const wchar_t* _text, const int32_t _n, const int32_t _k, const bool _transpositions):
+		text(_text), n(_n), k(_k), transpositions(_transpositions)
+	{
+	}
+
+	void initial(std::vector<int32_t>& states) const{
+		states.clear();
+		states.push_back(id(0, 0, false));
+	}
+
+	/** The states reached from states on c, c 0 standing for any character
+	* which the text does not hold */
+	void step(const std::vector<int32_t>& states, const wchar_t c, std::vector<int32_t>& to) const{
+		to.clear();
+		for ( size_t j = 0; j < states.size(); j++ ){
+			const int32_t s = states[j];
+			const int32_t i = position(s);
+			const int32_t e = edits(s);
+			if ( isTransposition(s) ){
+				if ( text[i] == c )
+					to.push_back(id(i + 2, e, false));
+				continue;
+			}
+			// a match, after deleting the characters before it
+			for ( int32_t p = i; p < n && e + p - i <= k; p++ ){
+				if ( text[p] == c )
+					to.push_back(id(p + 1, e + p - i, false));
+				if ( transpositions && e + p - i < k && p + 1 < n && text[p + 1] == c && text[p] != c )
+					to.push_back(id(p, e + p - i + 1, true));
+			}
+			if ( e < k ){
+				to.push_back(id(i, e + 1, false));  // insertion
+				if ( i < n )
+					to.push_back(id(i + 1, e + 1, false));  // substitution
+			}
+		}
+		normalize(to);
+	}
+
+	bool isAccept(const std::vector<int32_t>& states) const{
+		for ( size_t j = 0; j < states.size(); j++ ){
+			// the rest of the text can be deleted
+			if ( !isTransposition(states[j]) && n - position(states[j]) <= k - edits(states[j]) )
+				return true;
+		}
+		return false;
+	}
+};
+
+Automaton* LevenshteinAutomata::build(const wchar_t* prefix, const size_t prefixLength,
+	const wchar_t* text, const size_t textLength, const int32_t maxDistance,
+	const bool transpositions, const int32_t maxStates)
+{
+	Automaton* a = _CLNEW Automaton();
+	for ( size_t i = 0; i < prefixLength; i++ ){
+		const int32_t s = a->createState();
+		a->addTransition(s, prefix[i], prefix[i], s + 1);
+	}
+
+	// the characters of the text, every other character behaves the same
+	std::vector<wchar_t> alphabet(text, text + textLength);
+	std::sort(alphabet.begin(), alphabet.end());
+	alphabet.erase(std::unique(alphabet.begin(), alphabet.end()), alphabet.end());
+
+	const LevenshteinStates nfa(text, (int32_t)textLength, maxDistance, transpositions);
+	std::map< std::vector<int32_t>, int32_t > numbers;
+	std::vector< std::vector<int32_t> > pending;
+	std::vector<int32_t> states, to;
+	std::vector<int32_t> dests(alphabet.size());
+
+	nfa.initial(states);
+	numbers[states] = a->createState();
+	pending.push_back(states);
+	for ( size_t p = 0; p < pending.size(); p++ ){
+		states = pending[p];
+		const int32_t state = numbers[states];
+		a->setAccept(state, nfa.isAccept(states));
+
+		int32_t otherDest = -1;
+		for ( size_t c = 0; c <= alphabet.size(); c++ ){
+			nfa.step(states, c < alphabet.size() ? alphabet[c] : 0, to);
+			int32_t dest = -1;
+			if ( !to.empty() ){
+				std::map< std::vector<int32_t>, int32_t >::iterator itr = numbers.find(to);
+				if ( itr != numbers.end() ){
+					dest = itr->second;
+				}else{
+					if ( (int32_t)numbers.size() >= maxStates ){
+						_CLDELETE(a);
+						return NULL;
+					}
+					dest = a->createState();
+					numbers[to] = dest;
+					pending.push_back(to);
+				}
+			}
+			if ( c < alphabet.size() )
+				dests[c] = dest;
+			else
+				otherDest = dest;
+		}
+
+		int32_t from = Automaton::MIN_CHAR;
+		for ( size_t c = 0; c < alphabet.size(); c++ ){
+			if ( otherDest >= 0 && from < alphabet[c] )
+				a->addTransition(state, from, alphabet[c] - 1, otherDest);
+			if ( dests[c] >= 0 )
+				a->addTransition(state, alphabet[c], alphabet[c], dests[c]);
+			from = alphabet[c] + 1;
+		}
+		if ( otherDest >= 0 && from <= Automaton::MAX_CHAR )
+			a->addTransition(state, from, Automaton::MAX_CHAR, otherDest);
+	}
+	a->finish();
+	return a;
+}
+
+CL_NS_END
@@ -11,10 +11,60 @@
 #include "CLucene/store/Directory.h"
 #include "CLucene/store/IndexInput.h"
 #include "CLucene/store/IndexOutput.h"
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 CL_NS_USE(store)
 CL_NS_DEF(util)
 
+  /** number of set bits in x */
+  static inline int32_t bitCount(uint64_t x){
+#if defined(_MSC_VER) && defined(_M_X64) && defined(__AVX__)
+    //every cpu that has AVX also has the POPCNT instruction
+    return (int32_t)__popcnt64(x);
+#elif defined(__GNUC__)
+    return __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int32_t)((x * 0x0101010101010101ULL) >> 56);
+#endif
+  }
+
+  /** index of the lowest set bit, x must not be 0 */
+  static inline int32_t lowestBit(uint64_t x){
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long ret;
+    _BitScanForward64(&ret, x);
+    return (int32_t)ret;
+#elif defined(_MSC_VER)
+    unsigned long ret;
+    if ( (uint32_t)x != 0 ){
+      _BitScanForward(&ret, (uint32_t)x);
+      return (int32_t)ret;
+    }
+    _BitScanForward(&ret, (uint32_t)(x >> 32));
+    return 32 + (int32_t)ret;
+#else
+    return __builtin_ctzll(x);
+#endif
+  }
+
+  /** true if the words are laid out in memory in the byte order of the file format */
+  static inline bool littleEndian(){
+    const uint16_t one = 1;
+    return *(const uint8_t*)&one == 1;
+  }
+
+  /** byte i of the bit set, in the order of the file format */
+  static inline uint8_t byteAt(const uint64_t* bits, int32_t i){
+    return (uint8_t)(bits[i >> 3] >> ((i & 7) << 3));
+  }
+
 
 const uint8_t BitSet::BYTE_COUNTS[256] = {
     0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
@@ -36,23 +86,33 @@ const uint8_t BitSet::BYTE_COUNTS[256] = {
 
 BitSet::BitSet( const BitSet& copy ) :
 	_size( copy._size ),
-	_count(-1)
+	_count( copy._count ),
+	bits(NULL),
+	docs(NULL)
 {
-	int32_t len = (_size >> 3) + 1;
-	bits = _CL_NEWARRAY(uint8_t, len);
-	memcpy( bits, copy.bits, len );
+	if ( copy.bits != NULL ){
+		const int32_t len = wordCount(_size);
+		bits = _CL_NEWARRAY(uint64_t, len);
+		memcpy( bits, copy.bits, len * sizeof(uint64_t) );
+	}else{
+		docs = _CL_NEWARRAY(int32_t, _count + 1);
+		memcpy( docs, copy.docs, _count * sizeof(int32_t) );
+	}
 }
 
 BitSet::BitSet ( int32_t size ):
   _size(size),
-  _count(-1)
+  _count(0),
+  docs(NULL)
 {
-	int32_t len = (_size >> 3) + 1;
-	bits = _CL_NEWARRAY(uint8_t, len);
-	memset(bits,0,len);
+	const int32_t len = wordCount(_size);
+	bits = _CL_NEWARRAY(uint64_t, len);
+	memset(bits,0,len * sizeof(uint64_t));
 }
 
-BitSet::BitSet(CL_NS(store)::Directory* d, const wchar_t * name)
+BitSet::BitSet(CL_NS(store)::Directory* d, const wchar_t * name):
+  bits(NULL),
+  docs(NULL)
 {
 	_count=-1;
 	CL_NS(store)::IndexInput* input = d->openInput( name );
@@ -70,6 +130,8 @@ BitSet::BitSet(CL_NS(store)::Directory* d, const wchar_t * name)
 }
 	
 void BitSet::write(CL_NS(store)::Directory* d, const wchar_t * name) {
+	if ( bits == NULL )
+		toDense();
 	CL_NS(store)::IndexOutput* output = d->createOutput(name);
 	try {
     if (isSparse()) {
@@ -84,20 +146,209 @@ void BitSet::write(CL_NS(store)::Directory* d, const wchar_t * name) {
 }
 BitSet::~BitSet(){
 	_CLDELETE_ARRAY(bits);
+	_CLDELETE_ARRAY(docs);
 }
 
+int32_t BitSet::wordCount(int32_t size){
+	return (size >> 6) + 1;
+}
+
+void BitSet::toDense(){
+	const int32_t len = wordCount(_size);
+	uint64_t* words = _CL_NEWARRAY(uint64_t, len);
+	memset(words, 0, len * sizeof(uint64_t));
+	for ( int32_t i=0;i<_count;i++ )
+		words[docs[i] >> 6] |= (uint64_t)1 << (docs[i] & 63);
+	_CLDELETE_ARRAY(docs);
+	bits = words;
+}
+
+bool BitSet::sparseGet(const int32_t bit) const{
+	return std::binary_search(docs, docs + _count, bit);
+}
 
 void BitSet::set(const int32_t bit, bool val){
     if (bit >= _size) {
 	      _CLTHROWA(CL_ERR_IndexOutOfBounds, "bit out of range");
     }
+	if ( bits == NULL )
+		toDense();
 
 	_count = -1;
 
 	if (val)
-		bits[bit >> 3] |= 1 << (bit & 7);
+		bits[bit >> 6] |= (uint64_t)1 << (bit & 63);
 	else
-		bits[bit >> 3] &= ~(1 << (bit & 7));
+		bits[bit >> 6] &= ~((uint64_t)1 << (bit & 63));
+}
+
+void BitSet::set(const int32_t fromIndex, const int32_t toIndex, bool val){
+	if ( fromIndex < 0 || toIndex > _size || fromIndex > toIndex )
+		_CLTHROWA(CL_ERR_IndexOutOfBounds, "bit range out of range");
+	if ( fromIndex == toIndex )
+		return;
+	if ( bits == NULL )
+		toDense();
+	_count = -1;
+
+	const int32_t startWord = fromIndex >> 6;
+	const int32_t endWord = (toIndex - 1) >> 6;
+	const uint64_t startMask = ~(uint64_t)0 << (fromIndex & 63);
+	const uint64_t endMask = ~(uint64_t)0 >> (63 - ((toIndex - 1) & 63));
+	if ( startWord == endWord ){
+		if ( val )
+			bits[startWord] |= startMask & endMask;
+		else
+			bits[startWord] &= ~(startMask & endMask);
+		return;
+	}
+	if ( val ){
+		bits[startWord] |= startMask;
+		for ( int32_t i=startWord+1;i<endWord;i++ )
+			bits[i] = ~(uint64_t)0;
+		bits[endWord] |= endMask;
+	}else{
+		bits[startWord] &= ~startMask;
+		for ( int32_t i=startWord+1;i<endWord;i++ )
+			bits[i] = 0;
+		bits[endWord] &= ~endMask;
+	}
+}
+
+void BitSet::flip(const int32_t fromIndex, const int32_t toIndex){
+	if ( fromIndex < 0 || toIndex > _size || fromIndex > toIndex )
+		_CLTHROWA(CL_ERR_IndexOutOfBounds, "bit range out of range");
+	if ( fromIndex == toIndex )
+		return;
+	if ( bits == NULL )
+		toDense();
+	_count = -1;
+
+	const int32_t startWord = fromIndex >> 6;
+	const int32_t endWord = (toIndex - 1) >> 6;
+	const uint64_t startMask = ~(uint64_t)0 << (fromIndex & 63);
+	const uint64_t endMask = ~(uint64_t)0 >> (63 - ((toIndex - 1) & 63));
+	if ( startWord == endWord ){
+		bits[startWord] ^= startMask & endMask;
+		return;
+	}
+	bits[startWord] ^= startMask;
+	for ( int32_t i=startWord+1;i<endWord;i++ )
+		bits[i] = ~bits[i];
+	bits[endWord] ^= endMask;
+}
+
+// The word loops below are kept free of calls and branches, so that the
+// compiler can vectorize them. The bits past _size are always zero, which
+// count() and nextSetBit() rely on, so or_ and xor_ clear them again if
+// other is the larger bit set.
+
+void BitSet::and_(const BitSet& other){
+	if ( bits == NULL )
+		toDense();
+	_count = -1;
+	const int32_t len = wordCount(_size);
+	if ( other.bits == NULL ){
+		uint64_t* words = _CL_NEWARRAY(uint64_t, len);
+		memset(words, 0, len * sizeof(uint64_t));
+		for ( int32_t i=0;i<other._count && other.docs[i] < _size;i++ ){
+			const int32_t doc = other.docs[i];
+			words[doc >> 6] |= bits[doc >> 6] & ((uint64_t)1 << (doc & 63));
+		}
+		_CLDELETE_ARRAY(bits);
+		bits = words;
+		return;
+	}
+	const int32_t n = (std::min)(len, wordCount(other._size));
+	uint64_t* a = bits;
+	const uint64_t* b = other.bits;
+	for ( int32_t i=0;i<n;i++ )
+		a[i] &= b[i];
+	for ( int32_t i=n;i<len;i++ )
+		a[i] = 0;
+}
+
+void BitSet::or_(const BitSet& other){
+	if ( bits == NULL )
+		toDense();
+	_count = -1;
+	if ( other.bits == NULL ){
+		for ( int32_t i=0;i<other._count && other.docs[i] < _size;i++ )
+			bits[other.docs[i] >> 6] |= (uint64_t)1 << (other.docs[i] & 63);
+		return;
+	}
+	const int32_t n = (std::min)(wordCount(_size), wordCount(other._size));
+	uint64_t* a = bits;
+	const uint64_t* b = other.bits;
+	for ( int32_t i=0;i<n;i++ )
+		a[i] |= b[i];
+	if ( other._size > _size )
+		bits[_size >> 6] &= ((uint64_t)1 << (_size & 63)) - 1;
+}
+
+void BitSet::andNot(const BitSet& other){
+	if ( bits == NULL )
+		toDense();
+	_count = -1;
+	if ( other.bits == NULL ){
+		for ( int32_t i=0;i<other._count && other.docs[i] < _size;i++ )
+			bits[other.docs[i] >> 6] &= ~((uint64_t)1 << (other.docs[i] & 63));
+		return;
+	}
+	const int32_t n = (std::min)(wordCount(_size), wordCount(other._size));
+	uint64_t* a = bits;
+	const uint64_t* b = other.bits;
+	for ( int32_t i=0;i<n;i++ )
+		a[i] &= ~b[i];
+}
+
+void BitSet::xor_(const BitSet& other){
+	if ( bits == NULL )
+		toDense();
+	_count = -1;
+	if ( other.bits == NULL ){
+		for ( int32_t i=0;i<other._count && other.docs[i] < _size;i++ )
+			bits[other.docs[i] >> 6] ^= (uint64_t)1 << (other.docs[i] & 63);
+		return;
+	}
+	const int32_t n = (std::min)(wordCount(_size), wordCount(other._size));
+	uint64_t* a = bits;
+	const uint64_t* b = other.bits;
+	for ( int32_t i=0;i<n;i++ )
+		a[i] ^= b[i];
+	if ( other._size > _size )
+		bits[_size >> 6] &= ((uint64_t)1 << (_size & 63)) - 1;
+}
+
+bool BitSet::compact(){
+	if ( bits == NULL )
+		return true;
+	const int32_t len = wordCount(_size);
+	const int32_t c = count();
+	if ( (int64_t)c * sizeof(int32_t) >= (int64_t)len * sizeof(uint64_t) )
+		return false;
+
+	docs = _CL_NEWARRAY(int32_t, c + 1);
+	int32_t n = 0;
+	for ( int32_t i=0;i<len;i++ ){
+		uint64_t word = bits[i];
+		while ( word != 0 ){
+			docs[n++] = (i << 6) + lowestBit(word);
+			word &= word - 1;
+		}
+	}
+	_CLDELETE_ARRAY(bits);
+	return true;
+}
+
+bool BitSet::isCompact() const{
+	return bits == NULL;
+}
+
+size_t BitSet::ramBytesUsed() const{
+	if ( bits == NULL )
+		return sizeof(BitSet) + sizeof(int32_t) * (_count + 1);
+	return sizeof(BitSet) + sizeof(uint64_t) * wordCount(_size);
 }
 
 int32_t BitSet::size() const {
@@ -108,9 +359,9 @@ int32_t BitSet::count(){
     if (_count == -1) {
 
       int32_t c = 0;
-      int32_t end = (_size >> 3) + 1;
+      const int32_t end = wordCount(_size);
       for (int32_t i = 0; i < end; i++)
-        c += BYTE_COUNTS[bits[i]];	  // sum bits per uint8_t
+        c += bitCount(bits[i]);	  // sum bits per word
       _count = c;
     }
     return _count;
@@ -122,21 +373,32 @@ BitSet* BitSet::clone() const {
   /** Read as a bit set */
   void BitSet::readBits(IndexInput* input) {
     _count = input->readInt();        // read count
-    bits = _CL_NEWARRAY(uint8_t,(_size >> 3) + 1);      // allocate bits
-    input->readBytes(bits, (_size >> 3) + 1);   // read bits
+    const int32_t len = wordCount(_size);
+    bits = _CL_NEWARRAY(uint64_t,len);      // allocate bits
+    memset(bits, 0, len * sizeof(uint64_t));
+    const int32_t byteLen = (_size >> 3) + 1;
+    if ( littleEndian() ){
+      input->readBytes((uint8_t*)bits, byteLen);   // read bits
+    }else{
+      for ( int32_t i=0;i<byteLen;i++ )
+        bits[i >> 3] |= (uint64_t)input->readByte() << ((i & 7) << 3);
+    }
   }
 
   /** read as a d-gaps list */
   void BitSet::readDgaps(IndexInput* input) {
     _size = input->readInt();       // (re)read size
     _count = input->readInt();        // read count
-    bits = _CL_NEWARRAY(uint8_t,(_size >> 3) + 1);     // allocate bits
+    const int32_t len = wordCount(_size);
+    bits = _CL_NEWARRAY(uint64_t,len);     // allocate bits
+    memset(bits, 0, len * sizeof(uint64_t));
     int32_t last=0;
     int32_t n = count();
     while (n>0) {
       last += input->readVInt();
-      bits[last] = input->readByte();
-      n -= BYTE_COUNTS[bits[last] & 0xFF];
+      const uint8_t b = input->readByte();
+      bits[last >> 3] |= (uint64_t)b << ((last & 7) << 3);
+      n -= BYTE_COUNTS[b];
     }
   }
 
@@ -144,7 +406,13 @@ BitSet* BitSet::clone() const {
    void BitSet::writeBits(IndexOutput* output) {
     output->writeInt(size());       // write size
     output->writeInt(count());        // write count
-    output->writeBytes(bits, (_size >> 3) + 1);   // write bits
+    const int32_t byteLen = (_size >> 3) + 1;
+    if ( littleEndian() ){
+      output->writeBytes((const uint8_t*)bits, byteLen);   // write bits
+    }else{
+      for ( int32_t i=0;i<byteLen;i++ )
+        output->writeByte(byteAt(bits, i));
+    }
   }
 
   /** Write as a d-gaps list */
@@ -156,11 +424,16 @@ BitSet* BitSet::clone() const {
     int32_t n = count();
     int32_t m = (_size >> 3) + 1;
     for (int32_t i=0; i<m && n>0; i++) {
-      if (bits[i]!=0) {
+      if (bits[i >> 3] == 0) {
+        i |= 7; // skip the rest of an empty word
+        continue;
+      }
+      const uint8_t b = byteAt(bits, i);
+      if (b!=0) {
         output->writeVInt(i-last);
-        output->writeByte(bits[i]);
+        output->writeByte(b);
         last = i;
-        n -= BYTE_COUNTS[bits[i] & 0xFF];
+        n -= BYTE_COUNTS[b];
       }
     }
   }
@@ -189,11 +462,20 @@ BitSet* BitSet::clone() const {
       if (fromIndex >= _size)
           return -1;
 
+      if (bits == NULL) {
+          const int32_t* pos = std::lower_bound(docs, docs + _count, fromIndex);
+          return pos == docs + _count ? -1 : *pos;
+      }
+
+      int32_t i = fromIndex >> 6;
+      uint64_t word = bits[i] & (~(uint64_t)0 << (fromIndex & 63));
+      const int32_t len = wordCount(_size);
       while (true) {
-          if ((bits[fromIndex >> 3] & (1 << (fromIndex & 7))) != 0)
-              return fromIndex;
-          if (++fromIndex == _size)
+          if (word != 0)
+              return (i << 6) + lowestBit(word); // bits past _size are never set
+          if (++i == len)
               return -1;
+          word = bits[i];
       }
   }
 
@@ -24,12 +24,17 @@ CL_NS_DEF(util)
   <li>optimized read from and write to disk;</li>
   <li>inlinable get() method;</li>
   <li>store and load, as bit set or d-gaps, depending on sparseness;</li> 
+  <li>word-at-a-time boolean operations (and_, or_, andNot, xor_) for combining filters;</li>
+  <li>an optional sparse representation (a sorted list of the set bits) for
+  bit sets with only a few set bits, see compact().</li>
   </ul>
+  The bits are held in 64 bit words, bit i is bit (i &amp; 63) of word (i &gt;&gt; 6).
   */
 class CLUCENE_EXPORT BitSet:LUCENE_BASE {
 	int32_t _size;
 	int32_t _count;
-	uint8_t *bits;
+	uint64_t *bits; //NULL while the bit set is sparse
+	int32_t *docs;  //the set bits in ascending order, only while the bit set is sparse
 
   void readBits(CL_NS(store)::IndexInput* input);
   /** read as a d-gaps list */
@@ -41,6 +46,13 @@ class CLUCENE_EXPORT BitSet:LUCENE_BASE {
   /** Indicates if the bit vector is sparse and should be saved as a d-gaps list, or dense, and should be saved as a bit set. */
   bool isSparse();
   static const uint8_t BYTE_COUNTS[256];
+
+  /** number of 64 bit words for a bit set of the given size */
+  static int32_t wordCount(int32_t size);
+  /** switch back from the sparse to the word representation */
+  void toDense();
+  /** get() for the sparse representation */
+  bool sparseGet(const int32_t bit) const;
 protected:
 	BitSet( const BitSet& copy );
 
@@ -54,12 +66,13 @@ public:
 	~BitSet();
 	
 	///get the value of the specified bit
-	///get the value of the specified bit
     inline bool get(const int32_t bit) const{
         if (bit >= _size) {
             _CLTHROWA(CL_ERR_IndexOutOfBounds, "bit out of range");
         }
-        return (bits[bit >> 3] & (1 << (bit & 7))) != 0;
+        if (bits != NULL)
+            return (bits[bit >> 6] & ((uint64_t)1 << (bit & 63))) != 0;
+        return sparseGet(bit);
     }
 
     /**
@@ -85,6 +98,37 @@ public:
 	
 	///set the value of the specified bit
 	void set(const int32_t bit, bool val=true);
+
+	///set the bits from fromIndex (inclusive) to toIndex (exclusive) to val
+	void set(const int32_t fromIndex, const int32_t toIndex, bool val);
+
+	///flip the bits from fromIndex (inclusive) to toIndex (exclusive)
+	void flip(const int32_t fromIndex, const int32_t toIndex);
+
+	/** Keep only the bits that are also set in other (this = this AND other).
+	  Bits beyond the size of other are cleared. */
+	void and_(const BitSet& other);
+	/** Set the bits that are set in other (this = this OR other).
+	  Bits beyond the size of this bit set are ignored. */
+	void or_(const BitSet& other);
+	/** Clear the bits that are set in other (this = this AND NOT other) */
+	void andNot(const BitSet& other);
+	/** Flip the bits that are set in other (this = this XOR other).
+	  Bits beyond the size of this bit set are ignored. */
+	void xor_(const BitSet& other);
+
+	/** Switch to the sparse representation if it takes less memory than the
+	  words do. Lookups in a sparse bit set are a binary search, and the first
+	  change switches it back to words. Use this for bit sets that are kept
+	  around but rarely have bits set, such as cached filters.
+	  @return true if the bit set is now sparse */
+	bool compact();
+
+	///returns true if the bit set uses the sparse representation
+	bool isCompact() const;
+
+	///returns the memory held by the bits, in bytes
+	size_t ramBytesUsed() const;
 	
 	///returns the size of the bitset
 	int32_t size() const;
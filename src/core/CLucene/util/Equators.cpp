@@ -100,6 +100,30 @@ namespace lucene {
         }
 
 
+        int64_t Compare::Int64::getValue() const { return value; }
+        Compare::Int64::Int64(int64_t val)
+        {
+            value = val;
+        }
+        const std::wstring Compare::Int64::getClassName()
+        {
+            return L"Compare::Int64::getClassName";
+        }
+        const std::wstring Compare::Int64::getObjectName() const
+        {
+            return getClassName();
+        }
+        int32_t Compare::Int64::compareTo(NamedObject* o)
+        {
+            if (o->getObjectName() != Int64::getClassName()) return -1;
+
+            Int64* other = (Int64*) o;
+            if (value == other->value)
+                return 0;
+            return value > other->value ? 1 : -1;
+        }
+
+
         float_t Compare::Float::getValue() const
         {
             return value;
@@ -107,6 +107,17 @@ public:
         const std::wstring getObjectName() const;
     };
 
+    class CLUCENE_INLINE_EXPORT Int64 :public Comparable
+    {
+        int64_t value;
+    public:
+        int64_t getValue() const;
+        Int64(int64_t val);
+        int32_t compareTo(NamedObject* o);
+        static const std::wstring getClassName();
+        const std::wstring getObjectName() const;
+    };
+
 
     class CLUCENE_INLINE_EXPORT Float :public Comparable
     {
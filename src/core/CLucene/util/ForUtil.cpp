@@ -0,0 +1,178 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "CLucene/_ApiHeader.h"
+#include "_ForUtil.h"
+#include "CLucene/store/IndexInput.h"
+#include "CLucene/store/IndexOutput.h"
+
+CL_NS_USE(store)
+CL_NS_DEF(util)
+
+  /** the number of bits needed to store v, 0 for 0 */
+  static inline int32_t bitsOf(uint32_t v){
+    int32_t bits = 0;
+    while ( v != 0 ){
+      bits++;
+      v >>= 1;
+    }
+    return bits;
+  }
+
+  void ForUtil::pack(const uint32_t* values, const int32_t count, const int32_t bits, uint8_t* out){
+    const uint64_t mask = (((uint64_t)1) << bits) - 1;
+    uint64_t acc = 0;
+    int32_t accBits = 0;
+    for ( int32_t i=0;i<count;i++ ){
+      acc |= (values[i] & mask) << accBits;
+      accBits += bits;
+      while ( accBits >= 8 ){
+        *out++ = (uint8_t)acc;
+        acc >>= 8;
+        accBits -= 8;
+      }
+    }
+    if ( accBits > 0 )
+      *out = (uint8_t)acc;
+  }
+
+  void ForUtil::unpack(const uint8_t* in, const int32_t count, const int32_t bits, uint32_t* values){
+    const uint64_t mask = (((uint64_t)1) << bits) - 1;
+    uint64_t acc = 0;
+    int32_t accBits = 0;
+    for ( int32_t i=0;i<count;i++ ){
+      while ( accBits < bits ){
+        acc |= ((uint64_t)*in++) << accBits;
+        accBits += 8;
+      }
+      values[i] = (uint32_t)(acc & mask);
+      acc >>= bits;
+      accBits -= bits;
+    }
+  }
+
+  void ForUtil::readPacked(IndexInput* in, const int32_t count, const int32_t bits, uint32_t* values){
+    const int32_t len = (count * bits + 7) / 8;
+    int32_t available;
+    const uint8_t* bytes = in->bufferedBytes(available);
+    if ( bytes != NULL && available >= len ){
+      unpack(bytes, count, bits, values);
+      in->consumeBufferedBytes(len);
+    }else{
+      uint8_t scratch[BLOCK_LENGTH * 4];
+      in->readBytes(scratch, len);
+      unpack(scratch, count, bits, values);
+    }
+  }
+
+  void ForUtil::writeBlock(const int32_t* _values, IndexOutput* out){
+    const uint32_t* values = (const uint32_t*)_values;
+
+    int32_t counts[33];
+    memset(counts, 0, sizeof(counts));
+    bool allEqual = true;
+    for ( int32_t i=0;i<BLOCK_LENGTH;i++ ){
+      CND_PRECONDITION(_values[i] >= 0, "values must not be negative");
+      counts[bitsOf(values[i])]++;
+      allEqual = allEqual && values[i] == values[0];
+    }
+    if ( allEqual ){
+      out->writeByte(0);
+      out->writeVInt(_values[0]);
+      return;
+    }
+
+    int32_t maxBits = 32;
+    while ( counts[maxBits] == 0 )
+      maxBits--;
+
+    // take as few bits as makes the block smallest, the values that
+    // need more are exceptions
+    int32_t bits = maxBits;
+    int32_t size = BLOCK_LENGTH / 8 * maxBits;
+    int32_t numExceptions = 0;
+    for ( int32_t b = maxBits - 1, e = 0; b > 0; b-- ){
+      e += counts[b + 1];
+      const int32_t s = BLOCK_LENGTH / 8 * b + 1 + e + (e * (maxBits - b) + 7) / 8;
+      if ( s < size ){
+        size = s;
+        bits = b;
+        numExceptions = e;
+      }
+    }
+
+    uint8_t packed[BLOCK_LENGTH * 4];
+    out->writeByte((uint8_t)bits);
+    out->writeByte((uint8_t)numExceptions);
+    pack(values, BLOCK_LENGTH, bits, packed);
+    out->writeBytes(packed, BLOCK_LENGTH / 8 * bits);
+
+    if ( numExceptions > 0 ){
+      const int32_t exceptionBits = maxBits - bits;
+      uint8_t indexes[BLOCK_LENGTH];
+      uint32_t highs[BLOCK_LENGTH];
+      int32_t e = 0;
+      for ( int32_t i=0;i<BLOCK_LENGTH;i++ ){
+        if ( (values[i] >> bits) != 0 ){
+          indexes[e] = (uint8_t)i;
+          highs[e++] = values[i] >> bits;
+        }
+      }
+      out->writeByte((uint8_t)exceptionBits);
+      out->writeBytes(indexes, numExceptions);
+      pack(highs, numExceptions, exceptionBits, packed);
+      out->writeBytes(packed, (numExceptions * exceptionBits + 7) / 8);
+    }
+  }
+
+  void ForUtil::readBlock(IndexInput* in, int32_t* _values){
+    uint32_t* values = (uint32_t*)_values;
+
+    const int32_t bits = in->readByte();
+    if ( bits == 0 ){
+      const int32_t value = in->readVInt();
+      for ( int32_t i=0;i<BLOCK_LENGTH;i++ )
+        _values[i] = value;
+      return;
+    }
+    if ( bits > 32 )
+      _CLTHROWA(CL_ERR_CorruptIndex, "invalid bits per value in packed block");
+
+    const int32_t numExceptions = in->readByte();
+    readPacked(in, BLOCK_LENGTH, bits, values);
+
+    if ( numExceptions > 0 ){
+      const int32_t exceptionBits = in->readByte();
+      if ( numExceptions > BLOCK_LENGTH || exceptionBits + bits > 32 )
+        _CLTHROWA(CL_ERR_CorruptIndex, "invalid exceptions in packed block");
+      uint8_t indexes[BLOCK_LENGTH];
+      uint32_t highs[BLOCK_LENGTH];
+      in->readBytes(indexes, numExceptions);
+      readPacked(in, numExceptions, exceptionBits, highs);
+      for ( int32_t e=0;e<numExceptions;e++ )
+        values[indexes[e] & (BLOCK_LENGTH - 1)] |= highs[e] << bits;
+    }
+  }
+
+  void ForUtil::skipBlock(IndexInput* in){
+    const int32_t bits = in->readByte();
+    if ( bits == 0 ){
+      in->readVInt();
+      return;
+    }
+    const int32_t numExceptions = in->readByte();
+    int64_t len = BLOCK_LENGTH / 8 * bits;
+    if ( numExceptions > 0 ){
+      in->seek(in->getFilePointer() + len);
+      const int32_t exceptionBits = in->readByte();
+      len = numExceptions + (numExceptions * exceptionBits + 7) / 8;
+    }
+    in->seek(in->getFilePointer() + len);
+  }
+
+CL_NS_END
@@ -0,0 +1,166 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "CLucene/_ApiHeader.h"
+#include "_LZ4.h"
+
+CL_NS_DEF(util)
+
+  static const int32_t MIN_MATCH = 4;
+  static const int32_t LAST_LITERALS = 5; //the format wants the last bytes to be literals...
+  static const int32_t MF_LIMIT = 12;     //...and no match to start this close to the end
+  static const int32_t MAX_OFFSET = 65535;
+  static const int32_t HASH_LOG = 12;
+
+  static inline uint32_t read32(const uint8_t* p){
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+  }
+
+  static inline int32_t hash(const uint32_t v){
+    return (int32_t)((v * 2654435761U) >> (32 - HASH_LOG));
+  }
+
+  /** writes a length continued in 255 steps, after 15 went into the token */
+  static inline int32_t writeLength(uint8_t* out, int32_t op, int32_t len){
+    while ( len >= 255 ){
+      out[op++] = 255;
+      len -= 255;
+    }
+    out[op++] = (uint8_t)len;
+    return op;
+  }
+
+  static inline int32_t writeLiterals(const uint8_t* in, const int32_t anchor, const int32_t litLen, uint8_t* out, int32_t op, const uint8_t matchBits){
+    const int32_t token = op++;
+    if ( litLen >= 15 ){
+      out[token] = (uint8_t)(0xF0 | matchBits);
+      op = writeLength(out, op, litLen - 15);
+    }else
+      out[token] = (uint8_t)((litLen << 4) | matchBits);
+    if ( litLen > 0 )
+      memcpy(out + op, in + anchor, litLen);
+    return op + litLen;
+  }
+
+  int32_t LZ4::compressBound(const int32_t len){
+    return len + len / 255 + 16;
+  }
+
+  int32_t LZ4::compress(const uint8_t* in, const int32_t len, uint8_t* out){
+    int32_t op = 0;
+    int32_t anchor = 0;
+
+    if ( len > MF_LIMIT ){
+      int32_t table[1 << HASH_LOG];
+      memset(table, 0xFF, sizeof(table)); //-1: no position yet
+
+      const int32_t mfLimit = len - MF_LIMIT;
+      const int32_t matchLimit = len - LAST_LITERALS;
+      int32_t ip = 0;
+      while ( ip < mfLimit ){
+        const uint32_t seq = read32(in + ip);
+        const int32_t h = hash(seq);
+        int32_t ref = table[h];
+        table[h] = ip;
+        if ( ref < 0 || ip - ref > MAX_OFFSET || read32(in + ref) != seq ){
+          //step faster through data that does not compress
+          ip += 1 + ((ip - anchor) >> 6);
+          continue;
+        }
+
+        while ( ip > anchor && ref > 0 && in[ip - 1] == in[ref - 1] ){
+          ip--;
+          ref--;
+        }
+        int32_t matchLen = MIN_MATCH;
+        while ( ip + matchLen < matchLimit && in[ip + matchLen] == in[ref + matchLen] )
+          matchLen++;
+
+        const int32_t ml = matchLen - MIN_MATCH;
+        op = writeLiterals(in, anchor, ip - anchor, out, op, (uint8_t)(ml >= 15 ? 15 : ml));
+        const int32_t offset = ip - ref;
+        out[op++] = (uint8_t)offset;
+        out[op++] = (uint8_t)(offset >> 8);
+        if ( ml >= 15 )
+          op = writeLength(out, op, ml - 15);
+
+        ip += matchLen;
+        anchor = ip;
+        if ( ip - 2 < mfLimit )
+          table[hash(read32(in + ip - 2))] = ip - 2;
+      }
+    }
+
+    //the rest goes out as a final sequence without a match
+    return writeLiterals(in, anchor, len - anchor, out, op, 0);
+  }
+
+  void LZ4::decompress(const uint8_t* in, const int32_t len, uint8_t* out, const int32_t outLen){
+    int32_t ip = 0;
+    int32_t op = 0;
+    while ( true ){
+      if ( ip >= len )
+        _CLTHROWA(CL_ERR_IO, "LZ4 input ends unexpectedly");
+      const uint8_t token = in[ip++];
+
+      int32_t litLen = token >> 4;
+      if ( litLen == 15 ){
+        uint8_t b;
+        do{
+          if ( ip >= len || litLen > outLen )
+            _CLTHROWA(CL_ERR_IO, "LZ4 literal length is corrupt");
+          b = in[ip++];
+          litLen += b;
+        }while ( b == 255 );
+      }
+      if ( litLen > len - ip || litLen > outLen - op )
+        _CLTHROWA(CL_ERR_IO, "LZ4 literals run past the end");
+      memcpy(out + op, in + ip, litLen);
+      ip += litLen;
+      op += litLen;
+      if ( ip == len )
+        break; //the last sequence has no match
+
+      if ( ip + 2 > len )
+        _CLTHROWA(CL_ERR_IO, "LZ4 input ends unexpectedly");
+      const int32_t offset = in[ip] | (in[ip + 1] << 8);
+      ip += 2;
+      if ( offset == 0 || offset > op )
+        _CLTHROWA(CL_ERR_IO, "LZ4 match offset is corrupt");
+
+      int32_t matchLen = token & 0x0F;
+      if ( matchLen == 15 ){
+        uint8_t b;
+        do{
+          if ( ip >= len || matchLen > outLen )
+            _CLTHROWA(CL_ERR_IO, "LZ4 match length is corrupt");
+          b = in[ip++];
+          matchLen += b;
+        }while ( b == 255 );
+      }
+      matchLen += MIN_MATCH;
+      if ( matchLen > outLen - op )
+        _CLTHROWA(CL_ERR_IO, "LZ4 match runs past the end");
+
+      const uint8_t* match = out + op - offset;
+      if ( offset >= matchLen ){
+        memcpy(out + op, match, matchLen);
+      }else{
+        //the match overlaps what it produces, so it repeats
+        for ( int32_t i = 0; i < matchLen; i++ )
+          out[op + i] = match[i];
+      }
+      op += matchLen;
+    }
+    if ( op != outLen )
+      _CLTHROWA(CL_ERR_IO, "LZ4 data has the wrong length");
+  }
+
+CL_NS_END
@@ -0,0 +1,223 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "CLucene/_ApiHeader.h"
+#include "NumericUtils.h"
+
+CL_NS_DEF(util)
+
+int32_t NumericUtils::toPrefixCoded(uint64_t sortableBits, const int32_t valSize,
+	const int32_t shift, const wchar_t shiftStart, wchar_t* buffer)
+{
+	if ( shift < 0 || shift >= valSize )
+		_CLTHROWA(CL_ERR_IllegalArgument, "shift must be between 0 and the number of bits of the value");
+
+	const int32_t nChars = (valSize - 1 - shift) / 7 + 1;
+	buffer[0] = (wchar_t)(shiftStart + shift);
+	sortableBits >>= shift;
+	for ( int32_t i = nChars; i >= 1; i-- ){
+		buffer[i] = (wchar_t)((sortableBits & 0x7f) + 1);
+		sortableBits >>= 7;
+	}
+	buffer[nChars + 1] = 0;
+	return nChars + 1;
+}
+
+uint64_t NumericUtils::fromPrefixCoded(const wchar_t* prefixCoded, const int32_t valSize,
+	const wchar_t shiftStart)
+{
+	if ( prefixCoded == NULL )
+		_CLTHROWA(CL_ERR_NullPointer, "prefixCoded cannot be null");
+
+	const int32_t shift = (int32_t)prefixCoded[0] - shiftStart;
+	if ( shift < 0 || shift >= valSize )
+		_CLTHROWA(CL_ERR_NumberFormat, "invalid shift in prefix coded term");
+
+	const int32_t nChars = (valSize - 1 - shift) / 7 + 1;
+	uint64_t sortableBits = 0;
+	for ( int32_t i = 1; i <= nChars; i++ ){
+		const int32_t ch = prefixCoded[i];
+		if ( ch < 1 || ch > 0x80 )
+			_CLTHROWA(CL_ERR_NumberFormat, "invalid character in prefix coded term");
+		sortableBits = (sortableBits << 7) | (uint64_t)(ch - 1);
+	}
+	if ( prefixCoded[nChars + 1] != 0 )
+		_CLTHROWA(CL_ERR_NumberFormat, "prefix coded term is too long");
+	return sortableBits << shift;
+}
+
+int32_t NumericUtils::longToPrefixCoded(const int64_t val, const int32_t shift, wchar_t* buffer){
+	return toPrefixCoded((uint64_t)val ^ 0x8000000000000000ULL, 64, shift, SHIFT_START_LONG, buffer);
+}
+
+std::wstring NumericUtils::longToPrefixCoded(const int64_t val){
+	wchar_t buffer[BUF_SIZE_LONG + 1];
+	const int32_t len = longToPrefixCoded(val, 0, buffer);
+	return std::wstring(buffer, len);
+}
+
+int32_t NumericUtils::intToPrefixCoded(const int32_t val, const int32_t shift, wchar_t* buffer){
+	return toPrefixCoded((uint32_t)val ^ 0x80000000U, 32, shift, SHIFT_START_INT, buffer);
+}
+
+std::wstring NumericUtils::intToPrefixCoded(const int32_t val){
+	wchar_t buffer[BUF_SIZE_INT + 1];
+	const int32_t len = intToPrefixCoded(val, 0, buffer);
+	return std::wstring(buffer, len);
+}
+
+int64_t NumericUtils::prefixCodedToLong(const wchar_t* prefixCoded){
+	return (int64_t)(fromPrefixCoded(prefixCoded, 64, SHIFT_START_LONG) ^ 0x8000000000000000ULL);
+}
+
+int32_t NumericUtils::prefixCodedToInt(const wchar_t* prefixCoded){
+	return (int32_t)((uint32_t)fromPrefixCoded(prefixCoded, 32, SHIFT_START_INT) ^ 0x80000000U);
+}
+
+int64_t NumericUtils::doubleToSortableLong(const double val){
+	int64_t bits;
+	if ( val != val ){
+		bits = 0x7ff8000000000000LL; // a single NaN
+	}else{
+		memcpy(&bits, &val, sizeof(bits));
+		if ( val == 0 )
+			bits = 0; // -0 equals 0
+	}
+	// negative values sort backwards in the bits below the sign
+	if ( bits < 0 )
+		bits ^= 0x7fffffffffffffffLL;
+	return bits;
+}
+
+double NumericUtils::sortableLongToDouble(int64_t val){
+	if ( val < 0 )
+		val ^= 0x7fffffffffffffffLL;
+	double ret;
+	memcpy(&ret, &val, sizeof(ret));
+	return ret;
+}
+
+int32_t NumericUtils::floatToSortableInt(const float val){
+	int32_t bits;
+	if ( val != val ){
+		bits = 0x7fc00000; // a single NaN
+	}else{
+		memcpy(&bits, &val, sizeof(bits));
+		if ( val == 0 )
+			bits = 0; // -0 equals 0
+	}
+	if ( bits < 0 )
+		bits ^= 0x7fffffff;
+	return bits;
+}
+
+float NumericUtils::sortableIntToFloat(int32_t val){
+	if ( val < 0 )
+		val ^= 0x7fffffff;
+	float ret;
+	memcpy(&ret, &val, sizeof(ret));
+	return ret;
+}
+
+void NumericUtils::splitLongRange(LongRangeBuilder* builder, const int32_t precisionStep,
+	const int64_t minBound, const int64_t maxBound)
+{
+	splitRange(builder, 64, precisionStep, minBound, maxBound);
+}
+
+void NumericUtils::splitIntRange(IntRangeBuilder* builder, const int32_t precisionStep,
+	const int32_t minBound, const int32_t maxBound)
+{
+	splitRange(builder, 32, precisionStep, minBound, maxBound);
+}
+
+void NumericUtils::splitRange(void* builder, const int32_t valSize, const int32_t precisionStep,
+	int64_t minBound, int64_t maxBound)
+{
+	if ( precisionStep < 1 )
+		_CLTHROWA(CL_ERR_IllegalArgument, "precisionStep must be at least 1");
+	if ( minBound > maxBound )
+		return;
+
+	for ( int32_t shift = 0; ; shift += precisionStep ){
+		// at the lowest precision all that is left is one range
+		if ( shift + precisionStep >= valSize ){
+			addRange(builder, valSize, minBound, maxBound, shift);
+			break;
+		}
+
+		// the values at the ends which the next precision would round off
+		// are added at this one. The bounds may wrap around the ends of
+		// int64_t, so they are computed unsigned
+		const uint64_t diff = (uint64_t)1 << (shift + precisionStep);
+		const uint64_t mask = (((uint64_t)1 << precisionStep) - 1) << shift;
+		const bool hasLower = ((uint64_t)minBound & mask) != 0;
+		const bool hasUpper = ((uint64_t)maxBound & mask) != mask;
+		const int64_t nextMinBound = (int64_t)((hasLower ? (uint64_t)minBound + diff : (uint64_t)minBound) & ~mask);
+		const int64_t nextMaxBound = (int64_t)((hasUpper ? (uint64_t)maxBound - diff : (uint64_t)maxBound) & ~mask);
+
+		if ( nextMinBound > nextMaxBound || nextMinBound < minBound || nextMaxBound > maxBound ){
+			// nothing is left for the next precision
+			addRange(builder, valSize, minBound, maxBound, shift);
+			break;
+		}
+
+		if ( hasLower )
+			addRange(builder, valSize, minBound, (int64_t)((uint64_t)minBound | mask), shift);
+		if ( hasUpper )
+			addRange(builder, valSize, (int64_t)((uint64_t)maxBound & ~mask), maxBound, shift);
+
+		minBound = nextMinBound;
+		maxBound = nextMaxBound;
+	}
+}
+
+void NumericUtils::addRange(void* builder, const int32_t valSize,
+	const int64_t minBound, int64_t maxBound, const int32_t shift)
+{
+	// set the bits the precision shifts away in the upper bound, so that
+	// the bounds are the first and the last value of the range
+	maxBound = (int64_t)((uint64_t)maxBound | (((uint64_t)1 << shift) - 1));
+	if ( valSize == 64 )
+		static_cast<LongRangeBuilder*>(builder)->addRange(minBound, maxBound, shift);
+	else
+		static_cast<IntRangeBuilder*>(builder)->addRange((int32_t)minBound, (int32_t)maxBound, shift);
+}
+
+NumericUtils::~NumericUtils(){
+}
+
+NumericUtils::LongRangeBuilder::~LongRangeBuilder(){
+}
+
+void NumericUtils::LongRangeBuilder::addRange(const wchar_t* /*minPrefixCoded*/, const wchar_t* /*maxPrefixCoded*/){
+}
+
+void NumericUtils::LongRangeBuilder::addRange(const int64_t min, const int64_t max, const int32_t shift){
+	wchar_t minPrefixCoded[BUF_SIZE_LONG + 1];
+	wchar_t maxPrefixCoded[BUF_SIZE_LONG + 1];
+	longToPrefixCoded(min, shift, minPrefixCoded);
+	longToPrefixCoded(max, shift, maxPrefixCoded);
+	addRange(minPrefixCoded, maxPrefixCoded);
+}
+
+NumericUtils::IntRangeBuilder::~IntRangeBuilder(){
+}
+
+void NumericUtils::IntRangeBuilder::addRange(const wchar_t* /*minPrefixCoded*/, const wchar_t* /*maxPrefixCoded*/){
+}
+
+void NumericUtils::IntRangeBuilder::addRange(const int32_t min, const int32_t max, const int32_t shift){
+	wchar_t minPrefixCoded[BUF_SIZE_INT + 1];
+	wchar_t maxPrefixCoded[BUF_SIZE_INT + 1];
+	intToPrefixCoded(min, shift, minPrefixCoded);
+	intToPrefixCoded(max, shift, maxPrefixCoded);
+	addRange(minPrefixCoded, maxPrefixCoded);
+}
+
+CL_NS_END
@@ -0,0 +1,167 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#ifndef _lucene_util_NumericUtils_
+#define _lucene_util_NumericUtils_
+
+#include "CLucene/clucene-config.h"
+
+CL_NS_DEF(util)
+
+/**
+* Converts numbers to the terms which document::NumericField indexes and
+* search::NumericRangeQuery looks up, and splits ranges of numbers into the
+* fewest ranges of those terms.
+* <p>
+* A value is indexed at several precisions: with its lowest 0, precisionStep,
+* 2*precisionStep... bits shifted away. Each precision is a term, prefix
+* coded so that terms sort like their values:
+* <pre>
+* Term  --> Shift, Chars
+* Shift --> SHIFT_START_LONG+shift or SHIFT_START_INT+shift
+* Chars --> the remaining bits of the value, with its sign bit flipped,
+*           7 bits per character from the highest, each plus 1
+* </pre>
+* Characters hold 7 bits so that they stay single bytes in UTF-8, and are
+* offset by 1 as terms cannot hold character 0. The terms of a shift all
+* have the same length, so a range of values at a shift is a range of
+* terms. A range of values is then the terms of the full precision at its
+* ends, and of ever lower precisions towards its middle: at most
+* 2*(2^precisionStep-1) terms per precision, however wide the range.
+* <p>
+* Floating point values are indexed as their bits, flipped so that they
+* sort like the values (see doubleToSortableLong()).
+*/
+class CLUCENE_EXPORT NumericUtils :LUCENE_BASE {
+public:
+	/** The precision step used when none is given */
+	LUCENE_STATIC_CONSTANT(int32_t, PRECISION_STEP_DEFAULT = 4);
+
+	/** The first character of the terms of 64 bit values is this plus the shift */
+	LUCENE_STATIC_CONSTANT(wchar_t, SHIFT_START_LONG = 0x20);
+	/** The first character of the terms of 32 bit values is this plus the shift */
+	LUCENE_STATIC_CONSTANT(wchar_t, SHIFT_START_INT = 0x60);
+
+	/** The longest term of a 64 bit value, without the terminating 0 */
+	LUCENE_STATIC_CONSTANT(int32_t, BUF_SIZE_LONG = 63/7 + 2);
+	/** The longest term of a 32 bit value, without the terminating 0 */
+	LUCENE_STATIC_CONSTANT(int32_t, BUF_SIZE_INT = 31/7 + 2);
+
+	/**
+	* Writes the term of val with its lowest shift bits shifted away, and a
+	* terminating 0, to buffer, which must hold BUF_SIZE_LONG+1 characters.
+	* Returns the length of the term.
+	*/
+	static int32_t longToPrefixCoded(const int64_t val, const int32_t shift, wchar_t* buffer);
+
+	/** Returns the term of the full precision of val */
+	static std::wstring longToPrefixCoded(const int64_t val);
+
+	/**
+	* Writes the term of val with its lowest shift bits shifted away, and a
+	* terminating 0, to buffer, which must hold BUF_SIZE_INT+1 characters.
+	* Returns the length of the term.
+	*/
+	static int32_t intToPrefixCoded(const int32_t val, const int32_t shift, wchar_t* buffer);
+
+	/** Returns the term of the full precision of val */
+	static std::wstring intToPrefixCoded(const int32_t val);
+
+	/**
+	* Returns the value of a term of a 64 bit value, with the bits which
+	* its precision shifted away 0.
+	* @throws CLuceneError CL_ERR_NumberFormat if it is not such a term
+	*/
+	static int64_t prefixCodedToLong(const wchar_t* prefixCoded);
+
+	/**
+	* Returns the value of a term of a 32 bit value, with the bits which
+	* its precision shifted away 0.
+	* @throws CLuceneError CL_ERR_NumberFormat if it is not such a term
+	*/
+	static int32_t prefixCodedToInt(const wchar_t* prefixCoded);
+
+	/** Returns the bits of val, changed so that they sort like the values
+	* when compared as an int64_t. NaN sorts above positive infinity, -0
+	* is taken as 0 */
+	static int64_t doubleToSortableLong(const double val);
+	/** Returns the value of the bits which doubleToSortableLong() returned */
+	static double sortableLongToDouble(const int64_t val);
+
+	/** Returns the bits of val, changed so that they sort like the values
+	* when compared as an int32_t. NaN sorts above positive infinity, -0
+	* is taken as 0 */
+	static int32_t floatToSortableInt(const float val);
+	/** Returns the value of the bits which floatToSortableInt() returned */
+	static float sortableIntToFloat(const int32_t val);
+
+	/** Receives the ranges of terms which splitLongRange() splits a range
+	* of 64 bit values into */
+	class CLUCENE_EXPORT LongRangeBuilder {
+	public:
+		virtual ~LongRangeBuilder();
+
+		/** Called with the terms at both ends of each range, inclusive. The
+		* default does nothing */
+		virtual void addRange(const wchar_t* minPrefixCoded, const wchar_t* maxPrefixCoded);
+
+		/** Called with the values at both ends of each range, inclusive, and
+		* the shift of its terms. The default calls the other overload with
+		* the terms of min and max */
+		virtual void addRange(const int64_t min, const int64_t max, const int32_t shift);
+	};
+
+	/** Receives the ranges of terms which splitIntRange() splits a range
+	* of 32 bit values into */
+	class CLUCENE_EXPORT IntRangeBuilder {
+	public:
+		virtual ~IntRangeBuilder();
+
+		/** Called with the terms at both ends of each range, inclusive. The
+		* default does nothing */
+		virtual void addRange(const wchar_t* minPrefixCoded, const wchar_t* maxPrefixCoded);
+
+		/** Called with the values at both ends of each range, inclusive, and
+		* the shift of its terms. The default calls the other overload with
+		* the terms of min and max */
+		virtual void addRange(const int32_t min, const int32_t max, const int32_t shift);
+	};
+
+	/**
+	* Splits the 64 bit values from minBound to maxBound, inclusive, into
+	* the fewest ranges of terms indexed with precisionStep, and passes them
+	* to builder. Does nothing if minBound is greater than maxBound.
+	* @throws CLuceneError CL_ERR_IllegalArgument if precisionStep is below 1
+	*/
+	static void splitLongRange(LongRangeBuilder* builder, const int32_t precisionStep,
+		const int64_t minBound, const int64_t maxBound);
+
+	/**
+	* Splits the 32 bit values from minBound to maxBound, inclusive, into
+	* the fewest ranges of terms indexed with precisionStep, and passes them
+	* to builder. Does nothing if minBound is greater than maxBound.
+	* @throws CLuceneError CL_ERR_IllegalArgument if precisionStep is below 1
+	*/
+	static void splitIntRange(IntRangeBuilder* builder, const int32_t precisionStep,
+		const int32_t minBound, const int32_t maxBound);
+
+	~NumericUtils();
+
+private:
+	static int32_t toPrefixCoded(uint64_t sortableBits, const int32_t valSize,
+		const int32_t shift, const wchar_t shiftStart, wchar_t* buffer);
+	static uint64_t fromPrefixCoded(const wchar_t* prefixCoded, const int32_t valSize,
+		const wchar_t shiftStart);
+	static void splitRange(void* builder, const int32_t valSize, const int32_t precisionStep,
+		int64_t minBound, int64_t maxBound);
+	static void addRange(void* builder, const int32_t valSize,
+		const int64_t minBound, int64_t maxBound, const int32_t shift);
+};
+
+CL_NS_END
+#endif
@@ -0,0 +1,70 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "CLucene/_ApiHeader.h"
+#include "PackedInts.h"
+
+CL_NS_DEF(util)
+
+
+PackedInts::PackedInts ( int32_t valueCount, int32_t bitsPerValue ):
+	valueCount(valueCount),
+	bitsPerValue(bitsPerValue)
+{
+	if ( valueCount < 0 )
+		_CLTHROWA(CL_ERR_IllegalArgument, "valueCount must not be negative");
+	if ( bitsPerValue < 1 || bitsPerValue > 64 )
+		_CLTHROWA(CL_ERR_IllegalArgument, "bitsPerValue must be between 1 and 64");
+
+	mask = bitsPerValue == 64 ? ~(uint64_t)0 : (((uint64_t)1 << bitsPerValue) - 1);
+	const int32_t blockCount = (int32_t)(((int64_t)valueCount * bitsPerValue + 63) >> 6);
+	blocks = _CL_NEWARRAY(uint64_t, blockCount + 1);
+	memset(blocks, 0, sizeof(uint64_t) * (blockCount + 1));
+}
+
+PackedInts::~PackedInts(){
+	_CLDELETE_ARRAY(blocks);
+}
+
+int32_t PackedInts::bitsRequired(int64_t maxValue){
+	CND_PRECONDITION(maxValue >= 0, "maxValue must not be negative");
+	int32_t bits = 1;
+	while ( bits < 64 && (uint64_t)maxValue >> bits != 0 )
+		bits++;
+	return bits;
+}
+
+void PackedInts::set(const int32_t index, const int64_t value){
+	CND_PRECONDITION(index >= 0 && index < valueCount, "index out of range");
+	CND_PRECONDITION(((uint64_t)value & ~mask) == 0, "value does not fit into bitsPerValue");
+	const int64_t bit = (int64_t)index * bitsPerValue;
+	const int32_t block = (int32_t)(bit >> 6);
+	const int32_t shift = (int32_t)(bit & 63);
+	const uint64_t v = (uint64_t)value & mask;
+
+	blocks[block] = (blocks[block] & ~(mask << shift)) | (v << shift);
+	if ( shift + bitsPerValue > 64 ){
+		//the rest of the value goes into the low bits of the next block
+		const int32_t done = 64 - shift;
+		blocks[block + 1] = (blocks[block + 1] & ~(mask >> done)) | (v >> done);
+	}
+}
+
+int32_t PackedInts::size() const{
+	return valueCount;
+}
+
+int32_t PackedInts::getBitsPerValue() const{
+	return bitsPerValue;
+}
+
+size_t PackedInts::ramBytesUsed() const{
+	return sizeof(PackedInts) + sizeof(uint64_t) * (size_t)((((int64_t)valueCount * bitsPerValue + 63) >> 6) + 1);
+}
+
+CL_NS_END
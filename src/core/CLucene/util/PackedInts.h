@@ -0,0 +1,61 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#ifndef _lucene_util_PackedInts_
+#define _lucene_util_PackedInts_
+
+
+CL_NS_DEF(util)
+
+
+/** A fixed size array of non-negative integers, each stored with just the
+  number of bits needed by the largest value the array has to hold. The bits
+  are packed into 64 bit blocks, values may span two blocks.
+  */
+class CLUCENE_EXPORT PackedInts:LUCENE_BASE {
+	uint64_t* blocks;
+	int32_t valueCount;
+	int32_t bitsPerValue;
+	uint64_t mask;
+
+	PackedInts( const PackedInts& copy );
+public:
+	///Create an array of valueCount zeros, with the given number of bits (1 to 64) per value
+	PackedInts ( int32_t valueCount, int32_t bitsPerValue );
+	~PackedInts();
+
+	///returns the number of bits needed to store values up to maxValue, at least 1
+	static int32_t bitsRequired(int64_t maxValue);
+
+	///get the value at the specified index
+	inline int64_t get(const int32_t index) const{
+		CND_PRECONDITION(index >= 0 && index < valueCount, "index out of range");
+		const int64_t bit = (int64_t)index * bitsPerValue;
+		const int32_t block = (int32_t)(bit >> 6);
+		const int32_t shift = (int32_t)(bit & 63);
+		uint64_t value = blocks[block] >> shift;
+		if ( shift + bitsPerValue > 64 )
+			value |= blocks[block + 1] << (64 - shift);
+		return (int64_t)(value & mask);
+	}
+
+	///set the value at the specified index. value must fit into bitsPerValue bits
+	void set(const int32_t index, const int64_t value);
+
+	///returns the number of values
+	int32_t size() const;
+
+	///returns the number of bits each value is stored with
+	int32_t getBitsPerValue() const;
+
+	///returns the memory held by the values, in bytes
+	size_t ramBytesUsed() const;
+};
+
+CL_NS_END
+#endif
@@ -0,0 +1,126 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "CLucene/_ApiHeader.h"
+#include "_VIntDecoder.h"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define LUCENE_VINT_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+CL_NS_DEF(util)
+
+#ifdef LUCENE_VINT_SSE2
+  /** index of the lowest set bit, x must not be 0 */
+  static inline int32_t lowestBit(uint32_t x){
+#ifdef _MSC_VER
+    unsigned long ret;
+    _BitScanForward(&ret, x);
+    return (int32_t)ret;
+#else
+    return __builtin_ctz(x);
+#endif
+  }
+#endif
+
+  int32_t VIntDecoder::decodeScalar(const uint8_t* in, const int32_t length,
+      int32_t* values, int32_t* ends, const int32_t maxValues){
+    int32_t n = 0;
+    int32_t pos = 0;
+    while ( n < maxValues && pos < length ){
+      //find the end of the next vint before decoding it
+      int32_t end = pos;
+      while ( end < length && (in[end] & 0x80) != 0 )
+        end++;
+      if ( end == length )
+        break; //incomplete, the caller has to read it from the stream
+
+      uint8_t b = in[pos++];
+      int32_t i = b & 0x7F;
+      for (int32_t shift = 7; (b & 0x80) != 0; shift += 7) {
+        b = in[pos++];
+        i |= (b & 0x7F) << shift;
+      }
+      values[n] = i;
+      ends[n] = pos;
+      n++;
+    }
+    return n;
+  }
+
+  int32_t VIntDecoder::decode(const uint8_t* in, const int32_t length,
+      int32_t* values, int32_t* ends, const int32_t maxValues){
+#ifdef LUCENE_VINT_SSE2
+    int32_t n = 0;
+    int32_t pos = 0;
+    const __m128i zero = _mm_setzero_si128();
+    while ( n < maxValues && pos + 16 <= length ){
+      const __m128i block = _mm_loadu_si128((const __m128i*)(in + pos));
+      //one bit per byte, set where the continuation bit is set
+      const uint32_t more = (uint32_t)_mm_movemask_epi8(block);
+
+      if ( more == 0 && n + 16 <= maxValues ){
+        //16 single byte values: widen them to int32
+        const __m128i lo = _mm_unpacklo_epi8(block, zero);
+        const __m128i hi = _mm_unpackhi_epi8(block, zero);
+        _mm_storeu_si128((__m128i*)(values + n), _mm_unpacklo_epi16(lo, zero));
+        _mm_storeu_si128((__m128i*)(values + n + 4), _mm_unpackhi_epi16(lo, zero));
+        _mm_storeu_si128((__m128i*)(values + n + 8), _mm_unpacklo_epi16(hi, zero));
+        _mm_storeu_si128((__m128i*)(values + n + 12), _mm_unpackhi_epi16(hi, zero));
+        for ( int32_t k = 0; k < 16; k++ )
+          ends[n + k] = pos + k + 1;
+        n += 16;
+        pos += 16;
+        continue;
+      }
+
+      //decode every vint that ends within this block
+      uint32_t terminators = ~more & 0xFFFF;
+      if ( terminators == 0 )
+        break; //longer than 16 bytes: leave it to the scalar loop
+      int32_t start = 0;
+      while ( terminators != 0 && n < maxValues ){
+        const int32_t last = lowestBit(terminators);
+        terminators &= terminators - 1;
+
+        const uint8_t* p = in + pos + start;
+        int32_t i = p[0] & 0x7F;
+        for ( int32_t k = 1, shift = 7; k <= last - start; k++, shift += 7 )
+          i |= (p[k] & 0x7F) << shift;
+        values[n] = i;
+        start = last + 1;
+        ends[n] = pos + start;
+        n++;
+      }
+      pos += start;
+    }
+    if ( n < maxValues && pos < length ){
+      const int32_t m = decodeScalar(in + pos, length - pos, values + n, ends + n, maxValues - n);
+      for ( int32_t k = n; k < n + m; k++ )
+        ends[k] += pos;
+      n += m;
+    }
+    return n;
+#else
+    return decodeScalar(in, length, values, ends, maxValues);
+#endif
+  }
+
+  bool VIntDecoder::hasSimd(){
+#ifdef LUCENE_VINT_SSE2
+    return true;
+#else
+    return false;
+#endif
+  }
+
+CL_NS_END
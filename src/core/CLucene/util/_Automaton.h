@@ -0,0 +1,174 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#ifndef _lucene_util_Automaton_
+#define _lucene_util_Automaton_
+
+#include "CLucene/clucene-config.h"
+#include <vector>
+
+CL_NS_DEF(util)
+
+/** A deterministic finite automaton over characters, used to find the terms
+* of a term dictionary which a query matches (see AutomatonTermEnum).
+* <p>
+* State 0 is the initial state. The transitions of a state are ranges of
+* characters, sorted and not overlapping; a character without a transition
+* is rejected. Character 0 never has a transition, as terms cannot hold it.
+* Every state is expected to lead to an accepting state, so that the
+* smallest string accepted after any state can be found without dead ends.
+* <p>
+* Once all states and transitions are added, finish() builds the table
+* which step() and run() look transitions up in: the characters at which
+* any transition starts or ends split the characters into classes which
+* every state treats alike, and the table holds the state reached from
+* each state on each class.
+*/
+class Automaton: LUCENE_BASE {
+public:
+	/** The lowest and the highest character of a transition */
+	LUCENE_STATIC_CONSTANT(int32_t, MIN_CHAR = 1);
+	LUCENE_STATIC_CONSTANT(int32_t, MAX_CHAR = WCHAR_MAX);
+
+	struct Transition {
+		wchar_t min;
+		wchar_t max;
+		int32_t dest;
+	};
+
+	Automaton();
+	~Automaton();
+
+	/** Adds a state which does not accept, returns its number */
+	int32_t createState();
+
+	void setAccept(const int32_t state, const bool accept);
+	bool isAccept(const int32_t state) const{
+		return accepts[state];
+	}
+
+	/** Adds a transition from state to dest on the characters min to max.
+	* The transitions of a state must be added in the order of their
+	* characters */
+	void addTransition(const int32_t state, const wchar_t min, const wchar_t max, const int32_t dest);
+
+	int32_t getNumStates() const{
+		return (int32_t)accepts.size();
+	}
+	int32_t getNumTransitions(const int32_t state) const{
+		return (int32_t)transitions[state].size();
+	}
+	const Transition& getTransition(const int32_t state, const int32_t i) const{
+		return transitions[state][i];
+	}
+
+	/** Builds the table of transitions, after the last state and
+	* transition are added and before step() or run() are called */
+	void finish();
+
+	/** Returns the state reached from state on c, or -1 if c is rejected */
+	int32_t step(const int32_t state, const wchar_t c) const{
+		const int32_t charClass = ((uint32_t)c < (uint32_t)LATIN1_CHARS) ? latin1Classes[c] : getClass(c);
+		return table[state * numClasses + charClass];
+	}
+
+	/** True if the automaton accepts the len characters of s */
+	bool run(const wchar_t* s, const size_t len) const;
+
+private:
+	/** The characters whose class is looked up rather than searched for */
+	LUCENE_STATIC_CONSTANT(int32_t, LATIN1_CHARS = 256);
+
+	std::vector<bool> accepts;
+	std::vector< std::vector<Transition> > transitions;
+
+	/** The first character of each class, starting with character 0 */
+	std::vector<int64_t> classStarts;
+	int32_t numClasses;
+	int32_t latin1Classes[LATIN1_CHARS];
+	std::vector<int32_t> table;
+
+	int32_t getClass(const wchar_t c) const;
+};
+
+/** A nondeterministic automaton, with transitions on no character
+* (epsilon transitions), in which the automata of patterns are put together
+* before determinize() turns them into an Automaton.
+*/
+class AutomatonBuilder: LUCENE_BASE {
+public:
+	AutomatonBuilder();
+	~AutomatonBuilder();
+
+	/** Adds a state which does not accept, returns its number. The first
+	* state added is the initial state */
+	int32_t createState();
+
+	void setAccept(const int32_t state);
+
+	/** Adds a transition from state to dest on the characters min to max,
+	* in any order */
+	void addTransition(const int32_t state, const wchar_t min, const wchar_t max, const int32_t dest);
+
+	/** Adds a transition from state to dest on no character */
+	void addEpsilon(const int32_t state, const int32_t dest);
+
+	int32_t getNumStates() const{
+		return (int32_t)accepts.size();
+	}
+
+	/**
+	* Returns the deterministic automaton accepting the same strings, or
+	* NULL if it would have more than maxStates states. The states which
+	* lead to no accepting state are left out, so if no string is accepted
+	* the automaton is a single state without transitions.
+	*/
+	Automaton* determinize(const int32_t maxStates) const;
+
+private:
+	std::vector<bool> accepts;
+	std::vector< std::vector<Automaton::Transition> > transitions;
+	std::vector< std::vector<int32_t> > epsilons;
+
+	/** Adds the states reached from states on no character, and sorts them */
+	void closure(std::vector<int32_t>& states) const;
+};
+
+/** Parses regular expressions into automata, in the syntax described by
+* search::RegexpQuery */
+class RegExp {
+public:
+	/**
+	* Returns the automaton of the length characters of pattern, or NULL if
+	* it would have more than maxStates states.
+	* @throws CLuceneError CL_ERR_Parse if pattern is not a valid expression
+	*/
+	static Automaton* toAutomaton(const wchar_t* pattern, const size_t length, const int32_t maxStates);
+};
+
+/** Builds the automata of the strings within a number of edits of a string,
+* by determinizing the nondeterministic automaton which tracks the
+* position in the string and the number of edits spent. An edit is the
+* insertion, deletion or substitution of a character and, if asked for,
+* the transposition of two adjacent characters.
+*/
+class LevenshteinAutomata {
+public:
+	/**
+	* Returns the automaton of the strings which start with the prefixLength
+	* characters of prefix and whose rest is at most maxDistance edits away
+	* from the textLength characters of text, or NULL if that automaton
+	* would have more than maxStates states.
+	*/
+	static Automaton* build(const wchar_t* prefix, const size_t prefixLength,
+		const wchar_t* text, const size_t textLength, const int32_t maxDistance,
+		const bool transpositions, const int32_t maxStates);
+};
+
+CL_NS_END
+#endif
@@ -0,0 +1,64 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#ifndef _lucene_util_ForUtil_
+#define _lucene_util_ForUtil_
+
+#include "CLucene/clucene-config.h"
+
+CL_CLASS_DEF(store,IndexInput)
+CL_CLASS_DEF(store,IndexOutput)
+
+CL_NS_DEF(util)
+
+/** Writes and reads blocks of BLOCK_LENGTH non-negative integers, bit-packed
+* with the number of bits most of them need (patched frame of reference).
+* The few values which need more bits are exceptions: their low bits are
+* packed along with the other values, their high bits after the block.
+* <p>
+* The format of a block is:
+* <pre>
+* Block      --> BitsPerValue, (AllEqual | NumExceptions, Packed, Exceptions?)
+* AllEqual   --> VInt, the value of all BLOCK_LENGTH values if BitsPerValue is 0
+* Packed     --> the low BitsPerValue bits of each value, BLOCK_LENGTH/8*BitsPerValue bytes
+* Exceptions --> ExceptionBits, NumExceptions indexes, the high ExceptionBits
+*                bits of each exception packed into as few bytes as they fit
+* BitsPerValue, NumExceptions, ExceptionBits, index --> Byte
+* </pre>
+* Bits are packed starting with the lowest bit of the first byte. The
+* size of a block can be told from its first bytes, so a block can be
+* skipped without decoding it.
+*/
+class ForUtil {
+public:
+	/** The number of values of a block */
+	LUCENE_STATIC_CONSTANT(int32_t, BLOCK_LENGTH = 128);
+
+	/** Writes BLOCK_LENGTH values, none of them negative */
+	static void writeBlock(const int32_t* values, CL_NS(store)::IndexOutput* out);
+
+	/** Reads the BLOCK_LENGTH values of a block written by writeBlock() */
+	static void readBlock(CL_NS(store)::IndexInput* in, int32_t* values);
+
+	/** Moves in past a block written by writeBlock() */
+	static void skipBlock(CL_NS(store)::IndexInput* in);
+
+private:
+	/** Packs the low bits bits of count values into (count*bits+7)/8 bytes */
+	static void pack(const uint32_t* values, const int32_t count, const int32_t bits, uint8_t* out);
+
+	/** Unpacks count values of bits bits */
+	static void unpack(const uint8_t* in, const int32_t count, const int32_t bits, uint32_t* values);
+
+	/** Reads and unpacks count values of bits bits, straight out of the
+	* buffer of in if it holds all of their bytes */
+	static void readPacked(CL_NS(store)::IndexInput* in, const int32_t count, const int32_t bits, uint32_t* values);
+};
+
+CL_NS_END
+#endif
@@ -0,0 +1,39 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#ifndef _lucene_util_LZ4_H
+#define _lucene_util_LZ4_H
+
+namespace lucene {
+    namespace util {
+
+        /** A fast LZ77 codec writing the LZ4 block format: a token byte with
+         * the literal and match lengths, the literals, then a 2 byte offset
+         * back into the output. It trades ratio for speed, decompression is
+         * little more than memcpy. Used for compressed stored field blocks.
+         */
+        class LZ4
+        {
+        public:
+            /** The largest size compress() can produce for len input bytes */
+            static int32_t compressBound(const int32_t len);
+
+            /** Compresses len bytes of in into out, which must hold
+            * compressBound(len) bytes. Returns the compressed length.
+            */
+            static int32_t compress(const uint8_t* in, const int32_t len, uint8_t* out);
+
+            /** Decompresses len bytes of in into out, which must hold exactly
+            * outLen bytes. Throws CL_ERR_IO if in is not valid or does not
+            * decompress to outLen bytes.
+            */
+            static void decompress(const uint8_t* in, const int32_t len, uint8_t* out, const int32_t outLen);
+        };
+
+    }
+}
+#endif
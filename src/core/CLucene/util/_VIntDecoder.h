@@ -0,0 +1,45 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#ifndef _lucene_util_VIntDecoder_H
+#define _lucene_util_VIntDecoder_H
+
+namespace lucene {
+    namespace util {
+
+        /** Decodes runs of VInts (as written by IndexOutput::writeVInt) straight
+         * out of a byte buffer, instead of one readByte() at a time.
+         * Where SSE2 is available, 16 bytes are classified at once and blocks
+         * of single byte values (the common case for doc deltas and freqs) are
+         * widened without branching; other builds use the scalar loop only.
+         */
+        class VIntDecoder
+        {
+        public:
+            /**
+            * Decodes up to maxValues VInts from the first length bytes of in.
+            * Decoding stops early at the first VInt that is not complete within
+            * length, so no byte past in+length is ever read.
+            * \param values receives the decoded values
+            * \param ends receives, for each decoded value, the offset in in
+            *        just past its last byte
+            * \return the number of values decoded
+            */
+            static int32_t decode(const uint8_t* in, const int32_t length,
+                int32_t* values, int32_t* ends, const int32_t maxValues);
+
+            /** Same as decode(), but never uses the SIMD path. */
+            static int32_t decodeScalar(const uint8_t* in, const int32_t length,
+                int32_t* values, int32_t* ends, const int32_t maxValues);
+
+            /** True if decode() was compiled with the SIMD path. */
+            static bool hasSimd();
+        };
+
+    }
+}
+#endif
@@ -20,6 +20,8 @@ namespace lucene {
 
 #define _LUCENE_ATOMIC_INC(theInteger) CL_NS(util)::mutex_thread::atomic_increment(theInteger)
 #define _LUCENE_ATOMIC_DEC(theInteger) CL_NS(util)::mutex_thread::atomic_decrement(theInteger)
+#define _LUCENE_ATOMIC_ADD64(theInteger, delta) CL_NS(util)::mutex_thread::atomic_add64(theInteger, delta)
+#define _LUCENE_ATOMIC_GET64(theInteger) CL_NS(util)::mutex_thread::atomic_add64(theInteger, 0)
 
 #ifdef _M_X64
     #define _LUCENE_ATOMIC_INT long long
@@ -30,6 +32,9 @@ namespace lucene {
 #define _LUCENE_ATOMIC_INT_SET(x,v) x=v
 #define _LUCENE_ATOMIC_INT_GET(x) x
 
+#define _LUCENE_ATOMIC_PTR_GET(thePointer) CL_NS(util)::mutex_thread::atomic_get_ptr((void* volatile*)(thePointer))
+#define _LUCENE_ATOMIC_PTR_SET(thePointer, value) CL_NS(util)::mutex_thread::atomic_set_ptr((void* volatile*)(thePointer), value)
+
         //typedef void (__stdcall luceneThreadStartRoutine)(void* lpThreadParameter );
         typedef void(__cdecl*   luceneThreadStartRoutine)(void*);
         class CLUCENE_SHARED_EXPORT mutex_thread
@@ -37,6 +42,7 @@ namespace lucene {
         private:
             struct Internal;
             Internal* _internal;
+            friend class shared_condition;
         public:
             mutex_thread(const mutex_thread& clone);
             mutex_thread();
@@ -45,11 +51,20 @@ namespace lucene {
             void unlock();
             static void _exitThread(int ret);
             static _LUCENE_THREADID_TYPE _GetCurrentThreadId();
+            /** starts a thread, which must be passed to JoinThread once */
             static _LUCENE_THREADID_TYPE CreateThread(luceneThreadStartRoutine func, void* arg);
+            /** waits for the thread to exit and releases it */
             static void JoinThread(_LUCENE_THREADID_TYPE id);
 
             static int32_t atomic_increment(_LUCENE_ATOMIC_INT* theInteger);
             static int32_t atomic_decrement(_LUCENE_ATOMIC_INT* theInteger);
+            /** adds delta to a 64 bit counter and returns the new value */
+            static int64_t atomic_add64(volatile int64_t* theInteger, int64_t delta);
+            /** reads a pointer set with atomic_set_ptr. Once the new value is
+             *  seen, so is everything written before it was set */
+            static void* atomic_get_ptr(void* volatile* thePointer);
+            /** sets a pointer for other threads to read with atomic_get_ptr */
+            static void atomic_set_ptr(void* volatile* thePointer, void* value);
         };
 
         class CLUCENE_SHARED_EXPORT shared_condition
@@ -25,13 +25,18 @@
 #define _CL_HAVE_FUNCTION_WCSTOLL 1
 #define _CL_HAVE_FUNCTION_WCSUPR 1
 /* #undef _CL_HAVE_FUNCTION_GETTIMEOFDAY */
-#define _CL_HAVE_FUNCTION_MAPVIEWOFFILE 1
+#if defined(_WIN32) || defined(_WIN64)
+	#define _CL_HAVE_FUNCTION_MAPVIEWOFFILE 1
+#endif
 
 /* #undef _CL_HAVE_FUNCTION_LLTOA */
 /* #undef _CL_HAVE_FUNCTION_LLTOW */
 /* #undef _CL_HAVE_FUNCTION_PRINTF */
 /* #undef _CL_HAVE_FUNCTION_SNPRINTF */
-/* #undef _CL_HAVE_FUNCTION_MMAP */
+#if !defined(_WIN32) && !defined(_WIN64)
+	#define _CL_HAVE_FUNCTION_MMAP 1
+	#define _CL_HAVE_FUNCTION_PREAD 1
+#endif
 #define _CL_HAVE_FUNCTION_STRLWR 1
 #define _CL_HAVE_FUNCTION_STRTOLL 1
 #define _CL_HAVE_FUNCTION_STRUPR 1
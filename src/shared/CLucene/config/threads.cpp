@@ -60,7 +60,7 @@ CL_NS_DEF(util)
       return GetCurrentThreadId();
   }
   void mutex_thread::_exitThread(int val){
-  	ExitThread(val);
+  	_endthreadex(val);
   }
 
   int32_t mutex_thread::atomic_increment(_LUCENE_ATOMIC_INT *theInteger){
@@ -77,17 +77,27 @@ CL_NS_DEF(util)
     return InterlockedDecrement(theInteger);
 #endif
   }
+  int64_t mutex_thread::atomic_add64(volatile int64_t *theInteger, int64_t delta){
+    return InterlockedExchangeAdd64(theInteger, delta) + delta;
+  }
+  // the interlocked functions are full barriers, so the pointer is read
+  // and written with acquire and release semantics
+  void* mutex_thread::atomic_get_ptr(void* volatile* thePointer){
+    return InterlockedCompareExchangePointer(thePointer, NULL, NULL);
+  }
+  void mutex_thread::atomic_set_ptr(void* volatile* thePointer, void* value){
+    InterlockedExchangePointer(thePointer, value);
+  }
 
 
 
+	// A condition variable rather than an auto reset event, so that
+	// NotifyAll wakes every waiting thread and not just one of them.
 	class shared_condition::Internal{
 	public:
-	    void* _event;
+	    CONDITION_VARIABLE _cond;
 	    Internal(){
-	    	_event = CreateEvent( NULL, false, false, NULL );
-	    }
-	    ~Internal(){
-	    	CloseHandle( _event );
+	    	InitializeConditionVariable( &_cond );
 	    }
 	};
 	shared_condition::shared_condition(){
@@ -99,26 +109,47 @@ CL_NS_DEF(util)
 	
     void shared_condition::Wait(mutex_thread* shared_lock)
     {
-        shared_lock->unlock();
-        DWORD dwRes = WaitForSingleObject( _internal->_event, 0xFFFFFFFF );
-		assert ( 0x0 == dwRes );
-        shared_lock->lock();
+        BOOL bRes = SleepConditionVariableCS( &_internal->_cond, &shared_lock->_internal->mtx, INFINITE );
+		assert ( bRes );
 	}
 	
     void shared_condition::NotifyAll()
     {
-		bool bRes = SetEvent(_internal->_event);
-        assert( bRes );
+		WakeAllConditionVariable( &_internal->_cond );
+	}
+
+	struct ThreadStart{
+	    luceneThreadStartRoutine func;
+	    void* arg;
+	};
+	static unsigned __stdcall threadStart(void* arg){
+	    ThreadStart* start = (ThreadStart*)arg;
+	    luceneThreadStartRoutine func = start->func;
+	    void* funcArg = start->arg;
+	    delete start;
+	    func(funcArg);
+	    return 0;
 	}
 
+	// _beginthreadex rather than _beginthread, whose handle is closed as
+	// soon as the thread exits, so could not be waited on. The handle stays
+	// valid until JoinThread closes it, so every thread must be joined.
 	_LUCENE_THREADID_TYPE mutex_thread::CreateThread(luceneThreadStartRoutine func, void* arg)
     {
-	    return (_LUCENE_THREADID_TYPE) ::_beginthread (func, 0, arg);
+	    ThreadStart* start = new ThreadStart;
+	    start->func = func;
+	    start->arg = arg;
+	    uintptr_t handle = ::_beginthreadex (NULL, 0, &threadStart, start, 0, NULL);
+	    if ( handle == 0 )
+	        delete start;
+	    assert ( handle != 0 );
+	    return (_LUCENE_THREADID_TYPE) handle;
 	}
 
 	void mutex_thread::JoinThread(_LUCENE_THREADID_TYPE id)
     {
-	    WaitForSingleObject((void*)id, INFINITE);
+	    WaitForSingleObject((HANDLE)id, INFINITE);
+	    CloseHandle((HANDLE)id);
 	}
 
 
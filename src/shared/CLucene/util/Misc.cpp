@@ -72,7 +72,7 @@ namespace lucene
             // Compute the hash code using a local variable to be reentrant.
             size_t hashCode = 0;
             for (size_t i = 0; i < len && str[i] != NULL; i++)
-                hashCode = hashCode * 31 + *str++;
+                hashCode = hashCode * 31 + str[i];
             return hashCode;
         }
 
@@ -53,6 +53,8 @@
 #include "search/TestExtractTerms.cpp"
 #include "search/TestForDuplicates.cpp"
 #include "search/TestIndexSearcher.cpp"
+#include "search/TestNumericRange.cpp"
+#include "search/TestQueryCache.cpp"
 #include "search/TestQueries.cpp"
 #include "search/TestRangeFilter.cpp"
 #include "search/TestSearch.cpp"
@@ -64,6 +66,7 @@
 #include "store/TestStore.cpp"
 #include "util/English.cpp"
 #include "util/TestBitSet.cpp"
+#include "util/TestPackedInts.cpp"
 #include "util/TestPriorityQueue.cpp"
 #include "util/TestStringBuffer.cpp"
 
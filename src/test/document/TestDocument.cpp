@@ -8,6 +8,7 @@
 ------------------------------------------------------------------------------*/
 #include "test.h"
 #include "CLucene/document/FieldSelector.h"
+#include "CLucene/document/StoredFieldVisitor.h"
 
 //an in memory input stream for testing binary data
 class MemReader: public CL_NS(util)::Reader{
@@ -288,6 +289,96 @@ public:
   }
 
 
+  // records the fields it is given, skips `skip' and stops at `stop'
+  class RecordingVisitor: public StoredFieldVisitor{
+  public:
+    const wchar_t* skip;
+    const wchar_t* stop;
+    std::vector<std::wstring> names;
+    std::vector<std::string> values;
+    bool lengthsOk;
+
+    RecordingVisitor(const wchar_t* skip = NULL, const wchar_t* stop = NULL):
+      skip(skip), stop(stop), lengthsOk(true)
+    {
+    }
+    Status needsField(const wchar_t* fieldName){
+      if ( stop != NULL && wcscmp(fieldName, stop) == 0 )
+        return STOP;
+      if ( skip != NULL && wcscmp(fieldName, skip) == 0 )
+        return NO;
+      return YES;
+    }
+    void stringField(const wchar_t* fieldName, const wchar_t* value, const int32_t length){
+      if ( (int32_t)wcslen(value) != length )
+        lengthsOk = false;
+      names.push_back(fieldName);
+      std::string v;
+      for ( int32_t i = 0; i < length; i++ )
+        v += (char)value[i];
+      values.push_back(v);
+    }
+    void binaryField(const wchar_t* fieldName, const uint8_t* value, const int32_t length){
+      names.push_back(fieldName);
+      values.push_back(std::string((const char*)value, length));
+    }
+  };
+
+  void TestStoredFieldVisitor(CuTest *tc){
+    RAMDirectory dir;
+    WhitespaceAnalyzer a;
+    // the second segment stores its fields in compressed blocks
+    for ( int32_t s = 0; s < 2; s++ ){
+      IndexWriter w(&dir, &a, s == 0);
+      if ( s == 1 )
+        w.setStoredFieldsCompression(IndexWriter::STORED_FIELDS_FAST);
+      for ( int32_t i = 0; i < 3; i++ ){
+        char bin[20];
+        wchar_t title[20];
+        _snprintf(bin, 20, "bin%d", i);
+        _snwprintf(title, 20, _T("title%d"), i);
+        ValueArray<uint8_t> b((uint8_t*)bin, strlen(bin));
+
+        Document doc;
+        doc.add(*_CLNEW Field(_T("title"), title, Field::STORE_YES | Field::INDEX_UNTOKENIZED));
+        doc.add(*_CLNEW Field(_T("bin"), &b, Field::STORE_YES, true));
+        doc.add(*_CLNEW Field(_T("cbin"), &b, Field::STORE_COMPRESS, true));
+        doc.add(*_CLNEW Field(_T("body"), _T("compressed body"), Field::STORE_COMPRESS | Field::INDEX_TOKENIZED));
+        doc.add(*_CLNEW Field(_T("tail"), _T("last"), Field::STORE_YES | Field::INDEX_NO));
+        w.addDocument(&doc);
+        b.takeArray();
+      }
+      w.close();
+    }
+
+    IndexReader* reader = IndexReader::open(&dir);
+    IndexSearcher searcher(reader);
+    CLUCENE_ASSERT(reader->maxDoc() == 6);
+    for ( int32_t n = 0; n < 6; n++ ){
+      char expected[20];
+      _snprintf(expected, 20, "%d", n % 3);
+
+      RecordingVisitor all;
+      CLUCENE_ASSERT(searcher.doc(n, all));
+      CLUCENE_ASSERT(all.names.size() == 5);
+      CLUCENE_ASSERT(all.lengthsOk);
+      CLUCENE_ASSERT(all.names[0] == _T("title") && all.values[0] == std::string("title") + expected);
+      CLUCENE_ASSERT(all.names[1] == _T("bin") && all.values[1] == std::string("bin") + expected);
+      CLUCENE_ASSERT(all.names[2] == _T("cbin") && all.values[2] == std::string("bin") + expected);
+      CLUCENE_ASSERT(all.names[3] == _T("body") && all.values[3] == "compressed body");
+      CLUCENE_ASSERT(all.names[4] == _T("tail") && all.values[4] == "last");
+
+      // skipped fields are not passed on, nothing after a stop is read
+      RecordingVisitor some(_T("bin"), _T("body"));
+      CLUCENE_ASSERT(reader->document(n, some));
+      CLUCENE_ASSERT(some.names.size() == 2);
+      CLUCENE_ASSERT(some.names[0] == _T("title") && some.names[1] == _T("cbin"));
+    }
+
+    searcher.close();
+    reader->close();
+    _CLDELETE(reader);
+  }
 
 CuSuite *testdocument(void)
 {
@@ -299,6 +390,7 @@ CuSuite *testdocument(void)
   SUITE_ADD_TEST(suite, TestLazyBinaryDocument);
 	SUITE_ADD_TEST(suite, TestFieldSelectors);
 	SUITE_ADD_TEST(suite, TestFields);
+	SUITE_ADD_TEST(suite, TestStoredFieldVisitor);
 	//SUITE_ADD_TEST(suite, TestDateTools);
     return suite;
 }
@@ -11,6 +11,9 @@
 #include "CLucene/index/_SegmentHeader.h"
 #include "CLucene/index/_MultiSegmentReader.h"
 #include "CLucene/index/MultiReader.h"
+#include "CLucene/index/_FieldInfos.h"
+#include "CLucene/index/_IndexFileNames.h"
+#include "IndexWriter4Test.h"
 
 typedef IndexReader* (*TestIRModifyIndex)(CuTest* tc, IndexReader* reader, int modify);
 DEFINE_MUTEX(createReaderMutex)
@@ -300,11 +303,316 @@ void testMultiReaderReopen(CuTest *tc){
   //_CLDELETE(index2B);
 }
 
+// read() decodes whole blocks of the freq stream at once, make sure
+// it agrees with next() across buffer boundaries and deleted docs
+void checkTermDocsRead(CuTest* tc, Directory* dir){
+  WhitespaceAnalyzer analyzer;
+  IndexWriter w(dir, &analyzer, true);
+  Document doc;
+  for (int i = 0; i < 3000; i++) {
+    std::wstring text;
+    // mostly freq 1, sometimes larger freqs and larger doc gaps
+    int freq = (i % 7 == 0) ? 1 + (i % 300) : 1;
+    if ( i % 13 != 0 ){
+      for ( int j = 0; j < freq; j++ )
+        text.append(_T("x "));
+    }
+    text.append(_T("y"));
+    doc.clear();
+    doc.add(* _CLNEW Field(_T("content"), text.c_str(), Field::STORE_NO | Field::INDEX_TOKENIZED));
+    w.addDocument(&doc);
+  }
+  w.optimize();
+  w.close();
+
+  IndexReader* reader = IndexReader::open(dir);
+  for ( int i = 0; i < 3000; i += 17 )
+    reader->deleteDocument(i);
+
+  Term* t = _CLNEW Term(_T("content"), _T("x"));
+  const int32_t lengths[] = { 1, 3, 32, 4000 };
+  int32_t docs[4000];
+  int32_t freqs[4000];
+  for ( size_t l = 0; l < sizeof(lengths)/sizeof(lengths[0]); l++ ){
+    TermDocs* expected = reader->termDocs(t);
+    TermDocs* actual = reader->termDocs(t);
+    int32_t total = 0;
+    int32_t n;
+    while ( (n = actual->read(docs, freqs, lengths[l])) > 0 ){
+      CuAssertTrue(tc, n <= lengths[l]);
+      for ( int32_t i = 0; i < n; i++ ){
+        CuAssertTrue(tc, expected->next());
+        CuAssertIntEquals(tc, _T("doc"), expected->doc(), docs[i]);
+        CuAssertIntEquals(tc, _T("freq"), expected->freq(), freqs[i]);
+      }
+      total += n;
+    }
+    CuAssertTrue(tc, !expected->next());
+    CuAssertTrue(tc, total > 2000);
+    _CLLDELETE(expected);
+    _CLLDELETE(actual);
+  }
+
+  // mixing read() with skipTo() and next()
+  TermDocs* expected = reader->termDocs(t);
+  TermDocs* actual = reader->termDocs(t);
+  CuAssertIntEquals(tc, _T("read"), 5, actual->read(docs, freqs, 5));
+  for ( int32_t i = 0; i < 5; i++ )
+    CuAssertTrue(tc, expected->next());
+  CuAssertTrue(tc, actual->skipTo(1500));
+  CuAssertTrue(tc, expected->skipTo(1500));
+  CuAssertIntEquals(tc, _T("doc"), expected->doc(), actual->doc());
+  int32_t n;
+  while ( (n = actual->read(docs, freqs, 10)) > 0 ){
+    for ( int32_t i = 0; i < n; i++ ){
+      CuAssertTrue(tc, expected->next());
+      CuAssertIntEquals(tc, _T("doc"), expected->doc(), docs[i]);
+      CuAssertIntEquals(tc, _T("freq"), expected->freq(), freqs[i]);
+    }
+    if ( actual->next() ){
+      CuAssertTrue(tc, expected->next());
+      CuAssertIntEquals(tc, _T("doc"), expected->doc(), actual->doc());
+    }
+  }
+  CuAssertTrue(tc, !expected->next());
+  _CLLDELETE(expected);
+  _CLLDELETE(actual);
+
+  _CLDECDELETE(t);
+  reader->close();
+  _CLLDELETE(reader);
+}
+
+void testTermDocsRead(CuTest *tc){
+  RAMDirectory ram;
+  checkTermDocsRead(tc, &ram);
+
+  wchar_t fsdir[CL_MAX_PATH];
+  _snwprintf(fsdir,CL_MAX_PATH,L"%s/%s", cl_tempDir, L"termdocsread");
+  FSDirectory* fs = FSDirectory::getDirectory(fsdir);
+  checkTermDocsRead(tc, fs);
+  fs->close();
+  _CLDECDELETE(fs);
+}
+
+// the term index is prefix coded in blocks and lookups go through the term
+// cache, check both agree with the term dictionary for every term
+void checkTermInfosReader(CuTest* tc, Directory* dir, const wchar_t* seg, FieldInfos* fieldInfos, int32_t indexDivisor){
+  TermInfosReader tis(dir, seg, fieldInfos);
+  tis.setIndexDivisor(indexDivisor);
+  CuAssertIntEquals(tc, _T("size"), 4000, (int32_t)tis.size());
+
+  wchar_t buf[20];
+  for ( int32_t pass = 0; pass < 2; pass++ ){
+    // look the terms up out of order, so that most lookups seek. The second
+    // pass repeats the last lookups only, which still fit into the cache
+    for ( int32_t i = pass == 0 ? 0 : 1800; i < 2000; i++ ){
+      const int32_t n = (i * 7919) % 2000;
+      _snwprintf(buf, 20, _T("t%05d"), n);
+      Term a(_T("a"), buf);
+      TermInfo* ti = tis.get(&a);
+      CuAssertTrue(tc, ti != NULL);
+      CuAssertIntEquals(tc, _T("docFreq"), 1 + (n % 3), ti->docFreq);
+      _CLDELETE(ti);
+
+      _snwprintf(buf, 20, _T("\x00e9\x4e2d%05d"), n);
+      Term b(_T("b"), buf);
+      ti = tis.get(&b);
+      CuAssertTrue(tc, ti != NULL);
+      CuAssertIntEquals(tc, _T("docFreq"), 1 + (n % 3), ti->docFreq);
+      _CLDELETE(ti);
+    }
+  }
+  // the second pass should have been answered from the cache
+  if ( LUCENE_TERMINFOS_CACHE_SIZE > 0 )
+    CuAssertTrue(tc, tis.getCacheHits() > 0);
+  CuAssertTrue(tc, tis.getIndexRamBytesUsed() > 0);
+
+  // terms that are not in the dictionary, before, between and after the others
+  const wchar_t* missing[] = { _T("0"), _T("t"), _T("t00010x"), _T("t99999"), _T("\x00e9") };
+  for ( size_t i = 0; i < sizeof(missing)/sizeof(missing[0]); i++ ){
+    Term a(_T("a"), missing[i]);
+    CuAssertTrue(tc, tis.get(&a) == NULL);
+    Term b(_T("b"), missing[i]);
+    CuAssertTrue(tc, tis.get(&b) == NULL);
+  }
+  Term c(_T("c"), _T("t00010"));
+  CuAssertTrue(tc, tis.get(&c) == NULL);
+
+  // terms looked up in order are scanned for, and compared with the next
+  // index term the enumerator keeps
+  for ( int32_t n = 0; n < 2000; n++ ){
+    _snwprintf(buf, 20, _T("t%05dx"), n);
+    Term x(_T("a"), buf);
+    CuAssertTrue(tc, tis.get(&x) == NULL);
+    _snwprintf(buf, 20, _T("\x00e9\x4e2d%05d"), n);
+    Term b(_T("b"), buf);
+    TermInfo* ti = tis.get(&b);
+    CuAssertTrue(tc, ti != NULL);
+    CuAssertIntEquals(tc, _T("docFreq"), 1 + (n % 3), ti->docFreq);
+    _CLDELETE(ti);
+  }
+
+  // enumerations start at the term and continue in sorted order
+  for ( int32_t n = 0; n < 2000; n += 37 ){
+    _snwprintf(buf, 20, _T("t%05d"), n);
+    Term a(_T("a"), buf);
+    SegmentTermEnum* e = tis.terms(&a);
+    CuAssertTrue(tc, e->term(false) != NULL && a.equals(e->term(false)));
+    CuAssertTrue(tc, e->next());
+    if ( n < 1999 ){
+      _snwprintf(buf, 20, _T("t%05d"), n + 1);
+      CuAssertStrEquals(tc, _T("next term"), buf, e->term(false)->text());
+    }
+    _CLDELETE(e);
+  }
+  tis.close();
+}
+
+void testTermInfosReader(CuTest* tc){
+  RAMDirectory dir;
+  WhitespaceAnalyzer analyzer;
+  IndexWriter4Test w(&dir, &analyzer, true);
+  w.setUseCompoundFile(false);
+  w.setMaxBufferedDocs(10000);
+  // a small interval gives an index that spans many blocks
+  w.setTermIndexInterval(4);
+  Document doc;
+  wchar_t buf[20];
+  for (int32_t n = 0; n < 2000; n++) {
+    for (int32_t j = 0; j <= n % 3; j++) {
+      doc.clear();
+      _snwprintf(buf, 20, _T("t%05d"), n);
+      doc.add(* _CLNEW Field(_T("a"), buf, Field::STORE_NO | Field::INDEX_UNTOKENIZED));
+      _snwprintf(buf, 20, _T("\x00e9\x4e2d%05d"), n);
+      doc.add(* _CLNEW Field(_T("b"), buf, Field::STORE_NO | Field::INDEX_UNTOKENIZED));
+      w.addDocument(&doc);
+    }
+  }
+  w.flush();
+  std::wstring seg = w.newestSegment()->name;
+  w.close();
+
+  std::wstring fnm = seg;
+  fnm.append(L".");
+  fnm.append(IndexFileNames::FIELD_INFOS_EXTENSION);
+  FieldInfos fieldInfos(&dir, fnm.c_str());
+
+  checkTermInfosReader(tc, &dir, seg.c_str(), &fieldInfos, 1);
+  checkTermInfosReader(tc, &dir, seg.c_str(), &fieldInfos, 3);
+}
+
+void testFieldInfosFormat(CuTest* tc){
+  RAMDirectory ram;
+  Directory* dir = &ram;
+
+  // a Lucene 2.4 file, where 0x40 is OMIT_TF and not doc values
+  IndexOutput* out = dir->createOutput(_T("old.fnm"));
+  out->writeVInt(1);
+  out->writeString(_T("a"), 1);
+  out->writeByte(FieldInfos::IS_INDEXED | 0x40);
+  out->close();
+  _CLDELETE(out);
+  FieldInfos old(dir, _T("old.fnm"));
+  CuAssertTrue(tc, old.fieldInfo(_T("a"))->isIndexed);
+  CuAssertIntEquals(tc, _T("docValuesType"), 0, old.fieldInfo(_T("a"))->docValuesType);
+
+  // without doc values the file keeps the old format
+  FieldInfos fis;
+  fis.add(_T("a"), true);
+  fis.add(_T("b"), false);
+  fis.write(dir, _T("plain.fnm"));
+  IndexInput* in = dir->openInput(_T("plain.fnm"));
+  CuAssertIntEquals(tc, _T("size"), 2, in->readVInt());
+  in->close();
+  _CLDELETE(in);
+
+  fis.fieldInfo(_T("b"))->setDocValuesType(FieldInfos::DOC_VALUES_SORTED);
+  fis.write(dir, _T("dv.fnm"));
+  in = dir->openInput(_T("dv.fnm"));
+  CuAssertIntEquals(tc, _T("format"), FieldInfos::FORMAT_DOC_VALUES, in->readVInt());
+  in->close();
+  _CLDELETE(in);
+  FieldInfos dv(dir, _T("dv.fnm"));
+  CuAssertTrue(tc, dv.fieldInfo(_T("a"))->isIndexed);
+  CuAssertIntEquals(tc, _T("docValuesType"), 0, dv.fieldInfo(_T("a"))->docValuesType);
+  CuAssertTrue(tc, !dv.fieldInfo(_T("b"))->isIndexed);
+  CuAssertIntEquals(tc, _T("docValuesType"), FieldInfos::DOC_VALUES_SORTED, dv.fieldInfo(_T("b"))->docValuesType);
+}
+
+void testMaxNorm(CuTest* tc){
+  RAMDirectory dir;
+  WhitespaceAnalyzer analyzer;
+  IndexWriter w(&dir, &analyzer, true);
+  const wchar_t* texts[] = { _T("a b c d"), _T("a"), _T("a b") };
+  for ( int32_t i = 0; i < 3; i++ ){
+    Document doc;
+    doc.add(* _CLNEW Field(_T("f"), texts[i], Field::STORE_NO | Field::INDEX_TOKENIZED));
+    w.addDocument(&doc);
+  }
+  w.close();
+
+  IndexReader* reader = IndexReader::open(&dir);
+  const uint8_t* norms = reader->norms(_T("f"));
+  // the shortest document has the largest norm
+  const uint8_t top = norms[1];
+  CuAssertTrue(tc, norms[0] < top && norms[2] < top);
+  CuAssertIntEquals(tc, _T("maxNorm"), top, reader->maxNorm(_T("f")));
+
+  // the cached maximum follows changed norms
+  reader->setNorm(0, _T("f"), (uint8_t)(top + 1));
+  CuAssertIntEquals(tc, _T("maxNorm"), top + 1, reader->maxNorm(_T("f")));
+  reader->close();
+  _CLDELETE(reader);
+}
+
+void testSharedTermIndexDivisor(CuTest* tc){
+  RAMDirectory dir;
+  WhitespaceAnalyzer analyzer;
+  IndexWriter w(&dir, &analyzer, true);
+  for ( int32_t i = 0; i < 2; i++ ){
+    Document doc;
+    doc.add(* _CLNEW Field(_T("f"), _T("a b"), Field::STORE_NO | Field::INDEX_TOKENIZED));
+    w.addDocument(&doc);
+  }
+  w.close();
+
+  IndexReader* reader = IndexReader::open(&dir);
+  IndexReader* modifier = IndexReader::open(&dir);
+  modifier->deleteDocument(0);
+  modifier->close();
+  _CLDELETE(modifier);
+
+  // the reopened reader shares the term index of reader
+  IndexReader* reader2 = reader->reopen();
+  CuAssertTrue(tc, reader2 != reader);
+  try {
+    reader2->setTermInfosIndexDivisor(2);
+    CuFail(tc, _T("the divisor of a shared term index was changed"));
+  } catch (CLuceneError& err) {
+    CuAssertIntEquals(tc, _T("error"), CL_ERR_IllegalState, err.number());
+  }
+  CuAssertIntEquals(tc, _T("divisor"), 1, reader->getTermInfosIndexDivisor());
+
+  // once reader2 is the only reader of the term index it may change it
+  reader->close();
+  _CLDELETE(reader);
+  reader2->setTermInfosIndexDivisor(2);
+  CuAssertIntEquals(tc, _T("divisor"), 2, reader2->getTermInfosIndexDivisor());
+  reader2->close();
+  _CLDELETE(reader2);
+}
+
 CuSuite *testindexreader(void)
 {
 	CuSuite *suite = CuSuiteNew(_T("CLucene IndexReader Test"));
   SUITE_ADD_TEST(suite, testIndexReaderReopen);
   SUITE_ADD_TEST(suite, testMultiReaderReopen);
+  SUITE_ADD_TEST(suite, testTermDocsRead);
+  SUITE_ADD_TEST(suite, testTermInfosReader);
+  SUITE_ADD_TEST(suite, testFieldInfosFormat);
+  SUITE_ADD_TEST(suite, testMaxNorm);
+  SUITE_ADD_TEST(suite, testSharedTermIndexDivisor);
 
   return suite;
 }
@@ -8,6 +8,9 @@
 ------------------------------------------------------------------------------*/
 #include "test.h"
 #include <CLucene/search/MatchAllDocsQuery.h>
+#include "CLucene/index/MergeScheduler.h"
+#include "CLucene/document/FieldSelector.h"
+#include "IndexWriter4Test.h"
 #include <stdio.h>
 
 //checks if a merged index finds phrases correctly
@@ -647,6 +650,640 @@ void testMergeIndex(CuTest* tc) {
   _CLLDELETE( dir );
 }
 
+void testConcurrentMergeScheduler(CuTest* tc) {
+    RAMDirectory dir;
+    SimpleAnalyzer a;
+    ConcurrentMergeScheduler::clearUnhandledExceptions();
+
+    IndexWriter* writer = _CLNEW IndexWriter(&dir, &a, true);
+    ConcurrentMergeScheduler* cms = _CLNEW ConcurrentMergeScheduler();
+    cms->setMaxThreadCount(2);
+    cms->setMaxPendingMerges(0); // stall addDocument as soon as both threads are busy
+    writer->setMergeScheduler(cms);
+    writer->setMaxBufferedDocs(2);
+    writer->setMergeFactor(3);
+    writer->setUseCompoundFile(false);
+
+    wchar_t fld[1000];
+    for ( int i=0;i<300;i++ ){
+        English::IntToEnglish(i,fld,1000);
+        Document doc;
+        doc.add ( *_CLNEW Field(_T("field0"),fld,Field::STORE_YES | Field::INDEX_TOKENIZED) );
+        writer->addDocument(&doc);
+    }
+    cms->sync();
+    CLUCENE_ASSERT(cms->mergeThreadCount() == 0);
+
+    writer->optimize();
+    writer->close();
+    _CLLDELETE(writer);
+    CLUCENE_ASSERT(!ConcurrentMergeScheduler::anyUnhandledExceptions());
+
+    IndexReader* reader = IndexReader::open(&dir);
+    CLUCENE_ASSERT(reader->numDocs() == 300);
+    CLUCENE_ASSERT(reader->isOptimized());
+    reader->close();
+    _CLLDELETE(reader);
+}
+
+void testConcurrentMergeSchedulerAbort(CuTest* tc) {
+    RAMDirectory dir;
+    SimpleAnalyzer a;
+    ConcurrentMergeScheduler::clearUnhandledExceptions();
+
+    IndexWriter* writer = _CLNEW IndexWriter(&dir, &a, true);
+    writer->setMergeScheduler(_CLNEW ConcurrentMergeScheduler());
+    writer->setMaxBufferedDocs(2);
+    writer->setMergeFactor(2);
+
+    wchar_t fld[1000];
+    for ( int i=0;i<200;i++ ){
+        English::IntToEnglish(i,fld,1000);
+        Document doc;
+        doc.add ( *_CLNEW Field(_T("field0"),fld,Field::STORE_YES | Field::INDEX_TOKENIZED) );
+        writer->addDocument(&doc);
+    }
+
+    // merges still running are aborted; that must not be reported as an error
+    writer->close(false);
+    _CLLDELETE(writer);
+    CLUCENE_ASSERT(!ConcurrentMergeScheduler::anyUnhandledExceptions());
+
+    IndexReader* reader = IndexReader::open(&dir);
+    CLUCENE_ASSERT(reader->numDocs() == 200);
+    reader->close();
+    _CLLDELETE(reader);
+}
+
+// fails every file the merge threads create, as a full disk would
+class MergeFailDirectory : public RAMDirectory {
+    _LUCENE_THREADID_TYPE indexingThread;
+public:
+    MergeFailDirectory() : indexingThread(_LUCENE_CURRTHREADID) {}
+    IndexOutput* createOutput(const wchar_t* name) {
+        if ( _LUCENE_CURRTHREADID != indexingThread )
+            _CLTHROWA(CL_ERR_IO, "MergeFailDirectory: merge threads may not write");
+        return RAMDirectory::createOutput(name);
+    }
+};
+
+void testConcurrentMergeSchedulerFailure(CuTest* tc) {
+    SimpleAnalyzer a;
+    wchar_t fld[1000];
+
+    // waitForMerges reports the failed merges...
+    MergeFailDirectory dir;
+    IndexWriter* writer = _CLNEW IndexWriter(&dir, &a, true);
+    writer->setMergeScheduler(_CLNEW ConcurrentMergeScheduler());
+    writer->setMaxBufferedDocs(2);
+    writer->setMergeFactor(2);
+    for ( int i=0;i<20;i++ ){
+        English::IntToEnglish(i,fld,1000);
+        Document doc;
+        doc.add ( *_CLNEW Field(_T("field0"),fld,Field::STORE_YES | Field::INDEX_TOKENIZED) );
+        writer->addDocument(&doc);
+    }
+    bool thrown = false;
+    try {
+        writer->waitForMerges();
+    } catch (CLuceneError& err) {
+        thrown = err.number() == CL_ERR_IO;
+    }
+    CLUCENE_ASSERT(thrown);
+    writer->close(false);
+    _CLLDELETE(writer);
+
+    // ...and so does close, which still finishes closing
+    MergeFailDirectory dir2;
+    writer = _CLNEW IndexWriter(&dir2, &a, true);
+    writer->setMergeScheduler(_CLNEW ConcurrentMergeScheduler());
+    writer->setMaxBufferedDocs(2);
+    writer->setMergeFactor(2);
+    for ( int i=0;i<20;i++ ){
+        English::IntToEnglish(i,fld,1000);
+        Document doc;
+        doc.add ( *_CLNEW Field(_T("field0"),fld,Field::STORE_YES | Field::INDEX_TOKENIZED) );
+        writer->addDocument(&doc);
+    }
+    thrown = false;
+    try {
+        writer->close();
+    } catch (CLuceneError& err) {
+        thrown = err.number() == CL_ERR_IO;
+    }
+    CLUCENE_ASSERT(thrown);
+    _CLLDELETE(writer);
+
+    // the write lock was released, or this would time out
+    writer = _CLNEW IndexWriter(&dir2, &a, false);
+    writer->close();
+    _CLLDELETE(writer);
+
+    IndexReader* reader = IndexReader::open(&dir2);
+    CLUCENE_ASSERT(reader->numDocs() == 20);
+    reader->close();
+    _CLLDELETE(reader);
+    ConcurrentMergeScheduler::clearUnhandledExceptions();
+}
+
+void testOptimizeMaxMergeMB(CuTest* tc) {
+    RAMDirectory dir;
+    WhitespaceAnalyzer a;
+
+    IndexWriter4Test* writer = _CLNEW IndexWriter4Test(&dir, &a, true);
+    LogByteSizeMergePolicy* lmp = _CLNEW LogByteSizeMergePolicy();
+    writer->setMergePolicy(lmp);
+    writer->setUseCompoundFile(false);
+    writer->setMergeFactor(100);
+
+    // one large segment...
+    writer->setMaxBufferedDocs(100);
+    Document big;
+    for ( int i=0;i<4;i++ )
+        big.add(* _CLNEW Field(_T("content"), _T("aaa bbb ccc ddd eee fff ggg hhh iii"), Field::STORE_YES | Field::INDEX_TOKENIZED));
+    for ( int i=0;i<100;i++ )
+        writer->addDocument(&big);
+    writer->flush();
+
+    // ...followed by a few small ones
+    writer->setMaxBufferedDocs(2);
+    Document small;
+    small.add(* _CLNEW Field(_T("content"), _T("aaa"), Field::STORE_NO | Field::INDEX_TOKENIZED));
+    for ( int i=0;i<10;i++ )
+        writer->addDocument(&small);
+    writer->flush();
+    CLUCENE_ASSERT(writer->getSegmentCount() == 6);
+
+    // the large segment is over the limit, so optimize only merges the others
+    lmp->setMaxMergeMBForOptimize(0.005);
+    writer->optimize();
+    CLUCENE_ASSERT(writer->getSegmentCount() == 2);
+    CLUCENE_ASSERT(writer->getDocCount(0) == 100);
+    CLUCENE_ASSERT(writer->getDocCount(1) == 10);
+
+    // without the limit everything is merged
+    lmp->setMaxMergeMBForOptimize((float_t) LUCENE_INT64_MAX_SHOULDBE / 1024 / 1024);
+    writer->optimize();
+    CLUCENE_ASSERT(writer->getSegmentCount() == 1);
+
+    writer->close();
+    _CLLDELETE(writer);
+}
+
+// builds the stored text of document i, every 100th document is larger
+// than a whole block of compressed stored fields
+std::wstring storedFieldsText(int32_t i){
+    wchar_t fld[1000];
+    English::IntToEnglish(i, fld, 1000);
+    std::wstring text;
+    const int32_t repeat = i % 100 == 0 ? 2000 : 1 + i % 5;
+    for ( int32_t j = 0; j < repeat; j++ )
+        text.append(fld);
+    return text;
+}
+
+void checkStoredFields(CuTest* tc, Directory* dir, int32_t numDocs){
+    IndexReader* reader = IndexReader::open(dir);
+    CuAssertIntEquals(tc, _T("numDocs"), numDocs, reader->numDocs());
+    const int32_t maxDoc = reader->maxDoc();
+
+    MapFieldSelector lazy;
+    lazy.add(_T("id"));
+    lazy.add(_T("text"), FieldSelector::LAZY_LOAD);
+
+    // jump around, so that documents come from blocks that are not cached
+    for ( int32_t n = 0; n < maxDoc; n++ ){
+        const int32_t i = (int32_t)(((int64_t)n * 7919) % maxDoc);
+        if ( reader->isDeleted(i) )
+            continue;
+        Document doc;
+        CuAssertTrue(tc, reader->document(i, doc, i % 2 == 0 ? &lazy : NULL));
+        const int32_t id = _ttoi(doc.get(_T("id")));
+        CuAssertTrue(tc, storedFieldsText(id).compare(doc.get(_T("text"))) == 0, _T("text does not match"));
+    }
+    reader->close();
+    _CLLDELETE(reader);
+}
+
+// counts the doc stores of the index, and those of them in compressed blocks
+void countDocStores(Directory* dir, int32_t& total, int32_t& blocks){
+    std::vector<std::wstring> files;
+    dir->list(files);
+    total = blocks = 0;
+    for ( size_t i = 0; i < files.size(); i++ ){
+        if ( files[i].length() < 4 || files[i].compare(files[i].length() - 4, 4, L".fdx") != 0 )
+            continue;
+        IndexInput* in = dir->openInput(files[i].c_str());
+        total++;
+        // blocked stores start with FieldsWriter::FORMAT_BLOCKS, the others with a 0 pointer
+        if ( in->readInt() == -1 )
+            blocks++;
+        in->close();
+        _CLDELETE(in);
+    }
+}
+
+void testStoredFieldsCompression(CuTest* tc) {
+    const IndexWriter::StoredFieldsCompression compressions[] = {
+        IndexWriter::STORED_FIELDS_FAST, IndexWriter::STORED_FIELDS_HIGH };
+
+    for ( size_t c = 0; c < sizeof(compressions) / sizeof(compressions[0]); c++ ){
+        RAMDirectory dir;
+        WhitespaceAnalyzer a;
+        IndexWriter* writer = _CLNEW IndexWriter(&dir, &a, true);
+        writer->setStoredFieldsCompression(compressions[c]);
+        writer->setUseCompoundFile(false);
+        writer->setMaxBufferedDocs(100);
+        writer->setMergeFactor(100);
+
+        wchar_t id[20];
+        for ( int32_t i = 0; i < 500; i++ ){
+            // the last segment is written uncompressed by a new writer, so
+            // that merges mix both formats. An open doc store keeps the
+            // format it was opened with
+            if ( i == 400 ){
+                writer->close();
+                _CLLDELETE(writer);
+                writer = _CLNEW IndexWriter(&dir, &a, false);
+                writer->setStoredFieldsCompression(IndexWriter::STORED_FIELDS_UNCOMPRESSED);
+                writer->setUseCompoundFile(false);
+                writer->setMaxBufferedDocs(100);
+                writer->setMergeFactor(100);
+            }
+            _i64tot(i, id, 10);
+            Document doc;
+            doc.add(* _CLNEW Field(_T("id"), id, Field::STORE_YES | Field::INDEX_UNTOKENIZED));
+            doc.add(* _CLNEW Field(_T("text"), storedFieldsText(i).c_str(), Field::STORE_YES | Field::INDEX_NO));
+            writer->addDocument(&doc);
+        }
+        writer->flush();
+        CLUCENE_ASSERT(writer->getStoredFieldsCompression() == IndexWriter::STORED_FIELDS_UNCOMPRESSED);
+        writer->close();
+        _CLLDELETE(writer);
+        int32_t docStores, blockDocStores;
+        countDocStores(&dir, docStores, blockDocStores);
+        CuAssertIntEquals(tc, _T("doc stores"), 5, docStores);
+        CuAssertIntEquals(tc, _T("compressed doc stores"), 4, blockDocStores);
+        checkStoredFields(tc, &dir, 500);
+
+        // merge with deletions into a compressed segment
+        IndexReader* reader = IndexReader::open(&dir);
+        for ( int32_t i = 0; i < 500; i += 7 )
+            reader->deleteDocument(i);
+        reader->close();
+        _CLLDELETE(reader);
+
+        writer = _CLNEW IndexWriter(&dir, &a, false);
+        writer->setStoredFieldsCompression(compressions[c]);
+        writer->setUseCompoundFile(false);
+        writer->optimize();
+        writer->close();
+        _CLLDELETE(writer);
+        countDocStores(&dir, docStores, blockDocStores);
+        CuAssertIntEquals(tc, _T("doc stores"), 1, docStores);
+        CuAssertIntEquals(tc, _T("compressed doc stores"), 1, blockDocStores);
+        checkStoredFields(tc, &dir, 500 - 72);
+    }
+}
+
+static void addNearRealTimeDocs(IndexWriter* writer, int32_t from, int32_t to) {
+    wchar_t id[20];
+    for ( int32_t i = from; i < to; i++ ){
+        _i64tot(i, id, 10);
+        Document doc;
+        doc.add(* _CLNEW Field(_T("id"), id, Field::STORE_YES | Field::INDEX_UNTOKENIZED));
+        doc.add(* _CLNEW Field(_T("content"), _T("aaa"), Field::STORE_NO | Field::INDEX_TOKENIZED));
+        writer->addDocument(&doc);
+    }
+}
+
+// reads all the documents, which fails if the files of the reader were deleted
+static void checkNearRealTimeDocs(CuTest* tc, IndexReader* reader, int32_t numDocs) {
+    CLUCENE_ASSERT(reader->numDocs() == numDocs);
+    int32_t n = 0;
+    for ( int32_t i = 0; i < reader->maxDoc(); i++ ){
+        if ( reader->isDeleted(i) )
+            continue;
+        Document doc;
+        reader->document(i, doc);
+        const int32_t id = _ttoi(doc.get(_T("id")));
+        CLUCENE_ASSERT(id % 5 != 0);
+        n++;
+    }
+    CLUCENE_ASSERT(n == numDocs);
+    Term t(_T("content"), _T("aaa"));
+    CLUCENE_ASSERT(reader->docFreq(&t) == reader->maxDoc());
+}
+
+void testNearRealTimeReader(CuTest* tc) {
+    RAMDirectory dir;
+    WhitespaceAnalyzer a;
+    IndexWriter* writer = _CLNEW IndexWriter(&dir, false, &a, true);
+    writer->setMaxBufferedDocs(10);
+    writer->setMergeFactor(10);
+
+    addNearRealTimeDocs(writer, 0, 25);
+    IndexReader* reader = writer->getReader();
+    CLUCENE_ASSERT(reader->numDocs() == 25);
+    CLUCENE_ASSERT(reader->isCurrent());
+    CLUCENE_ASSERT(reader->reopen() == reader);
+
+    // nothing was committed
+    IndexReader* committed = IndexReader::open(&dir);
+    CLUCENE_ASSERT(committed->numDocs() == 0);
+    committed->close();
+    _CLLDELETE(committed);
+
+    try{
+        reader->deleteDocument(0);
+        CuFail(tc, _T("a reader of the writer must not delete documents"));
+    }catch(CLuceneError& err){
+        CLUCENE_ASSERT(err.number() == CL_ERR_UnsupportedOperation);
+    }
+
+    // buffered documents and deletes are seen after reopening
+    addNearRealTimeDocs(writer, 25, 60);
+    wchar_t id[20];
+    for ( int32_t i = 0; i < 60; i += 5 ){
+        _i64tot(i, id, 10);
+        Term* t = _CLNEW Term(_T("id"), id);
+        writer->deleteDocuments(t);
+        _CLDECDELETE(t);
+    }
+    CLUCENE_ASSERT(!reader->isCurrent());
+    IndexReader* reader2 = reader->reopen();
+    CLUCENE_ASSERT(reader2 != reader);
+    reader->close();
+    _CLLDELETE(reader);
+    checkNearRealTimeDocs(tc, reader2, 48);
+    CLUCENE_ASSERT(reader2->isCurrent());
+
+    // the files of reader2 are kept while the writer merges its segments away
+    writer->optimize();
+    CLUCENE_ASSERT(!reader2->isCurrent());
+    checkNearRealTimeDocs(tc, reader2, 48);
+    IndexReader* reader3 = reader2->reopen();
+    reader2->close();
+    _CLLDELETE(reader2);
+    checkNearRealTimeDocs(tc, reader3, 48);
+
+    // the optimized segment is reused next to a new one
+    addNearRealTimeDocs(writer, 61, 65);
+    IndexReader* reader4 = reader3->reopen();
+    reader3->close();
+    _CLLDELETE(reader3);
+    checkNearRealTimeDocs(tc, reader4, 52);
+
+    writer->close();
+    _CLLDELETE(writer);
+    checkNearRealTimeDocs(tc, reader4, 52);
+    reader4->close();
+    _CLLDELETE(reader4);
+
+    committed = IndexReader::open(&dir);
+    checkNearRealTimeDocs(tc, committed, 52);
+    committed->close();
+    _CLLDELETE(committed);
+}
+
+// readers of the writer share the pooled segment readers, which later
+// deletes and merges must not change under them
+void testSharedSegmentReaders(CuTest* tc) {
+    RAMDirectory dir;
+    WhitespaceAnalyzer a;
+    IndexWriter* writer = _CLNEW IndexWriter(&dir, false, &a, true);
+    writer->setMaxBufferedDocs(10);
+    writer->setMergeFactor(2);
+
+    IndexReader* readers[5];
+    wchar_t id[20];
+    for ( int32_t k = 0; k < 5; k++ ){
+        addNearRealTimeDocs(writer, k * 10, k * 10 + 10);
+        for ( int32_t i = k * 10; i < k * 10 + 10; i += 5 ){
+            _i64tot(i, id, 10);
+            Term* t = _CLNEW Term(_T("id"), id);
+            writer->deleteDocuments(t);
+            _CLDECDELETE(t);
+        }
+        readers[k] = k == 0 ? writer->getReader() : readers[k - 1]->reopen();
+        checkNearRealTimeDocs(tc, readers[k], 8 * (k + 1));
+    }
+    writer->optimize();
+    for ( int32_t k = 0; k < 5; k++ )
+        checkNearRealTimeDocs(tc, readers[k], 8 * (k + 1));
+
+    writer->close();
+    _CLLDELETE(writer);
+    for ( int32_t k = 0; k < 5; k++ ){
+        checkNearRealTimeDocs(tc, readers[k], 8 * (k + 1));
+        readers[k]->close();
+        _CLLDELETE(readers[k]);
+    }
+
+    // a reopened segment reader shares the files and norms of the old one,
+    // which stays usable and does not see the new deletions and norms
+    IndexReader* reader = IndexReader::open(&dir);
+    IndexReader* modifier = IndexReader::open(&dir);
+    modifier->deleteDocument(1);
+    modifier->close();
+    _CLLDELETE(modifier);
+
+    IndexReader* reader2 = reader->reopen();
+    CLUCENE_ASSERT(reader2 != reader);
+    CLUCENE_ASSERT(!reader->isDeleted(1));
+    CLUCENE_ASSERT(reader2->isDeleted(1));
+    reader2->setNorm(0, _T("content"), (uint8_t) 0);
+    CLUCENE_ASSERT(reader->norms(_T("content"))[0] != 0);
+    CLUCENE_ASSERT(reader2->norms(_T("content"))[0] == 0);
+    checkNearRealTimeDocs(tc, reader, 40);
+    reader->close();
+    _CLLDELETE(reader);
+    checkNearRealTimeDocs(tc, reader2, 39);
+    reader2->close();
+    _CLLDELETE(reader2);
+}
+
+static _LUCENE_THREAD_FUNC(closeNearRealTimeReaders, _readers) {
+    IndexReader** readers = (IndexReader**)_readers;
+    for ( int32_t k = 0; k < 20; k++ ){
+        readers[k]->close();
+        _CLLDELETE(readers[k]);
+    }
+    _LUCENE_THREAD_FUNC_RETURN(0);
+}
+
+// readers of the writer may be closed while the writer itself is closed
+// and destroyed
+void testCloseReadersWhileWriterCloses(CuTest* tc) {
+    RAMDirectory dir;
+    WhitespaceAnalyzer a;
+    for ( int32_t round = 0; round < 10; round++ ){
+        IndexWriter* writer = _CLNEW IndexWriter(&dir, &a, true);
+        IndexReader* readers[20];
+        for ( int32_t k = 0; k < 20; k++ ){
+            addNearRealTimeDocs(writer, k, k + 1);
+            readers[k] = writer->getReader();
+        }
+        CLUCENE_ASSERT(readers[19]->numDocs() == 20);
+
+        _LUCENE_THREADID_TYPE thread = _LUCENE_THREAD_CREATE(&closeNearRealTimeReaders, readers);
+        writer->close();
+        _CLLDELETE(writer);
+        _LUCENE_THREAD_JOIN(thread);
+    }
+}
+
+static void addPostingsFormatDocs(IndexWriter* writer, int32_t from, int32_t to) {
+    for ( int32_t i = from; i < to; i++ ){
+        // "a" is in every document, a few times and one time a lot, so that
+        // its documents and positions fill many blocks
+        std::wstring text;
+        const int32_t freq = i == 300 ? 400 : i % 7 + 1;
+        for ( int32_t j = 0; j < freq; j++ )
+            text.append(_T("a "));
+        if ( i % 3 == 0 )
+            text.append(_T("b "));
+        text.append(_T("c"));
+        wchar_t buf[20];
+        _i64tot(i % 50, buf, 10);
+        text.append(buf);
+        text.append(_T(" a"));
+
+        Document doc;
+        doc.add(* _CLNEW Field(_T("content"), text.c_str(), Field::STORE_NO | Field::INDEX_TOKENIZED));
+        writer->addDocument(&doc);
+    }
+}
+
+static void checkSamePositions(CuTest* tc, TermPositions* expected, TermPositions* actual) {
+    for ( int32_t k = 0; k < expected->freq(); k++ )
+        CuAssertIntEquals(tc, _T("position"), expected->nextPosition(), actual->nextPosition());
+}
+
+// compares the postings of all terms, and skipping and bulk reading over them
+static void checkSamePostings(CuTest* tc, IndexReader* expected, IndexReader* actual) {
+    CuAssertIntEquals(tc, _T("maxDoc"), expected->maxDoc(), actual->maxDoc());
+    TermEnum* terms = expected->terms();
+    TermPositions* ep = expected->termPositions();
+    TermPositions* ap = actual->termPositions();
+    while ( terms->next() ){
+        Term* term = terms->term(false);
+        CuAssertIntEquals(tc, _T("docFreq"), terms->docFreq(), actual->docFreq(term));
+        ep->seek(term);
+        ap->seek(term);
+        while ( ep->next() ){
+            CuAssertTrue(tc, ap->next(), _T("missing document"));
+            CuAssertIntEquals(tc, _T("doc"), ep->doc(), ap->doc());
+            CuAssertIntEquals(tc, _T("freq"), ep->freq(), ap->freq());
+            checkSamePositions(tc, ep, ap);
+        }
+        CuAssertTrue(tc, !ap->next(), _T("extra document"));
+
+        // skip in steps below and above the block size, reading the
+        // positions of every other document only
+        const int32_t steps[] = { 1, 5, 127, 129, 300 };
+        for ( size_t s = 0; s < sizeof(steps) / sizeof(steps[0]); s++ ){
+            ep->seek(term);
+            ap->seek(term);
+            int32_t target = 0;
+            for ( int32_t n = 0; ; n++ ){
+                const bool found = ep->skipTo(target);
+                CuAssertTrue(tc, found == ap->skipTo(target), _T("skipTo"));
+                if ( !found )
+                    break;
+                CuAssertIntEquals(tc, _T("doc after skipTo"), ep->doc(), ap->doc());
+                CuAssertIntEquals(tc, _T("freq after skipTo"), ep->freq(), ap->freq());
+                if ( n % 2 == 0 )
+                    checkSamePositions(tc, ep, ap);
+                target = ep->doc() + steps[s];
+            }
+        }
+
+        TermDocs* ed = expected->termDocs(term);
+        TermDocs* ad = actual->termDocs(term);
+        int32_t expectedDocs[50], expectedFreqs[50], actualDocs[50], actualFreqs[50];
+        while ( true ){
+            const int32_t n = ed->read(expectedDocs, expectedFreqs, 50);
+            CuAssertIntEquals(tc, _T("read"), n, ad->read(actualDocs, actualFreqs, 50));
+            if ( n == 0 )
+                break;
+            CuAssertTrue(tc, memcmp(expectedDocs, actualDocs, n * sizeof(int32_t)) == 0, _T("read docs"));
+            CuAssertTrue(tc, memcmp(expectedFreqs, actualFreqs, n * sizeof(int32_t)) == 0, _T("read freqs"));
+        }
+        _CLLDELETE(ed);
+        _CLLDELETE(ad);
+    }
+    _CLLDELETE(ep);
+    _CLLDELETE(ap);
+    terms->close();
+    _CLLDELETE(terms);
+}
+
+static void deletePostingsFormatDocs(Directory* dir) {
+    IndexReader* reader = IndexReader::open(dir);
+    for ( int32_t i = 0; i < reader->maxDoc(); i += 7 )
+        reader->deleteDocument(i);
+    reader->close();
+    _CLLDELETE(reader);
+}
+
+void testPostingsFormats(CuTest* tc) {
+    WhitespaceAnalyzer a;
+
+    // the expected postings, all in the vint format
+    RAMDirectory vintDir;
+    IndexWriter* writer = _CLNEW IndexWriter(&vintDir, &a, true);
+    writer->setPostingsFormat(IndexWriter::POSTINGS_VINT);
+    writer->setMaxBufferedDocs(250);
+    writer->setMergeFactor(100);
+    addPostingsFormatDocs(writer, 0, 1000);
+    writer->close();
+    _CLLDELETE(writer);
+
+    // vint segments first, then block ones
+    RAMDirectory blockDir;
+    writer = _CLNEW IndexWriter(&blockDir, &a, true);
+    CLUCENE_ASSERT(writer->getPostingsFormat() == IndexWriter::POSTINGS_BLOCK);
+    writer->setPostingsFormat(IndexWriter::POSTINGS_VINT);
+    writer->setMaxBufferedDocs(250);
+    writer->setMergeFactor(100);
+    addPostingsFormatDocs(writer, 0, 500);
+    writer->flush();
+    writer->setPostingsFormat(IndexWriter::POSTINGS_BLOCK);
+    addPostingsFormatDocs(writer, 500, 1000);
+    writer->close();
+    _CLLDELETE(writer);
+
+    IndexReader* expected = IndexReader::open(&vintDir);
+    IndexReader* actual = IndexReader::open(&blockDir);
+    checkSamePostings(tc, expected, actual);
+    expected->close();
+    _CLLDELETE(expected);
+    actual->close();
+    _CLLDELETE(actual);
+
+    // merge with deletions, the mixed segments into one block segment
+    deletePostingsFormatDocs(&vintDir);
+    deletePostingsFormatDocs(&blockDir);
+    Directory* dirs[] = { &vintDir, &blockDir };
+    for ( int32_t d = 0; d < 2; d++ ){
+        writer = _CLNEW IndexWriter(dirs[d], &a, false);
+        writer->setPostingsFormat(d == 0 ? IndexWriter::POSTINGS_VINT : IndexWriter::POSTINGS_BLOCK);
+        writer->optimize();
+        writer->close();
+        _CLLDELETE(writer);
+    }
+
+    expected = IndexReader::open(&vintDir);
+    actual = IndexReader::open(&blockDir);
+    CuAssertIntEquals(tc, _T("numDocs"), 1000 - 143, actual->numDocs());
+    checkSamePostings(tc, expected, actual);
+    expected->close();
+    _CLLDELETE(expected);
+    actual->close();
+    _CLLDELETE(actual);
+}
+
 CuSuite *testindexwriter(void)
 {
     CuSuite *suite = CuSuiteNew(_T("CLucene IndexWriter Test"));
@@ -664,6 +1301,15 @@ CuSuite *testindexwriter(void)
     SUITE_ADD_TEST(suite, testExceptionFromTokenStream);
     SUITE_ADD_TEST(suite, testDeleteDocument);
     SUITE_ADD_TEST(suite, testMergeIndex);
+    SUITE_ADD_TEST(suite, testConcurrentMergeScheduler);
+    SUITE_ADD_TEST(suite, testConcurrentMergeSchedulerAbort);
+    SUITE_ADD_TEST(suite, testConcurrentMergeSchedulerFailure);
+    SUITE_ADD_TEST(suite, testOptimizeMaxMergeMB);
+    SUITE_ADD_TEST(suite, testStoredFieldsCompression);
+    SUITE_ADD_TEST(suite, testNearRealTimeReader);
+    SUITE_ADD_TEST(suite, testSharedSegmentReaders);
+    SUITE_ADD_TEST(suite, testCloseReadersWhileWriterCloses);
+    SUITE_ADD_TEST(suite, testPostingsFormats);
 
     return suite;
 }
@@ -170,12 +170,89 @@ void testFSThreading(CuTest *tc)
     _CLDECDELETE(directory);
 }
 
+#define CONCURRENT_ADD_THREADS 10
+#define CONCURRENT_ADD_DOCS 300
+bool concurrentAddFailed = false;
+void __cdecl concurrentAddTest(void *_args)
+{
+    IndexWriter* writer = (IndexWriter*)((void**)_args)[0];
+    int32_t thread = *(int32_t*)((void**)_args)[1];
+    try {
+        wchar_t buf[30];
+        std::wstring sb;
+        for (int i = 0; i < CONCURRENT_ADD_DOCS; i++) {
+            Document d;
+            _i64tot(thread * CONCURRENT_ADD_DOCS + i, buf, 10);
+            d.add(*_CLNEW Field(_T("id"), buf, Field::STORE_YES | Field::INDEX_UNTOKENIZED));
+            sb.assign(_T("common "));
+            English::IntToEnglish(thread * CONCURRENT_ADD_DOCS + i, sb);
+            d.add(*_CLNEW Field(_T("contents"), sb.c_str(), Field::STORE_NO | Field::INDEX_TOKENIZED | Field::TERMVECTOR_WITH_POSITIONS));
+            writer->addDocument(&d);
+        }
+    }
+    catch (CLuceneError& e) {
+        fprintf(stderr, "err: #%d: %s\n", e.number(), e.what());
+        concurrentAddFailed = true;
+    }
+}
+
+/*
+  More threads than DocumentsWriter has thread states add documents
+  with a tiny RAM buffer, so that threads share states, flush often and
+  hand their free blocks back and forth.
+ */
+void testConcurrentAddDocuments(CuTest *tc)
+{
+    RAMDirectory directory;
+    SimpleAnalyzer analyzer;
+    IndexWriter writer(&directory, &analyzer, true);
+    writer.setRAMBufferSizeMB(0.5);
+
+    concurrentAddFailed = false;
+    _LUCENE_THREADID_TYPE threads[CONCURRENT_ADD_THREADS];
+    int32_t ids[CONCURRENT_ADD_THREADS];
+    void* args[CONCURRENT_ADD_THREADS][2];
+    for (int32_t i = 0; i < CONCURRENT_ADD_THREADS; i++) {
+        ids[i] = i;
+        args[i][0] = &writer;
+        args[i][1] = &ids[i];
+        threads[i] = _LUCENE_THREAD_CREATE(&concurrentAddTest, args[i]);
+    }
+    for (int32_t i = 0; i < CONCURRENT_ADD_THREADS; i++)
+        _LUCENE_THREAD_JOIN(threads[i]);
+    writer.close();
+    CuAssert(tc, _T("hit unexpected exception in one of the threads\n"), !concurrentAddFailed);
+
+    IndexReader* reader = IndexReader::open(&directory);
+    CuAssertIntEquals(tc, _T("numDocs"), CONCURRENT_ADD_THREADS * CONCURRENT_ADD_DOCS, reader->numDocs());
+    Term common(_T("contents"), _T("common"));
+    CuAssertIntEquals(tc, _T("docFreq"), CONCURRENT_ADD_THREADS * CONCURRENT_ADD_DOCS, reader->docFreq(&common));
+
+    // every document is found by its id, with the text it was added with
+    wchar_t buf[30];
+    for (int32_t i = 0; i < CONCURRENT_ADD_THREADS * CONCURRENT_ADD_DOCS; i += 7) {
+        _i64tot(i, buf, 10);
+        Term id(_T("id"), buf);
+        TermDocs* td = reader->termDocs(&id);
+        CuAssertTrue(tc, td->next());
+        TermFreqVector* tfv = reader->getTermFreqVector(td->doc(), _T("contents"));
+        CuAssertTrue(tc, tfv != NULL && tfv->indexOf(_T("common")) >= 0);
+        _CLDELETE(tfv);
+        CuAssertTrue(tc, !td->next());
+        _CLDELETE(td);
+    }
+    reader->close();
+    _CLDELETE(reader);
+    directory.close();
+}
+
 CuSuite *testatomicupdates(void)
 {
     srand((unsigned int)Misc::currentTimeMillis());
     CuSuite *suite = CuSuiteNew(_T("CLucene Atomic Updates Test"));
     SUITE_ADD_TEST(suite, testRAMThreading);
     SUITE_ADD_TEST(suite, testFSThreading);
+    SUITE_ADD_TEST(suite, testConcurrentAddDocuments);
 
     return suite;
 }
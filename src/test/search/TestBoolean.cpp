@@ -180,6 +180,60 @@ void testBooleanScorer2WithProhibitedScorer(CuTest* tc) {
     CuAssertIntEquals(tc, _T("Unexpected calls of next()!"), 1, prohibitedScorer.getNextCalls());
 }
 
+void testBooleanSkipNonCompetitive(CuTest* tc) {
+    RAMDirectory dir;
+    WhitespaceAnalyzer an;
+    IndexWriter* writer = _CLNEW IndexWriter(&dir, &an, true);
+    writer->setMaxBufferedDocs(700); // several segments
+
+    Document doc;
+    for (int32_t i = 0; i < 2000; i++) {
+        std::wstring text;
+        for (int32_t j = 0; i % 2 == 0 && j < (i * 7) % 5; j++) text += _T("aa ");
+        for (int32_t j = 0; i % 3 == 0 && j < (i * 13) % 4; j++) text += _T("bb ");
+        for (int32_t j = 0; i % 9 == 0 && j <= i % 6; j++) text += _T("cc ");
+        for (int32_t j = 0; j < i % 11; j++) text += _T("zz ");
+        doc.add(*_CLNEW Field(_T("content"), text.c_str(), Field::STORE_NO | Field::INDEX_TOKENIZED));
+        writer->addDocument(&doc);
+        doc.clear();
+    }
+    writer->close();
+    _CLLDELETE(writer);
+
+    BooleanQuery q;
+    const TCHAR* words[] = { _T("aa"), _T("bb"), _T("cc") };
+    for (int32_t i = 0; i < 3; i++) {
+        Term* t = _CLNEW Term(_T("content"), words[i]);
+        q.add(_CLNEW TermQuery(t), true, BooleanClause::SHOULD);
+        _CLDECDELETE(t);
+    }
+
+    IndexSearcher searcher(&dir);
+    CuAssertTrue(tc, searcher.getExactTotalHits());
+    TopDocs* all = searcher._search(&q, NULL, 2000);
+    TopDocs* exact = searcher._search(&q, NULL, 10);
+    searcher.setExactTotalHits(false);
+    TopDocs* top = searcher._search(&q, NULL, 10);
+
+    CuAssertIntEquals(tc, _T("exact total hits"), all->totalHits, exact->totalHits);
+    CuAssertTrue(tc, top->totalHits <= exact->totalHits);
+    CuAssertIntEquals(tc, _T("number of top hits"), exact->scoreDocsLength, top->scoreDocsLength);
+    for (int32_t i = 0; i < top->scoreDocsLength; i++) {
+        CuAssertTrue(tc, fabs(exact->scoreDocs[i].score - top->scoreDocs[i].score) < 1e-5);
+        // ties may order differently, but each hit must keep its score
+        int32_t j = 0;
+        while (j < all->scoreDocsLength && all->scoreDocs[j].doc != top->scoreDocs[i].doc) j++;
+        CuAssertTrue(tc, j < all->scoreDocsLength);
+        CuAssertTrue(tc, fabs(all->scoreDocs[j].score - top->scoreDocs[i].score) < 1e-5);
+    }
+
+    _CLLDELETE(all);
+    _CLLDELETE(exact);
+    _CLLDELETE(top);
+    searcher.close();
+    dir.close();
+}
+
 CuSuite *testBoolean(void)
 {
     CuSuite *suite = CuSuiteNew(_T("CLucene Boolean Tests"));
@@ -191,6 +245,7 @@ CuSuite *testBoolean(void)
 
     SUITE_ADD_TEST(suite, testBooleanPrefixQuery);
     SUITE_ADD_TEST(suite, testBooleanScorer2WithProhibitedScorer);
+    SUITE_ADD_TEST(suite, testBooleanSkipNonCompetitive);
 
     //_CrtSetBreakAlloc(1179);
 
@@ -5,6 +5,8 @@
 * the GNU Lesser General Public License, as specified in the COPYING file.
 ------------------------------------------------------------------------------*/
 #include "test.h"
+#include "CLucene/search/QueryFilter.h"
+#include "CLucene/search/_FieldDocSortedHitQueue.h"
 
 DEFINE_MUTEX(searchMutex);
 DEFINE_CONDITION(searchCondition);
@@ -88,12 +90,88 @@ void testEndThreadException(CuTest *tc) {
     ram.close();
 }
 
+static void assertSameTopDocs(CuTest* tc, TopDocs* expected, TopDocs* actual) {
+    CuAssertIntEquals(tc, _T("total hits"), expected->totalHits, actual->totalHits);
+    CuAssertIntEquals(tc, _T("number of hits"), expected->scoreDocsLength, actual->scoreDocsLength);
+    for (int32_t i = 0; i < expected->scoreDocsLength; i++) {
+        CuAssertIntEquals(tc, _T("doc"), expected->scoreDocs[i].doc, actual->scoreDocs[i].doc);
+        CuAssertTrue(tc, expected->scoreDocs[i].score == actual->scoreDocs[i].score);
+    }
+}
+
+void testSegmentParallelSearch(CuTest *tc) {
+    RAMDirectory ram;
+    WhitespaceAnalyzer an;
+    IndexWriter* writer = _CLNEW IndexWriter(&ram, &an, true);
+    writer->setMaxBufferedDocs(300); // several segments
+
+    Document doc;
+    for (int32_t i = 0; i < 2500; i++) {
+        std::wstring tmp = English::IntToEnglish(i);
+        doc.add(*_CLNEW Field(_T("content"), tmp.c_str(), Field::STORE_NO | Field::INDEX_TOKENIZED));
+        tmp = std::to_wstring(i % 97);
+        doc.add(*_CLNEW Field(_T("num"), tmp.c_str(), Field::STORE_NO | Field::INDEX_UNTOKENIZED));
+        writer->addDocument(&doc);
+        doc.clear();
+    }
+    writer->close();
+    _CLLDELETE(writer);
+
+    IndexReader* reader = IndexReader::open(&ram);
+    CuAssertTrue(tc, reader->getSubReaders() != NULL && reader->getSubReaders()->length > 1);
+    IndexSearcher serial(reader);
+    IndexSearcher parallel(reader);
+    parallel.setSearchThreads(3);
+    CuAssertIntEquals(tc, _T("search threads"), 3, parallel.getSearchThreads());
+
+    BooleanQuery q;
+    Term* t = _CLNEW Term(_T("content"), _T("hundred"));
+    q.add(_CLNEW TermQuery(t), true, BooleanClause::SHOULD);
+    _CLDECDELETE(t);
+    t = _CLNEW Term(_T("content"), _T("seven"));
+    q.add(_CLNEW TermQuery(t), true, BooleanClause::SHOULD);
+    _CLDECDELETE(t);
+    t = _CLNEW Term(_T("content"), _T("thousand"));
+    QueryFilter filter(_CLNEW TermQuery(t), true);
+    _CLDECDELETE(t);
+
+    TopDocs* expected = serial._search(&q, NULL, 50);
+    TopDocs* actual = parallel._search(&q, NULL, 50);
+    assertSameTopDocs(tc, expected, actual);
+    _CLLDELETE(expected);
+    _CLLDELETE(actual);
+
+    expected = serial._search(&q, &filter, 50);
+    actual = parallel._search(&q, &filter, 50);
+    assertSameTopDocs(tc, expected, actual);
+    _CLLDELETE(expected);
+    _CLLDELETE(actual);
+
+    Sort sort(_T("num"), true);
+    TopFieldDocs* expectedSorted = serial._search(&q, NULL, 50, &sort);
+    TopFieldDocs* actualSorted = parallel._search(&q, NULL, 50, &sort);
+    CuAssertIntEquals(tc, _T("total hits"), expectedSorted->totalHits, actualSorted->totalHits);
+    CuAssertIntEquals(tc, _T("number of hits"), expectedSorted->scoreDocsLength, actualSorted->scoreDocsLength);
+    for (int32_t i = 0; i < expectedSorted->scoreDocsLength; i++) {
+        CuAssertIntEquals(tc, _T("doc"), expectedSorted->fieldDocs[i]->scoreDoc.doc, actualSorted->fieldDocs[i]->scoreDoc.doc);
+        CuAssertTrue(tc, expectedSorted->fieldDocs[i]->scoreDoc.score == actualSorted->fieldDocs[i]->scoreDoc.score);
+    }
+    _CLLDELETE(expectedSorted);
+    _CLLDELETE(actualSorted);
+
+    parallel.close();
+    serial.close();
+    reader->close();
+    _CLLDELETE(reader);
+    ram.close();
+}
 
 CuSuite *testIndexSearcher(void)
 {
     CuSuite *suite = CuSuiteNew(_T("CLucene IndexSearcher Test"));
 
     SUITE_ADD_TEST(suite, testEndThreadException);
+    SUITE_ADD_TEST(suite, testSegmentParallelSearch);
 
     return suite;
   }
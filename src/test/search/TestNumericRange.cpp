@@ -0,0 +1,402 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "test.h"
+#include "CLucene/util/NumericUtils.h"
+#include "CLucene/document/NumericField.h"
+#include "CLucene/search/NumericRangeQuery.h"
+#include "CLucene/search/NumericRangeFilter.h"
+#include <algorithm>
+#include <vector>
+
+CL_NS_USE(util)
+
+static uint64_t _numericRandom(uint64_t& seed){
+	seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+	return seed ^ (seed >> 29);
+}
+
+void testNumericPrefixCoded(CuTest *tc){
+	const int64_t longs[] = { LUCENE_INT64_MIN_SHOULDBE, LUCENE_INT64_MIN_SHOULDBE + 1, -4096, -1, 0, 1, 127, 128,
+		4096, LUCENE_INT64_MAX_SHOULDBE - 1, LUCENE_INT64_MAX_SHOULDBE };
+	const int32_t nLongs = sizeof(longs) / sizeof(longs[0]);
+	wchar_t prev[NumericUtils::BUF_SIZE_LONG + 1];
+	wchar_t buf[NumericUtils::BUF_SIZE_LONG + 1];
+
+	for (int32_t shift = 0; shift < 64; shift++) {
+		prev[0] = 0;
+		for (int32_t i = 0; i < nLongs; i++) {
+			const int32_t len = NumericUtils::longToPrefixCoded(longs[i], shift, buf);
+			CLUCENE_ASSERT(len == (int32_t)wcslen(buf));
+			for (int32_t j = 0; j < len; j++)
+				CLUCENE_ASSERT(buf[j] != 0 && buf[j] <= 0x80);
+
+			// the value comes back without the bits shifted away
+			const int64_t expected = (int64_t)((uint64_t)longs[i] & ~(((uint64_t)1 << shift) - 1));
+			CLUCENE_ASSERT(NumericUtils::prefixCodedToLong(buf) == expected);
+
+			// the terms of a shift sort like the values
+			CLUCENE_ASSERT(wcscmp(prev, buf) <= 0);
+			wcscpy(prev, buf);
+		}
+	}
+	NumericUtils::longToPrefixCoded(12345, 0, buf);
+	CLUCENE_ASSERT(NumericUtils::longToPrefixCoded((int64_t)12345) == buf);
+
+	const int32_t ints[] = { -0x7fffffff - 1, -0x7fffffff, -65536, -1, 0, 1, 127, 128, 65536, 0x7ffffffe, 0x7fffffff };
+	const int32_t nInts = sizeof(ints) / sizeof(ints[0]);
+	for (int32_t shift = 0; shift < 32; shift++) {
+		prev[0] = 0;
+		for (int32_t i = 0; i < nInts; i++) {
+			const int32_t len = NumericUtils::intToPrefixCoded(ints[i], shift, buf);
+			CLUCENE_ASSERT(len == (int32_t)wcslen(buf));
+			const int32_t expected = (int32_t)((uint32_t)ints[i] & ~(((uint32_t)1 << shift) - 1));
+			CLUCENE_ASSERT(NumericUtils::prefixCodedToInt(buf) == expected);
+			CLUCENE_ASSERT(wcscmp(prev, buf) <= 0);
+			wcscpy(prev, buf);
+		}
+	}
+
+	// random values sort like their terms
+	uint64_t seed = 42;
+	for (int32_t i = 0; i < 10000; i++) {
+		const int64_t a = (int64_t)_numericRandom(seed);
+		const int64_t b = (int64_t)_numericRandom(seed) >> (i % 64);
+		const int32_t cmp = wcscmp(NumericUtils::longToPrefixCoded(a).c_str(), NumericUtils::longToPrefixCoded(b).c_str());
+		CLUCENE_ASSERT(a < b ? cmp < 0 : (a > b ? cmp > 0 : cmp == 0));
+		CLUCENE_ASSERT(NumericUtils::prefixCodedToLong(NumericUtils::longToPrefixCoded(a).c_str()) == a);
+	}
+
+	// the terms of one type are not read as the other
+	bool thrown = false;
+	try {
+		NumericUtils::prefixCodedToInt(NumericUtils::longToPrefixCoded((int64_t)1).c_str());
+	} catch (CLuceneError& err) {
+		thrown = err.number() == CL_ERR_NumberFormat;
+	}
+	CLUCENE_ASSERT(thrown);
+	thrown = false;
+	try {
+		NumericUtils::prefixCodedToLong(_T("abc"));
+	} catch (CLuceneError& err) {
+		thrown = err.number() == CL_ERR_NumberFormat;
+	}
+	CLUCENE_ASSERT(thrown);
+}
+
+void testNumericSortableFloats(CuTest *tc){
+	const double doubles[] = { -std::numeric_limits<double>::infinity(), -1e300, -1.5, -std::numeric_limits<double>::denorm_min(),
+		0.0, std::numeric_limits<double>::denorm_min(), 1e-300, 1.0, 1.5, 1e300, std::numeric_limits<double>::infinity(),
+		std::numeric_limits<double>::quiet_NaN() };
+	const int32_t nDoubles = sizeof(doubles) / sizeof(doubles[0]);
+	for (int32_t i = 0; i < nDoubles; i++) {
+		const int64_t bits = NumericUtils::doubleToSortableLong(doubles[i]);
+		if (i > 0)
+			CLUCENE_ASSERT(NumericUtils::doubleToSortableLong(doubles[i - 1]) < bits);
+		const double back = NumericUtils::sortableLongToDouble(bits);
+		CLUCENE_ASSERT(back == doubles[i] || (back != back && doubles[i] != doubles[i]));
+	}
+	CLUCENE_ASSERT(NumericUtils::doubleToSortableLong(-0.0) == NumericUtils::doubleToSortableLong(0.0));
+
+	const float floats[] = { -std::numeric_limits<float>::infinity(), -1e30f, -1.5f, -std::numeric_limits<float>::denorm_min(),
+		0.0f, std::numeric_limits<float>::denorm_min(), 1e-30f, 1.0f, 1.5f, 1e30f, std::numeric_limits<float>::infinity(),
+		std::numeric_limits<float>::quiet_NaN() };
+	const int32_t nFloats = sizeof(floats) / sizeof(floats[0]);
+	for (int32_t i = 0; i < nFloats; i++) {
+		const int32_t bits = NumericUtils::floatToSortableInt(floats[i]);
+		if (i > 0)
+			CLUCENE_ASSERT(NumericUtils::floatToSortableInt(floats[i - 1]) < bits);
+		const float back = NumericUtils::sortableIntToFloat(bits);
+		CLUCENE_ASSERT(back == floats[i] || (back != back && floats[i] != floats[i]));
+	}
+	CLUCENE_ASSERT(NumericUtils::floatToSortableInt(-0.0f) == NumericUtils::floatToSortableInt(0.0f));
+}
+
+/** Keeps the ranges NumericUtils splits a range into, as the values of
+* their ends */
+class _NumericRangeRecorder: public NumericUtils::LongRangeBuilder, public NumericUtils::IntRangeBuilder {
+public:
+	std::vector< std::pair<int64_t, int64_t> > ranges;
+	std::vector<int32_t> shifts;
+
+	using NumericUtils::LongRangeBuilder::addRange;
+	using NumericUtils::IntRangeBuilder::addRange;
+
+	void addRange(const int64_t min, const int64_t max, const int32_t shift){
+		ranges.push_back(std::pair<int64_t, int64_t>(min, max));
+		shifts.push_back(shift);
+	}
+	void addRange(const int32_t min, const int32_t max, const int32_t shift){
+		ranges.push_back(std::pair<int64_t, int64_t>(min, max));
+		shifts.push_back(shift);
+	}
+};
+
+static void _checkSplit(CuTest *tc, const int32_t valSize, const int32_t precisionStep, const int64_t lower, const int64_t upper){
+	_NumericRangeRecorder recorder;
+	if (valSize == 64)
+		NumericUtils::splitLongRange(&recorder, precisionStep, lower, upper);
+	else
+		NumericUtils::splitIntRange(&recorder, precisionStep, (int32_t)lower, (int32_t)upper);
+
+	// the ranges cover the values from lower to upper, once each
+	std::vector< std::pair<int64_t, int64_t> > ranges = recorder.ranges;
+	CLUCENE_ASSERT(!ranges.empty());
+	std::sort(ranges.begin(), ranges.end());
+	CLUCENE_ASSERT(ranges.front().first == lower);
+	CLUCENE_ASSERT(ranges.back().second == upper);
+	for (size_t i = 1; i < ranges.size(); i++)
+		CLUCENE_ASSERT((uint64_t)ranges[i - 1].second + 1 == (uint64_t)ranges[i].first);
+
+	// the ends of a range are the values of its terms
+	const uint64_t maxShift = (valSize + precisionStep - 1) / precisionStep;
+	int32_t perShift[64] = { 0 };
+	for (size_t i = 0; i < recorder.ranges.size(); i++) {
+		const int32_t shift = recorder.shifts[i];
+		const uint64_t low = ((uint64_t)1 << shift) - 1;
+		CLUCENE_ASSERT(((uint64_t)recorder.ranges[i].first & low) == 0);
+		CLUCENE_ASSERT(((uint64_t)recorder.ranges[i].second & low) == low);
+		perShift[shift / precisionStep]++;
+	}
+	// and there are at most two per precision
+	for (uint64_t i = 0; i < maxShift; i++)
+		CLUCENE_ASSERT(perShift[i] <= 2);
+}
+
+void testNumericSplitRange(CuTest *tc){
+	const int32_t steps[] = { 1, 2, 4, 6, 8, 16, 32, 64 };
+	for (int32_t s = 0; s < 8; s++) {
+		const int32_t step = steps[s];
+		_checkSplit(tc, 64, step, LUCENE_INT64_MIN_SHOULDBE, LUCENE_INT64_MAX_SHOULDBE);
+		_checkSplit(tc, 64, step, -1, 0);
+		_checkSplit(tc, 64, step, 5, 5);
+		_checkSplit(tc, 64, step, LUCENE_INT64_MAX_SHOULDBE - 1000, LUCENE_INT64_MAX_SHOULDBE);
+		_checkSplit(tc, 64, step, LUCENE_INT64_MIN_SHOULDBE, LUCENE_INT64_MIN_SHOULDBE + 1000);
+		if (step <= 32) {
+			_checkSplit(tc, 32, step, -0x7fffffff - 1, 0x7fffffff);
+			_checkSplit(tc, 32, step, 0x7fffffff - 1000, 0x7fffffff);
+			_checkSplit(tc, 32, step, -0x7fffffff - 1, -0x7fffffff + 1000);
+			_checkSplit(tc, 32, step, -1, 0);
+		}
+
+		uint64_t seed = 7 + step;
+		for (int32_t i = 0; i < 200; i++) {
+			int64_t a = (int64_t)_numericRandom(seed) >> (i % 60);
+			int64_t b = (int64_t)_numericRandom(seed) >> (i % 60);
+			if (a > b) std::swap(a, b);
+			_checkSplit(tc, 64, step, a, b);
+			if (step <= 32) {
+				int32_t c = (int32_t)(_numericRandom(seed) >> (32 + i % 30));
+				int32_t d = (int32_t)(_numericRandom(seed) >> (32 + i % 30));
+				if (c > d) std::swap(c, d);
+				_checkSplit(tc, 32, step, c, d);
+			}
+		}
+	}
+
+	// an empty range adds nothing, a step below 1 is refused
+	_NumericRangeRecorder recorder;
+	NumericUtils::splitLongRange(&recorder, 4, 10, 9);
+	CLUCENE_ASSERT(recorder.ranges.empty());
+	bool thrown = false;
+	try {
+		NumericUtils::splitLongRange(&recorder, 0, 0, 10);
+	} catch (CLuceneError& err) {
+		thrown = err.number() == CL_ERR_IllegalArgument;
+	}
+	CLUCENE_ASSERT(thrown);
+}
+
+#define NUMERIC_DOCS 3000
+
+struct _NumericValues {
+	int64_t longs[NUMERIC_DOCS];
+	int32_t ints[NUMERIC_DOCS];
+	double doubles[NUMERIC_DOCS];
+	float floats[NUMERIC_DOCS];
+};
+
+/** Indexes a long, an int, a double and a float per document, each with
+* another precision step, in several segments */
+static void _createNumericIndex(RAMDirectory* directory, _NumericValues& values){
+	WhitespaceAnalyzer a;
+	IndexWriter writer(directory, &a, true);
+	writer.setMaxBufferedDocs(400);
+	uint64_t seed = 1234;
+	for (int32_t i = 0; i < NUMERIC_DOCS; i++) {
+		// mostly values near each other, so that ranges hold some of them
+		const uint64_t r = _numericRandom(seed);
+		values.longs[i] = i % 100 == 0 ? (int64_t)r : (int64_t)(r % 2000000) - 1000000;
+		values.ints[i] = i % 100 == 1 ? (int32_t)(r >> 32) : (int32_t)(r % 20000) - 10000;
+		values.doubles[i] = i == 2 ? std::numeric_limits<double>::infinity() : ((int64_t)(r % 200000) - 100000) / 64.0;
+		values.floats[i] = i == 3 ? -std::numeric_limits<float>::infinity() : ((int32_t)(r % 200000) - 100000) / 16.0f;
+		if (i == 4) { values.longs[i] = LUCENE_INT64_MIN_SHOULDBE; values.ints[i] = 0x7fffffff; }
+		if (i == 5) { values.longs[i] = LUCENE_INT64_MAX_SHOULDBE; values.ints[i] = -0x7fffffff - 1; }
+
+		Document* doc = _CLNEW Document();
+		doc->add(*(_CLNEW NumericField(_T("long"), 4, Field::STORE_YES | Field::INDEX_TOKENIZED))->setLongValue(values.longs[i]));
+		doc->add(*(_CLNEW NumericField(_T("int"), 8))->setIntValue(values.ints[i]));
+		doc->add(*(_CLNEW NumericField(_T("double"), 6, Field::STORE_YES | Field::INDEX_TOKENIZED))->setDoubleValue(values.doubles[i]));
+		doc->add(*(_CLNEW NumericField(_T("float"), 1))->setFloatValue(values.floats[i]));
+		writer.addDocument(doc);
+		_CLLDELETE(doc);
+	}
+	writer.close();
+}
+
+template<typename T>
+static int32_t _countInRange(const T* values, const T* min, const T* max, const bool minInclusive, const bool maxInclusive){
+	int32_t count = 0;
+	for (int32_t i = 0; i < NUMERIC_DOCS; i++) {
+		if (min != NULL && (minInclusive ? values[i] < *min : values[i] <= *min)) continue;
+		if (max != NULL && (maxInclusive ? values[i] > *max : values[i] >= *max)) continue;
+		count++;
+	}
+	return count;
+}
+
+static void _checkNumericRange(CuTest *tc, IndexSearcher* searcher, NumericRangeFilter* filter, NumericRangeQuery* query, const int32_t expected){
+	BitSet* bits = filter->bits(searcher->getReader());
+	CuAssertIntEquals(tc, filter->toString().c_str(), expected, bits->count());
+	_CLLDELETE(bits);
+
+	Hits* hits = searcher->search(query);
+	CuAssertIntEquals(tc, query->toString(_T("")).c_str(), expected, (int32_t)hits->length());
+	_CLLDELETE(hits);
+
+	_CLLDELETE(filter);
+	_CLLDELETE(query);
+}
+
+void testNumericRangeAgainstScan(CuTest *tc){
+	RAMDirectory directory;
+	_NumericValues* values = _CLNEW _NumericValues;
+	_createNumericIndex(&directory, *values);
+	IndexReader* reader = IndexReader::open(&directory);
+	IndexSearcher searcher(reader);
+
+	uint64_t seed = 99;
+	for (int32_t i = 0; i < 200; i++) {
+		const bool minInclusive = (i & 1) != 0, maxInclusive = (i & 2) != 0;
+		const bool openMin = i % 17 == 3, openMax = i % 13 == 5;
+		// bounds are values of other documents, or random
+		const int32_t d1 = (int32_t)(_numericRandom(seed) % NUMERIC_DOCS), d2 = (int32_t)(_numericRandom(seed) % NUMERIC_DOCS);
+		const bool random = i % 5 == 4;
+
+		int64_t lmin = random ? (int64_t)(_numericRandom(seed) % 2000000) - 1000000 : values->longs[d1];
+		int64_t lmax = random ? (int64_t)(_numericRandom(seed) % 2000000) - 1000000 : values->longs[d2];
+		if (lmin > lmax) std::swap(lmin, lmax);
+		const int64_t* plmin = openMin ? NULL : &lmin;
+		const int64_t* plmax = openMax ? NULL : &lmax;
+		_checkNumericRange(tc, &searcher,
+			NumericRangeFilter::newLongRange(_T("long"), 4, plmin, plmax, minInclusive, maxInclusive),
+			NumericRangeQuery::newLongRange(_T("long"), 4, plmin, plmax, minInclusive, maxInclusive),
+			_countInRange(values->longs, plmin, plmax, minInclusive, maxInclusive));
+
+		int32_t imin = values->ints[d1], imax = values->ints[d2];
+		if (imin > imax) std::swap(imin, imax);
+		const int32_t* pimin = openMin ? NULL : &imin;
+		const int32_t* pimax = openMax ? NULL : &imax;
+		_checkNumericRange(tc, &searcher,
+			NumericRangeFilter::newIntRange(_T("int"), 8, pimin, pimax, minInclusive, maxInclusive),
+			NumericRangeQuery::newIntRange(_T("int"), 8, pimin, pimax, minInclusive, maxInclusive),
+			_countInRange(values->ints, pimin, pimax, minInclusive, maxInclusive));
+
+		double dmin = random ? values->doubles[d1] + 0.001 : values->doubles[d1];
+		double dmax = values->doubles[d2];
+		if (dmin > dmax) std::swap(dmin, dmax);
+		const double* pdmin = openMin ? NULL : &dmin;
+		const double* pdmax = openMax ? NULL : &dmax;
+		_checkNumericRange(tc, &searcher,
+			NumericRangeFilter::newDoubleRange(_T("double"), 6, pdmin, pdmax, minInclusive, maxInclusive),
+			NumericRangeQuery::newDoubleRange(_T("double"), 6, pdmin, pdmax, minInclusive, maxInclusive),
+			_countInRange(values->doubles, pdmin, pdmax, minInclusive, maxInclusive));
+
+		float fmin = values->floats[d1], fmax = values->floats[d2];
+		if (fmin > fmax) std::swap(fmin, fmax);
+		const float* pfmin = openMin ? NULL : &fmin;
+		const float* pfmax = openMax ? NULL : &fmax;
+		_checkNumericRange(tc, &searcher,
+			NumericRangeFilter::newFloatRange(_T("float"), 1, pfmin, pfmax, minInclusive, maxInclusive),
+			NumericRangeQuery::newFloatRange(_T("float"), 1, pfmin, pfmax, minInclusive, maxInclusive),
+			_countInRange(values->floats, pfmin, pfmax, minInclusive, maxInclusive));
+	}
+
+	// an empty range
+	const int64_t five = 5;
+	_checkNumericRange(tc, &searcher,
+		NumericRangeFilter::newLongRange(_T("long"), 4, &five, &five, true, false),
+		NumericRangeQuery::newLongRange(_T("long"), 4, &five, &five, true, false), 0);
+
+	// stored values read back as decimals
+	Document doc;
+	for (int32_t i = 0; i < 10; i++) {
+		reader->document(i, doc);
+		CLUCENE_ASSERT(_wcstoi64(doc.get(_T("long")), NULL, 10) == values->longs[i]);
+		CLUCENE_ASSERT(wcstod(doc.get(_T("double")), NULL) == values->doubles[i]);
+		CLUCENE_ASSERT(doc.get(_T("int")) == NULL);
+		doc.clear();
+	}
+
+	searcher.close();
+	reader->close();
+	_CLLDELETE(reader);
+	_CLLDELETE(values);
+	directory.close();
+}
+
+void testNumericRangeQueryObject(CuTest *tc){
+	const int64_t one = 1, ten = 10;
+	NumericRangeQuery* q1 = NumericRangeQuery::newLongRange(_T("f"), &one, &ten, true, false);
+	NumericRangeQuery* q2 = NumericRangeQuery::newLongRange(_T("f"), 4, &one, &ten, true, false);
+	NumericRangeQuery* q3 = NumericRangeQuery::newLongRange(_T("f"), 8, &one, &ten, true, false);
+	NumericRangeQuery* q4 = NumericRangeQuery::newIntRange(_T("f"), 4, NULL, NULL, false, false);
+	Query* q5 = q1->clone();
+
+	CuAssertStrEquals(tc, _T("toString"), _T("[1 TO 10}"), q1->toString(_T("f")).c_str());
+	CuAssertStrEquals(tc, _T("toString"), _T("f:[* TO *]"), q4->toString(_T("other")).c_str());
+	CLUCENE_ASSERT(q1->equals(q2) && q1->hashCode() == q2->hashCode());
+	CLUCENE_ASSERT(q1->equals(q5) && q1->hashCode() == q5->hashCode());
+	CLUCENE_ASSERT(!q1->equals(q3));
+	CLUCENE_ASSERT(!q1->equals(q4));
+	q5->setBoost(2);
+	CLUCENE_ASSERT(!q1->equals(q5));
+
+	const double half = 0.5;
+	NumericRangeFilter* f = NumericRangeFilter::newDoubleRange(_T("d"), NULL, &half, true, true);
+	CuAssertStrEquals(tc, _T("toString"), _T("d:[* TO 0.5]"), f->toString().c_str());
+	_CLLDELETE(f);
+
+	bool thrown = false;
+	try {
+		NumericRangeQuery::newLongRange(_T("f"), 0, &one, &ten, true, true);
+	} catch (CLuceneError& err) {
+		thrown = err.number() == CL_ERR_IllegalArgument;
+	}
+	CLUCENE_ASSERT(thrown);
+
+	_CLLDELETE(q1);
+	_CLLDELETE(q2);
+	_CLLDELETE(q3);
+	_CLLDELETE(q4);
+	_CLLDELETE(q5);
+}
+
+CuSuite *testNumericRange(void)
+{
+	CuSuite *suite = CuSuiteNew(_T("CLucene NumericRange Test"));
+
+	SUITE_ADD_TEST(suite, testNumericPrefixCoded);
+	SUITE_ADD_TEST(suite, testNumericSortableFloats);
+	SUITE_ADD_TEST(suite, testNumericSplitRange);
+	SUITE_ADD_TEST(suite, testNumericRangeAgainstScan);
+	SUITE_ADD_TEST(suite, testNumericRangeQueryObject);
+
+	return suite;
+}
+// EOF
@@ -8,6 +8,7 @@
 ------------------------------------------------------------------------------*/
 #include "test.h"
 #include "CLucene/search/MultiPhraseQuery.h"
+#include "CLucene/search/Scorer.h"
 #include "QueryUtils.h"
 
 /// Java PrefixQuery test, 2009-06-02
@@ -268,6 +269,132 @@ public:
         searcher.close();
         directory.close();
     }
+
+    void testTranspositions() {
+        RAMDirectory directory;
+        WhitespaceAnalyzer a;
+        IndexWriter writer(&directory, &a, true);
+        addDoc(_T("abdc"), &writer);
+        addDoc(_T("bacd"), &writer);
+        writer.close();
+        IndexReader* reader = IndexReader::open(&directory);
+        Term* t = _CLNEW Term(_T("field"), _T("abcd"));
+
+        // one edit with transpositions, two without
+        FuzzyTermEnum* e = _CLNEW FuzzyTermEnum(reader, t, 0.7f, 0, false);
+        CLUCENE_ASSERT( e->term(false) == NULL );
+        _CLLDELETE(e);
+        e = _CLNEW FuzzyTermEnum(reader, t, 0.7f, 0, true);
+        CuAssertStrEquals(tc, NULL, _T("abdc"), e->term(false)->text());
+        CuAssertTrue(tc, e->next());
+        CuAssertStrEquals(tc, NULL, _T("bacd"), e->term(false)->text());
+        CuAssertTrue(tc, !e->next());
+        _CLLDELETE(e);
+
+        _CLLDECDELETE(t);
+        reader->close();
+        _CLLDELETE(reader);
+        directory.close();
+    }
+
+    /** The similarity FuzzyTermEnum computes, the plain dynamic programming way */
+    static float_t similarity(const wchar_t* text, const wchar_t* target, size_t prefixLen, bool transpositions) {
+        const size_t n = wcslen(text) - prefixLen;
+        const size_t m = wcslen(target) - prefixLen;
+        if (n == 0 || m == 0)
+            return prefixLen == 0 ? 0.0f : 1.0f - ((float_t) (n + m) / prefixLen);
+        std::vector< std::vector<int32_t> > d(n + 1, std::vector<int32_t>(m + 1));
+        for (size_t i = 0; i <= n; i++)
+            d[i][0] = (int32_t) i;
+        for (size_t j = 0; j <= m; j++)
+            d[0][j] = (int32_t) j;
+        const wchar_t* s = text + prefixLen;
+        const wchar_t* t = target + prefixLen;
+        for (size_t i = 1; i <= n; i++) {
+            for (size_t j = 1; j <= m; j++) {
+                d[i][j] = (std::min)((std::min)(d[i - 1][j] + 1, d[i][j - 1] + 1), d[i - 1][j - 1] + (s[i - 1] == t[j - 1] ? 0 : 1));
+                if (transpositions && i > 1 && j > 1 && s[i - 1] == t[j - 2] && s[i - 2] == t[j - 1])
+                    d[i][j] = (std::min)(d[i][j], d[i - 2][j - 2] + 1);
+            }
+        }
+        return 1.0f - ((float_t) d[n][m] / (float_t) (prefixLen + (std::min)(n, m)));
+    }
+
+    /** Compares FuzzyTermEnum with comparing every term of the field */
+    void checkAgainstScan(IndexReader* reader, const wchar_t* text, float_t minSimilarity, size_t prefixLen, bool transpositions) {
+        Term* t = _CLNEW Term(_T("field"), text);
+        FuzzyTermEnum* e = _CLNEW FuzzyTermEnum(reader, t, minSimilarity, prefixLen, transpositions);
+        Term* start = _CLNEW Term(_T("field"), _T(""));
+        TermEnum* all = reader->terms(start);
+        prefixLen = (std::min)(prefixLen, wcslen(text));
+        do {
+            Term* term = all->term(false);
+            if (term == NULL || wcscmp(term->field(), _T("field")) != 0)
+                break;
+            if (wcsncmp(term->text(), text, prefixLen) != 0)
+                continue;
+            const float_t sim = similarity(text, term->text(), prefixLen, transpositions);
+            if (sim <= minSimilarity)
+                continue;
+            CuAssertTrue(tc, e->term(false) != NULL);
+            CuAssertStrEquals(tc, NULL, term->text(), e->term(false)->text());
+            CuAssertTrue(tc, fabs((sim - minSimilarity) / (1.0f - minSimilarity) - e->difference()) < 1e-5);
+            CuAssertIntEquals(tc, _T("docFreq"), all->docFreq(), e->docFreq());
+            e->next();
+        } while (all->next());
+        CLUCENE_ASSERT( e->term(false) == NULL );
+        all->close();
+        _CLLDELETE(all);
+        _CLLDECDELETE(start);
+        _CLLDELETE(e);
+        _CLLDECDELETE(t);
+    }
+
+    void testAgainstScan() {
+        RAMDirectory directory;
+        WhitespaceAnalyzer a;
+        IndexWriter writer(&directory, &a, true);
+        writer.setMaxBufferedDocs(300); // several segments
+        uint32_t seed = 17;
+        wchar_t text[10];
+        for (int32_t i = 0; i < 3000; i++) {
+            const int32_t len = 1 + (seed >> 16) % 8;
+            for (int32_t j = 0; j < len; j++) {
+                seed = seed * 1103515245 + 12345;
+                text[j] = _T('a') + (seed >> 16) % 5;
+            }
+            text[len] = 0;
+            Document* doc = _CLNEW Document();
+            doc->add(*_CLNEW Field(_T("field"), text, Field::STORE_NO | Field::INDEX_UNTOKENIZED));
+            doc->add(*_CLNEW Field(_T("other"), text, Field::STORE_NO | Field::INDEX_UNTOKENIZED));
+            doc->add(*_CLNEW Field(_T("e"), text, Field::STORE_NO | Field::INDEX_UNTOKENIZED));
+            writer.addDocument(doc);
+            _CLLDELETE(doc);
+        }
+        writer.close();
+
+        const wchar_t* texts[] = { _T("a"), _T("abc"), _T("cadeb"), _T("eeeee"), _T("abcdeab"), _T("bbbbbbbbbbbb"), _T("ab\u00e9cd"), NULL };
+        const float_t sims[] = { 0.0f, 0.3f, 0.5f, 0.7f };
+        for (int32_t pass = 0; pass < 2; pass++) {
+            // segments, then one optimized segment
+            IndexReader* reader = IndexReader::open(&directory);
+            for (int32_t i = 0; texts[i] != NULL; i++) {
+                for (int32_t s = 0; s < 4; s++) {
+                    for (size_t prefixLen = 0; prefixLen < 3; prefixLen++) {
+                        checkAgainstScan(reader, texts[i], sims[s], prefixLen, false);
+                        checkAgainstScan(reader, texts[i], sims[s], prefixLen, true);
+                    }
+                }
+            }
+            reader->close();
+            _CLLDELETE(reader);
+
+            IndexWriter optimizer(&directory, &a, false);
+            optimizer.optimize();
+            optimizer.close();
+        }
+        directory.close();
+    }
 };
 
 void testFuzzyQuery(CuTest *tc){
@@ -275,6 +402,8 @@ void testFuzzyQuery(CuTest *tc){
 	/// Run Java Lucene tests
 	TestFuzzyQuery tester(tc);
 	tester.testFuzziness();
+	tester.testTranspositions();
+	tester.testAgainstScan();
 
 	/// Legacy CLucene tests
 	RAMDirectory ram;
@@ -367,12 +496,85 @@ void testMultiPhraseQuery( CuTest * tc )
     _CLLDELETE( pClone );
 }
 
+/// Compares the documents and frequencies of exact phrases with counting them in the text
+void testExactPhraseQuery( CuTest * tc )
+{
+    const wchar_t* words[] = { _T("a"), _T("b"), _T("c"), _T("d"), _T("e") };
+    const int32_t numDocs = 200;
+    std::vector< std::vector<int32_t> > texts(numDocs);
+
+    RAMDirectory directory;
+    WhitespaceAnalyzer analyzer;
+    IndexWriter writer( &directory, &analyzer, true );
+    writer.setMaxBufferedDocs( 50 ); // a few segments
+    srand( 4711 );
+    for ( int32_t i = 0; i < numDocs; i++ ) {
+        std::wstring text;
+        const int32_t length = 1 + rand() % 40;
+        for ( int32_t j = 0; j < length; j++ ) {
+            // d and e are rare
+            const int32_t w = rand() % 10 < 8 ? rand() % 3 : 3 + rand() % 2;
+            texts[i].push_back( w );
+            text.append( words[w] );
+            text.append( _T(" ") );
+        }
+        Document doc;
+        doc.add( *_CLNEW Field( _T("content"), text.c_str(), Field::STORE_NO | Field::INDEX_TOKENIZED ));
+        writer.addDocument( &doc );
+    }
+    writer.close();
+
+    const int32_t phrases[][4] = { {0, 1, -1}, {1, 0, 1, -1}, {2, 2, -1}, {0, 1, 2, 3}, {4, 0, 4, -1}, {3, 4, -1} };
+    IndexSearcher searcher( &directory );
+    for ( size_t p = 0; p < sizeof(phrases) / sizeof(phrases[0]); p++ ) {
+        int32_t length = 0;
+        PhraseQuery* query = _CLNEW PhraseQuery();
+        while ( length < 4 && phrases[p][length] >= 0 ) {
+            Term* t = _CLNEW Term( _T("content"), words[phrases[p][length]] );
+            query->add( t );
+            _CLDECDELETE( t );
+            length++;
+        }
+
+        Weight* w = query->weight( &searcher );
+        Scorer* scorer = w->scorer( searcher.getReader() );
+        for ( int32_t i = 0; i < numDocs; i++ ) {
+            int32_t freq = 0;
+            for ( int32_t start = 0; start + length <= (int32_t) texts[i].size(); start++ ) {
+                int32_t k = 0;
+                while ( k < length && texts[i][start + k] == phrases[p][k] )
+                    k++;
+                if ( k == length )
+                    freq++;
+            }
+            if ( freq == 0 )
+                continue;
+
+            CLUCENE_ASSERT( scorer->next() );
+            CLUCENE_ASSERT( scorer->doc() == i );
+
+            Scorer* single = w->scorer( searcher.getReader() );
+            Explanation* tf = single->explain( i );
+            CLUCENE_ASSERT( tf->getValue() == searcher.getSimilarity()->tf( (float_t) freq ));
+            _CLLDELETE( tf );
+            _CLLDELETE( single );
+        }
+        CLUCENE_ASSERT( !scorer->next() );
+        _CLLDELETE( scorer );
+        _CLLDELETE( w );
+
+        QueryUtils::check( tc, query, &searcher );
+        _CLLDELETE( query );
+    }
+}
+
 CuSuite *testqueries(void)
 {
 	CuSuite *suite = CuSuiteNew(_T("CLucene Queries Test"));
 
 	SUITE_ADD_TEST(suite, testPrefixQuery);
 	SUITE_ADD_TEST(suite, testMultiPhraseQuery);
+	SUITE_ADD_TEST(suite, testExactPhraseQuery);
 	#ifndef NO_FUZZY_QUERY
 		SUITE_ADD_TEST(suite, testFuzzyQuery);
 	#else
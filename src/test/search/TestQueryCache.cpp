@@ -0,0 +1,343 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "test.h"
+#include "CLucene/search/QueryCache.h"
+#include "CLucene/search/QueryFilter.h"
+#include "CLucene/search/ConstantScoreQuery.h"
+#include "CLucene/search/_FieldDocSortedHitQueue.h"
+
+CL_NS_USE(util)
+
+static const int32_t QUERYCACHE_DOCS = 2000;
+
+/** Documents of 10 tenants, in several segments */
+static void _createQueryCacheIndex(RAMDirectory* directory){
+	WhitespaceAnalyzer a;
+	IndexWriter writer(directory, &a, true);
+	writer.setMaxBufferedDocs(300);
+	Document doc;
+	for (int32_t i = 0; i < QUERYCACHE_DOCS; i++) {
+		std::wstring tmp = English::IntToEnglish(i);
+		doc.add(*_CLNEW Field(_T("content"), tmp.c_str(), Field::STORE_NO | Field::INDEX_TOKENIZED));
+		tmp = _T("t") + std::to_wstring(i % 10);
+		doc.add(*_CLNEW Field(_T("tenant"), tmp.c_str(), Field::STORE_NO | Field::INDEX_UNTOKENIZED));
+		tmp = std::to_wstring(i % 97);
+		doc.add(*_CLNEW Field(_T("num"), tmp.c_str(), Field::STORE_NO | Field::INDEX_UNTOKENIZED));
+		writer.addDocument(&doc);
+		doc.clear();
+	}
+	writer.close();
+}
+
+static Query* _queryCacheTerm(const wchar_t* field, const wchar_t* text){
+	Term* t = _CLNEW Term(field, text);
+	Query* q = _CLNEW TermQuery(t);
+	_CLDECDELETE(t);
+	return q;
+}
+
+static Filter* _tenantFilter(const int32_t tenant){
+	std::wstring text = _T("t") + std::to_wstring(tenant);
+	return _CLNEW QueryFilter(_queryCacheTerm(_T("tenant"), text.c_str()), true);
+}
+
+static void _assertSameCachedTopDocs(CuTest* tc, TopDocs* expected, TopDocs* actual){
+	CuAssertIntEquals(tc, _T("total hits"), expected->totalHits, actual->totalHits);
+	CuAssertIntEquals(tc, _T("number of hits"), expected->scoreDocsLength, actual->scoreDocsLength);
+	for (int32_t i = 0; i < expected->scoreDocsLength; i++) {
+		CuAssertIntEquals(tc, _T("doc"), expected->scoreDocs[i].doc, actual->scoreDocs[i].doc);
+		CuAssertTrue(tc, expected->scoreDocs[i].score == actual->scoreDocs[i].score);
+	}
+	_CLLDELETE(expected);
+	_CLLDELETE(actual);
+}
+
+/** Collects the documents in the order they come */
+class _QueryCacheCollector: public HitCollector{
+public:
+	std::vector<int32_t> docs;
+	void collect(const int32_t doc, const float_t /*score*/){
+		docs.push_back(doc);
+	}
+};
+
+/** Searches with and without a cache must find the same */
+void testQueryCacheSameResults(CuTest *tc){
+	RAMDirectory directory;
+	_createQueryCacheIndex(&directory);
+	IndexReader* reader = IndexReader::open(&directory);
+	CuAssertTrue(tc, reader->getSubReaders() != NULL && reader->getSubReaders()->length > 1);
+
+	QueryCache cache;
+	IndexSearcher plain(reader);
+	IndexSearcher cached(reader);
+	cached.setQueryCache(&cache);
+	CuAssertTrue(tc, cached.getQueryCache() == &cache);
+	IndexSearcher cachedParallel(reader);
+	cachedParallel.setQueryCache(&cache);
+	cachedParallel.setSearchThreads(3);
+
+	BooleanQuery q;
+	q.add(_queryCacheTerm(_T("content"), _T("hundred")), true, BooleanClause::SHOULD);
+	q.add(_queryCacheTerm(_T("content"), _T("seven")), true, BooleanClause::SHOULD);
+	// a filter clause in the query
+	BooleanQuery withClause;
+	withClause.add(_queryCacheTerm(_T("content"), _T("thousand")), true, BooleanClause::MUST);
+	withClause.add(_CLNEW ConstantScoreQuery(_tenantFilter(3)), true, BooleanClause::MUST);
+
+	Sort sort(_T("num"), true);
+	for (int32_t round = 0; round < 3; round++) {
+		for (int32_t tenant = 0; tenant < 4; tenant++) {
+			Filter* filter = _tenantFilter(tenant);
+
+			_assertSameCachedTopDocs(tc, plain._search(&q, filter, 50), cached._search(&q, filter, 50));
+			_assertSameCachedTopDocs(tc, plain._search(&q, filter, 50), cachedParallel._search(&q, filter, 50));
+
+			TopFieldDocs* expected = plain._search(&q, filter, 50, &sort);
+			TopFieldDocs* actual = cachedParallel._search(&q, filter, 50, &sort);
+			CuAssertIntEquals(tc, _T("total hits"), expected->totalHits, actual->totalHits);
+			CuAssertIntEquals(tc, _T("number of hits"), expected->scoreDocsLength, actual->scoreDocsLength);
+			for (int32_t i = 0; i < expected->scoreDocsLength; i++)
+				CuAssertIntEquals(tc, _T("doc"), expected->fieldDocs[i]->scoreDoc.doc, actual->fieldDocs[i]->scoreDoc.doc);
+			_CLLDELETE(expected);
+			_CLLDELETE(actual);
+
+			_QueryCacheCollector plainDocs, cachedDocs;
+			plain._search(&q, filter, &plainDocs);
+			cached._search(&q, filter, &cachedDocs);
+			CuAssertTrue(tc, plainDocs.docs == cachedDocs.docs);
+
+			_CLLDELETE(filter);
+		}
+		_assertSameCachedTopDocs(tc, plain._search(&withClause, NULL, 50), cached._search(&withClause, NULL, 50));
+		_assertSameCachedTopDocs(tc, plain._search(&withClause, NULL, 50), cachedParallel._search(&withClause, NULL, 50));
+	}
+
+	// the filters were cached for each segment, and found again. The
+	// filter clause shares its entries with the filter of tenant 3
+	const int32_t segments = (int32_t)reader->getSubReaders()->length;
+	CuAssertIntEquals(tc, _T("cached entries"), 4 * segments, cache.size());
+	CuAssertTrue(tc, cache.getHitCount() > 0);
+	CuAssertTrue(tc, cache.ramBytesUsed() > 0 && cache.ramBytesUsed() <= cache.getMaxRamBytes());
+
+	// a boosted clause is the same filter
+	const int64_t hits = cache.getHitCount();
+	BooleanQuery boosted;
+	boosted.add(_queryCacheTerm(_T("content"), _T("seven")), true, BooleanClause::MUST);
+	Query* clause = _CLNEW ConstantScoreQuery(_tenantFilter(2));
+	clause->setBoost(3.0f);
+	boosted.add(clause, true, BooleanClause::MUST);
+	_assertSameCachedTopDocs(tc, plain._search(&boosted, NULL, 50), cached._search(&boosted, NULL, 50));
+	CuAssertTrue(tc, cache.getHitCount() > hits);
+	CuAssertIntEquals(tc, _T("cached entries"), 4 * segments, cache.size());
+
+	cachedParallel.close();
+	cached.close();
+	plain.close();
+	reader->close();
+	_CLLDELETE(reader);
+	CuAssertIntEquals(tc, _T("entries of a closed reader"), 0, cache.size());
+	CuAssertTrue(tc, cache.ramBytesUsed() == 0);
+}
+
+/** Filters are cached once they were used often enough, and only if
+* they can be found again */
+void testQueryCacheAdmission(CuTest *tc){
+	RAMDirectory directory;
+	_createQueryCacheIndex(&directory);
+	IndexReader* reader = IndexReader::open(&directory);
+	const int32_t segments = (int32_t)reader->getSubReaders()->length;
+
+	QueryCache cache(QueryCache::DEFAULT_MAX_RAM_BYTES, 3);
+	IndexSearcher searcher(reader);
+	searcher.setQueryCache(&cache);
+	Query* q = _queryCacheTerm(_T("content"), _T("one"));
+
+	for (int32_t i = 1; i <= 4; i++) {
+		Filter* filter = _tenantFilter(1);
+		_CLLDELETE(searcher._search(q, filter, 10));
+		_CLLDELETE(filter);
+		// a filter used once or twice is not cached
+		CuAssertIntEquals(tc, _T("cached entries"), i < 3 ? 0 : segments, cache.size());
+	}
+	CuAssertIntEquals(tc, _T("hits"), segments, (int32_t)cache.getHitCount());
+
+	// filters which cannot tell whether they equal another are never cached
+	DateFilter* dateFilter = DateFilter::After(_T("date"), 0);
+	for (int32_t i = 0; i < 5; i++)
+		_CLLDELETE(searcher._search(q, dateFilter, 10));
+	CuAssertIntEquals(tc, _T("cached entries"), segments, cache.size());
+	_CLLDELETE(dateFilter);
+
+	// clearing drops the entries and the uses
+	cache.clear();
+	CuAssertIntEquals(tc, _T("cached entries"), 0, cache.size());
+	Filter* filter = _tenantFilter(1);
+	_CLLDELETE(searcher._search(q, filter, 10));
+	CuAssertIntEquals(tc, _T("cached entries"), 0, cache.size());
+	_CLLDELETE(filter);
+
+	bool thrown = false;
+	try {
+		QueryCache tooRare(1024, QueryCache::HISTORY_SIZE + 1);
+	} catch (CLuceneError& err) {
+		thrown = err.number() == CL_ERR_IllegalArgument;
+	}
+	CuAssertTrue(tc, thrown);
+
+	_CLLDELETE(q);
+	searcher.close();
+	reader->close();
+	_CLLDELETE(reader);
+}
+
+/** The entries used least recently are evicted to stay in the RAM budget,
+* and bits in use outlive their eviction */
+void testQueryCacheEviction(CuTest *tc){
+	RAMDirectory directory;
+	_createQueryCacheIndex(&directory);
+	IndexReader* reader = IndexReader::open(&directory);
+	const int32_t maxDoc = reader->maxDoc();
+
+	// every entry takes the same memory: a dense set of every doc
+	Query* a = _queryCacheTerm(_T("tenant"), _T("a"));
+	Query* b = _queryCacheTerm(_T("tenant"), _T("b"));
+	Query* c = _queryCacheTerm(_T("tenant"), _T("c"));
+	BitSet* bits = _CLNEW BitSet(maxDoc);
+	bits->set(0, maxDoc, true);
+	QueryCache sizing(1 << 30, 1);
+	sizing.onUse(a);
+	sizing.release(sizing.put(a, reader, bits));
+	const size_t entryBytes = sizing.ramBytesUsed();
+	CuAssertTrue(tc, entryBytes > (size_t)maxDoc / 8);
+
+	QueryCache cache(entryBytes * 2, 1);
+	Query* keys[] = { a, b, c };
+	const BitSet* held[3];
+	for (int32_t i = 0; i < 2; i++) {
+		bits = _CLNEW BitSet(maxDoc);
+		bits->set(0, maxDoc, true);
+		cache.onUse(keys[i]);
+		held[i] = cache.put(keys[i], reader, bits);
+	}
+	CuAssertIntEquals(tc, _T("cached entries"), 2, cache.size());
+	cache.release(held[1]);
+
+	// a is used again, so b is the least recently used
+	const BitSet* found = cache.get(a, reader);
+	CuAssertTrue(tc, found == held[0]);
+	cache.release(found);
+	bits = _CLNEW BitSet(maxDoc);
+	bits->set(0, maxDoc, true);
+	cache.onUse(c);
+	held[2] = cache.put(c, reader, bits);
+	CuAssertIntEquals(tc, _T("cached entries"), 2, cache.size());
+	CuAssertIntEquals(tc, _T("evictions"), 1, (int32_t)cache.getEvictionCount());
+	CuAssertTrue(tc, cache.ramBytesUsed() <= cache.getMaxRamBytes());
+	CuAssertTrue(tc, cache.get(b, reader) == NULL);
+
+	// evict a while it is still held
+	cache.release(held[2]);
+	for (int32_t i = 1; i < 3; i++) {
+		bits = _CLNEW BitSet(maxDoc);
+		bits->set(0, maxDoc, true);
+		cache.onUse(keys[i]);
+		cache.release(cache.put(keys[i], reader, bits));
+	}
+	CuAssertTrue(tc, cache.get(a, reader) == NULL);
+	CuAssertIntEquals(tc, _T("held bits"), maxDoc, held[0]->nextSetBit(maxDoc - 1) + 1);
+	cache.release(held[0]);
+
+	// bits larger than the budget are not cached
+	QueryCache tiny(16, 1);
+	bits = _CLNEW BitSet(maxDoc);
+	bits->set(1);
+	tiny.onUse(a);
+	tiny.release(tiny.put(a, reader, bits));
+	CuAssertIntEquals(tc, _T("cached entries"), 0, tiny.size());
+
+	bool thrown = false;
+	try {
+		BitSet other(10);
+		cache.release(&other);
+	} catch (CLuceneError& err) {
+		thrown = err.number() == CL_ERR_IllegalArgument;
+	}
+	CuAssertTrue(tc, thrown);
+
+	_CLLDELETE(a);
+	_CLLDELETE(b);
+	_CLLDELETE(c);
+	reader->close();
+	_CLLDELETE(reader);
+}
+
+/** Closing a reader drops its entries from every cache */
+void testQueryCacheReaderClose(CuTest *tc){
+	RAMDirectory directory;
+	_createQueryCacheIndex(&directory);
+	IndexReader* reader1 = IndexReader::open(&directory);
+	IndexReader* reader2 = IndexReader::open(&directory);
+
+	QueryCache cache1(QueryCache::DEFAULT_MAX_RAM_BYTES, 1);
+	QueryCache cache2(QueryCache::DEFAULT_MAX_RAM_BYTES, 1);
+	IndexSearcher searcher1(reader1);
+	searcher1.setQueryCache(&cache1);
+	IndexSearcher searcher2(reader2);
+	searcher2.setQueryCache(&cache2);
+	IndexSearcher shared(reader2);
+	shared.setQueryCache(&cache1);
+
+	Query* q = _queryCacheTerm(_T("content"), _T("two"));
+	Filter* filter = _tenantFilter(2);
+	_CLLDELETE(searcher1._search(q, filter, 10));
+	_CLLDELETE(searcher2._search(q, filter, 10));
+	_CLLDELETE(shared._search(q, filter, 10));
+	const int32_t segments = (int32_t)reader1->getSubReaders()->length;
+	CuAssertIntEquals(tc, _T("cached entries"), 2 * segments, cache1.size());
+	CuAssertIntEquals(tc, _T("cached entries"), segments, cache2.size());
+
+	searcher2.close();
+	shared.close();
+	reader2->close();
+	_CLLDELETE(reader2);
+	CuAssertIntEquals(tc, _T("cached entries"), segments, cache1.size());
+	CuAssertIntEquals(tc, _T("cached entries"), 0, cache2.size());
+
+	// a cache deleted before the readers is not called back
+	{
+		QueryCache shortLived(QueryCache::DEFAULT_MAX_RAM_BYTES, 1);
+		IndexSearcher searcher(reader1);
+		searcher.setQueryCache(&shortLived);
+		_CLLDELETE(searcher._search(q, filter, 10));
+		CuAssertIntEquals(tc, _T("cached entries"), segments, shortLived.size());
+		searcher.close();
+	}
+
+	searcher1.close();
+	reader1->close();
+	_CLLDELETE(reader1);
+	CuAssertIntEquals(tc, _T("cached entries"), 0, cache1.size());
+
+	_CLLDELETE(filter);
+	_CLLDELETE(q);
+}
+
+CuSuite *testQueryCache(void)
+{
+	CuSuite *suite = CuSuiteNew(_T("CLucene QueryCache Test"));
+
+	SUITE_ADD_TEST(suite, testQueryCacheSameResults);
+	SUITE_ADD_TEST(suite, testQueryCacheAdmission);
+	SUITE_ADD_TEST(suite, testQueryCacheEviction);
+	SUITE_ADD_TEST(suite, testQueryCacheReaderClose);
+
+	return suite;
+}
+// EOF
@@ -7,6 +7,8 @@
 * the GNU Lesser General Public License, as specified in the COPYING file.
 ------------------------------------------------------------------------------*/
 #include "test.h"
+#include "CLucene/search/FieldCache.h"
+#include "CLucene/index/DocValues.h"
 /**
  * Unit tests for sorting code.
  *
@@ -450,6 +452,19 @@ void testSortCombos(CuTest *tc)
     sortMatches (tc, sort_full, sort_queryY, _sort, _T("HJDBF"));
 }*/
 
+// test a variety of sorts using a parallel multisearcher
+void testParallelMultiSort(CuTest *tc)
+{
+    Searchable* searchables[3] = { sort_searchX, sort_searchY, NULL };
+    ParallelMultiSearcher searcher(searchables);
+
+    sort_runMultiSorts(tc, &searcher);
+
+    Term* term = _CLNEW Term(_T("contents"), _T("x"));
+    CLUCENE_ASSERT(searcher.docFreq(term) == sort_searchX->docFreq(term) + sort_searchY->docFreq(term));
+    _CLDECDELETE(term);
+}
+
 // test a variety of sorts using more than one searcher
 void testMultiSort(CuTest *tc)
 {
@@ -555,6 +570,225 @@ void testNormalizedScores(CuTest *tc)
     _CLDELETE(scoresA);
 }
 
+// count the field cache entries of a reader, and the memory they hold
+int32_t sort_cacheEntries(IndexReader* reader, size_t* ramBytesUsed = NULL)
+{
+    std::vector<FieldCache::CacheEntry> entries;
+    FieldCache::DEFAULT()->getCacheEntries(entries);
+    int32_t count = 0;
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        if (entries[i].reader != reader)
+            continue;
+        count++;
+        if (ramBytesUsed != NULL)
+            *ramBytesUsed += entries[i].ramBytesUsed;
+    }
+    return count;
+}
+
+// sort by a single typed field, then by document order
+void sort_setTyped(const wchar_t* field, int32_t type)
+{
+    SortField* sorts[3] = { _CLNEW SortField(field, type, false), SortField::FIELD_DOC(), NULL };
+    _sort->setSort(sorts);
+}
+
+// test the memory accounting and eviction of the field cache used for sorting
+void testFieldCacheMemory(CuTest *tc)
+{
+    IndexSearcher* searcher = (IndexSearcher*)sort_getIndex(true, true);
+    IndexReader* reader = searcher->getReader();
+    FieldCache* cache = FieldCache::DEFAULT();
+
+    sort_setTyped(_T("int"), SortField::INT);
+    sortMatches(tc, searcher, sort_queryX, _sort, _T("IGAEC"));
+    sort_setTyped(_T("float"), SortField::FLOAT);
+    sortMatches(tc, searcher, sort_queryX, _sort, _T("GCIEA"));
+    sort_setTyped(_T("string"), SortField::STRING);
+    sortMatches(tc, searcher, sort_queryX, _sort, _T("AIGEC"));
+
+    // every entry is accounted for, and none is held once the searches are done
+    std::vector<FieldCache::CacheEntry> entries;
+    cache->getCacheEntries(entries);
+    int64_t total = 0;
+    int32_t count = 0;
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        total += entries[i].ramBytesUsed;
+        if (entries[i].reader != reader)
+            continue;
+        count++;
+        CuAssertTrue(tc, entries[i].ramBytesUsed > 0, _T("entry has no memory accounted"));
+        CuAssertTrue(tc, !entries[i].pinned, _T("entry still pinned after the search"));
+    }
+    CuAssertIntEquals(tc, _T("entries of the reader"), 3, count);
+    CuAssertTrue(tc, total == cache->getRamBytesUsed(), _T("ram used does not match the entries"));
+
+    // with a budget the least recently used entries go, and sorting still works
+    size_t before = 0;
+    sort_cacheEntries(reader, &before);
+    cache->setMaxRamBytes(1);
+    CuAssertIntEquals(tc, _T("entries after setting the budget"), 0, sort_cacheEntries(reader));
+
+    sort_setTyped(_T("int"), SortField::INT);
+    sortMatches(tc, searcher, sort_queryY, _sort, _T("DHFJB"));
+    sort_setTyped(_T("string"), SortField::STRING);
+    sortMatches(tc, searcher, sort_queryY, _sort, _T("DJHFB"));
+    size_t after = 0;
+    CuAssertTrue(tc, sort_cacheEntries(reader, &after) <= 1, _T("budget did not evict the entries"));
+    CuAssertTrue(tc, after < before, _T("budget did not reduce the memory used"));
+
+    // what the getters return without pinning is not evicted while it may be in use
+    FieldCacheAuto* ints = cache->getInts(reader, _T("int"));
+    sort_setTyped(_T("float"), SortField::FLOAT);
+    sortMatches(tc, searcher, sort_queryX, _sort, _T("GCIEA"));
+    CuAssertTrue(tc, cache->getInts(reader, _T("int")) == ints, _T("unpinned entry was evicted"));
+    CuAssertIntEquals(tc, _T("unpinned entry length"), reader->maxDoc(), ints->contentLen);
+    CuAssertIntEquals(tc, _T("unpinned entry value"), -1, ints->intArray[3]);
+
+    // purging drops whatever is left
+    cache->setMaxRamBytes(0);
+    CuAssertTrue(tc, cache->getMaxRamBytes() == 0, _T("budget was not reset"));
+    sort_setTyped(_T("float"), SortField::FLOAT);
+    sortMatches(tc, searcher, sort_queryX, _sort, _T("GCIEA"));
+    CuAssertTrue(tc, sort_cacheEntries(reader) > 0, _T("entry was not cached"));
+    cache->purge(reader);
+    CuAssertIntEquals(tc, _T("entries after purge"), 0, sort_cacheEntries(reader));
+
+    _CLDELETE(searcher);
+}
+
+// test the compact string index: ordinals follow term order, and terms
+// come back unchanged from their UTF-8 form
+void testStringIndex(CuTest *tc)
+{
+    const wchar_t* values[6] = { _T("b\u00e9ta"), _T("alpha"), NULL, _T("\u4e2d\u6587"), _T("alpha"), _T("zeta") };
+    const int32_t ords[6] = { 2, 1, 0, 4, 1, 3 };
+
+    RAMDirectory dir;
+    IndexWriter writer(&dir, &sort_analyser, true);
+    for (int i = 0; i < 6; ++i)
+    {
+        Document doc;
+        if (values[i] != NULL)
+            doc.add(*_CLNEW Field(_T("string"), values[i], Field::INDEX_UNTOKENIZED));
+        writer.addDocument(&doc);
+    }
+    writer.close();
+
+    IndexReader* reader = IndexReader::open(&dir);
+    FieldCache::StringIndex* index = FieldCache::DEFAULT()->getStringIndex(reader, _T("string"))->stringIndex;
+    CuAssertIntEquals(tc, _T("ordinals"), 5, index->count);
+    CuAssertTrue(tc, index->order->getBitsPerValue() == 3, _T("ordinals are not packed"));
+    for (int i = 0; i < 6; ++i)
+    {
+        CuAssertIntEquals(tc, _T("ordinal of document"), ords[i], index->getOrd(i));
+        wchar_t* term = index->getTerm(index->getOrd(i));
+        if (values[i] == NULL)
+            CuAssertTrue(tc, term == NULL, _T("document without a term has a term"));
+        else
+            CuAssertStrEquals(tc, _T("term of document"), values[i], term);
+        _CLDELETE_CARRAY(term);
+        if (values[i] == NULL)
+            CuAssertTrue(tc, index->lookupTerm(index->getOrd(i)) == NULL, _T("document without a term has a term"));
+        else
+            CuAssertStrEquals(tc, _T("looked up term of document"), values[i], index->lookupTerm(index->getOrd(i)));
+    }
+    int32_t length;
+    const char* utf8 = index->getTermUTF8(2, length);
+    CuAssertIntEquals(tc, _T("UTF-8 length"), 5, length);
+    CuAssertTrue(tc, strncmp(utf8, "b\xc3\xa9ta", 5) == 0, _T("term is not UTF-8"));
+
+    reader->close();
+    _CLDELETE(reader);
+}
+
+// test sorting by doc values: they are written with the documents, kept
+// through merges, and sorting by them leaves the field cache alone
+void testDocValuesSort(CuTest *tc)
+{
+    RAMDirectory dir;
+    IndexWriter* writer = _CLNEW IndexWriter(&dir, &sort_analyser, true);
+    writer->setMaxBufferedDocs(3); // several segments
+    for (int i = 0; i < 11; ++i)
+    {
+        Document doc;
+        doc.add(*_CLNEW Field(_T("tracer"), Data[i][0], Field::STORE_YES));
+        doc.add(*_CLNEW Field(_T("contents"), Data[i][1], Field::INDEX_TOKENIZED));
+        if (Data[i][2] != NULL)
+            doc.add(*_CLNEW Field(_T("dvint"), Data[i][2], Field::DOCVALUES_NUMERIC));
+        if (Data[i][4] != NULL)
+            doc.add(*_CLNEW Field(_T("dvstring"), Data[i][4], Field::DOCVALUES_SORTED | Field::STORE_YES));
+        writer->addDocument(&doc);
+    }
+    Document bad;
+    bad.add(*_CLNEW Field(_T("dvint"), _T("4x"), Field::DOCVALUES_NUMERIC));
+    try
+    {
+        writer->addDocument(&bad);
+        CuFail(tc, _T("a numeric doc value that is not a number was accepted"));
+    }
+    catch (CLuceneError& err)
+    {
+        CuAssertIntEquals(tc, _T("error of a bad numeric doc value"), CL_ERR_NumberFormat, err.number());
+    }
+    writer->close();
+    _CLDELETE(writer);
+
+    IndexSearcher* searcher = _CLNEW IndexSearcher(&dir);
+    IndexReader* reader = searcher->getReader();
+    CuAssertTrue(tc, reader->getNumericDocValues(_T("contents")) == NULL, _T("field without doc values has some"));
+    CuAssertTrue(tc, reader->getSortedDocValues(_T("dvint")) == NULL, _T("numeric field has sorted doc values"));
+    NumericDocValues* numeric = reader->getNumericDocValues(_T("dvint"));
+    SortedDocValues* sorted = reader->getSortedDocValues(_T("dvstring"));
+    CuAssertTrue(tc, numeric != NULL && sorted != NULL, _T("doc values are missing"));
+    CuAssertTrue(tc, numeric->get(8) == (int64_t)-2147483647 - 1, _T("numeric value of I"));
+    CuAssertTrue(tc, numeric->get(10) == 0, _T("document without a numeric value"));
+    CuAssertIntEquals(tc, _T("distinct values"), 10, sorted->getValueCount());
+    CuAssertIntEquals(tc, _T("document without a sorted value"), 0, sorted->getOrd(10));
+    CuAssertStrEquals(tc, _T("sorted value of D"), _T("a"), sorted->lookup(sorted->getOrd(3)));
+
+    sort_setTyped(_T("dvint"), SortField::INT);
+    sortMatches(tc, searcher, sort_queryX, _sort, _T("IGAEC"));
+    sortMatches(tc, searcher, sort_queryY, _sort, _T("DHFJB"));
+    sortMatches(tc, searcher, sort_queryF, _sort, _T("IZJ"));
+    sort_setTyped(_T("dvint"), SortField::LONG);
+    sortMatches(tc, searcher, sort_queryX, _sort, _T("IGAEC"));
+    sort_setTyped(_T("dvstring"), SortField::STRING);
+    sortMatches(tc, searcher, sort_queryX, _sort, _T("AIGEC"));
+    sortMatches(tc, searcher, sort_queryF, _sort, _T("ZJI"));
+    sort_setTyped(_T("dvstring"), SortField::AUTO);
+    sortMatches(tc, searcher, sort_queryY, _sort, _T("DJHFB"));
+    SortField* reverse[2] = { _CLNEW SortField(_T("dvint"), SortField::INT, true), NULL };
+    _sort->setSort(reverse);
+    sortMatches(tc, searcher, sort_queryX, _sort, _T("CAEGI"));
+    CuAssertIntEquals(tc, _T("field cache entries"), 0, sort_cacheEntries(reader));
+    _CLDELETE(searcher);
+
+    // merged into one compound segment, the deleted document's values are gone
+    reader = IndexReader::open(&dir);
+    reader->deleteDocument(0);
+    reader->close();
+    _CLDELETE(reader);
+    writer = _CLNEW IndexWriter(&dir, &sort_analyser, false);
+    writer->optimize();
+    writer->close();
+    _CLDELETE(writer);
+
+    searcher = _CLNEW IndexSearcher(&dir);
+    reader = searcher->getReader();
+    CuAssertTrue(tc, reader->isOptimized(), _T("index was not optimized"));
+    sorted = reader->getSortedDocValues(_T("dvstring"));
+    CuAssertIntEquals(tc, _T("distinct values after merging"), 9, sorted->getValueCount());
+    sort_setTyped(_T("dvint"), SortField::INT);
+    sortMatches(tc, searcher, sort_queryX, _sort, _T("IGEC"));
+    sort_setTyped(_T("dvstring"), SortField::STRING);
+    sortMatches(tc, searcher, sort_queryY, _sort, _T("DJHFB"));
+    CuAssertIntEquals(tc, _T("field cache entries after merging"), 0, sort_cacheEntries(reader));
+    _CLDELETE(searcher);
+}
+
 CuSuite *testsort(void)
 {
     CuSuite *suite = CuSuiteNew(_T("CLucene Sort Test"));
@@ -567,9 +801,13 @@ CuSuite *testsort(void)
     SUITE_ADD_TEST(suite, testEmptyFieldSort);
     SUITE_ADD_TEST(suite, testSortCombos);
     //SUITE_ADD_TEST(suite, testCustomSorts);
+    SUITE_ADD_TEST(suite, testParallelMultiSort);
     SUITE_ADD_TEST(suite, testMultiSort);
     SUITE_ADD_TEST(suite, testNormalizedScores);
     SUITE_ADD_TEST(suite, testReverseSort);
+    SUITE_ADD_TEST(suite, testFieldCacheMemory);
+    SUITE_ADD_TEST(suite, testStringIndex);
+    SUITE_ADD_TEST(suite, testDocValuesSort);
 
     SUITE_ADD_TEST(suite, testSortCleanup);
     return suite;
@@ -6,7 +6,9 @@
 * Distributable under the terms of either the Apache License (Version 2.0) or 
 * the GNU Lesser General Public License, as specified in the COPYING file.
 ------------------------------------------------------------------------------*/
+#include <regex>
 #include "test.h"
+#include "CLucene/search/WildcardTermEnum.h"
 
 #ifndef NO_WILDCARD_QUERY
 
@@ -55,6 +57,10 @@ void _testWildcard(CuTest* tc, IndexSearcher* searcher, const wchar_t* qt, int e
 		_testWildcard(tc, searcher, _T("metal*"), 2);
 		_testWildcard(tc, searcher, _T("m*tal"), 1);
 		_testWildcard(tc, searcher, _T("m*tal*"), 2);
+		_testWildcard(tc, searcher, _T("*tal"), 1);
+		_testWildcard(tc, searcher, _T("*tal*"), 2);
+		_testWildcard(tc, searcher, _T("*"), 2);
+		_testWildcard(tc, searcher, _T("*x*"), 0);
 			
 
 		Term* term = _CLNEW Term(_T("body"), _T("metal"));
@@ -104,6 +110,9 @@ void _testWildcard(CuTest* tc, IndexSearcher* searcher, const wchar_t* qt, int e
 		_testWildcard(tc, searcher, _T("meta??"), 1); //metals
 		_testWildcard(tc, searcher, _T("metals?"), 0);
 		_testWildcard(tc, searcher, _T("m?t?ls"), 3);
+		_testWildcard(tc, searcher, _T("?etal"), 1);
+		_testWildcard(tc, searcher, _T("??tals"), 2);
+		_testWildcard(tc, searcher, _T("*x*"), 2);
 
 		indexStore.close();
 		reader->close();
@@ -111,6 +120,169 @@ void _testWildcard(CuTest* tc, IndexSearcher* searcher, const wchar_t* qt, int e
 		_CLDELETE(reader);
 		_CLDELETE(searcher);
 	}
+
+	/** Compares the terms of e with those of field "field" which matches() accepts */
+	void _checkAgainstScan(CuTest *tc, IndexReader* reader, FilteredTermEnum* e,
+		bool (*matches)(const wchar_t* pattern, const wchar_t* text), const wchar_t* pattern){
+		Term* start = _CLNEW Term(_T("field"), _T(""));
+		TermEnum* all = reader->terms(start);
+		do {
+			Term* term = all->term(false);
+			if (term == NULL || wcscmp(term->field(), _T("field")) != 0)
+				break;
+			if (!matches(pattern, term->text()))
+				continue;
+			CuAssertTrue(tc, e->term(false) != NULL);
+			CuAssertStrEquals(tc, pattern, term->text(), e->term(false)->text());
+			CuAssertIntEquals(tc, _T("docFreq"), all->docFreq(), e->docFreq());
+			e->next();
+		} while (all->next());
+		CuAssertTrue(tc, e->term(false) == NULL);
+		all->close();
+		_CLLDELETE(all);
+		_CLLDECDELETE(start);
+	}
+
+	bool _wildcardMatches(const wchar_t* pattern, const wchar_t* text){
+		return WildcardTermEnum::wildcardEquals(pattern, (int32_t)wcslen(pattern), 0, text, (int32_t)wcslen(text), 0);
+	}
+
+	bool _regexpMatches(const wchar_t* pattern, const wchar_t* text){
+		return std::regex_match(std::wstring(text), std::wregex(pattern));
+	}
+
+	/** Indexes 3000 random terms over a-e into fields "field", "other" and
+	* "e", in several segments */
+	void _createRandomIndex(RAMDirectory* directory){
+		WhitespaceAnalyzer a;
+		IndexWriter writer(directory, &a, true);
+		writer.setMaxBufferedDocs(300);
+		uint32_t seed = 17;
+		wchar_t text[10];
+		for (int32_t i = 0; i < 3000; i++) {
+			const int32_t len = 1 + (seed >> 16) % 8;
+			for (int32_t j = 0; j < len; j++) {
+				seed = seed * 1103515245 + 12345;
+				text[j] = _T('a') + (seed >> 16) % 5;
+			}
+			text[len] = 0;
+			Document* doc = _CLNEW Document();
+			doc->add(*_CLNEW Field(_T("field"), text, Field::STORE_NO | Field::INDEX_UNTOKENIZED));
+			doc->add(*_CLNEW Field(_T("other"), text, Field::STORE_NO | Field::INDEX_UNTOKENIZED));
+			doc->add(*_CLNEW Field(_T("e"), text, Field::STORE_NO | Field::INDEX_UNTOKENIZED));
+			writer.addDocument(doc);
+			_CLLDELETE(doc);
+		}
+		writer.close();
+	}
+
+	void _optimize(RAMDirectory* directory){
+		WhitespaceAnalyzer a;
+		IndexWriter writer(directory, &a, false);
+		writer.optimize();
+		writer.close();
+	}
+
+	void testWildcardAgainstScan(CuTest *tc){
+		RAMDirectory directory;
+		_createRandomIndex(&directory);
+
+		// the last pattern's automaton is too large, so the terms starting
+		// with "a" are compared with wildcardEquals()
+		const wchar_t* patterns[] = { _T("*"), _T("a*"), _T("*a"), _T("*ab*"), _T("?"), _T("??"),
+			_T("a?c*"), _T("*b?d"), _T("e*e*e"), _T("*c*d*"), _T("cab?e"), _T("**a"), _T("x*"), _T("*x"),
+			_T("a*a??????????????"), NULL };
+		for (int32_t pass = 0; pass < 2; pass++) {
+			// segments, then one optimized segment
+			IndexReader* reader = IndexReader::open(&directory);
+			for (int32_t i = 0; patterns[i] != NULL; i++) {
+				Term* t = _CLNEW Term(_T("field"), patterns[i]);
+				WildcardTermEnum e(reader, t);
+				_checkAgainstScan(tc, reader, &e, _wildcardMatches, patterns[i]);
+				e.close();
+				_CLLDECDELETE(t);
+			}
+			reader->close();
+			_CLLDELETE(reader);
+			_optimize(&directory);
+		}
+		directory.close();
+	}
+
+	void testRegexpQuery(CuTest *tc){
+		RAMDirectory indexStore;
+		SimpleAnalyzer an;
+		IndexWriter* writer = _CLNEW IndexWriter(&indexStore, &an, true);
+		Document doc1;
+		Document doc2;
+		doc1.add(*_CLNEW Field(_T("body"), _T("metal"),Field::STORE_YES | Field::INDEX_TOKENIZED));
+		doc2.add(*_CLNEW Field(_T("body"), _T("metals"),Field::STORE_YES | Field::INDEX_TOKENIZED));
+		writer->addDocument(&doc1);
+		writer->addDocument(&doc2);
+		writer->close();
+		_CLDELETE(writer);
+
+		IndexSearcher searcher(&indexStore);
+		const wchar_t* patterns[] = { _T("m.tal"), _T("metals?"), _T(".*als"), _T("[^m].*"), _T("(metal|tin)s"), NULL };
+		const int32_t expected[] = { 1, 2, 1, 0, 1 };
+		for (int32_t i = 0; patterns[i] != NULL; i++) {
+			Term* term = _CLNEW Term(_T("body"), patterns[i]);
+			Query* query = _CLNEW RegexpQuery(term);
+			Hits* result = searcher.search(query);
+			CuAssertIntEquals(tc, patterns[i], expected[i], result->length());
+			_CLDELETE(result);
+			_CLDELETE(query);
+			_CLDECDELETE(term);
+		}
+
+		Term* term = _CLNEW Term(_T("body"), _T("m.tal"));
+		RegexpQuery* query = _CLNEW RegexpQuery(term);
+		Query* clone = query->clone();
+		CLUCENE_ASSERT(query->equals(clone));
+		CuAssertStrEquals(tc, NULL, _T("body:/m.tal/"), query->toString(_T("other")).c_str());
+		_CLDELETE(clone);
+		_CLDELETE(query);
+		_CLDECDELETE(term);
+
+		const wchar_t* invalid[] = { _T("(ab"), _T("ab)"), _T("*a"), _T("[ab"), _T("a{2"), _T("a{3,2}"), _T("[b-a]"), _T("a\\"), NULL };
+		for (int32_t i = 0; invalid[i] != NULL; i++) {
+			term = _CLNEW Term(_T("body"), invalid[i]);
+			int32_t number = 0;
+			try {
+				RegexpQuery q(term);
+			} catch (CLuceneError& err) {
+				number = err.number();
+			}
+			CuAssertIntEquals(tc, invalid[i], CL_ERR_Parse, number);
+			_CLDECDELETE(term);
+		}
+
+		searcher.close();
+		indexStore.close();
+	}
+
+	void testRegexpAgainstScan(CuTest *tc){
+		RAMDirectory directory;
+		_createRandomIndex(&directory);
+
+		const wchar_t* patterns[] = { _T(".*"), _T("a.*"), _T(".*a"), _T(".*ab.*"), _T("[ab]+"),
+			_T("[^ab]*c"), _T("(ab|ba)*"), _T("a{2,3}.*"), _T("[a-c]{3}"), _T("(a|b|c)d?e+"),
+			_T(".*(de|ed).{0,2}"), _T("ab\\.?c"), _T("a[b-d]{2,}"), _T("x.*"), _T("e{5}"), _T(""), NULL };
+		for (int32_t pass = 0; pass < 2; pass++) {
+			IndexReader* reader = IndexReader::open(&directory);
+			for (int32_t i = 0; patterns[i] != NULL; i++) {
+				Term* t = _CLNEW Term(_T("field"), patterns[i]);
+				RegexpTermEnum e(reader, t);
+				_checkAgainstScan(tc, reader, &e, _regexpMatches, patterns[i]);
+				e.close();
+				_CLLDECDELETE(t);
+			}
+			reader->close();
+			_CLLDELETE(reader);
+			_optimize(&directory);
+		}
+		directory.close();
+	}
 #else
 	void _NO_WILDCARD_QUERY(CuTest *tc){
 		CuNotImpl(tc,_T("Wildcard"));
@@ -125,6 +297,9 @@ CuSuite *testwildcard(void)
 	#ifndef NO_WILDCARD_QUERY
 		SUITE_ADD_TEST(suite, testQuestionmark);
 		SUITE_ADD_TEST(suite, testAsterisk);
+		SUITE_ADD_TEST(suite, testWildcardAgainstScan);
+		SUITE_ADD_TEST(suite, testRegexpQuery);
+		SUITE_ADD_TEST(suite, testRegexpAgainstScan);
 	#else
 		SUITE_ADD_TEST(suite, _NO_WILDCARD_QUERY);
     #endif
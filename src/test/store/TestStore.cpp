@@ -9,6 +9,7 @@
 #include "test.h"
 #include "CLucene/store/Directory.h"
 #include "CLucene/store/IndexInput.h"
+#include "CLucene/store/PrefetchIndexInput.h"
 #include <stdlib.h>
 
 
@@ -102,6 +103,246 @@ void StoreTest(CuTest *tc,int32_t count, int mode){
 	_CLDECDELETE(store);
 }
 
+void mmapclonetest(CuTest *tc){
+	wchar_t fsdir[CL_MAX_PATH];
+	_snwprintf(fsdir, CL_MAX_PATH, L"%s/%s",cl_tempDir, L"test.mmap");
+	Directory* store = FSDirectory::getDirectory(fsdir);
+	((FSDirectory*)store)->setUseMMap(true);
+
+	IndexOutput* out = store->createOutput(L"vints.dat");
+	for (int32_t i = 0; i < 10000; i++)
+		out->writeVInt(i * 37);
+	out->close();
+	_CLDELETE(out);
+
+	IndexInput* in = store->openInput(L"vints.dat");
+	CLUCENE_ASSERT(in->getObjectName().compare(L"MMapIndexInput") == 0);
+	for (int32_t i = 0; i < 5000; i++)
+		CLUCENE_ASSERT(in->readVInt() == i * 37);
+
+	//a clone starts where the original is, but moves independently
+	IndexInput* clone = in->clone();
+	CLUCENE_ASSERT(clone->getFilePointer() == in->getFilePointer());
+	in->seek(0);
+	CLUCENE_ASSERT(in->readVInt() == 0);
+	CLUCENE_ASSERT(clone->readVInt() == 5000 * 37);
+
+	//the mapping stays valid until the last clone is closed
+	in->close();
+	_CLDELETE(in);
+	for (int32_t i = 5001; i < 10000; i++)
+		CLUCENE_ASSERT(clone->readVInt() == i * 37);
+	CLUCENE_ASSERT(clone->getFilePointer() == clone->length());
+
+	//access hints must not change what is read
+	clone->setAccessPattern(IndexInput::ACCESS_RANDOM);
+	clone->seek(0);
+	CLUCENE_ASSERT(clone->readVInt() == 0);
+	IndexInput* seq = clone->clone();
+	seq->setAccessPattern(IndexInput::ACCESS_SEQUENTIAL);
+	for (int32_t i = 1; i < 10000; i++)
+		CLUCENE_ASSERT(seq->readVInt() == i * 37);
+	seq->close();
+	_CLDELETE(seq);
+	CLUCENE_ASSERT(clone->readVInt() == 37);
+	const int64_t length = clone->length();
+	clone->close();
+	CLUCENE_ASSERT(clone->length() == length);
+	_CLDELETE(clone);
+
+	store->deleteFile(L"vints.dat");
+	store->close();
+	_CLDECDELETE(store);
+}
+
+#define FS_CONCURRENT_INTS 100000
+#define FS_CONCURRENT_THREADS 8
+
+struct ConcurrentReadArgs{
+	IndexInput* in;
+	int32_t seed;
+	bool failed;
+};
+
+/** reads ints at random positions of its own clone */
+static void __cdecl concurrentReadThread(void* arg){
+	ConcurrentReadArgs* args = (ConcurrentReadArgs*)arg;
+	uint32_t r = (uint32_t)args->seed;
+	try{
+		for (int32_t i = 0; i < 20000 && !args->failed; i++) {
+			r = r * 1103515245 + 12345;
+			const int32_t n = (int32_t)((r >> 8) % FS_CONCURRENT_INTS);
+			args->in->seek((int64_t)n * 4);
+			if (args->in->readInt() != n)
+				args->failed = true;
+			if (i % 100 == 0) {
+				//read a stretch that crosses buffer boundaries too
+				for (int32_t j = n + 1; j < FS_CONCURRENT_INTS && j < n + 3000; j++)
+					if (args->in->readInt() != j)
+						args->failed = true;
+			}
+		}
+	}catch(CLuceneError&){
+		args->failed = true;
+	}
+}
+
+void fsconcurrentreadtest(CuTest *tc){
+	wchar_t fsdir[CL_MAX_PATH];
+	_snwprintf(fsdir, CL_MAX_PATH, L"%s/%s",cl_tempDir, L"test.fsread");
+	Directory* store = FSDirectory::getDirectory(fsdir);
+	((FSDirectory*)store)->setUseMMap(false);
+
+	IndexOutput* out = store->createOutput(L"ints.dat");
+	for (int32_t i = 0; i < FS_CONCURRENT_INTS; i++)
+		out->writeInt(i);
+	out->close();
+	_CLDELETE(out);
+
+	IndexInput* in = store->openInput(L"ints.dat");
+	CLUCENE_ASSERT(in->getObjectName().compare(L"FSIndexInput") == 0);
+	CLUCENE_ASSERT(in->length() == FS_CONCURRENT_INTS * 4);
+	for (int32_t i = 0; i < 5000; i++)
+		CLUCENE_ASSERT(in->readInt() == i);
+
+	//a clone starts where the original is, but moves independently
+	IndexInput* clone = in->clone();
+	CLUCENE_ASSERT(clone->getFilePointer() == in->getFilePointer());
+	in->seek(0);
+	CLUCENE_ASSERT(in->readInt() == 0);
+	for (int32_t i = 5000; i < 10000; i++)
+		CLUCENE_ASSERT(clone->readInt() == i);
+	clone->close();
+	_CLDELETE(clone);
+
+	//clones of the one file handle read at the same time
+	ConcurrentReadArgs args[FS_CONCURRENT_THREADS];
+	_LUCENE_THREADID_TYPE threads[FS_CONCURRENT_THREADS];
+	for (int32_t i = 0; i < FS_CONCURRENT_THREADS; i++) {
+		args[i].in = in->clone();
+		args[i].seed = i + 1;
+		args[i].failed = false;
+		threads[i] = _LUCENE_THREAD_CREATE(&concurrentReadThread, &args[i]);
+	}
+	for (int32_t i = 0; i < FS_CONCURRENT_THREADS; i++) {
+		_LUCENE_THREAD_JOIN(threads[i]);
+		CLUCENE_ASSERT(!args[i].failed);
+		args[i].in->close();
+		_CLDELETE(args[i].in);
+	}
+
+	in->seek(in->length() - 4);
+	CLUCENE_ASSERT(in->readInt() == FS_CONCURRENT_INTS - 1);
+	bool eof = false;
+	try{
+		in->readByte();
+	}catch(CLuceneError&){
+		eof = true;
+	}
+	CLUCENE_ASSERT(eof);
+	in->close();
+	_CLDELETE(in);
+
+	store->deleteFile(L"ints.dat");
+	store->close();
+	_CLDECDELETE(store);
+}
+
+#define PREFETCH_INTS 100000
+
+void prefetchtest(CuTest *tc){
+	wchar_t fsdir[CL_MAX_PATH];
+	_snwprintf(fsdir, CL_MAX_PATH, L"%s/%s",cl_tempDir, L"test.prefetch");
+	Directory* store = FSDirectory::getDirectory(fsdir);
+	((FSDirectory*)store)->setUseMMap(false);
+
+	IndexOutput* out = store->createOutput(L"ints.dat");
+	for (int32_t i = 0; i < PREFETCH_INTS; i++)
+		out->writeInt(i);
+	out->close();
+	_CLDELETE(out);
+
+	//small chunks, so that reads and seeks cross them often
+	PrefetchIndexInput* in = _CLNEW PrefetchIndexInput(store->openInput(L"ints.dat"), 1000, 3);
+	CLUCENE_ASSERT(in->length() == PREFETCH_INTS * 4);
+	for (int32_t i = 0; i < PREFETCH_INTS / 2; i++)
+		CLUCENE_ASSERT(in->readInt() == i);
+
+	uint8_t bytes[4 * 3000];
+	in->seek(4 * 10);
+	in->readBytes(bytes, sizeof(bytes));
+	CLUCENE_ASSERT(bytes[3] == 10 && bytes[4 * 2999 + 2] == (3009 >> 8) && bytes[4 * 2999 + 3] == (3009 & 0xff));
+
+	srand(1);
+	for (int32_t i = 0; i < 2000; i++) {
+		const int32_t n = rand() % PREFETCH_INTS;
+		in->seek(n * 4);
+		CLUCENE_ASSERT(in->readInt() == n);
+		if (n + 300 < PREFETCH_INTS) {
+			in->seek((n + 300) * 4); //a short skip forward keeps what was read ahead
+			CLUCENE_ASSERT(in->readInt() == n + 300);
+		}
+	}
+
+	IndexInput* clone = in->clone();
+	CLUCENE_ASSERT(clone->getFilePointer() == in->getFilePointer());
+	clone->seek(0);
+	for (int32_t i = 0; i < 5000; i++)
+		CLUCENE_ASSERT(clone->readInt() == i);
+	clone->close();
+	_CLDELETE(clone);
+
+	in->seek(in->length() - 4);
+	CLUCENE_ASSERT(in->readInt() == PREFETCH_INTS - 1);
+	bool eof = false;
+	try{
+		in->readByte();
+	}catch(CLuceneError&){
+		eof = true;
+	}
+	CLUCENE_ASSERT(eof);
+	in->close();
+	_CLDELETE(in);
+
+	//inputs read at the same time share the workers
+	PrefetchIndexInput* ins[4];
+	for (int32_t j = 0; j < 4; j++) {
+		ins[j] = _CLNEW PrefetchIndexInput(store->openInput(L"ints.dat"), 1000, 3);
+		ins[j]->seek(j * 1000 * 4);
+	}
+	for (int32_t i = 0; i < PREFETCH_INTS / 2; i++) {
+		for (int32_t j = 0; j < 4; j++)
+			CLUCENE_ASSERT(ins[j]->readInt() == j * 1000 + i);
+	}
+	for (int32_t j = 0; j < 4; j++) {
+		ins[j]->close();
+		_CLDELETE(ins[j]);
+	}
+
+	//a buffered input reads ahead while the access pattern is sequential
+	IndexInput* seq = store->openInput(L"ints.dat");
+	seq->setAccessPattern(IndexInput::ACCESS_SEQUENTIAL);
+	for (int32_t i = 0; i < PREFETCH_INTS / 4; i++)
+		CLUCENE_ASSERT(seq->readInt() == i);
+	//a clone does not read ahead, but reads on from where seq is
+	IndexInput* seqClone = seq->clone();
+	for (int32_t i = PREFETCH_INTS / 4; i < PREFETCH_INTS / 2; i++)
+		CLUCENE_ASSERT(seqClone->readInt() == i);
+	seqClone->close();
+	_CLDELETE(seqClone);
+	for (int32_t i = PREFETCH_INTS / 4; i < PREFETCH_INTS / 2; i++)
+		CLUCENE_ASSERT(seq->readInt() == i);
+	seq->setAccessPattern(IndexInput::ACCESS_NORMAL);
+	for (int32_t i = PREFETCH_INTS / 2; i < PREFETCH_INTS; i++)
+		CLUCENE_ASSERT(seq->readInt() == i);
+	seq->close();
+	_CLDELETE(seq);
+
+	store->deleteFile(L"ints.dat");
+	store->close();
+	_CLDECDELETE(store);
+}
+
 void ramtest(CuTest *tc){
 	StoreTest(tc,1000,1);
 }
@@ -119,6 +360,9 @@ CuSuite *teststore(void)
     SUITE_ADD_TEST(suite, ramtest);
     SUITE_ADD_TEST(suite, fstest);
     SUITE_ADD_TEST(suite, mmaptest);
+    SUITE_ADD_TEST(suite, mmapclonetest);
+    SUITE_ADD_TEST(suite, fsconcurrentreadtest);
+    SUITE_ADD_TEST(suite, prefetchtest);
 
     return suite;
 }
@@ -64,6 +64,8 @@ CuSuite *testtermvector(void);
 CuSuite *testsort(void);
 CuSuite *testduplicates(void);
 CuSuite *testRangeFilter(void);
+CuSuite *testNumericRange(void);
+CuSuite *testQueryCache(void);
 CuSuite *testdatefilter(void);
 CuSuite *testwildcard(void);
 CuSuite *testdebug(void);
@@ -75,6 +77,7 @@ CuSuite *testNumberTools(void);
 CuSuite *testDateTools(void);
 CuSuite *testBoolean(void);
 CuSuite *testBitSet(void);
+CuSuite *testPackedInts(void);
 CuSuite *testExtractTerms(void);
 CuSuite *testSpanQueries(void);
 CuSuite *testStringBuffer(void);
@@ -31,6 +31,8 @@ unittest tests[] = {
     {"boolean", testBoolean},
     {"search", testsearch},
     {"rangefilter", testRangeFilter},
+    {"numericrange", testNumericRange},
+    {"querycache", testQueryCache},
     {"queries", testqueries},
     {"csrqueries", testConstantScoreQueries},
     {"termvector",testtermvector},
@@ -41,6 +43,7 @@ unittest tests[] = {
     {"store", teststore},
     {"utf8", testutf8},
     {"bitset", testBitSet},
+    {"packedints", testPackedInts},
     {"extractterms",testExtractTerms},
     {"spanqueries",testSpanQueries},
     {"stringbuffer", testStringBuffer},
@@ -247,6 +247,180 @@ void testNextSetBit(CuTest* tc)
     doTestNextSetBit(tc, 100);
 }
 
+/** fill bv with a pseudo random pattern, roughly one bit in every density is set */
+void fillRandom(BitSet& bv, int32_t seed, int32_t density)
+{
+    uint32_t v = (uint32_t)seed;
+    for( int32_t i = 0; i < bv.size(); i++ ){
+        v = v * 1103515245 + 12345;
+        if ( (v >> 16) % density == 0 )
+            bv.set(i);
+    }
+}
+
+void doTestRange(CuTest* tc, int32_t size, int32_t from, int32_t to)
+{
+    BitSet bv(size);
+    fillRandom(bv, size + from, 2);
+    BitSet* expected = bv.clone();
+
+    bv.set(from, to, true);
+    for( int32_t i = from; i < to; i++ )
+        expected->set(i, true);
+    CLUCENE_ASSERT(doCompare(bv, *expected));
+    CLUCENE_ASSERT(bv.count() == expected->count());
+
+    bv.flip(from, to);
+    for( int32_t i = from; i < to; i++ )
+        expected->set(i, !expected->get(i));
+    CLUCENE_ASSERT(doCompare(bv, *expected));
+    CLUCENE_ASSERT(bv.count() == expected->count());
+
+    fillRandom(bv, size, 3);
+    fillRandom(*expected, size, 3);
+    bv.flip(from, to);
+    for( int32_t i = from; i < to; i++ )
+        expected->set(i, !expected->get(i));
+    CLUCENE_ASSERT(doCompare(bv, *expected));
+
+    bv.set(from, to, false);
+    for( int32_t i = from; i < to; i++ )
+        expected->set(i, false);
+    CLUCENE_ASSERT(doCompare(bv, *expected));
+    CLUCENE_ASSERT(bv.count() == expected->count());
+    _CLLDELETE(expected);
+}
+
+/**
+ * Test setting, clearing and flipping ranges, within one word and across words.
+ * CLucene specific
+ */
+void testBitSetRange(CuTest* tc)
+{
+    doTestRange(tc, 1, 0, 1);
+    doTestRange(tc, 64, 0, 64);
+    doTestRange(tc, 64, 3, 3);
+    doTestRange(tc, 100, 5, 60);
+    doTestRange(tc, 100, 63, 65);
+    doTestRange(tc, 1000, 0, 1000);
+    doTestRange(tc, 1000, 17, 900);
+    doTestRange(tc, 1024, 128, 1024);
+}
+
+void doTestBooleanOp(CuTest* tc, int32_t op, int32_t size, int32_t otherSize, bool compactThis, bool compactOther)
+{
+    BitSet a(size);
+    BitSet b(otherSize);
+    fillRandom(a, 7 + size, compactThis ? 100 : 2);
+    fillRandom(b, 11 + otherSize, compactOther ? 100 : 3);
+
+    // work out the expected result bit by bit
+    BitSet expected(size);
+    for( int32_t i = 0; i < size; i++ ){
+        bool x = a.get(i);
+        bool y = i < otherSize && b.get(i);
+        switch( op ){
+        case 0: expected.set(i, x && y); break;
+        case 1: expected.set(i, x || y); break;
+        case 2: expected.set(i, x && !y); break;
+        default: expected.set(i, x != y);
+        }
+    }
+
+    if ( compactThis )
+        CLUCENE_ASSERT(a.compact());
+    if ( compactOther )
+        CLUCENE_ASSERT(b.compact());
+    switch( op ){
+    case 0: a.and_(b); break;
+    case 1: a.or_(b); break;
+    case 2: a.andNot(b); break;
+    default: a.xor_(b);
+    }
+    CLUCENE_ASSERT(a.size() == size);
+    CLUCENE_ASSERT(doCompare(a, expected));
+    CLUCENE_ASSERT(a.count() == expected.count());
+
+    // nothing may be set past the end of the bit set
+    int32_t last = -1;
+    for( int32_t i = a.nextSetBit(0); i >= 0; i = a.nextSetBit(i + 1) )
+        last = i;
+    CLUCENE_ASSERT(last < size);
+}
+
+/**
+ * Test and_, or_, andNot and xor_ against the same operations done bit by bit,
+ * for bit sets of equal and different sizes, words and sparse.
+ * CLucene specific
+ */
+void testBooleanOps(CuTest* tc)
+{
+    for( int32_t op = 0; op < 4; op++ ){
+        doTestBooleanOp(tc, op, 1000, 1000, false, false);
+        doTestBooleanOp(tc, op, 100, 1000, false, false);
+        doTestBooleanOp(tc, op, 1000, 130, false, false);
+        doTestBooleanOp(tc, op, 5000, 5000, false, true);
+        doTestBooleanOp(tc, op, 5000, 3000, true, false);
+        doTestBooleanOp(tc, op, 3000, 5000, true, true);
+    }
+}
+
+/**
+ * Test the sparse representation of a bit set.
+ * CLucene specific
+ */
+void testCompact(CuTest* tc)
+{
+    const int32_t size = 100000;
+    BitSet bv(size);
+    for( int32_t i = 3; i < size; i += 997 )
+        bv.set(i);
+    BitSet* dense = bv.clone();
+    const int32_t count = bv.count();
+    const size_t denseBytes = bv.ramBytesUsed();
+
+    CLUCENE_ASSERT(bv.compact());
+    CLUCENE_ASSERT(bv.isCompact());
+    CLUCENE_ASSERT(bv.ramBytesUsed() < denseBytes / 10);
+    CLUCENE_ASSERT(bv.count() == count);
+    CLUCENE_ASSERT(doCompare(bv, *dense));
+
+    int32_t n = 0;
+    for( int32_t i = bv.nextSetBit(0); i >= 0; i = bv.nextSetBit(i + 1) ){
+        CLUCENE_ASSERT(i == 3 + n * 997);
+        n++;
+    }
+    CLUCENE_ASSERT(n == count);
+
+    // a copy stays sparse, a change switches back to words
+    BitSet* copy = bv.clone();
+    CLUCENE_ASSERT(copy->isCompact());
+    CLUCENE_ASSERT(doCompare(*copy, *dense));
+    copy->set(4);
+    CLUCENE_ASSERT(!copy->isCompact());
+    CLUCENE_ASSERT(copy->get(4) && copy->get(3));
+    CLUCENE_ASSERT(copy->count() == count + 1);
+    _CLLDELETE(copy);
+
+    // writing a sparse bit set
+    Directory* d = _CLNEW RAMDirectory();
+    bv.write(d, L"TESTBV");
+    BitSet read(d, L"TESTBV");
+    CLUCENE_ASSERT(doCompare(read, *dense));
+    _CLLDECDELETE( d );
+
+    // a bit set with many set bits is smaller as words
+    fillRandom(*dense, 1, 2);
+    CLUCENE_ASSERT(!dense->compact());
+    CLUCENE_ASSERT(!dense->isCompact());
+    _CLLDELETE(dense);
+
+    BitSet empty(size);
+    CLUCENE_ASSERT(empty.compact());
+    CLUCENE_ASSERT(empty.count() == 0);
+    CLUCENE_ASSERT(empty.nextSetBit(0) == -1);
+}
+
 CuSuite *testBitSet(void)
 {
     CuSuite *suite = CuSuiteNew(_T("CLucene BitSet Test"));
@@ -260,6 +434,9 @@ CuSuite *testBitSet(void)
     SUITE_ADD_TEST(suite, testBitAtEndOfBitSet);
 
     SUITE_ADD_TEST(suite, testNextSetBit);
+    SUITE_ADD_TEST(suite, testBitSetRange);
+    SUITE_ADD_TEST(suite, testBooleanOps);
+    SUITE_ADD_TEST(suite, testCompact);
 
     return suite; 
 }
@@ -0,0 +1,80 @@
+/*------------------------------------------------------------------------------
+* Copyright (C) 2003-2006 Ben van Klinken and the CLucene Team
+
+* Updated by https://github.com/farfella/.
+*
+* Distributable under the terms of either the Apache License (Version 2.0) or
+* the GNU Lesser General Public License, as specified in the COPYING file.
+------------------------------------------------------------------------------*/
+#include "test.h"
+#include "CLucene/util/PackedInts.h"
+
+CL_NS_USE(util)
+
+void testBitsRequired(CuTest* tc) {
+    CLUCENE_ASSERT(PackedInts::bitsRequired(0) == 1);
+    CLUCENE_ASSERT(PackedInts::bitsRequired(1) == 1);
+    CLUCENE_ASSERT(PackedInts::bitsRequired(2) == 2);
+    CLUCENE_ASSERT(PackedInts::bitsRequired(255) == 8);
+    CLUCENE_ASSERT(PackedInts::bitsRequired(256) == 9);
+    CLUCENE_ASSERT(PackedInts::bitsRequired(0x7FFFFFFF) == 31);
+    CLUCENE_ASSERT(PackedInts::bitsRequired(LUCENE_INT64_MAX_SHOULDBE) == 63);
+}
+
+void doTestGetSetOfSize(CuTest* tc, int32_t n, int32_t bitsPerValue) {
+    PackedInts values(n, bitsPerValue);
+    CLUCENE_ASSERT(n == values.size());
+    CLUCENE_ASSERT(bitsPerValue == values.getBitsPerValue());
+
+    const uint64_t mask = bitsPerValue == 64 ? ~(uint64_t)0 : (((uint64_t)1 << bitsPerValue) - 1);
+    for (int32_t i = 0; i < n; i++)
+        CLUCENE_ASSERT(values.get(i) == 0);
+
+    // set every value, so that neighbours which share a block are checked too
+    uint64_t v = 0x9E3779B97F4A7C15ULL;
+    for (int32_t i = 0; i < n; i++) {
+        v = v * 6364136223846793005ULL + 1442695040888963407ULL;
+        values.set(i, (int64_t)(v & mask));
+    }
+    v = 0x9E3779B97F4A7C15ULL;
+    for (int32_t i = 0; i < n; i++) {
+        v = v * 6364136223846793005ULL + 1442695040888963407ULL;
+        CLUCENE_ASSERT(values.get(i) == (int64_t)(v & mask));
+    }
+
+    // overwriting a value must leave the others alone
+    for (int32_t i = 0; i < n; i += 3)
+        values.set(i, 0);
+    v = 0x9E3779B97F4A7C15ULL;
+    for (int32_t i = 0; i < n; i++) {
+        v = v * 6364136223846793005ULL + 1442695040888963407ULL;
+        CLUCENE_ASSERT(values.get(i) == (i % 3 == 0 ? 0 : (int64_t)(v & mask)));
+    }
+}
+
+void testPackedGetSet(CuTest* tc) {
+    for (int32_t bits = 1; bits <= 64; bits++) {
+        doTestGetSetOfSize(tc, 0, bits);
+        doTestGetSetOfSize(tc, 1, bits);
+        doTestGetSetOfSize(tc, 100, bits);
+        doTestGetSetOfSize(tc, 1000, bits);
+    }
+}
+
+void testPackedRamBytesUsed(CuTest* tc) {
+    // 1000 values of 7 bits take 110 blocks, far less than 1000 int32_t
+    PackedInts values(1000, 7);
+    CLUCENE_ASSERT(values.ramBytesUsed() < 1000 * sizeof(int32_t));
+    CLUCENE_ASSERT(values.ramBytesUsed() >= 1000 * 7 / 8);
+}
+
+CuSuite *testPackedInts(void)
+{
+    CuSuite *suite = CuSuiteNew(_T("CLucene PackedInts Test"));
+
+    SUITE_ADD_TEST(suite, testBitsRequired);
+    SUITE_ADD_TEST(suite, testPackedGetSet);
+    SUITE_ADD_TEST(suite, testPackedRamBytesUsed);
+
+    return suite;
+}